@@ -16,6 +16,7 @@
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/PrintLib.h>
 #include <Library/IoLib.h>
+#include <Library/BufferedOutputLib.h>
 
 #include <Protocol/EfiShell.h>
 #include <Protocol/LoadedImage.h>
@@ -93,10 +94,10 @@ VOID
 Usage( BOOLEAN ErrorMsg )
 {
     if ( ErrorMsg ) {
-        Print(L"ERROR: Unknown option(s).\n");
+        OutputPrint(L"ERROR: Unknown option(s).\n");
     }
-    Print(L"Usage: Beep [NumberOfBeeps]\n");
-    Print(L"       Beep [-V | --version]\n");
+    OutputPrint(L"Usage: Beep [NumberOfBeeps]\n");
+    OutputPrint(L"       Beep [-V | --version]\n");
 }
 
 
@@ -108,10 +109,12 @@ ShellAppMain( UINTN Argc,
     EFI_STATUS Status = EFI_SUCCESS;
     UINTN NumberBeeps = 1;
 
+    OutputInit(&Argc, Argv);
+
     if (Argc == 2) {
         if (!StrCmp(Argv[1], L"--version") ||
             !StrCmp(Argv[1], L"-V")) {
-            Print(L"Version: %s\n", UTILITY_VERSION);
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
             return Status;
         } else if (!StrCmp(Argv[1], L"--help") ||
             !StrCmp(Argv[1], L"-h")) {
@@ -120,7 +123,7 @@ ShellAppMain( UINTN Argc,
         } else if (IsNumber(Argv[1])) {
             NumberBeeps = (UINTN) StrDecimalToUint64( Argv[1] );            
             if (NumberBeeps < 1) {
-                Print(L"ERROR: Invalid number of beeps\n");               
+                OutputPrint(L"ERROR: Invalid number of beeps\n");               
                 Usage(FALSE);
                 return Status;
             } 
@@ -18,6 +18,7 @@
 #include <Library/ShellLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
+#include <Library/BufferedOutputLib.h>
 
 #include <Protocol/EfiShell.h>
 #include <Protocol/LoadedImage.h>
@@ -29,9 +30,9 @@
 VOID
 Usage( VOID )
 {
-    Print(L"Usage: BootFWUI [-s | --set]\n");
-    Print(L"                [-u | --unset]\n");
-    Print(L"                [-V | --version]\n");
+    OutputPrint(L"Usage: BootFWUI [-s | --set]\n");
+    OutputPrint(L"                [-u | --unset]\n");
+    OutputPrint(L"                [-V | --version]\n");
 }
 
 
@@ -49,10 +50,12 @@ ShellAppMain( UINTN Argc,
     UINTN      DataSize;
     UINT32     Attributes;
 
+    OutputInit(&Argc, Argv);
+
     if (Argc == 2) {
         if (!StrCmp(Argv[1], L"--version") || 
             !StrCmp(Argv[1], L"-V")) {
-            Print(L"Version: %s\n", UTILITY_VERSION);
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
             return Status;
         } else if (!StrCmp(Argv[1], L"--set") ||
             !StrCmp(Argv[1], L"-s")) {
@@ -83,12 +86,12 @@ ShellAppMain( UINTN Argc,
                                &DataSize,
                                &OsIndicationsSupported);
     if (Status == EFI_NOT_FOUND) {
-        Print(L"ERROR: OsIndicationsSupported variable not found.\n");
+        OutputPrint(L"ERROR: OsIndicationsSupported variable not found.\n");
         return Status;
     }
 
 #ifdef DEBUG
-    Print(L"OSIndicationsSupported variable found: 0x%016x\n", OsIndicationSupport );
+    OutputPrint(L"OSIndicationsSupported variable found: 0x%016x\n", OsIndicationSupport );
 #endif
 
     Status = gRT->GetVariable( EFI_OS_INDICATIONS_VARIABLE_NAME,
@@ -97,19 +100,19 @@ ShellAppMain( UINTN Argc,
                                &DataSize,
                                &OsIndications);
     if (Status == EFI_NOT_FOUND) {
-        Print(L"ERROR: OsIndications variable not found.\n");
+        OutputPrint(L"ERROR: OsIndications variable not found.\n");
         return Status;
     }
 
 #ifdef DEBUG
-    Print(L"OsIndications variable: 0x%016x\n", OsIndication);
+    OutputPrint(L"OsIndications variable: 0x%016x\n", OsIndication);
 #endif
 
     SupportBootFwUi = (BOOLEAN) ((OsIndicationsSupported & EFI_OS_INDICATIONS_BOOT_TO_FW_UI) != 0);
     BootFwUi = (BOOLEAN) ((OsIndications & EFI_OS_INDICATIONS_BOOT_TO_FW_UI) != 0);
 
     if (Set == FALSE && Unset == FALSE) {
-        Print(L"  Boot to Firmware UI: %s. Current value is %s.\n", SupportBootFwUi ? L"Supported" : L"Unsupported", 
+        OutputPrint(L"  Boot to Firmware UI: %s. Current value is %s.\n", SupportBootFwUi ? L"Supported" : L"Unsupported", 
                                                                     BootFwUi ? L"SET" : L"UNSET");
         return Status;
     }
@@ -126,7 +129,7 @@ ShellAppMain( UINTN Argc,
                                sizeof (OsIndications),
                                &OsIndications);
     if (Status != EFI_SUCCESS) {
-        Print(L"ERROR: SetVariable: %d\n", Status);
+        OutputPrint(L"ERROR: SetVariable: %d\n", Status);
         return Status;
     }
     
@@ -137,17 +140,17 @@ ShellAppMain( UINTN Argc,
                                &DataSize,
                                &OsIndications);
     if (Status == EFI_NOT_FOUND) {
-        Print(L"ERROR: OsIndications variable not found.\n");
+        OutputPrint(L"ERROR: OsIndications variable not found.\n");
         return Status;
     }
 
 #ifdef DEBUG
-    Print(L"OsIndications variable: 0x%016x\n", OsIndication);
+    OutputPrint(L"OsIndications variable: 0x%016x\n", OsIndication);
 #endif
 
     BootFwUi = (BOOLEAN) ((OsIndications & EFI_OS_INDICATIONS_BOOT_TO_FW_UI) != 0);
 
-    Print(L"  Boot to Firmware UI: %s. Current value is %s.\n", SupportBootFwUi ? L"Supported" : L"Unsupported", 
+    OutputPrint(L"  Boot to Firmware UI: %s. Current value is %s.\n", SupportBootFwUi ? L"Supported" : L"Unsupported", 
                                                                 BootFwUi ? L"SET" : L"UNSET");
 
     return Status;
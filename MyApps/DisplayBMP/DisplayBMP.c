@@ -17,6 +17,7 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/PrintLib.h>
+#include <Library/BufferedOutputLib.h>
 
 #include <Protocol/LoadedImage.h>
 #include <Protocol/SimpleFileSystem.h>
@@ -36,8 +37,9 @@ PressKey( BOOLEAN DisplayText )
     UINTN         EventIndex;
 
     if (DisplayText) {
-        Print(L"\nPress any key to continue...\n\n");
+        OutputPrint(L"\nPress any key to continue...\n\n");
     }
+    OutputFlush();
 
     gBS->WaitForEvent(1, &gST->ConIn->WaitForKey, &EventIndex);
     Status = gST->ConIn->ReadKeyStroke(gST->ConIn, &Key);
@@ -82,7 +84,7 @@ DisplayImage( EFI_GRAPHICS_OUTPUT_PROTOCOL *Gop,
     Pixels = BmpHeader->PixelWidth * BmpHeader->PixelHeight;
     BltBuffer = AllocateZeroPool( sizeof(EFI_GRAPHICS_OUTPUT_BLT_PIXEL) * Pixels);
     if (BltBuffer == NULL) {
-        Print(L"ERROR: BltBuffer. No memory resources\n");
+        OutputPrint(L"ERROR: BltBuffer. No memory resources\n");
         return EFI_OUT_OF_RESOURCES;
     }
 
@@ -105,7 +107,7 @@ DisplayImage( EFI_GRAPHICS_OUTPUT_PROTOCOL *Gop,
                        BmpHeader->PixelWidth, BmpHeader->PixelHeight, 
                        0 );
     if (EFI_ERROR (Status)) {
-        Print(L"ERROR: Gop->Blt [%d]\n", Status);
+        OutputPrint(L"ERROR: Gop->Blt [%d]\n", Status);
     }            
 
     FreePool(BltBuffer);
@@ -126,20 +128,20 @@ PrintBMP( EFI_HANDLE *BmpBuffer )
 
     // not BMP format
     if (BmpHeader->CharB != 'B' || BmpHeader->CharM != 'M') {
-        Print(L"ERROR: Unsupported image format\n"); 
+        OutputPrint(L"ERROR: Unsupported image format\n"); 
         return EFI_UNSUPPORTED;
     }
 
     // BITMAPINFOHEADER format unsupported
     if (BmpHeader->HeaderSize != sizeof (BMP_IMAGE_HEADER) \
         - ((UINTN) &(((BMP_IMAGE_HEADER *)0)->HeaderSize))) {
-        Print(L"ERROR: Unsupported BITMAPFILEHEADER\n");
+        OutputPrint(L"ERROR: Unsupported BITMAPFILEHEADER\n");
         return EFI_UNSUPPORTED;
     }
 
     // compression type not 0
     if (BmpHeader->CompressionType != 0) {
-        Print(L"ERROR: Compression type not 0\n");
+        OutputPrint(L"ERROR: Compression type not 0\n");
         return EFI_UNSUPPORTED;
     }
 
@@ -148,27 +150,27 @@ PrintBMP( EFI_HANDLE *BmpBuffer )
         BmpHeader->BitPerPixel != 8 &&
         BmpHeader->BitPerPixel != 12 &&
         BmpHeader->BitPerPixel != 24) {
-        Print(L"ERROR: Bits per pixel is not one of 4, 8, 12 or 24\n");
+        OutputPrint(L"ERROR: Bits per pixel is not one of 4, 8, 12 or 24\n");
         return EFI_UNSUPPORTED;
     }
 
     AsciiToUnicodeSize((CHAR8 *)BmpHeader, 2, Buffer);
 
-    Print(L"\n");
-    Print(L"  BMP Signature      : %s\n", Buffer);
-    Print(L"  Size               : %d\n", BmpHeader->Size);
-    Print(L"  Image Offset       : %d\n", BmpHeader->ImageOffset);
-    Print(L"  Header Size        : %d\n", BmpHeader->HeaderSize);
-    Print(L"  Image Width        : %d\n", BmpHeader->PixelWidth);
-    Print(L"  Image Height       : %d\n", BmpHeader->PixelHeight);
-    Print(L"  Planes             : %d\n", BmpHeader->Planes);
-    Print(L"  Bit Per Pixel      : %d\n", BmpHeader->BitPerPixel);
-    Print(L"  Compression Type   : %d\n", BmpHeader->CompressionType);
-    Print(L"  Image Size         : %d\n", BmpHeader->ImageSize);
-    Print(L"  X Pixels Per Meter : %d\n", BmpHeader->XPixelsPerMeter);
-    Print(L"  Y Pixels Per Meter : %d\n", BmpHeader->YPixelsPerMeter);
-    Print(L"  Number of Colors   : %d\n", BmpHeader->NumberOfColors);
-    Print(L"  Important Colors   : %d\n", BmpHeader->ImportantColors);
+    OutputPrint(L"\n");
+    OutputPrint(L"  BMP Signature      : %s\n", Buffer);
+    OutputPrint(L"  Size               : %d\n", BmpHeader->Size);
+    OutputPrint(L"  Image Offset       : %d\n", BmpHeader->ImageOffset);
+    OutputPrint(L"  Header Size        : %d\n", BmpHeader->HeaderSize);
+    OutputPrint(L"  Image Width        : %d\n", BmpHeader->PixelWidth);
+    OutputPrint(L"  Image Height       : %d\n", BmpHeader->PixelHeight);
+    OutputPrint(L"  Planes             : %d\n", BmpHeader->Planes);
+    OutputPrint(L"  Bit Per Pixel      : %d\n", BmpHeader->BitPerPixel);
+    OutputPrint(L"  Compression Type   : %d\n", BmpHeader->CompressionType);
+    OutputPrint(L"  Image Size         : %d\n", BmpHeader->ImageSize);
+    OutputPrint(L"  X Pixels Per Meter : %d\n", BmpHeader->XPixelsPerMeter);
+    OutputPrint(L"  Y Pixels Per Meter : %d\n", BmpHeader->YPixelsPerMeter);
+    OutputPrint(L"  Number of Colors   : %d\n", BmpHeader->NumberOfColors);
+    OutputPrint(L"  Important Colors   : %d\n", BmpHeader->ImportantColors);
 
     return Status;
 }
@@ -178,11 +180,11 @@ VOID
 Usage( BOOLEAN ErrorMsg )
 {
     if ( ErrorMsg ) {
-        Print(L"ERROR: Unknown option(s).\n");
+        OutputPrint(L"ERROR: Unknown option(s).\n");
     }
 
-    Print(L"Usage: DisplayBMP [-v | --verbose] BMPfilename\n"); 
-    Print(L"       DisplayBMP [-V | --version]\n"); 
+    OutputPrint(L"Usage: DisplayBMP [-v | --verbose] BMPfilename\n"); 
+    OutputPrint(L"       DisplayBMP [-V | --version]\n"); 
 }
 
 
@@ -204,10 +206,12 @@ ShellAppMain( UINTN Argc,
 
     int OrgMode = 0, NewMode = 0, Pixels = 0;
 
+    OutputInit(&Argc, Argv);
+
     if (Argc == 2) {
         if (!StrCmp(Argv[1], L"--version") ||
             !StrCmp(Argv[1], L"-V")) {
-            Print(L"Version: %s\n", UTILITY_VERSION);
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
             return Status;
         } else if (!StrCmp(Argv[1], L"--help") ||
             !StrCmp(Argv[1], L"-h")) {
@@ -241,7 +245,7 @@ ShellAppMain( UINTN Argc,
                                   &FileHandle,
                                   EFI_FILE_MODE_READ , 0);
     if (EFI_ERROR (Status)) {
-        Print(L"ERROR: Could not open specified file [%d]\n", Status);
+        OutputPrint(L"ERROR: Could not open specified file [%d]\n", Status);
         return Status;
     }            
 
@@ -249,7 +253,7 @@ ShellAppMain( UINTN Argc,
     FileInfo = ShellGetFileInfo(FileHandle);    
     FileBuffer = AllocateZeroPool( (UINTN)FileInfo -> FileSize);
     if (FileBuffer == NULL) {
-        Print(L"ERROR: File buffer. No memory resources\n");
+        OutputPrint(L"ERROR: File buffer. No memory resources\n");
         return (SHELL_OUT_OF_RESOURCES);   
     }
 
@@ -257,7 +261,7 @@ ShellAppMain( UINTN Argc,
     FileSize = (UINTN) FileInfo->FileSize;
     Status = ShellReadFile(FileHandle, &FileSize, FileBuffer);
     if (EFI_ERROR (Status)) {
-        Print(L"ERROR: ShellReadFile failed [%d]\n", Status);
+        OutputPrint(L"ERROR: ShellReadFile failed [%d]\n", Status);
         goto cleanup;
     }            
   
@@ -275,12 +279,12 @@ ShellAppMain( UINTN Argc,
                                       &HandleCount,
                                       &Handles );
     if (EFI_ERROR (Status)) {
-        Print(L"ERROR: No GOP handles found via LocateHandleBuffer\n");
+        OutputPrint(L"ERROR: No GOP handles found via LocateHandleBuffer\n");
         goto cleanup;
     } 
 
 #ifdef DEBUG
-    Print(L"Found %d GOP handles via LocateHandleBuffer\n", HandleCount);
+    OutputPrint(L"Found %d GOP handles via LocateHandleBuffer\n", HandleCount);
 #endif
 
     // Make sure we use the correct GOP handle
@@ -300,7 +304,7 @@ ShellAppMain( UINTN Argc,
      }
      FreePool(Handles);
      if (Gop == NULL) {
-         Print(L"Exiting. Graphics console not found.\n");
+         OutputPrint(L"Exiting. Graphics console not found.\n");
          goto cleanup;
      }
 
@@ -332,14 +336,15 @@ ShellAppMain( UINTN Argc,
     }
 
 #ifdef DEBUG
-    Print(L"OrgMode; %d  NewMode: %d\n", OrgMode, NewMode);
+    OutputPrint(L"OrgMode; %d  NewMode: %d\n", OrgMode, NewMode);
 #endif
    
-    // Change screen mode 
+    // Change screen mode - anything still buffered would be lost
+    OutputFlush();
     Status = Gop->SetMode( Gop,
                            NewMode );
     if (EFI_ERROR (Status)) { 
-        Print(L"ERROR: SetMode [%d]\n", Status);
+        OutputPrint(L"ERROR: SetMode [%d]\n", Status);
         goto cleanup;
     }
         
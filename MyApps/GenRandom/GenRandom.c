@@ -0,0 +1,551 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Stream random bytes from the TPM (2.0 or 1.2), RDRAND or RDSEED to
+//  a file and report the throughput of each source
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/UefiLib.h>
+#include <Library/ShellCEntryLib.h>
+#include <Library/ShellLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/TscTimerLib.h>
+#include <Library/TpmCommandLib.h>
+
+#include <Protocol/EfiShell.h>
+#include <Protocol/LoadedImage.h>
+
+#include <Register/Cpuid.h>
+
+#define UTILITY_VERSION L"20181029"
+#undef DEBUG
+
+#define DEFAULT_MEGABYTES   1
+#define MAX_MEGABYTES       4096
+#define CHUNK_SIZE          OUTPUT_FILE_BUFFER_SIZE
+#define TPM12_RANDOM_BYTES  1024          // per TPM_ORD_GetRandom; the TPM may return fewer
+#define TPM_BUFFER_SIZE     (TPM_HEADER_SIZE + sizeof(UINT32) + TPM12_RANDOM_BYTES)
+#define RDRAND_RETRIES      10            // Intel DRNG guide: ten failures in a row means broken
+#define RDSEED_RETRIES      1000          // RDSEED runs dry under load; pause and try again
+
+//
+// RdRand.nasm
+//
+BOOLEAN EFIAPI RdRandStep64( UINT64 *Value );
+BOOLEAN EFIAPI RdSeedStep64( UINT64 *Value );
+
+typedef struct _RANDOM_SOURCE RANDOM_SOURCE;
+
+//
+// Probe returns EFI_SUCCESS if the source can be used.  Fill writes
+// exactly Size bytes or fails.
+//
+typedef EFI_STATUS (*RANDOM_PROBE)( RANDOM_SOURCE *Source );
+typedef EFI_STATUS (*RANDOM_FILL)( RANDOM_SOURCE *Source, UINT8 *Buffer, UINTN Size );
+
+struct _RANDOM_SOURCE {
+    CHAR16       *Name;
+    RANDOM_PROBE Probe;
+    RANDOM_FILL  Fill;
+    CHAR16       *Description;            // set by Probe
+    UINT64       Requests;                // TPM commands or instructions issued
+    UINT64       Retries;                 // instructions that returned no data
+};
+
+typedef struct {
+    UINT64 Bytes;
+    UINT64 FillUs;                        // time spent in the source
+    UINT64 WriteUs;                       // time spent writing the file
+} RANDOM_RESULT;
+
+//
+// The TPM command is built once and resubmitted unchanged
+//
+STATIC TPM_COMMAND TpmCommand;
+STATIC UINT8       TpmCommandBuffer[TPM_BUFFER_SIZE];
+STATIC UINT8       TpmResponseBuffer[TPM_BUFFER_SIZE];
+
+
+//
+// Value of one fixed TPM 2.0 property, or Default if it cannot be read
+//
+static UINT32
+Tpm2Property( UINT32 Property,
+              UINT32 Default )
+{
+    TPM_RESPONSE Response;
+    UINT8        RecvBuffer[TPM_HEADER_SIZE + sizeof(UINT8) + 4 * sizeof(UINT32)];
+    UINT32       Value;
+
+    if (EFI_ERROR(TpmGetCapability(TPM_CAP_TPM_PROPERTIES, Property, 1, NULL,
+                                   &Response, RecvBuffer, sizeof(RecvBuffer)))) {
+        return Default;
+    }
+    if (TpmGetUint32(&Response) != 1 || TpmGetUint32(&Response) != Property) {
+        return Default;
+    }
+    Value = TpmGetUint32(&Response);
+
+    return Response.Error ? Default : Value;
+}
+
+
+//
+// TPM2_GetRandom returns at most one digest's worth (TPM_PT_MAX_DIGEST)
+// per command, and no more than fits in TPM_PT_MAX_RESPONSE_SIZE
+//
+static EFI_STATUS
+ProbeTpm( RANDOM_SOURCE *Source )
+{
+    TPM_TRANSPORT Transport;
+    EFI_STATUS    Status;
+    UINT32        MaxDigest;
+    UINT32        MaxResponse;
+    UINT32        Request;
+
+    Status = TpmOpen(&Transport);
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+
+    if (Transport == TpmTransportTpm20) {
+        MaxDigest = Tpm2Property(TPM_PT_MAX_DIGEST, SHA256_DIGEST_SIZE);
+        MaxResponse = Tpm2Property(TPM_PT_MAX_RESPONSE_SIZE, TPM_BUFFER_SIZE);
+        Request = MIN(MaxDigest, sizeof(TPMU_HA));
+        if (MaxResponse > TPM_HEADER_SIZE + sizeof(UINT16)) {
+            Request = MIN(Request, MaxResponse - TPM_HEADER_SIZE - sizeof(UINT16));
+        }
+        TpmCommandBegin(&TpmCommand, TpmCommandBuffer, sizeof(TpmCommandBuffer),
+                        TPM_ST_NO_SESSIONS, TPM_CC_GetRandom);
+        TpmPutUint16(&TpmCommand, (UINT16) Request);
+        Source->Description = L"TPM 2.0 TPM2_GetRandom";
+    } else {
+        TpmCommandBegin(&TpmCommand, TpmCommandBuffer, sizeof(TpmCommandBuffer),
+                        TPM_TAG_RQU_COMMAND, TPM_ORD_GetRandom);
+        TpmPutUint32(&TpmCommand, TPM12_RANDOM_BYTES);
+        Source->Description = L"TPM 1.2 TPM_ORD_GetRandom";
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+static EFI_STATUS
+FillTpm( RANDOM_SOURCE *Source,
+         UINT8 *Buffer,
+         UINTN Size )
+{
+    TPM_RESPONSE Response;
+    EFI_STATUS   Status;
+    UINT8        *Data;
+    UINT32       Length;
+    UINT16       Length16;
+
+    while (Size > 0) {
+        Status = TpmSubmit(&TpmCommand, &Response, TpmResponseBuffer, sizeof(TpmResponseBuffer));
+        Source->Requests++;
+        if (EFI_ERROR(Status)) {
+            return Status;
+        }
+
+        if (TpmTransport() == TpmTransportTpm20) {
+            Data = TpmGetTpm2b(&Response, &Length16);
+            Length = Length16;
+        } else {
+            Length = TpmGetUint32(&Response);
+            Data = TpmGetBytes(&Response, Length);
+        }
+        if (Data == NULL || Length == 0) {
+            return EFI_DEVICE_ERROR;
+        }
+
+        Length = (UINT32) MIN(Length, Size);
+        CopyMem(Buffer, Data, Length);
+        Buffer += Length;
+        Size -= Length;
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+static EFI_STATUS
+ProbeRdRand( RANDOM_SOURCE *Source )
+{
+    CPUID_VERSION_INFO_ECX Ecx;
+
+    AsmCpuid(CPUID_VERSION_INFO, NULL, NULL, &Ecx.Uint32, NULL);
+    if (!Ecx.Bits.RDRAND) {
+        return EFI_UNSUPPORTED;
+    }
+    Source->Description = L"RDRAND instruction";
+
+    return EFI_SUCCESS;
+}
+
+
+static EFI_STATUS
+ProbeRdSeed( RANDOM_SOURCE *Source )
+{
+    CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS_EBX Ebx;
+    UINT32 MaxLeaf;
+
+    AsmCpuid(CPUID_SIGNATURE, &MaxLeaf, NULL, NULL, NULL);
+    if (MaxLeaf < CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS) {
+        return EFI_UNSUPPORTED;
+    }
+    AsmCpuidEx(CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS,
+               CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS_SUB_LEAF_INFO,
+               NULL, &Ebx.Uint32, NULL, NULL);
+    if (!Ebx.Bits.RDSEED) {
+        return EFI_UNSUPPORTED;
+    }
+    Source->Description = L"RDSEED instruction";
+
+    return EFI_SUCCESS;
+}
+
+
+//
+// Fill from a 64-bit instruction, retrying up to Retries times in a row
+// when it returns no data (carry clear)
+//
+static EFI_STATUS
+FillInstruction( RANDOM_SOURCE *Source,
+                 BOOLEAN (EFIAPI *Step)( UINT64 * ),
+                 UINTN Retries,
+                 UINT8 *Buffer,
+                 UINTN Size )
+{
+    UINT64 Value;
+    UINTN  Failed;
+    UINTN  Length;
+
+    while (Size > 0) {
+        for (Failed = 0; !Step(&Value); Failed++) {
+            if (Failed == Retries) {
+                return EFI_DEVICE_ERROR;
+            }
+            Source->Retries++;
+            CpuPause();
+        }
+        Source->Requests++;
+
+        Length = MIN(sizeof(Value), Size);
+        CopyMem(Buffer, &Value, Length);
+        Buffer += Length;
+        Size -= Length;
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+static EFI_STATUS
+FillRdRand( RANDOM_SOURCE *Source,
+            UINT8 *Buffer,
+            UINTN Size )
+{
+    return FillInstruction(Source, RdRandStep64, RDRAND_RETRIES, Buffer, Size);
+}
+
+
+static EFI_STATUS
+FillRdSeed( RANDOM_SOURCE *Source,
+            UINT8 *Buffer,
+            UINTN Size )
+{
+    return FillInstruction(Source, RdSeedStep64, RDSEED_RETRIES, Buffer, Size);
+}
+
+
+STATIC RANDOM_SOURCE Sources[] = {
+    { L"tpm",    ProbeTpm,    FillTpm,    NULL, 0, 0 },
+    { L"rdrand", ProbeRdRand, FillRdRand, NULL, 0, 0 },
+    { L"rdseed", ProbeRdSeed, FillRdSeed, NULL, 0, 0 },
+};
+
+
+//
+// Generate Bytes in CHUNK_SIZE pieces, writing each to File if not NULL
+//
+static EFI_STATUS
+Generate( RANDOM_SOURCE *Source,
+          UINT64 Bytes,
+          UINT8 *Chunk,
+          OUTPUT_FILE *File,
+          RANDOM_RESULT *Result )
+{
+    EFI_STATUS Status = EFI_SUCCESS;
+    UINT64     FillTicks = 0;
+    UINT64     WriteTicks = 0;
+    UINT64     Start;
+    UINTN      Size;
+
+    ZeroMem(Result, sizeof(RANDOM_RESULT));
+
+    while (Result->Bytes < Bytes) {
+        Size = (UINTN) MIN(Bytes - Result->Bytes, CHUNK_SIZE);
+
+        Start = TimerTick();
+        Status = Source->Fill(Source, Chunk, Size);
+        FillTicks += TimerTick() - Start;
+        if (EFI_ERROR(Status)) {
+            break;
+        }
+
+        if (File != NULL) {
+            Start = TimerTick();
+            Status = OutputFileWrite(File, Chunk, Size);
+            WriteTicks += TimerTick() - Start;
+            if (EFI_ERROR(Status)) {
+                break;
+            }
+        }
+        Result->Bytes += Size;
+    }
+
+    Result->FillUs = TimerTicksToMicroseconds(FillTicks);
+    Result->WriteUs = TimerTicksToMicroseconds(WriteTicks);
+
+    return Status;
+}
+
+
+static UINT64
+BytesPerSecond( UINT64 Bytes,
+                UINT64 Microseconds )
+{
+    if (Microseconds == 0) {
+        return 0;
+    }
+
+    return DivU64x64Remainder(MultU64x32(Bytes, 1000000), Microseconds, NULL);
+}
+
+
+static VOID
+PrintResult( RANDOM_SOURCE *Source,
+             RANDOM_RESULT *Result,
+             EFI_STATUS Status )
+{
+    OutputPrint(L"%-7s", Source->Name);
+    if (Source->Description == NULL) {
+        OutputPrint(L"  not available\n");
+        return;
+    }
+    OutputPrint(L" %12ld %12ld %10ld %10ld %8ld  %s\n", Result->Bytes,
+                BytesPerSecond(Result->Bytes, Result->FillUs), Source->Requests,
+                Source->Retries, Result->FillUs / 1000, Source->Description);
+    if (EFI_ERROR(Status)) {
+        OutputPrint(L"        stopped after %ld bytes [%r]\n", Result->Bytes, Status);
+    }
+}
+
+
+static VOID
+JsonResult( RANDOM_SOURCE *Source,
+            RANDOM_RESULT *Result,
+            EFI_STATUS Status )
+{
+    JsonObjectBegin(NULL);
+    JsonString(L"source", Source->Name);
+    JsonBool(L"available", Source->Description != NULL);
+    if (Source->Description != NULL) {
+        JsonString(L"description", Source->Description);
+        JsonUint(L"bytes", Result->Bytes);
+        JsonUint(L"bytesPerSecond", BytesPerSecond(Result->Bytes, Result->FillUs));
+        JsonUint(L"requests", Source->Requests);
+        JsonUint(L"retries", Source->Retries);
+        JsonUint(L"sourceUs", Result->FillUs);
+        JsonUint(L"writeUs", Result->WriteUs);
+        if (EFI_ERROR(Status)) {
+            JsonPrint(L"error", L"%r", Status);
+        }
+    }
+    JsonObjectEnd();
+}
+
+
+BOOLEAN
+IsNumber( CHAR16* str )
+{
+    CHAR16 *s = str;
+
+    if (*s == 0)
+        return FALSE;
+
+    while (*s) {
+        if (*s  < L'0' || *s > L'9')
+            return FALSE;
+        s++;
+    }
+
+    return TRUE;
+}
+
+
+VOID
+Usage( CHAR16 *Str,
+       BOOLEAN ErrorMsg )
+{
+    if ( ErrorMsg ) {
+        OutputPrint(L"ERROR: Unknown option.\n");
+    }
+    OutputPrint(L"Usage: %s [-s | --source <tpm | rdrand | rdseed>] [-m | --megabytes <count>] -o <file>\n", Str);
+    OutputPrint(L"       %s [-m | --megabytes <count>] [--json]\n", Str);
+    OutputPrint(L"       %s [-V | --version]\n", Str);
+    OutputPrint(L"\nWith -o, <count> MB (default %d) from the one source are written to <file>.\n",
+                DEFAULT_MEGABYTES);
+    OutputPrint(L"Without -o, every available source generates <count> MB and its rate is reported.\n");
+}
+
+
+INTN
+EFIAPI
+ShellAppMain( UINTN Argc,
+              CHAR16 **Argv )
+{
+    EFI_STATUS    Status = EFI_SUCCESS;
+    EFI_STATUS    GenerateStatus;
+    RANDOM_RESULT Result;
+    OUTPUT_FILE   File;
+    UINT8         *Chunk = NULL;
+    CHAR16        *SourceName = NULL;
+    CHAR16        *FileName = NULL;
+    UINTN         Megabytes = DEFAULT_MEGABYTES;
+    BOOLEAN       Json = FALSE;
+    UINTN         Selected = 0;
+
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
+
+    for (UINTN i = 1; i < Argc; i++) {
+        if (!StrCmp(Argv[i], L"--version") ||
+            !StrCmp(Argv[i], L"-V")) {
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
+            return Status;
+        } else if (!StrCmp(Argv[i], L"--help") ||
+            !StrCmp(Argv[i], L"-h")) {
+            Usage(Argv[0], FALSE);
+            return Status;
+        } else if ((!StrCmp(Argv[i], L"--source") ||
+            !StrCmp(Argv[i], L"-s")) && i + 1 < Argc) {
+            SourceName = Argv[++i];
+        } else if ((!StrCmp(Argv[i], L"--megabytes") ||
+            !StrCmp(Argv[i], L"-m")) && i + 1 < Argc && IsNumber(Argv[i + 1])) {
+            Megabytes = StrDecimalToUintn(Argv[++i]);
+        } else if ((!StrCmp(Argv[i], L"--output") ||
+            !StrCmp(Argv[i], L"-o")) && i + 1 < Argc) {
+            FileName = Argv[++i];
+        } else {
+            Usage(Argv[0], TRUE);
+            return Status;
+        }
+    }
+
+    if (Megabytes < 1 || Megabytes > MAX_MEGABYTES) {
+        OutputPrint(L"ERROR: Megabytes must be between 1 and %d\n", MAX_MEGABYTES);
+        return EFI_INVALID_PARAMETER;
+    }
+    if (SourceName != NULL) {
+        for (Selected = 0; Selected < ARRAY_SIZE(Sources); Selected++) {
+            if (!StrCmp(SourceName, Sources[Selected].Name)) {
+                break;
+            }
+        }
+        if (Selected == ARRAY_SIZE(Sources)) {
+            Usage(Argv[0], TRUE);
+            return EFI_INVALID_PARAMETER;
+        }
+    } else if (FileName != NULL) {
+        OutputPrint(L"ERROR: -o needs a single source (-s)\n");
+        return EFI_INVALID_PARAMETER;
+    }
+
+    if (Json) {
+        JsonDocumentBegin(L"GenRandom", UTILITY_VERSION);
+    }
+
+    Chunk = AllocatePool(CHUNK_SIZE);
+    if (Chunk == NULL) {
+        JsonError(L"Out of memory");
+        Status = EFI_OUT_OF_RESOURCES;
+        goto Done;
+    }
+
+    if (FileName != NULL) {
+        Status = OutputFileOpen(&File, FileName);
+        if (EFI_ERROR(Status)) {
+            JsonError(L"Opening %s [%d]", FileName, Status);
+            goto Done;
+        }
+    }
+
+    if (Json) {
+        JsonUint(L"bytesPerSource", MultU64x32(Megabytes, SIZE_1MB));
+        if (FileName != NULL) {
+            JsonString(L"file", FileName);
+        }
+        JsonArrayBegin(L"sources");
+    } else {
+        OutputPrint(L"%d MB per source, %d byte chunks\n\n", Megabytes, CHUNK_SIZE);
+        OutputPrint(L"Source         Bytes      Bytes/s   Requests    Retries     ms  Description\n");
+    }
+
+    for (UINTN i = 0; i < ARRAY_SIZE(Sources); i++) {
+        if (SourceName != NULL && i != Selected) {
+            continue;
+        }
+        ZeroMem(&Result, sizeof(Result));
+        GenerateStatus = Sources[i].Probe(&Sources[i]);
+        if (EFI_ERROR(GenerateStatus)) {
+            Sources[i].Description = NULL;
+        } else {
+            GenerateStatus = Generate( &Sources[i],
+                                       MultU64x32(Megabytes, SIZE_1MB),
+                                       Chunk,
+                                       FileName != NULL ? &File : NULL,
+                                       &Result );
+        }
+        if (SourceName != NULL) {
+            Status = EFI_ERROR(GenerateStatus) ? GenerateStatus : EFI_SUCCESS;
+        }
+        if (Json) {
+            JsonResult(&Sources[i], &Result, GenerateStatus);
+        } else {
+            PrintResult(&Sources[i], &Result, GenerateStatus);
+        }
+    }
+
+    if (Json) {
+        JsonArrayEnd();
+    }
+
+    if (FileName != NULL) {
+        GenerateStatus = OutputFileClose(&File);
+        if (EFI_ERROR(GenerateStatus)) {
+            JsonError(L"Writing %s [%d]", FileName, GenerateStatus);
+            Status = GenerateStatus;
+        } else if (!Json) {
+            OutputPrint(L"\nWrote %ld bytes to %s\n", Result.Bytes, FileName);
+        }
+    }
+
+Done:
+    if (Json) {
+        JsonDocumentEnd();
+    }
+    if (Chunk != NULL) {
+        FreePool(Chunk);
+    }
+
+    return Status;
+}
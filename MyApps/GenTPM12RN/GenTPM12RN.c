@@ -15,6 +15,9 @@
 #include <Library/ShellLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/TpmCommandLib.h>
 
 #include <Protocol/EfiShell.h>
 #include <Protocol/LoadedImage.h>
@@ -30,20 +33,6 @@
 #define DEFAULT_NUMBER_RANDOM_BYTES 1 
 #define MAX_RANDOM_BYTES 24
 
-#pragma pack(1)
-typedef struct {
-    TPM_RQU_COMMAND_HDR Header;
-    UINT32              BytesRequested;
-} TPM_COMMAND;
-
-typedef struct {
-    TPM_RSP_COMMAND_HDR Header;
-    UINT32              RandomBytesSize;
-    UINT8               RandomBytes[MAX_RANDOM_BYTES];
-} TPM_RESPONSE;
-#pragma pack()
-
-
 BOOLEAN
 IsNumber( CHAR16* str )
 {
@@ -63,33 +52,16 @@ IsNumber( CHAR16* str )
 }
 
 
-BOOLEAN
-CheckForTpm20()
-{
-     EFI_STATUS Status = EFI_SUCCESS;
-     EFI_TCG2_PROTOCOL *Tcg2Protocol;
-     EFI_GUID gEfiTcg2ProtocolGuid = EFI_TCG2_PROTOCOL_GUID;
-
-     Status = gBS->LocateProtocol( &gEfiTcg2ProtocolGuid,
-                                   NULL,
-                                   (VOID **) &Tcg2Protocol );
-     if (EFI_ERROR (Status)) {
-         return FALSE;
-     }
-
-     return TRUE;
-}
-
-
 VOID
 Usage( CHAR16 *Str,
        BOOLEAN ErrorMsg )
 {
     if ( ErrorMsg ) {
-        Print(L"ERROR: Unknown option.\n");
+        OutputPrint(L"ERROR: Unknown option.\n");
     }
-    Print(L"Usage: %s [-v | --verbose] [NumberOfBytes]\n", Str);
-    Print(L"       %s [-V | --version]\n", Str);
+    OutputPrint(L"Usage: %s [-v | --verbose] [NumberOfBytes]\n", Str);
+    OutputPrint(L"       %s [-v | --verbose] [NumberOfBytes] --json\n", Str);
+    OutputPrint(L"       %s [-V | --version]\n", Str);
 }
 
 
@@ -99,21 +71,24 @@ ShellAppMain( UINTN Argc,
               CHAR16 **Argv )
 {
     EFI_STATUS Status = EFI_SUCCESS;
-    EFI_TCG_PROTOCOL *TcgProtocol;
-    EFI_GUID gEfiTcgProtocolGuid = EFI_TCG_PROTOCOL_GUID;
+    TPM_TRANSPORT Transport;
     UINTN NumberRandomBytes = DEFAULT_NUMBER_RANDOM_BYTES;
     BOOLEAN Verbose = FALSE;
+    BOOLEAN Json = FALSE;
  
-    TPM_COMMAND  InBuffer;
-    TPM_RESPONSE OutBuffer;
-    UINT32       InBufferSize;
-    UINT32       OutBufferSize;
-    int          RandomBytesSize = 0;
+    TPM_COMMAND  Command;
+    TPM_RESPONSE Response;
+    UINT8        Buffer[TPM_HEADER_SIZE + sizeof(UINT32) + MAX_RANDOM_BYTES];
+    UINT8        *RandomBytes;
+    UINT32       RandomBytesSize = 0;
+
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
 
     if (Argc == 2) {
         if (!StrCmp(Argv[1], L"--version") ||
             !StrCmp(Argv[1], L"-V")) {
-            Print(L"Version: %s\n", UTILITY_VERSION);
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
             return Status;
         } else if (!StrCmp(Argv[1], L"--help") ||
             !StrCmp(Argv[1], L"-h")) {
@@ -145,66 +120,74 @@ ShellAppMain( UINTN Argc,
     }
 
     if (NumberRandomBytes < 1) {
-        Print(L"ERROR: Zero or negative number entered\n");
+        OutputPrint(L"ERROR: Zero or negative number entered\n");
         Usage(Argv[0], FALSE);
         return Status;
     } else if (NumberRandomBytes > MAX_RANDOM_BYTES) {
-        Print(L"Sorry - Output limited to a maximum of %d bytes\n", MAX_RANDOM_BYTES);
+        if (!Json) {
+            OutputPrint(L"Sorry - Output limited to a maximum of %d bytes\n", MAX_RANDOM_BYTES);
+        }
         NumberRandomBytes = MAX_RANDOM_BYTES;
     } 
 
-    Status = gBS->LocateProtocol( &gEfiTcgProtocolGuid, 
-                                  NULL, 
-                                  (VOID **) &TcgProtocol );
-    if (EFI_ERROR (Status)) {
-        if (CheckForTpm20()) {
-            Print(L"ERROR: Platform configured for TPM 2.0, not TPM 1.2\n");
+    if (Json) {
+        JsonDocumentBegin(L"GenTPM12RN", UTILITY_VERSION);
+    }
+
+    Status = TpmOpen(&Transport);
+    if (Transport != TpmTransportTpm12) {
+        if (Transport == TpmTransportTpm20) {
+            JsonError(L"Platform configured for TPM 2.0, not TPM 1.2");
+            Status = EFI_UNSUPPORTED;
         } else {
-            Print(L"ERROR: Failed to locate EFI_TCG_PROTOCOL [%d]\n", Status);
+            JsonError(L"Failed to locate EFI_TCG_PROTOCOL [%d]", Status);
         }
         return Status;
     }
 
-    InBufferSize = sizeof(TPM_COMMAND);
-    OutBufferSize = sizeof(TPM_RESPONSE);
-
-    InBuffer.Header.tag       = SwapBytes16(TPM_TAG_RQU_COMMAND);
-    InBuffer.Header.paramSize = SwapBytes32(InBufferSize);
-    InBuffer.Header.ordinal   = SwapBytes32(TPM_ORD_GetRandom);
-    InBuffer.BytesRequested   = SwapBytes32(NumberRandomBytes);
-
-    Status = TcgProtocol->PassThroughToTpm( TcgProtocol,
-                                            InBufferSize,
-                                            (UINT8 *)&InBuffer,
-                                            OutBufferSize,
-                                            (UINT8 *)&OutBuffer );
-    if (EFI_ERROR (Status)) {
-        Print(L"ERROR: PassThroughToTpm failed [%d]\n", Status);
+    TpmCommandBegin(&Command, Buffer, sizeof(Buffer), TPM_TAG_RQU_COMMAND, TPM_ORD_GetRandom);
+    TpmPutUint32(&Command, (UINT32) NumberRandomBytes);
+
+    Status = TpmSubmit(&Command, &Response, Buffer, sizeof(Buffer));
+    if (Status == EFI_PROTOCOL_ERROR) {
+        JsonError(L"TPM command result [%d]", Response.ResponseCode);
+        return EFI_DEVICE_ERROR;
+    } else if (EFI_ERROR (Status)) {
+        JsonError(L"PassThroughToTpm failed [%d]", Status);
         return Status;
     }
 
-    if ((OutBuffer.Header.tag != SwapBytes16 (TPM_TAG_RSP_COMMAND)) || (OutBuffer.Header.returnCode != 0)) {
-        Print(L"ERROR: TPM command result [%d]\n", SwapBytes32(OutBuffer.Header.returnCode));
+    // the size comes from the TPM; TpmGetBytes checks it against what arrived
+    RandomBytesSize = TpmGetUint32(&Response);
+    RandomBytes = TpmGetBytes(&Response, RandomBytesSize);
+    if (RandomBytes == NULL) {
+        JsonError(L"Malformed GetRandom response");
         return EFI_DEVICE_ERROR;
     }
 
-    RandomBytesSize = SwapBytes32(OutBuffer.RandomBytesSize);
+    if (Json) {
+        JsonUint(L"bytesRequested", NumberRandomBytes);
+        JsonUint(L"bytesReceived", RandomBytesSize);
+        JsonBytes(L"randomBytes", RandomBytes, RandomBytesSize);
+        JsonDocumentEnd();
+        return Status;
+    }
 
     if (Verbose) {
-        Print(L"\n");
-        Print(L"  Number of Random Bytes Requested: %d\n", SwapBytes32(InBuffer.BytesRequested));
-        Print(L"   Number of Random Bytes Received: %d\n", RandomBytesSize);
-        Print(L"             Ramdom Bytes Received: ");
-        for (int i = 0; i < RandomBytesSize; i++) {
-            Print(L"%02x ", OutBuffer.RandomBytes[i]);
+        OutputPrint(L"\n");
+        OutputPrint(L"  Number of Random Bytes Requested: %d\n", NumberRandomBytes);
+        OutputPrint(L"   Number of Random Bytes Received: %d\n", RandomBytesSize);
+        OutputPrint(L"             Ramdom Bytes Received: ");
+        for (UINT32 i = 0; i < RandomBytesSize; i++) {
+            OutputPrint(L"%02x ", RandomBytes[i]);
         }
-        Print(L"\n");
+        OutputPrint(L"\n");
     } else {
-        for (int i = 0; i < RandomBytesSize; i++) {
-            Print(L"%02x", OutBuffer.RandomBytes[i]);
+        for (UINT32 i = 0; i < RandomBytesSize; i++) {
+            OutputPrint(L"%02x", RandomBytes[i]);
         }
     }
-    Print(L"\n");
+    OutputPrint(L"\n");
 
     return Status;
 }
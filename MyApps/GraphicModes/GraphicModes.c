@@ -19,6 +19,8 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/PrintLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
 
 #include <Protocol/GraphicsOutput.h>
 #include <Protocol/UgaDraw.h>
@@ -44,29 +46,29 @@ PrintCCP( EFI_CONSOLE_CONTROL_PROTOCOL *ConsoleControl )
                                       &GopUgaExists,
                                       &StdInLocked );
     if (EFI_ERROR (Status)) {
-        Print(L"ERROR: ConsoleControl GetMode failed [%d]\n", Status );
+        OutputPrint(L"ERROR: ConsoleControl GetMode failed [%d]\n", Status );
         return Status;
     }
 
-    Print(L"  CCP: Current screen mode: ");
+    OutputPrint(L"  CCP: Current screen mode: ");
     switch (Mode) {
        case EfiConsoleControlScreenText:
-           Print(L"Text");
+           OutputPrint(L"Text");
            break;
        case EfiConsoleControlScreenGraphics:
-           Print(L"Graphics");
+           OutputPrint(L"Graphics");
            break;
        case EfiConsoleControlScreenMaxValue:
-           Print(L"MaxValue");
+           OutputPrint(L"MaxValue");
            break;
     }
-    Print(L"\n");
-    Print(L"       Graphics support available: ");
+    OutputPrint(L"\n");
+    OutputPrint(L"       Graphics support available: ");
     if (GopUgaExists) 
-        Print(L"Yes");
+        OutputPrint(L"Yes");
     else
-        Print(L"No");
-    Print(L"\n");
+        OutputPrint(L"No");
+    OutputPrint(L"\n");
 
     return EFI_SUCCESS;
 }
@@ -87,11 +89,11 @@ CheckCCP( BOOLEAN Verbose )
                                   (VOID **) &ConsoleControl );
     if (EFI_ERROR (Status)) {
         if (Verbose) {
-            Print(L"No ConsoleControl handle found via HandleProtocol\n");
+            OutputPrint(L"No ConsoleControl handle found via HandleProtocol\n");
         }
     } else {
         if (Verbose) {
-            Print(L"ConsoleControl handle found via HandleProtocol\n");
+            OutputPrint(L"ConsoleControl handle found via HandleProtocol\n");
         }
         PrintCCP(ConsoleControl);
         if (Verbose == FALSE) {
@@ -105,11 +107,11 @@ CheckCCP( BOOLEAN Verbose )
                                   (VOID **) &ConsoleControl );
     if (EFI_ERROR(Status) || ConsoleControl == NULL) {
         if (Verbose) {
-            Print(L"No ConsoleControl handle found via LocateProtocol\n");
+            OutputPrint(L"No ConsoleControl handle found via LocateProtocol\n");
         }
     } else {
         if (Verbose) {
-            Print(L"Found ConsoleControl handle via LocateProtocol\n");
+            OutputPrint(L"Found ConsoleControl handle via LocateProtocol\n");
         }
         PrintCCP(ConsoleControl);
         if (Verbose == FALSE) {
@@ -125,11 +127,11 @@ CheckCCP( BOOLEAN Verbose )
                                       &HandleBuffer );
     if (EFI_ERROR (Status)) {
         if (Verbose) {
-            Print(L"No ConsoleControl handles found via LocateHandleBuffer\n");
+            OutputPrint(L"No ConsoleControl handles found via LocateHandleBuffer\n");
         }
     } else {
         if (Verbose) {
-            Print(L"Found %d ConsoleControl handle(s) via LocateHandleBuffer\n", HandleCount);
+            OutputPrint(L"Found %d ConsoleControl handle(s) via LocateHandleBuffer\n", HandleCount);
         }
         for (int i = 0; i < HandleCount; i++) {
             Status = gBS->HandleProtocol( HandleBuffer[i],
@@ -163,13 +165,13 @@ PrintUGA( EFI_UGA_DRAW_PROTOCOL *Uga )
                            &ColorDepth, 
                            &RefreshRate );
     if (EFI_ERROR (Status)) {
-        Print(L"ERROR: UGA GetMode failed [%d]\n", Status );
+        OutputPrint(L"ERROR: UGA GetMode failed [%d]\n", Status );
     } else {
-        Print(L"  UGA Horizontal Resolution: %d\n", HorzResolution);
-        Print(L"      Vertical Resolution: %d\n", VertResolution);
-        Print(L"      Color Depth: %d\n", ColorDepth);
-        Print(L"      Refresh Rate: %d\n", RefreshRate);
-        Print(L"\n");
+        OutputPrint(L"  UGA Horizontal Resolution: %d\n", HorzResolution);
+        OutputPrint(L"      Vertical Resolution: %d\n", VertResolution);
+        OutputPrint(L"      Color Depth: %d\n", ColorDepth);
+        OutputPrint(L"      Refresh Rate: %d\n", RefreshRate);
+        OutputPrint(L"\n");
     }
 
     return Status;
@@ -191,11 +193,11 @@ CheckUGA( BOOLEAN Verbose )
                                   (VOID **) &Uga );
     if (EFI_ERROR (Status)) {
         if (Verbose) {
-            Print(L"No UGA handle found via HandleProtocol\n");
+            OutputPrint(L"No UGA handle found via HandleProtocol\n");
         }
     } else {
         if (Verbose) {
-            Print(L"UGA handle found via HandleProtocol\n");
+            OutputPrint(L"UGA handle found via HandleProtocol\n");
         }
         PrintUGA(Uga);
         UGAsupport = TRUE;
@@ -210,11 +212,11 @@ CheckUGA( BOOLEAN Verbose )
                                   (VOID **) &Uga );
     if (EFI_ERROR(Status) || Uga == NULL) {
         if (Verbose) {
-            Print(L"No UGA handle found via LocateProtocol\n");
+            OutputPrint(L"No UGA handle found via LocateProtocol\n");
         }
     } else {
         if (Verbose) {
-            Print(L"Found UGA handle via LocateProtocol\n");
+            OutputPrint(L"Found UGA handle via LocateProtocol\n");
         }
         PrintUGA(Uga);
         UGAsupport = TRUE;
@@ -231,11 +233,11 @@ CheckUGA( BOOLEAN Verbose )
                                       &HandleBuffer );
     if (EFI_ERROR (Status)) {
         if (Verbose) {
-            Print(L"No UGA handles found via LocateHandleBuffer\n");
+            OutputPrint(L"No UGA handles found via LocateHandleBuffer\n");
         }
     } else {
         if (Verbose) {
-            Print(L"Found %d UGA handle(s) via LocateHandleBuffer\n", HandleCount);
+            OutputPrint(L"Found %d UGA handle(s) via LocateHandleBuffer\n", HandleCount);
         }
         for (int i = 0; i < HandleCount; i++) {
             Status = gBS->HandleProtocol( HandleBuffer[i],
@@ -252,7 +254,7 @@ CheckUGA( BOOLEAN Verbose )
         FreePool(HandleBuffer);
     }
     if (UGAsupport == FALSE) {
-        Print(L"  UGA: No support found for this protocol\n");
+        OutputPrint(L"  UGA: No support found for this protocol\n");
     }
 
     return Status;
@@ -267,7 +269,7 @@ PrintGOP( EFI_GRAPHICS_OUTPUT_PROTOCOL *Gop )
 
     imax = Gop->Mode->MaxMode;
 
-    Print(L"  GOP: %d supported graphic modes\n", imax);
+    OutputPrint(L"  GOP: %d supported graphic modes\n", imax);
 
     for (i = 0; i < imax; i++) {
          EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *Info;
@@ -278,6 +280,7 @@ PrintGOP( EFI_GRAPHICS_OUTPUT_PROTOCOL *Gop )
                                   &SizeOfInfo,
                                   &Info );
          if (EFI_ERROR(Status) && Status == EFI_NOT_STARTED) {
+             OutputFlush();
              Gop->SetMode( Gop, 
                            Gop->Mode->Mode );
              Status = Gop->QueryMode( Gop,
@@ -287,34 +290,34 @@ PrintGOP( EFI_GRAPHICS_OUTPUT_PROTOCOL *Gop )
          }
 
          if (EFI_ERROR(Status)) {
-             Print(L"ERROR: Bad response from QueryMode: %d\n", Status);
+             OutputPrint(L"ERROR: Bad response from QueryMode: %d\n", Status);
              continue;
          }
-         Print(L"       %c%d: %dx%d ", memcmp(Info,Gop->Mode->Info,sizeof(*Info)) == 0 ? '*' : ' ', i,
+         OutputPrint(L"       %c%d: %dx%d ", memcmp(Info,Gop->Mode->Info,sizeof(*Info)) == 0 ? '*' : ' ', i,
                                        Info->HorizontalResolution,
                                        Info->VerticalResolution);
          switch(Info->PixelFormat) {
              case PixelRedGreenBlueReserved8BitPerColor:
-                  Print(L"RGBRerserved");
+                  OutputPrint(L"RGBRerserved");
                   break;
              case PixelBlueGreenRedReserved8BitPerColor:
-                  Print(L"BGRReserved");
+                  OutputPrint(L"BGRReserved");
                   break;
              case PixelBitMask:
-                  Print(L"Red:%08x Green:%08x Blue:%08x Reserved:%08x",
+                  OutputPrint(L"Red:%08x Green:%08x Blue:%08x Reserved:%08x",
                           Info->PixelInformation.RedMask,
                           Info->PixelInformation.GreenMask,
                           Info->PixelInformation.BlueMask,
                           Info->PixelInformation.ReservedMask);
                           break;
              case PixelBltOnly:
-                  Print(L"(blt only)");
+                  OutputPrint(L"(blt only)");
                   break;
              default:
-                  Print(L"(Invalid pixel format)");
+                  OutputPrint(L"(Invalid pixel format)");
                   break;
         }
-        Print(L" Pixels %d\n", Info->PixelsPerScanLine);
+        OutputPrint(L" Pixels %d\n", Info->PixelsPerScanLine);
     }
 
     return EFI_SUCCESS;
@@ -334,11 +337,11 @@ CheckGOP( BOOLEAN Verbose )
                                   (VOID **) &Gop );
     if (EFI_ERROR (Status)) {
         if (Verbose) {
-            Print(L"No GOP handle found via HandleProtocol\n");
+            OutputPrint(L"No GOP handle found via HandleProtocol\n");
         }
     } else {
         if (Verbose) {
-            Print(L"GOP handle found via HandleProtocol\n");
+            OutputPrint(L"GOP handle found via HandleProtocol\n");
         }
         PrintGOP(Gop);
         if (Verbose == FALSE) {
@@ -352,11 +355,11 @@ CheckGOP( BOOLEAN Verbose )
                                   (VOID **) &Gop );
     if (EFI_ERROR(Status) || Gop == NULL) {
         if (Verbose) {
-            Print(L"No GOP handle found via LocateProtocol\n");
+            OutputPrint(L"No GOP handle found via LocateProtocol\n");
         }
     } else {
         if (Verbose) {
-            Print(L"Found GOP handle via LocateProtocol\n");
+            OutputPrint(L"Found GOP handle via LocateProtocol\n");
         }
         PrintGOP(Gop);
         if (Verbose == FALSE) {
@@ -372,11 +375,11 @@ CheckGOP( BOOLEAN Verbose )
                                       &HandleBuffer );
     if (EFI_ERROR (Status)) {
         if (Verbose) {
-            Print(L"No GOP handles found via LocateHandleBuffer\n");
+            OutputPrint(L"No GOP handles found via LocateHandleBuffer\n");
         }
     } else {
         if (Verbose) {
-            Print(L"Found %d GOP handle(s) via LocateHandleBuffer\n", HandleCount);
+            OutputPrint(L"Found %d GOP handle(s) via LocateHandleBuffer\n", HandleCount);
         }
         for (int i = 0; i < HandleCount; i++) {
             Status = gBS->HandleProtocol( HandleBuffer[i],
@@ -396,15 +399,120 @@ CheckGOP( BOOLEAN Verbose )
 }
 
 
+//
+// Same three protocols as a JSON record, one handle of each
+//
+EFI_STATUS
+JsonGraphicModes( VOID )
+{
+    EFI_CONSOLE_CONTROL_PROTOCOL    *ConsoleControl = NULL;
+    EFI_CONSOLE_CONTROL_SCREEN_MODE ScreenMode;
+    EFI_GRAPHICS_OUTPUT_PROTOCOL    *Gop = NULL;
+    EFI_UGA_DRAW_PROTOCOL           *Uga = NULL;
+    EFI_GUID                        gEfiConsoleControlProtocolGuid = EFI_CONSOLE_CONTROL_PROTOCOL_GUID;
+    EFI_STATUS                      Status = EFI_SUCCESS;
+    BOOLEAN                         GopUgaExists;
+    BOOLEAN                         StdInLocked;
+    UINT32                          HorzResolution, VertResolution, ColorDepth, RefreshRate;
+
+    Status = gBS->HandleProtocol( gST->ConsoleOutHandle,
+                                  &gEfiConsoleControlProtocolGuid,
+                                  (VOID **) &ConsoleControl );
+    if (EFI_ERROR (Status)) {
+        gBS->LocateProtocol( &gEfiConsoleControlProtocolGuid, NULL, (VOID **) &ConsoleControl );
+    }
+    if (ConsoleControl != NULL &&
+        !EFI_ERROR (ConsoleControl->GetMode( ConsoleControl, &ScreenMode, &GopUgaExists, &StdInLocked ))) {
+        JsonObjectBegin(L"consoleControl");
+        JsonString(L"screenMode", ScreenMode == EfiConsoleControlScreenText ? L"Text" :
+                                  ScreenMode == EfiConsoleControlScreenGraphics ? L"Graphics" : L"MaxValue");
+        JsonBool(L"graphicsSupport", GopUgaExists);
+        JsonObjectEnd();
+    } else {
+        JsonNull(L"consoleControl");
+    }
+
+    Status = gBS->HandleProtocol( gST->ConsoleOutHandle,
+                                  &gEfiUgaDrawProtocolGuid,
+                                  (VOID **) &Uga );
+    if (EFI_ERROR (Status)) {
+        gBS->LocateProtocol( &gEfiUgaDrawProtocolGuid, NULL, (VOID **) &Uga );
+    }
+    if (Uga != NULL &&
+        !EFI_ERROR (Uga->GetMode( Uga, &HorzResolution, &VertResolution, &ColorDepth, &RefreshRate ))) {
+        JsonObjectBegin(L"uga");
+        JsonUint(L"horizontalResolution", HorzResolution);
+        JsonUint(L"verticalResolution", VertResolution);
+        JsonUint(L"colorDepth", ColorDepth);
+        JsonUint(L"refreshRate", RefreshRate);
+        JsonObjectEnd();
+    } else {
+        JsonNull(L"uga");
+    }
+
+    Status = gBS->HandleProtocol( gST->ConsoleOutHandle,
+                                  &gEfiGraphicsOutputProtocolGuid,
+                                  (VOID **) &Gop );
+    if (EFI_ERROR (Status)) {
+        gBS->LocateProtocol( &gEfiGraphicsOutputProtocolGuid, NULL, (VOID **) &Gop );
+    }
+    if (Gop == NULL) {
+        JsonNull(L"gop");
+        return EFI_NOT_FOUND;
+    }
+
+    JsonObjectBegin(L"gop");
+    JsonUint(L"maxMode", Gop->Mode->MaxMode);
+    JsonUint(L"currentMode", Gop->Mode->Mode);
+    JsonHex(L"frameBufferBase", Gop->Mode->FrameBufferBase);
+    JsonUint(L"frameBufferSize", Gop->Mode->FrameBufferSize);
+    JsonArrayBegin(L"modes");
+    for (UINT32 i = 0; i < Gop->Mode->MaxMode; i++) {
+        EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *Info;
+        UINTN SizeOfInfo;
+
+        Status = Gop->QueryMode( Gop, i, &SizeOfInfo, &Info );
+        if (EFI_ERROR(Status) && Status == EFI_NOT_STARTED) {
+            OutputFlush();
+            Gop->SetMode( Gop, Gop->Mode->Mode );
+            Status = Gop->QueryMode( Gop, i, &SizeOfInfo, &Info );
+        }
+        if (EFI_ERROR(Status)) {
+            continue;
+        }
+
+        JsonObjectBegin(NULL);
+        JsonUint(L"mode", i);
+        JsonUint(L"horizontalResolution", Info->HorizontalResolution);
+        JsonUint(L"verticalResolution", Info->VerticalResolution);
+        JsonUint(L"pixelFormat", Info->PixelFormat);
+        if (Info->PixelFormat == PixelBitMask) {
+            JsonHex(L"redMask", Info->PixelInformation.RedMask);
+            JsonHex(L"greenMask", Info->PixelInformation.GreenMask);
+            JsonHex(L"blueMask", Info->PixelInformation.BlueMask);
+            JsonHex(L"reservedMask", Info->PixelInformation.ReservedMask);
+        }
+        JsonUint(L"pixelsPerScanLine", Info->PixelsPerScanLine);
+        JsonBool(L"current", memcmp(Info, Gop->Mode->Info, sizeof(*Info)) == 0);
+        JsonObjectEnd();
+    }
+    JsonArrayEnd();
+    JsonObjectEnd();
+
+    return EFI_SUCCESS;
+}
+
+
 VOID
 Usage( BOOLEAN ErrorMsg )
 {
     if ( ErrorMsg ) {
-        Print(L"ERROR: Unknown option(s).\n");
+        OutputPrint(L"ERROR: Unknown option(s).\n");
     }
 
-    Print(L"Usage: GraphicModes [ -v | --verbose ]\n");
-    Print(L"       GraphicModes [ -V | --version ]\n");
+    OutputPrint(L"Usage: GraphicModes [ -v | --verbose ]\n");
+    OutputPrint(L"       GraphicModes [ --json ]\n");
+    OutputPrint(L"       GraphicModes [ -V | --version ]\n");
 }
 
 
@@ -415,6 +523,10 @@ ShellAppMain( UINTN Argc,
 {
     EFI_STATUS Status = EFI_SUCCESS;
     BOOLEAN    Verbose = FALSE;
+    BOOLEAN    Json = FALSE;
+
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
 
     if (Argc == 2) {
         if (!StrCmp(Argv[1], L"--verbose") ||
@@ -422,7 +534,7 @@ ShellAppMain( UINTN Argc,
             Verbose = TRUE;
         } else if (!StrCmp(Argv[1], L"--version") ||
             !StrCmp(Argv[1], L"-V")) {
-            Print(L"Version: %s\n", UTILITY_VERSION);
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
             return Status;
         } else if (!StrCmp(Argv[1], L"--help") ||
             !StrCmp(Argv[1], L"-h")) {
@@ -438,13 +550,20 @@ ShellAppMain( UINTN Argc,
         return Status;
     }
 
-    Print(L"\n");
+    if (Json) {
+        JsonDocumentBegin(L"GraphicModes", UTILITY_VERSION);
+        JsonGraphicModes();
+        JsonDocumentEnd();
+        return Status;
+    }
+
+    OutputPrint(L"\n");
     CheckCCP(Verbose);       // First check for older EDK ConsoleControl protocol support
-    Print(L"\n");
+    OutputPrint(L"\n");
     CheckUGA(Verbose);       // Next check for UGA support (probably none)
-    Print(L"\n");
+    OutputPrint(L"\n");
     CheckGOP(Verbose);       // Finally check for GOP support 
-    Print(L"\n");
+    OutputPrint(L"\n");
 
     return Status;
 }
@@ -0,0 +1,209 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Layouts and decoders for the ACPI tables shown by both ListACPI and
+//  the single table utilities (MSDM, SLIC, TPM2, FACS and BGRT), and
+//  the decoder registry used by ListACPI and SysReport
+//
+//  License: BSD License
+//
+
+#ifndef _ACPI_TABLE_DECODE_LIB_H_
+#define _ACPI_TABLE_DECODE_LIB_H_
+
+#include <IndustryStandard/Acpi.h>
+#include <IndustryStandard/Bmp.h>
+
+#pragma pack(1)
+typedef struct {
+    UINT32   Version;
+    UINT32   Reserved;
+    UINT32   DataType;
+    UINT32   DataReserved;
+    UINT32   DataLength;
+    CHAR8    Data[30];
+} SOFTWARE_LICENSING;
+
+// Microsoft Data Management table structure
+typedef struct {
+    EFI_ACPI_SDT_HEADER Header;
+    SOFTWARE_LICENSING  SoftLic;
+} EFI_ACPI_MSDM;
+
+// OEM Public Key
+typedef struct {
+    UINT32    Type;
+    UINT32    Length;
+    UINT8     KeyType;
+    UINT8     Version;
+    UINT16    Reserved;
+    UINT32    Algorithm;
+    CHAR8     Magic[4];
+    UINT32    BitLength;
+    UINT32    Exponent;
+    UINT8     Modulus[128];
+} OEM_PUBLIC_KEY;
+
+// Windows Marker
+typedef struct {
+    UINT32    Type;
+    UINT32    Length;
+    UINT32    Version;
+    CHAR8     OemId[6];
+    CHAR8     OemTableId[8];
+    CHAR8     Product[8];
+    UINT16    MinorVersion;
+    UINT16    MajorVersion;
+    UINT8     Signature[144];
+} WINDOWS_MARKER;
+
+// Software Licensing
+typedef struct {
+    EFI_ACPI_SDT_HEADER Header;
+    OEM_PUBLIC_KEY      PubKey;
+    WINDOWS_MARKER      Marker;
+} EFI_ACPI_SLIC;
+
+typedef struct {
+    EFI_ACPI_SDT_HEADER  Header;
+    UINT16               PlatformClass;
+    UINT16               Reserved;
+    UINT64               AddressOfControlArea;
+    UINT32               StartMethod;
+    // UINT8             PlatformSpecificParameters[];
+} MY_EFI_TPM2_ACPI_TABLE;
+
+// Boot Graphics Resource Table definition
+typedef struct {
+    EFI_ACPI_SDT_HEADER Header;
+    UINT16 Version;
+    UINT8  Status;
+    UINT8  ImageType;
+    UINT64 ImageAddress;
+    UINT32 ImageOffsetX;
+    UINT32 ImageOffsetY;
+} EFI_ACPI_BGRT;
+#pragma pack()
+
+
+//
+// The decoders below print the body of one table (or, with Json, write
+// its members into the object the caller has open).  Each checks the
+// table length before reading any field; a table too short for its
+// layout is reported as an error and EFI_BAD_BUFFER_SIZE returned.
+// Verbose adds the reserved fields and the raw key, signature and
+// image header details.
+//
+
+//
+// The standard header, as an "ACPI Standard Header" block or as
+// signature ... creatorRevision members
+//
+VOID
+EFIAPI
+AcpiDecodeSdtHeader( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                     BOOLEAN                     Json );
+
+//
+// The MSDM product key and its length (at most the 30 bytes of the
+// Data field), or NULL if the table is too short to hold it
+//
+CHAR8 *
+EFIAPI
+AcpiMsdmKey( EFI_ACPI_DESCRIPTION_HEADER *Table,
+             UINTN                       *Length );
+
+EFI_STATUS
+EFIAPI
+AcpiDecodeMsdm( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                BOOLEAN                     Verbose,
+                BOOLEAN                     Json );
+
+EFI_STATUS
+EFIAPI
+AcpiDecodeSlic( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                BOOLEAN                     Verbose,
+                BOOLEAN                     Json );
+
+//
+// The control area is only followed for the command response buffer
+// start methods
+//
+EFI_STATUS
+EFIAPI
+AcpiDecodeTpm2( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                BOOLEAN                     Json );
+
+//
+// The FACS has only the signature and length of the standard header
+//
+EFI_STATUS
+EFIAPI
+AcpiDecodeFacs( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                BOOLEAN                     Verbose,
+                BOOLEAN                     Json );
+
+EFI_STATUS
+EFIAPI
+AcpiDecodeBgrt( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                BOOLEAN                     Verbose,
+                BOOLEAN                     Json );
+
+//
+// The boot logo if the BGRT says it is a BMP image and it starts with
+// the "BM" signature, else NULL
+//
+BMP_IMAGE_HEADER *
+EFIAPI
+AcpiBgrtImage( EFI_ACPI_BGRT *Bgrt );
+
+
+//
+// A registry decoder prints the body of one table; the caller has
+// already printed (or, with Json, written) the signature, address and
+// length.  With Json the decoder writes members into the "decoded"
+// object the caller opened for it.
+//
+typedef VOID (*ACPI_DECODER)( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                              BOOLEAN Json );
+
+typedef struct {
+    UINT32        Signature;            // SIGNATURE_32() value
+    CHAR16        *Name;
+    ACPI_DECODER  Decode;
+} ACPI_DECODER_ENTRY;
+
+//
+// The registry entry for a table signature, or NULL if no decoder
+// handles it
+//
+CONST ACPI_DECODER_ENTRY *
+EFIAPI
+AcpiDecoderFind( UINT32 Signature );
+
+//
+// One line (or the signature ... oemTableId members) identifying a table
+//
+VOID
+EFIAPI
+AcpiDecodeTableHeader( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                       BOOLEAN                     Json );
+
+//
+// Decode every table in AcpiTableIndexLib's index in one pass, then
+// print (or write as "decoders") the time spent in each decoder
+//
+EFI_STATUS
+EFIAPI
+AcpiDecodeAllTables( BOOLEAN Json );
+
+//
+// Decode every table with one signature.  EFI_UNSUPPORTED if no decoder
+// handles the signature, EFI_NOT_FOUND if there is no such table.
+//
+EFI_STATUS
+EFIAPI
+AcpiDecodeTables( UINT32  Signature,
+                  BOOLEAN Json );
+
+#endif
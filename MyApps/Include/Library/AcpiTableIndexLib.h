@@ -0,0 +1,100 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Indexed lookup of the firmware ACPI tables for the MyApps utilities
+//
+//  License: BSD License
+//
+
+#ifndef _ACPI_TABLE_INDEX_LIB_H_
+#define _ACPI_TABLE_INDEX_LIB_H_
+
+#include <IndustryStandard/Acpi.h>
+
+#define ACPI_INDEX_MAX_TABLES   256       // tables held in the index
+#define ACPI_INDEX_HASH_SIZE    512       // signature hash slots, power of 2
+
+// per table flags
+#define ACPI_INDEX_CHECKSUM_OK  0x01      // byte sum of the table is zero
+#define ACPI_INDEX_NO_CHECKSUM  0x02      // table has no checksum (FACS)
+#define ACPI_INDEX_FROM_FADT    0x04      // reached through the FADT, not the XSDT/RSDT
+
+typedef struct {
+    EFI_ACPI_DESCRIPTION_HEADER *Table;
+    UINT32                      Signature;
+    UINT32                      Length;
+    UINT8                       Flags;
+    UINT16                      Next;         // next table with the same signature, or ACPI_INDEX_END
+} ACPI_INDEX_ENTRY;
+
+#define ACPI_INDEX_END          0xffff
+
+
+//
+// Build the index: locate the RSDP, walk the XSDT (or the RSDT when
+// there is no XSDT), follow the FADT to the FACS and DSDT and checksum
+// every table once.  Later calls return the cached result.  Returns
+// EFI_NOT_FOUND if there is no RSDP or root table.
+//
+EFI_STATUS
+EFIAPI
+AcpiIndexInit( VOID );
+
+EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *
+EFIAPI
+AcpiIndexRsdp( VOID );
+
+//
+// The ACPI configuration table GUID the RSDP was found under
+//
+EFI_GUID *
+EFIAPI
+AcpiIndexRsdpGuid( VOID );
+
+//
+// The XSDT, or the RSDT on systems without one.  IsXsdt, if not NULL,
+// says which.
+//
+EFI_ACPI_DESCRIPTION_HEADER *
+EFIAPI
+AcpiIndexRoot( BOOLEAN *IsXsdt );
+
+//
+// Tables in root table order, FADT-referenced tables last
+//
+UINTN
+EFIAPI
+AcpiIndexCount( VOID );
+
+CONST ACPI_INDEX_ENTRY *
+EFIAPI
+AcpiIndexEntry( UINTN Index );
+
+//
+// Instance'th table (0 based) with the given signature, or NULL.
+// Signature is a SIGNATURE_32() value.
+//
+EFI_ACPI_DESCRIPTION_HEADER *
+EFIAPI
+AcpiIndexFind( UINT32 Signature,
+               UINTN  Instance );
+
+//
+// As AcpiIndexFind() but returns the index entry
+//
+CONST ACPI_INDEX_ENTRY *
+EFIAPI
+AcpiIndexFindEntry( UINT32 Signature,
+                    UINTN  Instance );
+
+//
+// Byte sum (mod 256) of Length bytes at Buffer; zero for a table with a
+// valid checksum.  Same result as CalculateSum8() but sums a 64 bit word
+// at a time.
+//
+UINT8
+EFIAPI
+AcpiIndexChecksum( CONST VOID *Buffer,
+                   UINTN      Length );
+
+#endif
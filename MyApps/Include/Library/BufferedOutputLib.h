@@ -0,0 +1,126 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Buffered console output for the MyApps utilities
+//
+//  License: BSD License
+//
+
+#ifndef _BUFFERED_OUTPUT_LIB_H_
+#define _BUFFERED_OUTPUT_LIB_H_
+
+#define OUTPUT_BUFFER_SIZE    0x8000      // characters held before a forced flush
+#define OUTPUT_LINE_MAX       0x1000      // flush once less than this much space is left
+#define OUTPUT_FLUSH_LINES    64          // newlines per batch flush
+#define OUTPUT_FILE_BUFFER_SIZE 0x10000   // bytes held by an OUTPUT_FILE before a write
+
+//
+// A buffered export file.  Opened by OutputFileOpen(), written in
+// OUTPUT_FILE_BUFFER_SIZE pieces, and closed by OutputFileClose().
+//
+typedef struct {
+    VOID       *Handle;                   // SHELL_FILE_HANDLE
+    UINT8      *Buffer;
+    UINTN      Used;
+    UINT64     BytesWritten;
+    EFI_STATUS Status;                    // first write error, if any
+} OUTPUT_FILE;
+
+
+//
+// Strip the common output options (--stats, --tee <file>) from Argv
+// and act on them.  Call first thing in ShellAppMain.
+//
+EFI_STATUS
+EFIAPI
+OutputInit( UINTN  *Argc,
+            CHAR16 **Argv );
+
+//
+// Format and queue output, same format rules as Print().  Output too
+// long for the buffer is written out directly.
+//
+UINTN
+EFIAPI
+OutputPrint( CONST CHAR16 *Format,
+             ... );
+
+//
+// Queue an already formatted, NUL terminated string
+//
+VOID
+EFIAPI
+OutputString( CONST CHAR16 *String );
+
+//
+// Write everything queued to ConOut (and the tee file, if any)
+//
+VOID
+EFIAPI
+OutputFlush( VOID );
+
+//
+// Copy all further output to FileName, created or truncated
+//
+EFI_STATUS
+EFIAPI
+OutputTeeFile( CONST CHAR16 *FileName );
+
+//
+// Stop copying output to the tee file and close it
+//
+VOID
+EFIAPI
+OutputTeeClose( VOID );
+
+//
+// Enable or suppress console output.  With the console off and a tee
+// file open, output goes to the file only.
+//
+VOID
+EFIAPI
+OutputConsole( BOOLEAN Enable );
+
+//
+// Create FileName, or truncate it if it exists, for buffered writing
+//
+EFI_STATUS
+EFIAPI
+OutputFileOpen( OUTPUT_FILE  *File,
+                CONST CHAR16 *FileName );
+
+//
+// Queue Size bytes.  Writes of a buffer or more bypass the buffer.
+//
+EFI_STATUS
+EFIAPI
+OutputFileWrite( OUTPUT_FILE *File,
+                 CONST VOID  *Data,
+                 UINTN       Size );
+
+//
+// Format and queue ASCII text, same format rules as AsciiSPrint()
+//
+EFI_STATUS
+EFIAPI
+OutputFilePrint( OUTPUT_FILE *File,
+                 CONST CHAR8 *Format,
+                 ... );
+
+EFI_STATUS
+EFIAPI
+OutputFileFlush( OUTPUT_FILE *File );
+
+//
+// Flush, close and free the buffer.  Returns the first write error.
+//
+EFI_STATUS
+EFIAPI
+OutputFileClose( OUTPUT_FILE *File );
+
+VOID
+EFIAPI
+OutputGetStats( UINT64 *BytesWritten,
+                UINTN  *FlushCount );
+
+#endif
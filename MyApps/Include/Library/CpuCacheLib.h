@@ -0,0 +1,52 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Deterministic cache parameters from CPUID for the MyApps utilities
+//
+//  License: BSD License
+//
+
+#ifndef _CPU_CACHE_LIB_H_
+#define _CPU_CACHE_LIB_H_
+
+#define CPU_CACHE_DATA          1
+#define CPU_CACHE_INSTRUCTION   2
+#define CPU_CACHE_UNIFIED       3
+
+#define CPU_CACHE_MAX           16      // more cache levels than any processor has
+
+typedef struct {
+    UINT8    Level;                     // 1 = L1 ...
+    UINT8    Type;                      // CPU_CACHE_xxx
+    UINT32   Size;                      // bytes
+    UINT32   Ways;
+    UINT32   LineSize;                  // bytes
+    UINT32   Sets;
+    UINT32   SharedBy;                  // logical processors sharing the cache
+    BOOLEAN  FullyAssociative;
+    BOOLEAN  Inclusive;
+} CPU_CACHE_INFO;
+
+//
+// Fill Caches with up to Max caches of the executing processor, using
+// CPUID leaf 4 on Intel and leaf 0x8000001D on AMD processors with
+// topology extensions.  Returns the number of caches found, 0 if the
+// processor does not report deterministic cache parameters.
+//
+UINTN
+EFIAPI
+CpuCacheEnumerate( CPU_CACHE_INFO *Caches,
+                   UINTN Max );
+
+//
+// The CPUID leaf CpuCacheEnumerate() reads, 0 if none
+//
+UINT32
+EFIAPI
+CpuCacheLeaf( VOID );
+
+CHAR16 *
+EFIAPI
+CpuCacheTypeStr( UINT8 Type );
+
+#endif
@@ -0,0 +1,21 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Processor identification from CPUID for Cpuid and SysReport
+//
+//  License: BSD License
+//
+
+#ifndef _CPU_INFO_LIB_H_
+#define _CPU_INFO_LIB_H_
+
+//
+// Print (or, with Json, write as members of the object the caller has
+// open) the vendor signature, brand string, family/model/stepping,
+// feature flags and cache hierarchy of the processor it runs on
+//
+VOID
+EFIAPI
+CpuInfoReport( BOOLEAN Json );
+
+#endif
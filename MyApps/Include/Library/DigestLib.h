@@ -0,0 +1,127 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Message digests for the MyApps utilities
+//
+//  License: BSD License
+//
+
+#ifndef _DIGEST_LIB_H_
+#define _DIGEST_LIB_H_
+
+#define DIGEST_SHA1_SIZE        20
+#define DIGEST_SHA1_BLOCK       64
+#define DIGEST_SHA256_SIZE      32
+#define DIGEST_SHA256_BLOCK     64
+#define DIGEST_SHA384_SIZE      48
+#define DIGEST_SHA512_SIZE      64
+#define DIGEST_SHA512_BLOCK     128
+
+typedef struct {
+    UINT32 State[5];
+    UINT64 Length;                        // bytes hashed so far
+    UINT8  Block[DIGEST_SHA1_BLOCK];
+    UINTN  Used;                          // bytes waiting in Block
+} DIGEST_SHA1_CONTEXT;
+
+typedef struct {
+    UINT32 State[8];
+    UINT64 Length;                        // bytes hashed so far
+    UINT8  Block[DIGEST_SHA256_BLOCK];
+    UINTN  Used;                          // bytes waiting in Block
+} DIGEST_SHA256_CONTEXT;
+
+// SHA-384 and SHA-512 share a context
+typedef struct {
+    UINT64 State[8];
+    UINT64 Length;                        // bytes hashed so far
+    UINT8  Block[DIGEST_SHA512_BLOCK];
+    UINTN  Used;                          // bytes waiting in Block
+} DIGEST_SHA512_CONTEXT;
+
+
+VOID
+EFIAPI
+DigestSha256Init( DIGEST_SHA256_CONTEXT *Context );
+
+VOID
+EFIAPI
+DigestSha256Update( DIGEST_SHA256_CONTEXT *Context,
+                    CONST VOID            *Data,
+                    UINTN                 Size );
+
+VOID
+EFIAPI
+DigestSha256Final( DIGEST_SHA256_CONTEXT *Context,
+                   UINT8                 *Digest );
+
+//
+// SHA-256 of Size bytes at Data in one call
+//
+VOID
+EFIAPI
+DigestSha256( CONST VOID *Data,
+              UINTN      Size,
+              UINT8      *Digest );
+
+VOID
+EFIAPI
+DigestSha1Init( DIGEST_SHA1_CONTEXT *Context );
+
+VOID
+EFIAPI
+DigestSha1Update( DIGEST_SHA1_CONTEXT *Context,
+                  CONST VOID          *Data,
+                  UINTN               Size );
+
+VOID
+EFIAPI
+DigestSha1Final( DIGEST_SHA1_CONTEXT *Context,
+                 UINT8               *Digest );
+
+VOID
+EFIAPI
+DigestSha1( CONST VOID *Data,
+            UINTN      Size,
+            UINT8      *Digest );
+
+VOID
+EFIAPI
+DigestSha384Init( DIGEST_SHA512_CONTEXT *Context );
+
+VOID
+EFIAPI
+DigestSha512Init( DIGEST_SHA512_CONTEXT *Context );
+
+//
+// Used for both SHA-384 and SHA-512
+//
+VOID
+EFIAPI
+DigestSha512Update( DIGEST_SHA512_CONTEXT *Context,
+                    CONST VOID            *Data,
+                    UINTN                 Size );
+
+VOID
+EFIAPI
+DigestSha384Final( DIGEST_SHA512_CONTEXT *Context,
+                   UINT8                 *Digest );
+
+VOID
+EFIAPI
+DigestSha512Final( DIGEST_SHA512_CONTEXT *Context,
+                   UINT8                 *Digest );
+
+VOID
+EFIAPI
+DigestSha384( CONST VOID *Data,
+              UINTN      Size,
+              UINT8      *Digest );
+
+VOID
+EFIAPI
+DigestSha512( CONST VOID *Data,
+              UINTN      Size,
+              UINT8      *Digest );
+
+#endif
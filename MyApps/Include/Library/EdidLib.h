@@ -0,0 +1,77 @@
+//
+//  Copyright (c) 2015-2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  EDID base block decoding for ShowEDID and SysReport
+//
+//  License: BSD License
+//
+
+#ifndef _EDID_LIB_H_
+#define _EDID_LIB_H_
+
+#define EDID_DATA_BLOCK_SIZE              0x80
+
+#pragma pack(1)
+// From EDK2 VesaBiosExtensions.h
+typedef struct {
+    UINT8  Header[8];                        // EDID header "00 FF FF FF FF FF FF 00"
+    UINT16 ManufactureName;                  // EISA 3-character ID
+    UINT16 ProductCode;                      // Vendor assigned code
+    UINT32 SerialNumber;                     // 32-bit serial number
+    UINT8  WeekOfManufacture;                // Week number
+    UINT8  YearOfManufacture;                // Year
+    UINT8  EdidVersion;                      // EDID Structure Version
+    UINT8  EdidRevision;                     // EDID Structure Revision
+    UINT8  VideoInputDefinition;
+    UINT8  MaxHorizontalImageSize;           // cm
+    UINT8  MaxVerticalImageSize;             // cm
+    UINT8  DisplayGamma;
+    UINT8  DpmSupport;
+    UINT8  RedGreenLowBits;                  // Rx1 Rx0 Ry1 Ry0 Gx1 Gx0 Gy1Gy0
+    UINT8  BlueWhiteLowBits;                 // Bx1 Bx0 By1 By0 Wx1 Wx0 Wy1 Wy0
+    UINT8  RedX;                             // Red-x Bits 9 - 2
+    UINT8  RedY;                             // Red-y Bits 9 - 2
+    UINT8  GreenX;                           // Green-x Bits 9 - 2
+    UINT8  GreenY;                           // Green-y Bits 9 - 2
+    UINT8  BlueX;                            // Blue-x Bits 9 - 2
+    UINT8  BlueY;                            // Blue-y Bits 9 - 2
+    UINT8  WhiteX;                           // White-x Bits 9 - 2
+    UINT8  WhiteY;                           // White-x Bits 9 - 2
+    UINT8  EstablishedTimings[3];
+    UINT8  StandardTimingIdentification[16];
+    UINT8  DescriptionBlock1[18];
+    UINT8  DescriptionBlock2[18];
+    UINT8  DescriptionBlock3[18];
+    UINT8  DescriptionBlock4[18];
+    UINT8  ExtensionFlag;                    // Number of (optional) 128-byte EDID extension blocks
+    UINT8  Checksum;
+} EDID_DATA_BLOCK;
+#pragma pack()
+
+
+//
+// TRUE if Size covers the 128-byte base block and the block has a zero
+// checksum, the fixed header and EDID version 1.0 to 1.4
+//
+BOOLEAN
+EFIAPI
+EdidValid( UINT8  *Edid,
+           UINT32 Size );
+
+//
+// Print the version, vendor, product, input, display type, size, gamma
+// and first detailed timing block of a valid EDID
+//
+VOID
+EFIAPI
+EdidPrint( EDID_DATA_BLOCK *EdidDataBlock );
+
+//
+// The same as members of the object the caller has open, with the raw
+// base block as "raw"
+//
+VOID
+EFIAPI
+EdidJson( EDID_DATA_BLOCK *EdidDataBlock );
+
+#endif
@@ -0,0 +1,32 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  EFI System Resource Table decoding for ShowESRT and SysReport
+//
+//  License: BSD License
+//
+
+#ifndef _ESRT_LIB_H_
+#define _ESRT_LIB_H_
+
+#include <Guid/SystemResourceTable.h>
+
+//
+// Print the firmware resource entries; Verbose adds the table address,
+// counts and version first.  Only version 1 entries are decoded; any
+// other version is reported as an error and EFI_UNSUPPORTED returned.
+//
+EFI_STATUS
+EFIAPI
+EsrtPrint( EFI_SYSTEM_RESOURCE_TABLE *Esrt,
+           BOOLEAN                   Verbose );
+
+//
+// The same as members of the object the caller has open, the entries
+// as an "entries" array
+//
+EFI_STATUS
+EFIAPI
+EsrtJson( EFI_SYSTEM_RESOURCE_TABLE *Esrt );
+
+#endif
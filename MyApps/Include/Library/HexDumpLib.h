@@ -0,0 +1,47 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Shared hex/ASCII dump formatter for the MyApps utilities
+//
+//  License: BSD License
+//
+
+#ifndef _HEXDUMP_LIB_H_
+#define _HEXDUMP_LIB_H_
+
+// row layout flags
+#define HEXDUMP_0X          0x01      // "0x00 0x01 ..." instead of grouped "0001..."
+#define HEXDUMP_OFFSET      0x02      // leading "%08x: " offset column
+#define HEXDUMP_ASCII       0x04      // trailing printable ASCII column
+
+#define HEXDUMP_MAX_ROW     64        // widest supported row in bytes
+#define HEXDUMP_GROUP       16        // bytes per group in grouped layout
+
+
+//
+// Dump Count bytes of Data, BytesPerRow bytes to a line.  The first line
+// is prefixed with Lead, subsequent lines with Indent.  Each line is
+// built in a local buffer and queued with a single OutputString() call.
+// Nothing is printed when Count is 0.
+//
+VOID
+EFIAPI
+HexDump( CONST CHAR16 *Lead,
+         CONST CHAR16 *Indent,
+         CONST VOID   *Data,
+         UINTN        Count,
+         UINTN        BytesPerRow,
+         UINTN        Flags );
+
+//
+// Format Count bytes of Data as contiguous lowercase hex digits into
+// Buffer (BufferSize in bytes).  Returns Buffer.
+//
+CHAR16 *
+EFIAPI
+HexToString( CHAR16       *Buffer,
+             UINTN        BufferSize,
+             CONST VOID   *Data,
+             UINTN        Count );
+
+#endif
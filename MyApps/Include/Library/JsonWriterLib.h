@@ -0,0 +1,135 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Streaming JSON writer for the MyApps utilities
+//
+//  License: BSD License
+//
+
+#ifndef _JSON_WRITER_LIB_H_
+#define _JSON_WRITER_LIB_H_
+
+#define JSON_MAX_DEPTH      16        // deepest nesting; anything deeper is left out
+                                      // and the record gets "truncated": true
+#define JSON_VALUE_MAX      256       // largest JsonPrint() formatted value
+
+
+//
+// Strip --json from Argv.  Returns TRUE if it was present.  Call
+// straight after OutputInit() in ShellAppMain.
+//
+BOOLEAN
+EFIAPI
+JsonInit( UINTN  *Argc,
+          CHAR16 **Argv );
+
+//
+// Open/close the top-level record.  Every record carries the name and
+// version of the utility that produced it.
+//
+VOID
+EFIAPI
+JsonDocumentBegin( CONST CHAR16 *Utility,
+                   CONST CHAR16 *Version );
+
+VOID
+EFIAPI
+JsonDocumentEnd( VOID );
+
+//
+// Report an error.  Inside a record this closes any open containers
+// and adds an "error" member to the record; otherwise it prints the
+// usual "ERROR: ..." line.
+//
+VOID
+EFIAPI
+JsonError( CONST CHAR16 *Format,
+           ... );
+
+//
+// In the functions below Name is the member name when the enclosing
+// container is an object and is ignored inside an array.
+//
+VOID
+EFIAPI
+JsonObjectBegin( CONST CHAR16 *Name );
+
+VOID
+EFIAPI
+JsonObjectEnd( VOID );
+
+VOID
+EFIAPI
+JsonArrayBegin( CONST CHAR16 *Name );
+
+VOID
+EFIAPI
+JsonArrayEnd( VOID );
+
+VOID
+EFIAPI
+JsonString( CONST CHAR16 *Name,
+            CONST CHAR16 *Value );
+
+//
+// ASCII string of at most Length characters (ACPI signatures, OEM IDs
+// and the like are not NUL terminated).  Trailing spaces are dropped.
+//
+VOID
+EFIAPI
+JsonAsciiString( CONST CHAR16 *Name,
+                 CONST CHAR8  *Value,
+                 UINTN        Length );
+
+//
+// String value formatted with the usual Print() rules
+//
+VOID
+EFIAPI
+JsonPrint( CONST CHAR16 *Name,
+           CONST CHAR16 *Format,
+           ... );
+
+VOID
+EFIAPI
+JsonUint( CONST CHAR16 *Name,
+          UINT64       Value );
+
+VOID
+EFIAPI
+JsonInt( CONST CHAR16 *Name,
+         INT64        Value );
+
+//
+// Hexadecimal as a "0x..." string so 64-bit addresses survive parsers
+// that hold numbers in doubles
+//
+VOID
+EFIAPI
+JsonHex( CONST CHAR16 *Name,
+         UINT64       Value );
+
+VOID
+EFIAPI
+JsonBool( CONST CHAR16 *Name,
+          BOOLEAN      Value );
+
+VOID
+EFIAPI
+JsonNull( CONST CHAR16 *Name );
+
+VOID
+EFIAPI
+JsonGuid( CONST CHAR16   *Name,
+          CONST EFI_GUID *Guid );
+
+//
+// Count bytes of Data as one contiguous lowercase hex string
+//
+VOID
+EFIAPI
+JsonBytes( CONST CHAR16 *Name,
+           CONST VOID   *Data,
+           UINTN        Count );
+
+#endif
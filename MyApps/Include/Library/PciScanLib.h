@@ -0,0 +1,76 @@
+//
+//  Copyright (c) 2017-2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  PCI bus scan and pci.ids lookup for ShowPCI, ShowPCIx and SysReport
+//
+//  License: BSD License
+//
+
+#ifndef _PCI_SCAN_LIB_H_
+#define _PCI_SCAN_LIB_H_
+
+#include <IndustryStandard/Pci.h>
+
+#define PCIDATABASE L"pci.ids"
+
+typedef struct {
+    UINT32      Segment;
+    UINT16      Bus;
+    UINT16      Device;
+    UINT16      Function;
+    PCI_TYPE00  Header;            // only Hdr is common to all header types
+} PCI_SCAN_ENTRY;
+
+typedef
+VOID
+(EFIAPI *PCI_SCAN_CALLBACK)(
+    PCI_SCAN_ENTRY *Entry,
+    VOID           *Context
+);
+
+//
+// Walk every bus range of every root bridge handle and call Callback
+// for each function present.  Only the vendor ID is read for an empty
+// slot, and the other functions are skipped unless function 0 is a
+// multi-function device.  Returns the number of functions found.
+//
+UINTN
+EFIAPI
+PciScan( EFI_HANDLE        *Handles,
+         UINTN             HandleCount,
+         PCI_SCAN_CALLBACK Callback,
+         VOID              *Context );
+
+//
+// One function as an object in the array the caller has open; the
+// subsystem IDs are only written for a type 0 (device) header, and
+// the vendor and device names only while pci.ids is open
+//
+VOID
+EFIAPI
+PciScanJson( PCI_SCAN_ENTRY *Entry );
+
+//
+// Find pci.ids on the shell path and open it for PciIdsLookup
+//
+EFI_STATUS
+EFIAPI
+PciIdsOpen( VOID );
+
+VOID
+EFIAPI
+PciIdsClose( VOID );
+
+//
+// Look up the vendor and device names.  Returns FALSE if the vendor is
+// not listed; *DeviceName is NULL if only the vendor is.  The strings
+// are overwritten by the next lookup.
+//
+BOOLEAN
+EFIAPI
+PciIdsLookup( UINT16 VendorId,
+              UINT16 DeviceId,
+              CHAR16 **VendorName,
+              CHAR16 **DeviceName );
+
+#endif
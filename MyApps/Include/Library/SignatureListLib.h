@@ -0,0 +1,57 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Secure Boot signature database (PK, KEK, db, dbx) reading and X509
+//  certificate decoding for ListCerts and SysReport
+//
+//  License: BSD License
+//
+
+#ifndef _SIGNATURE_LIST_LIB_H_
+#define _SIGNATURE_LIST_LIB_H_
+
+#include <Guid/ImageAuthentication.h>
+
+//
+// "X509", "SHA256", "RSA2048", "PKCS7" or "Unknown"
+//
+CHAR16 *
+EFIAPI
+SignatureTypeName( EFI_GUID *Type );
+
+//
+// Read a signature database variable into a pool buffer the caller
+// frees.  Returns the GetVariable status (EFI_NOT_FOUND if the
+// variable does not exist) and leaves *Data NULL on failure.
+//
+EFI_STATUS
+EFIAPI
+SignatureListGet( CHAR16   *Name,
+                  EFI_GUID *Owner,
+                  UINT8    **Data,
+                  UINTN    *Size );
+
+//
+// Decode every certificate in the signature lists: version, serial
+// number, issuer, validity, subject, key algorithm and extensions.
+// With Json each certificate is written as an object into the array
+// the caller has open.  Lists are walked only while their sizes fit in
+// Size.  Returns EFI_COMPROMISED_DATA if a certificate failed to
+// decode (the reason is reported with it).
+//
+EFI_STATUS
+EFIAPI
+SignatureListCertificates( UINT8   *Data,
+                           UINTN   Size,
+                           BOOLEAN Json );
+
+//
+// One object per signature list (type, signatureSize, count and the
+// first owner) written into the array the caller has open
+//
+VOID
+EFIAPI
+SignatureListJson( UINT8 *Data,
+                   UINTN Size );
+
+#endif
@@ -0,0 +1,266 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  TPM 1.2 and 2.0 command transport and marshalling for the MyApps
+//  utilities
+//
+//  License: BSD License
+//
+
+#ifndef _TPM_COMMAND_LIB_H_
+#define _TPM_COMMAND_LIB_H_
+
+#include <IndustryStandard/Tpm20.h>
+#include <Protocol/TcgService.h>
+#include <Protocol/Tcg2Protocol.h>
+#include <Protocol/TrEEProtocol.h>
+
+#define TPM_HEADER_SIZE     10            // tag, size and code/ordinal; same for 1.2 and 2.0
+
+typedef enum {
+    TpmTransportNone = 0,
+    TpmTransportTpm12,                    // EFI_TCG_PROTOCOL
+    TpmTransportTpm20                     // EFI_TCG2_PROTOCOL, or EFI_TREE_PROTOCOL on older firmware
+} TPM_TRANSPORT;
+
+//
+// Command being built in place in the caller's buffer.  A write that
+// does not fit sets Overflow and is dropped; TpmSubmit then refuses
+// the command, so callers need not check each write.
+//
+typedef struct {
+    UINT8   *Buffer;
+    UINT32  Size;                         // capacity of Buffer
+    UINT32  Length;                       // bytes written so far
+    BOOLEAN Overflow;
+} TPM_COMMAND;
+
+//
+// Response being read in place.  Length is the smaller of the bytes
+// the TPM said it returned and the size of the buffer.  A read past
+// Length sets Error, returns zeros and leaves Offset where it was.
+//
+typedef struct {
+    UINT8   *Buffer;
+    UINT32  Length;
+    UINT32  Offset;                       // next byte to read
+    UINT32  ResponseCode;                 // from the header
+    BOOLEAN Error;
+} TPM_RESPONSE;
+
+
+//
+// Locate the TPM on the first call (TCG2, then TrEE, then TCG) and
+// return the cached answer after that.  Returns EFI_NOT_FOUND if no
+// TPM protocol is installed.
+//
+EFI_STATUS
+EFIAPI
+TpmOpen( TPM_TRANSPORT *Transport );
+
+TPM_TRANSPORT
+EFIAPI
+TpmTransport( VOID );
+
+//
+// The protocol behind the transport, for the non-command services
+// (GetCapability, GetEventLog, ...).  NULL if not the one in use.
+//
+EFI_TCG2_PROTOCOL *
+EFIAPI
+TpmTcg2( VOID );
+
+EFI_TREE_PROTOCOL *
+EFIAPI
+TpmTrEE( VOID );
+
+EFI_TCG_PROTOCOL *
+EFIAPI
+TpmTcg( VOID );
+
+//
+// Start a command in Buffer: tag, a size placeholder and the command
+// code (TPM 2.0) or ordinal (TPM 1.2)
+//
+VOID
+EFIAPI
+TpmCommandBegin( TPM_COMMAND *Command,
+                 VOID        *Buffer,
+                 UINT32      Size,
+                 UINT16      Tag,
+                 UINT32      Code );
+
+VOID
+EFIAPI
+TpmPutUint8( TPM_COMMAND *Command,
+             UINT8       Value );
+
+VOID
+EFIAPI
+TpmPutUint16( TPM_COMMAND *Command,
+              UINT16      Value );
+
+VOID
+EFIAPI
+TpmPutUint32( TPM_COMMAND *Command,
+              UINT32      Value );
+
+VOID
+EFIAPI
+TpmPutBytes( TPM_COMMAND *Command,
+             CONST VOID  *Data,
+             UINTN       Size );
+
+//
+// TPM2B: 16-bit size followed by the data
+//
+VOID
+EFIAPI
+TpmPutTpm2b( TPM_COMMAND *Command,
+             CONST VOID  *Data,
+             UINT16      Size );
+
+//
+// Size bytes of the command to be filled in directly by the caller, or
+// NULL (and Overflow set) if they do not fit
+//
+UINT8 *
+EFIAPI
+TpmPutReserve( TPM_COMMAND *Command,
+               UINTN       Size );
+
+//
+// TPML_PCR_SELECTION with one bank, PCR_SELECT_MAX select bytes
+//
+VOID
+EFIAPI
+TpmPutPcrSelection( TPM_COMMAND   *Command,
+                    TPMI_ALG_HASH Alg,
+                    CONST UINT8   *Select );
+
+//
+// Authorization area holding one empty password session (TPM_RS_PW),
+// for handles whose auth value is empty
+//
+VOID
+EFIAPI
+TpmPutPasswordSession( TPM_COMMAND *Command );
+
+//
+// Fill in the size, send the command and set up Response over the
+// Response->Buffer the caller provides (ResponseSize bytes).  Returns
+// EFI_BUFFER_TOO_SMALL if the command overflowed, the transport's error,
+// EFI_DEVICE_ERROR for a malformed response or EFI_PROTOCOL_ERROR if
+// the TPM returned a non-zero response code (left in ResponseCode).
+// On success Response->Offset is just past the header.
+//
+EFI_STATUS
+EFIAPI
+TpmSubmit( TPM_COMMAND  *Command,
+           TPM_RESPONSE *Response,
+           VOID         *ResponseBuffer,
+           UINT32       ResponseSize );
+
+UINT8
+EFIAPI
+TpmGetUint8( TPM_RESPONSE *Response );
+
+UINT16
+EFIAPI
+TpmGetUint16( TPM_RESPONSE *Response );
+
+UINT32
+EFIAPI
+TpmGetUint32( TPM_RESPONSE *Response );
+
+//
+// Pointer to the next Size bytes of the response, or NULL (and Error
+// set) if there are not that many
+//
+UINT8 *
+EFIAPI
+TpmGetBytes( TPM_RESPONSE *Response,
+             UINTN        Size );
+
+//
+// TPM2B in place: returns the data and sets *Size, or NULL
+//
+UINT8 *
+EFIAPI
+TpmGetTpm2b( TPM_RESPONSE *Response,
+             UINT16       *Size );
+
+//
+// Bytes of the response not yet read
+//
+UINT32
+EFIAPI
+TpmRemaining( TPM_RESPONSE *Response );
+
+//
+// Build TPM2_PCR_Read for every bank in PcrSelectionIn, without sending
+// it (for callers that time or repeat the command)
+//
+VOID
+EFIAPI
+TpmBuildPcrRead( TPM_COMMAND              *Command,
+                 VOID                     *Buffer,
+                 UINT32                   Size,
+                 CONST TPML_PCR_SELECTION *PcrSelectionIn );
+
+//
+// TPM2_PCR_Read.  PcrSelectionOut holds the PCRs whose values are in
+// PcrValues, bank by bank in ascending PCR order.  The TPM returns at
+// most eight digests per command, so it may be fewer than asked for;
+// a bank that is not allocated comes back with an empty selection.
+// PcrUpdateCounter may be NULL.
+//
+EFI_STATUS
+EFIAPI
+TpmPcrRead( CONST TPML_PCR_SELECTION *PcrSelectionIn,
+            UINT32                   *PcrUpdateCounter,
+            TPML_PCR_SELECTION       *PcrSelectionOut,
+            TPML_DIGEST              *PcrValues );
+
+//
+// Build TPM2_GetCapability without sending it
+//
+VOID
+EFIAPI
+TpmBuildGetCapability( TPM_COMMAND *Command,
+                       VOID        *Buffer,
+                       UINT32      Size,
+                       TPM_CAP     Capability,
+                       UINT32      Property,
+                       UINT32      PropertyCount );
+
+//
+// TPM2_GetCapability.  On success Response is positioned at the
+// capability data (a count followed by that many entries) in the
+// caller's ResponseBuffer.  MoreData, if not NULL, says whether the TPM
+// has entries beyond these.
+//
+EFI_STATUS
+EFIAPI
+TpmGetCapability( TPM_CAP      Capability,
+                  UINT32       Property,
+                  UINT32       PropertyCount,
+                  BOOLEAN      *MoreData,
+                  TPM_RESPONSE *Response,
+                  VOID         *ResponseBuffer,
+                  UINT32       ResponseSize );
+
+//
+// Commands submitted and the total time spent in the transport since
+// the library was loaded (or last reset)
+//
+VOID
+EFIAPI
+TpmStatistics( UINT64 *Commands,
+               UINT64 *Microseconds );
+
+VOID
+EFIAPI
+TpmResetStatistics( VOID );
+
+#endif
@@ -0,0 +1,92 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  TPM 2.0 capability and PCR bank reporting for ShowPCR20, ShowTCM20,
+//  ShowTrEE and SysReport
+//
+//  License: BSD License
+//
+
+#ifndef _TPM_INFO_LIB_H_
+#define _TPM_INFO_LIB_H_
+
+#include <Protocol/Tcg2Protocol.h>
+#include <IndustryStandard/UefiTcgPlatform.h>
+
+#define TPM_MAX_PCR              24
+#define TPM_MAX_PCR_READ_DIGESTS 8     // digests one TPM2_PCR_Read response can carry
+
+typedef struct {
+    TPML_PCR_SELECTION Selection;      // PCRs wanted, one entry per bank
+    TPML_PCR_SELECTION Read;           // PCRs the TPM returned, same banks and order
+    TPM2B_DIGEST       Digests[HASH_COUNT][TPM_MAX_PCR];
+    UINT32             RoundTrips;     // TPM2_PCR_Read commands sent
+} TPM_PCR_VALUES;
+
+//
+// The four character vendor ID, e.g. "INTC" (in a static buffer)
+//
+CHAR16 *
+EFIAPI
+TpmManufacturerStr( UINT32 ManufacturerID );
+
+//
+// "TPM_ALG_SHA256" etc., "TPM_ALG_UNKNOWN" for a bank not listed
+//
+CONST CHAR16 *
+EFIAPI
+TpmAlgorithmName( TPMI_ALG_HASH Alg );
+
+//
+// EFI_TCG2_PROTOCOL GetCapability data as members of the object the
+// caller has open
+//
+VOID
+EFIAPI
+TpmCapabilityJson( EFI_TCG2_BOOT_SERVICE_CAPABILITY *CapabilityData );
+
+//
+// Select all 24 PCRs of one bank
+//
+VOID
+EFIAPI
+TpmPcrSelectBank( TPM_PCR_VALUES *Values,
+                  TPMI_ALG_HASH  Alg );
+
+//
+// Select every allocated bank and its implemented PCRs, as reported by
+// TPM2_GetCapability.  EFI_NOT_FOUND if no bank is allocated.
+//
+EFI_STATUS
+EFIAPI
+TpmPcrSelectActive( TPM_PCR_VALUES *Values );
+
+//
+// Read the selected PCRs with TpmCommandLib's TpmPcrRead, packing
+// TPM_MAX_PCR_READ_DIGESTS of them, across bank boundaries, into each
+// TPM2_PCR_Read.  A PCR the TPM leaves out is asked for again; one it
+// never returns is not implemented and is left out of Read, so a bank
+// that is not allocated has an empty Read selection.  Returns
+// EFI_NOT_FOUND if there is no TPM 2.0 transport and EFI_DEVICE_ERROR
+// for a failed or malformed response.
+//
+EFI_STATUS
+EFIAPI
+TpmPcrReadAll( TPM_PCR_VALUES *Values );
+
+//
+// Print the PCR values read, bank by bank, and the round trips taken
+//
+VOID
+EFIAPI
+TpmPcrPrint( TPM_PCR_VALUES *Values );
+
+//
+// The same as a "banks" array and counts in the object the caller has
+// open
+//
+VOID
+EFIAPI
+TpmPcrJson( TPM_PCR_VALUES *Values );
+
+#endif
@@ -0,0 +1,41 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Time stamp counter based interval timing for the MyApps utilities
+//
+//  License: BSD License
+//
+
+#ifndef _TSC_TIMER_LIB_H_
+#define _TSC_TIMER_LIB_H_
+
+#define TSC_CALIBRATE_US    10000     // Stall() interval used to measure the TSC rate
+
+
+//
+// Current time stamp counter value
+//
+UINT64
+EFIAPI
+TimerTick( VOID );
+
+//
+// TSC ticks per second.  Measured against gBS->Stall() on the first
+// call and cached after that.
+//
+UINT64
+EFIAPI
+TimerFrequency( VOID );
+
+UINT64
+EFIAPI
+TimerTicksToMicroseconds( UINT64 Ticks );
+
+//
+// Microseconds since StartTick (a value returned by TimerTick())
+//
+UINT64
+EFIAPI
+TimerElapsedMicroseconds( UINT64 StartTick );
+
+#endif
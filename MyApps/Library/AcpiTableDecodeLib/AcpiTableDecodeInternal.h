@@ -0,0 +1,66 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  AcpiTableDecodeLib internal declarations
+//
+//  License: BSD License
+//
+
+#ifndef _ACPI_TABLE_DECODE_INTERNAL_H_
+#define _ACPI_TABLE_DECODE_INTERNAL_H_
+
+#include <Uefi.h>
+#include <Library/AcpiTableDecodeLib.h>
+
+//
+// A PCI function as read from configuration space (Pci.c)
+//
+typedef struct {
+    UINT16   Segment;
+    UINT8    Bus;
+    UINT8    Device;
+    UINT8    Function;
+    BOOLEAN  Present;
+    UINT16   VendorId;
+    UINT16   DeviceId;
+    UINT8    ClassCode[3];          // programming interface, subclass, base class
+    UINT8    HeaderType;
+} PCI_FUNCTION;
+
+// 16-bit requester ID as used by IVRS device entries
+#define PCI_RID_BUS(Rid)       ((UINT8)((Rid) >> 8))
+#define PCI_RID_DEVICE(Rid)    ((UINT8)(((Rid) >> 3) & 0x1f))
+#define PCI_RID_FUNCTION(Rid)  ((UINT8)((Rid) & 0x07))
+#define PCI_RID(Bus, Dev, Fn)  ((UINT16)(((Bus) << 8) | ((Dev) << 3) | (Fn)))
+
+// AcpiTableDecodeLib.c
+VOID InternalAsciiField( CONST CHAR8 *String, UINTN Length, CHAR16 *UniString );
+BOOLEAN InternalTooShort( EFI_ACPI_DESCRIPTION_HEADER *Table, UINTN MinLength, BOOLEAN Json );
+
+// Registry.c
+VOID DecodeWarning( BOOLEAN Json, CONST CHAR16 *Format, ... );
+
+// Pci.c
+BOOLEAN PciFunctionRead( UINT16 Segment, UINT8 Bus, UINT8 Device, UINT8 Function, PCI_FUNCTION *Pci );
+BOOLEAN PciBridgeBuses( PCI_FUNCTION *Bridge, UINT8 *Secondary, UINT8 *Subordinate );
+UINTN PciFunctionsInRange( UINT16 Segment, UINT16 First, UINT16 Last, PCI_FUNCTION *Functions, UINTN Max );
+VOID PciFunctionPrint( CONST CHAR16 *Indent, PCI_FUNCTION *Pci, CONST CHAR16 *Note );
+VOID PciFunctionJson( PCI_FUNCTION *Pci );
+UINTN PciSegmentEnumerate( UINT16 Segment );
+VOID PciSegmentClaim( UINT16 First, UINT16 Last );
+PCI_FUNCTION *PciSegmentNextUnclaimed( UINTN *Index );
+VOID PciNicReset( VOID );
+VOID PciNicAdd( PCI_FUNCTION *Pci );
+UINTN PciNicReport( CONST CHAR16 *Indent, BOOLEAN Json );
+
+//
+// Table decoders.  Only the registry in Registry.c calls these.
+//
+VOID DecodeMADT( EFI_ACPI_DESCRIPTION_HEADER *Table, BOOLEAN Json );
+VOID DecodeMCFG( EFI_ACPI_DESCRIPTION_HEADER *Table, BOOLEAN Json );
+VOID DecodeHPET( EFI_ACPI_DESCRIPTION_HEADER *Table, BOOLEAN Json );
+VOID DecodeDMAR( EFI_ACPI_DESCRIPTION_HEADER *Table, BOOLEAN Json );
+VOID DecodeIVRS( EFI_ACPI_DESCRIPTION_HEADER *Table, BOOLEAN Json );
+VOID DecodePPTT( EFI_ACPI_DESCRIPTION_HEADER *Table, BOOLEAN Json );
+
+#endif
@@ -0,0 +1,490 @@
+//
+//  Copyright (c) 2014-2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Layouts and decoders for the ACPI tables shown by both ListACPI and
+//  the single table utilities (MSDM, SLIC, TPM2, FACS and BGRT)
+//
+//  ListACPI and ShowMSDM, ShowSLIC, ShowTPM2, ShowFACS and ShowBGRT each
+//  carried their own copy of these layouts and decoders, and the copies
+//  had drifted: some read length-dependent fields before checking the
+//  table length, and ShowTPM2 followed the control area address for
+//  every start method.  The utilities now keep only their own options
+//  (hexdump, key only, save image) and the header layout they print.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/HexDumpLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/AcpiTableDecodeLib.h>
+
+#include <IndustryStandard/Tpm2Acpi.h>
+
+#include "AcpiTableDecodeInternal.h"
+
+
+//
+// Length bytes of a fixed size ASCII field, stopping at a NUL
+//
+VOID
+InternalAsciiField( CONST CHAR8 *String,
+                    UINTN Length,
+                    CHAR16 *UniString )
+{
+    while (*String != '\0' && Length > 0) {
+        *(UniString++) = (CHAR16) *(String++);
+        Length--;
+    }
+    *UniString = '\0';
+}
+
+
+//
+// Report a table too short to hold the structure its decoder expects
+//
+BOOLEAN
+InternalTooShort( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                  UINTN MinLength,
+                  BOOLEAN Json )
+{
+    if (Table->Length >= MinLength) {
+        return FALSE;
+    }
+
+    if (Json) {
+        JsonPrint(L"error", L"Table length %d is less than %d", Table->Length, MinLength);
+    } else {
+        OutputPrint(L"  ERROR: Table length %d is less than %d\n", Table->Length, MinLength);
+    }
+
+    return TRUE;
+}
+
+
+VOID
+EFIAPI
+AcpiDecodeSdtHeader( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                     BOOLEAN Json )
+{
+    CHAR16 Buffer[50];
+
+    if (Json) {
+        JsonAsciiString(L"signature", (CHAR8 *)&(Table->Signature), 4);
+        JsonUint(L"length", Table->Length);
+        JsonUint(L"revision", Table->Revision);
+        JsonUint(L"checksum", Table->Checksum);
+        JsonAsciiString(L"oemId", (CHAR8 *)(Table->OemId), 6);
+        JsonAsciiString(L"oemTableId", (CHAR8 *)&(Table->OemTableId), 8);
+        JsonHex(L"oemRevision", Table->OemRevision);
+        JsonAsciiString(L"creatorId", (CHAR8 *)&(Table->CreatorId), 4);
+        JsonHex(L"creatorRevision", Table->CreatorRevision);
+        return;
+    }
+
+    OutputPrint(L"ACPI Standard Header\n");
+    InternalAsciiField((CHAR8 *)&(Table->Signature), 4, Buffer);
+    OutputPrint(L"  Signature         : \"%s\"\n", Buffer);
+    OutputPrint(L"  Length            : 0x%08x (%d)\n", Table->Length, Table->Length);
+    OutputPrint(L"  Revision          : 0x%02x (%d)\n", Table->Revision, Table->Revision);
+    OutputPrint(L"  Checksum          : 0x%02x (%d)\n", Table->Checksum, Table->Checksum);
+    InternalAsciiField((CHAR8 *)(Table->OemId), 6, Buffer);
+    OutputPrint(L"  OEM ID            : \"%s\"\n", Buffer);
+    InternalAsciiField((CHAR8 *)&(Table->OemTableId), 8, Buffer);
+    OutputPrint(L"  OEM Table ID      : \"%s\"\n", Buffer);
+    OutputPrint(L"  OEM Revision      : 0x%08x (%d)\n", Table->OemRevision, Table->OemRevision);
+    InternalAsciiField((CHAR8 *)&(Table->CreatorId), 4, Buffer);
+    OutputPrint(L"  Creator ID        : \"%s\"\n", Buffer);
+    OutputPrint(L"  Creator Revision  : 0x%08x (%d)\n", Table->CreatorRevision, Table->CreatorRevision);
+    OutputPrint(L"\n");
+}
+
+
+CHAR8 *
+EFIAPI
+AcpiMsdmKey( EFI_ACPI_DESCRIPTION_HEADER *Table,
+             UINTN *Length )
+{
+    SOFTWARE_LICENSING *SoftLic;
+
+    if (Table->Length < sizeof(EFI_ACPI_MSDM)) {
+        return NULL;
+    }
+    SoftLic = &(((EFI_ACPI_MSDM *)Table)->SoftLic);
+
+    *Length = SoftLic->DataLength;
+    if (*Length > sizeof(SoftLic->Data)) {
+        *Length = sizeof(SoftLic->Data);
+    }
+
+    return SoftLic->Data;
+}
+
+
+EFI_STATUS
+EFIAPI
+AcpiDecodeMsdm( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                BOOLEAN Verbose,
+                BOOLEAN Json )
+{
+    SOFTWARE_LICENSING *SoftLic;
+    CHAR8 *Data;
+    UINTN DataLength;
+    CHAR16 Buffer[50];
+
+    if (InternalTooShort(Table, sizeof(EFI_ACPI_MSDM), Json)) {
+        return EFI_BAD_BUFFER_SIZE;
+    }
+    SoftLic = &(((EFI_ACPI_MSDM *)Table)->SoftLic);
+    Data = AcpiMsdmKey(Table, &DataLength);
+
+    if (Json) {
+        JsonUint(L"licensingVersion", SoftLic->Version);
+        JsonUint(L"dataType", SoftLic->DataType);
+        JsonUint(L"dataLength", SoftLic->DataLength);
+        JsonAsciiString(L"data", Data, DataLength);
+        return EFI_SUCCESS;
+    }
+
+    OutputPrint(L"  Version           : 0x%08x (%d)\n", SoftLic->Version, SoftLic->Version);
+    if (Verbose) {
+        OutputPrint(L"  Reserved          : 0x%08x (%d)\n", SoftLic->Reserved, SoftLic->Reserved);
+    }
+    OutputPrint(L"  Data Type         : 0x%08x (%d)\n", SoftLic->DataType, SoftLic->DataType);
+    if (Verbose) {
+        OutputPrint(L"  Data Reserved     : 0x%08x (%d)\n", SoftLic->DataReserved, SoftLic->DataReserved);
+    }
+    OutputPrint(L"  Data Length       : 0x%08x (%d)\n", SoftLic->DataLength, SoftLic->DataLength);
+    InternalAsciiField(Data, DataLength, Buffer);
+    OutputPrint(L"  Data              : \"%s\"\n", Buffer);
+
+    return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+EFIAPI
+AcpiDecodeSlic( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                BOOLEAN Verbose,
+                BOOLEAN Json )
+{
+    EFI_ACPI_SLIC *Slic = (EFI_ACPI_SLIC *)Table;
+    OEM_PUBLIC_KEY *PubKey = &(Slic->PubKey);
+    WINDOWS_MARKER *Marker = &(Slic->Marker);
+    UINTN ModulusLength;
+    CHAR16 Buffer[50];
+
+    if (InternalTooShort(Table, sizeof(EFI_ACPI_SLIC), Json)) {
+        return EFI_BAD_BUFFER_SIZE;
+    }
+    ModulusLength = PubKey->BitLength / 8;
+    if (ModulusLength > sizeof(PubKey->Modulus)) {
+        ModulusLength = sizeof(PubKey->Modulus);
+    }
+
+    if (Json) {
+        JsonObjectBegin(L"publicKey");
+        JsonUint(L"type", PubKey->Type);
+        JsonUint(L"length", PubKey->Length);
+        JsonUint(L"keyType", PubKey->KeyType);
+        JsonUint(L"version", PubKey->Version);
+        JsonHex(L"algorithm", PubKey->Algorithm);
+        JsonAsciiString(L"magic", PubKey->Magic, 4);
+        JsonUint(L"bitLength", PubKey->BitLength);
+        JsonUint(L"exponent", PubKey->Exponent);
+        JsonBytes(L"modulus", PubKey->Modulus, ModulusLength);
+        JsonObjectEnd();
+
+        JsonObjectBegin(L"windowsMarker");
+        JsonUint(L"type", Marker->Type);
+        JsonUint(L"length", Marker->Length);
+        JsonUint(L"version", Marker->Version);
+        JsonAsciiString(L"oemId", Marker->OemId, 6);
+        JsonAsciiString(L"oemTableId", Marker->OemTableId, 8);
+        JsonAsciiString(L"windowsFlag", Marker->Product, 8);
+        JsonPrint(L"slicVersion", L"%d.%d", Marker->MajorVersion, Marker->MinorVersion);
+        JsonBytes(L"signature", Marker->Signature, sizeof(Marker->Signature));
+        JsonObjectEnd();
+        return EFI_SUCCESS;
+    }
+
+    OutputPrint(L"  OEM Public Key\n");
+    OutputPrint(L"    Type            : 0x%08x (%d)\n", PubKey->Type, PubKey->Type);
+    OutputPrint(L"    Length          : 0x%08x (%d)\n", PubKey->Length, PubKey->Length);
+    OutputPrint(L"    KeyType         : 0x%02x (%d)\n", PubKey->KeyType, PubKey->KeyType);
+    OutputPrint(L"    Version         : 0x%02x (%d)\n", PubKey->Version, PubKey->Version);
+    if (Verbose) {
+        OutputPrint(L"    Reserved        : 0x%04x (%d)\n", PubKey->Reserved, PubKey->Reserved);
+    }
+    OutputPrint(L"    Algorithm       : 0x%08x (%d)\n", PubKey->Algorithm, PubKey->Algorithm);
+    InternalAsciiField(PubKey->Magic, 4, Buffer);
+    OutputPrint(L"    Magic           : \"%s\"\n", Buffer);
+    OutputPrint(L"    Bit Length      : 0x%08x (%d)\n", PubKey->BitLength, PubKey->BitLength);
+    OutputPrint(L"    Exponent        : 0x%08x (%d)\n", PubKey->Exponent, PubKey->Exponent);
+    if (Verbose) {
+        OutputPrint(L"    Modulus:\n");
+        HexDump( L"    ", L"    ", PubKey->Modulus, ModulusLength, 16, HEXDUMP_0X );
+    }
+
+    OutputPrint(L"  Windows Marker\n");
+    OutputPrint(L"    Type            : 0x%08x (%d)\n", Marker->Type, Marker->Type);
+    OutputPrint(L"    Length          : 0x%08x (%d)\n", Marker->Length, Marker->Length);
+    OutputPrint(L"    Version         : 0x%08x (%d)\n", Marker->Version, Marker->Version);
+    InternalAsciiField(Marker->OemId, 6, Buffer);
+    OutputPrint(L"    OEM ID          : \"%s\"\n", Buffer);
+    InternalAsciiField(Marker->OemTableId, 8, Buffer);
+    OutputPrint(L"    OEM Table ID    : \"%s\"\n", Buffer);
+    InternalAsciiField(Marker->Product, 8, Buffer);
+    OutputPrint(L"    Windows Flag    : \"%s\"\n", Buffer);
+    OutputPrint(L"    SLIC Version    : 0x%04x%04x (%d.%d)\n", Marker->MajorVersion, Marker->MinorVersion,
+                                                          Marker->MajorVersion, Marker->MinorVersion);
+    if (Verbose) {
+        OutputPrint(L"    Signature:\n");
+        HexDump( L"    ", L"    ", Marker->Signature, sizeof(Marker->Signature), 16, HEXDUMP_0X );
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+static CHAR16 *
+StartMethodStr( UINT32 StartMethod )
+{
+    switch (StartMethod) {
+        case 0:  return L"Not allowed";
+        case 1:  return L"Vendor specific legacy use";
+        case 2:  return L"ACPI start method";
+        case 3:
+        case 4:
+        case 5:  return L"Vendor specific legacy use";
+        case 6:  return L"Memory mapped I/O";
+        case 7:  return L"Command response buffer interface";
+        case 8:  return L"Command response buffer interface, ACPI start method";
+        default: return L"Reserved for future use";
+    }
+}
+
+
+//
+// Only the command response buffer interface has a control area at
+// AddressOfControlArea; for the other start methods it can be zero or
+// point at registers that must not be read blindly.
+//
+static EFI_TPM2_ACPI_CONTROL_AREA *
+ControlArea( MY_EFI_TPM2_ACPI_TABLE *Tpm2 )
+{
+    if (Tpm2->AddressOfControlArea == 0) {
+        return NULL;
+    }
+    if (Tpm2->StartMethod != EFI_TPM2_ACPI_TABLE_START_METHOD_COMMAND_RESPONSE_BUFFER_INTERFACE &&
+        Tpm2->StartMethod != EFI_TPM2_ACPI_TABLE_START_METHOD_COMMAND_RESPONSE_BUFFER_INTERFACE_WITH_ACPI) {
+        return NULL;
+    }
+
+    return (EFI_TPM2_ACPI_CONTROL_AREA *)(UINTN)(Tpm2->AddressOfControlArea);
+}
+
+
+EFI_STATUS
+EFIAPI
+AcpiDecodeTpm2( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                BOOLEAN Json )
+{
+    MY_EFI_TPM2_ACPI_TABLE *Tpm2 = (MY_EFI_TPM2_ACPI_TABLE *)Table;
+    EFI_TPM2_ACPI_CONTROL_AREA *Area;
+    UINTN ParametersSize;
+
+    if (InternalTooShort(Table, sizeof(MY_EFI_TPM2_ACPI_TABLE), Json)) {
+        return EFI_BAD_BUFFER_SIZE;
+    }
+    Area = ControlArea(Tpm2);
+    ParametersSize = Tpm2->Header.Length - sizeof(MY_EFI_TPM2_ACPI_TABLE);
+
+    if (Json) {
+        JsonUint(L"platformClass", Tpm2->PlatformClass);
+        JsonHex(L"controlAreaAddress", Tpm2->AddressOfControlArea);
+        if (Area != NULL) {
+            JsonObjectBegin(L"controlArea");
+            JsonHex(L"error", Area->Error);
+            JsonUint(L"commandSize", Area->CommandSize);
+            JsonHex(L"commandAddress", Area->Command);
+            JsonUint(L"responseSize", Area->ResponseSize);
+            JsonHex(L"responseAddress", Area->Response);
+            JsonObjectEnd();
+        } else {
+            JsonNull(L"controlArea");
+        }
+        JsonUint(L"startMethod", Tpm2->StartMethod);
+        JsonString(L"startMethodName", StartMethodStr(Tpm2->StartMethod));
+        if (ParametersSize > 0) {
+            JsonBytes(L"platformSpecificParameters", (UINT8 *)(Tpm2 + 1), ParametersSize);
+        }
+        return EFI_SUCCESS;
+    }
+
+    OutputPrint(L"                  Platform Class : %d\n", Tpm2->PlatformClass);
+    OutputPrint(L"       Control Area (CA) Address : 0x%08lx\n", Tpm2->AddressOfControlArea);
+    if (Area != NULL) {
+        OutputPrint(L"                  CA Error Value : 0x%04x (%d)\n", Area->Error, Area->Error);
+        OutputPrint(L"          CA Command Buffer Size : 0x%04x (%d)\n", Area->CommandSize, Area->CommandSize);
+        OutputPrint(L"       CA Command Buffer Address : 0x%08lx\n", Area->Command);
+        OutputPrint(L"         CA Response Buffer Size : 0x%04x (%d)\n", Area->ResponseSize, Area->ResponseSize);
+        OutputPrint(L"      CA Response Buffer Address : 0x%08lx\n", Area->Response);
+    }
+    OutputPrint(L"                    Start Method : %d (%s)\n", Tpm2->StartMethod, StartMethodStr(Tpm2->StartMethod));
+    OutputPrint(L"  Platform Specific Methods Size : %d\n", ParametersSize);
+    if (ParametersSize > 0) {
+        HexDump( L"    ", L"    ", (UINT8 *)(Tpm2 + 1), ParametersSize, 16, HEXDUMP_0X );
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+EFIAPI
+AcpiDecodeFacs( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                BOOLEAN Verbose,
+                BOOLEAN Json )
+{
+    EFI_ACPI_2_0_FIRMWARE_ACPI_CONTROL_STRUCTURE *Facs = (EFI_ACPI_2_0_FIRMWARE_ACPI_CONTROL_STRUCTURE *)Table;
+
+    if (InternalTooShort(Table, sizeof(EFI_ACPI_2_0_FIRMWARE_ACPI_CONTROL_STRUCTURE), Json)) {
+        return EFI_BAD_BUFFER_SIZE;
+    }
+
+    if (Json) {
+        JsonHex(L"hardwareSignature", Facs->HardwareSignature);
+        JsonHex(L"firmwareWakingVector", Facs->FirmwareWakingVector);
+        JsonHex(L"globalLock", Facs->GlobalLock);
+        JsonHex(L"flags", Facs->Flags);
+        JsonHex(L"xFirmwareWakingVector", Facs->XFirmwareWakingVector);
+        JsonUint(L"version", Facs->Version);
+        return EFI_SUCCESS;
+    }
+
+    OutputPrint(L"  Hardware Signature    : 0x%08x (%d)\n", Facs->HardwareSignature,
+                                                      Facs->HardwareSignature);
+    OutputPrint(L"  FirmwareWakingVector  : 0x%08x (%d)\n", Facs->FirmwareWakingVector,
+                                                      Facs->FirmwareWakingVector);
+    OutputPrint(L"  GlobalLock            : 0x%08x (%d)\n", Facs->GlobalLock, Facs->GlobalLock);
+    OutputPrint(L"  Flags                 : 0x%08x (%d)\n", Facs->Flags, Facs->Flags);
+    OutputPrint(L"  XFirmwareWakingVector : 0x%016lx (%ld)\n", Facs->XFirmwareWakingVector,
+                                                         Facs->XFirmwareWakingVector);
+    OutputPrint(L"  Version               : 0x%02x (%d)\n", Facs->Version, Facs->Version);
+    if (Verbose) {
+        OutputPrint(L"  Reserved:\n");
+        HexDump( L"  ", L"  ", Facs->Reserved, sizeof(Facs->Reserved), 16, HEXDUMP_0X );
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+BMP_IMAGE_HEADER *
+EFIAPI
+AcpiBgrtImage( EFI_ACPI_BGRT *Bgrt )
+{
+    BMP_IMAGE_HEADER *BmpHeader = (BMP_IMAGE_HEADER *)(UINTN)(Bgrt->ImageAddress);
+
+    if (BmpHeader == NULL || Bgrt->ImageType != EFI_ACPI_5_0_BGRT_IMAGE_TYPE_BMP) {
+        return NULL;
+    }
+    if (BmpHeader->CharB != 'B' || BmpHeader->CharM != 'M') {
+        return NULL;
+    }
+
+    return BmpHeader;
+}
+
+
+EFI_STATUS
+EFIAPI
+AcpiDecodeBgrt( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                BOOLEAN Verbose,
+                BOOLEAN Json )
+{
+    EFI_ACPI_BGRT *Bgrt = (EFI_ACPI_BGRT *)Table;
+    BMP_IMAGE_HEADER *BmpHeader;
+
+    if (InternalTooShort(Table, sizeof(EFI_ACPI_BGRT), Json)) {
+        return EFI_BAD_BUFFER_SIZE;
+    }
+    BmpHeader = AcpiBgrtImage(Bgrt);
+
+    if (Json) {
+        JsonUint(L"version", Bgrt->Version);
+        JsonUint(L"status", Bgrt->Status);
+        JsonBool(L"displayed", Bgrt->Status == EFI_ACPI_5_0_BGRT_STATUS_DISPLAYED);
+        JsonUint(L"imageType", Bgrt->ImageType);
+        JsonUint(L"imageOffsetX", Bgrt->ImageOffsetX);
+        JsonUint(L"imageOffsetY", Bgrt->ImageOffsetY);
+        JsonHex(L"imageAddress", Bgrt->ImageAddress);
+        if (BmpHeader != NULL) {
+            JsonObjectBegin(L"image");
+            JsonUint(L"size", BmpHeader->Size);
+            JsonUint(L"imageOffset", BmpHeader->ImageOffset);
+            JsonUint(L"headerSize", BmpHeader->HeaderSize);
+            JsonUint(L"width", BmpHeader->PixelWidth);
+            JsonUint(L"height", BmpHeader->PixelHeight);
+            JsonUint(L"planes", BmpHeader->Planes);
+            JsonUint(L"bitPerPixel", BmpHeader->BitPerPixel);
+            JsonUint(L"compressionType", BmpHeader->CompressionType);
+            JsonUint(L"imageSize", BmpHeader->ImageSize);
+            JsonUint(L"xPixelsPerMeter", BmpHeader->XPixelsPerMeter);
+            JsonUint(L"yPixelsPerMeter", BmpHeader->YPixelsPerMeter);
+            JsonUint(L"numberOfColors", BmpHeader->NumberOfColors);
+            JsonUint(L"importantColors", BmpHeader->ImportantColors);
+            JsonObjectEnd();
+        } else {
+            JsonNull(L"image");
+        }
+        return EFI_SUCCESS;
+    }
+
+    OutputPrint(L"  Version           : %d\n", Bgrt->Version);
+    OutputPrint(L"  Status            : %d", Bgrt->Status);
+    if (Bgrt->Status == EFI_ACPI_5_0_BGRT_STATUS_NOT_DISPLAYED) {
+        OutputPrint(L" (Not displayed)");
+    }
+    if (Bgrt->Status == EFI_ACPI_5_0_BGRT_STATUS_DISPLAYED) {
+        OutputPrint(L" (Displayed)");
+    }
+    OutputPrint(L"\n");
+    OutputPrint(L"  Image Type        : %d", Bgrt->ImageType);
+    if (Bgrt->ImageType == EFI_ACPI_5_0_BGRT_IMAGE_TYPE_BMP) {
+        OutputPrint(L" (BMP format)");
+    }
+    OutputPrint(L"\n");
+    OutputPrint(L"  Offset Y          : %ld\n", Bgrt->ImageOffsetY);
+    OutputPrint(L"  Offset X          : %ld\n", Bgrt->ImageOffsetX);
+    OutputPrint(L"  Physical Address  : 0x%08lx\n", Bgrt->ImageAddress);
+    if (BmpHeader == NULL) {
+        OutputPrint(L"  Image             : not a BMP image\n");
+        return EFI_SUCCESS;
+    }
+
+    OutputPrint(L"  Image Size        : %d\n", BmpHeader->Size);
+    if (Verbose) {
+        OutputPrint(L"  Image Offset      : %d\n", BmpHeader->ImageOffset);
+        OutputPrint(L"  Header Size       : %d\n", BmpHeader->HeaderSize);
+    }
+    OutputPrint(L"  Image Width       : %d\n", BmpHeader->PixelWidth);
+    OutputPrint(L"  Image Height      : %d\n", BmpHeader->PixelHeight);
+    if (Verbose) {
+        OutputPrint(L"  Planes            : %d\n", BmpHeader->Planes);
+    }
+    OutputPrint(L"  Bit Per Pixel     : %d\n", BmpHeader->BitPerPixel);
+    OutputPrint(L"  Compression Type  : %d\n", BmpHeader->CompressionType);
+    if (Verbose) {
+        OutputPrint(L"  Image Data Size   : %d\n", BmpHeader->ImageSize);
+        OutputPrint(L"  X Pixels Per Meter: %d\n", BmpHeader->XPixelsPerMeter);
+        OutputPrint(L"  Y Pixels Per Meter: %d\n", BmpHeader->YPixelsPerMeter);
+        OutputPrint(L"  Number of Colors  : %d\n", BmpHeader->NumberOfColors);
+        OutputPrint(L"  Important Colors  : %d\n", BmpHeader->ImportantColors);
+    }
+
+    return EFI_SUCCESS;
+}
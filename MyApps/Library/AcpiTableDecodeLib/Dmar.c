@@ -0,0 +1,517 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Decoder for the Intel DMA remapping table (DMAR)
+//
+//  Each device scope is resolved to the PCI functions it covers so
+//  that devices behind a remapping unit, and devices with reserved
+//  memory regions (RMRRs) that prevent direct assignment, can be
+//  matched against ShowPCIx output.  A unit with INCLUDE_PCI_ALL covers
+//  the functions on its segment that no other unit names, and each
+//  unit's network functions are listed with it.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+
+#include <IndustryStandard/DmaRemappingReportingTable.h>
+#include <IndustryStandard/Pci.h>
+
+#include "AcpiTableDecodeInternal.h"
+
+#define MAX_SCOPE_FUNCTIONS  256
+
+typedef struct {
+    UINTN  Units;
+    UINTN  UnitNics;
+    UINTN  Regions;
+    UINTN  RmrrFunctions;
+    UINTN  RmrrNics;
+} DMAR_SUMMARY;
+
+STATIC PCI_FUNCTION ScopeFunctions[MAX_SCOPE_FUNCTIONS];
+
+
+static CHAR16 *
+StructureTypeStr( UINT16 Type )
+{
+    switch (Type) {
+        case EFI_ACPI_DMAR_TYPE_DRHD: return L"DRHD";
+        case EFI_ACPI_DMAR_TYPE_RMRR: return L"RMRR";
+        case EFI_ACPI_DMAR_TYPE_ATSR: return L"ATSR";
+        case EFI_ACPI_DMAR_TYPE_RHSA: return L"RHSA";
+        case EFI_ACPI_DMAR_TYPE_ANDD: return L"ANDD";
+        default:                      return L"Reserved";
+    }
+}
+
+
+static CHAR16 *
+ScopeTypeStr( UINT8 Type )
+{
+    switch (Type) {
+        case EFI_ACPI_DEVICE_SCOPE_ENTRY_TYPE_PCI_ENDPOINT:          return L"PCI endpoint";
+        case EFI_ACPI_DEVICE_SCOPE_ENTRY_TYPE_PCI_BRIDGE:            return L"PCI sub-hierarchy";
+        case EFI_ACPI_DEVICE_SCOPE_ENTRY_TYPE_IOAPIC:                return L"I/O APIC";
+        case EFI_ACPI_DEVICE_SCOPE_ENTRY_TYPE_MSI_CAPABLE_HPET:      return L"HPET";
+        case EFI_ACPI_DEVICE_SCOPE_ENTRY_TYPE_ACPI_NAMESPACE_DEVICE: return L"ACPI namespace device";
+        default:                                                    return L"Reserved";
+    }
+}
+
+
+//
+// Size of the fixed part of a remapping structure; the device scopes
+// (for the types that have them) follow it
+//
+static UINTN
+StructureHeaderSize( UINT16 Type )
+{
+    switch (Type) {
+        case EFI_ACPI_DMAR_TYPE_DRHD: return sizeof(EFI_ACPI_DMAR_DRHD_HEADER);
+        case EFI_ACPI_DMAR_TYPE_RMRR: return sizeof(EFI_ACPI_DMAR_RMRR_HEADER);
+        case EFI_ACPI_DMAR_TYPE_ATSR: return sizeof(EFI_ACPI_DMAR_ATSR_HEADER);
+        case EFI_ACPI_DMAR_TYPE_RHSA: return sizeof(EFI_ACPI_DMAR_RHSA_HEADER);
+        case EFI_ACPI_DMAR_TYPE_ANDD: return sizeof(EFI_ACPI_DMAR_ANDD_HEADER);
+        default:                      return sizeof(EFI_ACPI_DMAR_STRUCTURE_HEADER);
+    }
+}
+
+
+static UINT16
+StructureSegment( EFI_ACPI_DMAR_STRUCTURE_HEADER *Structure )
+{
+    switch (Structure->Type) {
+        case EFI_ACPI_DMAR_TYPE_DRHD: return ((EFI_ACPI_DMAR_DRHD_HEADER *)Structure)->SegmentNumber;
+        case EFI_ACPI_DMAR_TYPE_RMRR: return ((EFI_ACPI_DMAR_RMRR_HEADER *)Structure)->SegmentNumber;
+        case EFI_ACPI_DMAR_TYPE_ATSR: return ((EFI_ACPI_DMAR_ATSR_HEADER *)Structure)->SegmentNumber;
+        default:                      return 0;
+    }
+}
+
+
+//
+// Follow the scope path from its start bus through each bridge to the
+// function it names.  A sub-hierarchy scope also covers every function
+// below that bridge.  Returns the number of functions found.
+//
+static UINTN
+ScopeResolve( UINT16 Segment,
+              EFI_ACPI_DMAR_DEVICE_SCOPE_STRUCTURE_HEADER *Scope,
+              PCI_FUNCTION *Target )
+{
+    EFI_ACPI_DMAR_PCI_PATH *Path = (EFI_ACPI_DMAR_PCI_PATH *)(Scope + 1);
+    UINTN Hops = (Scope->Length - sizeof(*Scope)) / sizeof(*Path);
+    UINT8 Bus = Scope->StartBusNumber;
+    UINT8 Secondary;
+    UINT8 Subordinate;
+
+    if (Hops == 0) {
+        return 0;
+    }
+    for (UINTN i = 0; i + 1 < Hops; i++) {
+        PciFunctionRead(Segment, Bus, Path[i].Device, Path[i].Function, Target);
+        if (!PciBridgeBuses(Target, &Secondary, &Subordinate)) {
+            return 0;
+        }
+        Bus = Secondary;
+    }
+    if (!PciFunctionRead(Segment, Bus, Path[Hops - 1].Device, Path[Hops - 1].Function, Target)) {
+        return 0;
+    }
+
+    if (Scope->Type != EFI_ACPI_DEVICE_SCOPE_ENTRY_TYPE_PCI_BRIDGE ||
+        !PciBridgeBuses(Target, &Secondary, &Subordinate) || Subordinate < Secondary) {
+        return 1;
+    }
+
+    return 1 + PciFunctionsInRange( Segment,
+                                    (UINT16)(Secondary << 8),
+                                    (UINT16)((Subordinate << 8) | 0xff),
+                                    ScopeFunctions,
+                                    MAX_SCOPE_FUNCTIONS );
+}
+
+
+static VOID
+PrintPath( EFI_ACPI_DMAR_DEVICE_SCOPE_STRUCTURE_HEADER *Scope )
+{
+    EFI_ACPI_DMAR_PCI_PATH *Path = (EFI_ACPI_DMAR_PCI_PATH *)(Scope + 1);
+    UINTN Hops = (Scope->Length - sizeof(*Scope)) / sizeof(*Path);
+
+    OutputPrint(L"%02x", Scope->StartBusNumber);
+    for (UINTN i = 0; i < Hops; i++) {
+        OutputPrint(L"/%02x.%x", Path[i].Device, Path[i].Function);
+    }
+}
+
+
+static VOID
+DecodeScopes( EFI_ACPI_DMAR_STRUCTURE_HEADER *Structure,
+              DMAR_SUMMARY *Summary,
+              BOOLEAN Json )
+{
+    EFI_ACPI_DMAR_DEVICE_SCOPE_STRUCTURE_HEADER *Scope;
+    PCI_FUNCTION Target;
+    UINT16 Segment = StructureSegment(Structure);
+    BOOLEAN Rmrr = (Structure->Type == EFI_ACPI_DMAR_TYPE_RMRR);
+    CHAR16 *Note = Rmrr ? L"RMRR, not assignable" : NULL;
+    UINT8 *Ptr = (UINT8 *)Structure + StructureHeaderSize(Structure->Type);
+    UINT8 *End = (UINT8 *)Structure + Structure->Length;
+    BOOLEAN PciScope;
+    UINTN Found;
+    UINTN Listed;
+
+    if (Json) {
+        JsonArrayBegin(L"scopes");
+    }
+
+    while (Ptr + sizeof(*Scope) <= End) {
+        Scope = (EFI_ACPI_DMAR_DEVICE_SCOPE_STRUCTURE_HEADER *)Ptr;
+        if (Scope->Length < sizeof(*Scope) || Ptr + Scope->Length > End) {
+            break;
+        }
+
+        // only PCI scopes name a function in configuration space
+        PciScope = (Scope->Type == EFI_ACPI_DEVICE_SCOPE_ENTRY_TYPE_PCI_ENDPOINT ||
+                    Scope->Type == EFI_ACPI_DEVICE_SCOPE_ENTRY_TYPE_PCI_BRIDGE);
+        Found = PciScope ? ScopeResolve(Segment, Scope, &Target) : 0;
+        Listed = (Found > 1) ? MIN(Found - 1, MAX_SCOPE_FUNCTIONS) : 0;
+
+        if (!Rmrr && Found > 0) {
+            PciNicAdd(&Target);
+            for (UINTN i = 0; i < Listed; i++) {
+                PciNicAdd(&ScopeFunctions[i]);
+            }
+        }
+        if (Rmrr && Found > 0) {
+            Summary->RmrrFunctions++;
+            Summary->RmrrNics += (Target.ClassCode[2] == PCI_CLASS_NETWORK);
+            for (UINTN i = 0; i < Listed; i++) {
+                Summary->RmrrFunctions++;
+                Summary->RmrrNics += (ScopeFunctions[i].ClassCode[2] == PCI_CLASS_NETWORK);
+            }
+        }
+
+        if (Json) {
+            JsonObjectBegin(NULL);
+            JsonUint(L"type", Scope->Type);
+            JsonString(L"name", ScopeTypeStr(Scope->Type));
+            JsonUint(L"enumerationId", Scope->EnumerationId);
+            JsonUint(L"startBus", Scope->StartBusNumber);
+            JsonArrayBegin(L"functions");
+            if (Found > 0) {
+                PciFunctionJson(&Target);
+            }
+            for (UINTN i = 0; i < Listed; i++) {
+                PciFunctionJson(&ScopeFunctions[i]);
+            }
+            JsonArrayEnd();
+            JsonObjectEnd();
+        } else {
+            OutputPrint(L"      %-21s  Path: ", ScopeTypeStr(Scope->Type));
+            PrintPath(Scope);
+            if (!PciScope) {
+                OutputPrint(L"  ID: %d", Scope->EnumerationId);
+            }
+            OutputPrint(L"\n");
+            if (Found > 0) {
+                PciFunctionPrint(L"        ", &Target, Note);
+            } else if (PciScope) {
+                OutputPrint(L"        not present\n");
+            }
+            for (UINTN i = 0; i < Listed; i++) {
+                PciFunctionPrint(L"          ", &ScopeFunctions[i], Note);
+            }
+            if (Found > 1 && Found - 1 > Listed) {
+                OutputPrint(L"          ... %d more\n", Found - 1 - Listed);
+            }
+        }
+
+        Ptr += Scope->Length;
+    }
+
+    if (Json) {
+        JsonArrayEnd();
+    }
+}
+
+
+//
+// Claim for another unit the functions its PCI scopes cover: the named
+// function and, for a sub-hierarchy, every bus below the bridge
+//
+static VOID
+ClaimScopes( EFI_ACPI_DMAR_STRUCTURE_HEADER *Structure )
+{
+    EFI_ACPI_DMAR_DEVICE_SCOPE_STRUCTURE_HEADER *Scope;
+    PCI_FUNCTION Target;
+    UINT16 Segment = StructureSegment(Structure);
+    UINT8 *Ptr = (UINT8 *)Structure + StructureHeaderSize(Structure->Type);
+    UINT8 *End = (UINT8 *)Structure + Structure->Length;
+    UINT8 Secondary;
+    UINT8 Subordinate;
+
+    while (Ptr + sizeof(*Scope) <= End) {
+        Scope = (EFI_ACPI_DMAR_DEVICE_SCOPE_STRUCTURE_HEADER *)Ptr;
+        if (Scope->Length < sizeof(*Scope) || Ptr + Scope->Length > End) {
+            break;
+        }
+        if ((Scope->Type == EFI_ACPI_DEVICE_SCOPE_ENTRY_TYPE_PCI_ENDPOINT ||
+             Scope->Type == EFI_ACPI_DEVICE_SCOPE_ENTRY_TYPE_PCI_BRIDGE) &&
+            ScopeResolve(Segment, Scope, &Target) > 0) {
+            PciSegmentClaim( PCI_RID(Target.Bus, Target.Device, Target.Function),
+                             PCI_RID(Target.Bus, Target.Device, Target.Function) );
+            if (Scope->Type == EFI_ACPI_DEVICE_SCOPE_ENTRY_TYPE_PCI_BRIDGE &&
+                PciBridgeBuses(&Target, &Secondary, &Subordinate) && Subordinate >= Secondary) {
+                PciSegmentClaim(PCI_RID(Secondary, 0, 0), PCI_RID(Subordinate, PCI_MAX_DEVICE, PCI_MAX_FUNC));
+            }
+        }
+        Ptr += Scope->Length;
+    }
+}
+
+
+//
+// A unit with INCLUDE_PCI_ALL covers every function on its segment
+// that the scopes of the other units on that segment do not name
+//
+static VOID
+DecodeIncludeAll( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                  EFI_ACPI_DMAR_DRHD_HEADER *Unit,
+                  BOOLEAN Json )
+{
+    EFI_ACPI_DMAR_STRUCTURE_HEADER *Structure;
+    PCI_FUNCTION *Pci;
+    UINT8 *Ptr = (UINT8 *)Table + sizeof(EFI_ACPI_DMAR_HEADER);
+    UINT8 *End = (UINT8 *)Table + Table->Length;
+    UINTN Total;
+    UINTN Index = 0;
+    UINTN Count = 0;
+
+    Total = PciSegmentEnumerate(Unit->SegmentNumber);
+    while (Ptr + sizeof(EFI_ACPI_DMAR_STRUCTURE_HEADER) <= End) {
+        Structure = (EFI_ACPI_DMAR_STRUCTURE_HEADER *)Ptr;
+        if (Structure->Length < StructureHeaderSize(Structure->Type) || Ptr + Structure->Length > End) {
+            break;
+        }
+        if (Structure->Type == EFI_ACPI_DMAR_TYPE_DRHD && Structure != (EFI_ACPI_DMAR_STRUCTURE_HEADER *)Unit &&
+            StructureSegment(Structure) == Unit->SegmentNumber) {
+            ClaimScopes(Structure);
+        }
+        Ptr += Structure->Length;
+    }
+
+    if (Json) {
+        JsonArrayBegin(L"includedFunctions");
+    } else {
+        OutputPrint(L"      All other devices on segment %d:\n", Unit->SegmentNumber);
+    }
+    while ((Pci = PciSegmentNextUnclaimed(&Index)) != NULL) {
+        Count++;
+        PciNicAdd(Pci);
+        if (Json) {
+            PciFunctionJson(Pci);
+        } else {
+            PciFunctionPrint(L"        ", Pci, NULL);
+        }
+    }
+    if (Json) {
+        JsonArrayEnd();
+    } else if (Count == 0) {
+        OutputPrint(L"        none\n");
+    }
+    if (Json) {
+        JsonUint(L"functionsNotChecked", Total - Index);
+    } else if (Total > Index) {
+        OutputPrint(L"        ... %d more not checked\n", Total - Index);
+    }
+}
+
+
+static VOID
+PrintStructure( EFI_ACPI_DMAR_STRUCTURE_HEADER *Structure )
+{
+    EFI_ACPI_DMAR_DRHD_HEADER *Drhd;
+    EFI_ACPI_DMAR_RMRR_HEADER *Rmrr;
+    EFI_ACPI_DMAR_ATSR_HEADER *Atsr;
+    EFI_ACPI_DMAR_RHSA_HEADER *Rhsa;
+    EFI_ACPI_DMAR_ANDD_HEADER *Andd;
+    CHAR16 Name[80];
+
+    OutputPrint(L"  %-4s", StructureTypeStr(Structure->Type));
+
+    switch (Structure->Type) {
+        case EFI_ACPI_DMAR_TYPE_DRHD:
+            Drhd = (EFI_ACPI_DMAR_DRHD_HEADER *)Structure;
+            OutputPrint(L"  Segment: %d  Register Base: 0x%016lx%s\n", Drhd->SegmentNumber, Drhd->RegisterBaseAddress,
+                        (Drhd->Flags & EFI_ACPI_DMAR_DRHD_FLAGS_INCLUDE_PCI_ALL) ? L"  All other devices" : L"");
+            break;
+        case EFI_ACPI_DMAR_TYPE_RMRR:
+            Rmrr = (EFI_ACPI_DMAR_RMRR_HEADER *)Structure;
+            OutputPrint(L"  Segment: %d  Region: 0x%016lx-0x%016lx\n", Rmrr->SegmentNumber,
+                        Rmrr->ReservedMemoryRegionBaseAddress, Rmrr->ReservedMemoryRegionLimitAddress);
+            break;
+        case EFI_ACPI_DMAR_TYPE_ATSR:
+            Atsr = (EFI_ACPI_DMAR_ATSR_HEADER *)Structure;
+            OutputPrint(L"  Segment: %d%s\n", Atsr->SegmentNumber,
+                        (Atsr->Flags & EFI_ACPI_DMAR_ATSR_FLAGS_ALL_PORTS) ? L"  All root ports" : L"");
+            break;
+        case EFI_ACPI_DMAR_TYPE_RHSA:
+            Rhsa = (EFI_ACPI_DMAR_RHSA_HEADER *)Structure;
+            OutputPrint(L"  Register Base: 0x%016lx  Proximity Domain: %d\n", Rhsa->RegisterBaseAddress,
+                        Rhsa->ProximityDomain);
+            break;
+        case EFI_ACPI_DMAR_TYPE_ANDD:
+            Andd = (EFI_ACPI_DMAR_ANDD_HEADER *)Structure;
+            InternalAsciiField( (CHAR8 *)(Andd + 1),
+                                MIN(Structure->Length - sizeof(*Andd), ARRAY_SIZE(Name) - 1),
+                                Name );
+            OutputPrint(L"  Device: %d  Name: %s\n", Andd->AcpiDeviceNumber, Name);
+            break;
+        default:
+            OutputPrint(L"  Type: %d  Length: %d\n", Structure->Type, Structure->Length);
+            break;
+    }
+}
+
+
+static VOID
+JsonStructure( EFI_ACPI_DMAR_STRUCTURE_HEADER *Structure )
+{
+    EFI_ACPI_DMAR_DRHD_HEADER *Drhd;
+    EFI_ACPI_DMAR_RMRR_HEADER *Rmrr;
+    EFI_ACPI_DMAR_ATSR_HEADER *Atsr;
+    EFI_ACPI_DMAR_RHSA_HEADER *Rhsa;
+    EFI_ACPI_DMAR_ANDD_HEADER *Andd;
+    CHAR16 Name[80];
+
+    JsonUint(L"type", Structure->Type);
+    JsonString(L"name", StructureTypeStr(Structure->Type));
+    JsonUint(L"length", Structure->Length);
+
+    switch (Structure->Type) {
+        case EFI_ACPI_DMAR_TYPE_DRHD:
+            Drhd = (EFI_ACPI_DMAR_DRHD_HEADER *)Structure;
+            JsonUint(L"segment", Drhd->SegmentNumber);
+            JsonHex(L"registerBase", Drhd->RegisterBaseAddress);
+            JsonBool(L"includePciAll", (Drhd->Flags & EFI_ACPI_DMAR_DRHD_FLAGS_INCLUDE_PCI_ALL) != 0);
+            break;
+        case EFI_ACPI_DMAR_TYPE_RMRR:
+            Rmrr = (EFI_ACPI_DMAR_RMRR_HEADER *)Structure;
+            JsonUint(L"segment", Rmrr->SegmentNumber);
+            JsonHex(L"baseAddress", Rmrr->ReservedMemoryRegionBaseAddress);
+            JsonHex(L"limitAddress", Rmrr->ReservedMemoryRegionLimitAddress);
+            break;
+        case EFI_ACPI_DMAR_TYPE_ATSR:
+            Atsr = (EFI_ACPI_DMAR_ATSR_HEADER *)Structure;
+            JsonUint(L"segment", Atsr->SegmentNumber);
+            JsonBool(L"allPorts", (Atsr->Flags & EFI_ACPI_DMAR_ATSR_FLAGS_ALL_PORTS) != 0);
+            break;
+        case EFI_ACPI_DMAR_TYPE_RHSA:
+            Rhsa = (EFI_ACPI_DMAR_RHSA_HEADER *)Structure;
+            JsonHex(L"registerBase", Rhsa->RegisterBaseAddress);
+            JsonUint(L"proximityDomain", Rhsa->ProximityDomain);
+            break;
+        case EFI_ACPI_DMAR_TYPE_ANDD:
+            Andd = (EFI_ACPI_DMAR_ANDD_HEADER *)Structure;
+            InternalAsciiField( (CHAR8 *)(Andd + 1),
+                                MIN(Structure->Length - sizeof(*Andd), ARRAY_SIZE(Name) - 1),
+                                Name );
+            JsonUint(L"acpiDeviceNumber", Andd->AcpiDeviceNumber);
+            JsonString(L"objectName", Name);
+            break;
+    }
+}
+
+
+VOID
+DecodeDMAR( EFI_ACPI_DESCRIPTION_HEADER *Table,
+            BOOLEAN Json )
+{
+    EFI_ACPI_DMAR_HEADER *Dmar = (EFI_ACPI_DMAR_HEADER *)Table;
+    EFI_ACPI_DMAR_STRUCTURE_HEADER *Structure;
+    DMAR_SUMMARY Summary = { 0, 0, 0, 0, 0 };
+    UINT8 *Ptr;
+    UINT8 *End;
+    UINT8 *Bad = NULL;
+
+    if (InternalTooShort(Table, sizeof(EFI_ACPI_DMAR_HEADER), Json)) {
+        return;
+    }
+
+    if (Json) {
+        JsonUint(L"hostAddressWidth", Dmar->HostAddressWidth + 1);
+        JsonHex(L"flags", Dmar->Flags);
+        JsonBool(L"interruptRemapping", (Dmar->Flags & EFI_ACPI_DMAR_FLAGS_INTR_REMAP) != 0);
+        JsonBool(L"x2ApicOptOut", (Dmar->Flags & EFI_ACPI_DMAR_FLAGS_X2APIC_OPT_OUT) != 0);
+        JsonArrayBegin(L"structures");
+    } else {
+        OutputPrint(L"  Host Address Width : %d bits\n", Dmar->HostAddressWidth + 1);
+        OutputPrint(L"  Flags              : 0x%02x%s%s\n", Dmar->Flags,
+                    (Dmar->Flags & EFI_ACPI_DMAR_FLAGS_INTR_REMAP) ? L" (Interrupt remapping)" : L"",
+                    (Dmar->Flags & EFI_ACPI_DMAR_FLAGS_X2APIC_OPT_OUT) ? L" (x2APIC opt out)" : L"");
+    }
+
+    Ptr = (UINT8 *)(Dmar + 1);
+    End = (UINT8 *)Table + Table->Length;
+    while (Ptr + sizeof(EFI_ACPI_DMAR_STRUCTURE_HEADER) <= End) {
+        Structure = (EFI_ACPI_DMAR_STRUCTURE_HEADER *)Ptr;
+        if (Structure->Length < StructureHeaderSize(Structure->Type) || Ptr + Structure->Length > End) {
+            Bad = Ptr;
+            break;
+        }
+
+        Summary.Units += (Structure->Type == EFI_ACPI_DMAR_TYPE_DRHD);
+        Summary.Regions += (Structure->Type == EFI_ACPI_DMAR_TYPE_RMRR);
+
+        if (Json) {
+            JsonObjectBegin(NULL);
+            JsonStructure(Structure);
+        } else {
+            PrintStructure(Structure);
+        }
+        PciNicReset();
+        if (Structure->Type <= EFI_ACPI_DMAR_TYPE_ATSR) {
+            DecodeScopes(Structure, &Summary, Json);
+        }
+        if (Structure->Type == EFI_ACPI_DMAR_TYPE_DRHD) {
+            if (((EFI_ACPI_DMAR_DRHD_HEADER *)Structure)->Flags & EFI_ACPI_DMAR_DRHD_FLAGS_INCLUDE_PCI_ALL) {
+                DecodeIncludeAll(Table, (EFI_ACPI_DMAR_DRHD_HEADER *)Structure, Json);
+            }
+            Summary.UnitNics += PciNicReport(L"      ", Json);
+        }
+        if (Json) {
+            JsonObjectEnd();
+        }
+
+        Ptr += Structure->Length;
+    }
+
+    if (Json) {
+        JsonArrayEnd();
+        if (Bad != NULL) {
+            JsonPrint(L"error", L"Bad structure length %d at offset %d",
+                      ((EFI_ACPI_DMAR_STRUCTURE_HEADER *)Bad)->Length, Bad - (UINT8 *)Table);
+        }
+        JsonObjectBegin(L"summary");
+        JsonUint(L"remappingUnits", Summary.Units);
+        JsonUint(L"unitNetworkFunctions", Summary.UnitNics);
+        JsonUint(L"reservedRegions", Summary.Regions);
+        JsonUint(L"rmrrFunctions", Summary.RmrrFunctions);
+        JsonUint(L"rmrrNetworkFunctions", Summary.RmrrNics);
+        JsonObjectEnd();
+    } else {
+        if (Bad != NULL) {
+            OutputPrint(L"  ERROR: Bad structure length %d at offset %d\n",
+                        ((EFI_ACPI_DMAR_STRUCTURE_HEADER *)Bad)->Length, Bad - (UINT8 *)Table);
+        }
+        OutputPrint(L"\n  %d remapping units covering %d network functions\n", Summary.Units, Summary.UnitNics);
+        OutputPrint(L"  %d reserved regions covering %d functions (%d network)\n",
+                    Summary.Regions, Summary.RmrrFunctions, Summary.RmrrNics);
+    }
+}
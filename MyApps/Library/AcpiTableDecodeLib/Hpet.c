@@ -0,0 +1,64 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Decoder for the HPET
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+
+#include <IndustryStandard/HighPrecisionEventTimerTable.h>
+
+#include "AcpiTableDecodeInternal.h"
+
+
+// HPET EventTimerBlockId fields
+#define HPET_HARDWARE_REVISION(Id)     ((Id) & 0xff)
+#define HPET_COMPARATORS(Id)           ((((Id) >> 8) & 0x1f) + 1)
+#define HPET_COUNTER_64BIT             BIT13
+#define HPET_LEGACY_REPLACEMENT        BIT15
+#define HPET_VENDOR_ID(Id)             ((Id) >> 16)
+
+
+VOID
+DecodeHPET( EFI_ACPI_DESCRIPTION_HEADER *Table,
+            BOOLEAN Json )
+{
+    EFI_ACPI_HIGH_PRECISION_EVENT_TIMER_TABLE_HEADER *Hpet = (EFI_ACPI_HIGH_PRECISION_EVENT_TIMER_TABLE_HEADER *)Table;
+    UINT32 Id;
+
+    if (InternalTooShort(Table, sizeof(EFI_ACPI_HIGH_PRECISION_EVENT_TIMER_TABLE_HEADER), Json)) {
+        return;
+    }
+    Id = Hpet->EventTimerBlockId;
+
+    if (Json) {
+        JsonHex(L"eventTimerBlockId", Id);
+        JsonHex(L"vendorId", HPET_VENDOR_ID(Id));
+        JsonUint(L"hardwareRevision", HPET_HARDWARE_REVISION(Id));
+        JsonUint(L"comparators", HPET_COMPARATORS(Id));
+        JsonBool(L"counter64Bit", (Id & HPET_COUNTER_64BIT) != 0);
+        JsonBool(L"legacyReplacement", (Id & HPET_LEGACY_REPLACEMENT) != 0);
+        JsonUint(L"addressSpaceId", Hpet->BaseAddressLower32Bit.AddressSpaceId);
+        JsonHex(L"baseAddress", Hpet->BaseAddressLower32Bit.Address);
+        JsonUint(L"hpetNumber", Hpet->HpetNumber);
+        JsonUint(L"minimumClockTick", Hpet->MainCounterMinimumClockTickInPeriodicMode);
+        JsonHex(L"pageProtection", Hpet->PageProtectionAndOemAttribute);
+        return;
+    }
+
+    OutputPrint(L"  Event Timer Block ID : 0x%08x\n", Id);
+    OutputPrint(L"    PCI Vendor ID      : 0x%04x\n", HPET_VENDOR_ID(Id));
+    OutputPrint(L"    Hardware Revision  : %d\n", HPET_HARDWARE_REVISION(Id));
+    OutputPrint(L"    Comparators        : %d\n", HPET_COMPARATORS(Id));
+    OutputPrint(L"    Counter Size       : %s\n", (Id & HPET_COUNTER_64BIT) ? L"64 bit" : L"32 bit");
+    OutputPrint(L"    Legacy Replacement : %s\n", (Id & HPET_LEGACY_REPLACEMENT) ? L"Yes" : L"No");
+    OutputPrint(L"  Base Address         : 0x%016lx (%s)\n", Hpet->BaseAddressLower32Bit.Address,
+                Hpet->BaseAddressLower32Bit.AddressSpaceId == 0 ? L"memory" : L"I/O");
+    OutputPrint(L"  HPET Number          : %d\n", Hpet->HpetNumber);
+    OutputPrint(L"  Minimum Clock Tick   : %d\n", Hpet->MainCounterMinimumClockTickInPeriodicMode);
+    OutputPrint(L"  Page Protection      : 0x%02x\n", Hpet->PageProtectionAndOemAttribute);
+}
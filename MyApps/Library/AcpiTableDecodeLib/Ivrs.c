@@ -0,0 +1,652 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Decoder for the AMD I/O virtualization reporting table (IVRS)
+//
+//  IVHD device entries are resolved to the PCI functions they cover.
+//  IVMD blocks are the AMD equivalent of Intel RMRRs: the functions
+//  they name need unity mapped memory and cannot be assigned directly.
+//  An "all" entry covers the functions no other IVHD block names, and
+//  each unit's network functions are listed with it.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+
+#include <IndustryStandard/Pci.h>
+
+#include "AcpiTableDecodeInternal.h"
+
+#define MAX_ENTRY_FUNCTIONS  256
+
+// IVHD and IVMD block types
+#define IVHD_TYPE_10         0x10
+#define IVHD_TYPE_11         0x11
+#define IVHD_TYPE_40         0x40
+#define IVMD_TYPE_ALL        0x20
+#define IVMD_TYPE_SELECT     0x21
+#define IVMD_TYPE_RANGE      0x22
+
+// IVHD device entry types
+#define IVHD_DEV_PAD         0x00
+#define IVHD_DEV_ALL         0x01
+#define IVHD_DEV_SELECT      0x02
+#define IVHD_DEV_RANGE_START 0x03
+#define IVHD_DEV_RANGE_END   0x04
+#define IVHD_DEV_ALIAS       0x42
+#define IVHD_DEV_ALIAS_RANGE 0x43
+#define IVHD_DEV_EXT         0x46
+#define IVHD_DEV_EXT_RANGE   0x47
+#define IVHD_DEV_SPECIAL     0x48
+#define IVHD_DEV_ACPI_HID    0xf0
+
+#define IVMD_FLAG_UNITY      BIT0
+#define IVMD_FLAG_READ       BIT1
+#define IVMD_FLAG_WRITE      BIT2
+#define IVMD_FLAG_EXCLUSION  BIT3
+
+#define IVINFO_PA_SIZE(Info) (((Info) >> 8) & 0x7f)
+#define IVINFO_VA_SIZE(Info) (((Info) >> 15) & 0x7f)
+
+#pragma pack(1)
+typedef struct {
+    EFI_ACPI_DESCRIPTION_HEADER  Header;
+    UINT32  IvInfo;
+    UINT64  Reserved;
+} IVRS_HEADER;
+
+typedef struct {
+    UINT8   Type;
+    UINT8   Flags;
+    UINT16  Length;
+    UINT16  DeviceId;
+} IVRS_BLOCK_HEADER;
+
+typedef struct {
+    UINT8   Type;
+    UINT8   Flags;
+    UINT16  Length;
+    UINT16  DeviceId;
+    UINT16  CapabilityOffset;
+    UINT64  BaseAddress;
+    UINT16  PciSegment;
+    UINT16  IommuInfo;
+    UINT32  FeatureInfo;
+} IVHD_HEADER;
+
+// type 11h and 40h blocks add the extended feature register
+typedef struct {
+    IVHD_HEADER  Ivhd;
+    UINT64  Efr;
+    UINT64  Reserved;
+} IVHD_EFR_HEADER;
+
+typedef struct {
+    UINT8   Type;
+    UINT8   Flags;
+    UINT16  Length;
+    UINT16  DeviceId;
+    UINT16  AuxData;
+    UINT64  Reserved;
+    UINT64  StartAddress;
+    UINT64  BlockLength;
+} IVMD_HEADER;
+#pragma pack()
+
+typedef struct {
+    UINTN  Units;
+    UINTN  UnitNics;
+    UINTN  Blocks;
+    UINTN  IvmdFunctions;
+    UINTN  IvmdNics;
+} IVRS_SUMMARY;
+
+STATIC PCI_FUNCTION EntryFunctions[MAX_ENTRY_FUNCTIONS];
+
+
+static CHAR16 *
+BlockTypeStr( UINT8 Type )
+{
+    switch (Type) {
+        case IVHD_TYPE_10:
+        case IVHD_TYPE_11:
+        case IVHD_TYPE_40:     return L"IVHD";
+        case IVMD_TYPE_ALL:
+        case IVMD_TYPE_SELECT:
+        case IVMD_TYPE_RANGE:  return L"IVMD";
+        default:               return L"Reserved";
+    }
+}
+
+
+static CHAR16 *
+EntryTypeStr( UINT8 Type )
+{
+    switch (Type) {
+        case IVHD_DEV_ALL:
+            return L"All";
+        case IVHD_DEV_SELECT:
+        case IVHD_DEV_EXT:
+            return L"Select";
+        case IVHD_DEV_RANGE_START:
+        case IVHD_DEV_ALIAS_RANGE:
+        case IVHD_DEV_EXT_RANGE:
+            return L"Range";
+        case IVHD_DEV_ALIAS:
+            return L"Alias";
+        case IVHD_DEV_SPECIAL:
+            return L"Special";
+        case IVHD_DEV_ACPI_HID:
+            return L"ACPI HID";
+        default:
+            return L"Reserved";
+    }
+}
+
+
+//
+// Device entries are 4 << (type >> 6) bytes long, except ACPI HID
+// entries which carry their own UID length.  Returns 0 for an entry
+// whose length cannot be determined.
+//
+static UINTN
+EntryLength( UINT8 *Entry,
+             UINT8 *End )
+{
+    if (Entry[0] < 0x80) {
+        return 4 << (Entry[0] >> 6);
+    }
+    if (Entry[0] == IVHD_DEV_ACPI_HID && Entry + 22 <= End) {
+        return 22 + Entry[21];
+    }
+
+    return 0;
+}
+
+
+static UINTN
+IvhdHeaderSize( UINT8 Type )
+{
+    return Type == IVHD_TYPE_10 ? sizeof(IVHD_HEADER) : sizeof(IVHD_EFR_HEADER);
+}
+
+
+//
+// Print or write the functions from First to Last, counting those that
+// an IVMD block makes unassignable.  For an IVHD entry (Unit) the
+// network functions are noted for the unit's report.
+//
+static VOID
+ListFunctions( UINT16 Segment,
+               UINT16 First,
+               UINT16 Last,
+               CONST CHAR16 *Note,
+               IVRS_SUMMARY *Summary,
+               BOOLEAN Unit,
+               BOOLEAN Json )
+{
+    UINTN Found = PciFunctionsInRange(Segment, First, Last, EntryFunctions, MAX_ENTRY_FUNCTIONS);
+    UINTN Listed = MIN(Found, MAX_ENTRY_FUNCTIONS);
+
+    if (Json) {
+        JsonArrayBegin(L"functions");
+    }
+    for (UINTN i = 0; i < Listed; i++) {
+        if (Summary != NULL) {
+            Summary->IvmdFunctions++;
+            Summary->IvmdNics += (EntryFunctions[i].ClassCode[2] == PCI_CLASS_NETWORK);
+        }
+        if (Unit) {
+            PciNicAdd(&EntryFunctions[i]);
+        }
+        if (Json) {
+            PciFunctionJson(&EntryFunctions[i]);
+        } else {
+            PciFunctionPrint(L"        ", &EntryFunctions[i], Note);
+        }
+    }
+    if (Json) {
+        JsonArrayEnd();
+    } else if (Found > Listed) {
+        OutputPrint(L"        ... %d more\n", Found - Listed);
+    } else if (Found == 0) {
+        OutputPrint(L"        not present\n");
+    }
+}
+
+
+static VOID
+EntryBegin( UINT8 Type,
+            UINT16 First,
+            UINT16 Last,
+            BOOLEAN Json )
+{
+    if (Json) {
+        JsonObjectBegin(NULL);
+        JsonUint(L"type", Type);
+        JsonString(L"name", EntryTypeStr(Type));
+        JsonHex(L"firstDeviceId", First);
+        JsonHex(L"lastDeviceId", Last);
+    } else {
+        OutputPrint(L"      %-8s  %02x:%02x.%x", EntryTypeStr(Type),
+                    PCI_RID_BUS(First), PCI_RID_DEVICE(First), PCI_RID_FUNCTION(First));
+        if (Last != First) {
+            OutputPrint(L" - %02x:%02x.%x", PCI_RID_BUS(Last), PCI_RID_DEVICE(Last), PCI_RID_FUNCTION(Last));
+        }
+    }
+}
+
+
+//
+// TRUE for IVHD blocks superseded by a later type 11h or 40h block
+// for the same IOMMU; firmware lists every type so older operating
+// systems find one they understand
+//
+static BOOLEAN
+IvhdSuperseded( IVHD_HEADER *Ivhd,
+                UINT8 *End )
+{
+    IVRS_BLOCK_HEADER *Block;
+    UINT8 *Ptr = (UINT8 *)Ivhd + Ivhd->Length;
+
+    while (Ptr + sizeof(IVRS_BLOCK_HEADER) <= End) {
+        Block = (IVRS_BLOCK_HEADER *)Ptr;
+        if (Block->Length < sizeof(IVRS_BLOCK_HEADER) || Ptr + Block->Length > End) {
+            break;
+        }
+        if ((Block->Type == IVHD_TYPE_11 || Block->Type == IVHD_TYPE_40) && Block->Type > Ivhd->Type &&
+            Block->DeviceId == Ivhd->DeviceId) {
+            return TRUE;
+        }
+        Ptr += Block->Length;
+    }
+
+    return FALSE;
+}
+
+
+//
+// Claim for another unit the device IDs its select and range entries
+// name
+//
+static VOID
+ClaimDeviceEntries( IVHD_HEADER *Ivhd )
+{
+    UINT8 *Ptr = (UINT8 *)Ivhd + IvhdHeaderSize(Ivhd->Type);
+    UINT8 *End = (UINT8 *)Ivhd + Ivhd->Length;
+    UINT16 DeviceId;
+    UINT16 RangeStart = 0;
+    BOOLEAN InRange = FALSE;
+    UINTN Length;
+
+    while (Ptr + 4 <= End) {
+        Length = EntryLength(Ptr, End);
+        if (Length == 0 || Ptr + Length > End) {
+            break;
+        }
+        DeviceId = *(UINT16 *)(Ptr + 1);
+
+        switch (Ptr[0]) {
+            case IVHD_DEV_SELECT:
+            case IVHD_DEV_ALIAS:
+            case IVHD_DEV_EXT:
+                PciSegmentClaim(DeviceId, DeviceId);
+                break;
+            case IVHD_DEV_RANGE_START:
+            case IVHD_DEV_ALIAS_RANGE:
+            case IVHD_DEV_EXT_RANGE:
+                RangeStart = DeviceId;
+                InRange = TRUE;
+                break;
+            case IVHD_DEV_RANGE_END:
+                if (InRange && DeviceId >= RangeStart) {
+                    PciSegmentClaim(RangeStart, DeviceId);
+                }
+                InRange = FALSE;
+                break;
+            default:
+                break;
+        }
+
+        Ptr += Length;
+    }
+}
+
+
+//
+// An "all" entry covers every function on the unit's segment that the
+// other (current) IVHD blocks for that segment do not name
+//
+static VOID
+ListAllDevices( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                IVHD_HEADER *Unit,
+                BOOLEAN Json )
+{
+    IVRS_BLOCK_HEADER *Block;
+    PCI_FUNCTION *Pci;
+    UINT8 *Ptr = (UINT8 *)Table + sizeof(IVRS_HEADER);
+    UINT8 *End = (UINT8 *)Table + Table->Length;
+    UINTN Total;
+    UINTN Index = 0;
+    UINTN Count = 0;
+
+    Total = PciSegmentEnumerate(Unit->PciSegment);
+    while (Ptr + sizeof(IVRS_BLOCK_HEADER) <= End) {
+        Block = (IVRS_BLOCK_HEADER *)Ptr;
+        if (Block->Length < sizeof(IVRS_BLOCK_HEADER) || Ptr + Block->Length > End) {
+            break;
+        }
+        if ((Block->Type == IVHD_TYPE_10 || Block->Type == IVHD_TYPE_11 || Block->Type == IVHD_TYPE_40) &&
+            Block->Length >= IvhdHeaderSize(Block->Type) && Block != (IVRS_BLOCK_HEADER *)Unit &&
+            ((IVHD_HEADER *)Block)->PciSegment == Unit->PciSegment && !IvhdSuperseded((IVHD_HEADER *)Block, End)) {
+            ClaimDeviceEntries((IVHD_HEADER *)Block);
+        }
+        Ptr += Block->Length;
+    }
+
+    if (Json) {
+        JsonArrayBegin(L"functions");
+    }
+    while ((Pci = PciSegmentNextUnclaimed(&Index)) != NULL) {
+        Count++;
+        PciNicAdd(Pci);
+        if (Json) {
+            PciFunctionJson(Pci);
+        } else {
+            PciFunctionPrint(L"        ", Pci, NULL);
+        }
+    }
+    if (Json) {
+        JsonArrayEnd();
+        JsonUint(L"functionsNotChecked", Total - Index);
+    } else if (Total > Index) {
+        OutputPrint(L"        ... %d more not checked\n", Total - Index);
+    } else if (Count == 0) {
+        OutputPrint(L"        not present\n");
+    }
+}
+
+
+//
+// Walk the device entries of one IVHD block.  Range start entries are
+// held until the matching end entry arrives.
+//
+static VOID
+DecodeDeviceEntries( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                     IVHD_HEADER *Ivhd,
+                     BOOLEAN Json )
+{
+    UINT8 *Ptr = (UINT8 *)Ivhd + IvhdHeaderSize(Ivhd->Type);
+    UINT8 *End = (UINT8 *)Ivhd + Ivhd->Length;
+    UINT16 DeviceId;
+    UINT16 RangeStart = 0;
+    UINT8 RangeType = 0;
+    BOOLEAN InRange = FALSE;
+    CHAR16 Hid[9];
+    UINTN Length;
+
+    if (Json) {
+        JsonArrayBegin(L"devices");
+    }
+
+    while (Ptr + 4 <= End) {
+        Length = EntryLength(Ptr, End);
+        if (Length == 0 || Ptr + Length > End) {
+            break;
+        }
+        DeviceId = *(UINT16 *)(Ptr + 1);
+
+        switch (Ptr[0]) {
+            case IVHD_DEV_PAD:
+                break;
+            case IVHD_DEV_ALL:
+                EntryBegin(Ptr[0], 0, 0xffff, Json);
+                if (!Json) {
+                    OutputPrint(L"  all other devices on segment %d\n", Ivhd->PciSegment);
+                }
+                ListAllDevices(Table, Ivhd, Json);
+                if (Json) {
+                    JsonObjectEnd();
+                }
+                break;
+            case IVHD_DEV_SELECT:
+            case IVHD_DEV_ALIAS:
+            case IVHD_DEV_EXT:
+                EntryBegin(Ptr[0], DeviceId, DeviceId, Json);
+                if (Ptr[0] == IVHD_DEV_ALIAS) {
+                    if (Json) {
+                        JsonHex(L"aliasDeviceId", *(UINT16 *)(Ptr + 5));
+                    } else {
+                        OutputPrint(L"  alias %02x:%02x.%x", PCI_RID_BUS(*(UINT16 *)(Ptr + 5)),
+                                    PCI_RID_DEVICE(*(UINT16 *)(Ptr + 5)), PCI_RID_FUNCTION(*(UINT16 *)(Ptr + 5)));
+                    }
+                }
+                if (!Json) {
+                    OutputPrint(L"\n");
+                }
+                ListFunctions(Ivhd->PciSegment, DeviceId, DeviceId, NULL, NULL, TRUE, Json);
+                if (Json) {
+                    JsonObjectEnd();
+                }
+                break;
+            case IVHD_DEV_RANGE_START:
+            case IVHD_DEV_ALIAS_RANGE:
+            case IVHD_DEV_EXT_RANGE:
+                RangeStart = DeviceId;
+                RangeType = Ptr[0];
+                InRange = TRUE;
+                break;
+            case IVHD_DEV_RANGE_END:
+                if (InRange && DeviceId >= RangeStart) {
+                    EntryBegin(RangeType, RangeStart, DeviceId, Json);
+                    if (!Json) {
+                        OutputPrint(L"\n");
+                    }
+                    ListFunctions(Ivhd->PciSegment, RangeStart, DeviceId, NULL, NULL, TRUE, Json);
+                    if (Json) {
+                        JsonObjectEnd();
+                    }
+                }
+                InRange = FALSE;
+                break;
+            case IVHD_DEV_SPECIAL:
+                // Ptr[4] is the I/O APIC ID or HPET number, Ptr[7] says which
+                DeviceId = *(UINT16 *)(Ptr + 5);
+                EntryBegin(Ptr[0], DeviceId, DeviceId, Json);
+                if (Json) {
+                    JsonString(L"variety", Ptr[7] == 1 ? L"IOAPIC" : Ptr[7] == 2 ? L"HPET" : L"Reserved");
+                    JsonUint(L"handle", Ptr[4]);
+                    JsonObjectEnd();
+                } else {
+                    OutputPrint(L"  %s %d\n", Ptr[7] == 1 ? L"I/O APIC" : Ptr[7] == 2 ? L"HPET" : L"Reserved", Ptr[4]);
+                }
+                break;
+            case IVHD_DEV_ACPI_HID:
+                InternalAsciiField((CHAR8 *)(Ptr + 4), 8, Hid);
+                EntryBegin(Ptr[0], DeviceId, DeviceId, Json);
+                if (Json) {
+                    JsonString(L"hid", Hid);
+                    JsonObjectEnd();
+                } else {
+                    OutputPrint(L"  %s\n", Hid);
+                }
+                break;
+            default:
+                break;
+        }
+
+        Ptr += Length;
+    }
+
+    if (Json) {
+        JsonArrayEnd();
+    }
+}
+
+
+static UINTN
+DecodeIvhd( EFI_ACPI_DESCRIPTION_HEADER *Table,
+            IVHD_HEADER *Ivhd,
+            BOOLEAN Json )
+{
+    IVHD_EFR_HEADER *Efr = (Ivhd->Type == IVHD_TYPE_10) ? NULL : (IVHD_EFR_HEADER *)Ivhd;
+
+    if (Json) {
+        JsonUint(L"segment", Ivhd->PciSegment);
+        JsonHex(L"iommuDeviceId", Ivhd->DeviceId);
+        JsonHex(L"baseAddress", Ivhd->BaseAddress);
+        JsonHex(L"flags", Ivhd->Flags);
+        if (Efr != NULL) {
+            JsonHex(L"efr", Efr->Efr);
+        }
+    } else {
+        OutputPrint(L"  IVHD  Type: 0x%02x  Segment: %d  IOMMU: %02x:%02x.%x  Base: 0x%016lx\n",
+                    Ivhd->Type, Ivhd->PciSegment, PCI_RID_BUS(Ivhd->DeviceId),
+                    PCI_RID_DEVICE(Ivhd->DeviceId), PCI_RID_FUNCTION(Ivhd->DeviceId), Ivhd->BaseAddress);
+    }
+
+    PciNicReset();
+    DecodeDeviceEntries(Table, Ivhd, Json);
+
+    return PciNicReport(L"      ", Json);
+}
+
+
+static VOID
+DecodeIvmd( IVMD_HEADER *Ivmd,
+            IVRS_SUMMARY *Summary,
+            BOOLEAN Json )
+{
+    CHAR16 *Note = (Ivmd->Flags & IVMD_FLAG_UNITY) ? L"IVMD, not assignable" : NULL;
+    UINT16 Last = (Ivmd->Type == IVMD_TYPE_RANGE) ? Ivmd->AuxData : Ivmd->DeviceId;
+
+    if (Json) {
+        JsonHex(L"flags", Ivmd->Flags);
+        JsonBool(L"unity", (Ivmd->Flags & IVMD_FLAG_UNITY) != 0);
+        JsonBool(L"exclusion", (Ivmd->Flags & IVMD_FLAG_EXCLUSION) != 0);
+        JsonHex(L"startAddress", Ivmd->StartAddress);
+        JsonHex(L"length", Ivmd->BlockLength);
+    } else {
+        OutputPrint(L"  IVMD  Region: 0x%016lx-0x%016lx %s%s%s%s\n", Ivmd->StartAddress,
+                    Ivmd->StartAddress + Ivmd->BlockLength - 1,
+                    (Ivmd->Flags & IVMD_FLAG_UNITY) ? L" Unity" : L"",
+                    (Ivmd->Flags & IVMD_FLAG_READ) ? L" R" : L"",
+                    (Ivmd->Flags & IVMD_FLAG_WRITE) ? L" W" : L"",
+                    (Ivmd->Flags & IVMD_FLAG_EXCLUSION) ? L" Exclusion" : L"");
+    }
+
+    // IVMD blocks have no segment field; they apply to segment 0
+    if (Ivmd->Type == IVMD_TYPE_ALL) {
+        if (Json) {
+            JsonBool(L"allDevices", TRUE);
+        } else {
+            OutputPrint(L"      All devices\n");
+        }
+        ListFunctions(0, 0, 0xffff, Note, (Note != NULL) ? Summary : NULL, FALSE, Json);
+        return;
+    }
+    if (Json) {
+        JsonHex(L"firstDeviceId", Ivmd->DeviceId);
+        JsonHex(L"lastDeviceId", Last);
+    }
+    ListFunctions(0, Ivmd->DeviceId, Last, Note, (Note != NULL) ? Summary : NULL, FALSE, Json);
+}
+
+
+VOID
+DecodeIVRS( EFI_ACPI_DESCRIPTION_HEADER *Table,
+            BOOLEAN Json )
+{
+    IVRS_HEADER *Ivrs = (IVRS_HEADER *)Table;
+    IVRS_BLOCK_HEADER *Block;
+    IVRS_SUMMARY Summary = { 0, 0, 0, 0, 0 };
+    BOOLEAN Ivhd;
+    UINT8 *Ptr;
+    UINT8 *End;
+    UINT8 *Bad = NULL;
+
+    if (InternalTooShort(Table, sizeof(IVRS_HEADER), Json)) {
+        return;
+    }
+
+    if (Json) {
+        JsonHex(L"ivInfo", Ivrs->IvInfo);
+        JsonUint(L"physicalAddressSize", IVINFO_PA_SIZE(Ivrs->IvInfo));
+        JsonUint(L"virtualAddressSize", IVINFO_VA_SIZE(Ivrs->IvInfo));
+        JsonArrayBegin(L"blocks");
+    } else {
+        OutputPrint(L"  IVinfo             : 0x%08x (PA %d bits, VA %d bits)\n", Ivrs->IvInfo,
+                    IVINFO_PA_SIZE(Ivrs->IvInfo), IVINFO_VA_SIZE(Ivrs->IvInfo));
+    }
+
+    Ptr = (UINT8 *)(Ivrs + 1);
+    End = (UINT8 *)Table + Table->Length;
+    while (Ptr + sizeof(IVRS_BLOCK_HEADER) <= End) {
+        Block = (IVRS_BLOCK_HEADER *)Ptr;
+        if (Block->Length < sizeof(IVRS_BLOCK_HEADER) || Ptr + Block->Length > End) {
+            Bad = Ptr;
+            break;
+        }
+        Ivhd = (Block->Type == IVHD_TYPE_10 || Block->Type == IVHD_TYPE_11 || Block->Type == IVHD_TYPE_40);
+        if ((Ivhd && Block->Length < IvhdHeaderSize(Block->Type)) ||
+            (!Ivhd && Block->Type >= IVMD_TYPE_ALL && Block->Type <= IVMD_TYPE_RANGE && Block->Length < sizeof(IVMD_HEADER))) {
+            Bad = Ptr;
+            break;
+        }
+
+        if (Json) {
+            JsonObjectBegin(NULL);
+            JsonUint(L"type", Block->Type);
+            JsonString(L"name", BlockTypeStr(Block->Type));
+            JsonUint(L"length", Block->Length);
+        }
+
+        if (Ivhd && IvhdSuperseded((IVHD_HEADER *)Block, End)) {
+            if (Json) {
+                JsonBool(L"superseded", TRUE);
+            } else {
+                OutputPrint(L"  IVHD  Type: 0x%02x  superseded by a later block\n", Block->Type);
+            }
+        } else if (Ivhd) {
+            Summary.Units++;
+            Summary.UnitNics += DecodeIvhd(Table, (IVHD_HEADER *)Block, Json);
+        } else if (Block->Type >= IVMD_TYPE_ALL && Block->Type <= IVMD_TYPE_RANGE) {
+            Summary.Blocks++;
+            DecodeIvmd((IVMD_HEADER *)Block, &Summary, Json);
+        } else if (!Json) {
+            OutputPrint(L"  %-4s  Type: 0x%02x  Length: %d\n", BlockTypeStr(Block->Type), Block->Type, Block->Length);
+        }
+
+        if (Json) {
+            JsonObjectEnd();
+        }
+        Ptr += Block->Length;
+    }
+
+    if (Json) {
+        JsonArrayEnd();
+        if (Bad != NULL) {
+            JsonPrint(L"error", L"Bad block length %d at offset %d",
+                      ((IVRS_BLOCK_HEADER *)Bad)->Length, Bad - (UINT8 *)Table);
+        }
+        JsonObjectBegin(L"summary");
+        JsonUint(L"remappingUnits", Summary.Units);
+        JsonUint(L"unitNetworkFunctions", Summary.UnitNics);
+        JsonUint(L"memoryBlocks", Summary.Blocks);
+        JsonUint(L"ivmdFunctions", Summary.IvmdFunctions);
+        JsonUint(L"ivmdNetworkFunctions", Summary.IvmdNics);
+        JsonObjectEnd();
+    } else {
+        if (Bad != NULL) {
+            OutputPrint(L"  ERROR: Bad block length %d at offset %d\n",
+                        ((IVRS_BLOCK_HEADER *)Bad)->Length, Bad - (UINT8 *)Table);
+        }
+        OutputPrint(L"\n  %d remapping units covering %d network functions\n", Summary.Units, Summary.UnitNics);
+        OutputPrint(L"  %d memory blocks covering %d functions (%d network)\n",
+                    Summary.Blocks, Summary.IvmdFunctions, Summary.IvmdNics);
+    }
+}
@@ -0,0 +1,582 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Decoder for the MADT (signature APIC)
+//
+//  Lists the interrupt controller structures and cross-checks the
+//  processor entries against what MP Services actually started.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+
+#include <Protocol/MpService.h>
+
+#include "AcpiTableDecodeInternal.h"
+
+// Local APIC/x2APIC flag added in ACPI 6.3: can be enabled at runtime
+#define MADT_ONLINE_CAPABLE   BIT1
+
+#define MADT_MAX_PROCESSORS   1024
+
+// processor entry states
+#define CPU_ENABLED           0
+#define CPU_ONLINE_CAPABLE    1
+#define CPU_DISABLED          2
+
+typedef struct {
+    UINT64  Id;                 // APIC ID, x2APIC ID or GICC MPIDR
+    UINT8   State;
+    BOOLEAN Started;            // MP Services reports it
+} MADT_PROCESSOR;
+
+STATIC MADT_PROCESSOR Processors[MADT_MAX_PROCESSORS];
+STATIC UINTN          ProcessorCount;
+STATIC UINTN          DroppedProcessors;
+
+// GICC through MPIDR; the ACPI 5.1 structure stops there
+#define GICC_MIN_LENGTH  OFFSET_OF(EFI_ACPI_6_0_GIC_STRUCTURE, ProcessorPowerEfficiencyClass)
+
+
+static CHAR16 *
+StructureTypeStr( UINT8 Type )
+{
+    switch (Type) {
+        case EFI_ACPI_6_0_PROCESSOR_LOCAL_APIC:          return L"Local APIC";
+        case EFI_ACPI_6_0_IO_APIC:                       return L"I/O APIC";
+        case EFI_ACPI_6_0_INTERRUPT_SOURCE_OVERRIDE:     return L"Interrupt Source Override";
+        case EFI_ACPI_6_0_NON_MASKABLE_INTERRUPT_SOURCE: return L"NMI Source";
+        case EFI_ACPI_6_0_LOCAL_APIC_NMI:                return L"Local APIC NMI";
+        case EFI_ACPI_6_0_LOCAL_APIC_ADDRESS_OVERRIDE:   return L"Local APIC Address Override";
+        case EFI_ACPI_6_0_IO_SAPIC:                      return L"I/O SAPIC";
+        case EFI_ACPI_6_0_LOCAL_SAPIC:                   return L"Local SAPIC";
+        case EFI_ACPI_6_0_PLATFORM_INTERRUPT_SOURCES:    return L"Platform Interrupt Sources";
+        case EFI_ACPI_6_0_PROCESSOR_LOCAL_X2APIC:        return L"Local x2APIC";
+        case EFI_ACPI_6_0_LOCAL_X2APIC_NMI:              return L"Local x2APIC NMI";
+        case EFI_ACPI_6_0_GIC:                           return L"GIC CPU Interface";
+        case EFI_ACPI_6_0_GICD:                          return L"GIC Distributor";
+        case EFI_ACPI_6_0_GIC_MSI_FRAME:                 return L"GIC MSI Frame";
+        case EFI_ACPI_6_0_GICR:                          return L"GIC Redistributor";
+        case EFI_ACPI_6_0_GIC_ITS:                       return L"GIC ITS";
+        default:                                         return L"Reserved";
+    }
+}
+
+
+static UINT8
+ProcessorState( UINT32 Flags )
+{
+    if (Flags & EFI_ACPI_6_0_LOCAL_APIC_ENABLED) {
+        return CPU_ENABLED;
+    }
+    if (Flags & MADT_ONLINE_CAPABLE) {
+        return CPU_ONLINE_CAPABLE;
+    }
+    return CPU_DISABLED;
+}
+
+
+static CHAR16 *
+ProcessorStateStr( UINT32 Flags )
+{
+    switch (ProcessorState(Flags)) {
+        case CPU_ENABLED:        return L"Enabled";
+        case CPU_ONLINE_CAPABLE: return L"Online capable";
+        default:                 return L"Disabled";
+    }
+}
+
+
+//
+// Processor entries in table order, for the MP Services cross-check.
+// GICC entries have no online capable flag.
+//
+static VOID
+AddProcessor( UINT8 *Ptr )
+{
+    MADT_PROCESSOR *Cpu;
+
+    if (ProcessorCount == MADT_MAX_PROCESSORS) {
+        DroppedProcessors++;
+        return;
+    }
+    Cpu = &Processors[ProcessorCount];
+
+    switch (Ptr[0]) {
+        case EFI_ACPI_6_0_PROCESSOR_LOCAL_APIC:
+            Cpu->Id = ((EFI_ACPI_6_0_PROCESSOR_LOCAL_APIC_STRUCTURE *)Ptr)->ApicId;
+            Cpu->State = ProcessorState(((EFI_ACPI_6_0_PROCESSOR_LOCAL_APIC_STRUCTURE *)Ptr)->Flags);
+            break;
+        case EFI_ACPI_6_0_PROCESSOR_LOCAL_X2APIC:
+            Cpu->Id = ((EFI_ACPI_6_0_PROCESSOR_LOCAL_X2APIC_STRUCTURE *)Ptr)->X2ApicId;
+            Cpu->State = ProcessorState(((EFI_ACPI_6_0_PROCESSOR_LOCAL_X2APIC_STRUCTURE *)Ptr)->Flags);
+            break;
+        case EFI_ACPI_6_0_GIC:
+            Cpu->Id = ((EFI_ACPI_6_0_GIC_STRUCTURE *)Ptr)->MPIDR;
+            Cpu->State = (((EFI_ACPI_6_0_GIC_STRUCTURE *)Ptr)->Flags & EFI_ACPI_6_0_GIC_ENABLED) ?
+                         CPU_ENABLED : CPU_DISABLED;
+            break;
+        default:
+            return;
+    }
+    Cpu->Started = FALSE;
+    ProcessorCount++;
+}
+
+
+//
+// TRUE if the structure is one of the known types and long enough to
+// hold its fields; anything else is listed by type and length only
+//
+static BOOLEAN
+StructureKnown( UINT8 *Ptr )
+{
+    switch (Ptr[0]) {
+        case EFI_ACPI_6_0_PROCESSOR_LOCAL_APIC:
+            return Ptr[1] >= sizeof(EFI_ACPI_6_0_PROCESSOR_LOCAL_APIC_STRUCTURE);
+        case EFI_ACPI_6_0_IO_APIC:
+            return Ptr[1] >= sizeof(EFI_ACPI_6_0_IO_APIC_STRUCTURE);
+        case EFI_ACPI_6_0_INTERRUPT_SOURCE_OVERRIDE:
+            return Ptr[1] >= sizeof(EFI_ACPI_6_0_INTERRUPT_SOURCE_OVERRIDE_STRUCTURE);
+        case EFI_ACPI_6_0_NON_MASKABLE_INTERRUPT_SOURCE:
+            return Ptr[1] >= sizeof(EFI_ACPI_6_0_NON_MASKABLE_INTERRUPT_SOURCE_STRUCTURE);
+        case EFI_ACPI_6_0_LOCAL_APIC_NMI:
+            return Ptr[1] >= sizeof(EFI_ACPI_6_0_LOCAL_APIC_NMI_STRUCTURE);
+        case EFI_ACPI_6_0_LOCAL_APIC_ADDRESS_OVERRIDE:
+            return Ptr[1] >= sizeof(EFI_ACPI_6_0_LOCAL_APIC_ADDRESS_OVERRIDE_STRUCTURE);
+        case EFI_ACPI_6_0_PROCESSOR_LOCAL_X2APIC:
+            return Ptr[1] >= sizeof(EFI_ACPI_6_0_PROCESSOR_LOCAL_X2APIC_STRUCTURE);
+        case EFI_ACPI_6_0_LOCAL_X2APIC_NMI:
+            return Ptr[1] >= sizeof(EFI_ACPI_6_0_LOCAL_X2APIC_NMI_STRUCTURE);
+        case EFI_ACPI_6_0_GIC:
+            return Ptr[1] >= GICC_MIN_LENGTH;
+        case EFI_ACPI_6_0_GICD:
+            return Ptr[1] >= sizeof(EFI_ACPI_6_0_GIC_DISTRIBUTOR_STRUCTURE);
+        case EFI_ACPI_6_0_GIC_MSI_FRAME:
+            return Ptr[1] >= sizeof(EFI_ACPI_6_0_GIC_MSI_FRAME_STRUCTURE);
+        case EFI_ACPI_6_0_GICR:
+            return Ptr[1] >= sizeof(EFI_ACPI_6_0_GICR_STRUCTURE);
+        case EFI_ACPI_6_0_GIC_ITS:
+            return Ptr[1] >= sizeof(EFI_ACPI_6_0_GIC_ITS_STRUCTURE);
+        default:
+            return FALSE;
+    }
+}
+
+
+static VOID
+PrintStructure( UINT8 *Ptr )
+{
+    EFI_ACPI_6_0_PROCESSOR_LOCAL_APIC_STRUCTURE *LocalApic;
+    EFI_ACPI_6_0_PROCESSOR_LOCAL_X2APIC_STRUCTURE *X2Apic;
+    EFI_ACPI_6_0_IO_APIC_STRUCTURE *IoApic;
+    EFI_ACPI_6_0_INTERRUPT_SOURCE_OVERRIDE_STRUCTURE *Override;
+    EFI_ACPI_6_0_NON_MASKABLE_INTERRUPT_SOURCE_STRUCTURE *NmiSource;
+    EFI_ACPI_6_0_LOCAL_APIC_NMI_STRUCTURE *Nmi;
+    EFI_ACPI_6_0_LOCAL_X2APIC_NMI_STRUCTURE *X2Nmi;
+    EFI_ACPI_6_0_LOCAL_APIC_ADDRESS_OVERRIDE_STRUCTURE *AddressOverride;
+    EFI_ACPI_6_0_GIC_STRUCTURE *Gicc;
+    EFI_ACPI_6_0_GIC_DISTRIBUTOR_STRUCTURE *Gicd;
+    EFI_ACPI_6_0_GIC_MSI_FRAME_STRUCTURE *MsiFrame;
+    EFI_ACPI_6_0_GICR_STRUCTURE *Gicr;
+    EFI_ACPI_6_0_GIC_ITS_STRUCTURE *Its;
+
+    OutputPrint(L"  %-27s", StructureTypeStr(Ptr[0]));
+    if (!StructureKnown(Ptr)) {
+        OutputPrint(L"  Type: %d  Length: %d\n", Ptr[0], Ptr[1]);
+        return;
+    }
+
+    switch (Ptr[0]) {
+        case EFI_ACPI_6_0_PROCESSOR_LOCAL_APIC:
+            LocalApic = (EFI_ACPI_6_0_PROCESSOR_LOCAL_APIC_STRUCTURE *)Ptr;
+            OutputPrint(L"  UID: %3d  APIC ID: %3d  %s", LocalApic->AcpiProcessorUid, LocalApic->ApicId,
+                        ProcessorStateStr(LocalApic->Flags));
+            break;
+        case EFI_ACPI_6_0_PROCESSOR_LOCAL_X2APIC:
+            X2Apic = (EFI_ACPI_6_0_PROCESSOR_LOCAL_X2APIC_STRUCTURE *)Ptr;
+            OutputPrint(L"  UID: %3d  x2APIC ID: 0x%x  %s", X2Apic->AcpiProcessorUid, X2Apic->X2ApicId,
+                        ProcessorStateStr(X2Apic->Flags));
+            break;
+        case EFI_ACPI_6_0_IO_APIC:
+            IoApic = (EFI_ACPI_6_0_IO_APIC_STRUCTURE *)Ptr;
+            OutputPrint(L"  ID: %3d  Address: 0x%08x  GSI Base: %d", IoApic->IoApicId,
+                        IoApic->IoApicAddress, IoApic->GlobalSystemInterruptBase);
+            break;
+        case EFI_ACPI_6_0_INTERRUPT_SOURCE_OVERRIDE:
+            Override = (EFI_ACPI_6_0_INTERRUPT_SOURCE_OVERRIDE_STRUCTURE *)Ptr;
+            OutputPrint(L"  Bus: %d  IRQ: %2d  GSI: %2d  Flags: 0x%04x", Override->Bus, Override->Source,
+                        Override->GlobalSystemInterrupt, Override->Flags);
+            break;
+        case EFI_ACPI_6_0_NON_MASKABLE_INTERRUPT_SOURCE:
+            NmiSource = (EFI_ACPI_6_0_NON_MASKABLE_INTERRUPT_SOURCE_STRUCTURE *)Ptr;
+            OutputPrint(L"  GSI: %d  Flags: 0x%04x", NmiSource->GlobalSystemInterrupt, NmiSource->Flags);
+            break;
+        case EFI_ACPI_6_0_LOCAL_APIC_NMI:
+            Nmi = (EFI_ACPI_6_0_LOCAL_APIC_NMI_STRUCTURE *)Ptr;
+            OutputPrint(L"  UID: 0x%02x  LINT%d  Flags: 0x%04x", Nmi->AcpiProcessorUid, Nmi->LocalApicLint, Nmi->Flags);
+            break;
+        case EFI_ACPI_6_0_LOCAL_X2APIC_NMI:
+            X2Nmi = (EFI_ACPI_6_0_LOCAL_X2APIC_NMI_STRUCTURE *)Ptr;
+            OutputPrint(L"  UID: 0x%08x  LINT%d  Flags: 0x%04x", X2Nmi->AcpiProcessorUid, X2Nmi->LocalX2ApicLint, X2Nmi->Flags);
+            break;
+        case EFI_ACPI_6_0_LOCAL_APIC_ADDRESS_OVERRIDE:
+            AddressOverride = (EFI_ACPI_6_0_LOCAL_APIC_ADDRESS_OVERRIDE_STRUCTURE *)Ptr;
+            OutputPrint(L"  Address: 0x%016lx", AddressOverride->LocalApicAddress);
+            break;
+        case EFI_ACPI_6_0_GIC:
+            Gicc = (EFI_ACPI_6_0_GIC_STRUCTURE *)Ptr;
+            OutputPrint(L"  UID: %3d  CPU Interface: %3d  MPIDR: 0x%010lx  %s", Gicc->AcpiProcessorUid,
+                        Gicc->CPUInterfaceNumber, Gicc->MPIDR,
+                        (Gicc->Flags & EFI_ACPI_6_0_GIC_ENABLED) ? L"Enabled" : L"Disabled");
+            break;
+        case EFI_ACPI_6_0_GICD:
+            Gicd = (EFI_ACPI_6_0_GIC_DISTRIBUTOR_STRUCTURE *)Ptr;
+            OutputPrint(L"  ID: %d  Address: 0x%016lx  GICv%d", Gicd->GicId, Gicd->PhysicalBaseAddress, Gicd->GicVersion);
+            break;
+        case EFI_ACPI_6_0_GIC_MSI_FRAME:
+            MsiFrame = (EFI_ACPI_6_0_GIC_MSI_FRAME_STRUCTURE *)Ptr;
+            OutputPrint(L"  ID: %d  Address: 0x%016lx  SPIs: %d-%d", MsiFrame->GicMsiFrameId, MsiFrame->PhysicalBaseAddress,
+                        MsiFrame->SPIBase, MsiFrame->SPIBase + MsiFrame->SPICount - 1);
+            break;
+        case EFI_ACPI_6_0_GICR:
+            Gicr = (EFI_ACPI_6_0_GICR_STRUCTURE *)Ptr;
+            OutputPrint(L"  Address: 0x%016lx  Length: 0x%x", Gicr->DiscoveryRangeBaseAddress, Gicr->DiscoveryRangeLength);
+            break;
+        case EFI_ACPI_6_0_GIC_ITS:
+            Its = (EFI_ACPI_6_0_GIC_ITS_STRUCTURE *)Ptr;
+            OutputPrint(L"  ID: %d  Address: 0x%016lx", Its->GicItsId, Its->PhysicalBaseAddress);
+            break;
+    }
+    OutputPrint(L"\n");
+}
+
+
+static VOID
+JsonStructure( UINT8 *Ptr )
+{
+    EFI_ACPI_6_0_PROCESSOR_LOCAL_APIC_STRUCTURE *LocalApic;
+    EFI_ACPI_6_0_PROCESSOR_LOCAL_X2APIC_STRUCTURE *X2Apic;
+    EFI_ACPI_6_0_IO_APIC_STRUCTURE *IoApic;
+    EFI_ACPI_6_0_INTERRUPT_SOURCE_OVERRIDE_STRUCTURE *Override;
+    EFI_ACPI_6_0_NON_MASKABLE_INTERRUPT_SOURCE_STRUCTURE *NmiSource;
+    EFI_ACPI_6_0_LOCAL_APIC_NMI_STRUCTURE *Nmi;
+    EFI_ACPI_6_0_LOCAL_X2APIC_NMI_STRUCTURE *X2Nmi;
+    EFI_ACPI_6_0_LOCAL_APIC_ADDRESS_OVERRIDE_STRUCTURE *AddressOverride;
+    EFI_ACPI_6_0_GIC_STRUCTURE *Gicc;
+    EFI_ACPI_6_0_GIC_DISTRIBUTOR_STRUCTURE *Gicd;
+    EFI_ACPI_6_0_GIC_MSI_FRAME_STRUCTURE *MsiFrame;
+    EFI_ACPI_6_0_GICR_STRUCTURE *Gicr;
+    EFI_ACPI_6_0_GIC_ITS_STRUCTURE *Its;
+
+    JsonObjectBegin(NULL);
+    JsonUint(L"type", Ptr[0]);
+    JsonString(L"name", StructureTypeStr(Ptr[0]));
+    JsonUint(L"length", Ptr[1]);
+    if (!StructureKnown(Ptr)) {
+        JsonObjectEnd();
+        return;
+    }
+
+    switch (Ptr[0]) {
+        case EFI_ACPI_6_0_PROCESSOR_LOCAL_APIC:
+            LocalApic = (EFI_ACPI_6_0_PROCESSOR_LOCAL_APIC_STRUCTURE *)Ptr;
+            JsonUint(L"processorUid", LocalApic->AcpiProcessorUid);
+            JsonUint(L"apicId", LocalApic->ApicId);
+            JsonBool(L"enabled", (LocalApic->Flags & EFI_ACPI_6_0_LOCAL_APIC_ENABLED) != 0);
+            JsonBool(L"onlineCapable", (LocalApic->Flags & MADT_ONLINE_CAPABLE) != 0);
+            break;
+        case EFI_ACPI_6_0_PROCESSOR_LOCAL_X2APIC:
+            X2Apic = (EFI_ACPI_6_0_PROCESSOR_LOCAL_X2APIC_STRUCTURE *)Ptr;
+            JsonUint(L"processorUid", X2Apic->AcpiProcessorUid);
+            JsonUint(L"x2ApicId", X2Apic->X2ApicId);
+            JsonBool(L"enabled", (X2Apic->Flags & EFI_ACPI_6_0_LOCAL_APIC_ENABLED) != 0);
+            JsonBool(L"onlineCapable", (X2Apic->Flags & MADT_ONLINE_CAPABLE) != 0);
+            break;
+        case EFI_ACPI_6_0_IO_APIC:
+            IoApic = (EFI_ACPI_6_0_IO_APIC_STRUCTURE *)Ptr;
+            JsonUint(L"ioApicId", IoApic->IoApicId);
+            JsonHex(L"address", IoApic->IoApicAddress);
+            JsonUint(L"gsiBase", IoApic->GlobalSystemInterruptBase);
+            break;
+        case EFI_ACPI_6_0_INTERRUPT_SOURCE_OVERRIDE:
+            Override = (EFI_ACPI_6_0_INTERRUPT_SOURCE_OVERRIDE_STRUCTURE *)Ptr;
+            JsonUint(L"bus", Override->Bus);
+            JsonUint(L"source", Override->Source);
+            JsonUint(L"gsi", Override->GlobalSystemInterrupt);
+            JsonHex(L"flags", Override->Flags);
+            break;
+        case EFI_ACPI_6_0_NON_MASKABLE_INTERRUPT_SOURCE:
+            NmiSource = (EFI_ACPI_6_0_NON_MASKABLE_INTERRUPT_SOURCE_STRUCTURE *)Ptr;
+            JsonUint(L"gsi", NmiSource->GlobalSystemInterrupt);
+            JsonHex(L"flags", NmiSource->Flags);
+            break;
+        case EFI_ACPI_6_0_LOCAL_APIC_NMI:
+            Nmi = (EFI_ACPI_6_0_LOCAL_APIC_NMI_STRUCTURE *)Ptr;
+            JsonUint(L"processorUid", Nmi->AcpiProcessorUid);
+            JsonUint(L"lint", Nmi->LocalApicLint);
+            JsonHex(L"flags", Nmi->Flags);
+            break;
+        case EFI_ACPI_6_0_LOCAL_X2APIC_NMI:
+            X2Nmi = (EFI_ACPI_6_0_LOCAL_X2APIC_NMI_STRUCTURE *)Ptr;
+            JsonUint(L"processorUid", X2Nmi->AcpiProcessorUid);
+            JsonUint(L"lint", X2Nmi->LocalX2ApicLint);
+            JsonHex(L"flags", X2Nmi->Flags);
+            break;
+        case EFI_ACPI_6_0_LOCAL_APIC_ADDRESS_OVERRIDE:
+            AddressOverride = (EFI_ACPI_6_0_LOCAL_APIC_ADDRESS_OVERRIDE_STRUCTURE *)Ptr;
+            JsonHex(L"address", AddressOverride->LocalApicAddress);
+            break;
+        case EFI_ACPI_6_0_GIC:
+            Gicc = (EFI_ACPI_6_0_GIC_STRUCTURE *)Ptr;
+            JsonUint(L"processorUid", Gicc->AcpiProcessorUid);
+            JsonUint(L"cpuInterface", Gicc->CPUInterfaceNumber);
+            JsonHex(L"mpidr", Gicc->MPIDR);
+            JsonHex(L"address", Gicc->PhysicalBaseAddress);
+            JsonHex(L"gicrAddress", Gicc->GICRBaseAddress);
+            JsonBool(L"enabled", (Gicc->Flags & EFI_ACPI_6_0_GIC_ENABLED) != 0);
+            break;
+        case EFI_ACPI_6_0_GICD:
+            Gicd = (EFI_ACPI_6_0_GIC_DISTRIBUTOR_STRUCTURE *)Ptr;
+            JsonUint(L"gicId", Gicd->GicId);
+            JsonHex(L"address", Gicd->PhysicalBaseAddress);
+            JsonUint(L"systemVectorBase", Gicd->SystemVectorBase);
+            JsonUint(L"gicVersion", Gicd->GicVersion);
+            break;
+        case EFI_ACPI_6_0_GIC_MSI_FRAME:
+            MsiFrame = (EFI_ACPI_6_0_GIC_MSI_FRAME_STRUCTURE *)Ptr;
+            JsonUint(L"frameId", MsiFrame->GicMsiFrameId);
+            JsonHex(L"address", MsiFrame->PhysicalBaseAddress);
+            JsonUint(L"spiBase", MsiFrame->SPIBase);
+            JsonUint(L"spiCount", MsiFrame->SPICount);
+            break;
+        case EFI_ACPI_6_0_GICR:
+            Gicr = (EFI_ACPI_6_0_GICR_STRUCTURE *)Ptr;
+            JsonHex(L"address", Gicr->DiscoveryRangeBaseAddress);
+            JsonUint(L"rangeLength", Gicr->DiscoveryRangeLength);
+            break;
+        case EFI_ACPI_6_0_GIC_ITS:
+            Its = (EFI_ACPI_6_0_GIC_ITS_STRUCTURE *)Ptr;
+            JsonUint(L"itsId", Its->GicItsId);
+            JsonHex(L"address", Its->PhysicalBaseAddress);
+            break;
+    }
+    JsonObjectEnd();
+}
+
+
+static MADT_PROCESSOR *
+FindProcessor( UINT64 Id )
+{
+    for (UINTN i = 0; i < ProcessorCount; i++) {
+        if (Processors[i].Id == Id) {
+            return &Processors[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+//
+// Compare the MADT processor entries with the processors MP Services
+// started.  Entries that are disabled or only online capable usually
+// mean cores or SMT threads were turned off in firmware setup.
+//
+static VOID
+CheckProcessors( BOOLEAN Json )
+{
+    EFI_MP_SERVICES_PROTOCOL *MpServices = NULL;
+    EFI_PROCESSOR_INFORMATION Info;
+    MADT_PROCESSOR *Cpu;
+    EFI_STATUS Status;
+    UINTN Count[3] = { 0, 0, 0 };
+    UINTN Total = 0;
+    UINTN Enabled = 0;
+    UINTN Packages = 0;
+    UINTN Cores = 0;
+    UINTN Threads = 0;
+
+    for (UINTN i = 0; i < ProcessorCount; i++) {
+        Count[Processors[i].State]++;
+    }
+
+    Status = gBS->LocateProtocol( &gEfiMpServiceProtocolGuid,
+                                  NULL,
+                                  (VOID **) &MpServices );
+    if (!EFI_ERROR(Status)) {
+        Status = MpServices->GetNumberOfProcessors( MpServices, &Total, &Enabled );
+    }
+    if (EFI_ERROR(Status)) {
+        MpServices = NULL;
+    }
+
+    // firmware numbers packages, cores and threads from zero
+    if (MpServices != NULL) {
+        for (UINTN i = 0; i < Total; i++) {
+            if (EFI_ERROR(MpServices->GetProcessorInfo( MpServices, i, &Info ))) {
+                continue;
+            }
+            if (Info.Location.Thread == 0) {
+                Cores++;
+                if (Info.Location.Core == 0) {
+                    Packages++;
+                }
+            }
+            if (Info.Location.Thread + 1 > Threads) {
+                Threads = Info.Location.Thread + 1;
+            }
+        }
+    }
+
+    if (Json) {
+        JsonObjectBegin(L"processors");
+        JsonUint(L"enabled", Count[CPU_ENABLED]);
+        JsonUint(L"onlineCapable", Count[CPU_ONLINE_CAPABLE]);
+        JsonUint(L"disabled", Count[CPU_DISABLED]);
+        JsonObjectEnd();
+        if (MpServices != NULL) {
+            JsonObjectBegin(L"mpServices");
+            JsonUint(L"processors", Total);
+            JsonUint(L"enabled", Enabled);
+            JsonUint(L"packages", Packages);
+            JsonUint(L"cores", Cores);
+            JsonUint(L"threadsPerCore", Threads);
+            JsonObjectEnd();
+        } else {
+            JsonNull(L"mpServices");
+        }
+        JsonArrayBegin(L"mismatches");
+    } else {
+        OutputPrint(L"\n  Processors  : %d enabled, %d online capable, %d disabled\n",
+                    Count[CPU_ENABLED], Count[CPU_ONLINE_CAPABLE], Count[CPU_DISABLED]);
+        if (MpServices != NULL) {
+            OutputPrint(L"  MP Services : %d processors, %d enabled, %d packages, %d cores, %d threads per core\n",
+                        Total, Enabled, Packages, Cores, Threads);
+        } else {
+            OutputPrint(L"  MP Services : not available\n");
+        }
+    }
+
+    // firmware often pads the table with disabled placeholder entries
+    // that share an ID (0xFF, say), so only usable entries must be unique
+    for (UINTN i = 0; i < ProcessorCount; i++) {
+        if (Processors[i].State == CPU_DISABLED) {
+            continue;
+        }
+        for (UINTN j = 0; j < i; j++) {
+            if (Processors[j].State != CPU_DISABLED && Processors[j].Id == Processors[i].Id) {
+                DecodeWarning(Json, L"Processor ID 0x%lx is listed more than once", Processors[i].Id);
+                break;
+            }
+        }
+    }
+    if (DroppedProcessors > 0) {
+        DecodeWarning(Json, L"%d processor entries beyond %d not checked", DroppedProcessors, MADT_MAX_PROCESSORS);
+    }
+
+    if (MpServices != NULL) {
+        if (Total != Count[CPU_ENABLED]) {
+            DecodeWarning(Json, L"MP Services reports %d processors, MADT enables %d", Total, Count[CPU_ENABLED]);
+        }
+        if (Enabled < Total) {
+            DecodeWarning(Json, L"%d of %d processors are disabled in MP Services", Total - Enabled, Total);
+        }
+        for (UINTN i = 0; i < Total; i++) {
+            if (EFI_ERROR(MpServices->GetProcessorInfo( MpServices, i, &Info ))) {
+                DecodeWarning(Json, L"No information for processor %d", i);
+                continue;
+            }
+            Cpu = FindProcessor(Info.ProcessorId);
+            if (Cpu == NULL) {
+                DecodeWarning(Json, L"Processor ID 0x%lx has no MADT entry", Info.ProcessorId);
+            } else {
+                Cpu->Started = TRUE;
+                if (Cpu->State != CPU_ENABLED) {
+                    DecodeWarning(Json, L"Processor ID 0x%lx is running but not enabled in MADT", Info.ProcessorId);
+                }
+            }
+            if (!(Info.StatusFlag & PROCESSOR_HEALTH_STATUS_BIT)) {
+                DecodeWarning(Json, L"Processor ID 0x%lx failed its health check", Info.ProcessorId);
+            }
+        }
+        for (UINTN i = 0; i < ProcessorCount; i++) {
+            if (Processors[i].State == CPU_ENABLED && !Processors[i].Started) {
+                DecodeWarning(Json, L"Processor ID 0x%lx is enabled in MADT but was not started", Processors[i].Id);
+            }
+        }
+    }
+
+    if (Count[CPU_ONLINE_CAPABLE] + Count[CPU_DISABLED] > 0) {
+        DecodeWarning(Json, L"%d processors not enabled; cores or SMT may be disabled in setup",
+                 Count[CPU_ONLINE_CAPABLE] + Count[CPU_DISABLED]);
+    }
+
+    if (Json) {
+        JsonArrayEnd();
+    }
+}
+
+
+VOID
+DecodeMADT( EFI_ACPI_DESCRIPTION_HEADER *Table,
+            BOOLEAN Json )
+{
+    EFI_ACPI_6_0_MULTIPLE_APIC_DESCRIPTION_TABLE_HEADER *Madt = (EFI_ACPI_6_0_MULTIPLE_APIC_DESCRIPTION_TABLE_HEADER *)Table;
+    UINT8 *Ptr;
+    UINT8 *End;
+    UINT8 *Bad = NULL;
+
+    if (InternalTooShort(Table, sizeof(EFI_ACPI_6_0_MULTIPLE_APIC_DESCRIPTION_TABLE_HEADER), Json)) {
+        return;
+    }
+    ProcessorCount = 0;
+    DroppedProcessors = 0;
+
+    if (Json) {
+        JsonHex(L"localApicAddress", Madt->LocalApicAddress);
+        JsonHex(L"flags", Madt->Flags);
+        JsonBool(L"pcatCompat", (Madt->Flags & EFI_ACPI_6_0_PCAT_COMPAT) != 0);
+        JsonArrayBegin(L"structures");
+    } else {
+        OutputPrint(L"  Local APIC Address : 0x%08x\n", Madt->LocalApicAddress);
+        OutputPrint(L"  Flags              : 0x%08x%s\n", Madt->Flags,
+                    (Madt->Flags & EFI_ACPI_6_0_PCAT_COMPAT) ? L" (PC-AT compatible)" : L"");
+    }
+
+    Ptr = (UINT8 *)(Madt + 1);
+    End = (UINT8 *)Table + Table->Length;
+    while (Ptr + 2 <= End) {
+        // a zero length structure would loop forever; one running past
+        // the end of the table would be read out of bounds
+        if (Ptr[1] < 2 || Ptr + Ptr[1] > End) {
+            Bad = Ptr;
+            break;
+        }
+        if (Json) {
+            JsonStructure(Ptr);
+        } else {
+            PrintStructure(Ptr);
+        }
+        if (StructureKnown(Ptr)) {
+            AddProcessor(Ptr);
+        }
+        Ptr += Ptr[1];
+    }
+
+    if (Json) {
+        JsonArrayEnd();
+        if (Bad != NULL) {
+            JsonPrint(L"error", L"Bad structure length %d at offset %d", Bad[1], Bad - (UINT8 *)Table);
+        }
+    } else if (Bad != NULL) {
+        OutputPrint(L"  ERROR: Bad structure length %d at offset %d\n", Bad[1], Bad - (UINT8 *)Table);
+    }
+
+    CheckProcessors(Json);
+}
@@ -0,0 +1,83 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Decoder for the MCFG (PCI Express ECAM regions)
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+
+#include <IndustryStandard/MemoryMappedConfigurationSpaceAccessTable.h>
+
+#include "AcpiTableDecodeInternal.h"
+
+typedef EFI_ACPI_MEMORY_MAPPED_CONFIGURATION_BASE_ADDRESS_TABLE_HEADER MCFG_HEADER;
+typedef EFI_ACPI_MEMORY_MAPPED_ENHANCED_CONFIGURATION_SPACE_BASE_ADDRESS_ALLOCATION_STRUCTURE MCFG_ALLOCATION;
+
+
+VOID
+DecodeMCFG( EFI_ACPI_DESCRIPTION_HEADER *Table,
+            BOOLEAN Json )
+{
+    MCFG_ALLOCATION *Alloc;
+    UINTN Count;
+    UINT64 Size;
+
+    if (InternalTooShort(Table, sizeof(MCFG_HEADER), Json)) {
+        return;
+    }
+    Alloc = (MCFG_ALLOCATION *)((UINT8 *)Table + sizeof(MCFG_HEADER));
+    Count = (Table->Length - sizeof(MCFG_HEADER)) / sizeof(MCFG_ALLOCATION);
+
+    if (Json) {
+        JsonArrayBegin(L"allocations");
+    } else {
+        OutputPrint(L"  Segment  Buses    Base Address        Size\n");
+    }
+
+    for (UINTN i = 0; i < Count; i++, Alloc++) {
+        // a reversed bus range would wrap the size computation below
+        if (Alloc->EndBusNumber < Alloc->StartBusNumber) {
+            if (Json) {
+                JsonObjectBegin(NULL);
+                JsonUint(L"segment", Alloc->PciSegmentGroupNumber);
+                JsonUint(L"startBus", Alloc->StartBusNumber);
+                JsonUint(L"endBus", Alloc->EndBusNumber);
+                JsonHex(L"baseAddress", Alloc->BaseAddress);
+                JsonPrint(L"error", L"End bus %02x is below start bus %02x",
+                          Alloc->EndBusNumber, Alloc->StartBusNumber);
+                JsonObjectEnd();
+            } else {
+                OutputPrint(L"  %7d  %02x-%02x    0x%016lx  ERROR: end bus is below start bus\n",
+                            Alloc->PciSegmentGroupNumber, Alloc->StartBusNumber,
+                            Alloc->EndBusNumber, Alloc->BaseAddress);
+            }
+            continue;
+        }
+
+        // 1 MB of configuration space per bus
+        Size = LShiftU64((UINT64)(Alloc->EndBusNumber - Alloc->StartBusNumber) + 1, 20);
+        if (Json) {
+            JsonObjectBegin(NULL);
+            JsonUint(L"segment", Alloc->PciSegmentGroupNumber);
+            JsonUint(L"startBus", Alloc->StartBusNumber);
+            JsonUint(L"endBus", Alloc->EndBusNumber);
+            JsonHex(L"baseAddress", Alloc->BaseAddress);
+            JsonUint(L"size", Size);
+            JsonObjectEnd();
+        } else {
+            OutputPrint(L"  %7d  %02x-%02x    0x%016lx  %ld MB\n", Alloc->PciSegmentGroupNumber,
+                        Alloc->StartBusNumber, Alloc->EndBusNumber, Alloc->BaseAddress,
+                        RShiftU64(Size, 20));
+        }
+    }
+
+    if (Json) {
+        JsonArrayEnd();
+    }
+}
+
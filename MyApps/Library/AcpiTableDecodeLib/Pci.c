@@ -0,0 +1,411 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  PCI configuration space access for the IOMMU decoders.
+//  Functions are found through the PCI Root Bridge I/O protocol the
+//  same way ShowPCIx enumerates them.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+
+#include <Protocol/PciRootBridgeIo.h>
+#include <IndustryStandard/Pci.h>
+
+#include "AcpiTableDecodeInternal.h"
+
+#define MAX_ROOT_BRIDGES  32
+
+typedef struct {
+    EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL *IoDev;
+    UINT16  MinBus;
+    UINT16  MaxBus;
+} ROOT_BRIDGE;
+
+STATIC ROOT_BRIDGE RootBridges[MAX_ROOT_BRIDGES];
+STATIC UINTN       RootBridgeCount;
+STATIC BOOLEAN     RootBridgesFound = FALSE;
+
+
+//
+// One entry per bus range of every root bridge.  A root bridge that
+// cannot report its resources is assumed to decode all buses.
+//
+static VOID
+FindRootBridges( VOID )
+{
+    EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL *IoDev;
+    EFI_ACPI_ADDRESS_SPACE_DESCRIPTOR *Descriptors;
+    EFI_HANDLE *HandleBuf = NULL;
+    EFI_STATUS Status;
+    UINTN HandleCount = 0;
+
+    RootBridgesFound = TRUE;
+    RootBridgeCount = 0;
+
+    Status = gBS->LocateHandleBuffer( ByProtocol,
+                                      &gEfiPciRootBridgeIoProtocolGuid,
+                                      NULL,
+                                      &HandleCount,
+                                      &HandleBuf );
+    if (EFI_ERROR(Status)) {
+        return;
+    }
+
+    for (UINTN i = 0; i < HandleCount; i++) {
+        Status = gBS->HandleProtocol( HandleBuf[i],
+                                      &gEfiPciRootBridgeIoProtocolGuid,
+                                      (VOID **) &IoDev );
+        if (EFI_ERROR(Status)) {
+            continue;
+        }
+        Status = IoDev->Configuration( IoDev, (VOID **) &Descriptors );
+        if (EFI_ERROR(Status) || Descriptors == NULL) {
+            if (RootBridgeCount < MAX_ROOT_BRIDGES) {
+                RootBridges[RootBridgeCount].IoDev = IoDev;
+                RootBridges[RootBridgeCount].MinBus = 0;
+                RootBridges[RootBridgeCount].MaxBus = PCI_MAX_BUS;
+                RootBridgeCount++;
+            }
+            continue;
+        }
+        for (; Descriptors->Desc != ACPI_END_TAG_DESCRIPTOR; Descriptors++) {
+            if (Descriptors->ResType == ACPI_ADDRESS_SPACE_TYPE_BUS && RootBridgeCount < MAX_ROOT_BRIDGES) {
+                RootBridges[RootBridgeCount].IoDev = IoDev;
+                RootBridges[RootBridgeCount].MinBus = (UINT16) Descriptors->AddrRangeMin;
+                RootBridges[RootBridgeCount].MaxBus = (UINT16) Descriptors->AddrRangeMax;
+                RootBridgeCount++;
+            }
+        }
+    }
+
+    FreePool(HandleBuf);
+}
+
+
+static EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL *
+RootBridge( UINT16 Segment,
+            UINT8 Bus )
+{
+    if (!RootBridgesFound) {
+        FindRootBridges();
+    }
+
+    for (UINTN i = 0; i < RootBridgeCount; i++) {
+        if (RootBridges[i].IoDev->SegmentNumber == Segment &&
+            Bus >= RootBridges[i].MinBus && Bus <= RootBridges[i].MaxBus) {
+            return RootBridges[i].IoDev;
+        }
+    }
+
+    return NULL;
+}
+
+
+static BOOLEAN
+PciRead( UINT16 Segment,
+         UINT8 Bus,
+         UINT8 Device,
+         UINT8 Function,
+         UINT8 Offset,
+         UINTN Count,
+         VOID *Buffer )
+{
+    EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL *IoDev = RootBridge(Segment, Bus);
+
+    if (IoDev == NULL || Device > PCI_MAX_DEVICE || Function > PCI_MAX_FUNC) {
+        return FALSE;
+    }
+
+    return !EFI_ERROR(IoDev->Pci.Read( IoDev,
+                                       EfiPciWidthUint8,
+                                       EFI_PCI_ADDRESS(Bus, Device, Function, Offset),
+                                       Count,
+                                       Buffer ));
+}
+
+
+//
+// Fill in Pci for the function at Segment:Bus:Device.Function.
+// Returns TRUE if a function answers at that address.
+//
+BOOLEAN
+PciFunctionRead( UINT16 Segment,
+                 UINT8 Bus,
+                 UINT8 Device,
+                 UINT8 Function,
+                 PCI_FUNCTION *Pci )
+{
+    PCI_DEVICE_INDEPENDENT_REGION Header;
+
+    ZeroMem(Pci, sizeof(PCI_FUNCTION));
+    Pci->Segment = Segment;
+    Pci->Bus = Bus;
+    Pci->Device = Device;
+    Pci->Function = Function;
+
+    if (!PciRead(Segment, Bus, Device, Function, 0, sizeof(Header), &Header) || Header.VendorId == 0xffff) {
+        return FALSE;
+    }
+
+    Pci->Present = TRUE;
+    Pci->VendorId = Header.VendorId;
+    Pci->DeviceId = Header.DeviceId;
+    CopyMem(Pci->ClassCode, Header.ClassCode, sizeof(Pci->ClassCode));
+    Pci->HeaderType = Header.HeaderType;
+
+    return TRUE;
+}
+
+
+//
+// Secondary and subordinate bus numbers of a PCI-to-PCI bridge
+//
+BOOLEAN
+PciBridgeBuses( PCI_FUNCTION *Bridge,
+                UINT8 *Secondary,
+                UINT8 *Subordinate )
+{
+    UINT8 Buses[2];
+
+    if (!Bridge->Present || (Bridge->HeaderType & HEADER_LAYOUT_CODE) != HEADER_TYPE_PCI_TO_PCI_BRIDGE) {
+        return FALSE;
+    }
+    if (!PciRead( Bridge->Segment, Bridge->Bus, Bridge->Device, Bridge->Function,
+                  PCI_BRIDGE_SECONDARY_BUS_REGISTER_OFFSET, sizeof(Buses), Buses )) {
+        return FALSE;
+    }
+    *Secondary = Buses[0];
+    *Subordinate = Buses[1];
+
+    return TRUE;
+}
+
+
+//
+// Present functions with requester IDs (bus << 8 | device << 3 | function)
+// from First to Last inclusive.  Returns the number found, which may be
+// more than Max; only the first Max are stored.
+//
+UINTN
+PciFunctionsInRange( UINT16 Segment,
+                     UINT16 First,
+                     UINT16 Last,
+                     PCI_FUNCTION *Functions,
+                     UINTN Max )
+{
+    PCI_FUNCTION Pci;
+    UINTN Found = 0;
+    UINT32 Rid = First;
+
+    while (Rid <= Last) {
+        if (!PciFunctionRead(Segment, PCI_RID_BUS(Rid), PCI_RID_DEVICE(Rid), PCI_RID_FUNCTION(Rid), &Pci)) {
+            // no function 0 means no device; skip its other functions
+            Rid += (PCI_RID_FUNCTION(Rid) == 0) ? 8 : 1;
+            continue;
+        }
+        if (Found < Max) {
+            CopyMem(&Functions[Found], &Pci, sizeof(Pci));
+        }
+        Found++;
+        if (PCI_RID_FUNCTION(Rid) == 0 && !(Pci.HeaderType & HEADER_TYPE_MULTI_FUNCTION)) {
+            Rid += 8;
+        } else {
+            Rid++;
+        }
+    }
+
+    return Found;
+}
+
+
+static CHAR16 *
+PciClassStr( UINT8 BaseClass )
+{
+    switch (BaseClass) {
+        case 0x00: return L"Unclassified";
+        case 0x01: return L"Storage";
+        case 0x02: return L"Network";
+        case 0x03: return L"Display";
+        case 0x04: return L"Multimedia";
+        case 0x05: return L"Memory";
+        case 0x06: return L"Bridge";
+        case 0x07: return L"Communication";
+        case 0x08: return L"System peripheral";
+        case 0x0c: return L"Serial bus";
+        case 0x12: return L"Accelerator";
+        default:   return L"Other";
+    }
+}
+
+
+//
+// One line per function: address, vendor:device, class and a note
+//
+VOID
+PciFunctionPrint( CONST CHAR16 *Indent,
+                  PCI_FUNCTION *Pci,
+                  CONST CHAR16 *Note )
+{
+    OutputPrint(L"%s%04x:%02x:%02x.%x", Indent, Pci->Segment, Pci->Bus, Pci->Device, Pci->Function);
+    if (Pci->Present) {
+        OutputPrint(L"  %04x:%04x  %-13s", Pci->VendorId, Pci->DeviceId, PciClassStr(Pci->ClassCode[2]));
+    } else {
+        OutputPrint(L"  not present");
+    }
+    OutputPrint(L"%s%s\n", Note != NULL ? L"  " : L"", Note != NULL ? Note : L"");
+}
+
+
+//
+// Array element with the same member names as ShowPCIx
+//
+VOID
+PciFunctionJson( PCI_FUNCTION *Pci )
+{
+    JsonObjectBegin(NULL);
+    JsonUint(L"segment", Pci->Segment);
+    JsonUint(L"bus", Pci->Bus);
+    JsonUint(L"device", Pci->Device);
+    JsonUint(L"function", Pci->Function);
+    JsonBool(L"present", Pci->Present);
+    if (Pci->Present) {
+        JsonHex(L"vendorId", Pci->VendorId);
+        JsonHex(L"deviceId", Pci->DeviceId);
+        JsonPrint(L"classCode", L"%02x%02x%02x", Pci->ClassCode[2], Pci->ClassCode[1], Pci->ClassCode[0]);
+        JsonString(L"className", PciClassStr(Pci->ClassCode[2]));
+    }
+    JsonObjectEnd();
+}
+
+
+//
+// Every present function on one segment, for the catch-all remapping
+// units (a DMAR DRHD with INCLUDE_PCI_ALL, an IVRS "all" entry).  The
+// decoder claims the functions the other units name and lists the rest.
+//
+#define MAX_SEGMENT_FUNCTIONS  1024
+
+STATIC PCI_FUNCTION SegmentFunctions[MAX_SEGMENT_FUNCTIONS];
+STATIC BOOLEAN      SegmentClaimed[MAX_SEGMENT_FUNCTIONS];
+STATIC UINTN        SegmentCount;
+
+//
+// Returns the number of functions found, which may be more than are
+// held; only the first MAX_SEGMENT_FUNCTIONS take part
+//
+UINTN
+PciSegmentEnumerate( UINT16 Segment )
+{
+    UINTN Found = PciFunctionsInRange(Segment, 0, 0xffff, SegmentFunctions, MAX_SEGMENT_FUNCTIONS);
+
+    SegmentCount = MIN(Found, MAX_SEGMENT_FUNCTIONS);
+    ZeroMem(SegmentClaimed, sizeof(SegmentClaimed));
+
+    return Found;
+}
+
+
+//
+// Mark the functions with requester IDs First to Last as belonging to
+// another unit
+//
+VOID
+PciSegmentClaim( UINT16 First,
+                 UINT16 Last )
+{
+    UINT16 Rid;
+
+    for (UINTN i = 0; i < SegmentCount; i++) {
+        Rid = PCI_RID(SegmentFunctions[i].Bus, SegmentFunctions[i].Device, SegmentFunctions[i].Function);
+        if (Rid >= First && Rid <= Last) {
+            SegmentClaimed[i] = TRUE;
+        }
+    }
+}
+
+
+//
+// The next function from *Index on that no other unit claims, or NULL
+// when there are no more
+//
+PCI_FUNCTION *
+PciSegmentNextUnclaimed( UINTN *Index )
+{
+    while (*Index < SegmentCount) {
+        if (!SegmentClaimed[(*Index)++]) {
+            return &SegmentFunctions[*Index - 1];
+        }
+    }
+
+    return NULL;
+}
+
+
+//
+// Network functions behind the remapping unit being decoded, reported
+// together once its scopes or device entries are done
+//
+#define MAX_UNIT_NICS  32
+
+STATIC PCI_FUNCTION UnitNics[MAX_UNIT_NICS];
+STATIC UINTN        UnitNicCount;
+
+VOID
+PciNicReset( VOID )
+{
+    UnitNicCount = 0;
+}
+
+
+//
+// Note Pci if it is a network function
+//
+VOID
+PciNicAdd( PCI_FUNCTION *Pci )
+{
+    if (!Pci->Present || Pci->ClassCode[2] != PCI_CLASS_NETWORK) {
+        return;
+    }
+    if (UnitNicCount < MAX_UNIT_NICS) {
+        CopyMem(&UnitNics[UnitNicCount], Pci, sizeof(PCI_FUNCTION));
+    }
+    UnitNicCount++;
+}
+
+
+//
+// List the network functions noted since PciNicReset and return how
+// many there were
+//
+UINTN
+PciNicReport( CONST CHAR16 *Indent,
+              BOOLEAN Json )
+{
+    UINTN Listed = MIN(UnitNicCount, MAX_UNIT_NICS);
+
+    if (Json) {
+        JsonArrayBegin(L"networkFunctions");
+        for (UINTN i = 0; i < Listed; i++) {
+            PciFunctionJson(&UnitNics[i]);
+        }
+        JsonArrayEnd();
+    } else {
+        OutputPrint(L"%sNetwork functions: %d\n", Indent, UnitNicCount);
+        for (UINTN i = 0; i < Listed; i++) {
+            PciFunctionPrint(Indent, &UnitNics[i], NULL);
+        }
+        if (UnitNicCount > Listed) {
+            OutputPrint(L"%s... %d more\n", Indent, UnitNicCount - Listed);
+        }
+    }
+
+    return UnitNicCount;
+}
@@ -0,0 +1,619 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Decoder for the processor properties topology table (PPTT)
+//
+//  Lists the processor hierarchy and cache structures, then compares
+//  the caches firmware reports for a leaf processor with what CPUID
+//  reports for the processor the decoder runs on.  This assumes the cores
+//  are identical, which the identical implementation flag says.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/CpuCacheLib.h>
+
+#include "AcpiTableDecodeInternal.h"
+
+#define PPTT_TYPE_PROCESSOR      0
+#define PPTT_TYPE_CACHE          1
+#define PPTT_TYPE_ID             2
+
+// processor hierarchy node flags
+#define PPTT_PHYSICAL_PACKAGE    BIT0
+#define PPTT_PROCESSOR_ID_VALID  BIT1
+#define PPTT_THREAD              BIT2
+#define PPTT_LEAF                BIT3
+#define PPTT_IDENTICAL           BIT4
+
+// cache type structure flags
+#define PPTT_SIZE_VALID          BIT0
+#define PPTT_SETS_VALID          BIT1
+#define PPTT_WAYS_VALID          BIT2
+#define PPTT_ALLOCATION_VALID    BIT3
+#define PPTT_TYPE_VALID          BIT4
+#define PPTT_POLICY_VALID        BIT5
+#define PPTT_LINE_SIZE_VALID     BIT6
+
+#define PPTT_CACHE_TYPE(Attr)    (((Attr) >> 2) & 0x3)
+
+#define PPTT_MAX_DEPTH           16       // hierarchy levels followed before giving up
+#define PPTT_MAX_CACHES          16
+
+#pragma pack(1)
+typedef struct {
+    UINT8   Type;
+    UINT8   Length;
+    UINT16  Reserved;
+} PPTT_STRUCTURE_HEADER;
+
+typedef struct {
+    UINT8   Type;
+    UINT8   Length;
+    UINT16  Reserved;
+    UINT32  Flags;
+    UINT32  Parent;
+    UINT32  AcpiProcessorId;
+    UINT32  NumberOfPrivateResources;
+    // UINT32  PrivateResources[];
+} PPTT_PROCESSOR;
+
+typedef struct {
+    UINT8   Type;
+    UINT8   Length;
+    UINT16  Reserved;
+    UINT32  Flags;
+    UINT32  NextLevelOfCache;
+    UINT32  Size;
+    UINT32  NumberOfSets;
+    UINT8   Associativity;
+    UINT8   Attributes;
+    UINT16  LineSize;
+} PPTT_CACHE;
+#pragma pack()
+
+typedef struct {
+    PPTT_CACHE      *Cache;
+    UINTN           Sharing;              // leaf processors that reach it
+    UINT8           Level;
+} PPTT_CACHE_LEVEL;
+
+
+static CHAR16 *
+CacheTypeStr( PPTT_CACHE *Cache )
+{
+    if (!(Cache->Flags & PPTT_TYPE_VALID)) {
+        return L"Unknown";
+    }
+    switch (PPTT_CACHE_TYPE(Cache->Attributes)) {
+        case 0:  return L"Data";
+        case 1:  return L"Instruction";
+        default: return L"Unified";
+    }
+}
+
+
+//
+// CPU_CACHE_xxx type for a cache structure, 0 if not reported
+//
+static UINT8
+CacheType( PPTT_CACHE *Cache )
+{
+    if (!(Cache->Flags & PPTT_TYPE_VALID)) {
+        return 0;
+    }
+    switch (PPTT_CACHE_TYPE(Cache->Attributes)) {
+        case 0:  return CPU_CACHE_DATA;
+        case 1:  return CPU_CACHE_INSTRUCTION;
+        default: return CPU_CACHE_UNIFIED;
+    }
+}
+
+
+//
+// Structure at Offset from the start of the table, if it is of the
+// given type and lies wholly within the table
+//
+static VOID *
+StructureAt( EFI_ACPI_DESCRIPTION_HEADER *Table,
+             UINT32 Offset,
+             UINT8 Type )
+{
+    PPTT_STRUCTURE_HEADER *Header;
+
+    if (Offset < sizeof(EFI_ACPI_DESCRIPTION_HEADER) ||
+        Offset + sizeof(PPTT_STRUCTURE_HEADER) > Table->Length) {
+        return NULL;
+    }
+    Header = (PPTT_STRUCTURE_HEADER *)((UINT8 *)Table + Offset);
+    if (Header->Type != Type || Offset + Header->Length > Table->Length) {
+        return NULL;
+    }
+    if (Type == PPTT_TYPE_PROCESSOR && Header->Length < sizeof(PPTT_PROCESSOR)) {
+        return NULL;
+    }
+    if (Type == PPTT_TYPE_CACHE && Header->Length < sizeof(PPTT_CACHE)) {
+        return NULL;
+    }
+
+    return Header;
+}
+
+
+static UINT32
+OffsetOf( EFI_ACPI_DESCRIPTION_HEADER *Table,
+          VOID *Structure )
+{
+    return (UINT32)((UINT8 *)Structure - (UINT8 *)Table);
+}
+
+
+//
+// Private resources that fit inside the node
+//
+static UINTN
+PrivateCount( PPTT_PROCESSOR *Node )
+{
+    return MIN(Node->NumberOfPrivateResources, (Node->Length - sizeof(PPTT_PROCESSOR)) / sizeof(UINT32));
+}
+
+
+static UINT32 *
+PrivateResources( PPTT_PROCESSOR *Node )
+{
+    return (UINT32 *)(Node + 1);
+}
+
+
+//
+// TRUE if Cache is one of the caches Leaf sees: listed as a private
+// resource of Leaf or one of its parents, or reached from one of
+// those through the next level of cache pointers
+//
+static BOOLEAN
+LeafReaches( EFI_ACPI_DESCRIPTION_HEADER *Table,
+             PPTT_PROCESSOR *Leaf,
+             PPTT_CACHE *Cache )
+{
+    PPTT_PROCESSOR *Node = Leaf;
+    PPTT_CACHE *Next;
+
+    for (UINTN Depth = 0; Node != NULL && Depth < PPTT_MAX_DEPTH; Depth++) {
+        for (UINTN i = 0; i < PrivateCount(Node); i++) {
+            Next = StructureAt(Table, PrivateResources(Node)[i], PPTT_TYPE_CACHE);
+            for (UINTN Level = 0; Next != NULL && Level < PPTT_MAX_DEPTH; Level++) {
+                if (Next == Cache) {
+                    return TRUE;
+                }
+                Next = StructureAt(Table, Next->NextLevelOfCache, PPTT_TYPE_CACHE);
+            }
+        }
+        Node = StructureAt(Table, Node->Parent, PPTT_TYPE_PROCESSOR);
+    }
+
+    return FALSE;
+}
+
+
+//
+// Older tables do not set the leaf flag, so a node is also a leaf if
+// no other node names it as parent
+//
+static BOOLEAN
+IsLeaf( EFI_ACPI_DESCRIPTION_HEADER *Table,
+        PPTT_PROCESSOR *Node )
+{
+    PPTT_STRUCTURE_HEADER *Header;
+    UINT8 *Ptr = (UINT8 *)Table + sizeof(EFI_ACPI_DESCRIPTION_HEADER);
+    UINT8 *End = (UINT8 *)Table + Table->Length;
+    UINT32 Offset = OffsetOf(Table, Node);
+
+    if (Node->Flags & PPTT_LEAF) {
+        return TRUE;
+    }
+    while (Ptr + sizeof(PPTT_STRUCTURE_HEADER) <= End) {
+        Header = (PPTT_STRUCTURE_HEADER *)Ptr;
+        if (Header->Length < sizeof(PPTT_STRUCTURE_HEADER) || Ptr + Header->Length > End) {
+            break;
+        }
+        if (Header->Type == PPTT_TYPE_PROCESSOR && Header->Length >= sizeof(PPTT_PROCESSOR) &&
+            ((PPTT_PROCESSOR *)Header)->Parent == Offset) {
+            return FALSE;
+        }
+        Ptr += Header->Length;
+    }
+
+    return TRUE;
+}
+
+
+//
+// Leaf processors sharing Cache.  The owning node's subtree is not
+// enough: cores that each list their own L1 with a next level pointer
+// to one L2 or L3 share it without a common node listing it.
+//
+static UINTN
+CacheSharing( EFI_ACPI_DESCRIPTION_HEADER *Table,
+              PPTT_CACHE *Cache )
+{
+    PPTT_STRUCTURE_HEADER *Header;
+    UINT8 *Ptr = (UINT8 *)Table + sizeof(EFI_ACPI_DESCRIPTION_HEADER);
+    UINT8 *End = (UINT8 *)Table + Table->Length;
+    UINTN Count = 0;
+
+    while (Ptr + sizeof(PPTT_STRUCTURE_HEADER) <= End) {
+        Header = (PPTT_STRUCTURE_HEADER *)Ptr;
+        if (Header->Length < sizeof(PPTT_STRUCTURE_HEADER) || Ptr + Header->Length > End) {
+            break;
+        }
+        if (Header->Type == PPTT_TYPE_PROCESSOR && Header->Length >= sizeof(PPTT_PROCESSOR) &&
+            IsLeaf(Table, (PPTT_PROCESSOR *)Header) && LeafReaches(Table, (PPTT_PROCESSOR *)Header, Cache)) {
+            Count++;
+        }
+        Ptr += Header->Length;
+    }
+
+    return Count;
+}
+
+
+static PPTT_PROCESSOR *
+FirstLeaf( EFI_ACPI_DESCRIPTION_HEADER *Table )
+{
+    PPTT_STRUCTURE_HEADER *Header;
+    UINT8 *Ptr = (UINT8 *)Table + sizeof(EFI_ACPI_DESCRIPTION_HEADER);
+    UINT8 *End = (UINT8 *)Table + Table->Length;
+
+    while (Ptr + sizeof(PPTT_STRUCTURE_HEADER) <= End) {
+        Header = (PPTT_STRUCTURE_HEADER *)Ptr;
+        if (Header->Length < sizeof(PPTT_STRUCTURE_HEADER) || Ptr + Header->Length > End) {
+            break;
+        }
+        if (Header->Type == PPTT_TYPE_PROCESSOR && Header->Length >= sizeof(PPTT_PROCESSOR) &&
+            IsLeaf(Table, (PPTT_PROCESSOR *)Header)) {
+            return (PPTT_PROCESSOR *)Header;
+        }
+        Ptr += Header->Length;
+    }
+
+    return NULL;
+}
+
+
+//
+// Caches seen by a leaf processor with their levels.  Levels are not
+// stored in the table but follow from the next level of cache chains:
+// each pointer adds one.  A cache already reached through a chain keeps
+// that level when a parent also lists it, and the rest of the chain
+// continues from there.  A cache that only a parent lists starts one
+// level above the deepest cache found below it.
+//
+static UINTN
+LeafCaches( EFI_ACPI_DESCRIPTION_HEADER *Table,
+            PPTT_PROCESSOR *Leaf,
+            PPTT_CACHE_LEVEL *Caches,
+            UINTN Max )
+{
+    PPTT_PROCESSOR *Node = Leaf;
+    PPTT_CACHE *Cache;
+    UINTN Count = 0;
+    UINTN Seen;
+    UINT8 Base = 0;
+    UINT8 Deepest = 0;
+    UINT8 Level;
+
+    for (UINTN Depth = 0; Node != NULL && Depth < PPTT_MAX_DEPTH; Depth++) {
+        for (UINTN i = 0; i < PrivateCount(Node); i++) {
+            Cache = StructureAt(Table, PrivateResources(Node)[i], PPTT_TYPE_CACHE);
+            Level = Base + 1;
+            // counted separately from Level, which a seen cache can lower
+            for (UINTN Step = 0; Cache != NULL && Step < PPTT_MAX_DEPTH; Step++, Level++) {
+                for (Seen = 0; Seen < Count && Caches[Seen].Cache != Cache; Seen++)
+                    ;
+                if (Seen < Count) {
+                    Level = Caches[Seen].Level;
+                } else if (Count < Max) {
+                    Caches[Count].Cache = Cache;
+                    Caches[Count].Sharing = CacheSharing(Table, Cache);
+                    Caches[Count].Level = Level;
+                    Count++;
+                }
+                Deepest = MAX(Deepest, Level);
+                Cache = StructureAt(Table, Cache->NextLevelOfCache, PPTT_TYPE_CACHE);
+            }
+        }
+        Base = Deepest;
+        Node = StructureAt(Table, Node->Parent, PPTT_TYPE_PROCESSOR);
+    }
+
+    return Count;
+}
+
+
+static VOID
+PrintProcessor( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                PPTT_PROCESSOR *Node )
+{
+    OutputPrint(L"  0x%04x  Processor  Parent: 0x%04x", OffsetOf(Table, Node), Node->Parent);
+    if (Node->Flags & PPTT_PROCESSOR_ID_VALID) {
+        OutputPrint(L"  UID: %d", Node->AcpiProcessorId);
+    }
+    OutputPrint(L"%s%s%s", (Node->Flags & PPTT_PHYSICAL_PACKAGE) ? L"  Package" : L"",
+                (Node->Flags & PPTT_THREAD) ? L"  Thread" : L"",
+                IsLeaf(Table, Node) ? L"  Leaf" : L"");
+    if (PrivateCount(Node) > 0) {
+        OutputPrint(L"  Private:");
+        for (UINTN i = 0; i < PrivateCount(Node); i++) {
+            OutputPrint(L" 0x%04x", PrivateResources(Node)[i]);
+        }
+    }
+    OutputPrint(L"\n");
+}
+
+
+static VOID
+PrintCache( EFI_ACPI_DESCRIPTION_HEADER *Table,
+            PPTT_CACHE *Cache )
+{
+    OutputPrint(L"  0x%04x  Cache      %-11s", OffsetOf(Table, Cache), CacheTypeStr(Cache));
+    if (Cache->Flags & PPTT_SIZE_VALID) {
+        OutputPrint(L"  %d KB", Cache->Size / 1024);
+    }
+    if (Cache->Flags & PPTT_WAYS_VALID) {
+        OutputPrint(L"  %d-way", Cache->Associativity);
+    }
+    if (Cache->Flags & PPTT_LINE_SIZE_VALID) {
+        OutputPrint(L"  %d byte lines", Cache->LineSize);
+    }
+    if (Cache->Flags & PPTT_SETS_VALID) {
+        OutputPrint(L"  %d sets", Cache->NumberOfSets);
+    }
+    if (Cache->NextLevelOfCache != 0) {
+        OutputPrint(L"  Next: 0x%04x", Cache->NextLevelOfCache);
+    }
+    OutputPrint(L"\n");
+}
+
+
+static VOID
+JsonProcessor( EFI_ACPI_DESCRIPTION_HEADER *Table,
+               PPTT_PROCESSOR *Node )
+{
+    JsonHex(L"flags", Node->Flags);
+    JsonHex(L"parent", Node->Parent);
+    if (Node->Flags & PPTT_PROCESSOR_ID_VALID) {
+        JsonUint(L"processorUid", Node->AcpiProcessorId);
+    } else {
+        JsonNull(L"processorUid");
+    }
+    JsonBool(L"physicalPackage", (Node->Flags & PPTT_PHYSICAL_PACKAGE) != 0);
+    JsonBool(L"leaf", IsLeaf(Table, Node));
+    JsonArrayBegin(L"privateResources");
+    for (UINTN i = 0; i < PrivateCount(Node); i++) {
+        JsonHex(NULL, PrivateResources(Node)[i]);
+    }
+    JsonArrayEnd();
+}
+
+
+static VOID
+JsonCache( PPTT_CACHE *Cache )
+{
+    JsonHex(L"flags", Cache->Flags);
+    JsonString(L"cacheType", CacheTypeStr(Cache));
+    if (Cache->Flags & PPTT_SIZE_VALID) {
+        JsonUint(L"size", Cache->Size);
+    }
+    if (Cache->Flags & PPTT_WAYS_VALID) {
+        JsonUint(L"ways", Cache->Associativity);
+    }
+    if (Cache->Flags & PPTT_LINE_SIZE_VALID) {
+        JsonUint(L"lineSize", Cache->LineSize);
+    }
+    if (Cache->Flags & PPTT_SETS_VALID) {
+        JsonUint(L"sets", Cache->NumberOfSets);
+    }
+    JsonHex(L"nextLevelOfCache", Cache->NextLevelOfCache);
+}
+
+
+//
+// Compare one CPUID cache with the PPTT cache at the same level and of
+// the same type.  CPUID reports sharing as the number of addressable
+// IDs, a power of two, so the PPTT count is rounded up before comparing.
+//
+static VOID
+CheckCache( EFI_ACPI_DESCRIPTION_HEADER *Table,
+            CPU_CACHE_INFO *Cpu,
+            PPTT_CACHE_LEVEL *Caches,
+            UINTN Count,
+            BOOLEAN Json )
+{
+    PPTT_CACHE_LEVEL *Found = NULL;
+    PPTT_CACHE *Cache;
+    UINTN Sharing;
+    CHAR16 *Name = CpuCacheTypeStr(Cpu->Type);
+
+    for (UINTN i = 0; i < Count && Found == NULL; i++) {
+        if (Caches[i].Level == Cpu->Level && CacheType(Caches[i].Cache) == Cpu->Type) {
+            Found = &Caches[i];
+        }
+    }
+    if (Found == NULL) {
+        DecodeWarning(Json, L"L%d %s cache (%d KB) is not described", Cpu->Level, Name, Cpu->Size / 1024);
+        return;
+    }
+    Cache = Found->Cache;
+
+    if ((Cache->Flags & PPTT_SIZE_VALID) && Cache->Size != Cpu->Size) {
+        DecodeWarning(Json, L"L%d %s size %d KB, CPUID says %d KB", Cpu->Level, Name,
+                      Cache->Size / 1024, Cpu->Size / 1024);
+    }
+    if ((Cache->Flags & PPTT_WAYS_VALID) && !Cpu->FullyAssociative && Cache->Associativity != Cpu->Ways) {
+        DecodeWarning(Json, L"L%d %s is %d-way, CPUID says %d-way", Cpu->Level, Name,
+                      Cache->Associativity, Cpu->Ways);
+    }
+    if ((Cache->Flags & PPTT_LINE_SIZE_VALID) && Cache->LineSize != Cpu->LineSize) {
+        DecodeWarning(Json, L"L%d %s line size %d, CPUID says %d", Cpu->Level, Name,
+                      Cache->LineSize, Cpu->LineSize);
+    }
+    if ((Cache->Flags & PPTT_SETS_VALID) && Cache->NumberOfSets != Cpu->Sets) {
+        DecodeWarning(Json, L"L%d %s has %d sets, CPUID says %d", Cpu->Level, Name,
+                      Cache->NumberOfSets, Cpu->Sets);
+    }
+
+    Sharing = Found->Sharing;
+    if (Sharing > 0 && GetPowerOfTwo32((UINT32)(2 * Sharing - 1)) != Cpu->SharedBy) {
+        DecodeWarning(Json, L"L%d %s shared by %d processors, CPUID allows %d (SMT or cores disabled?)",
+                      Cpu->Level, Name, Sharing, Cpu->SharedBy);
+    }
+}
+
+
+static VOID
+CheckCaches( EFI_ACPI_DESCRIPTION_HEADER *Table,
+             BOOLEAN Json )
+{
+    PPTT_CACHE_LEVEL Caches[PPTT_MAX_CACHES];
+    CPU_CACHE_INFO Cpu[CPU_CACHE_MAX];
+    PPTT_PROCESSOR *Leaf = FirstLeaf(Table);
+    UINTN CacheCount = 0;
+    UINTN CpuCount = CpuCacheEnumerate(Cpu, CPU_CACHE_MAX);
+    BOOLEAN Matched;
+
+    if (Leaf != NULL) {
+        CacheCount = LeafCaches(Table, Leaf, Caches, PPTT_MAX_CACHES);
+    }
+
+    if (Json) {
+        JsonObjectBegin(L"cacheCheck");
+        JsonHex(L"cpuidLeaf", CpuCacheLeaf());
+        if (Leaf != NULL) {
+            JsonHex(L"leafProcessor", OffsetOf(Table, Leaf));
+        } else {
+            JsonNull(L"leafProcessor");
+        }
+        JsonArrayBegin(L"caches");
+        for (UINTN i = 0; i < CacheCount; i++) {
+            JsonObjectBegin(NULL);
+            JsonHex(L"offset", OffsetOf(Table, Caches[i].Cache));
+            JsonUint(L"level", Caches[i].Level);
+            JsonString(L"cacheType", CacheTypeStr(Caches[i].Cache));
+            JsonUint(L"sharedBy", Caches[i].Sharing);
+            JsonObjectEnd();
+        }
+        JsonArrayEnd();
+        JsonArrayBegin(L"mismatches");
+    } else {
+        OutputPrint(L"\n  Cache check against CPUID leaf 0x%x", CpuCacheLeaf());
+        if (Leaf != NULL) {
+            OutputPrint(L" for processor 0x%04x", OffsetOf(Table, Leaf));
+        }
+        OutputPrint(L"\n");
+        for (UINTN i = 0; i < CacheCount; i++) {
+            OutputPrint(L"  L%d %-11s  0x%04x  shared by %d\n", Caches[i].Level, CacheTypeStr(Caches[i].Cache),
+                        OffsetOf(Table, Caches[i].Cache), Caches[i].Sharing);
+        }
+    }
+
+    if (Leaf == NULL) {
+        DecodeWarning(Json, L"No leaf processor node");
+    } else if (CpuCount == 0) {
+        DecodeWarning(Json, L"Processor does not report deterministic cache parameters");
+    }
+
+    if (Leaf != NULL) {
+        for (UINTN i = 0; i < CpuCount; i++) {
+            CheckCache(Table, &Cpu[i], Caches, CacheCount, Json);
+        }
+        for (UINTN i = 0; i < CacheCount && CpuCount > 0; i++) {
+            Matched = FALSE;
+            for (UINTN j = 0; j < CpuCount; j++) {
+                Matched |= (Cpu[j].Level == Caches[i].Level && Cpu[j].Type == CacheType(Caches[i].Cache));
+            }
+            if (!Matched) {
+                DecodeWarning(Json, L"L%d %s cache at 0x%04x is not reported by CPUID", Caches[i].Level,
+                              CacheTypeStr(Caches[i].Cache), OffsetOf(Table, Caches[i].Cache));
+            }
+        }
+    }
+
+    if (Json) {
+        JsonArrayEnd();
+        JsonObjectEnd();
+    }
+}
+
+
+VOID
+DecodePPTT( EFI_ACPI_DESCRIPTION_HEADER *Table,
+            BOOLEAN Json )
+{
+    PPTT_STRUCTURE_HEADER *Header;
+    UINT8 *Ptr;
+    UINT8 *End;
+    UINT8 *Bad = NULL;
+    UINT32 Offset;
+
+    if (InternalTooShort(Table, sizeof(EFI_ACPI_DESCRIPTION_HEADER), Json)) {
+        return;
+    }
+
+    if (Json) {
+        JsonArrayBegin(L"structures");
+    }
+
+    Ptr = (UINT8 *)Table + sizeof(EFI_ACPI_DESCRIPTION_HEADER);
+    End = (UINT8 *)Table + Table->Length;
+    while (Ptr + sizeof(PPTT_STRUCTURE_HEADER) <= End) {
+        Header = (PPTT_STRUCTURE_HEADER *)Ptr;
+        if (Header->Length < sizeof(PPTT_STRUCTURE_HEADER) || Ptr + Header->Length > End) {
+            Bad = Ptr;
+            break;
+        }
+        Offset = OffsetOf(Table, Header);
+
+        if (Json) {
+            JsonObjectBegin(NULL);
+            JsonHex(L"offset", Offset);
+            JsonUint(L"type", Header->Type);
+            JsonUint(L"length", Header->Length);
+        }
+        if (StructureAt(Table, Offset, PPTT_TYPE_PROCESSOR) != NULL) {
+            if (Json) {
+                JsonProcessor(Table, (PPTT_PROCESSOR *)Header);
+            } else {
+                PrintProcessor(Table, (PPTT_PROCESSOR *)Header);
+            }
+        } else if (StructureAt(Table, Offset, PPTT_TYPE_CACHE) != NULL) {
+            if (Json) {
+                JsonCache((PPTT_CACHE *)Header);
+            } else {
+                PrintCache(Table, (PPTT_CACHE *)Header);
+            }
+        } else if (!Json) {
+            OutputPrint(L"  0x%04x  %-9s  Type: %d  Length: %d\n", Offset,
+                        Header->Type == PPTT_TYPE_ID ? L"ID" : L"Reserved", Header->Type, Header->Length);
+        }
+        if (Json) {
+            JsonObjectEnd();
+        }
+
+        Ptr += Header->Length;
+    }
+
+    if (Json) {
+        JsonArrayEnd();
+        if (Bad != NULL) {
+            JsonPrint(L"error", L"Bad structure length %d at offset %d", Bad[1], Bad - (UINT8 *)Table);
+        }
+    } else if (Bad != NULL) {
+        OutputPrint(L"  ERROR: Bad structure length %d at offset %d\n", Bad[1], Bad - (UINT8 *)Table);
+    }
+
+    CheckCaches(Table, Json);
+}
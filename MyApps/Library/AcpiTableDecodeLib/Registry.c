@@ -0,0 +1,322 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  AcpiTableDecodeLib decoder registry
+//
+//  Maps a table signature to its decoder and decodes every indexed
+//  table in one pass, timing each decoder as it goes.  The MSDM, SLIC,
+//  TPM2, FACS and BGRT entries adapt the decoders ListACPI shares with
+//  the single table utilities.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/PrintLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/AcpiTableIndexLib.h>
+#include <Library/TscTimerLib.h>
+
+#include "AcpiTableDecodeInternal.h"
+
+
+STATIC VOID
+DecodeMSDM( EFI_ACPI_DESCRIPTION_HEADER *Table,
+            BOOLEAN Json )
+{
+    AcpiDecodeMsdm(Table, FALSE, Json);
+}
+
+
+STATIC VOID
+DecodeSLIC( EFI_ACPI_DESCRIPTION_HEADER *Table,
+            BOOLEAN Json )
+{
+    AcpiDecodeSlic(Table, TRUE, Json);
+}
+
+
+STATIC VOID
+DecodeTPM2( EFI_ACPI_DESCRIPTION_HEADER *Table,
+            BOOLEAN Json )
+{
+    AcpiDecodeTpm2(Table, Json);
+}
+
+
+STATIC VOID
+DecodeFACS( EFI_ACPI_DESCRIPTION_HEADER *Table,
+            BOOLEAN Json )
+{
+    AcpiDecodeFacs(Table, FALSE, Json);
+}
+
+
+STATIC VOID
+DecodeBGRT( EFI_ACPI_DESCRIPTION_HEADER *Table,
+            BOOLEAN Json )
+{
+    AcpiDecodeBgrt(Table, FALSE, Json);
+}
+
+
+STATIC CONST ACPI_DECODER_ENTRY Decoders[] = {
+    { SIGNATURE_32('A','P','I','C'), L"MADT", DecodeMADT },
+    { SIGNATURE_32('B','G','R','T'), L"BGRT", DecodeBGRT },
+    { SIGNATURE_32('D','M','A','R'), L"DMAR", DecodeDMAR },
+    { SIGNATURE_32('F','A','C','S'), L"FACS", DecodeFACS },
+    { SIGNATURE_32('H','P','E','T'), L"HPET", DecodeHPET },
+    { SIGNATURE_32('I','V','R','S'), L"IVRS", DecodeIVRS },
+    { SIGNATURE_32('M','C','F','G'), L"MCFG", DecodeMCFG },
+    { SIGNATURE_32('M','S','D','M'), L"MSDM", DecodeMSDM },
+    { SIGNATURE_32('P','P','T','T'), L"PPTT", DecodePPTT },
+    { SIGNATURE_32('S','L','I','C'), L"SLIC", DecodeSLIC },
+    { SIGNATURE_32('T','P','M','2'), L"TPM2", DecodeTPM2 },
+};
+
+// per decoder totals for the summary
+typedef struct {
+    UINTN   Tables;
+    UINT64  Ticks;
+} DECODER_STATS;
+
+
+CONST ACPI_DECODER_ENTRY *
+EFIAPI
+AcpiDecoderFind( UINT32 Signature )
+{
+    for (UINTN i = 0; i < ARRAY_SIZE(Decoders); i++) {
+        if (Decoders[i].Signature == Signature) {
+            return &Decoders[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+//
+// One line (or the JSON members) identifying a table.  The FACS has no
+// standard header past its length.
+//
+VOID
+EFIAPI
+AcpiDecodeTableHeader( EFI_ACPI_DESCRIPTION_HEADER *Table,
+                       BOOLEAN Json )
+{
+    BOOLEAN Facs = (Table->Signature == SIGNATURE_32('F','A','C','S'));
+    CHAR16 Signature[5];
+    CHAR16 OemId[7];
+    CHAR16 OemTableId[9];
+
+    if (Json) {
+        JsonAsciiString(L"signature", (CHAR8 *)&(Table->Signature), 4);
+        JsonHex(L"address", (UINTN)Table);
+        JsonUint(L"length", Table->Length);
+        if (!Facs) {
+            JsonUint(L"revision", Table->Revision);
+            JsonAsciiString(L"oemId", (CHAR8 *)(Table->OemId), 6);
+            JsonAsciiString(L"oemTableId", (CHAR8 *)&(Table->OemTableId), 8);
+        }
+        return;
+    }
+
+    InternalAsciiField((CHAR8 *)&(Table->Signature), 4, Signature);
+    OutputPrint(L"\n%s @ 0x%016lx  Length: %d", Signature, (UINT64)(UINTN)Table, Table->Length);
+    if (!Facs) {
+        InternalAsciiField((CHAR8 *)(Table->OemId), 6, OemId);
+        InternalAsciiField((CHAR8 *)&(Table->OemTableId), 8, OemTableId);
+        OutputPrint(L"  Revision: %d  OEM: \"%s\" \"%s\"", Table->Revision, OemId, OemTableId);
+    }
+    OutputPrint(L"\n");
+}
+
+
+//
+// A cross-check finding: a WARNING line, or with Json a string in the
+// array the caller has open
+//
+VOID
+DecodeWarning( BOOLEAN Json,
+               CONST CHAR16 *Format,
+               ... )
+{
+    CHAR16 Buffer[128];
+    VA_LIST Marker;
+
+    VA_START(Marker, Format);
+    UnicodeVSPrint(Buffer, sizeof(Buffer), Format, Marker);
+    VA_END(Marker);
+
+    if (Json) {
+        JsonString(NULL, Buffer);
+    } else {
+        OutputPrint(L"  WARNING: %s\n", Buffer);
+    }
+}
+
+
+STATIC VOID
+PrintSummary( DECODER_STATS *Stats,
+              UINTN Undecoded,
+              UINT64 TotalTicks )
+{
+    UINT64 Us;
+
+    OutputPrint(L"\nDecoder  Tables   Total us  Average us\n");
+    for (UINTN i = 0; i < ARRAY_SIZE(Decoders); i++) {
+        if (Stats[i].Tables == 0) {
+            continue;
+        }
+        Us = TimerTicksToMicroseconds(Stats[i].Ticks);
+        OutputPrint(L"  %-5s  %6d  %9ld  %10ld\n", Decoders[i].Name, Stats[i].Tables,
+                    Us, Us / Stats[i].Tables);
+    }
+    OutputPrint(L"\n%d tables with no decoder\n", Undecoded);
+    OutputPrint(L"Total decode time: %ld us\n", TimerTicksToMicroseconds(TotalTicks));
+}
+
+
+STATIC VOID
+JsonSummary( DECODER_STATS *Stats,
+             UINTN Undecoded,
+             UINT64 TotalTicks )
+{
+    JsonArrayBegin(L"decoders");
+    for (UINTN i = 0; i < ARRAY_SIZE(Decoders); i++) {
+        if (Stats[i].Tables == 0) {
+            continue;
+        }
+        JsonObjectBegin(NULL);
+        JsonString(L"name", Decoders[i].Name);
+        JsonUint(L"tables", Stats[i].Tables);
+        JsonUint(L"totalUs", TimerTicksToMicroseconds(Stats[i].Ticks));
+        JsonObjectEnd();
+    }
+    JsonArrayEnd();
+    JsonUint(L"undecoded", Undecoded);
+    JsonUint(L"totalUs", TimerTicksToMicroseconds(TotalTicks));
+}
+
+
+//
+// Walk the table index once, root table order then the FADT-referenced
+// tables, and hand each table with a registered decoder to it
+//
+EFI_STATUS
+EFIAPI
+AcpiDecodeAllTables( BOOLEAN Json )
+{
+    CONST ACPI_DECODER_ENTRY *Decoder;
+    CONST ACPI_INDEX_ENTRY *Entry;
+    DECODER_STATS Stats[ARRAY_SIZE(Decoders)];
+    UINTN Undecoded = 0;
+    UINT64 TotalTicks = 0;
+    UINT64 Start;
+    UINT64 Ticks;
+    UINTN Slot;
+
+    ZeroMem(Stats, sizeof(Stats));
+
+    if (Json) {
+        JsonArrayBegin(L"tables");
+    }
+
+    for (UINTN Index = 0; Index < AcpiIndexCount(); Index++) {
+        Entry = AcpiIndexEntry(Index);
+        Decoder = AcpiDecoderFind(Entry->Signature);
+
+        if (Json) {
+            JsonObjectBegin(NULL);
+        }
+        AcpiDecodeTableHeader(Entry->Table, Json);
+
+        if (Decoder == NULL) {
+            Undecoded++;
+            if (Json) {
+                JsonNull(L"decoder");
+                JsonObjectEnd();
+            }
+            continue;
+        }
+
+        if (Json) {
+            JsonString(L"decoder", Decoder->Name);
+            JsonObjectBegin(L"decoded");
+        }
+
+        Start = TimerTick();
+        Decoder->Decode(Entry->Table, Json);
+        Ticks = TimerTick() - Start;
+
+        Slot = Decoder - Decoders;
+        Stats[Slot].Tables++;
+        Stats[Slot].Ticks += Ticks;
+        TotalTicks += Ticks;
+
+        if (Json) {
+            JsonObjectEnd();
+            JsonUint(L"decodeUs", TimerTicksToMicroseconds(Ticks));
+            JsonObjectEnd();
+        }
+    }
+
+    if (Json) {
+        JsonArrayEnd();
+        JsonSummary(Stats, Undecoded, TotalTicks);
+    } else {
+        PrintSummary(Stats, Undecoded, TotalTicks);
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+//
+// Decode every table with the given signature, e.g. both SSDTs or
+// all MADTs.  Tables with no registered decoder are not found.
+//
+EFI_STATUS
+EFIAPI
+AcpiDecodeTables( UINT32 Signature,
+                  BOOLEAN Json )
+{
+    CONST ACPI_DECODER_ENTRY *Decoder = AcpiDecoderFind(Signature);
+    EFI_ACPI_DESCRIPTION_HEADER *Table;
+    UINTN Instance;
+
+    if (Decoder == NULL) {
+        return EFI_UNSUPPORTED;
+    }
+
+    if (Json) {
+        JsonArrayBegin(L"tables");
+    }
+
+    for (Instance = 0; (Table = AcpiIndexFind(Signature, Instance)) != NULL; Instance++) {
+        if (Json) {
+            JsonObjectBegin(NULL);
+        } else if (Instance > 0) {
+            OutputPrint(L"\n");
+        }
+        AcpiDecodeTableHeader(Table, Json);
+        if (Json) {
+            JsonString(L"decoder", Decoder->Name);
+            JsonObjectBegin(L"decoded");
+        }
+        Decoder->Decode(Table, Json);
+        if (Json) {
+            JsonObjectEnd();
+            JsonObjectEnd();
+        }
+    }
+
+    if (Json) {
+        JsonArrayEnd();
+    }
+
+    return Instance > 0 ? EFI_SUCCESS : EFI_NOT_FOUND;
+}
@@ -0,0 +1,370 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Indexed lookup of the firmware ACPI tables for the MyApps utilities
+//
+//  Previously every utility found the RSDP by scanning the configuration
+//  table and then scanned the XSDT for each table it wanted, ignoring
+//  RSDT-only firmware and tables only reachable through the FADT.  The
+//  index is built once per image: one walk of the root table, one
+//  checksum per table, and an open-addressed signature hash whose slots
+//  head a chain of the tables sharing that signature.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/AcpiTableIndexLib.h>
+
+#include <Guid/Acpi.h>
+
+typedef struct {
+    UINT32 Signature;
+    UINT16 First;
+    UINT16 Last;
+} ACPI_INDEX_SLOT;
+
+STATIC EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *mRsdp = NULL;
+STATIC EFI_GUID                    *mRsdpGuid = NULL;
+STATIC EFI_ACPI_DESCRIPTION_HEADER *mRoot = NULL;
+STATIC BOOLEAN                     mIsXsdt = FALSE;
+STATIC BOOLEAN                     mBuilt = FALSE;
+
+STATIC ACPI_INDEX_ENTRY            mEntry[ACPI_INDEX_MAX_TABLES];
+STATIC UINTN                       mCount = 0;
+STATIC ACPI_INDEX_SLOT             mSlot[ACPI_INDEX_HASH_SIZE];
+
+
+//
+// Byte sum of a table, eight bytes at a time.  Each word is split into
+// its even and odd bytes and added into four 16 bit lanes; a lane gains
+// at most 2 * 255 per word, so 128 words can be added before the lanes
+// must be folded.  The inner loop has no dependency on byte order and
+// vectorizes well.
+//
+UINT8
+EFIAPI
+AcpiIndexChecksum( CONST VOID *Buffer,
+                   UINTN      Length )
+{
+    CONST UINT8 *Ptr = Buffer;
+    UINT64 Lanes;
+    UINT64 Word;
+    UINTN  Run;
+    UINT8  Sum = 0;
+
+    while (Length > 0 && ((UINTN)Ptr & 7) != 0) {
+        Sum = (UINT8)(Sum + *Ptr++);
+        Length--;
+    }
+
+    while (Length >= 8) {
+        Run = MIN(Length / 8, 128);
+        Lanes = 0;
+        for (UINTN i = 0; i < Run; i++) {
+            Word = ((CONST UINT64 *)Ptr)[i];
+            Lanes += (Word & 0x00ff00ff00ff00ffULL) + ((Word >> 8) & 0x00ff00ff00ff00ffULL);
+        }
+        Ptr += Run * 8;
+        Length -= Run * 8;
+
+        Lanes = (Lanes & 0xffff) + ((Lanes >> 16) & 0xffff) + ((Lanes >> 32) & 0xffff) + (Lanes >> 48);
+        Sum = (UINT8)(Sum + Lanes);
+    }
+
+    while (Length > 0) {
+        Sum = (UINT8)(Sum + *Ptr++);
+        Length--;
+    }
+
+    return Sum;
+}
+
+
+STATIC UINTN
+HashSignature( UINT32 Signature )
+{
+    // Fibonacci hashing; signatures are four ASCII letters so the low
+    // bits alone are a poor key
+    return (UINTN)((Signature * 2654435769U) >> 23) & (ACPI_INDEX_HASH_SIZE - 1);
+}
+
+
+STATIC ACPI_INDEX_SLOT *
+FindSlot( UINT32  Signature,
+          BOOLEAN Create )
+{
+    UINTN Hash = HashSignature(Signature);
+
+    for (UINTN i = 0; i < ACPI_INDEX_HASH_SIZE; i++) {
+        ACPI_INDEX_SLOT *Slot = &mSlot[(Hash + i) & (ACPI_INDEX_HASH_SIZE - 1)];
+
+        if (Slot->First == ACPI_INDEX_END) {
+            if (!Create) {
+                return NULL;
+            }
+            Slot->Signature = Signature;
+            return Slot;
+        }
+        if (Slot->Signature == Signature) {
+            return Slot;
+        }
+    }
+
+    return NULL;
+}
+
+
+STATIC VOID
+AddTable( EFI_ACPI_DESCRIPTION_HEADER *Table,
+          UINT8 Flags )
+{
+    ACPI_INDEX_ENTRY *Entry;
+    ACPI_INDEX_SLOT  *Slot;
+
+    if (Table == NULL || mCount >= ACPI_INDEX_MAX_TABLES) {
+        return;
+    }
+
+    Slot = FindSlot(Table->Signature, TRUE);
+    if (Slot == NULL) {
+        return;
+    }
+
+    // the FADT may point at a table the root table already lists
+    for (UINT16 i = Slot->First; i != ACPI_INDEX_END; i = mEntry[i].Next) {
+        if (mEntry[i].Table == Table) {
+            return;
+        }
+    }
+
+    Entry = &mEntry[mCount];
+    Entry->Table = Table;
+    Entry->Signature = Table->Signature;
+    Entry->Length = Table->Length;
+    Entry->Flags = Flags;
+    Entry->Next = ACPI_INDEX_END;
+
+    if (!(Flags & ACPI_INDEX_NO_CHECKSUM) && Table->Length >= sizeof(EFI_ACPI_DESCRIPTION_HEADER)) {
+        if (AcpiIndexChecksum(Table, Table->Length) == 0) {
+            Entry->Flags |= ACPI_INDEX_CHECKSUM_OK;
+        }
+    }
+
+    if (Slot->First == ACPI_INDEX_END) {
+        Slot->First = (UINT16)mCount;
+    } else {
+        mEntry[Slot->Last].Next = (UINT16)mCount;
+    }
+    Slot->Last = (UINT16)mCount;
+    mCount++;
+}
+
+
+//
+// FACS and DSDT are not listed in the root table.  Prefer the 64-bit
+// X_ fields when the FADT is long enough to have them and they are set.
+//
+STATIC VOID
+AddFadtTables( EFI_ACPI_2_0_FIXED_ACPI_DESCRIPTION_TABLE *Fadt )
+{
+    UINT64 Facs = Fadt->FirmwareCtrl;
+    UINT64 Dsdt = Fadt->Dsdt;
+
+    if (Fadt->Header.Length >= OFFSET_OF(EFI_ACPI_2_0_FIXED_ACPI_DESCRIPTION_TABLE, XFirmwareCtrl) + sizeof(UINT64) &&
+        Fadt->XFirmwareCtrl != 0) {
+        Facs = Fadt->XFirmwareCtrl;
+    }
+    if (Fadt->Header.Length >= OFFSET_OF(EFI_ACPI_2_0_FIXED_ACPI_DESCRIPTION_TABLE, XDsdt) + sizeof(UINT64) &&
+        Fadt->XDsdt != 0) {
+        Dsdt = Fadt->XDsdt;
+    }
+
+    if (Facs != 0) {
+        AddTable((EFI_ACPI_DESCRIPTION_HEADER *)(UINTN)Facs, ACPI_INDEX_FROM_FADT | ACPI_INDEX_NO_CHECKSUM);
+    }
+    if (Dsdt != 0) {
+        AddTable((EFI_ACPI_DESCRIPTION_HEADER *)(UINTN)Dsdt, ACPI_INDEX_FROM_FADT);
+    }
+}
+
+
+STATIC VOID
+FindRsdp( VOID )
+{
+    EFI_CONFIGURATION_TABLE *ect = gST->ConfigurationTable;
+    EFI_GUID gAcpi20TableGuid = EFI_ACPI_20_TABLE_GUID;
+    EFI_GUID gAcpi10TableGuid = ACPI_10_TABLE_GUID;
+
+    // an ACPI 2.0+ RSDP wins over an ACPI 1.0 one
+    for (UINTN i = 0; i < gST->NumberOfTableEntries; i++, ect++) {
+        if (CompareGuid(&ect->VendorGuid, &gAcpi20TableGuid) ||
+            (mRsdp == NULL && CompareGuid(&ect->VendorGuid, &gAcpi10TableGuid))) {
+            if (!AsciiStrnCmp("RSD PTR ", (CHAR8 *)(ect->VendorTable), 8)) {
+                mRsdp = (EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *)ect->VendorTable;
+                mRsdpGuid = &ect->VendorGuid;
+            }
+        }
+    }
+}
+
+
+EFI_STATUS
+EFIAPI
+AcpiIndexInit( VOID )
+{
+    UINTN  EntrySize = 0;
+    UINTN  EntryCount;
+    UINT8  *EntryPtr;
+    UINT64 Address;
+    EFI_ACPI_DESCRIPTION_HEADER *Fadt = NULL;
+
+    if (mBuilt) {
+        return (mRoot != NULL) ? EFI_SUCCESS : EFI_NOT_FOUND;
+    }
+    mBuilt = TRUE;
+
+    SetMem(mSlot, sizeof(mSlot), 0xff);
+
+    FindRsdp();
+    if (mRsdp == NULL) {
+        return EFI_NOT_FOUND;
+    }
+
+    if (mRsdp->Revision >= EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER_REVISION &&
+        mRsdp->XsdtAddress != 0) {
+        mRoot = (EFI_ACPI_DESCRIPTION_HEADER *)(UINTN)(mRsdp->XsdtAddress);
+        mIsXsdt = TRUE;
+        EntrySize = sizeof(UINT64);
+        if (mRoot->Signature != EFI_ACPI_2_0_EXTENDED_SYSTEM_DESCRIPTION_TABLE_SIGNATURE) {
+            mRoot = NULL;
+        }
+    }
+    if (mRoot == NULL && mRsdp->RsdtAddress != 0) {
+        mRoot = (EFI_ACPI_DESCRIPTION_HEADER *)(UINTN)(mRsdp->RsdtAddress);
+        mIsXsdt = FALSE;
+        EntrySize = sizeof(UINT32);
+        if (mRoot->Signature != EFI_ACPI_1_0_ROOT_SYSTEM_DESCRIPTION_TABLE_SIGNATURE) {
+            mRoot = NULL;
+        }
+    }
+    if (mRoot == NULL || mRoot->Length < sizeof(EFI_ACPI_DESCRIPTION_HEADER)) {
+        mRoot = NULL;
+        return EFI_NOT_FOUND;
+    }
+
+    EntryCount = (mRoot->Length - sizeof(EFI_ACPI_DESCRIPTION_HEADER)) / EntrySize;
+    EntryPtr = (UINT8 *)(mRoot + 1);
+    for (UINTN i = 0; i < EntryCount; i++) {
+        // XSDT entries are only 4-byte aligned
+        Address = 0;
+        CopyMem(&Address, EntryPtr + (i * EntrySize), EntrySize);
+        if (Address == 0) {
+            continue;
+        }
+        AddTable((EFI_ACPI_DESCRIPTION_HEADER *)(UINTN)Address, 0);
+        if (Fadt == NULL &&
+            ((EFI_ACPI_DESCRIPTION_HEADER *)(UINTN)Address)->Signature ==
+            EFI_ACPI_2_0_FIXED_ACPI_DESCRIPTION_TABLE_SIGNATURE) {
+            Fadt = (EFI_ACPI_DESCRIPTION_HEADER *)(UINTN)Address;
+        }
+    }
+
+    if (Fadt != NULL) {
+        AddFadtTables((EFI_ACPI_2_0_FIXED_ACPI_DESCRIPTION_TABLE *)Fadt);
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *
+EFIAPI
+AcpiIndexRsdp( VOID )
+{
+    AcpiIndexInit();
+
+    return mRsdp;
+}
+
+
+EFI_GUID *
+EFIAPI
+AcpiIndexRsdpGuid( VOID )
+{
+    AcpiIndexInit();
+
+    return mRsdpGuid;
+}
+
+
+EFI_ACPI_DESCRIPTION_HEADER *
+EFIAPI
+AcpiIndexRoot( BOOLEAN *IsXsdt )
+{
+    AcpiIndexInit();
+
+    if (IsXsdt != NULL) {
+        *IsXsdt = mIsXsdt;
+    }
+
+    return mRoot;
+}
+
+
+UINTN
+EFIAPI
+AcpiIndexCount( VOID )
+{
+    AcpiIndexInit();
+
+    return mCount;
+}
+
+
+CONST ACPI_INDEX_ENTRY *
+EFIAPI
+AcpiIndexEntry( UINTN Index )
+{
+    AcpiIndexInit();
+
+    return (Index < mCount) ? &mEntry[Index] : NULL;
+}
+
+
+CONST ACPI_INDEX_ENTRY *
+EFIAPI
+AcpiIndexFindEntry( UINT32 Signature,
+                    UINTN  Instance )
+{
+    ACPI_INDEX_SLOT *Slot;
+
+    AcpiIndexInit();
+
+    Slot = FindSlot(Signature, FALSE);
+    if (Slot == NULL) {
+        return NULL;
+    }
+
+    for (UINT16 i = Slot->First; i != ACPI_INDEX_END; i = mEntry[i].Next) {
+        if (Instance-- == 0) {
+            return &mEntry[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+EFI_ACPI_DESCRIPTION_HEADER *
+EFIAPI
+AcpiIndexFind( UINT32 Signature,
+               UINTN  Instance )
+{
+    CONST ACPI_INDEX_ENTRY *Entry = AcpiIndexFindEntry(Signature, Instance);
+
+    return (Entry != NULL) ? Entry->Table : NULL;
+}
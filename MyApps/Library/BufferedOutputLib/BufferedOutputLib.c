@@ -0,0 +1,447 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Buffered console output for the MyApps utilities
+//
+//  Every Print() is a full UnicodeVSPrint + ConOut->OutputString round
+//  trip, which is painfully slow on serial and serial-over-LAN consoles.
+//  Output is instead formatted straight into one large buffer that is
+//  written out in batches of lines, when it fills up, or at image exit
+//  (library destructor).  The buffer is always drained completely on a
+//  flush so it never needs to wrap.
+//
+//  The OutputFile functions give the utilities the same batching for
+//  the files they export (ASCII or binary, no BOM).
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/ShellLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/BufferedOutputLib.h>
+
+#define UNICODE_BOM  0xfeff
+
+STATIC CHAR16            mBuffer[OUTPUT_BUFFER_SIZE + 1];
+STATIC UINTN             mUsed = 0;
+STATIC UINTN             mLines = 0;
+STATIC UINT64            mBytesWritten = 0;
+STATIC UINTN             mFlushCount = 0;
+STATIC BOOLEAN           mShowStats = FALSE;
+STATIC BOOLEAN           mConsole = TRUE;
+STATIC SHELL_FILE_HANDLE mTeeHandle = NULL;
+
+
+//
+// Write Length characters of a NUL terminated String to ConOut (unless
+// it is turned off) and the tee file
+//
+STATIC VOID
+WriteOut( CHAR16 *String,
+          UINTN  Length )
+{
+    UINTN Size;
+
+    if (mConsole) {
+        gST->ConOut->OutputString(gST->ConOut, String);
+    }
+
+    if (mTeeHandle != NULL) {
+        Size = Length * sizeof(CHAR16);
+        if (EFI_ERROR(ShellWriteFile(mTeeHandle, &Size, String))) {
+            ShellCloseFile(&mTeeHandle);
+            mTeeHandle = NULL;
+        }
+    }
+
+    mBytesWritten += Length * sizeof(CHAR16);
+    mFlushCount++;
+}
+
+
+VOID
+EFIAPI
+OutputFlush( VOID )
+{
+    if (mUsed == 0) {
+        return;
+    }
+
+    mBuffer[mUsed] = CHAR_NULL;
+    WriteOut(mBuffer, mUsed);
+
+    mUsed = 0;
+    mLines = 0;
+}
+
+
+//
+// Account for Length characters just placed at the end of the buffer
+//
+STATIC VOID
+Commit( UINTN Length )
+{
+    CHAR16 *Ptr = &mBuffer[mUsed];
+
+    for (UINTN i = 0; i < Length; i++) {
+        if (Ptr[i] == L'\n') {
+            mLines++;
+        }
+    }
+    mUsed += Length;
+
+    if (mLines >= OUTPUT_FLUSH_LINES || (OUTPUT_BUFFER_SIZE - mUsed) < OUTPUT_LINE_MAX) {
+        OutputFlush();
+    }
+}
+
+
+UINTN
+EFIAPI
+OutputPrint( CONST CHAR16 *Format,
+             ... )
+{
+    VA_LIST Marker;
+    VA_LIST Copy;
+    UINTN   Length;
+    CHAR16  *Line;
+
+    VA_START(Marker, Format);
+    VA_COPY(Copy, Marker);
+    Length = SPrintLength(Format, Copy);
+    VA_END(Copy);
+
+    if (Length > OUTPUT_BUFFER_SIZE - mUsed) {
+        OutputFlush();
+    }
+
+    // too long for even an empty buffer, so write it straight out
+    if (Length > OUTPUT_BUFFER_SIZE) {
+        Line = AllocatePool((Length + 1) * sizeof(CHAR16));
+        if (Line != NULL) {
+            Length = UnicodeVSPrint(Line, (Length + 1) * sizeof(CHAR16), Format, Marker);
+            WriteOut(Line, Length);
+            FreePool(Line);
+        }
+        VA_END(Marker);
+        return Length;
+    }
+
+    Length = UnicodeVSPrint( &mBuffer[mUsed],
+                             (OUTPUT_BUFFER_SIZE + 1 - mUsed) * sizeof(CHAR16),
+                             Format,
+                             Marker );
+    VA_END(Marker);
+
+    Commit(Length);
+
+    return Length;
+}
+
+
+VOID
+EFIAPI
+OutputString( CONST CHAR16 *String )
+{
+    UINTN Length;
+
+    while (*String != CHAR_NULL) {
+        if (mUsed == OUTPUT_BUFFER_SIZE) {
+            OutputFlush();
+        }
+        for (Length = 0; String[Length] != CHAR_NULL && mUsed + Length < OUTPUT_BUFFER_SIZE; Length++) {
+            mBuffer[mUsed + Length] = String[Length];
+        }
+        String += Length;
+        Commit(Length);
+    }
+}
+
+
+//
+// Open FileName for writing, deleting any existing file first so output
+// is not appended to stale data
+//
+STATIC EFI_STATUS
+CreateFile( CONST CHAR16      *FileName,
+            SHELL_FILE_HANDLE *Handle )
+{
+    EFI_STATUS Status;
+
+    Status = ShellOpenFileByName( FileName,
+                                  Handle,
+                                  EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE,
+                                  0 );
+    if (!EFI_ERROR(Status)) {
+        ShellDeleteFile(Handle);
+    }
+
+    Status = ShellOpenFileByName( FileName,
+                                  Handle,
+                                  EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE,
+                                  0 );
+    if (EFI_ERROR(Status)) {
+        *Handle = NULL;
+    }
+
+    return Status;
+}
+
+
+EFI_STATUS
+EFIAPI
+OutputTeeFile( CONST CHAR16 *FileName )
+{
+    EFI_STATUS Status;
+    CHAR16     Bom = UNICODE_BOM;
+    UINTN      Size;
+
+    OutputFlush();
+
+    if (mTeeHandle != NULL) {
+        ShellCloseFile(&mTeeHandle);
+        mTeeHandle = NULL;
+    }
+
+    Status = CreateFile(FileName, &mTeeHandle);
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+
+    Size = sizeof(Bom);
+    Status = ShellWriteFile(mTeeHandle, &Size, &Bom);
+    if (EFI_ERROR(Status)) {
+        ShellCloseFile(&mTeeHandle);
+        mTeeHandle = NULL;
+    }
+
+    return Status;
+}
+
+
+VOID
+EFIAPI
+OutputTeeClose( VOID )
+{
+    OutputFlush();
+
+    if (mTeeHandle != NULL) {
+        ShellCloseFile(&mTeeHandle);
+        mTeeHandle = NULL;
+    }
+}
+
+
+VOID
+EFIAPI
+OutputConsole( BOOLEAN Enable )
+{
+    OutputFlush();
+    mConsole = Enable;
+}
+
+
+EFI_STATUS
+EFIAPI
+OutputFileOpen( OUTPUT_FILE  *File,
+                CONST CHAR16 *FileName )
+{
+    EFI_STATUS Status;
+
+    ZeroMem(File, sizeof(*File));
+
+    File->Buffer = AllocatePool(OUTPUT_FILE_BUFFER_SIZE);
+    if (File->Buffer == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+    }
+
+    Status = CreateFile(FileName, (SHELL_FILE_HANDLE *)&File->Handle);
+    if (EFI_ERROR(Status)) {
+        FreePool(File->Buffer);
+        File->Buffer = NULL;
+    }
+
+    return Status;
+}
+
+
+//
+// Write out whatever is buffered.  The first error sticks and turns
+// every later write into a no-op.
+//
+EFI_STATUS
+EFIAPI
+OutputFileFlush( OUTPUT_FILE *File )
+{
+    UINTN Size = File->Used;
+
+    if (File->Used > 0 && !EFI_ERROR(File->Status)) {
+        File->Status = ShellWriteFile((SHELL_FILE_HANDLE)File->Handle, &Size, File->Buffer);
+        File->BytesWritten += Size;
+    }
+    File->Used = 0;
+
+    return File->Status;
+}
+
+
+EFI_STATUS
+EFIAPI
+OutputFileWrite( OUTPUT_FILE *File,
+                 CONST VOID  *Data,
+                 UINTN       Size )
+{
+    UINTN Chunk;
+
+    if (EFI_ERROR(File->Status)) {
+        return File->Status;
+    }
+
+    // anything at least a buffer long goes straight to the file
+    if (Size >= OUTPUT_FILE_BUFFER_SIZE) {
+        if (EFI_ERROR(OutputFileFlush(File))) {
+            return File->Status;
+        }
+        Chunk = Size;
+        File->Status = ShellWriteFile((SHELL_FILE_HANDLE)File->Handle, &Chunk, (VOID *)Data);
+        File->BytesWritten += Chunk;
+        return File->Status;
+    }
+
+    while (Size > 0) {
+        if (File->Used == OUTPUT_FILE_BUFFER_SIZE && EFI_ERROR(OutputFileFlush(File))) {
+            return File->Status;
+        }
+        Chunk = MIN(Size, OUTPUT_FILE_BUFFER_SIZE - File->Used);
+        CopyMem(File->Buffer + File->Used, Data, Chunk);
+        File->Used += Chunk;
+        Data = (CONST UINT8 *)Data + Chunk;
+        Size -= Chunk;
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+EFIAPI
+OutputFilePrint( OUTPUT_FILE *File,
+                 CONST CHAR8 *Format,
+                 ... )
+{
+    VA_LIST Marker;
+    UINTN   Length;
+
+    if (OUTPUT_FILE_BUFFER_SIZE - File->Used < OUTPUT_LINE_MAX &&
+        EFI_ERROR(OutputFileFlush(File))) {
+        return File->Status;
+    }
+
+    VA_START(Marker, Format);
+    Length = AsciiVSPrint( (CHAR8 *)File->Buffer + File->Used,
+                           OUTPUT_FILE_BUFFER_SIZE - File->Used,
+                           Format,
+                           Marker );
+    VA_END(Marker);
+
+    File->Used += Length;
+
+    return File->Status;
+}
+
+
+EFI_STATUS
+EFIAPI
+OutputFileClose( OUTPUT_FILE *File )
+{
+    if (File->Handle != NULL) {
+        OutputFileFlush(File);
+        ShellCloseFile((SHELL_FILE_HANDLE *)&File->Handle);
+        File->Handle = NULL;
+    }
+    if (File->Buffer != NULL) {
+        FreePool(File->Buffer);
+        File->Buffer = NULL;
+    }
+
+    return File->Status;
+}
+
+
+VOID
+EFIAPI
+OutputGetStats( UINT64 *BytesWritten,
+                UINTN  *FlushCount )
+{
+    if (BytesWritten != NULL) {
+        *BytesWritten = mBytesWritten + (mUsed * sizeof(CHAR16));
+    }
+    if (FlushCount != NULL) {
+        *FlushCount = mFlushCount;
+    }
+}
+
+
+EFI_STATUS
+EFIAPI
+OutputInit( UINTN  *Argc,
+            CHAR16 **Argv )
+{
+    EFI_STATUS Status = EFI_SUCCESS;
+    UINTN      i = 1;
+    UINTN      Skip;
+
+    while (i < *Argc) {
+        Skip = 0;
+        if (!StrCmp(Argv[i], L"--stats")) {
+            mShowStats = TRUE;
+            Skip = 1;
+        } else if (!StrCmp(Argv[i], L"--tee") && (i + 1) < *Argc) {
+            Status = OutputTeeFile(Argv[i + 1]);
+            if (EFI_ERROR(Status)) {
+                OutputPrint(L"ERROR: Cannot open tee file %s [%d]\n", Argv[i + 1], Status);
+            }
+            Skip = 2;
+        }
+
+        if (Skip) {
+            for (UINTN j = i; j + Skip < *Argc; j++) {
+                Argv[j] = Argv[j + Skip];
+            }
+            *Argc -= Skip;
+        } else {
+            i++;
+        }
+    }
+
+    return Status;
+}
+
+
+EFI_STATUS
+EFIAPI
+BufferedOutputLibDestructor( EFI_HANDLE ImageHandle,
+                             EFI_SYSTEM_TABLE *SystemTable )
+{
+    CHAR16 Buffer[80];
+
+    OutputFlush();
+
+    if (mTeeHandle != NULL) {
+        ShellCloseFile(&mTeeHandle);
+        mTeeHandle = NULL;
+    }
+
+    if (mShowStats) {
+        UnicodeSPrint( Buffer, sizeof(Buffer), L"Output: %ld bytes written, %d flushes\n",
+                       mBytesWritten, mFlushCount );
+        gST->ConOut->OutputString(gST->ConOut, Buffer);
+    }
+
+    return EFI_SUCCESS;
+}
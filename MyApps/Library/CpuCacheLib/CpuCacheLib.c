@@ -0,0 +1,98 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Deterministic cache parameters from CPUID for the MyApps utilities
+//
+//  Intel reports caches in leaf 4 and AMD in leaf 0x8000001D; both use
+//  the same register layout, one subleaf per cache until a subleaf with
+//  a null cache type.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/CpuCacheLib.h>
+
+#define CPUID_CACHE_PARAMS              0x04
+#define CPUID_AMD_CACHE_PARAMS          0x8000001D
+#define CPUID_EXTENDED_FUNCTION         0x80000000
+#define CPUID_EXTENDED_CPU_SIG          0x80000001
+#define AMD_TOPOLOGY_EXTENSIONS         BIT22       // CPUID 0x80000001 ECX
+
+// "AuthenticAMD" and "HygonGenuine" in CPUID 0 EBX
+#define CPUID_VENDOR_AMD                0x68747541
+#define CPUID_VENDOR_HYGON              0x6f677948
+
+
+UINT32
+EFIAPI
+CpuCacheLeaf( VOID )
+{
+    UINT32 MaxLeaf;
+    UINT32 Vendor;
+    UINT32 Ecx;
+
+    AsmCpuid(0, &MaxLeaf, &Vendor, NULL, NULL);
+
+    if (Vendor == CPUID_VENDOR_AMD || Vendor == CPUID_VENDOR_HYGON) {
+        AsmCpuid(CPUID_EXTENDED_FUNCTION, &MaxLeaf, NULL, NULL, NULL);
+        if (MaxLeaf < CPUID_AMD_CACHE_PARAMS) {
+            return 0;
+        }
+        AsmCpuid(CPUID_EXTENDED_CPU_SIG, NULL, NULL, &Ecx, NULL);
+        return (Ecx & AMD_TOPOLOGY_EXTENSIONS) ? CPUID_AMD_CACHE_PARAMS : 0;
+    }
+
+    return (MaxLeaf >= CPUID_CACHE_PARAMS) ? CPUID_CACHE_PARAMS : 0;
+}
+
+
+UINTN
+EFIAPI
+CpuCacheEnumerate( CPU_CACHE_INFO *Caches,
+                   UINTN Max )
+{
+    UINT32 Leaf = CpuCacheLeaf();
+    UINT32 Eax, Ebx, Ecx, Edx;
+    UINTN Count = 0;
+
+    if (Leaf == 0) {
+        return 0;
+    }
+
+    for (UINT32 SubLeaf = 0; Count < Max && SubLeaf < CPU_CACHE_MAX; SubLeaf++) {
+        AsmCpuidEx(Leaf, SubLeaf, &Eax, &Ebx, &Ecx, &Edx);
+        if (BitFieldRead32(Eax, 0, 4) == 0) {
+            break;
+        }
+
+        Caches[Count].Type = (UINT8)BitFieldRead32(Eax, 0, 4);
+        Caches[Count].Level = (UINT8)BitFieldRead32(Eax, 5, 7);
+        Caches[Count].FullyAssociative = (Eax & BIT9) != 0;
+        Caches[Count].SharedBy = BitFieldRead32(Eax, 14, 25) + 1;
+        Caches[Count].LineSize = BitFieldRead32(Ebx, 0, 11) + 1;
+        Caches[Count].Ways = BitFieldRead32(Ebx, 22, 31) + 1;
+        Caches[Count].Sets = Ecx + 1;
+        Caches[Count].Inclusive = (Edx & BIT1) != 0;
+        // line partitions (EBX 21:12) are always 1 in practice but count them
+        Caches[Count].Size = Caches[Count].Ways * (BitFieldRead32(Ebx, 12, 21) + 1) *
+                             Caches[Count].LineSize * Caches[Count].Sets;
+        Count++;
+    }
+
+    return Count;
+}
+
+
+CHAR16 *
+EFIAPI
+CpuCacheTypeStr( UINT8 Type )
+{
+    switch (Type) {
+        case CPU_CACHE_DATA:        return L"Data";
+        case CPU_CACHE_INSTRUCTION: return L"Instruction";
+        case CPU_CACHE_UNIFIED:     return L"Unified";
+        default:                    return L"Unknown";
+    }
+}
@@ -0,0 +1,463 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Message digests for the MyApps utilities
+//
+//  CryptoPkg's BaseCryptLib needs the OpenSSL sources in the tree, which
+//  is a lot to carry for the odd content hash, so SHA-1, SHA-256, SHA-384
+//  and SHA-512 (FIPS 180-4) are implemented here directly.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DigestLib.h>
+
+#define ROTL32(x, n)  (((x) << (n)) | ((x) >> (32 - (n))))
+#define ROTR32(x, n)  (((x) >> (n)) | ((x) << (32 - (n))))
+#define ROTR64(x, n)  (((x) >> (n)) | ((x) << (64 - (n))))
+
+typedef VOID (*BLOCK_FUNCTION)( VOID *State, CONST UINT8 *Block );
+
+STATIC CONST UINT32 mSha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+STATIC CONST UINT64 mSha512K[80] = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+
+//
+// Buffer Data into Block and run BlockFn on each complete block.
+// Shared by all the digests; only the block size differs.
+//
+STATIC VOID
+BlockUpdate( BLOCK_FUNCTION BlockFn,
+             VOID           *State,
+             UINT8          *Block,
+             UINTN          BlockSize,
+             UINTN          *Used,
+             CONST VOID     *Data,
+             UINTN          Size )
+{
+    CONST UINT8 *Ptr = Data;
+    UINTN       Chunk;
+
+    if (*Used > 0) {
+        Chunk = MIN(Size, BlockSize - *Used);
+        CopyMem(Block + *Used, Ptr, Chunk);
+        *Used += Chunk;
+        Ptr += Chunk;
+        Size -= Chunk;
+        if (*Used < BlockSize) {
+            return;
+        }
+        BlockFn(State, Block);
+        *Used = 0;
+    }
+
+    // whole blocks straight from the caller's buffer
+    while (Size >= BlockSize) {
+        BlockFn(State, Ptr);
+        Ptr += BlockSize;
+        Size -= BlockSize;
+    }
+
+    if (Size > 0) {
+        CopyMem(Block, Ptr, Size);
+        *Used = Size;
+    }
+}
+
+
+//
+// Append 0x80, zeros and the big-endian bit length in the last
+// LengthSize bytes of the final block
+//
+STATIC VOID
+BlockFinal( BLOCK_FUNCTION BlockFn,
+            VOID           *State,
+            UINT8          *Block,
+            UINTN          BlockSize,
+            UINTN          Used,
+            UINT64         Length,
+            UINTN          LengthSize )
+{
+    UINT64 Bits = LShiftU64(Length, 3);
+
+    Block[Used++] = 0x80;
+    if (Used > BlockSize - LengthSize) {
+        ZeroMem(Block + Used, BlockSize - Used);
+        BlockFn(State, Block);
+        Used = 0;
+    }
+    ZeroMem(Block + Used, BlockSize - Used);
+    for (UINTN i = 0; i < 8; i++) {
+        Block[BlockSize - 1 - i] = (UINT8)RShiftU64(Bits, i * 8);
+    }
+    BlockFn(State, Block);
+}
+
+
+STATIC VOID
+Sha1Block( VOID        *Context,
+           CONST UINT8 *Block )
+{
+    UINT32 *State = Context;
+    UINT32 W[80];
+    UINT32 a, b, c, d, e, f, k, t;
+
+    for (UINTN i = 0; i < 16; i++) {
+        W[i] = ((UINT32)Block[i * 4] << 24) | ((UINT32)Block[i * 4 + 1] << 16) |
+               ((UINT32)Block[i * 4 + 2] << 8) | (UINT32)Block[i * 4 + 3];
+    }
+    for (UINTN i = 16; i < 80; i++) {
+        W[i] = ROTL32(W[i - 3] ^ W[i - 8] ^ W[i - 14] ^ W[i - 16], 1);
+    }
+
+    a = State[0]; b = State[1]; c = State[2]; d = State[3]; e = State[4];
+
+    for (UINTN i = 0; i < 80; i++) {
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5a827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ed9eba1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8f1bbcdc;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xca62c1d6;
+        }
+        t = ROTL32(a, 5) + f + e + k + W[i];
+        e = d; d = c; c = ROTL32(b, 30); b = a; a = t;
+    }
+
+    State[0] += a; State[1] += b; State[2] += c; State[3] += d; State[4] += e;
+}
+
+
+STATIC VOID
+Sha256Block( VOID        *Context,
+             CONST UINT8 *Block )
+{
+    UINT32 *State = Context;
+    UINT32 W[64];
+    UINT32 a, b, c, d, e, f, g, h;
+    UINT32 T1, T2;
+
+    for (UINTN i = 0; i < 16; i++) {
+        W[i] = ((UINT32)Block[i * 4] << 24) | ((UINT32)Block[i * 4 + 1] << 16) |
+               ((UINT32)Block[i * 4 + 2] << 8) | (UINT32)Block[i * 4 + 3];
+    }
+    for (UINTN i = 16; i < 64; i++) {
+        W[i] = (ROTR32(W[i - 2], 17) ^ ROTR32(W[i - 2], 19) ^ (W[i - 2] >> 10)) + W[i - 7] +
+               (ROTR32(W[i - 15], 7) ^ ROTR32(W[i - 15], 18) ^ (W[i - 15] >> 3)) + W[i - 16];
+    }
+
+    a = State[0]; b = State[1]; c = State[2]; d = State[3];
+    e = State[4]; f = State[5]; g = State[6]; h = State[7];
+
+    for (UINTN i = 0; i < 64; i++) {
+        T1 = h + (ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25)) + ((e & f) ^ (~e & g)) + mSha256K[i] + W[i];
+        T2 = (ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + T1;
+        d = c; c = b; b = a; a = T1 + T2;
+    }
+
+    State[0] += a; State[1] += b; State[2] += c; State[3] += d;
+    State[4] += e; State[5] += f; State[6] += g; State[7] += h;
+}
+
+
+STATIC VOID
+Sha512Block( VOID        *Context,
+             CONST UINT8 *Block )
+{
+    UINT64 *State = Context;
+    UINT64 W[80];
+    UINT64 a, b, c, d, e, f, g, h;
+    UINT64 T1, T2;
+
+    for (UINTN i = 0; i < 16; i++) {
+        W[i] = 0;
+        for (UINTN j = 0; j < 8; j++) {
+            W[i] = LShiftU64(W[i], 8) | Block[i * 8 + j];
+        }
+    }
+    for (UINTN i = 16; i < 80; i++) {
+        W[i] = (ROTR64(W[i - 2], 19) ^ ROTR64(W[i - 2], 61) ^ RShiftU64(W[i - 2], 6)) + W[i - 7] +
+               (ROTR64(W[i - 15], 1) ^ ROTR64(W[i - 15], 8) ^ RShiftU64(W[i - 15], 7)) + W[i - 16];
+    }
+
+    a = State[0]; b = State[1]; c = State[2]; d = State[3];
+    e = State[4]; f = State[5]; g = State[6]; h = State[7];
+
+    for (UINTN i = 0; i < 80; i++) {
+        T1 = h + (ROTR64(e, 14) ^ ROTR64(e, 18) ^ ROTR64(e, 41)) + ((e & f) ^ (~e & g)) + mSha512K[i] + W[i];
+        T2 = (ROTR64(a, 28) ^ ROTR64(a, 34) ^ ROTR64(a, 39)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + T1;
+        d = c; c = b; b = a; a = T1 + T2;
+    }
+
+    State[0] += a; State[1] += b; State[2] += c; State[3] += d;
+    State[4] += e; State[5] += f; State[6] += g; State[7] += h;
+}
+
+
+VOID
+EFIAPI
+DigestSha256Init( DIGEST_SHA256_CONTEXT *Context )
+{
+    Context->State[0] = 0x6a09e667;
+    Context->State[1] = 0xbb67ae85;
+    Context->State[2] = 0x3c6ef372;
+    Context->State[3] = 0xa54ff53a;
+    Context->State[4] = 0x510e527f;
+    Context->State[5] = 0x9b05688c;
+    Context->State[6] = 0x1f83d9ab;
+    Context->State[7] = 0x5be0cd19;
+    Context->Length = 0;
+    Context->Used = 0;
+}
+
+
+VOID
+EFIAPI
+DigestSha256Update( DIGEST_SHA256_CONTEXT *Context,
+                    CONST VOID            *Data,
+                    UINTN                 Size )
+{
+    Context->Length += Size;
+    BlockUpdate( Sha256Block, Context->State, Context->Block, DIGEST_SHA256_BLOCK,
+                 &Context->Used, Data, Size );
+}
+
+
+VOID
+EFIAPI
+DigestSha256Final( DIGEST_SHA256_CONTEXT *Context,
+                   UINT8                 *Digest )
+{
+    BlockFinal( Sha256Block, Context->State, Context->Block, DIGEST_SHA256_BLOCK,
+                Context->Used, Context->Length, 8 );
+
+    for (UINTN i = 0; i < 8; i++) {
+        Digest[i * 4]     = (UINT8)(Context->State[i] >> 24);
+        Digest[i * 4 + 1] = (UINT8)(Context->State[i] >> 16);
+        Digest[i * 4 + 2] = (UINT8)(Context->State[i] >> 8);
+        Digest[i * 4 + 3] = (UINT8)(Context->State[i]);
+    }
+}
+
+
+VOID
+EFIAPI
+DigestSha256( CONST VOID *Data,
+              UINTN      Size,
+              UINT8      *Digest )
+{
+    DIGEST_SHA256_CONTEXT Context;
+
+    DigestSha256Init(&Context);
+    DigestSha256Update(&Context, Data, Size);
+    DigestSha256Final(&Context, Digest);
+}
+
+
+VOID
+EFIAPI
+DigestSha1Init( DIGEST_SHA1_CONTEXT *Context )
+{
+    Context->State[0] = 0x67452301;
+    Context->State[1] = 0xefcdab89;
+    Context->State[2] = 0x98badcfe;
+    Context->State[3] = 0x10325476;
+    Context->State[4] = 0xc3d2e1f0;
+    Context->Length = 0;
+    Context->Used = 0;
+}
+
+
+VOID
+EFIAPI
+DigestSha1Update( DIGEST_SHA1_CONTEXT *Context,
+                  CONST VOID          *Data,
+                  UINTN               Size )
+{
+    Context->Length += Size;
+    BlockUpdate( Sha1Block, Context->State, Context->Block, DIGEST_SHA1_BLOCK,
+                 &Context->Used, Data, Size );
+}
+
+
+VOID
+EFIAPI
+DigestSha1Final( DIGEST_SHA1_CONTEXT *Context,
+                 UINT8               *Digest )
+{
+    BlockFinal( Sha1Block, Context->State, Context->Block, DIGEST_SHA1_BLOCK,
+                Context->Used, Context->Length, 8 );
+
+    for (UINTN i = 0; i < 5; i++) {
+        Digest[i * 4]     = (UINT8)(Context->State[i] >> 24);
+        Digest[i * 4 + 1] = (UINT8)(Context->State[i] >> 16);
+        Digest[i * 4 + 2] = (UINT8)(Context->State[i] >> 8);
+        Digest[i * 4 + 3] = (UINT8)(Context->State[i]);
+    }
+}
+
+
+VOID
+EFIAPI
+DigestSha1( CONST VOID *Data,
+            UINTN      Size,
+            UINT8      *Digest )
+{
+    DIGEST_SHA1_CONTEXT Context;
+
+    DigestSha1Init(&Context);
+    DigestSha1Update(&Context, Data, Size);
+    DigestSha1Final(&Context, Digest);
+}
+
+
+VOID
+EFIAPI
+DigestSha512Init( DIGEST_SHA512_CONTEXT *Context )
+{
+    Context->State[0] = 0x6a09e667f3bcc908ULL;
+    Context->State[1] = 0xbb67ae8584caa73bULL;
+    Context->State[2] = 0x3c6ef372fe94f82bULL;
+    Context->State[3] = 0xa54ff53a5f1d36f1ULL;
+    Context->State[4] = 0x510e527fade682d1ULL;
+    Context->State[5] = 0x9b05688c2b3e6c1fULL;
+    Context->State[6] = 0x1f83d9abfb41bd6bULL;
+    Context->State[7] = 0x5be0cd19137e2179ULL;
+    Context->Length = 0;
+    Context->Used = 0;
+}
+
+
+//
+// SHA-384 is SHA-512 with its own initial values, truncated
+//
+VOID
+EFIAPI
+DigestSha384Init( DIGEST_SHA512_CONTEXT *Context )
+{
+    Context->State[0] = 0xcbbb9d5dc1059ed8ULL;
+    Context->State[1] = 0x629a292a367cd507ULL;
+    Context->State[2] = 0x9159015a3070dd17ULL;
+    Context->State[3] = 0x152fecd8f70e5939ULL;
+    Context->State[4] = 0x67332667ffc00b31ULL;
+    Context->State[5] = 0x8eb44a8768581511ULL;
+    Context->State[6] = 0xdb0c2e0d64f98fa7ULL;
+    Context->State[7] = 0x47b5481dbefa4fa4ULL;
+    Context->Length = 0;
+    Context->Used = 0;
+}
+
+
+VOID
+EFIAPI
+DigestSha512Update( DIGEST_SHA512_CONTEXT *Context,
+                    CONST VOID            *Data,
+                    UINTN                 Size )
+{
+    Context->Length += Size;
+    BlockUpdate( Sha512Block, Context->State, Context->Block, DIGEST_SHA512_BLOCK,
+                 &Context->Used, Data, Size );
+}
+
+
+STATIC VOID
+Sha512Final( DIGEST_SHA512_CONTEXT *Context,
+             UINT8                 *Digest,
+             UINTN                 DigestSize )
+{
+    // 128-bit length field; the upper 64 bits are always zero here
+    BlockFinal( Sha512Block, Context->State, Context->Block, DIGEST_SHA512_BLOCK,
+                Context->Used, Context->Length, 16 );
+
+    for (UINTN i = 0; i < DigestSize; i++) {
+        Digest[i] = (UINT8)RShiftU64(Context->State[i / 8], (7 - (i % 8)) * 8);
+    }
+}
+
+
+VOID
+EFIAPI
+DigestSha384Final( DIGEST_SHA512_CONTEXT *Context,
+                   UINT8                 *Digest )
+{
+    Sha512Final(Context, Digest, DIGEST_SHA384_SIZE);
+}
+
+
+VOID
+EFIAPI
+DigestSha512Final( DIGEST_SHA512_CONTEXT *Context,
+                   UINT8                 *Digest )
+{
+    Sha512Final(Context, Digest, DIGEST_SHA512_SIZE);
+}
+
+
+VOID
+EFIAPI
+DigestSha384( CONST VOID *Data,
+              UINTN      Size,
+              UINT8      *Digest )
+{
+    DIGEST_SHA512_CONTEXT Context;
+
+    DigestSha384Init(&Context);
+    DigestSha512Update(&Context, Data, Size);
+    DigestSha384Final(&Context, Digest);
+}
+
+
+VOID
+EFIAPI
+DigestSha512( CONST VOID *Data,
+              UINTN      Size,
+              UINT8      *Digest )
+{
+    DIGEST_SHA512_CONTEXT Context;
+
+    DigestSha512Init(&Context);
+    DigestSha512Update(&Context, Data, Size);
+    DigestSha512Final(&Context, Digest);
+}
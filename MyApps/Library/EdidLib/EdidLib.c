@@ -0,0 +1,364 @@
+//
+//  Copyright (c) 2015-2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  EDID base block decoding
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/EdidLib.h>
+
+
+// Most of these defines come straight out of NetBSD EDID source code
+#define CHECK_BIT(var, pos)               ((var & (1 << pos)) == (1 << pos))
+#define EDID_COMBINE_HI_8LO(hi, lo)       ((((unsigned)hi) << 8) | (unsigned)lo)
+#define EDID_VIDEO_INPUT_LEVEL(x)         (((x) & 0x60) >> 5)
+#define EDID_DPMS_ACTIVE_OFF              (1 << 5)
+#define EDID_DPMS_SUSPEND                 (1 << 6)
+#define EDID_DPMS_STANDBY                 (1 << 7)
+#define EDID_STD_TIMING_HRES(ptr)         ((((ptr)[0]) * 8) + 248)
+#define EDID_STD_TIMING_VFREQ(ptr)        ((((ptr)[1]) & 0x3f) + 60)
+#define EDID_STD_TIMING_RATIO(ptr)        ((ptr)[1] & 0xc0)
+#define EDID_BLOCK_IS_DET_TIMING(ptr)     ((ptr)[0] | (ptr)[1])
+#define EDID_DET_TIMING_DOT_CLOCK(ptr)    (((ptr)[0] | ((ptr)[1] << 8)) * 10000)
+#define EDID_HACT_LO(ptr)                 ((ptr)[2])
+#define EDID_HBLK_LO(ptr)                 ((ptr)[3])
+#define EDID_HACT_HI(ptr)                 (((ptr)[4] & 0xf0) << 4)
+#define EDID_HBLK_HI(ptr)                 (((ptr)[4] & 0x0f) << 8)
+#define EDID_DET_TIMING_HACTIVE(ptr)      (EDID_HACT_LO(ptr) | EDID_HACT_HI(ptr))
+#define EDID_DET_TIMING_HBLANK(ptr)       (EDID_HBLK_LO(ptr) | EDID_HBLK_HI(ptr))
+#define EDID_VACT_LO(ptr)                 ((ptr)[5])
+#define EDID_VBLK_LO(ptr)                 ((ptr)[6])
+#define EDID_VACT_HI(ptr)                 (((ptr)[7] & 0xf0) << 4)
+#define EDID_VBLK_HI(ptr)                 (((ptr)[7] & 0x0f) << 8)
+#define EDID_DET_TIMING_VACTIVE(ptr)      (EDID_VACT_LO(ptr) | EDID_VACT_HI(ptr))
+#define EDID_DET_TIMING_VBLANK(ptr)       (EDID_VBLK_LO(ptr) | EDID_VBLK_HI(ptr))
+#define EDID_HOFF_LO(ptr)                 ((ptr)[8])
+#define EDID_HWID_LO(ptr)                 ((ptr)[9])
+#define EDID_VOFF_LO(ptr)                 ((ptr)[10] >> 4)
+#define EDID_VWID_LO(ptr)                 ((ptr)[10] & 0xf)
+#define EDID_HOFF_HI(ptr)                 (((ptr)[11] & 0xc0) << 2)
+#define EDID_HWID_HI(ptr)                 (((ptr)[11] & 0x30) << 4)
+#define EDID_VOFF_HI(ptr)                 (((ptr)[11] & 0x0c) << 2)
+#define EDID_VWID_HI(ptr)                 (((ptr)[11] & 0x03) << 4)
+#define EDID_DET_TIMING_HSYNC_OFFSET(ptr) (EDID_HOFF_LO(ptr) | EDID_HOFF_HI(ptr))
+#define EDID_DET_TIMING_HSYNC_WIDTH(ptr)  (EDID_HWID_LO(ptr) | EDID_HWID_HI(ptr))
+#define EDID_DET_TIMING_VSYNC_OFFSET(ptr) (EDID_VOFF_LO(ptr) | EDID_VOFF_HI(ptr))
+#define EDID_DET_TIMING_VSYNC_WIDTH(ptr)  (EDID_VWID_LO(ptr) | EDID_VWID_HI(ptr))
+#define EDID_HSZ_LO(ptr)                  ((ptr)[12])
+#define EDID_VSZ_LO(ptr)                  ((ptr)[13])
+#define EDID_HSZ_HI(ptr)                  (((ptr)[14] & 0xf0) << 4)
+#define EDID_VSZ_HI(ptr)                  (((ptr)[14] & 0x0f) << 8)
+#define EDID_DET_TIMING_HSIZE(ptr)        (EDID_HSZ_LO(ptr) | EDID_HSZ_HI(ptr))
+#define EDID_DET_TIMING_VSIZE(ptr)        (EDID_VSZ_LO(ptr) | EDID_VSZ_HI(ptr))
+#define EDID_DET_TIMING_HBORDER(ptr)      ((ptr)[15])
+#define EDID_DET_TIMING_VBORDER(ptr)      ((ptr)[16])
+#define EDID_DET_TIMING_FLAGS(ptr)        ((ptr)[17])
+#define EDID_DET_TIMING_VSOBVHSPW(ptr)    ((ptr)[11])
+
+
+//
+// Based on code found at http://code.google.com/p/my-itoa/
+//
+STATIC int 
+Integer2AsciiString( int val, 
+                     char* buf )
+{
+    const unsigned int radix = 10;
+
+    char* p = buf;
+    unsigned int a; 
+    int len;
+    char* b;
+    char temp;
+    unsigned int u;
+
+    if (val < 0) {
+        *p++ = '-';
+        val = 0 - val;
+    }
+    u = (unsigned int)val;
+    b = p;
+
+    do {
+        a = u % radix;
+        u /= radix;
+        *p++ = a + '0';
+    } while (u > 0);
+
+    len = (int)(p - buf);
+    *p-- = 0;
+
+    // swap 
+    do {
+       temp = *p; *p = *b; *b = temp;
+       --p; ++b;
+    } while (b < p);
+
+    return len;
+}
+
+
+//
+// Based on code found on the Internet (author unknown)
+// Search for ftoa implementations
+//
+STATIC int 
+Float2AsciiString( float f,
+                   char *buffer, 
+                   int numdecimals )
+{
+    int status = 0;
+    char *s = buffer;
+    long mantissa, int_part, frac_part;
+    short exp2;
+    char m;
+
+    typedef union {
+        long L;
+        float F;
+    } LF_t;
+    LF_t x;
+
+    if (f == 0.0) {           // return 0.00
+        *s++ = '0'; *s++ = '.'; *s++ = '0'; *s++ = '0'; 
+        *s = 0;
+       return status;
+    }
+
+    x.F = f;
+
+    exp2 = (unsigned char)(x.L >> 23) - 127;
+    mantissa = (x.L & 0xFFFFFF) | 0x800000;
+    frac_part = 0;
+    int_part = 0;
+
+    if (exp2 >= 31 || exp2 < -23) {
+        *s = 0;
+        return 1;
+    } 
+
+    if (exp2 >= 0) {
+        int_part = mantissa >> (23 - exp2);
+        frac_part = (mantissa << (exp2 + 1)) & 0xFFFFFF;
+    } else {
+        frac_part = (mantissa & 0xFFFFFF) >> -(exp2 + 1);
+    }
+
+    if (int_part == 0)
+       *s++ = '0';
+    else {
+        Integer2AsciiString(int_part, s);
+        while (*s) s++;
+    }
+    *s++ = '.';
+
+    if (frac_part == 0)
+        *s++ = '0';
+    else {
+        for (m = 0; m < numdecimals; m++) {                       // print BCD
+            frac_part = (frac_part << 3) + (frac_part << 1);      // frac_part *= 10
+            *s++ = (frac_part >> 24) + '0';
+            frac_part &= 0xFFFFFF;
+        }
+    }
+    *s = 0;
+
+    return status;
+}
+
+
+STATIC VOID
+Ascii2UnicodeString( CHAR8 *String, 
+                     CHAR16 *UniString )
+{
+    while (*String != '\0') {
+        *(UniString++) = (CHAR16) *(String++);
+    }
+    *UniString = '\0';
+}
+
+
+STATIC CHAR16 *
+DisplayGammaString( UINT8 Gamma )
+{
+    char Str[8];
+    static CHAR16 Wstr[8];
+
+    float g1 = (float)Gamma;
+    float g2 = 1.00 + (g1/100);
+
+    Float2AsciiString(g2, Str, 2);         
+    Ascii2UnicodeString(Str, Wstr);
+
+    return Wstr;
+}
+
+
+STATIC CHAR16 *
+ManufacturerAbbrev( UINT16 *ManufactureName )
+{
+    static CHAR16 Mcode[8];
+    UINT8 *block = (UINT8 *)ManufactureName;
+    UINT16 h = EDID_COMBINE_HI_8LO(block[0], block[1]);
+
+    Mcode[0] = (CHAR16)((h>>10) & 0x1f) + 'A' - 1;
+    Mcode[1] = (CHAR16)((h>>5) & 0x1f) + 'A' - 1;
+    Mcode[2] = (CHAR16)(h & 0x1f) + 'A' - 1;
+    Mcode[3] = (CHAR16)'\0';
+ 
+    return Mcode;
+}
+
+
+BOOLEAN
+EFIAPI
+EdidValid( UINT8  *Edid,
+           UINT32 Size )
+{
+    CONST UINT8 EdidHeader[] = {0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00};
+    EDID_DATA_BLOCK *EdidDataBlock = (EDID_DATA_BLOCK *)Edid;
+
+    if (Edid == NULL || Size < EDID_DATA_BLOCK_SIZE) {
+        return FALSE;
+    }
+    if (CalculateSum8(Edid, EDID_DATA_BLOCK_SIZE) != 0) {
+        return FALSE;
+    }
+    if (CompareMem(Edid, EdidHeader, sizeof(EdidHeader)) != 0) {
+        return FALSE;
+    }
+
+    return (EdidDataBlock->EdidVersion == 1 && EdidDataBlock->EdidRevision <= 4);
+}
+
+
+STATIC VOID
+PrintDetailedTimingBlock( UINT8 *dtb )
+{
+    OutputPrint(L"  Horizonal Image Size: %d mm\n", EDID_DET_TIMING_HSIZE(dtb));
+    OutputPrint(L"   Vertical Image Size: %d mm\n", EDID_DET_TIMING_VSIZE(dtb));
+    OutputPrint(L"  HoriImgSzByVertImgSz: %d\n", dtb[14]);
+    OutputPrint(L"     Horizontal Border: %d\n", EDID_DET_TIMING_HBORDER(dtb));
+    OutputPrint(L"       Vertical Border: %d\n", EDID_DET_TIMING_VBORDER(dtb));
+}
+
+
+VOID
+EFIAPI
+EdidPrint( EDID_DATA_BLOCK *EdidDataBlock )
+{ 
+    UINT8 tmp;
+
+    OutputPrint(L"          EDID Version: 0x%02x (%d)\n", EdidDataBlock->EdidVersion,
+                                                    EdidDataBlock->EdidVersion );
+    OutputPrint(L"         EDID Revision: 0x%02x (%d)\n", EdidDataBlock->EdidRevision,
+                                                    EdidDataBlock->EdidRevision );
+    OutputPrint(L"   Vendor Abbreviation: %s\n", ManufacturerAbbrev(&(EdidDataBlock->ManufactureName)));
+    OutputPrint(L"            Product ID: 0x%08X\n", EdidDataBlock->ProductCode);
+    OutputPrint(L"         Serial Number: 0x%08X\n", EdidDataBlock->SerialNumber);
+    OutputPrint(L"      Manufacture Week: %02d\n", EdidDataBlock->WeekOfManufacture);
+    OutputPrint(L"      Manufacture Year: %d\n", EdidDataBlock->YearOfManufacture + 1990);
+
+    tmp = (UINT8) EdidDataBlock->VideoInputDefinition;
+    OutputPrint(L"           Video Input: ");
+    if (CHECK_BIT(tmp, 7)) {
+        OutputPrint(L"Analog\n");
+    } else {
+        OutputPrint(L"Digital\n");
+    }
+    if (tmp & 0x1F) {
+        OutputPrint(L"        Syncronization: ");
+        if (CHECK_BIT(tmp, 4))
+            OutputPrint(L"BlankToBackSetup ");
+        if (CHECK_BIT(tmp, 3))
+            OutputPrint(L"SeparateSync ");
+        if (CHECK_BIT(tmp, 2))
+            OutputPrint(L"CompositeSync ");
+        if (CHECK_BIT(tmp, 1))
+            OutputPrint(L"SyncOnGreen ");
+        if (CHECK_BIT(tmp, 0))
+            OutputPrint(L"SerrationVSync ");
+        OutputPrint(L"\n");
+    }
+
+    tmp = (UINT8) EdidDataBlock->DpmSupport;
+    OutputPrint(L"          Display Type: ");
+    if (CHECK_BIT(tmp, 3) && CHECK_BIT(tmp, 4)) {
+        OutputPrint(L"Undefined");
+    } else if (CHECK_BIT(tmp, 3)) {
+        OutputPrint(L"RGB color");
+    } else if (CHECK_BIT(tmp, 4)) {
+        OutputPrint(L"Non-RGB multicolor");
+    } else {
+        OutputPrint(L"Monochrome");
+    }
+    OutputPrint(L"\n");
+
+    OutputPrint(L"    Max Horizonal Size: %1d cm\n", EdidDataBlock->MaxHorizontalImageSize);
+    OutputPrint(L"     Max Vertical Size: %1d cm\n", EdidDataBlock->MaxVerticalImageSize);
+    OutputPrint(L"                 Gamma: %s\n", DisplayGammaString(EdidDataBlock->DisplayGamma));
+
+    PrintDetailedTimingBlock((UINT8 *)&(EdidDataBlock->DescriptionBlock1[0]));
+}
+
+
+VOID
+EFIAPI
+EdidJson( EDID_DATA_BLOCK *EdidDataBlock )
+{ 
+    UINT8 *dtb = (UINT8 *)&(EdidDataBlock->DescriptionBlock1[0]);
+    UINT8 tmp;
+
+    JsonUint(L"edidVersion", EdidDataBlock->EdidVersion);
+    JsonUint(L"edidRevision", EdidDataBlock->EdidRevision);
+    JsonString(L"vendor", ManufacturerAbbrev(&(EdidDataBlock->ManufactureName)));
+    JsonHex(L"productId", EdidDataBlock->ProductCode);
+    JsonHex(L"serialNumber", EdidDataBlock->SerialNumber);
+    JsonUint(L"manufactureWeek", EdidDataBlock->WeekOfManufacture);
+    JsonUint(L"manufactureYear", EdidDataBlock->YearOfManufacture + 1990);
+
+    tmp = (UINT8) EdidDataBlock->VideoInputDefinition;
+    JsonString(L"videoInput", CHECK_BIT(tmp, 7) ? L"Analog" : L"Digital");
+    JsonArrayBegin(L"synchronization");
+    if (CHECK_BIT(tmp, 4))
+        JsonString(NULL, L"BlankToBackSetup");
+    if (CHECK_BIT(tmp, 3))
+        JsonString(NULL, L"SeparateSync");
+    if (CHECK_BIT(tmp, 2))
+        JsonString(NULL, L"CompositeSync");
+    if (CHECK_BIT(tmp, 1))
+        JsonString(NULL, L"SyncOnGreen");
+    if (CHECK_BIT(tmp, 0))
+        JsonString(NULL, L"SerrationVSync");
+    JsonArrayEnd();
+
+    tmp = (UINT8) EdidDataBlock->DpmSupport;
+    if (CHECK_BIT(tmp, 3) && CHECK_BIT(tmp, 4)) {
+        JsonString(L"displayType", L"Undefined");
+    } else if (CHECK_BIT(tmp, 3)) {
+        JsonString(L"displayType", L"RGB color");
+    } else if (CHECK_BIT(tmp, 4)) {
+        JsonString(L"displayType", L"Non-RGB multicolor");
+    } else {
+        JsonString(L"displayType", L"Monochrome");
+    }
+
+    JsonUint(L"maxHorizontalSizeCm", EdidDataBlock->MaxHorizontalImageSize);
+    JsonUint(L"maxVerticalSizeCm", EdidDataBlock->MaxVerticalImageSize);
+    JsonString(L"gamma", DisplayGammaString(EdidDataBlock->DisplayGamma));
+
+    JsonObjectBegin(L"detailedTiming");
+    JsonUint(L"horizontalImageSizeMm", EDID_DET_TIMING_HSIZE(dtb));
+    JsonUint(L"verticalImageSizeMm", EDID_DET_TIMING_VSIZE(dtb));
+    JsonUint(L"horizontalBorder", EDID_DET_TIMING_HBORDER(dtb));
+    JsonUint(L"verticalBorder", EDID_DET_TIMING_VBORDER(dtb));
+    JsonObjectEnd();
+
+    JsonBytes(L"raw", EdidDataBlock, sizeof(EDID_DATA_BLOCK));
+}
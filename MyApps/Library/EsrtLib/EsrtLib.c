@@ -0,0 +1,157 @@
+//
+//  Copyright (c) 2015-2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  EFI System Resource Table decoding
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Uefi/UefiSpec.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/EsrtLib.h>
+
+STATIC CHAR16 *FwTypeStr[] = {
+   L"Unknown", L"System", L"Device", L"UEFI Driver"
+};
+
+STATIC CHAR16 *LastAttemptStatusStr[] = {
+   L"Success", L"Unsuccessful", L"Insufficient Resources", L"Incorrect Version",
+   L"Invalid Image Format", L"Authentication Error", L"AC Power Not Connected",
+   L"Insufficent Battery Power"
+};
+
+
+STATIC CHAR16 *
+FwTypeName( UINT32 FwType )
+{
+    return (FwType < ARRAY_SIZE(FwTypeStr)) ? FwTypeStr[FwType] : L"Unknown";
+}
+
+
+STATIC CHAR16 *
+LastAttemptStatusName( UINT32 LastAttemptStatus )
+{
+    return (LastAttemptStatus < ARRAY_SIZE(LastAttemptStatusStr)) ?
+           LastAttemptStatusStr[LastAttemptStatus] : L"Unknown";
+}
+
+
+EFI_STATUS
+EFIAPI
+EsrtJson( EFI_SYSTEM_RESOURCE_TABLE *Esrt )
+{
+    EFI_SYSTEM_RESOURCE_ENTRY *EsrtEntry = (EFI_SYSTEM_RESOURCE_ENTRY *)(Esrt + 1);
+
+    JsonHex(L"address", (UINTN)Esrt);
+    JsonUint(L"fwResourceCount", Esrt->FwResourceCount);
+    JsonUint(L"fwResourceCountMax", Esrt->FwResourceCountMax);
+    JsonUint(L"fwResourceVersion", Esrt->FwResourceVersion);
+
+    if (Esrt->FwResourceVersion != 1) {
+        JsonPrint(L"error", L"Unsupported ESRT version: %d", Esrt->FwResourceVersion);
+        return EFI_UNSUPPORTED;
+    }
+
+    JsonArrayBegin(L"entries");
+    for (UINT32 i = 0; i < Esrt->FwResourceCount; i++, EsrtEntry++) {
+        JsonObjectBegin(NULL);
+        JsonGuid(L"fwClass", &EsrtEntry->FwClass);
+        JsonUint(L"fwType", EsrtEntry->FwType);
+        JsonString(L"fwTypeName", FwTypeName(EsrtEntry->FwType));
+        JsonHex(L"fwVersion", EsrtEntry->FwVersion);
+        JsonHex(L"lowestSupportedFwVersion", EsrtEntry->LowestSupportedFwVersion);
+        JsonHex(L"capsuleFlags", EsrtEntry->CapsuleFlags);
+        JsonBool(L"persistAcrossReset", (EsrtEntry->CapsuleFlags & CAPSULE_FLAGS_PERSIST_ACROSS_RESET) != 0);
+        JsonBool(L"populateSystemTable", (EsrtEntry->CapsuleFlags & CAPSULE_FLAGS_POPULATE_SYSTEM_TABLE) != 0);
+        JsonBool(L"initiateReset", (EsrtEntry->CapsuleFlags & CAPSULE_FLAGS_INITIATE_RESET) != 0);
+        JsonHex(L"privateFlags", EsrtEntry->CapsuleFlags & 0xffff);
+        JsonHex(L"lastAttemptVersion", EsrtEntry->LastAttemptVersion);
+        JsonUint(L"lastAttemptStatus", EsrtEntry->LastAttemptStatus);
+        JsonString(L"lastAttemptStatusName", LastAttemptStatusName(EsrtEntry->LastAttemptStatus));
+        JsonObjectEnd();
+    }
+    JsonArrayEnd();
+
+    return EFI_SUCCESS;
+}
+
+
+EFI_STATUS
+EFIAPI
+EsrtPrint( EFI_SYSTEM_RESOURCE_TABLE *Esrt,
+           BOOLEAN                   Verbose )
+{
+    EFI_SYSTEM_RESOURCE_ENTRY *EsrtEntry = (EFI_SYSTEM_RESOURCE_ENTRY *)(Esrt + 1);
+    BOOLEAN ob;
+    UINT16 PrivateFlags;
+
+    if ( Verbose ) {
+        OutputPrint(L"ESRT found at 0x%08x\n", Esrt);
+        OutputPrint(L"Firmware Resource Count: %d\n", Esrt->FwResourceCount);
+        OutputPrint(L"Firmware Resource Max Count: %d\n", Esrt->FwResourceCountMax);
+        OutputPrint(L"Firmware Resource Version: %ld\n", Esrt->FwResourceVersion);
+        OutputPrint(L"\n");
+    }
+
+    if (Esrt->FwResourceVersion != 1) {
+        OutputPrint(L"ERROR: Unsupported ESRT version: %d\n", Esrt->FwResourceVersion);
+        return EFI_UNSUPPORTED;
+    }
+
+    for (UINT32 i = 0; i < Esrt->FwResourceCount; i++, EsrtEntry++) {
+        ob = FALSE;
+        OutputPrint(L"Firmware Resource Entry: %d\n", i);
+        OutputPrint(L"Firmware Class GUID: %g\n", &EsrtEntry->FwClass);
+        OutputPrint(L"Firmware Type: %d (%s)\n", EsrtEntry->FwType, FwTypeName(EsrtEntry->FwType));
+        OutputPrint(L"Firmware Version: 0x%08x\n", EsrtEntry->FwVersion);
+        OutputPrint(L"Lowest Supported Firmware Version: 0x%08x\n", EsrtEntry->LowestSupportedFwVersion);
+
+        // the low 16 bits are the device's own; the table itself is left untouched
+        OutputPrint(L"Capsule Flags: 0x%08x", EsrtEntry->CapsuleFlags);
+        PrivateFlags = (UINT16)(EsrtEntry->CapsuleFlags & 0xffff);
+        if ( EsrtEntry->CapsuleFlags & CAPSULE_FLAGS_PERSIST_ACROSS_RESET ) {
+            if (!ob) {
+                ob = TRUE;
+                OutputPrint(L" (");
+            }
+            OutputPrint(L"Persist Across Reboot");
+        }
+        if ( EsrtEntry->CapsuleFlags & CAPSULE_FLAGS_POPULATE_SYSTEM_TABLE ) {
+            if (!ob) {
+                ob = TRUE;
+                OutputPrint(L" (");
+            } else 
+                OutputPrint(L", ");
+            OutputPrint(L"Populate System Table");
+        }
+        if ( EsrtEntry->CapsuleFlags & CAPSULE_FLAGS_INITIATE_RESET ) {
+            if (!ob) {
+                ob = TRUE;
+                OutputPrint(L" (");
+            } else 
+                OutputPrint(L", ");
+            OutputPrint(L"Initiate Reset");
+        }
+        if ( PrivateFlags ) {
+            if (!ob) {
+                ob = TRUE;
+                OutputPrint(L" (");
+            } else 
+                OutputPrint(L", ");
+            OutputPrint(L"Private Update Flags: 0x%04x", PrivateFlags);
+        }
+        if (ob) 
+            OutputPrint(L")");
+        OutputPrint(L"\n");
+        OutputPrint(L"Last Attempt Version: 0x%08x\n", EsrtEntry->LastAttemptVersion);
+        OutputPrint(L"Last Attempt Status: %d (%s)\n", EsrtEntry->LastAttemptStatus,
+                    LastAttemptStatusName(EsrtEntry->LastAttemptStatus));
+        OutputPrint(L"\n");
+    }
+
+    return EFI_SUCCESS;
+}
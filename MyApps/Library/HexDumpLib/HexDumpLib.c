@@ -0,0 +1,162 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Shared hex/ASCII dump formatter for the MyApps utilities
+//
+//  Each row is assembled in a stack buffer using a nibble lookup table
+//  and queued as a single string, rather than one Print() (and so one
+//  UnicodeVSPrint + ConOut->OutputString) per byte.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/HexDumpLib.h>
+
+#define MAX_LEAD   48
+#define ROW_SIZE   (MAX_LEAD + 10 + (HEXDUMP_MAX_ROW * 5) + HEXDUMP_MAX_ROW + 8)
+
+STATIC CONST CHAR16 HexDigit[16] = {
+    L'0', L'1', L'2', L'3', L'4', L'5', L'6', L'7',
+    L'8', L'9', L'a', L'b', L'c', L'd', L'e', L'f'
+};
+
+
+STATIC UINTN
+AppendLead( CHAR16 *Row,
+            CONST CHAR16 *Lead )
+{
+    UINTN Pos = 0;
+
+    if (Lead == NULL) {
+        return 0;
+    }
+    while (*Lead != L'\0' && Pos < MAX_LEAD) {
+        Row[Pos++] = *Lead++;
+    }
+
+    return Pos;
+}
+
+
+STATIC UINTN
+AppendOffset( CHAR16 *Row,
+              UINTN Pos,
+              UINT32 Offset )
+{
+    for (INTN Shift = 28; Shift >= 0; Shift -= 4) {
+        Row[Pos++] = HexDigit[(Offset >> Shift) & 0x0f];
+    }
+    Row[Pos++] = L':';
+    Row[Pos++] = L' ';
+
+    return Pos;
+}
+
+
+VOID
+EFIAPI
+HexDump( CONST CHAR16 *Lead,
+         CONST CHAR16 *Indent,
+         CONST VOID   *Data,
+         UINTN        Count,
+         UINTN        BytesPerRow,
+         UINTN        Flags )
+{
+    CONST UINT8 *Ptr = (CONST UINT8 *)Data;
+    CHAR16 Row[ROW_SIZE];
+    UINTN  Offset = 0;
+    UINTN  RowBytes;
+    UINTN  Pos;
+    UINT8  Byte;
+
+    if (Count == 0) {
+        return;
+    }
+    if (BytesPerRow == 0 || BytesPerRow > HEXDUMP_MAX_ROW) {
+        BytesPerRow = 16;
+    }
+
+    do {
+        Pos = AppendLead(Row, (Offset == 0) ? Lead : Indent);
+        if (Flags & HEXDUMP_OFFSET) {
+            Pos = AppendOffset(Row, Pos, (UINT32)Offset);
+        }
+
+        RowBytes = Count - Offset;
+        if (RowBytes > BytesPerRow) {
+            RowBytes = BytesPerRow;
+        }
+
+        for (UINTN i = 0; i < RowBytes; i++) {
+            Byte = Ptr[Offset + i];
+            if (Flags & HEXDUMP_0X) {
+                Row[Pos++] = L'0';
+                Row[Pos++] = L'x';
+                Row[Pos++] = HexDigit[Byte >> 4];
+                Row[Pos++] = HexDigit[Byte & 0x0f];
+                Row[Pos++] = L' ';
+            } else {
+                if (i > 0 && (i % HEXDUMP_GROUP) == 0) {
+                    Row[Pos++] = L' ';
+                }
+                Row[Pos++] = HexDigit[Byte >> 4];
+                Row[Pos++] = HexDigit[Byte & 0x0f];
+            }
+        }
+
+        if (Flags & HEXDUMP_ASCII) {
+            // pad a short last row so the ASCII column lines up
+            for (UINTN i = RowBytes; i < BytesPerRow; i++) {
+                if (Flags & HEXDUMP_0X) {
+                    Row[Pos++] = L' '; Row[Pos++] = L' '; Row[Pos++] = L' ';
+                    Row[Pos++] = L' '; Row[Pos++] = L' ';
+                } else {
+                    if (i > 0 && (i % HEXDUMP_GROUP) == 0) {
+                        Row[Pos++] = L' ';
+                    }
+                    Row[Pos++] = L' '; Row[Pos++] = L' ';
+                }
+            }
+            Row[Pos++] = L' ';
+            Row[Pos++] = L' ';
+            for (UINTN i = 0; i < RowBytes; i++) {
+                Byte = Ptr[Offset + i];
+                Row[Pos++] = (Byte >= 0x20 && Byte < 0x7f) ? (CHAR16)Byte : L'.';
+            }
+        }
+
+        Row[Pos++] = L'\r';
+        Row[Pos++] = L'\n';
+        Row[Pos] = L'\0';
+        OutputString(Row);
+
+        Offset += RowBytes;
+    } while (Offset < Count);
+}
+
+
+CHAR16 *
+EFIAPI
+HexToString( CHAR16       *Buffer,
+             UINTN        BufferSize,
+             CONST VOID   *Data,
+             UINTN        Count )
+{
+    CONST UINT8 *Ptr = (CONST UINT8 *)Data;
+    UINTN Max = BufferSize / sizeof(CHAR16);
+    UINTN Pos = 0;
+
+    if (Max == 0) {
+        return Buffer;
+    }
+    for (UINTN i = 0; i < Count && Pos + 2 < Max; i++) {
+        Buffer[Pos++] = HexDigit[Ptr[i] >> 4];
+        Buffer[Pos++] = HexDigit[Ptr[i] & 0x0f];
+    }
+    Buffer[Pos] = L'\0';
+
+    return Buffer;
+}
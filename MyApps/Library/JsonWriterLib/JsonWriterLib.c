@@ -0,0 +1,496 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Streaming JSON writer for the MyApps utilities
+//
+//  Values are escaped straight into a small chunk buffer and handed to
+//  BufferedOutputLib as they are produced.  Nothing is built up in
+//  memory; the only state kept is one container type and one "needs a
+//  comma" flag per nesting level.  Each top-level record is written
+//  compactly on a single line.  The library destructor closes a record
+//  left open by an early return so the output always parses.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/PrintLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+
+#define JSON_OBJECT   0
+#define JSON_ARRAY    1
+
+#define CHUNK_SIZE    128
+
+STATIC CONST CHAR16 HexDigit[16] = {
+    L'0', L'1', L'2', L'3', L'4', L'5', L'6', L'7',
+    L'8', L'9', L'a', L'b', L'c', L'd', L'e', L'f'
+};
+
+STATIC UINT8   mType[JSON_MAX_DEPTH];
+STATIC BOOLEAN mFirst[JSON_MAX_DEPTH];
+STATIC UINTN   mDepth = 0;
+STATIC UINTN   mOverflow = 0;          // containers opened past JSON_MAX_DEPTH
+STATIC BOOLEAN mTruncated = FALSE;
+
+STATIC CHAR16  mChunk[CHUNK_SIZE + 1];
+STATIC UINTN   mChunkUsed = 0;
+
+
+STATIC VOID
+Drain( VOID )
+{
+    if (mChunkUsed) {
+        mChunk[mChunkUsed] = CHAR_NULL;
+        OutputString(mChunk);
+        mChunkUsed = 0;
+    }
+}
+
+
+STATIC VOID
+Put( CHAR16 Ch )
+{
+    if (mChunkUsed == CHUNK_SIZE) {
+        Drain();
+    }
+    mChunk[mChunkUsed++] = Ch;
+}
+
+
+STATIC VOID
+PutRaw( CONST CHAR16 *Str )
+{
+    while (*Str != CHAR_NULL) {
+        Put(*Str++);
+    }
+}
+
+
+STATIC VOID
+PutEscaped( CHAR16 Ch )
+{
+    switch (Ch) {
+        case L'"':  Put(L'\\'); Put(L'"');  break;
+        case L'\\': Put(L'\\'); Put(L'\\'); break;
+        case L'\b': Put(L'\\'); Put(L'b');  break;
+        case L'\f': Put(L'\\'); Put(L'f');  break;
+        case L'\n': Put(L'\\'); Put(L'n');  break;
+        case L'\r': Put(L'\\'); Put(L'r');  break;
+        case L'\t': Put(L'\\'); Put(L't');  break;
+        default:
+            if (Ch < 0x20 || Ch >= 0x7f) {
+                // keep the stream 7-bit clean
+                Put(L'\\'); Put(L'u');
+                Put(HexDigit[(Ch >> 12) & 0x0f]);
+                Put(HexDigit[(Ch >> 8) & 0x0f]);
+                Put(HexDigit[(Ch >> 4) & 0x0f]);
+                Put(HexDigit[Ch & 0x0f]);
+            } else {
+                Put(Ch);
+            }
+            break;
+    }
+}
+
+
+STATIC VOID
+PutQuoted( CONST CHAR16 *Str )
+{
+    Put(L'"');
+    if (Str != NULL) {
+        while (*Str != CHAR_NULL) {
+            PutEscaped(*Str++);
+        }
+    }
+    Put(L'"');
+}
+
+
+STATIC VOID
+PutDecimal( UINT64 Value )
+{
+    CHAR16 Digits[21];
+    UINTN  Pos = 0;
+    UINT32 Digit;
+
+    do {
+        Value = DivU64x32Remainder(Value, 10, &Digit);
+        Digits[Pos++] = (CHAR16)(L'0' + Digit);
+    } while (Value != 0);
+
+    while (Pos > 0) {
+        Put(Digits[--Pos]);
+    }
+}
+
+
+//
+// Separator and member name ahead of a value.  FALSE if the value is
+// inside a container that was too deep to write, and so is left out.
+//
+STATIC BOOLEAN
+BeginValue( CONST CHAR16 *Name )
+{
+    if (mOverflow) {
+        return FALSE;
+    }
+    if (mDepth == 0) {
+        return TRUE;
+    }
+    if (!mFirst[mDepth - 1]) {
+        Put(L',');
+    }
+    mFirst[mDepth - 1] = FALSE;
+    if (mType[mDepth - 1] == JSON_OBJECT) {
+        PutQuoted(Name);
+        Put(L':');
+    }
+
+    return TRUE;
+}
+
+
+//
+// A complete top-level value ends the record
+//
+STATIC VOID
+EndValue( VOID )
+{
+    if (mDepth == 0) {
+        Put(L'\r');
+        Put(L'\n');
+    }
+    Drain();
+}
+
+
+STATIC VOID
+Open( CONST CHAR16 *Name,
+      UINT8 Type )
+{
+    if (mOverflow || mDepth >= JSON_MAX_DEPTH) {
+        mOverflow++;
+        mTruncated = TRUE;
+        return;
+    }
+
+    BeginValue(Name);
+    Put(Type == JSON_OBJECT ? L'{' : L'[');
+    mType[mDepth] = Type;
+    mFirst[mDepth] = TRUE;
+    mDepth++;
+}
+
+
+STATIC VOID
+Close( UINT8 Type )
+{
+    if (mOverflow) {
+        mOverflow--;
+        return;
+    }
+    ASSERT(mDepth > 0 && mType[mDepth - 1] == Type);
+    if (mDepth == 0) {
+        return;
+    }
+
+    mDepth--;
+    Put(Type == JSON_OBJECT ? L'}' : L']');
+    EndValue();
+}
+
+
+BOOLEAN
+EFIAPI
+JsonInit( UINTN  *Argc,
+          CHAR16 **Argv )
+{
+    BOOLEAN Found = FALSE;
+    UINTN   i = 1;
+
+    while (i < *Argc) {
+        if (!StrCmp(Argv[i], L"--json")) {
+            for (UINTN j = i; j + 1 < *Argc; j++) {
+                Argv[j] = Argv[j + 1];
+            }
+            (*Argc)--;
+            Found = TRUE;
+        } else {
+            i++;
+        }
+    }
+
+    return Found;
+}
+
+
+VOID
+EFIAPI
+JsonDocumentBegin( CONST CHAR16 *Utility,
+                   CONST CHAR16 *Version )
+{
+    JsonObjectBegin(NULL);
+    JsonString(L"utility", Utility);
+    JsonString(L"version", Version);
+}
+
+
+VOID
+EFIAPI
+JsonDocumentEnd( VOID )
+{
+    // close anything an early error path left open
+    mOverflow = 0;
+    if (mTruncated && mDepth > 0) {
+        while (mDepth > 1) {
+            Close(mType[mDepth - 1]);
+        }
+        JsonBool(L"truncated", TRUE);
+    }
+    mTruncated = FALSE;
+    while (mDepth > 0) {
+        Close(mType[mDepth - 1]);
+    }
+}
+
+
+VOID
+EFIAPI
+JsonError( CONST CHAR16 *Format,
+           ... )
+{
+    CHAR16  Value[JSON_VALUE_MAX];
+    VA_LIST Marker;
+
+    VA_START(Marker, Format);
+    UnicodeVSPrint(Value, sizeof(Value), Format, Marker);
+    VA_END(Marker);
+
+    if (mDepth == 0) {
+        OutputPrint(L"ERROR: %s\n", Value);
+        return;
+    }
+
+    mOverflow = 0;
+    while (mDepth > 1) {
+        Close(mType[mDepth - 1]);
+    }
+    JsonString(L"error", Value);
+}
+
+
+VOID
+EFIAPI
+JsonObjectBegin( CONST CHAR16 *Name )
+{
+    Open(Name, JSON_OBJECT);
+}
+
+
+VOID
+EFIAPI
+JsonObjectEnd( VOID )
+{
+    Close(JSON_OBJECT);
+}
+
+
+VOID
+EFIAPI
+JsonArrayBegin( CONST CHAR16 *Name )
+{
+    Open(Name, JSON_ARRAY);
+}
+
+
+VOID
+EFIAPI
+JsonArrayEnd( VOID )
+{
+    Close(JSON_ARRAY);
+}
+
+
+VOID
+EFIAPI
+JsonString( CONST CHAR16 *Name,
+            CONST CHAR16 *Value )
+{
+    if (!BeginValue(Name)) {
+        return;
+    }
+    PutQuoted(Value);
+    EndValue();
+}
+
+
+VOID
+EFIAPI
+JsonAsciiString( CONST CHAR16 *Name,
+                 CONST CHAR8  *Value,
+                 UINTN        Length )
+{
+    UINTN Len = 0;
+
+    while (Len < Length && Value[Len] != '\0') {
+        Len++;
+    }
+    while (Len > 0 && Value[Len - 1] == ' ') {
+        Len--;
+    }
+
+    if (!BeginValue(Name)) {
+        return;
+    }
+    Put(L'"');
+    for (UINTN i = 0; i < Len; i++) {
+        PutEscaped((CHAR16)(UINT8)Value[i]);
+    }
+    Put(L'"');
+    EndValue();
+}
+
+
+VOID
+EFIAPI
+JsonPrint( CONST CHAR16 *Name,
+           CONST CHAR16 *Format,
+           ... )
+{
+    CHAR16  Value[JSON_VALUE_MAX];
+    VA_LIST Marker;
+
+    VA_START(Marker, Format);
+    UnicodeVSPrint(Value, sizeof(Value), Format, Marker);
+    VA_END(Marker);
+
+    JsonString(Name, Value);
+}
+
+
+VOID
+EFIAPI
+JsonUint( CONST CHAR16 *Name,
+          UINT64       Value )
+{
+    if (!BeginValue(Name)) {
+        return;
+    }
+    PutDecimal(Value);
+    EndValue();
+}
+
+
+VOID
+EFIAPI
+JsonInt( CONST CHAR16 *Name,
+         INT64        Value )
+{
+    if (!BeginValue(Name)) {
+        return;
+    }
+    if (Value < 0) {
+        Put(L'-');
+        PutDecimal((UINT64)(-(Value + 1)) + 1);
+    } else {
+        PutDecimal((UINT64)Value);
+    }
+    EndValue();
+}
+
+
+VOID
+EFIAPI
+JsonHex( CONST CHAR16 *Name,
+         UINT64       Value )
+{
+    INTN Shift = 60;
+
+    if (!BeginValue(Name)) {
+        return;
+    }
+    Put(L'"');
+    Put(L'0');
+    Put(L'x');
+    while (Shift > 0 && ((RShiftU64(Value, Shift) & 0x0f) == 0)) {
+        Shift -= 4;
+    }
+    for (; Shift >= 0; Shift -= 4) {
+        Put(HexDigit[RShiftU64(Value, Shift) & 0x0f]);
+    }
+    Put(L'"');
+    EndValue();
+}
+
+
+VOID
+EFIAPI
+JsonBool( CONST CHAR16 *Name,
+          BOOLEAN      Value )
+{
+    if (!BeginValue(Name)) {
+        return;
+    }
+    PutRaw(Value ? L"true" : L"false");
+    EndValue();
+}
+
+
+VOID
+EFIAPI
+JsonNull( CONST CHAR16 *Name )
+{
+    if (!BeginValue(Name)) {
+        return;
+    }
+    PutRaw(L"null");
+    EndValue();
+}
+
+
+VOID
+EFIAPI
+JsonGuid( CONST CHAR16   *Name,
+          CONST EFI_GUID *Guid )
+{
+    CHAR16 Value[40];
+
+    UnicodeSPrint(Value, sizeof(Value), L"%g", Guid);
+    JsonString(Name, Value);
+}
+
+
+VOID
+EFIAPI
+JsonBytes( CONST CHAR16 *Name,
+           CONST VOID   *Data,
+           UINTN        Count )
+{
+    CONST UINT8 *Ptr = (CONST UINT8 *)Data;
+
+    if (!BeginValue(Name)) {
+        return;
+    }
+    Put(L'"');
+    for (UINTN i = 0; i < Count; i++) {
+        Put(HexDigit[Ptr[i] >> 4]);
+        Put(HexDigit[Ptr[i] & 0x0f]);
+    }
+    Put(L'"');
+    EndValue();
+}
+
+
+EFI_STATUS
+EFIAPI
+JsonWriterLibDestructor( EFI_HANDLE ImageHandle,
+                         EFI_SYSTEM_TABLE *SystemTable )
+{
+    JsonDocumentEnd();
+
+    return EFI_SUCCESS;
+}
@@ -0,0 +1,372 @@
+//
+//  Copyright (c) 2017-2018   Finnbarr P. Murphy.   All rights reserved.
+//
+//  PCI bus scan through the root bridge I/O protocol, and vendor and
+//  device names from the pci.ids database (https://pci-ids.ucw.cz/)
+//
+//  License: UDK2015 license applies to code from UDK2015 source,
+//           BSD 2 clause license applies to all other code.
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/ShellLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/PciScanLib.h>
+
+#include <Protocol/PciRootBridgeIo.h>
+
+#define CALC_EFI_PCI_ADDRESS(Bus, Dev, Func, Reg) \
+    ((UINT64) ((((UINTN) Bus) << 24) + (((UINTN) Dev) << 16) + (((UINTN) Func) << 8) + ((UINTN) Reg)))
+
+#define LINE_MAX 1024
+
+STATIC SHELL_FILE_HANDLE mIdsHandle = NULL;
+STATIC CHAR16 *mIdsLine = NULL;
+
+
+STATIC CHAR16 *
+GetDeviceDesc( CHAR16 *Line )
+{
+    STATIC CHAR16 DeviceDesc[LINE_MAX];
+    CHAR16 *s = Line;
+    CHAR16 *d = DeviceDesc;
+
+    s++;
+    while (*s++) {
+        if (*s == L' ' || *s == L'\t')
+           break;
+    }
+
+    while (*s++) {
+        if (*s != L' ' && *s != L'\t')
+           break;
+    }
+
+    while (*s) {
+        *(d++) = *(s++);
+    }
+    *d = 0;
+
+    return DeviceDesc;
+}
+
+
+STATIC CHAR16 *
+GetVendorDesc( CHAR16 *Line )
+{
+    STATIC CHAR16 VendorDesc[LINE_MAX];
+    CHAR16 *s = Line;
+    CHAR16 *d = VendorDesc;
+
+    while (*s++) {
+        if (*s == L' ' || *s == L'\t')
+            break;
+    }
+
+    while (*s++) {
+        if (*s != L' ' && *s != L'\t')
+            break;
+    }
+
+    while (*s) {
+        *(d++) = *(s++);
+    }
+    *d = 0;
+
+    return VendorDesc;
+}
+
+
+STATIC VOID
+LowerCaseStr( CHAR16 *Str )
+{
+    for (int i = 0; Str[i] != L'\0'; i++) {
+        if (Str[i] >= L'A' && Str[i] <= L'Z') {
+            Str[i] -= (CHAR16)(L'A' - L'a');
+        }
+    }
+}
+
+
+//
+// Copyed from UDK2015 Source. UDK2015 license applies.
+//
+STATIC EFI_STATUS
+PciGetNextBusRange( EFI_ACPI_ADDRESS_SPACE_DESCRIPTOR **Descriptors,
+                    UINT16 *MinBus,
+                    UINT16 *MaxBus,
+                    BOOLEAN *IsEnd )
+{
+    *IsEnd = FALSE;
+
+    if ((*Descriptors) == NULL) {
+        *MinBus = 0;
+        *MaxBus = PCI_MAX_BUS;
+        return EFI_SUCCESS;
+    }
+
+    while ((*Descriptors)->Desc != ACPI_END_TAG_DESCRIPTOR) {
+        if ((*Descriptors)->ResType == ACPI_ADDRESS_SPACE_TYPE_BUS) {
+            *MinBus = (UINT16) (*Descriptors)->AddrRangeMin;
+            *MaxBus = (UINT16) (*Descriptors)->AddrRangeMax;
+            (*Descriptors)++;
+            return (EFI_SUCCESS);
+        }
+
+        (*Descriptors)++;
+    }
+
+    if ((*Descriptors)->Desc == ACPI_END_TAG_DESCRIPTOR) {
+        *IsEnd = TRUE;
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+STATIC UINTN
+PciScanBus( EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL *IoDev,
+            UINT16            Bus,
+            PCI_SCAN_CALLBACK Callback,
+            VOID              *Context )
+{
+    PCI_SCAN_ENTRY Entry;
+    UINT64     Address;
+    EFI_STATUS Status;
+    UINTN      Found = 0;
+
+    Entry.Segment = IoDev->SegmentNumber;
+    Entry.Bus = Bus;
+    for (UINT16 Device = 0; Device <= PCI_MAX_DEVICE; Device++) {
+        for (UINT16 Func = 0; Func <= PCI_MAX_FUNC; Func++) {
+            Address = CALC_EFI_PCI_ADDRESS(Bus, Device, Func, 0);
+
+            Status = IoDev->Pci.Read( IoDev,
+                                      EfiPciWidthUint16,
+                                      Address,
+                                      1,
+                                      &Entry.Header.Hdr.VendorId );
+            if (EFI_ERROR(Status) || Entry.Header.Hdr.VendorId == 0xffff) {
+                if (Func == 0) {
+                    break;
+                }
+                continue;
+            }
+
+            Status = IoDev->Pci.Read( IoDev,
+                                      EfiPciWidthUint32,
+                                      Address,
+                                      sizeof(Entry.Header)/sizeof(UINT32),
+                                      &Entry.Header );
+            if (EFI_ERROR(Status)) {
+                continue;
+            }
+
+            Entry.Device = Device;
+            Entry.Function = Func;
+            Callback(&Entry, Context);
+            Found++;
+
+            if (Func == 0 && (Entry.Header.Hdr.HeaderType & HEADER_TYPE_MULTI_FUNCTION) == 0) {
+                break;
+            }
+        }
+    }
+
+    return Found;
+}
+
+
+UINTN
+EFIAPI
+PciScan( EFI_HANDLE        *Handles,
+         UINTN             HandleCount,
+         PCI_SCAN_CALLBACK Callback,
+         VOID              *Context )
+{
+    EFI_PCI_ROOT_BRIDGE_IO_PROTOCOL   *IoDev;
+    EFI_ACPI_ADDRESS_SPACE_DESCRIPTOR *Descriptors;
+    EFI_STATUS Status;
+    UINT16     MinBus, MaxBus;
+    BOOLEAN    IsEnd;
+    UINTN      Found = 0;
+
+    for (UINTN Index = 0; Index < HandleCount; Index++) {
+        Status = gBS->HandleProtocol( Handles[Index],
+                                      &gEfiPciRootBridgeIoProtocolGuid,
+                                      (VOID**)&IoDev );
+        if (EFI_ERROR(Status)) {
+            continue;
+        }
+        // without bus resources every bus number is scanned
+        Status = IoDev->Configuration(IoDev, (VOID**)&Descriptors);
+        if (EFI_ERROR(Status)) {
+            Descriptors = NULL;
+        }
+
+        while (1) {
+            PciGetNextBusRange(&Descriptors, &MinBus, &MaxBus, &IsEnd);
+            if (IsEnd) {
+                break;
+            }
+
+            for (UINT16 Bus = MinBus; Bus <= MaxBus; Bus++) {
+                Found += PciScanBus(IoDev, Bus, Callback, Context);
+            }
+
+            if (Descriptors == NULL) {
+                break;
+            }
+        }
+    }
+
+    return Found;
+}
+
+
+VOID
+EFIAPI
+PciScanJson( PCI_SCAN_ENTRY *Entry )
+{
+    PCI_TYPE00 *Header = &Entry->Header;
+    CHAR16     *VendorName;
+    CHAR16     *DeviceName;
+
+    JsonObjectBegin(NULL);
+    JsonUint(L"segment", Entry->Segment);
+    JsonUint(L"bus", Entry->Bus);
+    JsonUint(L"device", Entry->Device);
+    JsonUint(L"function", Entry->Function);
+    JsonHex(L"vendorId", Header->Hdr.VendorId);
+    JsonHex(L"deviceId", Header->Hdr.DeviceId);
+    if ((Header->Hdr.HeaderType & HEADER_LAYOUT_CODE) == HEADER_TYPE_DEVICE) {
+        JsonHex(L"subsystemVendorId", Header->Device.SubsystemVendorID);
+        JsonHex(L"subsystemId", Header->Device.SubsystemID);
+    }
+    JsonPrint(L"classCode", L"%02x%02x%02x", Header->Hdr.ClassCode[2],
+              Header->Hdr.ClassCode[1], Header->Hdr.ClassCode[0]);
+    JsonHex(L"revisionId", Header->Hdr.RevisionID);
+    if (PciIdsLookup(Header->Hdr.VendorId, Header->Hdr.DeviceId, &VendorName, &DeviceName)) {
+        JsonString(L"vendorName", VendorName);
+        if (DeviceName != NULL) {
+            JsonString(L"deviceName", DeviceName);
+        }
+    }
+    JsonObjectEnd();
+}
+
+
+EFI_STATUS
+EFIAPI
+PciIdsOpen( VOID )
+{
+    CHAR16     *FullFileName;
+    EFI_STATUS Status;
+
+    if (mIdsHandle != NULL) {
+        return EFI_SUCCESS;
+    }
+
+    FullFileName = ShellFindFilePath(PCIDATABASE);
+    if (FullFileName == NULL) {
+        return EFI_NOT_FOUND;
+    }
+
+    Status = ShellOpenFileByName( FullFileName,
+                                  &mIdsHandle,
+                                  EFI_FILE_MODE_READ,
+                                  0 );
+    FreePool(FullFileName);
+    if (EFI_ERROR(Status)) {
+        mIdsHandle = NULL;
+        return Status;
+    }
+
+    // allocate a buffer to read lines into
+    mIdsLine = AllocateZeroPool(LINE_MAX);
+    if (mIdsLine == NULL) {
+        PciIdsClose();
+        return EFI_OUT_OF_RESOURCES;
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+VOID
+EFIAPI
+PciIdsClose( VOID )
+{
+    if (mIdsLine != NULL) {
+        FreePool(mIdsLine);
+        mIdsLine = NULL;
+    }
+    if (mIdsHandle != NULL) {
+        ShellCloseFile(&mIdsHandle);
+        mIdsHandle = NULL;
+    }
+}
+
+
+BOOLEAN
+EFIAPI
+PciIdsLookup( UINT16 VendorId,
+              UINT16 DeviceId,
+              CHAR16 **VendorName,
+              CHAR16 **DeviceName )
+{
+    EFI_STATUS Status = EFI_SUCCESS;
+    BOOLEAN VendorFound = FALSE;
+    BOOLEAN Ascii = TRUE;
+    UINTN   Size = LINE_MAX;
+    CHAR16  Vendor[5];
+    CHAR16  Device[5];
+    CHAR16  *ReadLine = mIdsLine;
+
+    *VendorName = NULL;
+    *DeviceName = NULL;
+
+    if (mIdsHandle == NULL) {
+        return FALSE;
+    }
+
+    UnicodeSPrint(Vendor, sizeof(Vendor), L"%04x", VendorId);
+    LowerCaseStr(Vendor);
+    UnicodeSPrint(Device, sizeof(Device), L"%04x", DeviceId);
+    LowerCaseStr(Device);
+
+    ShellSetFilePosition(mIdsHandle, 0);
+
+    // Read file line by line
+    for (;!ShellFileHandleEof(mIdsHandle); Size = LINE_MAX) {
+        Status = ShellFileHandleReadLine(mIdsHandle, ReadLine, &Size, TRUE, &Ascii);
+        if (Status == EFI_BUFFER_TOO_SMALL) {
+            Status = EFI_SUCCESS;
+        } else if (EFI_ERROR(Status)) {
+            break;
+        }
+
+        // Skip comment and empty lines
+        if (ReadLine[0] == L'#' || ReadLine[0] == L' ' ||
+            ReadLine[0] == L'\n' || ReadLine[0] == L'\r') {
+            continue;
+        }
+
+        if (StrnCmp(ReadLine, Vendor, 4) == 0) {
+            *VendorName = GetVendorDesc(ReadLine);
+            VendorFound = TRUE;
+        } else if (VendorFound && StrnCmp(&ReadLine[1], Device, 4) == 0) {
+            *DeviceName = GetDeviceDesc(ReadLine);
+            break;
+        } else if (VendorFound && (StrnCmp(ReadLine, L"\t", 1) != 0) &&
+                  (StrnCmp(ReadLine, L"\t\t", 2) != 0)) {
+            break;
+        }
+    }
+
+    return VendorFound;
+}
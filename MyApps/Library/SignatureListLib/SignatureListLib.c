@@ -0,0 +1,595 @@
+//
+//  Copyright (c) 2012-2018  Finnbarr P. Murphy.  All rights reserved.
+//
+//  Secure Boot signature database reading and X509 certificate decoding
+//
+//  The do_* functions are the actions the generated x509 decoder calls
+//  as it walks a certificate.  The issuer, subject and extension text
+//  is accumulated in tmpbuf and written out (as text, or as a JSON
+//  member) when the enclosing element ends.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/SignatureListLib.h>
+
+#include "oid_registry.h"
+#include "x509.h"
+#include "asn1_ber_decoder.h"
+
+#define UTCDATE_LEN 23
+
+
+/* temporary store for output text */
+STATIC CHAR16  tmpbuf[1000];
+STATIC int     wrapno = 1;
+
+/* decoder callbacks write JSON members instead of text */
+STATIC BOOLEAN mJson = FALSE;
+
+
+/* accumulated tmpbuf text as a member, minus its leading blank */
+STATIC VOID
+JsonText( CHAR16 *Name,
+          CHAR16 *Str )
+{
+    while (*Str == L' ')
+        Str++;
+    JsonString(Name, Str);
+}
+
+
+STATIC CHAR16 *
+AsciiToUnicode( const char *s, 
+                int len )
+{
+    CHAR16 *ret = NULL;
+    int i;
+
+    ret = AllocateZeroPool(len*2 + 2);
+    if (!ret)
+        return NULL;
+
+    for (i = 0; i < len; i++)
+        ret[i] = s[i];
+
+    return ret;
+}
+
+
+int 
+do_version( void *context, 
+            long state_index,
+            unsigned char tag,
+            const void *value, 
+            long vlen )
+{
+    int version = *(const char *)value;
+
+    if (mJson)
+        JsonUint(L"version", version + 1);
+    else
+        OutputPrint(L"  Version: %d (0x%02x)\n", version + 1, version);
+
+    return 0;
+}
+
+
+int
+do_signature( void *context, 
+              long state_index,
+              unsigned char tag,
+              const void *value,
+              long vlen )
+{
+    if (mJson)
+        JsonText(L"signatureAlgorithm", tmpbuf);
+    else
+        OutputPrint(L"  Signature Algorithm: %s\n", tmpbuf);
+    tmpbuf[0] = '\0';
+
+    return 0;
+}
+
+
+int
+do_algorithm( void *context,
+              long state_index,
+              unsigned char tag,
+              const void *value, 
+              long vlen )
+{
+    enum OID oid; 
+    CHAR16 buffer[100];
+
+    oid = Lookup_OID(value, vlen);
+    Sprint_OID(value, vlen, buffer, sizeof(buffer));
+    if (oid == OID_id_dsa_with_sha1)
+        StrCpy(tmpbuf, L"id_dsa_with_sha1");
+    else if (oid == OID_id_dsa)
+        StrCpy(tmpbuf, L"id_dsa");
+    else if (oid == OID_id_ecdsa_with_sha1)
+        StrCpy(tmpbuf, L"id_ecdsa_with_sha1");
+    else if (oid == OID_id_ecPublicKey)
+        StrCpy(tmpbuf, L"id_ecPublicKey");
+    else if (oid == OID_rsaEncryption)
+        StrCpy(tmpbuf, L"rsaEncryption");
+    else if (oid == OID_md2WithRSAEncryption)
+        StrCpy(tmpbuf, L"md2WithRSAEncryption");
+    else if (oid == OID_md3WithRSAEncryption)
+        StrCpy(tmpbuf, L"md3WithRSAEncryption");
+    else if (oid == OID_md4WithRSAEncryption)
+        StrCpy(tmpbuf, L"md4WithRSAEncryption");
+    else if (oid == OID_sha1WithRSAEncryption)
+        StrCpy(tmpbuf, L"sha1WithRSAEncryption");
+    else if (oid == OID_sha256WithRSAEncryption)
+        StrCpy(tmpbuf, L"sha256WithRSAEncryption");
+    else if (oid == OID_sha384WithRSAEncryption)
+        StrCpy(tmpbuf, L"sha384WithRSAEncryption");
+    else if (oid == OID_sha512WithRSAEncryption)
+        StrCpy(tmpbuf, L"sha512WithRSAEncryption");
+    else if (oid == OID_sha224WithRSAEncryption)
+        StrCpy(tmpbuf, L"sha224WithRSAEncryption");
+    else {
+        StrCat(tmpbuf, L" (");
+        StrCat(tmpbuf, buffer);
+        StrCat(tmpbuf, L")");
+    }
+
+    return 0;
+}
+
+
+int 
+do_serialnumber( void *context, 
+                 long state_index,
+                 unsigned char tag,
+                 const void *value, 
+                 long vlen )
+{
+    int i;
+    char *p = (char *)value;
+
+    if (mJson) {
+        JsonBytes(L"serialNumber", value, vlen);
+        return 0;
+    }
+
+    OutputPrint(L"  Serial Number: ");
+    if (vlen > 4) {
+        for (i = 0; i < vlen; i++, p++) {
+            OutputPrint(L"%02x%c", (UINT8)*p, ((i+1 == vlen)?' ':':'));
+        }
+    }
+    OutputPrint(L"\n");
+
+    return 0;
+}
+
+
+int
+do_issuer( void *context,
+           long  state_index,
+           unsigned char tag,
+           const void *value,
+           long vlen )
+{
+    if (mJson)
+        JsonText(L"issuer", tmpbuf);
+    else
+        OutputPrint(L"  Issuer:%s\n", tmpbuf);
+    tmpbuf[0] = '\0';
+
+    return 0;
+}
+
+
+int
+do_subject( void *context,
+            long state_index,
+            unsigned char tag,
+            const void *value,
+            long vlen )
+{
+    if (mJson)
+        JsonText(L"subject", tmpbuf);
+    else
+        OutputPrint(L"  Subject:%s\n", tmpbuf);
+    tmpbuf[0] = '\0';
+
+    return 0;
+}
+
+
+int
+do_attribute_type( void *context,
+                   long state_index,
+                   unsigned char tag,
+                   const void *value,
+                   long vlen )
+{
+    enum OID oid; 
+    CHAR16 buffer[60];
+
+    oid = Lookup_OID(value, vlen);
+    Sprint_OID(value, vlen, buffer, sizeof(buffer));
+   
+    if (oid == OID_countryName) {
+        StrCat(tmpbuf, L" C=");
+    } else if (oid == OID_stateOrProvinceName) {
+        StrCat(tmpbuf, L" ST=");
+    } else if (oid == OID_locality) {
+        StrCat(tmpbuf, L" L=");
+    } else if (oid == OID_organizationName) {
+        StrCat(tmpbuf, L" O=");
+    } else if (oid == OID_commonName) {
+        StrCat(tmpbuf, L" CN=");
+    } else {
+        StrCat(tmpbuf, L" (");
+        StrCat(tmpbuf, buffer);
+        StrCat(tmpbuf, L")");
+    }
+
+    return 0;
+}
+
+
+int
+do_attribute_value( void *context,
+                    long state_index,
+                    unsigned char tag,
+                    const void *value,
+                    long vlen )
+{
+    CHAR16 *ptr;
+
+    ptr = AsciiToUnicode(value, (int)vlen);
+    StrCat(tmpbuf, ptr);
+    FreePool(ptr);
+
+    return 0;
+}
+
+
+int
+do_extensions( void *context,
+               long state_index,
+               unsigned char tag,
+               const void *value,
+               long vlen )
+{
+    if (mJson)
+        JsonText(L"extensions", tmpbuf);
+    else
+        OutputPrint(L"  Extensions:%s\n", tmpbuf);
+    tmpbuf[0] = '\0';
+    wrapno = 1;
+
+    return 0;
+}
+
+
+int
+do_extension_id( void *context, 
+                 long state_index,
+                 unsigned char tag,
+                 const void *value,
+                 long vlen )
+{
+    enum OID oid; 
+    CHAR16 buffer[60];
+    int len = StrLen(tmpbuf);
+
+    if (len > (90*wrapno)) {
+        // Not sure why a CR is now required in UDK2017.  Need to investigate
+        StrCat(tmpbuf, L"\r\n             ");
+        wrapno++;
+    }
+
+    oid = Lookup_OID(value, vlen);
+    Sprint_OID(value, vlen, buffer, sizeof(buffer));
+
+    if (oid == OID_subjectKeyIdentifier)
+        StrCat(tmpbuf, L" SubjectKeyIdentifier");
+    else if (oid == OID_keyUsage)
+        StrCat(tmpbuf, L" KeyUsage");
+    else if (oid == OID_subjectAltName)
+        StrCat(tmpbuf, L" SubjectAltName");
+    else if (oid == OID_issuerAltName)
+        StrCat(tmpbuf, L" IssuerAltName");
+    else if (oid == OID_basicConstraints)
+        StrCat(tmpbuf, L" BasicConstraints");
+    else if (oid == OID_crlDistributionPoints)
+        StrCat(tmpbuf, L" CrlDistributionPoints");
+    else if (oid == OID_certAuthInfoAccess) 
+        StrCat(tmpbuf, L" CertAuthInfoAccess");
+    else if (oid == OID_certPolicies)
+        StrCat(tmpbuf, L" CertPolicies");
+    else if (oid == OID_authorityKeyIdentifier)
+        StrCat(tmpbuf, L" AuthorityKeyIdentifier");
+    else if (oid == OID_extKeyUsage)
+        StrCat(tmpbuf, L" ExtKeyUsage");
+    else if (oid == OID_msEnrollCerttypeExtension)
+        StrCat(tmpbuf, L" msEnrollCertTypeExtension");
+    else if (oid == OID_msCertsrvCAVersion)
+        StrCat(tmpbuf, L" msCertsrvCAVersion");
+    else if (oid == OID_msCertsrvPreviousCertHash)
+        StrCat(tmpbuf, L" msCertsrvPreviousCertHash");
+    else {
+        StrCat(tmpbuf, L" (");
+        StrCat(tmpbuf, buffer);
+        StrCat(tmpbuf, L")");
+    }
+
+    return 0;
+}
+
+
+//
+//  Yes, a hack but it works!
+//
+STATIC char *
+make_utc_date_string( char *s )
+{
+    static char buffer[50];
+    char  *d;
+
+    d = buffer;
+    *d++ = '2';      /* year */
+    *d++ = '0';
+    *d++ = *s++;
+    *d++ = *s++;
+    *d++ = '-';
+    *d++ = *s++;     /* month */
+    *d++ = *s++;
+    *d++ = '-';
+    *d++ = *s++;     /* day */
+    *d++ = *s++;
+    *d++ = ' ';
+    *d++ = *s++;     /* hour */
+    *d++ = *s++;
+    *d++ = ':';
+    *d++ = *s++;     /* minute */
+    *d++ = *s++;
+    *d++ = ':';
+    *d++ = *s++;     /* second */
+    *d++ = *s;
+    *d++ = ' ';
+    *d++ = 'U';
+    *d++ = 'T';
+    *d++ = 'C';
+     *d = '\0';
+
+    return buffer;
+}
+
+
+int
+do_validity_not_before( void *context,
+                        long state_index,
+                        unsigned char tag,
+                        const void *value, 
+                        long vlen )
+{
+    CHAR16 *ptr;
+    char *p;
+
+    p = make_utc_date_string((char *)value);
+    ptr = AsciiToUnicode(p, UTCDATE_LEN);
+    if (mJson)
+        JsonString(L"notBefore", ptr);
+    else
+        OutputPrint(L"  Validity:  Not Before: %s", ptr);
+    FreePool(ptr);
+
+    return 0;
+}
+
+
+int
+do_validity_not_after( void *context,
+                       long state_index,
+                       unsigned char tag,
+                       const void *value,
+                       long vlen )
+{
+    CHAR16 *ptr;
+    char *p;
+
+    p = make_utc_date_string((char *)value);
+    ptr = AsciiToUnicode(p, UTCDATE_LEN);
+    if (mJson)
+        JsonString(L"notAfter", ptr);
+    else
+        OutputPrint(L"   Not After: %s\n", ptr);
+    FreePool(ptr);
+
+    return 0;
+}
+
+
+int
+do_subject_public_key_info( void *context, 
+                            long state_index,
+                            unsigned char tag,
+                            const void *value, 
+                            long vlen )
+{
+    if (mJson)
+        JsonText(L"subjectPublicKeyAlgorithm", tmpbuf);
+    else
+        OutputPrint(L"  Subject Public Key Algorithm: %s\n", tmpbuf);
+    tmpbuf[0] = '\0';
+
+    return 0;
+}
+
+
+CHAR16 *
+EFIAPI
+SignatureTypeName( EFI_GUID *Type )
+{
+    EFI_GUID gX509 = EFI_CERT_X509_GUID;
+    EFI_GUID gSHA256 = EFI_CERT_SHA256_GUID;
+    EFI_GUID gRSA2048 = EFI_CERT_RSA2048_GUID;
+    EFI_GUID gPKCS7 = EFI_CERT_TYPE_PKCS7_GUID;
+
+    if (CompareGuid(Type, &gX509))
+        return L"X509";
+    if (CompareGuid(Type, &gSHA256))
+        return L"SHA256";
+    if (CompareGuid(Type, &gRSA2048))
+        return L"RSA2048";
+    if (CompareGuid(Type, &gPKCS7))
+        return L"PKCS7";
+
+    return L"Unknown";
+}
+
+
+EFI_STATUS
+EFIAPI
+SignatureListGet( CHAR16   *Name,
+                  EFI_GUID *Owner,
+                  UINT8    **Data,
+                  UINTN    *Size )
+{
+    EFI_STATUS Status;
+
+    *Data = NULL;
+    *Size = 0;
+
+    Status = gRT->GetVariable(Name, Owner, NULL, Size, NULL);
+    if (Status != EFI_BUFFER_TOO_SMALL)
+        return Status;
+
+    *Data = AllocateZeroPool(*Size);
+    if (*Data == NULL)
+        return EFI_OUT_OF_RESOURCES;
+
+    Status = gRT->GetVariable(Name, Owner, NULL, Size, *Data);
+    if (EFI_ERROR(Status)) {
+        FreePool(*Data);
+        *Data = NULL;
+    }
+
+    return Status;
+}
+
+
+//
+// The next list, or NULL once the remaining data cannot hold a whole
+// list with at least one signature slot
+//
+STATIC EFI_SIGNATURE_LIST *
+ValidList( EFI_SIGNATURE_LIST *CertList,
+           UINTN              Remaining )
+{
+    if (Remaining < sizeof(EFI_SIGNATURE_LIST) ||
+        CertList->SignatureListSize < sizeof(EFI_SIGNATURE_LIST) + CertList->SignatureHeaderSize ||
+        Remaining < CertList->SignatureListSize ||
+        CertList->SignatureSize <= sizeof(EFI_GUID))
+        return NULL;
+
+    return CertList;
+}
+
+
+EFI_STATUS
+EFIAPI
+SignatureListCertificates( UINT8   *Data,
+                           UINTN   Size,
+                           BOOLEAN Json )
+{
+    EFI_SIGNATURE_LIST  *CertList = (EFI_SIGNATURE_LIST *)Data;
+    EFI_SIGNATURE_DATA  *Cert;
+    EFI_STATUS Status = EFI_SUCCESS;
+    UINTN Index, DataSize = Size, CertCount = 0;
+    BOOLEAN CertFound = FALSE;
+    UINTN  buflen;
+    CHAR16 *ext;
+
+    mJson = Json;
+
+    while (ValidList(CertList, DataSize) != NULL) {
+        CertCount = (CertList->SignatureListSize - sizeof(EFI_SIGNATURE_LIST) - CertList->SignatureHeaderSize)
+                    / CertList->SignatureSize;
+        Cert = (EFI_SIGNATURE_DATA *) ((UINT8 *) CertList + sizeof (EFI_SIGNATURE_LIST) + CertList->SignatureHeaderSize);
+
+        // should all be X509 but just in case...
+        ext = SignatureTypeName(&CertList->SignatureType);
+
+        for (Index = 0; Index < CertCount; Index++) {
+            if ( CertList->SignatureSize > 100 ) {
+                CertFound = TRUE;
+                if (Json) {
+                    JsonObjectBegin(NULL);
+                    JsonString(L"type", ext);
+                    JsonGuid(L"owner", &Cert->SignatureOwner);
+                } else {
+                    OutputPrint(L"\nType: %s  (GUID: %g)\n", ext, &Cert->SignatureOwner);
+                }
+                tmpbuf[0] = '\0';
+                wrapno = 1;
+                buflen  = CertList->SignatureSize-sizeof(EFI_GUID);
+                if (asn1_ber_decoder(&x509_decoder, NULL, Cert->SignatureData, buflen) < 0) {
+                    if (Json)
+                        JsonString(L"error", (CHAR16 *)asn1_ber_errmsg);
+                    else
+                        OutputPrint(L"ERROR: %s\n", asn1_ber_errmsg);
+                    Status = EFI_COMPROMISED_DATA;
+                }
+                if (Json) {
+                    JsonObjectEnd();
+                }
+            }
+            Cert = (EFI_SIGNATURE_DATA *) ((UINT8 *) Cert + CertList->SignatureSize);
+        }
+        DataSize -= CertList->SignatureListSize;
+        CertList = (EFI_SIGNATURE_LIST *) ((UINT8 *) CertList + CertList->SignatureListSize);
+    }
+
+    if (CertFound == FALSE && !Json) {
+       OutputPrint(L"\nNo certificates found for this database\n");
+    }
+
+    return Status;
+}
+
+
+VOID
+EFIAPI
+SignatureListJson( UINT8 *Data,
+                   UINTN Size )
+{
+    EFI_SIGNATURE_LIST *CertList = (EFI_SIGNATURE_LIST *)Data;
+    EFI_SIGNATURE_DATA *Cert;
+    UINTN      Remaining = Size;
+    UINTN      CertCount;
+
+    while (ValidList(CertList, Remaining) != NULL) {
+        CertCount = (CertList->SignatureListSize - sizeof(EFI_SIGNATURE_LIST) - CertList->SignatureHeaderSize)
+                    / CertList->SignatureSize;
+        Cert = (EFI_SIGNATURE_DATA *)((UINT8 *)CertList + sizeof(EFI_SIGNATURE_LIST) + CertList->SignatureHeaderSize);
+
+        JsonObjectBegin(NULL);
+        JsonString(L"type", SignatureTypeName(&CertList->SignatureType));
+        JsonUint(L"signatureSize", CertList->SignatureSize);
+        JsonUint(L"count", CertCount);
+        if (CertCount > 0) {
+            JsonGuid(L"owner", &Cert->SignatureOwner);
+        }
+        JsonObjectEnd();
+
+        Remaining -= CertList->SignatureListSize;
+        CertList = (EFI_SIGNATURE_LIST *)((UINT8 *)CertList + CertList->SignatureListSize);
+    }
+}
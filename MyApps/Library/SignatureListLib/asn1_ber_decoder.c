@@ -27,6 +27,8 @@
 #include "asn1_ber_decoder.h"
 #include "asn1_ber_bytecode.h"
 
+const CHAR16 *asn1_ber_errmsg = NULL;
+
 static const unsigned char asn1_op_lengths[ASN1_OP__NR] = {
 	/*					OPC TAG JMP ACT */
 	[ASN1_OP_MATCH]				= 1 + 1,
@@ -484,7 +486,7 @@ tag_mismatch:
 long_tag_not_supported:
 	Errmsg = L"Long tag not supported";
 error:
-        Print(L"ERROR: %s\n", Errmsg);
+        asn1_ber_errmsg = Errmsg;
 	return -EBADMSG;
 }
 
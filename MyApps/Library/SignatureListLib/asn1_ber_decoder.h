@@ -29,6 +29,9 @@ typedef long  size_t __attribute__((aligned (8)));
 
 struct asn1_decoder;
 
+/* why the last call failed; the caller reports it */
+extern const CHAR16 *asn1_ber_errmsg;
+
 extern int 
 asn1_ber_decoder( const struct asn1_decoder *decoder,
 		  void *context,
@@ -20,8 +20,6 @@
 
 #include <Uefi.h>
 #include <Library/UefiLib.h>
-#include <Library/ShellCEntryLib.h>
-#include <Library/ShellLib.h>
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
@@ -0,0 +1,537 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  TPM 1.2 and 2.0 command transport and marshalling for the MyApps
+//  utilities
+//
+//  Commands are marshalled big-endian straight into the caller's buffer
+//  and responses are read where the TPM left them; nothing is copied
+//  into intermediate structures.  Every read is checked against the
+//  response length, so a short or corrupt response cannot walk a tool
+//  off the end of its buffer.  The transport is found once per run.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/TscTimerLib.h>
+#include <Library/TpmCommandLib.h>
+
+STATIC BOOLEAN           mOpened = FALSE;
+STATIC TPM_TRANSPORT     mTransport = TpmTransportNone;
+STATIC EFI_TCG2_PROTOCOL *mTcg2 = NULL;
+STATIC EFI_TREE_PROTOCOL *mTrEE = NULL;
+STATIC EFI_TCG_PROTOCOL  *mTcg = NULL;
+STATIC UINT64            mCommands = 0;
+STATIC UINT64            mTicks = 0;
+
+
+EFI_STATUS
+EFIAPI
+TpmOpen( TPM_TRANSPORT *Transport )
+{
+    if (!mOpened) {
+        mOpened = TRUE;
+        if (!EFI_ERROR(gBS->LocateProtocol(&gEfiTcg2ProtocolGuid, NULL, (VOID **) &mTcg2))) {
+            mTransport = TpmTransportTpm20;
+        } else if (!EFI_ERROR(gBS->LocateProtocol(&gEfiTrEEProtocolGuid, NULL, (VOID **) &mTrEE))) {
+            mTcg2 = NULL;
+            mTransport = TpmTransportTpm20;
+        } else if (!EFI_ERROR(gBS->LocateProtocol(&gEfiTcgProtocolGuid, NULL, (VOID **) &mTcg))) {
+            mTcg2 = NULL;
+            mTrEE = NULL;
+            mTransport = TpmTransportTpm12;
+        } else {
+            mTcg2 = NULL;
+            mTrEE = NULL;
+            mTcg = NULL;
+        }
+    }
+
+    if (Transport != NULL) {
+        *Transport = mTransport;
+    }
+
+    return (mTransport == TpmTransportNone) ? EFI_NOT_FOUND : EFI_SUCCESS;
+}
+
+
+TPM_TRANSPORT
+EFIAPI
+TpmTransport( VOID )
+{
+    return mTransport;
+}
+
+
+EFI_TCG2_PROTOCOL *
+EFIAPI
+TpmTcg2( VOID )
+{
+    return mTcg2;
+}
+
+
+EFI_TREE_PROTOCOL *
+EFIAPI
+TpmTrEE( VOID )
+{
+    return mTrEE;
+}
+
+
+EFI_TCG_PROTOCOL *
+EFIAPI
+TpmTcg( VOID )
+{
+    return mTcg;
+}
+
+
+//
+// Room for Size more bytes; sets Overflow if not
+//
+STATIC UINT8 *
+Reserve( TPM_COMMAND *Command,
+         UINTN       Size )
+{
+    UINT8 *Position;
+
+    if (Command->Overflow || Size > Command->Size - Command->Length) {
+        Command->Overflow = TRUE;
+        return NULL;
+    }
+    Position = Command->Buffer + Command->Length;
+    Command->Length += (UINT32) Size;
+
+    return Position;
+}
+
+
+VOID
+EFIAPI
+TpmCommandBegin( TPM_COMMAND *Command,
+                 VOID        *Buffer,
+                 UINT32      Size,
+                 UINT16      Tag,
+                 UINT32      Code )
+{
+    Command->Buffer = Buffer;
+    Command->Size = Size;
+    Command->Length = 0;
+    Command->Overflow = FALSE;
+
+    TpmPutUint16(Command, Tag);
+    TpmPutUint32(Command, 0);            // filled in by TpmSubmit
+    TpmPutUint32(Command, Code);
+}
+
+
+VOID
+EFIAPI
+TpmPutUint8( TPM_COMMAND *Command,
+             UINT8       Value )
+{
+    UINT8 *Position = Reserve(Command, sizeof(UINT8));
+
+    if (Position != NULL) {
+        *Position = Value;
+    }
+}
+
+
+VOID
+EFIAPI
+TpmPutUint16( TPM_COMMAND *Command,
+              UINT16      Value )
+{
+    UINT8 *Position = Reserve(Command, sizeof(UINT16));
+
+    if (Position != NULL) {
+        WriteUnaligned16((UINT16 *) Position, SwapBytes16(Value));
+    }
+}
+
+
+VOID
+EFIAPI
+TpmPutUint32( TPM_COMMAND *Command,
+              UINT32      Value )
+{
+    UINT8 *Position = Reserve(Command, sizeof(UINT32));
+
+    if (Position != NULL) {
+        WriteUnaligned32((UINT32 *) Position, SwapBytes32(Value));
+    }
+}
+
+
+VOID
+EFIAPI
+TpmPutBytes( TPM_COMMAND *Command,
+             CONST VOID  *Data,
+             UINTN       Size )
+{
+    UINT8 *Position = Reserve(Command, Size);
+
+    if (Position != NULL && Size > 0) {
+        CopyMem(Position, Data, Size);
+    }
+}
+
+
+VOID
+EFIAPI
+TpmPutTpm2b( TPM_COMMAND *Command,
+             CONST VOID  *Data,
+             UINT16      Size )
+{
+    TpmPutUint16(Command, Size);
+    TpmPutBytes(Command, Data, Size);
+}
+
+
+UINT8 *
+EFIAPI
+TpmPutReserve( TPM_COMMAND *Command,
+               UINTN       Size )
+{
+    return Reserve(Command, Size);
+}
+
+
+VOID
+EFIAPI
+TpmPutPcrSelection( TPM_COMMAND   *Command,
+                    TPMI_ALG_HASH Alg,
+                    CONST UINT8   *Select )
+{
+    TpmPutUint32(Command, 1);
+    TpmPutUint16(Command, Alg);
+    TpmPutUint8(Command, PCR_SELECT_MAX);
+    TpmPutBytes(Command, Select, PCR_SELECT_MAX);
+}
+
+
+VOID
+EFIAPI
+TpmPutPasswordSession( TPM_COMMAND *Command )
+{
+    TpmPutUint32(Command, sizeof(UINT32) + sizeof(UINT16) + sizeof(UINT8) + sizeof(UINT16));
+    TpmPutUint32(Command, TPM_RS_PW);
+    TpmPutUint16(Command, 0);            // nonce
+    TpmPutUint8(Command, 0);             // session attributes
+    TpmPutUint16(Command, 0);            // password
+}
+
+
+EFI_STATUS
+EFIAPI
+TpmSubmit( TPM_COMMAND  *Command,
+           TPM_RESPONSE *Response,
+           VOID         *ResponseBuffer,
+           UINT32       ResponseSize )
+{
+    EFI_STATUS Status;
+    UINT64     Start;
+    UINT32     Length;
+
+    ZeroMem(Response, sizeof(TPM_RESPONSE));
+    Response->Buffer = ResponseBuffer;
+    Response->Error = TRUE;
+
+    if (Command->Overflow || Command->Length < TPM_HEADER_SIZE) {
+        return EFI_BUFFER_TOO_SMALL;
+    }
+    if (TpmOpen(NULL) != EFI_SUCCESS) {
+        return EFI_NOT_FOUND;
+    }
+    WriteUnaligned32((UINT32 *)(Command->Buffer + sizeof(UINT16)), SwapBytes32(Command->Length));
+
+    Start = TimerTick();
+    if (mTcg2 != NULL) {
+        Status = mTcg2->SubmitCommand( mTcg2,
+                                       Command->Length,
+                                       Command->Buffer,
+                                       ResponseSize,
+                                       ResponseBuffer );
+    } else if (mTrEE != NULL) {
+        Status = mTrEE->SubmitCommand( mTrEE,
+                                       Command->Length,
+                                       Command->Buffer,
+                                       ResponseSize,
+                                       ResponseBuffer );
+    } else {
+        Status = mTcg->PassThroughToTpm( mTcg,
+                                         Command->Length,
+                                         Command->Buffer,
+                                         ResponseSize,
+                                         ResponseBuffer );
+    }
+    mTicks += TimerTick() - Start;
+    mCommands++;
+
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+    if (ResponseSize < TPM_HEADER_SIZE) {
+        return EFI_DEVICE_ERROR;
+    }
+
+    Length = SwapBytes32(ReadUnaligned32((UINT32 *)(Response->Buffer + sizeof(UINT16))));
+    if (Length < TPM_HEADER_SIZE) {
+        return EFI_DEVICE_ERROR;
+    }
+    Response->Length = MIN(Length, ResponseSize);
+    Response->Offset = TPM_HEADER_SIZE;
+    Response->ResponseCode = SwapBytes32(ReadUnaligned32((UINT32 *)(Response->Buffer + sizeof(UINT16) + sizeof(UINT32))));
+    Response->Error = FALSE;
+
+    return (Response->ResponseCode == 0) ? EFI_SUCCESS : EFI_PROTOCOL_ERROR;
+}
+
+
+UINT8 *
+EFIAPI
+TpmGetBytes( TPM_RESPONSE *Response,
+             UINTN        Size )
+{
+    UINT8 *Position;
+
+    if (Response->Error || Size > Response->Length - Response->Offset) {
+        Response->Error = TRUE;
+        return NULL;
+    }
+    Position = Response->Buffer + Response->Offset;
+    Response->Offset += (UINT32) Size;
+
+    return Position;
+}
+
+
+UINT8
+EFIAPI
+TpmGetUint8( TPM_RESPONSE *Response )
+{
+    UINT8 *Position = TpmGetBytes(Response, sizeof(UINT8));
+
+    return (Position != NULL) ? *Position : 0;
+}
+
+
+UINT16
+EFIAPI
+TpmGetUint16( TPM_RESPONSE *Response )
+{
+    UINT8 *Position = TpmGetBytes(Response, sizeof(UINT16));
+
+    return (Position != NULL) ? SwapBytes16(ReadUnaligned16((UINT16 *) Position)) : 0;
+}
+
+
+UINT32
+EFIAPI
+TpmGetUint32( TPM_RESPONSE *Response )
+{
+    UINT8 *Position = TpmGetBytes(Response, sizeof(UINT32));
+
+    return (Position != NULL) ? SwapBytes32(ReadUnaligned32((UINT32 *) Position)) : 0;
+}
+
+
+UINT8 *
+EFIAPI
+TpmGetTpm2b( TPM_RESPONSE *Response,
+             UINT16       *Size )
+{
+    UINT32 Offset = Response->Offset;
+    UINT8  *Data;
+
+    *Size = TpmGetUint16(Response);
+    Data = TpmGetBytes(Response, *Size);
+    if (Data == NULL) {
+        Response->Offset = Offset;
+        *Size = 0;
+    }
+
+    return Data;
+}
+
+
+UINT32
+EFIAPI
+TpmRemaining( TPM_RESPONSE *Response )
+{
+    return Response->Error ? 0 : Response->Length - Response->Offset;
+}
+
+
+VOID
+EFIAPI
+TpmBuildPcrRead( TPM_COMMAND              *Command,
+                 VOID                     *Buffer,
+                 UINT32                   Size,
+                 CONST TPML_PCR_SELECTION *PcrSelectionIn )
+{
+    TpmCommandBegin(Command, Buffer, Size, TPM_ST_NO_SESSIONS, TPM_CC_PCR_Read);
+    TpmPutUint32(Command, PcrSelectionIn->count);
+    for (UINT32 Index = 0; Index < PcrSelectionIn->count && Index < HASH_COUNT; Index++) {
+        TpmPutUint16(Command, PcrSelectionIn->pcrSelections[Index].hash);
+        TpmPutUint8(Command, PcrSelectionIn->pcrSelections[Index].sizeofSelect);
+        TpmPutBytes(Command, PcrSelectionIn->pcrSelections[Index].pcrSelect,
+                    MIN(PcrSelectionIn->pcrSelections[Index].sizeofSelect, PCR_SELECT_MAX));
+    }
+}
+
+
+//
+// Modified from the UDK2015 SecurityPkg Tpm2PcrRead routine
+//
+EFI_STATUS
+EFIAPI
+TpmPcrRead( CONST TPML_PCR_SELECTION *PcrSelectionIn,
+            UINT32                   *PcrUpdateCounter,
+            TPML_PCR_SELECTION       *PcrSelectionOut,
+            TPML_DIGEST              *PcrValues )
+{
+    EFI_STATUS         Status;
+    TPM_COMMAND        Command;
+    TPM_RESPONSE       Response;
+    UINT8              SendBuffer[sizeof(TPM2_COMMAND_HEADER) + sizeof(TPML_PCR_SELECTION)];
+    UINT8              RecvBuffer[sizeof(TPM2_RESPONSE_HEADER) + sizeof(UINT32) + sizeof(TPML_PCR_SELECTION) + sizeof(TPML_DIGEST)];
+    TPMS_PCR_SELECTION *Selection;
+    UINT8              *Data;
+    UINT32             Counter;
+
+    ZeroMem(PcrSelectionOut, sizeof(TPML_PCR_SELECTION));
+    ZeroMem(PcrValues, sizeof(TPML_DIGEST));
+    if (PcrSelectionIn->count > HASH_COUNT) {
+        return EFI_INVALID_PARAMETER;
+    }
+    for (UINT32 Index = 0; Index < PcrSelectionIn->count; Index++) {
+        if (PcrSelectionIn->pcrSelections[Index].sizeofSelect > PCR_SELECT_MAX) {
+            return EFI_INVALID_PARAMETER;
+        }
+    }
+
+    TpmBuildPcrRead(&Command, SendBuffer, sizeof(SendBuffer), PcrSelectionIn);
+    Status = TpmSubmit(&Command, &Response, RecvBuffer, sizeof(RecvBuffer));
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+
+    Counter = TpmGetUint32(&Response);
+    if (PcrUpdateCounter != NULL) {
+        *PcrUpdateCounter = Counter;
+    }
+
+    PcrSelectionOut->count = TpmGetUint32(&Response);
+    if (PcrSelectionOut->count > HASH_COUNT) {
+        PcrSelectionOut->count = 0;
+        return EFI_DEVICE_ERROR;
+    }
+    for (UINT32 Index = 0; Index < PcrSelectionOut->count; Index++) {
+        Selection = &PcrSelectionOut->pcrSelections[Index];
+        Selection->hash = TpmGetUint16(&Response);
+        Selection->sizeofSelect = TpmGetUint8(&Response);
+        if (Selection->sizeofSelect > PCR_SELECT_MAX) {
+            return EFI_DEVICE_ERROR;
+        }
+        Data = TpmGetBytes(&Response, Selection->sizeofSelect);
+        if (Data == NULL) {
+            return EFI_DEVICE_ERROR;
+        }
+        CopyMem(Selection->pcrSelect, Data, Selection->sizeofSelect);
+    }
+
+    PcrValues->count = TpmGetUint32(&Response);
+    if (PcrValues->count > ARRAY_SIZE(PcrValues->digests)) {
+        PcrValues->count = 0;
+        return EFI_DEVICE_ERROR;
+    }
+    for (UINT32 Index = 0; Index < PcrValues->count; Index++) {
+        Data = TpmGetTpm2b(&Response, &PcrValues->digests[Index].size);
+        if (Data == NULL || PcrValues->digests[Index].size > sizeof(PcrValues->digests[Index].buffer)) {
+            return EFI_DEVICE_ERROR;
+        }
+        CopyMem(PcrValues->digests[Index].buffer, Data, PcrValues->digests[Index].size);
+    }
+
+    return Response.Error ? EFI_DEVICE_ERROR : EFI_SUCCESS;
+}
+
+
+VOID
+EFIAPI
+TpmBuildGetCapability( TPM_COMMAND *Command,
+                       VOID        *Buffer,
+                       UINT32      Size,
+                       TPM_CAP     Capability,
+                       UINT32      Property,
+                       UINT32      PropertyCount )
+{
+    TpmCommandBegin(Command, Buffer, Size, TPM_ST_NO_SESSIONS, TPM_CC_GetCapability);
+    TpmPutUint32(Command, Capability);
+    TpmPutUint32(Command, Property);
+    TpmPutUint32(Command, PropertyCount);
+}
+
+
+EFI_STATUS
+EFIAPI
+TpmGetCapability( TPM_CAP      Capability,
+                  UINT32       Property,
+                  UINT32       PropertyCount,
+                  BOOLEAN      *MoreData,
+                  TPM_RESPONSE *Response,
+                  VOID         *ResponseBuffer,
+                  UINT32       ResponseSize )
+{
+    EFI_STATUS  Status;
+    TPM_COMMAND Command;
+    UINT8       SendBuffer[TPM_HEADER_SIZE + 3 * sizeof(UINT32)];
+    UINT8       More;
+
+    TpmBuildGetCapability(&Command, SendBuffer, sizeof(SendBuffer), Capability, Property, PropertyCount);
+    Status = TpmSubmit(&Command, Response, ResponseBuffer, ResponseSize);
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+
+    More = TpmGetUint8(Response);
+    if (TpmGetUint32(Response) != Capability || Response->Error) {
+        Response->Error = TRUE;
+        return EFI_DEVICE_ERROR;
+    }
+    if (MoreData != NULL) {
+        *MoreData = (More != 0);
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+VOID
+EFIAPI
+TpmStatistics( UINT64 *Commands,
+               UINT64 *Microseconds )
+{
+    if (Commands != NULL) {
+        *Commands = mCommands;
+    }
+    if (Microseconds != NULL) {
+        *Microseconds = TimerTicksToMicroseconds(mTicks);
+    }
+}
+
+
+VOID
+EFIAPI
+TpmResetStatistics( VOID )
+{
+    mCommands = 0;
+    mTicks = 0;
+}
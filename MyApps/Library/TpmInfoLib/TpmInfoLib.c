@@ -0,0 +1,485 @@
+//
+//  Copyright (c) 2017-2018   Finnbarr P. Murphy.   All rights reserved.
+//
+//  TPM 2.0 capability and PCR bank reporting
+//
+//  License: UDK2017 license applies to code from UDK2017 sources.
+//           Intel license, shown below, applies to routines from tpm2.0-tools (tpm_*). 
+//           BSD 2 clause license applies to all other code.
+//
+//  Routines containing an underbar in the name were ported from Intel Open Source Technology 
+//  Center tpm2.0-tools and modified for UDK2015 environment and my requirements. 
+//
+//  Original tpm2.0-tools license is:
+//  
+//  Copyright (c) 2015, Intel Corporation
+//  
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  
+//      * Redistributions of source code must retain the above copyright notice,
+//        this list of conditions and the following disclaimer.
+//      * Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//      * Neither the name of Intel Corporation nor the names of its contributors
+//        may be used to endorse or promote products derived from this software
+//        without specific prior written permission.
+//  
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. 
+//  
+
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/TpmCommandLib.h>
+#include <Library/TpmInfoLib.h>
+
+typedef struct {
+    TPMI_ALG_HASH alg;
+    CHAR16 *desc;
+} tpm2_algorithm; 
+
+STATIC tpm2_algorithm algs[] = { 
+    { TPM_ALG_SHA1,    L"TPM_ALG_SHA1" }, 
+    { TPM_ALG_SHA256,  L"TPM_ALG_SHA256" },
+    { TPM_ALG_SHA384,  L"TPM_ALG_SHA384" },
+    { TPM_ALG_SHA512,  L"TPM_ALG_SHA512" }, 
+    { TPM_ALG_SM3_256, L"TPM_ALG_SM3_256" }, 
+    { TPM_ALG_NULL,    L"TPM_ALG_UNKNOWN" }
+};
+
+
+CHAR16 *
+EFIAPI
+TpmManufacturerStr( UINT32 ManufacturerID )
+{
+    STATIC CHAR16 Mcode[5];
+
+    Mcode[0] = (CHAR16) ((ManufacturerID & 0xff000000) >> 24);
+    Mcode[1] = (CHAR16) ((ManufacturerID & 0x00ff0000) >> 16);
+    Mcode[2] = (CHAR16) ((ManufacturerID & 0x0000ff00) >> 8);
+    Mcode[3] = (CHAR16)  (ManufacturerID & 0x000000ff);
+    Mcode[4] = (CHAR16) '\0';
+
+    return Mcode;
+}
+
+
+VOID
+EFIAPI
+TpmCapabilityJson( EFI_TCG2_BOOT_SERVICE_CAPABILITY *CapabilityData )
+{
+    JsonPrint(L"structureVersion", L"%d.%d", CapabilityData->StructureVersion.Major,
+              CapabilityData->StructureVersion.Minor);
+    JsonPrint(L"protocolVersion", L"%d.%d", CapabilityData->ProtocolVersion.Major,
+              CapabilityData->ProtocolVersion.Minor);
+
+    JsonArrayBegin(L"hashAlgorithms");
+    if ((CapabilityData->HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SHA1) != 0) {
+        JsonString(NULL, L"SHA1");
+    }
+    if ((CapabilityData->HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SHA256) != 0) {
+        JsonString(NULL, L"SHA256");
+    }
+    if ((CapabilityData->HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SHA384) != 0) {
+        JsonString(NULL, L"SHA384");
+    }
+    if ((CapabilityData->HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SHA512) != 0) {
+        JsonString(NULL, L"SHA512");
+    }
+    if ((CapabilityData->HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SM3_256) != 0) {
+        JsonString(NULL, L"SM3_256");
+    }
+    JsonArrayEnd();
+
+    JsonArrayBegin(L"eventLogFormats");
+    if ((CapabilityData->SupportedEventLogs & EFI_TCG2_EVENT_LOG_FORMAT_TCG_1_2) != 0) {
+        JsonString(NULL, L"TCG_1.2");
+    }
+    if ((CapabilityData->SupportedEventLogs & EFI_TCG2_EVENT_LOG_FORMAT_TCG_2) != 0) {
+        JsonString(NULL, L"TCG_2");
+    }
+    JsonArrayEnd();
+
+    JsonBool(L"tpmPresent", CapabilityData->TPMPresentFlag);
+    JsonUint(L"maxCommandSize", CapabilityData->MaxCommandSize);
+    JsonUint(L"maxResponseSize", CapabilityData->MaxResponseSize);
+    JsonString(L"manufacturerId", TpmManufacturerStr(CapabilityData->ManufacturerID));
+    JsonUint(L"numberOfPcrBanks", CapabilityData->NumberOfPCRBanks);
+    JsonHex(L"activePcrBanks", CapabilityData->ActivePcrBanks);
+}
+
+
+CONST CHAR16 *
+EFIAPI
+TpmAlgorithmName( TPMI_ALG_HASH alg_id ) 
+{
+    UINT32 i;
+
+    for (i = 0; algs[i].alg != TPM_ALG_NULL; i++) {
+        if (algs[i].alg == alg_id) {
+            break;
+        }
+    }
+
+    return algs[i].desc;
+}
+
+
+STATIC VOID
+Set_PcrSelect_Bit( TPMS_PCR_SELECTION *s, 
+                   UINT32 pcr ) 
+{
+    s->pcrSelect[((pcr) / 8)] |= (1 << ((pcr) % 8));
+}
+
+
+STATIC VOID
+Clear_PcrSelect_Bits( TPMS_PCR_SELECTION *s )
+{
+    s->pcrSelect[0] = 0;
+    s->pcrSelect[1] = 0;
+    s->pcrSelect[2] = 0;
+}
+
+
+STATIC VOID
+Set_PcrSelect_Size( TPMS_PCR_SELECTION *s, 
+                    UINT8 size ) 
+{
+    s->sizeofSelect = size;
+}
+
+
+STATIC BOOLEAN
+Is_PcrSelect_Bit_Set( TPMS_PCR_SELECTION *s, 
+                      UINT32 pcr ) 
+{
+    return (s->pcrSelect[((pcr) / 8)] & (1 << ((pcr) % 8)));
+}
+
+
+STATIC BOOLEAN
+Is_PcrSelect_Empty( TPMS_PCR_SELECTION *s )
+{
+    return !(s->pcrSelect[0] | s->pcrSelect[1] | s->pcrSelect[2]);
+}
+
+
+STATIC BOOLEAN
+Unset_PcrSections( TPML_PCR_SELECTION *s ) 
+{
+    UINT32 i, j;
+
+    for (i = 0; i < s->count; i++) {
+        for (j = 0; j < s->pcrSelections[i].sizeofSelect; j++) {
+            if (s->pcrSelections[i].pcrSelect[j]) {
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+
+STATIC UINT32
+Count_PcrSelect_Bits( TPML_PCR_SELECTION *s )
+{
+    UINT32 i, pcr, count = 0;
+
+    for (i = 0; i < s->count; i++) {
+        for (pcr = 0; pcr < TPM_MAX_PCR; pcr++) {
+            if (Is_PcrSelect_Bit_Set(&s->pcrSelections[i], pcr)) {
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+
+STATIC UINT32
+Find_Bank( TPML_PCR_SELECTION *s,
+           TPMI_ALG_HASH alg )
+{
+    UINT32 i;
+
+    for (i = 0; i < s->count; i++) {
+        if (s->pcrSelections[i].hash == alg) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+
+//
+// Move up to TPM_MAX_PCR_READ_DIGESTS PCRs from pending into request, bank
+// by bank and in ascending PCR order, which is the order the TPM returns
+// the digests in.  A request may span several banks.
+//
+STATIC UINT32
+Next_Pcr_Selection( TPML_PCR_SELECTION *pending,
+                    TPML_PCR_SELECTION *request )
+{
+    TPMS_PCR_SELECTION *r;
+    UINT32 i, pcr, count = 0;
+
+    ZeroMem(request, sizeof(TPML_PCR_SELECTION));
+
+    for (i = 0; i < pending->count && count < TPM_MAX_PCR_READ_DIGESTS; i++) {
+        r = NULL;
+        for (pcr = 0; pcr < TPM_MAX_PCR && count < TPM_MAX_PCR_READ_DIGESTS; pcr++) {
+            if (!Is_PcrSelect_Bit_Set(&pending->pcrSelections[i], pcr)) {
+                continue;
+            }
+            if (r == NULL) {
+                r = &request->pcrSelections[request->count++];
+                r->hash = pending->pcrSelections[i].hash;
+                Set_PcrSelect_Size(r, PCR_SELECT_MAX);
+            }
+            Set_PcrSelect_Bit(r, pcr);
+            pending->pcrSelections[i].pcrSelect[pcr / 8] &= ~(1 << (pcr % 8));
+            count++;
+        }
+    }
+
+    return count;
+}
+
+
+VOID
+EFIAPI
+TpmPcrPrint( TPM_PCR_VALUES *context )
+{
+    TPMS_PCR_SELECTION *read;
+    TPM2B_DIGEST *digest;
+    UINT64 commands, microseconds;
+    UINT32 i;
+
+    for (i = 0; i < context->Selection.count; i++) {
+        CONST CHAR16 *alg_name = TpmAlgorithmName( context->Selection.pcrSelections[i].hash);
+
+        OutputPrint(L"\nBank (Algorithm): %s (0x%04x)\n\n", alg_name,
+                context->Selection.pcrSelections[i].hash);
+
+        read = &context->Read.pcrSelections[i];
+        for (UINT32 pcr_id = 0; pcr_id < TPM_MAX_PCR; pcr_id++) {
+            if (!Is_PcrSelect_Bit_Set(read, pcr_id)) {
+                continue;
+            }
+
+            digest = &context->Digests[i][pcr_id];
+            OutputPrint(L"[%02d] ", pcr_id);
+            for (UINT32 k = 0; k < digest->size; k++)
+                OutputPrint(L" %02x", digest->buffer[k]);
+            OutputPrint(L"\n");
+        }
+        if (Is_PcrSelect_Empty(read)) {
+            OutputPrint(L"Bank not allocated\n");
+        }
+        OutputPrint(L"\n");
+    }
+
+    TpmStatistics(&commands, &microseconds);
+    OutputPrint(L"%d PCRs read in %d TPM2_PCR_Read round trips (at most %d digests each)\n",
+                Count_PcrSelect_Bits(&context->Read), context->RoundTrips, TPM_MAX_PCR_READ_DIGESTS);
+    OutputPrint(L"%ld TPM commands in total, %ld us spent in the TPM\n", commands, microseconds);
+}
+
+
+VOID
+EFIAPI
+TpmPcrJson( TPM_PCR_VALUES *context )
+{
+    TPM2B_DIGEST *digest;
+    UINT64 commands, microseconds;
+    UINT32 i;
+
+    JsonArrayBegin(L"banks");
+    for (i = 0; i < context->Selection.count; i++) {
+        JsonObjectBegin(NULL);
+        JsonString(L"algorithm", TpmAlgorithmName( context->Selection.pcrSelections[i].hash));
+        JsonHex(L"algorithmId", context->Selection.pcrSelections[i].hash);
+        JsonArrayBegin(L"pcrs");
+
+        for (UINT32 pcr_id = 0; pcr_id < TPM_MAX_PCR; pcr_id++) {
+            if (!Is_PcrSelect_Bit_Set(&context->Read.pcrSelections[i], pcr_id)) {
+                continue;
+            }
+
+            digest = &context->Digests[i][pcr_id];
+            JsonObjectBegin(NULL);
+            JsonUint(L"index", pcr_id);
+            JsonBytes(L"digest", digest->buffer, digest->size);
+            JsonObjectEnd();
+        }
+        JsonArrayEnd();
+        JsonObjectEnd();
+    }
+    JsonArrayEnd();
+
+    TpmStatistics(&commands, &microseconds);
+    JsonUint(L"pcrCount", Count_PcrSelect_Bits(&context->Read));
+    JsonUint(L"pcrReadCommands", context->RoundTrips);
+    JsonUint(L"tpmCommands", commands);
+    JsonUint(L"tpmUs", microseconds);
+}
+
+
+//
+// Each command asks for as many PCRs as one response can carry, so N
+// PCRs over any number of banks take N / 8 (rounded up) round trips.
+//
+EFI_STATUS
+EFIAPI
+TpmPcrReadAll( TPM_PCR_VALUES *context )
+{
+    TPML_PCR_SELECTION pending;
+    TPML_PCR_SELECTION request;
+    TPML_PCR_SELECTION pcr_selection_out;
+    TPML_DIGEST pcr_values;
+    UINT32 pcr_update_counter;
+    UINT32 requested, returned, bank;
+    TPM_TRANSPORT Transport;
+    EFI_STATUS Status;
+
+    TpmOpen(&Transport);
+    if (Transport != TpmTransportTpm20) {
+        return EFI_NOT_FOUND;
+    }
+
+    CopyMem(&pending, &context->Selection, sizeof(pending));
+    CopyMem(&context->Read, &context->Selection, sizeof(context->Read));
+    for (UINT32 i = 0; i < context->Read.count; i++) {
+        Clear_PcrSelect_Bits(&context->Read.pcrSelections[i]);
+    }
+    context->RoundTrips = 0;
+
+    while (!Unset_PcrSections(&pending)) {
+        requested = Next_Pcr_Selection(&pending, &request);
+        Status = TpmPcrRead( &request,
+                             &pcr_update_counter,
+                             &pcr_selection_out,
+                             &pcr_values );
+        if (EFI_ERROR (Status)) {
+            return (Status == EFI_PROTOCOL_ERROR) ? EFI_DEVICE_ERROR : Status;
+        }
+        context->RoundTrips++;
+
+        // digests are in pcrSelectionOut order: bank by bank, PCR ascending
+        returned = 0;
+        for (UINT32 i = 0; i < pcr_selection_out.count; i++) {
+            bank = Find_Bank(&context->Selection, pcr_selection_out.pcrSelections[i].hash);
+            for (UINT32 pcr_id = 0; pcr_id < TPM_MAX_PCR; pcr_id++) {
+                if (!Is_PcrSelect_Bit_Set(&pcr_selection_out.pcrSelections[i], pcr_id)) {
+                    continue;
+                }
+                if (bank >= context->Selection.count || returned >= pcr_values.count) {
+                    return EFI_DEVICE_ERROR;
+                }
+                CopyMem(&context->Digests[bank][pcr_id], &pcr_values.digests[returned++], sizeof(TPM2B_DIGEST));
+                Set_PcrSelect_Bit(&context->Read.pcrSelections[bank], pcr_id);
+            }
+        }
+
+        // a TPM that returned fewer digests than asked for is asked again
+        // for the rest; PCRs it never returns are not implemented
+        if (returned > 0 && returned < requested) {
+            for (UINT32 i = 0; i < request.count; i++) {
+                bank = Find_Bank(&context->Selection, request.pcrSelections[i].hash);
+                for (UINT32 pcr_id = 0; pcr_id < TPM_MAX_PCR; pcr_id++) {
+                    if (Is_PcrSelect_Bit_Set(&request.pcrSelections[i], pcr_id) &&
+                        !Is_PcrSelect_Bit_Set(&context->Read.pcrSelections[bank], pcr_id)) {
+                        Set_PcrSelect_Bit(&pending.pcrSelections[bank], pcr_id);
+                    }
+                }
+            }
+        }
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+VOID
+EFIAPI
+TpmPcrSelectBank( TPM_PCR_VALUES *context, 
+                  TPMI_ALG_HASH alg )
+{
+    TPML_PCR_SELECTION *s = &context->Selection;
+
+    s->count = 1;
+    s->pcrSelections[0].hash = alg;
+    Set_PcrSelect_Size(&s->pcrSelections[0], 3);
+    Clear_PcrSelect_Bits(&s->pcrSelections[0]);
+
+    for (UINT32 pcr_id = 0; pcr_id < TPM_MAX_PCR; pcr_id++) {
+        Set_PcrSelect_Bit(&s->pcrSelections[0], pcr_id);
+    }
+}
+
+
+//
+// Every allocated bank and its implemented PCRs, from TPM2_GetCapability
+//
+EFI_STATUS
+EFIAPI
+TpmPcrSelectActive( TPM_PCR_VALUES *context )
+{
+    TPML_PCR_SELECTION *s = &context->Selection;
+    TPMS_PCR_SELECTION *bank;
+    EFI_STATUS   Status;
+    TPM_RESPONSE Response;
+    UINT8        RecvBuffer[sizeof(TPM2_RESPONSE_HEADER) + sizeof(UINT8) + sizeof(UINT32) + sizeof(TPML_PCR_SELECTION) + 16];
+    UINT8        *select;
+    UINT32       count;
+    UINT16       hash;
+    UINT8        size;
+
+    Status = TpmGetCapability(TPM_CAP_PCRS, 0, 1, NULL, &Response, RecvBuffer, sizeof(RecvBuffer));
+    if (EFI_ERROR (Status)) {
+        return Status;
+    }
+
+    count = TpmGetUint32(&Response);
+
+    s->count = 0;
+    for (UINT32 i = 0; i < count && !Response.Error; i++) {
+        hash = TpmGetUint16(&Response);
+        size = TpmGetUint8(&Response);
+        select = TpmGetBytes(&Response, size);
+        if (select == NULL || s->count >= HASH_COUNT) {
+            break;
+        }
+        bank = &s->pcrSelections[s->count];
+        bank->hash = hash;
+        Set_PcrSelect_Size(bank, PCR_SELECT_MAX);
+        Clear_PcrSelect_Bits(bank);
+        CopyMem(bank->pcrSelect, select, MIN(size, PCR_SELECT_MAX));
+        if (!Is_PcrSelect_Empty(bank)) {
+            s->count++;
+        }
+    }
+    if (Response.Error) {
+        return EFI_DEVICE_ERROR;
+    }
+
+    return (s->count > 0) ? EFI_SUCCESS : EFI_NOT_FOUND;
+}
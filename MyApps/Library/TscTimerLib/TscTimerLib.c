@@ -0,0 +1,72 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Time stamp counter based interval timing for the MyApps utilities
+//
+//  MdePkg TimerLib instances are platform specific, so the utilities
+//  read the TSC directly.  The rate is measured once, lazily, so tools
+//  that link the library but never time anything do not pay for the
+//  calibration Stall().
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/TscTimerLib.h>
+
+STATIC UINT64 mFrequency = 0;
+
+
+UINT64
+EFIAPI
+TimerTick( VOID )
+{
+    return AsmReadTsc();
+}
+
+
+UINT64
+EFIAPI
+TimerFrequency( VOID )
+{
+    UINT64 Start;
+    UINT64 End;
+
+    if (mFrequency == 0) {
+        Start = AsmReadTsc();
+        gBS->Stall(TSC_CALIBRATE_US);
+        End = AsmReadTsc();
+        mFrequency = MultU64x32(End - Start, 1000000 / TSC_CALIBRATE_US);
+        if (mFrequency == 0) {
+            mFrequency = 1;
+        }
+    }
+
+    return mFrequency;
+}
+
+
+UINT64
+EFIAPI
+TimerTicksToMicroseconds( UINT64 Ticks )
+{
+    UINT64 Frequency = TimerFrequency();
+    UINT64 Remainder;
+    UINT64 Seconds;
+
+    // split so Ticks * 1000000 cannot overflow
+    Seconds = DivU64x64Remainder(Ticks, Frequency, &Remainder);
+
+    return MultU64x32(Seconds, 1000000) +
+           DivU64x64Remainder(MultU64x32(Remainder, 1000000), Frequency, NULL);
+}
+
+
+UINT64
+EFIAPI
+TimerElapsedMicroseconds( UINT64 StartTick )
+{
+    return TimerTicksToMicroseconds(AsmReadTsc() - StartTick);
+}
@@ -0,0 +1,832 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  ListACPI AML namespace scanner
+//
+//  Walks the AML byte stream of the DSDT and every SSDT once, decoding
+//  package lengths, name strings and the opcodes that open a scope or
+//  declare an object.  Nothing is executed: method bodies and If/Else
+//  blocks are skipped whole, and a scope is abandoned at the first
+//  opcode the scanner does not know how to step over.  The objects go
+//  into an index sorted by name path so lookups are a binary search.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/SortLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/AcpiTableIndexLib.h>
+#include <Library/TscTimerLib.h>
+
+#include "Aml.h"
+
+// opcodes
+#define AML_ZERO_OP            0x00
+#define AML_ONE_OP             0x01
+#define AML_ALIAS_OP           0x06
+#define AML_NAME_OP            0x08
+#define AML_BYTE_PREFIX        0x0a
+#define AML_WORD_PREFIX        0x0b
+#define AML_DWORD_PREFIX       0x0c
+#define AML_STRING_PREFIX      0x0d
+#define AML_QWORD_PREFIX       0x0e
+#define AML_SCOPE_OP           0x10
+#define AML_BUFFER_OP          0x11
+#define AML_PACKAGE_OP         0x12
+#define AML_VAR_PACKAGE_OP     0x13
+#define AML_METHOD_OP          0x14
+#define AML_EXTERNAL_OP        0x15
+#define AML_DUAL_NAME_PREFIX   0x2e
+#define AML_MULTI_NAME_PREFIX  0x2f
+#define AML_EXT_OP             0x5b
+#define AML_ROOT_CHAR          0x5c
+#define AML_PARENT_PREFIX      0x5e
+#define AML_IF_OP              0xa0
+#define AML_ELSE_OP            0xa1
+#define AML_WHILE_OP           0xa2
+#define AML_NOOP_OP            0xa3
+#define AML_ONES_OP            0xff
+
+// second byte of extended opcodes
+#define AML_EXT_MUTEX_OP       0x01
+#define AML_EXT_EVENT_OP       0x02
+#define AML_EXT_REVISION_OP    0x30
+#define AML_EXT_REGION_OP      0x80
+#define AML_EXT_FIELD_OP       0x81
+#define AML_EXT_DEVICE_OP      0x82
+#define AML_EXT_PROCESSOR_OP   0x83
+#define AML_EXT_POWER_RES_OP   0x84
+#define AML_EXT_THERMAL_OP     0x85
+#define AML_EXT_INDEX_FIELD_OP 0x86
+#define AML_EXT_BANK_FIELD_OP  0x87
+
+#define AML_MAX_DEPTH          16        // name segments in a path
+#define AML_MAX_NESTING        32        // nested scopes followed
+#define AML_MAX_TABLES         64
+#define AML_INDEX_CHUNK        1024      // objects added per index growth
+
+// object types in the index
+#define AML_OBJECT_NAME        0
+#define AML_OBJECT_METHOD      1
+#define AML_OBJECT_DEVICE      2
+#define AML_OBJECT_PROCESSOR   3
+#define AML_OBJECT_THERMAL     4
+#define AML_OBJECT_POWER_RES   5
+#define AML_OBJECT_REGION      6
+#define AML_OBJECT_MUTEX       7
+#define AML_OBJECT_EVENT       8
+#define AML_OBJECT_ALIAS       9
+
+#define AML_VALUE_NONE         0
+#define AML_VALUE_INTEGER      1
+#define AML_VALUE_STRING       2
+
+typedef struct {
+    UINT32  Segs[AML_MAX_DEPTH];
+    UINT8   Depth;
+} AML_PATH;
+
+typedef struct {
+    AML_PATH  Path;
+    UINT8     Type;                 // AML_OBJECT_xxx
+    UINT8     Table;                // index into ScanTables
+    UINT8     ArgCount;             // methods only
+    UINT8     ValueType;            // AML_VALUE_xxx, names only
+    UINT32    Offset;               // of the opcode from the start of its table
+    UINT64    Integer;
+    CHAR8     String[12];
+} AML_OBJECT;
+
+typedef struct {
+    EFI_ACPI_DESCRIPTION_HEADER  *Table;
+    UINTN                        Instance;
+} AML_TABLE;
+
+typedef struct {
+    UINTN   Tables;
+    UINTN   Bytes;
+    UINTN   Skipped;                // bytes in scopes abandoned on an unknown opcode
+    UINTN   Conditionals;           // If/Else/While blocks not scanned
+    UINT64  Ticks;
+} AML_STATS;
+
+STATIC AML_OBJECT *Objects = NULL;
+STATIC UINTN      ObjectCount = 0;
+STATIC UINTN      ObjectMax = 0;
+STATIC AML_TABLE  ScanTables[AML_MAX_TABLES];
+STATIC AML_STATS  Stats;
+
+
+static CHAR16 *
+ObjectTypeStr( UINT8 Type )
+{
+    switch (Type) {
+        case AML_OBJECT_NAME:      return L"Name";
+        case AML_OBJECT_METHOD:    return L"Method";
+        case AML_OBJECT_DEVICE:    return L"Device";
+        case AML_OBJECT_PROCESSOR: return L"Processor";
+        case AML_OBJECT_THERMAL:   return L"ThermalZone";
+        case AML_OBJECT_POWER_RES: return L"PowerResource";
+        case AML_OBJECT_REGION:    return L"OperationRegion";
+        case AML_OBJECT_MUTEX:     return L"Mutex";
+        case AML_OBJECT_EVENT:     return L"Event";
+        case AML_OBJECT_ALIAS:     return L"Alias";
+        default:                   return L"Unknown";
+    }
+}
+
+
+static BOOLEAN
+IsScopeObject( UINT8 Type )
+{
+    return Type == AML_OBJECT_DEVICE || Type == AML_OBJECT_PROCESSOR ||
+           Type == AML_OBJECT_THERMAL || Type == AML_OBJECT_POWER_RES;
+}
+
+
+static BOOLEAN
+IsLeadNameChar( UINT8 Char )
+{
+    return (Char >= 'A' && Char <= 'Z') || Char == '_';
+}
+
+
+//
+// Decode a PkgLength.  Returns the first byte after the encoding and
+// the end of the package (the length counts the encoding itself), or
+// NULL if the package does not fit.
+//
+static UINT8 *
+PkgLength( UINT8 *Ptr,
+           UINT8 *End,
+           UINT8 **PkgEnd )
+{
+    UINT8 *Start = Ptr;
+    UINT32 Length;
+    UINTN Follow;
+
+    if (Ptr >= End) {
+        return NULL;
+    }
+    Follow = Ptr[0] >> 6;
+    if (Ptr + 1 + Follow > End) {
+        return NULL;
+    }
+    if (Follow == 0) {
+        Length = Ptr[0] & 0x3f;
+    } else {
+        Length = Ptr[0] & 0x0f;
+        for (UINTN i = 0; i < Follow; i++) {
+            Length |= (UINT32)Ptr[1 + i] << (4 + 8 * i);
+        }
+    }
+    if (Length < 1 + Follow || Start + Length > End) {
+        return NULL;
+    }
+    *PkgEnd = Start + Length;
+
+    return Ptr + 1 + Follow;
+}
+
+
+//
+// Decode a NameString and resolve it against Scope.  Returns the first
+// byte after it, or NULL if it is malformed or too deep to index.
+//
+static UINT8 *
+NameString( UINT8 *Ptr,
+            UINT8 *End,
+            AML_PATH *Scope,
+            AML_PATH *Path )
+{
+    UINTN Count;
+
+    if (Ptr < End && *Ptr == AML_ROOT_CHAR) {
+        Path->Depth = 0;
+        Ptr++;
+    } else {
+        CopyMem(Path, Scope, sizeof(AML_PATH));
+        while (Ptr < End && *Ptr == AML_PARENT_PREFIX) {
+            if (Path->Depth > 0) {
+                Path->Depth--;
+            }
+            Ptr++;
+        }
+    }
+    if (Ptr >= End) {
+        return NULL;
+    }
+
+    if (*Ptr == AML_ZERO_OP) {
+        return Ptr + 1;
+    } else if (*Ptr == AML_DUAL_NAME_PREFIX) {
+        Count = 2;
+        Ptr++;
+    } else if (*Ptr == AML_MULTI_NAME_PREFIX) {
+        if (Ptr + 2 > End) {
+            return NULL;
+        }
+        Count = Ptr[1];
+        Ptr += 2;
+    } else if (IsLeadNameChar(*Ptr)) {
+        Count = 1;
+    } else {
+        return NULL;
+    }
+
+    if (Ptr + 4 * Count > End || Path->Depth + Count > AML_MAX_DEPTH) {
+        return NULL;
+    }
+    for (UINTN i = 0; i < Count; i++, Ptr += 4) {
+        Path->Segs[Path->Depth++] = ReadUnaligned32((UINT32 *)Ptr);
+    }
+
+    return Ptr;
+}
+
+
+//
+// Step over a DataRefObject or simple TermArg, keeping its value in
+// Object if it is an integer or string constant.  Returns NULL for
+// anything that would need evaluating.
+//
+static UINT8 *
+DataObject( UINT8 *Ptr,
+            UINT8 *End,
+            AML_PATH *Scope,
+            AML_OBJECT *Object )
+{
+    AML_PATH Path;
+    UINT8 *PkgEnd;
+    UINT8 *Str;
+    UINTN Size = 0;
+
+    if (Ptr >= End) {
+        return NULL;
+    }
+
+    switch (*Ptr) {
+        case AML_ZERO_OP:
+        case AML_ONE_OP:
+        case AML_ONES_OP:
+            Object->ValueType = AML_VALUE_INTEGER;
+            Object->Integer = (*Ptr == AML_ONES_OP) ? MAX_UINT64 : *Ptr;
+            return Ptr + 1;
+        case AML_BYTE_PREFIX:  Size = 1; break;
+        case AML_WORD_PREFIX:  Size = 2; break;
+        case AML_DWORD_PREFIX: Size = 4; break;
+        case AML_QWORD_PREFIX: Size = 8; break;
+        case AML_STRING_PREFIX:
+            for (Str = Ptr + 1; Str < End && *Str != 0; Str++) {
+                ;
+            }
+            if (Str >= End) {
+                return NULL;
+            }
+            Object->ValueType = AML_VALUE_STRING;
+            CopyMem(Object->String, Ptr + 1, MIN((UINTN)(Str - Ptr - 1), sizeof(Object->String) - 1));
+            return Str + 1;
+        case AML_BUFFER_OP:
+        case AML_PACKAGE_OP:
+        case AML_VAR_PACKAGE_OP:
+            return PkgLength(Ptr + 1, End, &PkgEnd) != NULL ? PkgEnd : NULL;
+        case AML_EXT_OP:
+            return (Ptr + 2 <= End && Ptr[1] == AML_EXT_REVISION_OP) ? Ptr + 2 : NULL;
+        default:
+            // a region offset or length may be a named integer
+            return NameString(Ptr, End, Scope, &Path);
+    }
+
+    if (Ptr + 1 + Size > End) {
+        return NULL;
+    }
+    Object->ValueType = AML_VALUE_INTEGER;
+    Object->Integer = 0;
+    CopyMem(&Object->Integer, Ptr + 1, Size);
+
+    return Ptr + 1 + Size;
+}
+
+
+static AML_OBJECT *
+AddObject( AML_PATH *Path,
+           UINT8 Type,
+           UINT8 Table,
+           UINT8 *Op )
+{
+    AML_OBJECT *Object;
+
+    if (ObjectCount == ObjectMax) {
+        Object = ReallocatePool( ObjectMax * sizeof(AML_OBJECT),
+                                 (ObjectMax + AML_INDEX_CHUNK) * sizeof(AML_OBJECT),
+                                 Objects );
+        if (Object == NULL) {
+            return NULL;
+        }
+        Objects = Object;
+        ObjectMax += AML_INDEX_CHUNK;
+    }
+
+    Object = &Objects[ObjectCount++];
+    ZeroMem(Object, sizeof(AML_OBJECT));
+    CopyMem(&Object->Path, Path, sizeof(AML_PATH));
+    Object->Type = Type;
+    Object->Table = Table;
+    Object->Offset = (UINT32)(Op - (UINT8 *)ScanTables[Table].Table);
+
+    return Object;
+}
+
+
+//
+// Scan one TermList.  Scope and object declarations are followed;
+// anything else ends the list.
+//
+static VOID
+ScanTermList( UINT8 Table,
+              UINT8 *Ptr,
+              UINT8 *End,
+              AML_PATH *Scope,
+              UINTN Nesting )
+{
+    AML_OBJECT *Object;
+    AML_OBJECT Value;
+    AML_PATH Path;
+    AML_PATH Target;
+    UINT8 *Op;
+    UINT8 *PkgEnd;
+    UINT8 Type;
+
+    while (Ptr != NULL && Ptr < End) {
+        Op = Ptr;
+        switch (*Ptr) {
+            case AML_NOOP_OP:
+                Ptr++;
+                break;
+            case AML_SCOPE_OP:
+                Ptr = PkgLength(Ptr + 1, End, &PkgEnd);
+                if (Ptr != NULL && (Ptr = NameString(Ptr, PkgEnd, Scope, &Path)) != NULL) {
+                    if (Nesting < AML_MAX_NESTING) {
+                        ScanTermList(Table, Ptr, PkgEnd, &Path, Nesting + 1);
+                    }
+                    Ptr = PkgEnd;
+                }
+                break;
+            case AML_NAME_OP:
+                ZeroMem(&Value, sizeof(Value));
+                Ptr = NameString(Ptr + 1, End, Scope, &Path);
+                if (Ptr != NULL && (Ptr = DataObject(Ptr, End, Scope, &Value)) != NULL) {
+                    Object = AddObject(&Path, AML_OBJECT_NAME, Table, Op);
+                    if (Object != NULL) {
+                        Object->ValueType = Value.ValueType;
+                        Object->Integer = Value.Integer;
+                        CopyMem(Object->String, Value.String, sizeof(Value.String));
+                    }
+                }
+                break;
+            case AML_METHOD_OP:
+                Ptr = PkgLength(Ptr + 1, End, &PkgEnd);
+                if (Ptr != NULL && (Ptr = NameString(Ptr, PkgEnd, Scope, &Path)) != NULL && Ptr < PkgEnd) {
+                    Object = AddObject(&Path, AML_OBJECT_METHOD, Table, Op);
+                    if (Object != NULL) {
+                        Object->ArgCount = *Ptr & 0x07;
+                    }
+                    Ptr = PkgEnd;
+                } else {
+                    Ptr = NULL;
+                }
+                break;
+            case AML_EXTERNAL_OP:
+                // a reference to an object declared elsewhere
+                Ptr = NameString(Ptr + 1, End, Scope, &Path);
+                Ptr = (Ptr != NULL && Ptr + 2 <= End) ? Ptr + 2 : NULL;
+                break;
+            case AML_ALIAS_OP:
+                Ptr = NameString(Ptr + 1, End, Scope, &Target);
+                if (Ptr != NULL && (Ptr = NameString(Ptr, End, Scope, &Path)) != NULL) {
+                    AddObject(&Path, AML_OBJECT_ALIAS, Table, Op);
+                }
+                break;
+            case AML_IF_OP:
+            case AML_ELSE_OP:
+            case AML_WHILE_OP:
+                // the predicate would have to be evaluated
+                Ptr = PkgLength(Ptr + 1, End, &PkgEnd) != NULL ? PkgEnd : NULL;
+                Stats.Conditionals++;
+                break;
+            case AML_EXT_OP:
+                if (Ptr + 2 > End) {
+                    Ptr = NULL;
+                    break;
+                }
+                switch (Ptr[1]) {
+                    case AML_EXT_DEVICE_OP:
+                    case AML_EXT_THERMAL_OP:
+                    case AML_EXT_PROCESSOR_OP:
+                    case AML_EXT_POWER_RES_OP:
+                        Ptr = PkgLength(Ptr + 2, End, &PkgEnd);
+                        if (Ptr == NULL || (Ptr = NameString(Ptr, PkgEnd, Scope, &Path)) == NULL) {
+                            break;
+                        }
+                        if (Op[1] == AML_EXT_DEVICE_OP) {
+                            Type = AML_OBJECT_DEVICE;
+                        } else if (Op[1] == AML_EXT_THERMAL_OP) {
+                            Type = AML_OBJECT_THERMAL;
+                        } else if (Op[1] == AML_EXT_PROCESSOR_OP) {
+                            Type = AML_OBJECT_PROCESSOR;
+                            Ptr += 6;       // ProcID, PblkAddr, PblkLen
+                        } else {
+                            Type = AML_OBJECT_POWER_RES;
+                            Ptr += 3;       // SystemLevel, ResourceOrder
+                        }
+                        AddObject(&Path, Type, Table, Op);
+                        if (Ptr <= PkgEnd && Nesting < AML_MAX_NESTING) {
+                            ScanTermList(Table, Ptr, PkgEnd, &Path, Nesting + 1);
+                        }
+                        Ptr = PkgEnd;
+                        break;
+                    case AML_EXT_FIELD_OP:
+                    case AML_EXT_INDEX_FIELD_OP:
+                    case AML_EXT_BANK_FIELD_OP:
+                        Ptr = PkgLength(Ptr + 2, End, &PkgEnd) != NULL ? PkgEnd : NULL;
+                        break;
+                    case AML_EXT_MUTEX_OP:
+                        Ptr = NameString(Ptr + 2, End, Scope, &Path);
+                        if (Ptr != NULL && Ptr < End) {
+                            AddObject(&Path, AML_OBJECT_MUTEX, Table, Op);
+                            Ptr++;          // SyncFlags
+                        } else {
+                            Ptr = NULL;
+                        }
+                        break;
+                    case AML_EXT_EVENT_OP:
+                        Ptr = NameString(Ptr + 2, End, Scope, &Path);
+                        if (Ptr != NULL) {
+                            AddObject(&Path, AML_OBJECT_EVENT, Table, Op);
+                        }
+                        break;
+                    case AML_EXT_REGION_OP:
+                        ZeroMem(&Value, sizeof(Value));
+                        Ptr = NameString(Ptr + 2, End, Scope, &Path);
+                        if (Ptr != NULL && Ptr < End) {
+                            AddObject(&Path, AML_OBJECT_REGION, Table, Op);
+                            // an offset or length computed at run time cannot be
+                            // skipped, so the rest of this scope is given up
+                            Ptr = DataObject(Ptr + 1, End, Scope, &Value);      // RegionOffset
+                            if (Ptr != NULL) {
+                                Ptr = DataObject(Ptr, End, Scope, &Value);      // RegionLen
+                            }
+                        } else {
+                            Ptr = NULL;
+                        }
+                        break;
+                    default:
+                        Ptr = NULL;
+                        break;
+                }
+                break;
+            default:
+                Ptr = NULL;
+                break;
+        }
+        if (Ptr == NULL) {
+            Stats.Skipped += End - Op;
+        }
+    }
+}
+
+
+static INTN
+ComparePaths( CONST AML_PATH *Path1,
+              CONST AML_PATH *Path2 )
+{
+    INTN Result;
+
+    for (UINTN i = 0; i < Path1->Depth && i < Path2->Depth; i++) {
+        Result = CompareMem(&Path1->Segs[i], &Path2->Segs[i], sizeof(UINT32));
+        if (Result != 0) {
+            return Result;
+        }
+    }
+
+    return (INTN)Path1->Depth - (INTN)Path2->Depth;
+}
+
+
+static INTN
+EFIAPI
+CompareObjects( CONST VOID *Object1,
+                CONST VOID *Object2 )
+{
+    return ComparePaths(&((AML_OBJECT *)Object1)->Path, &((AML_OBJECT *)Object2)->Path);
+}
+
+
+//
+// First object with exactly this path, by binary search of the index
+//
+static AML_OBJECT *
+FindObject( AML_PATH *Path )
+{
+    UINTN Low = 0;
+    UINTN High = ObjectCount;
+    UINTN Mid;
+
+    while (Low < High) {
+        Mid = (Low + High) / 2;
+        if (ComparePaths(&Objects[Mid].Path, Path) < 0) {
+            Low = Mid + 1;
+        } else {
+            High = Mid;
+        }
+    }
+
+    if (Low < ObjectCount && ComparePaths(&Objects[Low].Path, Path) == 0) {
+        return &Objects[Low];
+    }
+
+    return NULL;
+}
+
+
+//
+// Index the DSDT and every SSDT.  Returns the number of objects.
+//
+static UINTN
+BuildIndex( VOID )
+{
+    EFI_ACPI_DESCRIPTION_HEADER *Table;
+    AML_PATH Root;
+    UINT64 Start = TimerTick();
+    UINTN Count = 0;
+
+    ZeroMem(&Stats, sizeof(Stats));
+    ZeroMem(&Root, sizeof(Root));
+    ObjectCount = 0;
+
+    Table = AcpiIndexFind(EFI_ACPI_2_0_DIFFERENTIATED_SYSTEM_DESCRIPTION_TABLE_SIGNATURE, 0);
+    if (Table != NULL) {
+        ScanTables[Count].Table = Table;
+        ScanTables[Count++].Instance = 0;
+    }
+    for (UINTN i = 0; Count < AML_MAX_TABLES &&
+         (Table = AcpiIndexFind(EFI_ACPI_2_0_SECONDARY_SYSTEM_DESCRIPTION_TABLE_SIGNATURE, i)) != NULL; i++) {
+        ScanTables[Count].Table = Table;
+        ScanTables[Count++].Instance = i;
+    }
+
+    for (UINTN i = 0; i < Count; i++) {
+        Table = ScanTables[i].Table;
+        if (Table->Length <= sizeof(EFI_ACPI_DESCRIPTION_HEADER)) {
+            continue;
+        }
+        ScanTermList( (UINT8)i,
+                      (UINT8 *)Table + sizeof(EFI_ACPI_DESCRIPTION_HEADER),
+                      (UINT8 *)Table + Table->Length,
+                      &Root,
+                      0 );
+        Stats.Bytes += Table->Length - sizeof(EFI_ACPI_DESCRIPTION_HEADER);
+    }
+    Stats.Tables = Count;
+
+    if (ObjectCount > 1) {
+        PerformQuickSort(Objects, ObjectCount, sizeof(AML_OBJECT), CompareObjects);
+    }
+    Stats.Ticks = TimerTick() - Start;
+
+    return ObjectCount;
+}
+
+
+static VOID
+PathToStr( AML_PATH *Path,
+           CHAR16 *Str,
+           UINTN Size )
+{
+    UINTN Pos = 0;
+    CHAR8 *Seg;
+
+    Str[Pos++] = L'\\';
+    for (UINTN i = 0; i < Path->Depth && Pos + 6 < Size / sizeof(CHAR16); i++) {
+        if (i > 0) {
+            Str[Pos++] = L'.';
+        }
+        Seg = (CHAR8 *)&Path->Segs[i];
+        for (UINTN j = 0; j < 4; j++) {
+            Str[Pos++] = (CHAR16)Seg[j];
+        }
+    }
+    Str[Pos] = CHAR_NULL;
+}
+
+
+static VOID
+TableName( UINT8 Table,
+           CHAR16 *Name,
+           UINTN Size )
+{
+    if (ScanTables[Table].Table->Signature == EFI_ACPI_2_0_DIFFERENTIATED_SYSTEM_DESCRIPTION_TABLE_SIGNATURE) {
+        StrCpyS(Name, Size / sizeof(CHAR16), L"DSDT");
+    } else {
+        UnicodeSPrint(Name, Size, L"SSDT%d", ScanTables[Table].Instance + 1);
+    }
+}
+
+
+//
+// Value of a named constant.  _HID and _CID integers are EISA IDs.
+//
+static VOID
+ValueToStr( AML_OBJECT *Object,
+            CHAR16 *Str,
+            UINTN Size )
+{
+    UINT32 Id;
+
+    Str[0] = CHAR_NULL;
+    if (Object->ValueType == AML_VALUE_STRING) {
+        UnicodeSPrint(Str, Size, L"\"%a\"", Object->String);
+    } else if (Object->ValueType == AML_VALUE_INTEGER) {
+        if ((Object->Path.Segs[Object->Path.Depth - 1] == SIGNATURE_32('_','H','I','D') ||
+             Object->Path.Segs[Object->Path.Depth - 1] == SIGNATURE_32('_','C','I','D')) &&
+            Object->Integer <= MAX_UINT32) {
+            Id = SwapBytes32((UINT32)Object->Integer);
+            UnicodeSPrint(Str, Size, L"%c%c%c%04X", ((Id >> 26) & 0x1f) + L'@', ((Id >> 21) & 0x1f) + L'@',
+                          ((Id >> 16) & 0x1f) + L'@', Id & 0xffff);
+        } else {
+            UnicodeSPrint(Str, Size, L"0x%lx", Object->Integer);
+        }
+    }
+}
+
+
+static VOID
+PrintObject( AML_OBJECT *Object,
+             AML_OBJECT *Child )
+{
+    CHAR16 Path[AML_MAX_DEPTH * 5 + 2];
+    CHAR16 Table[8];
+    CHAR16 Value[40];
+
+    PathToStr(&Object->Path, Path, sizeof(Path));
+    TableName(Object->Table, Table, sizeof(Table));
+    OutputPrint(L"  %-13s  %-5s  0x%05x  %s", ObjectTypeStr(Object->Type), Table, Object->Offset, Path);
+    if (Object->Type == AML_OBJECT_METHOD) {
+        OutputPrint(L"  (%d args)", Object->ArgCount);
+    }
+    if (Child != NULL) {
+        ValueToStr(Child, Value, sizeof(Value));
+        OutputPrint(L"  %s", Value);
+    }
+    OutputPrint(L"\n");
+}
+
+
+static VOID
+JsonObject( AML_OBJECT *Object,
+            AML_OBJECT *Child )
+{
+    CHAR16 Path[AML_MAX_DEPTH * 5 + 2];
+    CHAR16 Table[8];
+    CHAR16 Value[40];
+
+    PathToStr(&Object->Path, Path, sizeof(Path));
+    TableName(Object->Table, Table, sizeof(Table));
+    JsonObjectBegin(NULL);
+    JsonString(L"path", Path);
+    JsonString(L"type", ObjectTypeStr(Object->Type));
+    JsonString(L"table", Table);
+    JsonHex(L"offset", Object->Offset);
+    if (Object->Type == AML_OBJECT_METHOD) {
+        JsonUint(L"argCount", Object->ArgCount);
+    }
+    if (Child != NULL) {
+        if (Child->ValueType == AML_VALUE_NONE) {
+            JsonString(L"object", ObjectTypeStr(Child->Type));
+        } else {
+            ValueToStr(Child, Value, sizeof(Value));
+            JsonString(L"value", Value);
+        }
+    }
+    JsonObjectEnd();
+}
+
+
+//
+// Name as typed on the command line to a NameSeg: upper case, padded
+// with underscores
+//
+static BOOLEAN
+QueryToSeg( CONST CHAR16 *Query,
+            UINT32 *Seg )
+{
+    CHAR8 Name[4] = { '_', '_', '_', '_' };
+    UINTN Length = StrLen(Query);
+
+    if (Length == 0 || Length > 4) {
+        return FALSE;
+    }
+    for (UINTN i = 0; i < Length; i++) {
+        Name[i] = (Query[i] >= L'a' && Query[i] <= L'z') ? (CHAR8)(Query[i] - L'a' + 'A') : (CHAR8)Query[i];
+        if (!IsLeadNameChar(Name[i]) && !(i > 0 && Name[i] >= '0' && Name[i] <= '9')) {
+            return FALSE;
+        }
+    }
+    *Seg = ReadUnaligned32((UINT32 *)Name);
+
+    return TRUE;
+}
+
+
+//
+// With no query list every device-like object and method; with a query
+// list the devices, processors, thermal zones and power resources that
+// contain an object of that name, e.g. _PXM or _CST
+//
+EFI_STATUS
+ScanNamespace( CONST CHAR16 *Query,
+               BOOLEAN Json )
+{
+    AML_OBJECT *Parent;
+    AML_PATH Path;
+    UINT32 Seg = 0;
+    UINTN Matches = 0;
+
+    if (Query != NULL && !QueryToSeg(Query, &Seg)) {
+        JsonError(L"Invalid object name %s", Query);
+        return EFI_INVALID_PARAMETER;
+    }
+
+    BuildIndex();
+    if (Stats.Tables == 0) {
+        JsonError(L"No DSDT or SSDT found.");
+        return EFI_NOT_FOUND;
+    }
+
+    if (Json) {
+        JsonObjectBegin(L"namespace");
+        JsonUint(L"tables", Stats.Tables);
+        JsonUint(L"bytes", Stats.Bytes);
+        JsonUint(L"objects", ObjectCount);
+        JsonUint(L"skippedBytes", Stats.Skipped);
+        JsonUint(L"conditionalBlocks", Stats.Conditionals);
+        JsonUint(L"scanUs", TimerTicksToMicroseconds(Stats.Ticks));
+        if (Query != NULL) {
+            JsonString(L"query", Query);
+        }
+        JsonArrayBegin(Query != NULL ? L"matches" : L"objects");
+    }
+
+    for (UINTN i = 0; i < ObjectCount; i++) {
+        if (Query == NULL) {
+            if (!IsScopeObject(Objects[i].Type) && Objects[i].Type != AML_OBJECT_METHOD) {
+                continue;
+            }
+            Parent = &Objects[i];
+        } else {
+            if (Objects[i].Path.Depth == 0 || Objects[i].Path.Segs[Objects[i].Path.Depth - 1] != Seg) {
+                continue;
+            }
+            CopyMem(&Path, &Objects[i].Path, sizeof(Path));
+            Path.Depth--;
+            Parent = FindObject(&Path);
+            if (Parent == NULL || !IsScopeObject(Parent->Type)) {
+                continue;
+            }
+        }
+
+        Matches++;
+        if (Json) {
+            JsonObject(Parent, Query != NULL ? &Objects[i] : NULL);
+        } else {
+            PrintObject(Parent, Query != NULL ? &Objects[i] : NULL);
+        }
+    }
+
+    if (Json) {
+        JsonArrayEnd();
+        JsonObjectEnd();
+    } else {
+        OutputPrint(L"\n  %d %s in %d objects from %d tables (%d bytes, %ld us)",
+                    Matches, Query != NULL ? L"matches" : L"devices and methods", ObjectCount,
+                    Stats.Tables, Stats.Bytes, TimerTicksToMicroseconds(Stats.Ticks));
+        if (Stats.Skipped > 0 || Stats.Conditionals > 0) {
+            OutputPrint(L"\n  %d bytes not scanned, %d conditional blocks skipped", Stats.Skipped, Stats.Conditionals);
+        }
+        OutputPrint(L"\n");
+    }
+
+    if (Objects != NULL) {
+        FreePool(Objects);
+        Objects = NULL;
+        ObjectCount = ObjectMax = 0;
+    }
+
+    return EFI_SUCCESS;
+}
@@ -0,0 +1,17 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  ListACPI AML namespace scanner
+//
+//  License: BSD License
+//
+
+#ifndef _LISTACPI_AML_H_
+#define _LISTACPI_AML_H_
+
+#include <Uefi.h>
+
+// Aml.c
+EFI_STATUS ScanNamespace( CONST CHAR16 *Query, BOOLEAN Json );
+
+#endif
@@ -12,16 +12,23 @@
 #include <Library/ShellLib.h>
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/PrintLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/AcpiTableIndexLib.h>
+#include <Library/TscTimerLib.h>
+#include <Library/DigestLib.h>
+#include <Library/AcpiTableDecodeLib.h>
 
 #include <Protocol/EfiShell.h>
 #include <Protocol/LoadedImage.h>
 #include <Protocol/AcpiSystemDescriptionTable.h>
 
-#include <Guid/Acpi.h>
+#include "Aml.h"
 
-#define UTILITY_VERSION L"20180306"
+#define UTILITY_VERSION L"20181025"
 #undef DEBUG
 
 
@@ -56,75 +63,1019 @@ PrintTable( EFI_ACPI_SDT_HEADER *Ptr,
     AsciiToUnicodeSize((CHAR8 *)&(Ptr->Signature), 4, Buffer1, FALSE);
     AsciiToUnicodeSize((CHAR8 *)&(Ptr->CreatorId), 4, Buffer2, FALSE);
     if ( Verbose ) {
-        Print(L"  %s   0x%02x     %s     0x%08x", Buffer1, (int)(Ptr->Revision), Buffer2, (int)(Ptr->CreatorRevision) );
+        OutputPrint(L"  %s   0x%02x     %s     0x%08x", Buffer1, (int)(Ptr->Revision), Buffer2, (int)(Ptr->CreatorRevision) );
         if (!AsciiStrnCmp( (CHAR8 *)&(Ptr->Signature), "SSDT`", 4)) {
             AsciiToUnicodeSize((CHAR8 *)&(Ptr->OemTableId), 8, Buffer1, TRUE);
-            Print(L"   %s", Buffer1);
+            OutputPrint(L"   %s", Buffer1);
         }
     } else {
-        Print(L"  %s", Buffer1);
+        OutputPrint(L"  %s", Buffer1);
     }
     if (!AsciiStrnCmp( (CHAR8 *)&(Ptr->Signature), "FACP", 4)) {
-        Print(L"  (inc. FACS, DSDT)");
+        OutputPrint(L"  (inc. FACS, DSDT)");
     }
-    Print(L"\n");
+    OutputPrint(L"\n");
+}
+
+
+static VOID
+JsonTable( EFI_ACPI_SDT_HEADER *Ptr )
+{
+    JsonObjectBegin(NULL);
+    JsonAsciiString(L"signature", (CHAR8 *)&(Ptr->Signature), 4);
+    JsonHex(L"address", (UINTN)Ptr);
+    JsonUint(L"length", Ptr->Length);
+    JsonUint(L"revision", Ptr->Revision);
+    JsonAsciiString(L"oemId", (CHAR8 *)(Ptr->OemId), 6);
+    JsonAsciiString(L"oemTableId", (CHAR8 *)&(Ptr->OemTableId), 8);
+    JsonHex(L"oemRevision", Ptr->OemRevision);
+    JsonAsciiString(L"creatorId", (CHAR8 *)&(Ptr->CreatorId), 4);
+    JsonHex(L"creatorRevision", Ptr->CreatorRevision);
+    JsonObjectEnd();
 }
 
 
 static int
-ParseRSDP( EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *Rsdp, 
-           CHAR16* GuidStr,
-           BOOLEAN Verbose )
+ListTables( BOOLEAN Verbose,
+            BOOLEAN Json )
 {
-    EFI_ACPI_SDT_HEADER *Xsdt;
-    UINT32 EntryCount;
-    UINT64 *EntryPtr;
+    EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *Rsdp = AcpiIndexRsdp();
+    CONST ACPI_INDEX_ENTRY *Entry;
+    EFI_ACPI_DESCRIPTION_HEADER *Root;
+    BOOLEAN IsXsdt;
+    UINTN TableCount;
     CHAR16 OemStr[20];
 
 #ifdef DEBUG
-    Print(L"\n\nACPI GUID: %s\n", GuidStr);
+    OutputPrint(L"\n\nACPI GUID: %g\n", AcpiIndexRsdpGuid());
 #endif
 
-    if (Rsdp->Revision >= EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER_REVISION) {
-        if ( Verbose ) {
-            AsciiToUnicodeSize((CHAR8 *)(Rsdp->OemId), 6, OemStr, FALSE);
-            Print(L"\nRSDP Revision: %d  OEM ID: %s\n", (int)(Rsdp->Revision), OemStr);
+    Root = AcpiIndexRoot(&IsXsdt);
+    if ( Json ) {
+        JsonObjectBegin(NULL);
+        JsonGuid(L"guid", AcpiIndexRsdpGuid());
+        JsonUint(L"revision", Rsdp->Revision);
+        JsonAsciiString(L"oemId", (CHAR8 *)(Rsdp->OemId), 6);
+    } else if ( Verbose ) {
+        AsciiToUnicodeSize((CHAR8 *)(Rsdp->OemId), 6, OemStr, FALSE);
+        OutputPrint(L"\nRSDP Revision: %d  OEM ID: %s\n", (int)(Rsdp->Revision), OemStr);
+    }
+
+    if (Root == NULL) {
+        if ( Json ) {
+            JsonString(L"error", L"Invalid ACPI XSDT/RSDT table found.");
+            JsonObjectEnd();
+        } else {
+            OutputPrint(L"ERROR: Invalid ACPI XSDT/RSDT table found.\n");
         }
-        Xsdt = (EFI_ACPI_SDT_HEADER *)(Rsdp->XsdtAddress);
-    } else {
-#ifdef DEBUG
-        Print(L"ERROR: RSDP table < revision ACPI 2.0 found.\n");
-#endif
         return 1;
     }
 
-    if (Xsdt->Signature != SIGNATURE_32 ('X', 'S', 'D', 'T')) {
-        Print(L"ERROR: Invalid ACPI XSDT table found.\n");
-        return 1;
+    // FACS and DSDT come from the FADT and are not root table entries
+    TableCount = 0;
+    for (UINTN Index = 0; Index < AcpiIndexCount(); Index++) {
+        if (!(AcpiIndexEntry(Index)->Flags & ACPI_INDEX_FROM_FADT)) {
+            TableCount++;
+        }
+    }
+
+    if ( Json ) {
+        JsonObjectBegin(IsXsdt ? L"xsdt" : L"rsdt");
+        JsonHex(L"address", (UINTN)Root);
+        JsonUint(L"revision", Root->Revision);
+        JsonAsciiString(L"oemId", (CHAR8 *)(Root->OemId), 6);
+        JsonUint(L"entryCount", TableCount);
+        JsonObjectEnd();
+
+        JsonArrayBegin(L"tables");
+        for (UINTN Index = 0; Index < AcpiIndexCount(); Index++) {
+            Entry = AcpiIndexEntry(Index);
+            if (!(Entry->Flags & ACPI_INDEX_FROM_FADT)) {
+                JsonTable((EFI_ACPI_SDT_HEADER *)Entry->Table);
+            }
+        }
+        JsonArrayEnd();
+        JsonObjectEnd();
+        return 0;
     }
 
-    EntryCount = (Xsdt->Length - sizeof (EFI_ACPI_SDT_HEADER)) / sizeof(UINT64);
     if ( Verbose ) {
-        AsciiToUnicodeSize((CHAR8 *)(Xsdt->OemId), 6, OemStr, FALSE);
-        Print(L"XSDT Revision: %d  OEM ID: %s  Entry Count: %d\n\n", (int)(Xsdt->Revision), OemStr, EntryCount);
+        AsciiToUnicodeSize((CHAR8 *)(Root->OemId), 6, OemStr, FALSE);
+        OutputPrint(L"%s Revision: %d  OEM ID: %s  Entry Count: %d\n\n", IsXsdt ? L"XSDT" : L"RSDT",
+                    (int)(Root->Revision), OemStr, TableCount);
 
-        Print(L" Table Revision CreatorID  CreatorRev\n");
+        OutputPrint(L" Table Revision CreatorID  CreatorRev\n");
     }
- 
-    EntryPtr = (UINT64 *)(Xsdt + 1);
-    for (int Index = 0; Index < EntryCount; Index++, EntryPtr++) {
-        PrintTable((EFI_ACPI_SDT_HEADER *)((UINTN)(*EntryPtr)), Verbose);
+
+    for (UINTN Index = 0; Index < AcpiIndexCount(); Index++) {
+        Entry = AcpiIndexEntry(Index);
+        if (!(Entry->Flags & ACPI_INDEX_FROM_FADT)) {
+            PrintTable((EFI_ACPI_SDT_HEADER *)Entry->Table, Verbose);
+        }
     }
 
     return 0;
 }
 
 
+//
+// Check one root table entry: non-zero and pointing at something with
+// at least a table header's worth of length
+//
+static BOOLEAN
+RootEntryValid( UINT64 Address )
+{
+    EFI_ACPI_DESCRIPTION_HEADER *Table = (EFI_ACPI_DESCRIPTION_HEADER *)(UINTN)Address;
+
+    return Address != 0 && Table->Length >= sizeof(EFI_ACPI_DESCRIPTION_HEADER);
+}
+
+
+//
+// Report any two indexed tables whose memory overlaps.  Entries are
+// sorted by address so only neighbours need comparing.
+//
+static UINTN
+CheckOverlaps( BOOLEAN Json )
+{
+    UINTN Order[ACPI_INDEX_MAX_TABLES];
+    UINTN Count = AcpiIndexCount();
+    UINTN Overlaps = 0;
+    UINTN Last = 0;
+    UINTN j, Tmp;
+    CONST ACPI_INDEX_ENTRY *A, *B;
+    CHAR16 Sig1[8], Sig2[8];
+
+    for (UINTN i = 0; i < Count; i++) {
+        Order[i] = i;
+        for (j = i; j > 0 && AcpiIndexEntry(Order[j - 1])->Table > AcpiIndexEntry(Order[j])->Table; j--) {
+            Tmp = Order[j];
+            Order[j] = Order[j - 1];
+            Order[j - 1] = Tmp;
+        }
+    }
+
+    if (Json) {
+        JsonArrayBegin(L"overlaps");
+    }
+    // Last is the entry reaching furthest so far, which catches a table
+    // that overlaps one that is not its immediate neighbour
+    for (UINTN i = 1; i < Count; i++) {
+        A = AcpiIndexEntry(Order[Last]);
+        B = AcpiIndexEntry(Order[i]);
+        if ((UINTN)B->Table < (UINTN)A->Table + A->Length) {
+            Overlaps++;
+            if (Json) {
+                JsonObjectBegin(NULL);
+                JsonAsciiString(L"first", (CHAR8 *)&(A->Signature), 4);
+                JsonHex(L"firstAddress", (UINTN)A->Table);
+                JsonUint(L"firstLength", A->Length);
+                JsonAsciiString(L"second", (CHAR8 *)&(B->Signature), 4);
+                JsonHex(L"secondAddress", (UINTN)B->Table);
+                JsonUint(L"secondLength", B->Length);
+                JsonObjectEnd();
+            } else {
+                AsciiToUnicodeSize((CHAR8 *)&(A->Signature), 4, Sig1, FALSE);
+                AsciiToUnicodeSize((CHAR8 *)&(B->Signature), 4, Sig2, FALSE);
+                OutputPrint(L"  OVERLAP  %s 0x%lx-0x%lx and %s 0x%lx-0x%lx\n",
+                            Sig1, (UINT64)(UINTN)A->Table, (UINT64)((UINTN)A->Table + A->Length - 1),
+                            Sig2, (UINT64)(UINTN)B->Table, (UINT64)((UINTN)B->Table + B->Length - 1));
+            }
+        }
+        if ((UINTN)B->Table + B->Length > (UINTN)A->Table + A->Length) {
+            Last = i;
+        }
+    }
+    if (Json) {
+        JsonArrayEnd();
+    }
+
+    return Overlaps;
+}
+
+
+//
+// Verify the RSDP checksums, the XSDT/RSDT bounds and entries, every
+// indexed table's checksum, and that no two tables overlap
+//
+static EFI_STATUS
+CheckTables( BOOLEAN Json )
+{
+    EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *Rsdp = AcpiIndexRsdp();
+    EFI_ACPI_DESCRIPTION_HEADER *Root;
+    CONST ACPI_INDEX_ENTRY *Entry;
+    BOOLEAN IsXsdt;
+    BOOLEAN RsdpValid, ExtendedValid = TRUE, RootValid, LengthValid, Valid;
+    BOOLEAN TableValid[ACPI_INDEX_MAX_TABLES];
+    UINTN   EntrySize, EntryCount, BadEntries = 0;
+    UINTN   Corrupt = 0, Overlaps, Tables = 0;
+    UINT64  Bytes = 0, Start, Elapsed;
+    UINT64  Address;
+    CHAR16  Sig[8];
+
+    // ACPI 1.0 checksum covers the first 20 bytes, the extended one all of it
+    RsdpValid = AcpiIndexChecksum(Rsdp, OFFSET_OF(EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER, Length)) == 0;
+    if (Rsdp->Revision >= EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER_REVISION) {
+        ExtendedValid = Rsdp->Length >= sizeof(EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER) &&
+                        AcpiIndexChecksum(Rsdp, Rsdp->Length) == 0;
+    }
+
+    if (Json) {
+        JsonObjectBegin(L"rsdp");
+        JsonHex(L"address", (UINTN)Rsdp);
+        JsonUint(L"revision", Rsdp->Revision);
+        JsonBool(L"checksumValid", RsdpValid);
+        if (Rsdp->Revision >= EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER_REVISION) {
+            JsonBool(L"extendedChecksumValid", ExtendedValid);
+        }
+        JsonObjectEnd();
+    } else {
+        OutputPrint(L"\nRSDP Revision: %d  Checksum: %s", (int)(Rsdp->Revision), RsdpValid ? L"OK" : L"BAD");
+        if (Rsdp->Revision >= EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER_REVISION) {
+            OutputPrint(L"  Extended Checksum: %s", ExtendedValid ? L"OK" : L"BAD");
+        }
+        OutputPrint(L"\n");
+    }
+
+    Root = AcpiIndexRoot(&IsXsdt);
+    if (Root == NULL) {
+        JsonError(L"Invalid ACPI XSDT/RSDT table found.");
+        return EFI_VOLUME_CORRUPTED;
+    }
+
+    Start = TimerTick();
+
+    // root table: whole number of entries, each pointing at a table
+    EntrySize = IsXsdt ? sizeof(UINT64) : sizeof(UINT32);
+    LengthValid = ((Root->Length - sizeof(EFI_ACPI_DESCRIPTION_HEADER)) % EntrySize) == 0;
+    EntryCount = (Root->Length - sizeof(EFI_ACPI_DESCRIPTION_HEADER)) / EntrySize;
+    for (UINTN i = 0; i < EntryCount; i++) {
+        Address = 0;
+        CopyMem(&Address, (UINT8 *)(Root + 1) + (i * EntrySize), EntrySize);
+        if (!RootEntryValid(Address)) {
+            BadEntries++;
+        }
+    }
+    RootValid = AcpiIndexChecksum(Root, Root->Length) == 0;
+    Bytes += Root->Length;
+    if (!RootValid || !LengthValid || BadEntries > 0) {
+        Corrupt++;
+    }
+
+    for (UINTN i = 0; (Entry = AcpiIndexEntry(i)) != NULL; i++) {
+        // FACS has no checksum; only its length can be checked
+        if (Entry->Flags & ACPI_INDEX_NO_CHECKSUM) {
+            Valid = Entry->Length >= sizeof(EFI_ACPI_2_0_FIRMWARE_ACPI_CONTROL_STRUCTURE);
+        } else {
+            Valid = Entry->Length >= sizeof(EFI_ACPI_DESCRIPTION_HEADER) &&
+                    AcpiIndexChecksum(Entry->Table, Entry->Length) == 0;
+            Bytes += Entry->Length;
+            Tables++;
+        }
+        if (!Valid) {
+            Corrupt++;
+        }
+        TableValid[i] = Valid;
+    }
+
+    // only the checks are timed; the results are printed afterwards
+    Elapsed = TimerElapsedMicroseconds(Start);
+
+    if (Json) {
+        JsonObjectBegin(IsXsdt ? L"xsdt" : L"rsdt");
+        JsonHex(L"address", (UINTN)Root);
+        JsonUint(L"length", Root->Length);
+        JsonBool(L"lengthValid", LengthValid);
+        JsonUint(L"entryCount", EntryCount);
+        JsonUint(L"badEntries", BadEntries);
+        JsonBool(L"checksumValid", RootValid);
+        JsonObjectEnd();
+        JsonArrayBegin(L"tables");
+    } else {
+        OutputPrint(L"%s Length: %d (%s)  Entries: %d  Bad Entries: %d  Checksum: %s\n\n",
+                    IsXsdt ? L"XSDT" : L"RSDT", Root->Length, LengthValid ? L"OK" : L"BAD",
+                    EntryCount, BadEntries, RootValid ? L"OK" : L"BAD");
+        OutputPrint(L" Table  Address             Length  Checksum\n");
+    }
+
+    for (UINTN i = 0; (Entry = AcpiIndexEntry(i)) != NULL; i++) {
+        Valid = TableValid[i];
+        if (Json) {
+            JsonObjectBegin(NULL);
+            JsonAsciiString(L"signature", (CHAR8 *)&(Entry->Signature), 4);
+            JsonHex(L"address", (UINTN)Entry->Table);
+            JsonUint(L"length", Entry->Length);
+            if (Entry->Flags & ACPI_INDEX_NO_CHECKSUM) {
+                JsonBool(L"lengthValid", Valid);
+            } else {
+                JsonBool(L"checksumValid", Valid);
+            }
+            JsonObjectEnd();
+        } else {
+            AsciiToUnicodeSize((CHAR8 *)&(Entry->Signature), 4, Sig, FALSE);
+            OutputPrint(L"  %s   0x%016lx  %7d  %s\n", Sig, (UINT64)(UINTN)Entry->Table, Entry->Length,
+                        (Entry->Flags & ACPI_INDEX_NO_CHECKSUM) ? (Valid ? L"n/a" : L"BAD LENGTH") :
+                        (Valid ? L"OK" : L"BAD"));
+        }
+    }
+
+    if (Json) {
+        JsonArrayEnd();
+    } else {
+        OutputPrint(L"\n");
+    }
+
+    Overlaps = CheckOverlaps(Json);
+
+    // bytes per microsecond is MB per second
+    if (Json) {
+        JsonUint(L"corrupt", Corrupt);
+        JsonUint(L"overlapCount", Overlaps);
+        JsonUint(L"tablesVerified", Tables);
+        JsonUint(L"bytesVerified", Bytes);
+        JsonUint(L"elapsedUs", Elapsed);
+        JsonUint(L"throughputMBs", Elapsed ? DivU64x64Remainder(Bytes, Elapsed, NULL) : 0);
+    } else {
+        OutputPrint(L"%d table(s) corrupt, %d overlap(s)\n", Corrupt, Overlaps);
+        OutputPrint(L"Verified %ld bytes in %d tables in %ld us", Bytes, Tables, Elapsed);
+        if (Elapsed) {
+            OutputPrint(L" (%ld MB/s)", DivU64x64Remainder(Bytes, Elapsed, NULL));
+        }
+        OutputPrint(L"\n");
+    }
+
+    if (!RsdpValid || !ExtendedValid || Corrupt > 0 || Overlaps > 0) {
+        return EFI_CRC_ERROR;
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+//
+// One table in acpidump format: a "SIG @ 0xADDRESS" line, then 16 bytes
+// of hex and ASCII per line, then a blank line.  This is what acpixtract
+// and iasl -d expect.  Lines are built by hand straight from the table,
+// one buffered write each.
+//
+static VOID
+DumpTable( OUTPUT_FILE *File,
+           CONST CHAR8 *Signature,
+           VOID *Table,
+           UINTN Length )
+{
+    STATIC CONST CHAR8 Hex[] = "0123456789ABCDEF";
+    UINT8  *Ptr = Table;
+    CHAR8  Line[96];
+    CHAR8  Offset[16];
+    UINTN  Count, Pos, Width;
+
+    OutputFilePrint(File, "%a @ 0x%016lX\n", Signature, (UINT64)(UINTN)Table);
+
+    for (UINTN Off = 0; Off < Length; Off += 16) {
+        Count = MIN(16, Length - Off);
+
+        // offset right aligned in 8 columns, at least 4 digits
+        Width = AsciiSPrint(Offset, sizeof(Offset), "%04X", Off);
+        Pos = 0;
+        while (Pos + Width < 8) {
+            Line[Pos++] = ' ';
+        }
+        CopyMem(&Line[Pos], Offset, Width);
+        Pos += Width;
+        Line[Pos++] = ':';
+        Line[Pos++] = ' ';
+
+        for (UINTN i = 0; i < 16; i++) {
+            if (i < Count) {
+                Line[Pos++] = Hex[Ptr[Off + i] >> 4];
+                Line[Pos++] = Hex[Ptr[Off + i] & 0x0f];
+            } else {
+                Line[Pos++] = ' ';
+                Line[Pos++] = ' ';
+            }
+            Line[Pos++] = ' ';
+        }
+        Line[Pos++] = ' ';
+        for (UINTN i = 0; i < Count; i++) {
+            Line[Pos++] = (Ptr[Off + i] >= 0x20 && Ptr[Off + i] < 0x7f) ? Ptr[Off + i] : '.';
+        }
+        Line[Pos++] = '\n';
+
+        OutputFileWrite(File, Line, Pos);
+    }
+
+    OutputFileWrite(File, "\n", 1);
+}
+
+
+//
+// Length of the RSDP: the extended length only exists from revision 2
+//
+static UINTN
+RsdpLength( EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *Rsdp )
+{
+    if (Rsdp->Revision >= EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER_REVISION) {
+        return Rsdp->Length;
+    }
+
+    return OFFSET_OF(EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER, Length);
+}
+
+
+//
+// XSDT and RSDT, whichever the RSDP points at and are valid.  The index
+// only keeps the one it walked.
+//
+static UINTN
+RootTables( EFI_ACPI_DESCRIPTION_HEADER **Roots )
+{
+    EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *Rsdp = AcpiIndexRsdp();
+    EFI_ACPI_DESCRIPTION_HEADER *Table;
+    UINTN Count = 0;
+
+    if (Rsdp->Revision >= EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER_REVISION && Rsdp->XsdtAddress != 0) {
+        Table = (EFI_ACPI_DESCRIPTION_HEADER *)(UINTN)Rsdp->XsdtAddress;
+        if (Table->Signature == EFI_ACPI_2_0_EXTENDED_SYSTEM_DESCRIPTION_TABLE_SIGNATURE) {
+            Roots[Count++] = Table;
+        }
+    }
+    if (Rsdp->RsdtAddress != 0) {
+        Table = (EFI_ACPI_DESCRIPTION_HEADER *)(UINTN)Rsdp->RsdtAddress;
+        if (Table->Signature == EFI_ACPI_1_0_ROOT_SYSTEM_DESCRIPTION_TABLE_SIGNATURE) {
+            Roots[Count++] = Table;
+        }
+    }
+
+    return Count;
+}
+
+
+//
+// Write every table (RSDP, XSDT/RSDT, root table entries, FACS and DSDT)
+// to one acpidump format text file
+//
+static EFI_STATUS
+DumpTables( CONST CHAR16 *FileName,
+            UINTN *Tables,
+            UINT64 *Bytes )
+{
+    EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *Rsdp = AcpiIndexRsdp();
+    EFI_ACPI_DESCRIPTION_HEADER *Roots[2];
+    CONST ACPI_INDEX_ENTRY *Entry;
+    OUTPUT_FILE File;
+    EFI_STATUS  Status;
+    CHAR8       Sig[5];
+    UINTN       RootCount;
+
+    Status = OutputFileOpen(&File, FileName);
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+
+    DumpTable(&File, "RSD PTR", Rsdp, RsdpLength(Rsdp));
+    *Tables = 1;
+
+    RootCount = RootTables(Roots);
+    for (UINTN i = 0; i < RootCount; i++) {
+        CopyMem(Sig, &(Roots[i]->Signature), 4);
+        Sig[4] = '\0';
+        DumpTable(&File, Sig, Roots[i], Roots[i]->Length);
+        (*Tables)++;
+    }
+
+    for (UINTN i = 0; (Entry = AcpiIndexEntry(i)) != NULL; i++) {
+        CopyMem(Sig, &(Entry->Signature), 4);
+        Sig[4] = '\0';
+        DumpTable(&File, Sig, Entry->Table, Entry->Length);
+        (*Tables)++;
+    }
+
+    Status = OutputFileClose(&File);
+    *Bytes = File.BytesWritten;
+
+    return Status;
+}
+
+
+//
+// Write one raw table to Directory\Name.dat
+//
+static EFI_STATUS
+ExtractTable( CONST CHAR16 *Directory,
+              CONST CHAR16 *Name,
+              VOID *Table,
+              UINTN Length )
+{
+    OUTPUT_FILE File;
+    EFI_STATUS  Status;
+    CHAR16      FileName[256];
+
+    UnicodeSPrint(FileName, sizeof(FileName), L"%s\\%s.dat", Directory, Name);
+
+    Status = OutputFileOpen(&File, FileName);
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+    OutputFileWrite(&File, Table, Length);
+
+    return OutputFileClose(&File);
+}
+
+
+//
+// File name for an indexed table the way acpixtract names them: lower
+// case signature, numbered from 1 when there is more than one
+//
+static VOID
+TableFileName( CONST ACPI_INDEX_ENTRY *Entry,
+               UINTN Instance,
+               CHAR16 *Name,
+               UINTN Size )
+{
+    CHAR8  *Sig = (CHAR8 *)&(Entry->Signature);
+    CHAR16 Lower[5];
+
+    for (UINTN i = 0; i < 4; i++) {
+        if (Sig[i] >= 'A' && Sig[i] <= 'Z') {
+            Lower[i] = (CHAR16)(Sig[i] - 'A' + 'a');
+        } else if ((Sig[i] >= 'a' && Sig[i] <= 'z') || (Sig[i] >= '0' && Sig[i] <= '9')) {
+            Lower[i] = (CHAR16)Sig[i];
+        } else {
+            Lower[i] = L'_';
+        }
+    }
+    Lower[4] = CHAR_NULL;
+
+    if (Instance > 0 || AcpiIndexFindEntry(Entry->Signature, 1) != NULL) {
+        UnicodeSPrint(Name, Size, L"%s%d", Lower, Instance + 1);
+    } else {
+        UnicodeSPrint(Name, Size, L"%s", Lower);
+    }
+}
+
+
+//
+// Write every table as a separate binary .dat file under Directory
+//
+static EFI_STATUS
+ExtractTables( CONST CHAR16 *Directory,
+               UINTN *Tables,
+               UINT64 *Bytes )
+{
+    EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *Rsdp = AcpiIndexRsdp();
+    EFI_ACPI_DESCRIPTION_HEADER *Roots[2];
+    CONST ACPI_INDEX_ENTRY *Entry;
+    SHELL_FILE_HANDLE Handle;
+    EFI_STATUS Status;
+    CHAR16     Name[16];
+    UINTN      RootCount;
+    UINTN      Instance;
+
+    // created if it does not already exist
+    Status = ShellCreateDirectory(Directory, &Handle);
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+    ShellCloseFile(&Handle);
+
+    Status = ExtractTable(Directory, L"rsdp", Rsdp, RsdpLength(Rsdp));
+    *Tables = 1;
+    *Bytes = RsdpLength(Rsdp);
+
+    RootCount = RootTables(Roots);
+    for (UINTN i = 0; i < RootCount && !EFI_ERROR(Status); i++) {
+        Status = ExtractTable( Directory,
+                               Roots[i]->Signature == EFI_ACPI_2_0_EXTENDED_SYSTEM_DESCRIPTION_TABLE_SIGNATURE ?
+                               L"xsdt" : L"rsdt",
+                               Roots[i],
+                               Roots[i]->Length );
+        (*Tables)++;
+        *Bytes += Roots[i]->Length;
+    }
+
+    for (UINTN i = 0; (Entry = AcpiIndexEntry(i)) != NULL && !EFI_ERROR(Status); i++) {
+        // instance number of this table among those with its signature
+        for (Instance = 0; AcpiIndexFindEntry(Entry->Signature, Instance) != Entry; Instance++) {
+            ;
+        }
+        TableFileName(Entry, Instance, Name, sizeof(Name));
+        Status = ExtractTable(Directory, Name, Entry->Table, Entry->Length);
+        (*Tables)++;
+        *Bytes += Entry->Length;
+    }
+
+    return Status;
+}
+
+
+//
+// Manifest: one line per indexed table, "SIG OEMTABLEID LENGTH SHA256".
+// Tables are matched across boots by signature, OEM table ID and the
+// occurrence of that pair, since addresses move between boots.
+//
+#define MANIFEST_HEADER  "# ListACPI manifest 1\n"
+
+typedef struct {
+    CHAR8   Signature[5];
+    CHAR8   OemTableId[9];
+    UINT32  Length;
+    UINT8   Digest[DIGEST_SHA256_SIZE];
+    UINTN   Occurrence;
+    BOOLEAN Matched;
+} MANIFEST_ENTRY;
+
+
+//
+// Printable form of a 4 or 8 byte name field, no spaces, so the
+// manifest stays whitespace separated
+//
+static VOID
+ManifestName( CONST CHAR8 *Field,
+              UINTN Size,
+              CHAR8 *Name )
+{
+    for (UINTN i = 0; i < Size; i++) {
+        Name[i] = (Field[i] > 0x20 && Field[i] < 0x7f) ? Field[i] : '_';
+    }
+    Name[Size] = '\0';
+}
+
+
+//
+// Signature and OEM table ID of an indexed table as manifest names.
+// The FACS has no OEM table ID.
+//
+static VOID
+EntryNames( CONST ACPI_INDEX_ENTRY *Entry,
+            CHAR8 *Signature,
+            CHAR8 *OemTableId )
+{
+    ManifestName((CHAR8 *)&(Entry->Signature), 4, Signature);
+    if (Entry->Flags & ACPI_INDEX_NO_CHECKSUM) {
+        AsciiStrCpyS(OemTableId, 9, "-");
+    } else {
+        ManifestName((CHAR8 *)&(Entry->Table->OemTableId), 8, OemTableId);
+    }
+}
+
+
+//
+// How many earlier indexed tables share this table's signature and OEM
+// table ID
+//
+static UINTN
+EntryOccurrence( UINTN Index )
+{
+    CONST ACPI_INDEX_ENTRY *Entry = AcpiIndexEntry(Index);
+    CONST ACPI_INDEX_ENTRY *Other;
+    UINTN Occurrence = 0;
+
+    for (UINTN i = 0; i < Index; i++) {
+        Other = AcpiIndexEntry(i);
+        if (Other->Signature == Entry->Signature &&
+            ((Entry->Flags & ACPI_INDEX_NO_CHECKSUM) ||
+             Other->Table->OemTableId == Entry->Table->OemTableId)) {
+            Occurrence++;
+        }
+    }
+
+    return Occurrence;
+}
+
+
+static VOID
+DigestToAscii( CONST UINT8 *Digest,
+               CHAR8 *Str )
+{
+    STATIC CONST CHAR8 Hex[] = "0123456789abcdef";
+
+    for (UINTN i = 0; i < DIGEST_SHA256_SIZE; i++) {
+        Str[i * 2] = Hex[Digest[i] >> 4];
+        Str[i * 2 + 1] = Hex[Digest[i] & 0x0f];
+    }
+    Str[DIGEST_SHA256_SIZE * 2] = '\0';
+}
+
+
+static EFI_STATUS
+SaveManifest( CONST CHAR16 *FileName,
+              UINTN *Tables )
+{
+    CONST ACPI_INDEX_ENTRY *Entry;
+    OUTPUT_FILE File;
+    EFI_STATUS  Status;
+    UINT8       Digest[DIGEST_SHA256_SIZE];
+    CHAR8       DigestStr[DIGEST_SHA256_SIZE * 2 + 1];
+    CHAR8       Signature[5];
+    CHAR8       OemTableId[9];
+
+    Status = OutputFileOpen(&File, FileName);
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+
+    OutputFilePrint(&File, MANIFEST_HEADER);
+    for (*Tables = 0; (Entry = AcpiIndexEntry(*Tables)) != NULL; (*Tables)++) {
+        EntryNames(Entry, Signature, OemTableId);
+        DigestSha256(Entry->Table, Entry->Length, Digest);
+        DigestToAscii(Digest, DigestStr);
+        OutputFilePrint(&File, "%a %a %d %a\n", Signature, OemTableId, Entry->Length, DigestStr);
+    }
+
+    return OutputFileClose(&File);
+}
+
+
+//
+// Next whitespace separated token on the current line, NUL terminated
+// in place.  Returns NULL at the end of the line.
+//
+static CHAR8 *
+NextToken( CHAR8 **Ptr )
+{
+    CHAR8 *Start;
+
+    while (**Ptr == ' ' || **Ptr == '\t' || **Ptr == '\r') {
+        (*Ptr)++;
+    }
+    if (**Ptr == '\0' || **Ptr == '\n') {
+        return NULL;
+    }
+
+    Start = *Ptr;
+    while (**Ptr != '\0' && **Ptr != '\n' && **Ptr != ' ' && **Ptr != '\t' && **Ptr != '\r') {
+        (*Ptr)++;
+    }
+    if (**Ptr != '\0' && **Ptr != '\n') {
+        *(*Ptr)++ = '\0';
+    }
+
+    return Start;
+}
+
+
+static BOOLEAN
+AsciiToDigest( CONST CHAR8 *Str,
+               UINT8 *Digest )
+{
+    UINT8 Nibble;
+
+    for (UINTN i = 0; i < DIGEST_SHA256_SIZE * 2; i++) {
+        if (Str[i] >= '0' && Str[i] <= '9') {
+            Nibble = Str[i] - '0';
+        } else if (Str[i] >= 'a' && Str[i] <= 'f') {
+            Nibble = Str[i] - 'a' + 10;
+        } else if (Str[i] >= 'A' && Str[i] <= 'F') {
+            Nibble = Str[i] - 'A' + 10;
+        } else {
+            return FALSE;
+        }
+        Digest[i / 2] = (i & 1) ? (Digest[i / 2] | Nibble) : (UINT8)(Nibble << 4);
+    }
+
+    return Str[DIGEST_SHA256_SIZE * 2] == '\0';
+}
+
+
+//
+// Read and parse a saved manifest.  Malformed lines are skipped.
+//
+static EFI_STATUS
+LoadManifest( CONST CHAR16 *FileName,
+              MANIFEST_ENTRY *Manifest,
+              UINTN *Count )
+{
+    SHELL_FILE_HANDLE Handle;
+    EFI_STATUS Status;
+    UINT64     FileSize;
+    UINTN      Size;
+    CHAR8      *Buffer;
+    CHAR8      *Ptr;
+    CHAR8      *Sig, *OemId, *Len, *Hash;
+    MANIFEST_ENTRY *Entry;
+
+    *Count = 0;
+
+    Status = ShellOpenFileByName(FileName, &Handle, EFI_FILE_MODE_READ, 0);
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+    Status = ShellGetFileSize(Handle, &FileSize);
+    if (EFI_ERROR(Status)) {
+        ShellCloseFile(&Handle);
+        return Status;
+    }
+
+    Size = (UINTN)FileSize;
+    Buffer = AllocatePool(Size + 1);
+    if (Buffer == NULL) {
+        ShellCloseFile(&Handle);
+        return EFI_OUT_OF_RESOURCES;
+    }
+    Status = ShellReadFile(Handle, &Size, Buffer);
+    ShellCloseFile(&Handle);
+    if (EFI_ERROR(Status)) {
+        FreePool(Buffer);
+        return Status;
+    }
+    Buffer[Size] = '\0';
+
+    for (Ptr = Buffer; *Ptr != '\0' && *Count < ACPI_INDEX_MAX_TABLES; ) {
+        Sig = NextToken(&Ptr);
+        OemId = NextToken(&Ptr);
+        Len = NextToken(&Ptr);
+        Hash = NextToken(&Ptr);
+
+        Entry = &Manifest[*Count];
+        if (Sig != NULL && Sig[0] != '#' && OemId != NULL && Len != NULL && Hash != NULL &&
+            AsciiStrLen(Sig) == 4 && AsciiStrLen(OemId) <= 8 && AsciiToDigest(Hash, Entry->Digest)) {
+            AsciiStrCpyS(Entry->Signature, sizeof(Entry->Signature), Sig);
+            AsciiStrCpyS(Entry->OemTableId, sizeof(Entry->OemTableId), OemId);
+            Entry->Length = (UINT32)AsciiStrDecimalToUintn(Len);
+            Entry->Occurrence = 0;
+            Entry->Matched = FALSE;
+            for (UINTN i = 0; i < *Count; i++) {
+                if (!AsciiStrCmp(Manifest[i].Signature, Sig) && !AsciiStrCmp(Manifest[i].OemTableId, OemId)) {
+                    Entry->Occurrence++;
+                }
+            }
+            (*Count)++;
+        }
+
+        // rest of the line
+        while (*Ptr != '\0' && *Ptr != '\n') {
+            Ptr++;
+        }
+        if (*Ptr == '\n') {
+            Ptr++;
+        }
+    }
+
+    FreePool(Buffer);
+
+    return EFI_SUCCESS;
+}
+
+
+static VOID
+ReportDiff( CONST CHAR16 *State,
+            CONST CHAR8 *Signature,
+            CONST CHAR8 *OemTableId,
+            UINT32 OldLength,
+            UINT32 NewLength,
+            BOOLEAN Json )
+{
+    if (Json) {
+        JsonObjectBegin(NULL);
+        JsonString(L"state", State);
+        JsonAsciiString(L"signature", Signature, 4);
+        JsonAsciiString(L"oemTableId", OemTableId, 8);
+        if (OldLength != 0) {
+            JsonUint(L"oldLength", OldLength);
+        }
+        if (NewLength != 0) {
+            JsonUint(L"length", NewLength);
+        }
+        JsonObjectEnd();
+    } else {
+        OutputPrint(L"  %-8s %a  %-8a  %d -> %d\n", State, Signature, OemTableId, OldLength, NewLength);
+    }
+}
+
+
+//
+// Hash the live tables, compare with a saved manifest, and optionally
+// write only the changed and new tables to an acpidump format file
+//
+static EFI_STATUS
+DiffManifest( CONST CHAR16 *ManifestFile,
+              CONST CHAR16 *DumpFile,
+              BOOLEAN Json )
+{
+    STATIC MANIFEST_ENTRY Manifest[ACPI_INDEX_MAX_TABLES];
+    CONST ACPI_INDEX_ENTRY *Entry;
+    MANIFEST_ENTRY *Saved;
+    OUTPUT_FILE File;
+    BOOLEAN     FileOpen = FALSE;
+    EFI_STATUS  Status;
+    UINTN       Count, Occurrence;
+    UINTN       Unchanged = 0, Changed = 0, Added = 0, Removed = 0;
+    UINT8       Digest[DIGEST_SHA256_SIZE];
+    CHAR8       Signature[5];
+    CHAR8       OemTableId[9];
+
+    Status = LoadManifest(ManifestFile, Manifest, &Count);
+    if (EFI_ERROR(Status)) {
+        JsonError(L"Cannot read manifest %s [%r]", ManifestFile, Status);
+        return Status;
+    }
+
+    if (Json) {
+        JsonObjectBegin(L"diff");
+        JsonString(L"manifest", ManifestFile);
+        JsonArrayBegin(L"tables");
+    } else {
+        OutputPrint(L"\nChanges since %s\n", ManifestFile);
+    }
+
+    for (UINTN i = 0; (Entry = AcpiIndexEntry(i)) != NULL; i++) {
+        EntryNames(Entry, Signature, OemTableId);
+        Occurrence = EntryOccurrence(i);
+
+        Saved = NULL;
+        for (UINTN j = 0; j < Count; j++) {
+            if (!Manifest[j].Matched && Manifest[j].Occurrence == Occurrence &&
+                !AsciiStrCmp(Manifest[j].Signature, Signature) &&
+                !AsciiStrCmp(Manifest[j].OemTableId, OemTableId)) {
+                Saved = &Manifest[j];
+                Saved->Matched = TRUE;
+                break;
+            }
+        }
+
+        // a length change alone proves a difference without hashing
+        if (Saved != NULL && Saved->Length == Entry->Length) {
+            DigestSha256(Entry->Table, Entry->Length, Digest);
+            if (CompareMem(Digest, Saved->Digest, DIGEST_SHA256_SIZE) == 0) {
+                Unchanged++;
+                continue;
+            }
+        }
+
+        if (Saved != NULL) {
+            Changed++;
+            ReportDiff(L"changed", Signature, OemTableId, Saved->Length, Entry->Length, Json);
+        } else {
+            Added++;
+            ReportDiff(L"new", Signature, OemTableId, 0, Entry->Length, Json);
+        }
+        if (DumpFile != NULL) {
+            // created on the first difference, so no differences means no file
+            if (!FileOpen) {
+                Status = OutputFileOpen(&File, DumpFile);
+                if (EFI_ERROR(Status)) {
+                    JsonError(L"Cannot write %s [%r]", DumpFile, Status);
+                    return Status;
+                }
+                FileOpen = TRUE;
+            }
+            DumpTable(&File, Signature, Entry->Table, Entry->Length);
+        }
+    }
+
+    for (UINTN j = 0; j < Count; j++) {
+        if (!Manifest[j].Matched) {
+            Removed++;
+            ReportDiff(L"removed", Manifest[j].Signature, Manifest[j].OemTableId, Manifest[j].Length, 0, Json);
+        }
+    }
+
+    if (FileOpen) {
+        Status = OutputFileClose(&File);
+    }
+
+    if (Json) {
+        JsonArrayEnd();
+        JsonUint(L"unchanged", Unchanged);
+        JsonUint(L"changed", Changed);
+        JsonUint(L"new", Added);
+        JsonUint(L"removed", Removed);
+        if (FileOpen) {
+            JsonString(L"dumpFile", DumpFile);
+        }
+        JsonObjectEnd();
+    } else {
+        OutputPrint(L"%d unchanged, %d changed, %d new, %d removed\n", Unchanged, Changed, Added, Removed);
+        if (FileOpen) {
+            OutputPrint(L"Changed and new tables written to %s\n", DumpFile);
+        } else if (DumpFile != NULL) {
+            OutputPrint(L"No changed or new tables, %s not written\n", DumpFile);
+        }
+    }
+
+    if (EFI_ERROR(Status)) {
+        JsonError(L"Cannot write %s [%r]", DumpFile, Status);
+    }
+
+    return Status;
+}
+
+
 static void
 Usage( void )
 {
-    Print(L"Usage: ListACPI [-v | --verbose]\n");
-    Print(L"       ListACPI [-V | --version]\n");
+    OutputPrint(L"Usage: ListACPI [-v | --verbose]\n");
+    OutputPrint(L"       ListACPI [-c | --check]\n");
+    OutputPrint(L"       ListACPI [-a | --all]\n");
+    OutputPrint(L"       ListACPI [-t | --table <signature>]\n");
+    OutputPrint(L"       ListACPI [-n | --namespace [<name>]]\n");
+    OutputPrint(L"       ListACPI [-d | --dump <file>]\n");
+    OutputPrint(L"       ListACPI [-x | --extract <directory>]\n");
+    OutputPrint(L"       ListACPI [-m | --manifest <file>]\n");
+    OutputPrint(L"       ListACPI [-D | --diff <manifest> [<dumpfile>]]\n");
+    OutputPrint(L"       ListACPI [--json]\n");
+    OutputPrint(L"       ListACPI [-V | --version]\n");
 }
 
 
@@ -133,21 +1084,41 @@ EFIAPI
 ShellAppMain( UINTN Argc,
               CHAR16 **Argv )
 {
-    EFI_CONFIGURATION_TABLE *ect = gST->ConfigurationTable;
     EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *Rsdp = NULL;
-    EFI_GUID gAcpi20TableGuid = EFI_ACPI_20_TABLE_GUID;
-    EFI_GUID gAcpi10TableGuid = ACPI_10_TABLE_GUID;
     EFI_STATUS Status = EFI_SUCCESS;
-    CHAR16 GuidStr[100];
     BOOLEAN Verbose = FALSE;
+    BOOLEAN Check = FALSE;
+    BOOLEAN DecodeAll = FALSE;
+    CHAR16  *DumpFile = NULL;
+    CHAR16  *ExtractDir = NULL;
+    CHAR16  *ManifestFile = NULL;
+    CHAR16  *DiffFile = NULL;
+    CHAR16  *TableSig = NULL;
+    CHAR16  *Query = NULL;
+    BOOLEAN Namespace = FALSE;
+    UINTN   Tables = 0;
+    UINT64  Bytes = 0;
+    BOOLEAN Json = FALSE;
+
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
 
     if (Argc == 2) {
         if (!StrCmp(Argv[1], L"--verbose") ||
             !StrCmp(Argv[1], L"-v")) {
             Verbose = TRUE;
+        } else if (!StrCmp(Argv[1], L"--check") ||
+            !StrCmp(Argv[1], L"-c")) {
+            Check = TRUE;
+        } else if (!StrCmp(Argv[1], L"--all") ||
+            !StrCmp(Argv[1], L"-a")) {
+            DecodeAll = TRUE;
+        } else if (!StrCmp(Argv[1], L"--namespace") ||
+            !StrCmp(Argv[1], L"-n")) {
+            Namespace = TRUE;
         } else if (!StrCmp(Argv[1], L"--version") ||
             !StrCmp(Argv[1], L"-V")) {
-            Print(L"Version: %s\n", UTILITY_VERSION);
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
             return Status;
         } else if (!StrCmp(Argv[1], L"--help") ||
             !StrCmp(Argv[1], L"-h")) {
@@ -158,27 +1129,160 @@ ShellAppMain( UINTN Argc,
             return Status;
         }
     }
-    if (Argc > 2) {
+    if (Argc == 3) {
+        if (!StrCmp(Argv[1], L"--dump") ||
+            !StrCmp(Argv[1], L"-d")) {
+            DumpFile = Argv[2];
+        } else if (!StrCmp(Argv[1], L"--extract") ||
+            !StrCmp(Argv[1], L"-x")) {
+            ExtractDir = Argv[2];
+        } else if (!StrCmp(Argv[1], L"--manifest") ||
+            !StrCmp(Argv[1], L"-m")) {
+            ManifestFile = Argv[2];
+        } else if (!StrCmp(Argv[1], L"--diff") ||
+            !StrCmp(Argv[1], L"-D")) {
+            DiffFile = Argv[2];
+        } else if (!StrCmp(Argv[1], L"--table") ||
+            !StrCmp(Argv[1], L"-t")) {
+            TableSig = Argv[2];
+            if (StrLen(TableSig) != 4) {
+                Usage();
+                return Status;
+            }
+        } else if (!StrCmp(Argv[1], L"--namespace") ||
+            !StrCmp(Argv[1], L"-n")) {
+            Namespace = TRUE;
+            Query = Argv[2];
+        } else {
+            Usage();
+            return Status;
+        }
+    }
+    if (Argc == 4) {
+        if (!StrCmp(Argv[1], L"--diff") ||
+            !StrCmp(Argv[1], L"-D")) {
+            DiffFile = Argv[2];
+            DumpFile = Argv[3];
+        } else {
+            Usage();
+            return Status;
+        }
+    }
+    if (Argc > 4) {
         Usage();
         return Status;
     }
 
+    if (ManifestFile != NULL || DiffFile != NULL) {
+        if (Json) {
+            JsonDocumentBegin(L"ListACPI", UTILITY_VERSION);
+        }
+        if (AcpiIndexRsdp() == NULL) {
+            JsonError(L"Could not find an ACPI RSDP table.");
+            Status = EFI_NOT_FOUND;
+        } else if (DiffFile != NULL) {
+            Status = DiffManifest(DiffFile, DumpFile, Json);
+        } else {
+            Status = SaveManifest(ManifestFile, &Tables);
+            if (EFI_ERROR(Status)) {
+                JsonError(L"Cannot write %s [%r]", ManifestFile, Status);
+            } else if (Json) {
+                JsonObjectBegin(L"manifest");
+                JsonString(L"path", ManifestFile);
+                JsonUint(L"tables", Tables);
+                JsonObjectEnd();
+            } else {
+                OutputPrint(L"Wrote manifest of %d tables to %s\n", Tables, ManifestFile);
+            }
+        }
+        if (Json) {
+            JsonDocumentEnd();
+        }
+        return Status;
+    }
+
+    if (DumpFile != NULL || ExtractDir != NULL) {
+        if (Json) {
+            JsonDocumentBegin(L"ListACPI", UTILITY_VERSION);
+        }
+        if (AcpiIndexRsdp() == NULL) {
+            JsonError(L"Could not find an ACPI RSDP table.");
+            Status = EFI_NOT_FOUND;
+        } else {
+            if (DumpFile != NULL) {
+                Status = DumpTables(DumpFile, &Tables, &Bytes);
+            } else {
+                Status = ExtractTables(ExtractDir, &Tables, &Bytes);
+            }
+            if (EFI_ERROR(Status)) {
+                JsonError(L"Cannot write %s [%r]", DumpFile != NULL ? DumpFile : ExtractDir, Status);
+            } else if (Json) {
+                JsonObjectBegin(L"export");
+                JsonString(L"format", DumpFile != NULL ? L"acpidump" : L"binary");
+                JsonString(L"path", DumpFile != NULL ? DumpFile : ExtractDir);
+                JsonUint(L"tables", Tables);
+                JsonUint(L"bytes", Bytes);
+                JsonObjectEnd();
+            } else {
+                OutputPrint(L"Wrote %d tables (%ld bytes) to %s\n", Tables, Bytes,
+                            DumpFile != NULL ? DumpFile : ExtractDir);
+            }
+        }
+        if (Json) {
+            JsonDocumentEnd();
+        }
+        return Status;
+    }
+
+    if (Check || DecodeAll || TableSig != NULL || Namespace) {
+        if (Json) {
+            JsonDocumentBegin(L"ListACPI", UTILITY_VERSION);
+        }
+        if (AcpiIndexRsdp() == NULL) {
+            JsonError(L"Could not find an ACPI RSDP table.");
+            Status = EFI_NOT_FOUND;
+        } else if (DecodeAll) {
+            Status = AcpiDecodeAllTables(Json);
+        } else if (Namespace) {
+            Status = ScanNamespace(Query, Json);
+        } else if (TableSig != NULL) {
+            Status = AcpiDecodeTables(SIGNATURE_32(TableSig[0], TableSig[1], TableSig[2], TableSig[3]), Json);
+            if (Status == EFI_UNSUPPORTED) {
+                JsonError(L"No decoder for %s tables.", TableSig);
+            } else if (EFI_ERROR(Status)) {
+                JsonError(L"No %s table found.", TableSig);
+            }
+        } else {
+            Status = CheckTables(Json);
+        }
+        if (Json) {
+            JsonDocumentEnd();
+        }
+        return Status;
+    }
+
+    if (Json) {
+        JsonDocumentBegin(L"ListACPI", UTILITY_VERSION);
+        JsonArrayBegin(L"rsdp");
+    }
+
+    // locate RSDP (Root System Description Pointer) and index the tables
+    Rsdp = AcpiIndexRsdp();
+    if (Rsdp != NULL) {
+        ListTables(Verbose, Json);
+    }
 
-    // locate RSDP (Root System Description Pointer) 
-    for (int i = 0; i < gST->NumberOfTableEntries; i++) {
-        if ((CompareGuid (&(gST->ConfigurationTable[i].VendorGuid), &gAcpi20TableGuid)) ||
-            (CompareGuid (&(gST->ConfigurationTable[i].VendorGuid), &gAcpi10TableGuid))) {
-            if (!AsciiStrnCmp("RSD PTR ", (CHAR8 *)(ect->VendorTable), 8)) {
-                UnicodeSPrint(GuidStr, sizeof(GuidStr), L"%g", &(gST->ConfigurationTable[i].VendorGuid));
-                Rsdp = (EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *)ect->VendorTable;
-                ParseRSDP(Rsdp, GuidStr, Verbose); 
-            }        
+    if (Json) {
+        JsonArrayEnd();
+        if (Rsdp == NULL) {
+            JsonString(L"error", L"Could not find an ACPI RSDP table.");
         }
-        ect++;
+        JsonDocumentEnd();
+        return (Rsdp == NULL) ? EFI_NOT_FOUND : Status;
     }
 
     if (Rsdp == NULL) {
-        Print(L"ERROR: Could not find an ACPI RSDP table.\n");
+        OutputPrint(L"ERROR: Could not find an ACPI RSDP table.\n");
         Status = EFI_NOT_FOUND;
     }
 
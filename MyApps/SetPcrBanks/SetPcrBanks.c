@@ -0,0 +1,626 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Show and change the active TPM 2.0 PCR banks, and compare the firmware
+//  boot time (FPDT) before and after the change
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/UefiLib.h>
+#include <Library/ShellCEntryLib.h>
+#include <Library/ShellLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/AcpiTableIndexLib.h>
+#include <Library/TpmCommandLib.h>
+
+#include <Protocol/EfiShell.h>
+#include <Protocol/LoadedImage.h>
+#include <Protocol/Tcg2Protocol.h>
+#include <IndustryStandard/Acpi.h>
+
+#define UTILITY_VERSION L"20181030"
+#undef DEBUG
+
+// FPDT timestamps are in nanoseconds since reset
+#define NS_PER_MS  1000000
+
+//
+// Boot time and banks recorded when a change is requested, compared on
+// the next run once the requested banks are active
+//
+#define BASELINE_VARIABLE  L"SetPcrBanksBaseline"
+#define BASELINE_VERSION   1
+
+STATIC EFI_GUID BaselineGuid = { 0x5d4a8f3e, 0x1c27, 0x4b90, { 0x9e, 0x63, 0x2a, 0x71, 0xd0, 0x5b, 0xc8, 0x14 } };
+
+typedef struct {
+    UINT32 Version;
+    UINT32 ActivePcrBanks;                // when the change was requested
+    UINT32 RequestedPcrBanks;
+    UINT32 Direct;                        // TPM2_PCR_Allocate rather than SetActivePcrBanks
+    UINT64 BootTimeNs;                    // reset to OS loader LoadImage, 0 if unknown
+} BANK_BASELINE;
+
+typedef struct {
+    UINT32        Bit;                    // EFI_TCG2_BOOT_HASH_ALG_*
+    TPMI_ALG_HASH Alg;
+    CHAR16        *Name;
+    CHAR16        *LowerName;
+} PCR_BANK;
+
+STATIC PCR_BANK Banks[] = {
+    { EFI_TCG2_BOOT_HASH_ALG_SHA1,    TPM_ALG_SHA1,    L"SHA1",    L"sha1" },
+    { EFI_TCG2_BOOT_HASH_ALG_SHA256,  TPM_ALG_SHA256,  L"SHA256",  L"sha256" },
+    { EFI_TCG2_BOOT_HASH_ALG_SHA384,  TPM_ALG_SHA384,  L"SHA384",  L"sha384" },
+    { EFI_TCG2_BOOT_HASH_ALG_SHA512,  TPM_ALG_SHA512,  L"SHA512",  L"sha512" },
+    { EFI_TCG2_BOOT_HASH_ALG_SM3_256, TPM_ALG_SM3_256, L"SM3_256", L"sm3_256" },
+};
+
+
+static VOID
+PrintBanks( CHAR16 *Label,
+            UINT32 Bitmap )
+{
+    OutputPrint(L"%17s: ", Label);
+    if (Bitmap == 0) {
+        OutputPrint(L"none");
+    }
+    for (UINTN i = 0; i < ARRAY_SIZE(Banks); i++) {
+        if (Bitmap & Banks[i].Bit) {
+            OutputPrint(L"%s ", Banks[i].Name);
+        }
+    }
+    OutputPrint(L"\n");
+}
+
+
+static VOID
+JsonBanks( CHAR16 *Name,
+           UINT32 Bitmap )
+{
+    JsonArrayBegin(Name);
+    for (UINTN i = 0; i < ARRAY_SIZE(Banks); i++) {
+        if (Bitmap & Banks[i].Bit) {
+            JsonString(NULL, Banks[i].Name);
+        }
+    }
+    JsonArrayEnd();
+}
+
+
+//
+// Comma separated list of bank names, e.g. "sha256,sha384"
+//
+static BOOLEAN
+ParseBanks( CHAR16 *List,
+            UINT32 *Bitmap )
+{
+    CHAR16 *Name = List;
+    CHAR16 *End;
+    UINTN  i;
+
+    *Bitmap = 0;
+    while (*Name != L'\0') {
+        for (End = Name; *End != L'\0' && *End != L','; End++)
+            ;
+        if (*End == L',') {
+            *End++ = L'\0';
+        }
+        for (i = 0; i < ARRAY_SIZE(Banks); i++) {
+            if (!StrCmp(Name, Banks[i].Name) || !StrCmp(Name, Banks[i].LowerName)) {
+                *Bitmap |= Banks[i].Bit;
+                break;
+            }
+        }
+        if (i == ARRAY_SIZE(Banks)) {
+            return FALSE;
+        }
+        Name = End;
+    }
+
+    return (*Bitmap != 0);
+}
+
+
+//
+// Time from reset to the OS loader (the first boot option) LoadImage,
+// from the FPDT Firmware Basic Boot Performance Record.  Every PCR
+// extend made by the firmware falls inside it.
+//
+static EFI_STATUS
+FirmwareBootTime( UINT64 *Ns )
+{
+    EFI_ACPI_DESCRIPTION_HEADER                  *Fpdt;
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER  *Record;
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER   *Fbpt = NULL;
+    EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD *Boot;
+    UINT8 *Ptr;
+    UINT8 *End;
+
+    *Ns = 0;
+    if (AcpiIndexRsdp() == NULL) {
+        return EFI_NOT_FOUND;
+    }
+    Fpdt = AcpiIndexFind(EFI_ACPI_5_0_FIRMWARE_PERFORMANCE_DATA_TABLE_SIGNATURE, 0);
+    if (Fpdt == NULL) {
+        return EFI_NOT_FOUND;
+    }
+
+    Ptr = (UINT8 *)(Fpdt + 1);
+    End = (UINT8 *)Fpdt + Fpdt->Length;
+    while (Fbpt == NULL && Ptr + sizeof(*Record) <= End) {
+        Record = (EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *)Ptr;
+        if (Record->Length < sizeof(*Record) || Ptr + Record->Length > End) {
+            break;
+        }
+        if (Record->Type == EFI_ACPI_5_0_FPDT_RECORD_TYPE_FIRMWARE_BASIC_BOOT_POINTER &&
+            Record->Length >= sizeof(EFI_ACPI_5_0_FPDT_BOOT_PERFORMANCE_TABLE_POINTER_RECORD)) {
+            Fbpt = (EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *)(UINTN)
+                   ((EFI_ACPI_5_0_FPDT_BOOT_PERFORMANCE_TABLE_POINTER_RECORD *)Record)->BootPerformanceTablePointer;
+        }
+        Ptr += Record->Length;
+    }
+    if (Fbpt == NULL || Fbpt->Signature != EFI_ACPI_5_0_FPDT_BOOT_PERFORMANCE_TABLE_SIGNATURE) {
+        return EFI_NOT_FOUND;
+    }
+
+    Ptr = (UINT8 *)(Fbpt + 1);
+    End = (UINT8 *)Fbpt + Fbpt->Length;
+    while (Ptr + sizeof(*Record) <= End) {
+        Record = (EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *)Ptr;
+        if (Record->Length < sizeof(*Record) || Ptr + Record->Length > End) {
+            break;
+        }
+        if (Record->Type == EFI_ACPI_5_0_FPDT_RUNTIME_RECORD_TYPE_FIRMWARE_BASIC_BOOT &&
+            Record->Length >= sizeof(EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD)) {
+            Boot = (EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD *)Record;
+            *Ns = Boot->OsLoaderLoadImageStart;
+            return (*Ns != 0) ? EFI_SUCCESS : EFI_NOT_FOUND;
+        }
+        Ptr += Record->Length;
+    }
+
+    return EFI_NOT_FOUND;
+}
+
+
+static EFI_STATUS
+ReadBaseline( BANK_BASELINE *Baseline )
+{
+    EFI_STATUS Status;
+    UINTN      Size = sizeof(BANK_BASELINE);
+
+    Status = gRT->GetVariable( BASELINE_VARIABLE,
+                               &BaselineGuid,
+                               NULL,
+                               &Size,
+                               Baseline );
+    if (!EFI_ERROR(Status) &&
+        (Size != sizeof(BANK_BASELINE) || Baseline->Version != BASELINE_VERSION)) {
+        Status = EFI_INCOMPATIBLE_VERSION;
+    }
+
+    return Status;
+}
+
+
+static EFI_STATUS
+WriteBaseline( BANK_BASELINE *Baseline )
+{
+    return gRT->SetVariable( BASELINE_VARIABLE,
+                             &BaselineGuid,
+                             EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                             Baseline != NULL ? sizeof(BANK_BASELINE) : 0,
+                             Baseline );
+}
+
+
+//
+// TPM2_PCR_Allocate with the platform hierarchy's (empty) password.
+// Firmware normally sets a random platform auth before booting the
+// shell, in which case the TPM refuses this and the physical presence
+// request (SetActivePcrBanks) must be used instead.
+//
+// The allocation covers every bank the TPM implements (TPM_CAP_PCRS),
+// which can differ from what the firmware reports it supports.  Banks
+// this utility does not know keep their current allocation.
+//
+static EFI_STATUS
+AllocatePcrBanks( UINT32 Requested,
+                  UINT32 *ResponseCode )
+{
+    EFI_STATUS         Status;
+    TPM_COMMAND        Command;
+    TPM_RESPONSE       Response;
+    TPML_PCR_SELECTION Implemented;
+    UINT8              SendBuffer[sizeof(TPM2_COMMAND_HEADER) + 64 + sizeof(TPML_PCR_SELECTION)];
+    UINT8              RecvBuffer[sizeof(TPM2_RESPONSE_HEADER) + sizeof(UINT8) + sizeof(UINT32) + sizeof(TPML_PCR_SELECTION) + 16];
+    UINT8              All[PCR_SELECT_MAX];
+    UINT8              None[PCR_SELECT_MAX];
+    UINT8              *Select;
+    UINT32             Count;
+    UINT32             Found = 0;
+    UINT16             Hash;
+    UINT8              Size;
+    UINT8              AllocationSuccess;
+
+    *ResponseCode = 0;
+    Status = TpmGetCapability(TPM_CAP_PCRS, 0, 1, NULL, &Response, RecvBuffer, sizeof(RecvBuffer));
+    if (EFI_ERROR(Status)) {
+        *ResponseCode = Response.ResponseCode;
+        return Status;
+    }
+
+    ZeroMem(&Implemented, sizeof(Implemented));
+    Count = TpmGetUint32(&Response);
+    for (UINT32 i = 0; i < Count && !Response.Error; i++) {
+        Hash = TpmGetUint16(&Response);
+        Size = TpmGetUint8(&Response);
+        Select = TpmGetBytes(&Response, Size);
+        if (Select == NULL || Size > PCR_SELECT_MAX || Implemented.count >= HASH_COUNT) {
+            return EFI_DEVICE_ERROR;
+        }
+        Implemented.pcrSelections[Implemented.count].hash = Hash;
+        Implemented.pcrSelections[Implemented.count].sizeofSelect = Size;
+        CopyMem(Implemented.pcrSelections[Implemented.count].pcrSelect, Select, Size);
+        Implemented.count++;
+        for (UINTN j = 0; j < ARRAY_SIZE(Banks); j++) {
+            if (Banks[j].Alg == Hash) {
+                Found |= Banks[j].Bit;
+            }
+        }
+    }
+    if (Response.Error) {
+        return EFI_DEVICE_ERROR;
+    }
+    if ((Requested & ~Found) != 0) {
+        return EFI_UNSUPPORTED;
+    }
+
+    SetMem(All, sizeof(All), 0xff);
+    ZeroMem(None, sizeof(None));
+
+    TpmCommandBegin(&Command, SendBuffer, sizeof(SendBuffer), TPM_ST_SESSIONS, TPM_CC_PCR_Allocate);
+    TpmPutUint32(&Command, TPM_RH_PLATFORM);
+    TpmPutPasswordSession(&Command);
+    TpmPutUint32(&Command, Implemented.count);
+    for (UINT32 i = 0; i < Implemented.count; i++) {
+        Hash = Implemented.pcrSelections[i].hash;
+        Size = Implemented.pcrSelections[i].sizeofSelect;
+        Select = Implemented.pcrSelections[i].pcrSelect;
+        for (UINTN j = 0; j < ARRAY_SIZE(Banks); j++) {
+            if (Banks[j].Alg == Hash) {
+                Select = (Requested & Banks[j].Bit) ? All : None;
+            }
+        }
+        TpmPutUint16(&Command, Hash);
+        TpmPutUint8(&Command, Size);
+        TpmPutBytes(&Command, Select, Size);
+    }
+
+    Status = TpmSubmit(&Command, &Response, RecvBuffer, sizeof(RecvBuffer));
+    *ResponseCode = Response.ResponseCode;
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+
+    TpmGetUint32(&Response);              // parameterSize
+    AllocationSuccess = TpmGetUint8(&Response);
+    if (Response.Error) {
+        return EFI_DEVICE_ERROR;
+    }
+
+    return AllocationSuccess ? EFI_SUCCESS : EFI_OUT_OF_RESOURCES;
+}
+
+
+static BOOLEAN
+Confirm( CHAR16 *Prompt )
+{
+    EFI_INPUT_KEY Key;
+    UINTN         EventIndex;
+
+    OutputPrint(L"%s [y/N] ", Prompt);
+    OutputFlush();
+
+    gBS->WaitForEvent(1, &gST->ConIn->WaitForKey, &EventIndex);
+    if (EFI_ERROR(gST->ConIn->ReadKeyStroke(gST->ConIn, &Key))) {
+        Key.UnicodeChar = 0;
+    }
+    OutputPrint(L"%c\n", Key.UnicodeChar ? Key.UnicodeChar : L' ');
+
+    return (Key.UnicodeChar == L'y' || Key.UnicodeChar == L'Y');
+}
+
+
+static VOID
+PrintBaseline( BANK_BASELINE *Baseline,
+               UINT32 Active,
+               UINT64 BootTimeNs )
+{
+    OutputPrint(L"\n");
+    PrintBanks(L"Requested Banks", Baseline->RequestedPcrBanks);
+    PrintBanks(L"Previous Banks", Baseline->ActivePcrBanks);
+    if (Active != Baseline->RequestedPcrBanks) {
+        OutputPrint(L"%17s: requested banks are not active yet\n", L"Status");
+        return;
+    }
+    if (Baseline->BootTimeNs == 0 || BootTimeNs == 0) {
+        OutputPrint(L"%17s: no FPDT boot time to compare\n", L"Boot Time");
+        return;
+    }
+    OutputPrint(L"%17s: %ld ms\n", L"Boot Time Before", DivU64x32(Baseline->BootTimeNs, NS_PER_MS));
+    OutputPrint(L"%17s: %ld ms\n", L"Boot Time Now", DivU64x32(BootTimeNs, NS_PER_MS));
+    if (BootTimeNs <= Baseline->BootTimeNs) {
+        OutputPrint(L"%17s: %ld ms faster\n", L"Change", DivU64x32(Baseline->BootTimeNs - BootTimeNs, NS_PER_MS));
+    } else {
+        OutputPrint(L"%17s: %ld ms slower\n", L"Change", DivU64x32(BootTimeNs - Baseline->BootTimeNs, NS_PER_MS));
+    }
+}
+
+
+static VOID
+JsonBaseline( BANK_BASELINE *Baseline,
+              UINT32 Active,
+              UINT64 BootTimeNs )
+{
+    JsonObjectBegin(L"baseline");
+    JsonBanks(L"requestedBanks", Baseline->RequestedPcrBanks);
+    JsonBanks(L"previousBanks", Baseline->ActivePcrBanks);
+    JsonBool(L"applied", Active == Baseline->RequestedPcrBanks);
+    JsonBool(L"direct", Baseline->Direct != 0);
+    if (Baseline->BootTimeNs != 0) {
+        JsonUint(L"bootTimeBeforeUs", DivU64x32(Baseline->BootTimeNs, 1000));
+    }
+    // negative is faster, as in PrintBaseline
+    if (Active == Baseline->RequestedPcrBanks && Baseline->BootTimeNs != 0 && BootTimeNs != 0) {
+        JsonUint(L"bootTimeNowUs", DivU64x32(BootTimeNs, 1000));
+        JsonInt(L"bootTimeChangeUs", (INT64)DivU64x32(BootTimeNs, 1000) - (INT64)DivU64x32(Baseline->BootTimeNs, 1000));
+    }
+    JsonObjectEnd();
+}
+
+
+VOID
+Usage( CHAR16 *Str,
+       BOOLEAN ErrorMsg )
+{
+    if ( ErrorMsg ) {
+        OutputPrint(L"ERROR: Unknown option.\n");
+    }
+    OutputPrint(L"Usage: %s [--json]\n", Str);
+    OutputPrint(L"       %s -s | --set <bank>[,<bank>...] [-d | --direct] [-y | --yes] [-n | --no-reboot]\n", Str);
+    OutputPrint(L"       %s -c | --clear\n", Str);
+    OutputPrint(L"       %s [-V | --version]\n", Str);
+    OutputPrint(L"\nBanks: SHA1, SHA256, SHA384, SHA512, SM3_256\n");
+    OutputPrint(L"\n--set asks the firmware (physical presence request) to allocate the banks\n");
+    OutputPrint(L"on the next boot, records this boot's FPDT boot time and reboots.  Run again\n");
+    OutputPrint(L"after the reboot to compare.  --direct sends TPM2_PCR_Allocate instead, which\n");
+    OutputPrint(L"needs the platform hierarchy to still have an empty password.  --clear drops\n");
+    OutputPrint(L"the recorded boot time.\n");
+}
+
+
+INTN
+EFIAPI
+ShellAppMain( UINTN Argc,
+              CHAR16 **Argv )
+{
+    EFI_STATUS                       Status = EFI_SUCCESS;
+    EFI_TCG2_PROTOCOL                *Tcg2;
+    EFI_TCG2_BOOT_SERVICE_CAPABILITY CapabilityData;
+    TPM_TRANSPORT                    Transport;
+    BANK_BASELINE                    Baseline;
+    BOOLEAN                          HaveBaseline;
+    UINT64                           BootTimeNs = 0;
+    UINT32                           Requested = 0;
+    UINT32                           OperationPresent = 0;
+    UINT32                           OperationResponse = 0;
+    UINT32                           ResponseCode = 0;
+    CHAR16                           *BankList = NULL;
+    BOOLEAN                          Direct = FALSE;
+    BOOLEAN                          Yes = FALSE;
+    BOOLEAN                          NoReboot = FALSE;
+    BOOLEAN                          Clear = FALSE;
+    BOOLEAN                          Json = FALSE;
+
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
+
+    for (UINTN i = 1; i < Argc; i++) {
+        if (!StrCmp(Argv[i], L"--version") ||
+            !StrCmp(Argv[i], L"-V")) {
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
+            return Status;
+        } else if (!StrCmp(Argv[i], L"--help") ||
+            !StrCmp(Argv[i], L"-h")) {
+            Usage(Argv[0], FALSE);
+            return Status;
+        } else if ((!StrCmp(Argv[i], L"--set") ||
+            !StrCmp(Argv[i], L"-s")) && i + 1 < Argc) {
+            BankList = Argv[++i];
+        } else if (!StrCmp(Argv[i], L"--direct") ||
+            !StrCmp(Argv[i], L"-d")) {
+            Direct = TRUE;
+        } else if (!StrCmp(Argv[i], L"--yes") ||
+            !StrCmp(Argv[i], L"-y")) {
+            Yes = TRUE;
+        } else if (!StrCmp(Argv[i], L"--no-reboot") ||
+            !StrCmp(Argv[i], L"-n")) {
+            NoReboot = TRUE;
+        } else if (!StrCmp(Argv[i], L"--clear") ||
+            !StrCmp(Argv[i], L"-c")) {
+            Clear = TRUE;
+        } else {
+            Usage(Argv[0], TRUE);
+            return Status;
+        }
+    }
+
+    if (BankList != NULL && !ParseBanks(BankList, &Requested)) {
+        OutputPrint(L"ERROR: Unknown PCR bank in list\n");
+        return EFI_INVALID_PARAMETER;
+    }
+    if ((BankList != NULL && (Json || Clear)) || (BankList == NULL && (Direct || Yes || NoReboot))) {
+        Usage(Argv[0], TRUE);
+        return EFI_INVALID_PARAMETER;
+    }
+
+    if (Clear) {
+        Status = WriteBaseline(NULL);
+        if (Status == EFI_NOT_FOUND) {
+            Status = EFI_SUCCESS;
+        }
+        if (EFI_ERROR(Status)) {
+            OutputPrint(L"ERROR: Deleting %s [%r]\n", BASELINE_VARIABLE, Status);
+        }
+        return Status;
+    }
+
+    if (Json) {
+        JsonDocumentBegin(L"SetPcrBanks", UTILITY_VERSION);
+    }
+
+    TpmOpen(&Transport);
+    Tcg2 = TpmTcg2();
+    if (Tcg2 == NULL) {
+        if (Transport == TpmTransportTpm12) {
+            JsonError(L"Platform configured for TPM 1.2, not TPM 2.0");
+        } else {
+            JsonError(L"Failed to locate EFI_TCG2_PROTOCOL [%d]", EFI_NOT_FOUND);
+        }
+        Status = EFI_NOT_FOUND;
+        goto Done;
+    }
+
+    ZeroMem(&CapabilityData, sizeof(CapabilityData));
+    CapabilityData.Size = (UINT8)sizeof(CapabilityData);
+    Status = Tcg2->GetCapability(Tcg2, &CapabilityData);
+    if (EFI_ERROR(Status)) {
+        JsonError(L"Tcg2Protocol GetCapability [%d]", Status);
+        goto Done;
+    }
+
+    FirmwareBootTime(&BootTimeNs);
+    HaveBaseline = !EFI_ERROR(ReadBaseline(&Baseline));
+
+    //
+    // Report
+    //
+    if (BankList == NULL) {
+        // result of the last SetActivePcrBanks, if the firmware kept one
+        if (EFI_ERROR(Tcg2->GetResultOfSetActivePcrBanks(Tcg2, &OperationPresent, &OperationResponse))) {
+            OperationPresent = 0;
+        }
+
+        if (Json) {
+            JsonBanks(L"supportedBanks", CapabilityData.HashAlgorithmBitmap);
+            JsonBanks(L"activeBanks", CapabilityData.ActivePcrBanks);
+            JsonUint(L"numberOfPcrBanks", CapabilityData.NumberOfPCRBanks);
+            if (OperationPresent) {
+                JsonHex(L"lastRequestResponse", OperationResponse);
+            }
+            if (BootTimeNs != 0) {
+                JsonUint(L"bootTimeUs", DivU64x32(BootTimeNs, 1000));
+            }
+            if (HaveBaseline) {
+                JsonBaseline(&Baseline, CapabilityData.ActivePcrBanks, BootTimeNs);
+            }
+        } else {
+            OutputPrint(L"\n");
+            PrintBanks(L"Supported Banks", CapabilityData.HashAlgorithmBitmap);
+            PrintBanks(L"Active Banks", CapabilityData.ActivePcrBanks);
+            OutputPrint(L"%17s: %d\n", L"Number of Banks", CapabilityData.NumberOfPCRBanks);
+            if (OperationPresent) {
+                OutputPrint(L"%17s: 0x%x%s\n", L"Last Request", OperationResponse,
+                            OperationResponse == 0 ? L" (success)" : L"");
+            }
+            if (BootTimeNs != 0) {
+                OutputPrint(L"%17s: %ld ms (reset to OS loader)\n", L"Boot Time",
+                            DivU64x32(BootTimeNs, NS_PER_MS));
+            }
+            if (HaveBaseline) {
+                PrintBaseline(&Baseline, CapabilityData.ActivePcrBanks, BootTimeNs);
+            }
+            OutputPrint(L"\n");
+        }
+        goto Done;
+    }
+
+    //
+    // Change
+    //
+    if ((Requested & ~CapabilityData.HashAlgorithmBitmap) != 0) {
+        OutputPrint(L"ERROR: Bank not supported by this TPM and firmware\n");
+        PrintBanks(L"Supported Banks", CapabilityData.HashAlgorithmBitmap);
+        Status = EFI_UNSUPPORTED;
+        goto Done;
+    }
+    PrintBanks(L"Active Banks", CapabilityData.ActivePcrBanks);
+    PrintBanks(L"Requested Banks", Requested);
+    if (Requested == CapabilityData.ActivePcrBanks) {
+        OutputPrint(L"Requested banks are already active\n");
+        goto Done;
+    }
+    if (BootTimeNs != 0) {
+        OutputPrint(L"%17s: %ld ms (recorded for comparison)\n", L"Boot Time",
+                    DivU64x32(BootTimeNs, NS_PER_MS));
+    }
+
+    if (!Yes && !Confirm(NoReboot ? L"Change the active PCR banks?" :
+                                    L"Change the active PCR banks and reboot now?")) {
+        OutputPrint(L"Cancelled\n");
+        goto Done;
+    }
+
+    ZeroMem(&Baseline, sizeof(Baseline));
+    Baseline.Version = BASELINE_VERSION;
+    Baseline.ActivePcrBanks = CapabilityData.ActivePcrBanks;
+    Baseline.RequestedPcrBanks = Requested;
+    Baseline.Direct = Direct;
+    Baseline.BootTimeNs = BootTimeNs;
+    Status = WriteBaseline(&Baseline);
+    if (EFI_ERROR(Status)) {
+        OutputPrint(L"WARNING: Could not record the boot time [%r]\n", Status);
+    }
+
+    if (Direct) {
+        Status = AllocatePcrBanks(Requested, &ResponseCode);
+    } else {
+        Status = Tcg2->SetActivePcrBanks(Tcg2, Requested);
+    }
+    if (EFI_ERROR(Status)) {
+        if (ResponseCode != 0) {
+            OutputPrint(L"ERROR: TPM2_PCR_Allocate response code 0x%x [%r]\n", ResponseCode, Status);
+        } else if (Direct && Status == EFI_UNSUPPORTED) {
+            OutputPrint(L"ERROR: Bank not implemented by the TPM\n");
+        } else {
+            OutputPrint(L"ERROR: %s [%r]\n", Direct ? L"TPM2_PCR_Allocate" : L"SetActivePcrBanks", Status);
+        }
+        WriteBaseline(NULL);
+        goto Done;
+    }
+
+    if (NoReboot) {
+        OutputPrint(L"Change takes effect on the next reboot\n");
+        goto Done;
+    }
+
+    OutputPrint(L"Rebooting...\n");
+    OutputFlush();
+    gRT->ResetSystem(EfiResetCold, EFI_SUCCESS, 0, NULL);
+
+Done:
+    if (Json) {
+        JsonDocumentEnd();
+    }
+
+    return Status;
+}
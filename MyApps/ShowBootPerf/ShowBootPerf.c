@@ -0,0 +1,724 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Show the slowest drivers and boot phases from the EDK II extended
+//  performance records in the FPDT Firmware Basic Boot Performance Table
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/UefiLib.h>
+#include <Library/ShellCEntryLib.h>
+#include <Library/ShellLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/PrintLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/AcpiTableIndexLib.h>
+
+#include <Protocol/EfiShell.h>
+#include <Protocol/LoadedImage.h>
+#include <Protocol/AcpiSystemDescriptionTable.h>
+
+#define UTILITY_VERSION L"20181020"
+#undef DEBUG
+
+#define NS_PER_US           1000
+#define DEFAULT_TOP_COUNT   20
+#define MAX_TOP_COUNT       100
+
+//
+// EDK II extended FPDT records (MdeModulePkg Guid/ExtendedFirmwarePerformance.h).
+// DxeCorePerformanceLib appends these to the FBPT after the basic boot record.
+//
+#define FPDT_GUID_EVENT_TYPE               0x1010
+#define FPDT_DYNAMIC_STRING_EVENT_TYPE     0x1011
+#define FPDT_DUAL_GUID_STRING_EVENT_TYPE   0x1012
+#define FPDT_GUID_QWORD_EVENT_TYPE         0x1013
+#define FPDT_GUID_QWORD_STRING_EVENT_TYPE  0x1014
+
+// start progress IDs; the matching end ID is always start + 1
+#define MODULE_START_ID                    0x01
+#define MODULE_LOADIMAGE_START_ID          0x03
+#define MODULE_DB_START_ID                 0x05
+#define MODULE_DB_SUPPORT_START_ID         0x07
+#define MODULE_DB_STOP_START_ID            0x09
+#define PERF_EVENTSIGNAL_START_ID          0x10
+#define PERF_CALLBACK_START_ID             0x20
+#define PERF_FUNCTION_START_ID             0x30
+#define PERF_INMODULE_START_ID             0x40
+#define PERF_CROSSMODULE_START_ID          0x50
+
+#pragma pack(1)
+// common leading part of all five record types
+typedef struct {
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER Header;
+    UINT16   ProgressID;
+    UINT32   ProcessorIdentifier;
+    UINT64   Timestamp;
+    EFI_GUID Guid;
+} FPDT_GUID_EVENT_RECORD;
+
+typedef struct {
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER Header;
+    UINT16   ProgressID;
+    UINT32   ProcessorIdentifier;
+    UINT64   Timestamp;
+    EFI_GUID Guid1;
+    EFI_GUID Guid2;
+    // CHAR8 String[];
+} FPDT_DUAL_GUID_STRING_EVENT_RECORD;
+
+typedef struct {
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER Header;
+    UINT16   ProgressID;
+    UINT32   ProcessorIdentifier;
+    UINT64   Timestamp;
+    EFI_GUID Guid;
+    UINT64   Qword;
+    // CHAR8 String[];
+} FPDT_GUID_QWORD_STRING_EVENT_RECORD;
+#pragma pack()
+
+//
+// Kinds of start/end pair.  The first DRIVER_KIND_COUNT are charged to
+// the driver (module GUID) that produced them.
+//
+typedef struct {
+    UINT16 StartId;
+    CHAR16 *Name;
+    CHAR16 *JsonName;
+} PERF_KIND;
+
+STATIC PERF_KIND PerfKinds[] = {
+    { MODULE_LOADIMAGE_START_ID,  L"LoadImage",   L"loadImage" },
+    { MODULE_START_ID,            L"StartImage",  L"startImage" },
+    { MODULE_DB_SUPPORT_START_ID, L"DB:Support",  L"bindingSupported" },
+    { MODULE_DB_START_ID,         L"DB:Start",    L"bindingStart" },
+    { MODULE_DB_STOP_START_ID,    L"DB:Stop",     L"bindingStop" },
+    { PERF_EVENTSIGNAL_START_ID,  L"EventSignal", L"eventSignal" },
+    { PERF_CALLBACK_START_ID,     L"Callback",    L"callback" },
+    { PERF_FUNCTION_START_ID,     L"Function",    L"function" },
+    { PERF_INMODULE_START_ID,     L"InModule",    L"inModule" },
+    { PERF_CROSSMODULE_START_ID,  L"CrossModule", L"crossModule" }
+};
+
+#define PERF_KIND_COUNT     (sizeof(PerfKinds) / sizeof(PerfKinds[0]))
+#define DRIVER_KIND_COUNT   5
+#define KIND_CROSSMODULE    (PERF_KIND_COUNT - 1)
+#define KIND_NONE           0xff
+
+//
+// One start record, and its duration once the end record is seen.
+// Open starts hang off a small hash of (GUID, kind) so that an end
+// record finds its start without rescanning the table.
+//
+typedef struct {
+    CONST EFI_GUID *Guid;
+    CONST CHAR8    *String;
+    UINT8          StringLen;
+    UINT8          Kind;
+    BOOLEAN        Open;
+    UINT64         Start;
+    UINT64         Duration;
+    UINT32         Prev;               // previous open start in the bucket, 1 based
+} PERF_MEASUREMENT;
+
+typedef struct {
+    CONST EFI_GUID *Guid;
+    CONST CHAR8    *Name;
+    UINT8          NameLen;
+    UINT64         Total;
+    UINT64         KindTotal[DRIVER_KIND_COUNT];
+} PERF_DRIVER;
+
+#define PENDING_HASH_SIZE   256        // power of 2
+
+typedef struct {
+    PERF_MEASUREMENT *Meas;
+    UINTN            MeasCount;
+    UINT32           Pending[PENDING_HASH_SIZE];
+    PERF_DRIVER      *Drivers;
+    UINTN            DriverCount;
+    UINTN            DriverSlots;      // power of 2, Drivers is open addressed
+    UINT64           KindTotal[PERF_KIND_COUNT];
+    UINTN            KindCount[PERF_KIND_COUNT];
+    UINTN            Unmatched;
+} PERF_DATA;
+
+
+BOOLEAN
+IsNumber( CHAR16* str )
+{
+    CHAR16 *s = str;
+
+    if (*str == L'\0')
+        return FALSE;
+
+    while (*s) {
+        if (*s  < L'0' || *s > L'9')
+            return FALSE;
+        s++;
+    }
+
+    return TRUE;
+}
+
+
+static UINT64
+NsToUs( UINT64 Ns )
+{
+    return DivU64x32(Ns, NS_PER_US);
+}
+
+
+static VOID
+AsciiToUnicodeSize( CONST CHAR8 *String,
+                    UINT8 length,
+                    CHAR16 *UniString )
+{
+    int len = length;
+
+    while (*String != '\0' && len > 0) {
+        *(UniString++) = (CHAR16) *(String++);
+        len--;
+    }
+    *UniString = '\0';
+}
+
+
+static UINT8
+KindFromId( UINT16 ProgressId,
+            BOOLEAN *IsEnd )
+{
+    for (UINT8 i = 0; i < PERF_KIND_COUNT; i++) {
+        if (ProgressId == PerfKinds[i].StartId) {
+            *IsEnd = FALSE;
+            return i;
+        }
+        if (ProgressId == PerfKinds[i].StartId + 1) {
+            *IsEnd = TRUE;
+            return i;
+        }
+    }
+
+    return KIND_NONE;
+}
+
+
+static UINTN
+HashGuid( CONST EFI_GUID *Guid,
+          UINTN Seed )
+{
+    UINT32 Value = ReadUnaligned32((CONST UINT32 *)Guid) ^ ReadUnaligned32((CONST UINT32 *)Guid + 3);
+
+    return (UINTN)(((Value ^ (UINT32)Seed) * 2654435769U) >> 16);
+}
+
+
+//
+// Point String/StringLen at the record's ASCII string, if it has one
+//
+static VOID
+RecordString( FPDT_GUID_EVENT_RECORD *Record,
+              CONST CHAR8 **String,
+              UINT8 *StringLen )
+{
+    UINTN Offset;
+    UINT8 Len = 0;
+
+    switch (Record->Header.Type) {
+        case FPDT_DYNAMIC_STRING_EVENT_TYPE:
+            Offset = sizeof(FPDT_GUID_EVENT_RECORD);
+            break;
+        case FPDT_DUAL_GUID_STRING_EVENT_TYPE:
+            Offset = sizeof(FPDT_DUAL_GUID_STRING_EVENT_RECORD);
+            break;
+        case FPDT_GUID_QWORD_STRING_EVENT_TYPE:
+            Offset = sizeof(FPDT_GUID_QWORD_STRING_EVENT_RECORD);
+            break;
+        default:
+            *String = NULL;
+            *StringLen = 0;
+            return;
+    }
+
+    if (Record->Header.Length <= Offset) {
+        *String = NULL;
+        *StringLen = 0;
+        return;
+    }
+
+    *String = (CONST CHAR8 *)Record + Offset;
+    while (Len < Record->Header.Length - Offset && (*String)[Len] != '\0') {
+        Len++;
+    }
+    *StringLen = Len;
+}
+
+
+static PERF_DRIVER *
+FindDriver( PERF_DATA *Data,
+            CONST EFI_GUID *Guid )
+{
+    UINTN Slot = HashGuid(Guid, 0) & (Data->DriverSlots - 1);
+
+    while (Data->Drivers[Slot].Guid != NULL) {
+        if (CompareGuid(Data->Drivers[Slot].Guid, Guid)) {
+            return &Data->Drivers[Slot];
+        }
+        Slot = (Slot + 1) & (Data->DriverSlots - 1);
+    }
+
+    Data->Drivers[Slot].Guid = Guid;
+    Data->DriverCount++;
+
+    return &Data->Drivers[Slot];
+}
+
+
+static VOID
+StartMeasurement( PERF_DATA *Data,
+                  FPDT_GUID_EVENT_RECORD *Record,
+                  UINT8 Kind,
+                  CONST CHAR8 *String,
+                  UINT8 StringLen )
+{
+    PERF_MEASUREMENT *Meas = &Data->Meas[Data->MeasCount];
+    UINTN Bucket = HashGuid(&Record->Guid, Kind) & (PENDING_HASH_SIZE - 1);
+
+    Meas->Guid = &Record->Guid;
+    Meas->String = String;
+    Meas->StringLen = StringLen;
+    Meas->Kind = Kind;
+    Meas->Open = TRUE;
+    Meas->Start = Record->Timestamp;
+    Meas->Prev = Data->Pending[Bucket];
+    Data->MeasCount++;
+    Data->Pending[Bucket] = (UINT32)Data->MeasCount;
+}
+
+
+//
+// Close the most recent open start with the same GUID and kind, and for
+// the token based kinds the same string.  Driver end records carry other
+// strings (DB:Start ends name the controller device path), so only the
+// GUID identifies those.  Measurements nest, so the match is almost
+// always the head of the bucket.
+//
+static VOID
+EndMeasurement( PERF_DATA *Data,
+                FPDT_GUID_EVENT_RECORD *Record,
+                UINT8 Kind,
+                CONST CHAR8 *String,
+                UINT8 StringLen )
+{
+    UINTN  Bucket = HashGuid(&Record->Guid, Kind) & (PENDING_HASH_SIZE - 1);
+    UINT32 *Link = &Data->Pending[Bucket];
+    PERF_MEASUREMENT *Meas;
+    PERF_DRIVER *Driver;
+
+    while (*Link != 0) {
+        Meas = &Data->Meas[*Link - 1];
+        if (Meas->Kind == Kind &&
+            CompareGuid(Meas->Guid, &Record->Guid) &&
+            (Kind < DRIVER_KIND_COUNT ||
+             (Meas->StringLen == StringLen &&
+              (StringLen == 0 || CompareMem(Meas->String, String, StringLen) == 0)))) {
+            break;
+        }
+        Link = &Meas->Prev;
+    }
+    if (*Link == 0) {
+        Data->Unmatched++;
+        return;
+    }
+
+    *Link = Meas->Prev;
+    Meas->Open = FALSE;
+    Meas->Duration = (Record->Timestamp >= Meas->Start) ? Record->Timestamp - Meas->Start : 0;
+
+    Data->KindTotal[Kind] += Meas->Duration;
+    Data->KindCount[Kind]++;
+
+    if (Kind < DRIVER_KIND_COUNT) {
+        Driver = FindDriver(Data, Meas->Guid);
+        Driver->Total += Meas->Duration;
+        Driver->KindTotal[Kind] += Meas->Duration;
+        // LoadImage/StartImage start records carry the module name
+        if (Driver->Name == NULL && Meas->StringLen > 0 &&
+            (PerfKinds[Kind].StartId == MODULE_LOADIMAGE_START_ID ||
+             PerfKinds[Kind].StartId == MODULE_START_ID)) {
+            Driver->Name = Meas->String;
+            Driver->NameLen = Meas->StringLen;
+        }
+    }
+}
+
+
+//
+// One pass over the FBPT matching start and end records
+//
+static EFI_STATUS
+CollectMeasurements( EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *Fbpt,
+                     PERF_DATA *Data )
+{
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *Header;
+    FPDT_GUID_EVENT_RECORD *Record;
+    UINT8 *Ptr;
+    UINT8 *End = (UINT8 *)Fbpt + Fbpt->Length;
+    UINTN Records = 0;
+    CONST CHAR8 *String;
+    UINT8 StringLen;
+    UINT8 Kind;
+    BOOLEAN IsEnd;
+
+    ZeroMem(Data, sizeof(*Data));
+
+    // every extended record is at least this long, which bounds the count
+    Records = (Fbpt->Length / sizeof(FPDT_GUID_EVENT_RECORD)) + 1;
+    Data->DriverSlots = 64;
+    while (Data->DriverSlots < Records * 2) {
+        Data->DriverSlots <<= 1;
+    }
+
+    Data->Meas = AllocateZeroPool(Records * sizeof(PERF_MEASUREMENT));
+    Data->Drivers = AllocateZeroPool(Data->DriverSlots * sizeof(PERF_DRIVER));
+    if (Data->Meas == NULL || Data->Drivers == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+    }
+
+    for (Ptr = (UINT8 *)(Fbpt + 1); Ptr + sizeof(*Header) <= End; Ptr += Header->Length) {
+        Header = (EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *)Ptr;
+        if (Header->Length < sizeof(*Header) || Ptr + Header->Length > End) {
+            break;
+        }
+        if (Header->Type < FPDT_GUID_EVENT_TYPE ||
+            Header->Type > FPDT_GUID_QWORD_STRING_EVENT_TYPE ||
+            Header->Length < sizeof(FPDT_GUID_EVENT_RECORD)) {
+            continue;
+        }
+
+        Record = (FPDT_GUID_EVENT_RECORD *)Ptr;
+        Kind = KindFromId(Record->ProgressID, &IsEnd);
+        if (Kind == KIND_NONE) {
+            continue;
+        }
+
+        RecordString(Record, &String, &StringLen);
+        if (IsEnd) {
+            EndMeasurement(Data, Record, Kind, String, StringLen);
+        } else {
+            StartMeasurement(Data, Record, Kind, String, StringLen);
+        }
+    }
+
+    for (UINTN i = 0; i < Data->MeasCount; i++) {
+        if (Data->Meas[i].Open) {
+            Data->Unmatched++;
+        }
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+static VOID
+FreeMeasurements( PERF_DATA *Data )
+{
+    if (Data->Meas != NULL) {
+        FreePool(Data->Meas);
+    }
+    if (Data->Drivers != NULL) {
+        FreePool(Data->Drivers);
+    }
+}
+
+
+//
+// Indices of the Count slowest drivers, slowest first
+//
+static UINTN
+SlowestDrivers( PERF_DATA *Data,
+                UINTN *Top,
+                UINTN Count )
+{
+    UINTN Found = 0;
+    UINTN j;
+
+    for (UINTN i = 0; i < Data->DriverSlots; i++) {
+        if (Data->Drivers[i].Guid == NULL) {
+            continue;
+        }
+        for (j = Found; j > 0 && Data->Drivers[Top[j - 1]].Total < Data->Drivers[i].Total; j--) {
+            if (j < Count) {
+                Top[j] = Top[j - 1];
+            }
+        }
+        if (j < Count) {
+            Top[j] = i;
+            if (Found < Count) {
+                Found++;
+            }
+        }
+    }
+
+    return Found;
+}
+
+
+//
+// Locate the FBPT through the FPDT boot performance pointer record
+//
+static EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *
+FindFBPT( EFI_ACPI_DESCRIPTION_HEADER *Fpdt )
+{
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *Record;
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *Fbpt;
+    UINT8 *Ptr = (UINT8 *)(Fpdt + 1);
+    UINT8 *End = (UINT8 *)Fpdt + Fpdt->Length;
+
+    while (Ptr + sizeof(*Record) <= End) {
+        Record = (EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *)Ptr;
+        if (Record->Length < sizeof(*Record) || Ptr + Record->Length > End) {
+            break;
+        }
+        if (Record->Type == EFI_ACPI_5_0_FPDT_RECORD_TYPE_FIRMWARE_BASIC_BOOT_POINTER &&
+            Record->Length >= sizeof(EFI_ACPI_5_0_FPDT_BOOT_PERFORMANCE_TABLE_POINTER_RECORD)) {
+            Fbpt = (EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *)(UINTN)
+                   ((EFI_ACPI_5_0_FPDT_BOOT_PERFORMANCE_TABLE_POINTER_RECORD *)Record)->BootPerformanceTablePointer;
+            if (Fbpt != NULL && Fbpt->Signature == EFI_ACPI_5_0_FPDT_BOOT_PERFORMANCE_TABLE_SIGNATURE) {
+                return Fbpt;
+            }
+        }
+        Ptr += Record->Length;
+    }
+
+    return NULL;
+}
+
+
+static VOID
+PrintBootPerf( PERF_DATA *Data,
+               UINTN TopCount )
+{
+    UINTN  Top[MAX_TOP_COUNT];
+    UINTN  Found;
+    PERF_DRIVER *Driver;
+    PERF_MEASUREMENT *Meas;
+    CHAR16 Name[256];
+
+    OutputPrint(L"\nPhases (cross-module measurements)\n");
+    for (UINTN i = 0; i < Data->MeasCount; i++) {
+        Meas = &Data->Meas[i];
+        if (Meas->Kind != KIND_CROSSMODULE || Meas->Open) {
+            continue;
+        }
+        AsciiToUnicodeSize(Meas->String != NULL ? Meas->String : "", Meas->StringLen, Name);
+        OutputPrint(L"  %-24s  Start %10ld us  Duration %10ld us\n", Name,
+                    NsToUs(Meas->Start), NsToUs(Meas->Duration));
+    }
+
+    OutputPrint(L"\nTotals by measurement type\n");
+    for (UINTN i = 0; i < PERF_KIND_COUNT; i++) {
+        if (Data->KindCount[i] == 0) {
+            continue;
+        }
+        OutputPrint(L"  %-12s  %6d measurements  %10ld us\n", PerfKinds[i].Name,
+                    Data->KindCount[i], NsToUs(Data->KindTotal[i]));
+    }
+
+    Found = SlowestDrivers(Data, Top, TopCount);
+    OutputPrint(L"\nSlowest %d of %d drivers (us)\n", Found, Data->DriverCount);
+    OutputPrint(L"  %10s %10s %10s %10s %10s %10s  Driver\n",
+                L"Total", L"LoadImage", L"StartImage", L"DB:Support", L"DB:Start", L"DB:Stop");
+    for (UINTN i = 0; i < Found; i++) {
+        Driver = &Data->Drivers[Top[i]];
+        OutputPrint(L"  %10ld %10ld %10ld %10ld %10ld %10ld  ",
+                    NsToUs(Driver->Total),
+                    NsToUs(Driver->KindTotal[0]), NsToUs(Driver->KindTotal[1]),
+                    NsToUs(Driver->KindTotal[2]), NsToUs(Driver->KindTotal[3]),
+                    NsToUs(Driver->KindTotal[4]));
+        if (Driver->Name != NULL) {
+            AsciiToUnicodeSize(Driver->Name, Driver->NameLen, Name);
+            OutputPrint(L"%s (%g)\n", Name, Driver->Guid);
+        } else {
+            OutputPrint(L"%g\n", Driver->Guid);
+        }
+    }
+
+    if (Data->Unmatched > 0) {
+        OutputPrint(L"\n%d start or end records had no match.\n", Data->Unmatched);
+    }
+    OutputPrint(L"\n");
+}
+
+
+static VOID
+JsonBootPerf( PERF_DATA *Data,
+              UINTN TopCount )
+{
+    UINTN  Top[MAX_TOP_COUNT];
+    UINTN  Found;
+    PERF_DRIVER *Driver;
+    PERF_MEASUREMENT *Meas;
+
+    JsonArrayBegin(L"phases");
+    for (UINTN i = 0; i < Data->MeasCount; i++) {
+        Meas = &Data->Meas[i];
+        if (Meas->Kind != KIND_CROSSMODULE || Meas->Open) {
+            continue;
+        }
+        JsonObjectBegin(NULL);
+        JsonAsciiString(L"name", Meas->String != NULL ? Meas->String : "", Meas->StringLen);
+        JsonUint(L"startUs", NsToUs(Meas->Start));
+        JsonUint(L"durationUs", NsToUs(Meas->Duration));
+        JsonObjectEnd();
+    }
+    JsonArrayEnd();
+
+    JsonObjectBegin(L"totals");
+    for (UINTN i = 0; i < PERF_KIND_COUNT; i++) {
+        if (Data->KindCount[i] == 0) {
+            continue;
+        }
+        JsonObjectBegin(PerfKinds[i].JsonName);
+        JsonUint(L"count", Data->KindCount[i]);
+        JsonUint(L"totalUs", NsToUs(Data->KindTotal[i]));
+        JsonObjectEnd();
+    }
+    JsonObjectEnd();
+
+    Found = SlowestDrivers(Data, Top, TopCount);
+    JsonUint(L"driverCount", Data->DriverCount);
+    JsonArrayBegin(L"slowestDrivers");
+    for (UINTN i = 0; i < Found; i++) {
+        Driver = &Data->Drivers[Top[i]];
+        JsonObjectBegin(NULL);
+        JsonGuid(L"guid", Driver->Guid);
+        if (Driver->Name != NULL) {
+            JsonAsciiString(L"name", Driver->Name, Driver->NameLen);
+        } else {
+            JsonNull(L"name");
+        }
+        JsonUint(L"totalUs", NsToUs(Driver->Total));
+        for (UINTN k = 0; k < DRIVER_KIND_COUNT; k++) {
+            JsonUint(PerfKinds[k].JsonName, NsToUs(Driver->KindTotal[k]));
+        }
+        JsonObjectEnd();
+    }
+    JsonArrayEnd();
+
+    JsonUint(L"unmatched", Data->Unmatched);
+}
+
+
+static VOID
+Usage( CHAR16 *Str,
+       BOOLEAN ErrorMsg )
+{
+    if ( ErrorMsg ) {
+        OutputPrint(L"ERROR: Unknown option.\n");
+    }
+    OutputPrint(L"Usage: %s [-n | --top <count>]\n", Str);
+    OutputPrint(L"       %s [--json]\n", Str);
+    OutputPrint(L"       %s [-V | --version]\n", Str);
+}
+
+
+INTN
+EFIAPI
+ShellAppMain( UINTN Argc,
+              CHAR16 **Argv )
+{
+    EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *Rsdp = NULL;
+    EFI_ACPI_DESCRIPTION_HEADER *Fpdt = NULL;
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *Fbpt = NULL;
+    EFI_STATUS Status = EFI_SUCCESS;
+    PERF_DATA  Data;
+    UINTN      TopCount = DEFAULT_TOP_COUNT;
+    BOOLEAN    Json = FALSE;
+
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
+
+    if (Argc == 2) {
+        if (!StrCmp(Argv[1], L"--version") ||
+            !StrCmp(Argv[1], L"-V")) {
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
+            return Status;
+        } else if (!StrCmp(Argv[1], L"--help") ||
+            !StrCmp(Argv[1], L"-h")) {
+            Usage(Argv[0], FALSE);
+            return Status;
+        } else {
+            Usage(Argv[0], TRUE);
+            return Status;
+        }
+    } else if (Argc == 3) {
+        if ((!StrCmp(Argv[1], L"--top") ||
+            !StrCmp(Argv[1], L"-n")) && IsNumber(Argv[2])) {
+            TopCount = (UINTN) StrDecimalToUint64( Argv[2] );
+        } else {
+            Usage(Argv[0], TRUE);
+            return Status;
+        }
+    } else if (Argc > 3) {
+        Usage(Argv[0], TRUE);
+        return Status;
+    }
+
+    if (TopCount < 1) {
+        TopCount = DEFAULT_TOP_COUNT;
+    } else if (TopCount > MAX_TOP_COUNT) {
+        TopCount = MAX_TOP_COUNT;
+    }
+
+    if (Json) {
+        JsonDocumentBegin(L"ShowBootPerf", UTILITY_VERSION);
+    }
+
+    // FPDT -> FBPT; the extended records follow the basic boot record
+    Rsdp = AcpiIndexRsdp();
+    if (Rsdp != NULL) {
+        Fpdt = AcpiIndexFind(EFI_ACPI_5_0_FIRMWARE_PERFORMANCE_DATA_TABLE_SIGNATURE, 0);
+    }
+    if (Fpdt != NULL) {
+        Fbpt = FindFBPT(Fpdt);
+    }
+
+    if (Rsdp == NULL) {
+        JsonError(L"Could not find an ACPI RSDP table.");
+        Status = EFI_NOT_FOUND;
+    } else if (Fpdt == NULL) {
+        JsonError(L"Could not find an ACPI FPDT table.");
+        Status = EFI_NOT_FOUND;
+    } else if (Fbpt == NULL) {
+        JsonError(L"Could not find the Firmware Basic Boot Performance Table.");
+        Status = EFI_NOT_FOUND;
+    } else {
+        Status = CollectMeasurements(Fbpt, &Data);
+        if (EFI_ERROR(Status)) {
+            JsonError(L"Out of memory.");
+        } else if (Data.MeasCount == 0) {
+            JsonError(L"No EDK II performance records found. Firmware built without PERFORMANCE_MEASUREMENT_ENABLE?");
+            Status = EFI_NOT_FOUND;
+        } else if (Json) {
+            JsonHex(L"fbptAddress", (UINTN)Fbpt);
+            JsonBootPerf(&Data, TopCount);
+        } else {
+            PrintBootPerf(&Data, TopCount);
+        }
+        FreeMeasurements(&Data);
+    }
+
+    if (Json) {
+        JsonDocumentEnd();
+    }
+
+    return Status;
+}
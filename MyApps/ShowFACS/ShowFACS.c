@@ -14,13 +14,16 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/PrintLib.h>
+#include <Library/HexDumpLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/AcpiTableIndexLib.h>
+#include <Library/AcpiTableDecodeLib.h>
 
 #include <Protocol/EfiShell.h>
 #include <Protocol/LoadedImage.h>
 #include <Protocol/AcpiSystemDescriptionTable.h>
 
-#include <Guid/Acpi.h>
-
 #define UTILITY_VERSION L"20180226"
 #undef DEBUG
 
@@ -62,113 +65,44 @@ AsciiToUnicodeSize( CHAR8 *String,
 }
 
 
-static VOID
-PrintHexTable( UINT8 *ptr,
-               int Count )
-{
-    int i = 0;
-
-    Print(L"  ");
-    for (i = 0; i < Count; i++ ) {
-        if ( i > 0 && i%16 == 0)
-            Print(L"\n  ");
-        Print(L"0x%02x ", 0xff & *ptr++);
-    }
-    Print(L"\n");
-}
-
-
 static VOID 
-PrintFACS( EFI_ACPI_2_0_FIRMWARE_ACPI_CONTROL_STRUCTURE *Facs,
+PrintFACS( EFI_ACPI_DESCRIPTION_HEADER *Table,
            BOOLEAN Hexdump )
 {
+    EFI_ACPI_2_0_FIRMWARE_ACPI_CONTROL_STRUCTURE *Facs = (EFI_ACPI_2_0_FIRMWARE_ACPI_CONTROL_STRUCTURE *)Table;
     CHAR16 Buffer[50];
 
-    Print(L"\n");
+    OutputPrint(L"\n");
     if (Hexdump) {
-        PrintHexTable( (UINT8 *)Facs, (int)(Facs->Length) );
+        HexDump( L"  ", L"  ", Facs, Facs->Length, 16, HEXDUMP_0X );
     } else {
-        Print(L"FACS Table Details\n"); 
+        OutputPrint(L"FACS Table Details\n"); 
         AsciiToUnicodeSize((CHAR8 *)&(Facs->Signature), 4, Buffer, TRUE);
-        Print(L"  Signature             : %s\n", Buffer);
-        Print(L"  Length                : 0x%08x (%d)\n", Facs->Length, Facs->Length);
-        Print(L"  Hardware Signature    : 0x%08x (%d)\n", Facs->HardwareSignature, 
-                                                          Facs->HardwareSignature);
-        Print(L"  FirmwareWakingVector  : 0x%08x (%d)\n", Facs->FirmwareWakingVector, 
-                                                          Facs->FirmwareWakingVector);
-        Print(L"  GlobalLock            : 0x%08x (%d)\n", Facs->GlobalLock, Facs->GlobalLock);
-        Print(L"  Flags                 : 0x%08x (%d)\n", Facs->Flags, Facs->Flags);
-        Print(L"  XFirmwareWakingVector : 0x%016x (%ld)\n", Facs->XFirmwareWakingVector, 
-                                                            Facs->XFirmwareWakingVector);
-        Print(L"  Version               : 0x%02x (%d)\n", Facs->Version, Facs->Version);
-	Print(L"  Reserved:\n");
-        PrintHexTable( (UINT8 *)&(Facs->Reserved), 31 );
+        OutputPrint(L"  Signature             : %s\n", Buffer);
+        OutputPrint(L"  Length                : 0x%08x (%d)\n", Facs->Length, Facs->Length);
+        AcpiDecodeFacs(Table, TRUE, FALSE);
     }
-    Print(L"\n");
+    OutputPrint(L"\n");
 }
 
 
-static int
-ParseRSDP( EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *Rsdp, 
-           CHAR16* GuidStr, 
-           BOOLEAN Hexdump )
+static VOID 
+JsonFACS( EFI_ACPI_DESCRIPTION_HEADER *Table )
 {
-    EFI_ACPI_2_0_FIXED_ACPI_DESCRIPTION_TABLE *Fadt2Table;
-    EFI_ACPI_2_0_FIRMWARE_ACPI_CONTROL_STRUCTURE *Facs2Table;
-    EFI_ACPI_SDT_HEADER *Xsdt, *Entry;
-    UINT32 EntryCount;
-    UINT64 *EntryPtr;
-#ifdef DEBUG
-    CHAR16 OemStr[20];
-
-    Print(L"\n\nACPI GUID: %s\n", GuidStr);
-
-    AsciiToUnicodeSize((CHAR8 *)(Rsdp->OemId), 6, OemStr, FALSE);
-    Print(L"\nFound RSDP. Version: %d  OEM ID: %s\n", (int)(Rsdp->Revision), OemStr);
-#endif
-
-    if (Rsdp->Revision >= EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER_REVISION) {
-        Xsdt = (EFI_ACPI_SDT_HEADER *)(Rsdp->XsdtAddress);
-    } else {
-#ifdef DEBUG 
-        Print(L"ERROR: No ACPI XSDT table found.\n");
-#endif
-        return 1;
-    }
-
-    if (Xsdt->Signature != SIGNATURE_32 ('X', 'S', 'D', 'T')) {
-#ifdef DEBUG 
-        Print(L"ERROR: Invalid ACPI XSDT table found.\n");
-#endif
-        return 1;
-    }
-
-    EntryCount = (Xsdt->Length - sizeof (EFI_ACPI_SDT_HEADER)) / sizeof(UINT64);
-#ifdef DEBUG 
-    AsciiToUnicodeSize((CHAR8 *)(Xsdt->OemId), 6, OemStr, FALSE);
-    Print(L"Found XSDT. OEM ID: %s  Entry Count: %d\n\n", OemStr, EntryCount);
-#endif
-
-    // Locate Fixed ACPI Description Table - "FACP"
-    EntryPtr = (UINT64 *)(Xsdt + 1);
-    for (int Index = 0; Index < EntryCount; Index++, EntryPtr++) {
-        Entry = (EFI_ACPI_SDT_HEADER *)((UINTN)(*EntryPtr));
-        if (!AsciiStrnCmp( (CHAR8 *)&(Entry->Signature), "FACP", 4)) {
-            Fadt2Table = (EFI_ACPI_2_0_FIXED_ACPI_DESCRIPTION_TABLE *)((UINTN)(*EntryPtr));
-            Facs2Table = (EFI_ACPI_2_0_FIRMWARE_ACPI_CONTROL_STRUCTURE *)((UINTN)(Fadt2Table->FirmwareCtrl));
-            PrintFACS(Facs2Table, Hexdump);
-        }
-    }
-
-    return 0;
+    JsonObjectBegin(NULL);
+    JsonAsciiString(L"signature", (CHAR8 *)&(Table->Signature), 4);
+    JsonUint(L"length", Table->Length);
+    AcpiDecodeFacs(Table, FALSE, TRUE);
+    JsonObjectEnd();
 }
 
 
 static void
 Usage( void )
 {
-    Print(L"Usage: ShowFACS [-d | --dump]\n");
-    Print(L"       ShowFACS [-V | --version]\n");
+    OutputPrint(L"Usage: ShowFACS [-d | --dump]\n");
+    OutputPrint(L"       ShowFACS [--json]\n");
+    OutputPrint(L"       ShowFACS [-V | --version]\n");
 }
 
 
@@ -177,13 +111,14 @@ EFIAPI
 ShellAppMain( UINTN Argc, 
               CHAR16 **Argv )
 {
-    EFI_CONFIGURATION_TABLE *ect = gST->ConfigurationTable;
     EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *Rsdp = NULL;
-    EFI_GUID gAcpi20TableGuid = EFI_ACPI_20_TABLE_GUID;
-    EFI_GUID gAcpi10TableGuid = ACPI_10_TABLE_GUID;
+    EFI_ACPI_DESCRIPTION_HEADER *Table;
     EFI_STATUS Status = EFI_SUCCESS;
-    CHAR16 GuidStr[100];
     BOOLEAN Hexdump = FALSE;
+    BOOLEAN Json = FALSE;
+
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
 
     if (Argc == 2) {
         if (!StrCmp(Argv[1], L"--dump") ||
@@ -191,7 +126,7 @@ ShellAppMain( UINTN Argc,
             Hexdump = TRUE;
         } else if (!StrCmp(Argv[1], L"--version") ||
             !StrCmp(Argv[1], L"-V")) {
-            Print(L"Version: %s\n", UTILITY_VERSION);
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
             return Status;
         } else if (!StrCmp(Argv[1], L"--help") ||
             !StrCmp(Argv[1], L"-h")) {
@@ -207,23 +142,29 @@ ShellAppMain( UINTN Argc,
         return Status;
     }
 
-    // Locate Root System Description Pointer Table - "RSDP" 
-    for (int i = 0; i < gST->NumberOfTableEntries; i++) {
-        if ((CompareGuid (&(gST->ConfigurationTable[i].VendorGuid), &gAcpi20TableGuid)) ||
-            (CompareGuid (&(gST->ConfigurationTable[i].VendorGuid), &gAcpi10TableGuid))) {
-            if (!AsciiStrnCmp("RSD PTR ", (CHAR8 *)(ect->VendorTable), 8)) {
-                UnicodeSPrint(GuidStr, sizeof(GuidStr), L"%g", &(gST->ConfigurationTable[i].VendorGuid));
-                Rsdp = (EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *)ect->VendorTable;
-                ParseRSDP(Rsdp, GuidStr, Hexdump); 
-            }        
+    if (Json) {
+        JsonDocumentBegin(L"ShowFACS", UTILITY_VERSION);
+        JsonArrayBegin(L"facs");
+    }
+
+    // look up the FACS table(s) in the shared ACPI table index
+    Rsdp = AcpiIndexRsdp();
+    for (UINTN i = 0; Rsdp != NULL && (Table = AcpiIndexFind(SIGNATURE_32('F', 'A', 'C', 'S'), i)) != NULL; i++) {
+        if (Json) {
+            JsonFACS(Table);
+        } else {
+            PrintFACS(Table, Hexdump);
         }
-        ect++;
     }
 
     if (Rsdp == NULL) {
-        Print(L"ERROR: Could not find an ACPI RSDP table.\n");
+        JsonError(L"Could not find an ACPI RSDP table.");
         Status = EFI_NOT_FOUND;
     }
 
+    if (Json) {
+        JsonDocumentEnd();
+    }
+
     return Status;
 }
@@ -0,0 +1,503 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Show ACPI FPDT (Firmware Performance Data Table) boot and S3 resume timings
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/UefiLib.h>
+#include <Library/ShellCEntryLib.h>
+#include <Library/ShellLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/AcpiTableIndexLib.h>
+
+#include <Protocol/EfiShell.h>
+#include <Protocol/LoadedImage.h>
+#include <Protocol/AcpiSystemDescriptionTable.h>
+
+#define UTILITY_VERSION L"20181020"
+#undef DEBUG
+
+// FPDT timestamps are in nanoseconds since reset
+#define NS_PER_US  1000
+
+//
+// Basic Boot Performance Record events, in boot order
+//
+typedef struct {
+    CHAR16 *Name;
+    CHAR16 *JsonName;
+    UINTN  Offset;
+} BOOT_EVENT;
+
+STATIC BOOT_EVENT BootEvents[] = {
+    { L"Reset End",                    L"resetEnd",
+      OFFSET_OF(EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD, ResetEnd) },
+    { L"OS Loader LoadImage Start",    L"osLoaderLoadImageStart",
+      OFFSET_OF(EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD, OsLoaderLoadImageStart) },
+    { L"OS Loader StartImage Start",   L"osLoaderStartImageStart",
+      OFFSET_OF(EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD, OsLoaderStartImageStart) },
+    { L"ExitBootServices Entry",       L"exitBootServicesEntry",
+      OFFSET_OF(EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD, ExitBootServicesEntry) },
+    { L"ExitBootServices Exit",        L"exitBootServicesExit",
+      OFFSET_OF(EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD, ExitBootServicesExit) }
+};
+
+#define BOOT_EVENT_COUNT  (sizeof(BootEvents) / sizeof(BootEvents[0]))
+
+// phase i runs from event i-1 (reset for i = 0) to event i
+STATIC CHAR16 *BootPhases[BOOT_EVENT_COUNT] = {
+    L"Reset",
+    L"Firmware",
+    L"OS Loader Load",
+    L"OS Loader",
+    L"ExitBootServices"
+};
+
+STATIC CHAR16 *BootPhasesJson[BOOT_EVENT_COUNT] = {
+    L"reset",
+    L"firmware",
+    L"osLoaderLoad",
+    L"osLoader",
+    L"exitBootServices"
+};
+
+
+static VOID
+AsciiToUnicodeSize( CHAR8 *String,
+                    UINT8 length,
+                    CHAR16 *UniString )
+{
+    int len = length;
+
+    while (*String != '\0' && len > 0) {
+        *(UniString++) = (CHAR16) *(String++);
+        len--;
+    }
+    *UniString = '\0';
+}
+
+
+static UINT64
+NsToUs( UINT64 Ns )
+{
+    return DivU64x32(Ns, NS_PER_US);
+}
+
+
+static UINT64
+BootEventTime( EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD *Record,
+               UINTN Event )
+{
+    return *(UINT64 *)((UINT8 *)Record + BootEvents[Event].Offset);
+}
+
+
+//
+// Records in a performance table (FBPT/S3PT) follow its 8 byte header
+//
+static EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *
+NextRecord( EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *Table,
+            EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *Record )
+{
+    UINT8 *Ptr;
+    UINT8 *End = (UINT8 *)Table + Table->Length;
+
+    if (Record == NULL) {
+        Ptr = (UINT8 *)(Table + 1);
+    } else {
+        Ptr = (UINT8 *)Record + Record->Length;
+    }
+
+    if (Ptr + sizeof(EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER) > End) {
+        return NULL;
+    }
+    Record = (EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *)Ptr;
+    if (Record->Length < sizeof(EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER) ||
+        Ptr + Record->Length > End) {
+        return NULL;
+    }
+
+    return Record;
+}
+
+
+static EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *
+FindRecord( EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *Table,
+            UINT16 Type,
+            UINTN MinLength )
+{
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *Record = NULL;
+
+    while ((Record = NextRecord(Table, Record)) != NULL) {
+        if (Record->Type == Type && Record->Length >= MinLength) {
+            return Record;
+        }
+    }
+
+    return NULL;
+}
+
+
+//
+// Follow the FPDT pointer records to the FBPT and S3PT
+//
+static VOID
+FindPerformanceTables( EFI_ACPI_DESCRIPTION_HEADER *Fpdt,
+                       EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER **Fbpt,
+                       EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER **S3pt )
+{
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *Record;
+    UINT8 *Ptr = (UINT8 *)(Fpdt + 1);
+    UINT8 *End = (UINT8 *)Fpdt + Fpdt->Length;
+    UINT64 Address;
+
+    *Fbpt = NULL;
+    *S3pt = NULL;
+
+    while (Ptr + sizeof(*Record) <= End) {
+        Record = (EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *)Ptr;
+        if (Record->Length < sizeof(*Record) || Ptr + Record->Length > End) {
+            break;
+        }
+        if (Record->Type == EFI_ACPI_5_0_FPDT_RECORD_TYPE_FIRMWARE_BASIC_BOOT_POINTER &&
+            Record->Length >= sizeof(EFI_ACPI_5_0_FPDT_BOOT_PERFORMANCE_TABLE_POINTER_RECORD)) {
+            Address = ((EFI_ACPI_5_0_FPDT_BOOT_PERFORMANCE_TABLE_POINTER_RECORD *)Record)->BootPerformanceTablePointer;
+            *Fbpt = (EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *)(UINTN)Address;
+        } else if (Record->Type == EFI_ACPI_5_0_FPDT_RECORD_TYPE_S3_PERFORMANCE_TABLE_POINTER &&
+            Record->Length >= sizeof(EFI_ACPI_5_0_FPDT_S3_PERFORMANCE_TABLE_POINTER_RECORD)) {
+            Address = ((EFI_ACPI_5_0_FPDT_S3_PERFORMANCE_TABLE_POINTER_RECORD *)Record)->S3PerformanceTablePointer;
+            *S3pt = (EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *)(UINTN)Address;
+        }
+        Ptr += Record->Length;
+    }
+
+    if (*Fbpt != NULL && (*Fbpt)->Signature != EFI_ACPI_5_0_FPDT_BOOT_PERFORMANCE_TABLE_SIGNATURE) {
+        *Fbpt = NULL;
+    }
+    if (*S3pt != NULL && (*S3pt)->Signature != EFI_ACPI_5_0_FPDT_S3_PERFORMANCE_TABLE_SIGNATURE) {
+        *S3pt = NULL;
+    }
+}
+
+
+static VOID
+PrintRecords( EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *Table )
+{
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER *Record = NULL;
+
+    OutputPrint(L"  Records:\n");
+    while ((Record = NextRecord(Table, Record)) != NULL) {
+        OutputPrint(L"    Type 0x%04x  Length %3d  Revision %d\n",
+                    Record->Type, Record->Length, Record->Revision);
+    }
+}
+
+
+static VOID
+PrintFBPT( EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *Fbpt,
+           BOOLEAN Verbose )
+{
+    EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD *Boot;
+    UINT64 Previous = 0;
+    UINT64 Time;
+
+    OutputPrint(L"\nFirmware Basic Boot Performance Table (FBPT)\n");
+    OutputPrint(L"  Address               : 0x%lx\n", (UINT64)(UINTN)Fbpt);
+    OutputPrint(L"  Length                : %d\n", Fbpt->Length);
+    if (Verbose) {
+        PrintRecords(Fbpt);
+    }
+
+    Boot = (EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD *)
+           FindRecord( Fbpt,
+                       EFI_ACPI_5_0_FPDT_RUNTIME_RECORD_TYPE_FIRMWARE_BASIC_BOOT,
+                       sizeof(EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD) );
+    if (Boot == NULL) {
+        OutputPrint(L"  No Firmware Basic Boot Performance Record found.\n");
+        return;
+    }
+
+    OutputPrint(L"\n  Boot Timeline                       Time (us)      Phase (us)\n");
+    for (UINTN i = 0; i < BOOT_EVENT_COUNT; i++) {
+        Time = BootEventTime(Boot, i);
+        if (Time == 0 && i > 0) {
+            OutputPrint(L"  %-30s  %12s\n", BootEvents[i].Name, L"-");
+            continue;
+        }
+        if (Previous != 0 || i == 0) {
+            OutputPrint(L"  %-30s  %12ld  %14ld  %s\n", BootEvents[i].Name, NsToUs(Time),
+                        NsToUs(Time - Previous), BootPhases[i]);
+        } else {
+            OutputPrint(L"  %-30s  %12ld\n", BootEvents[i].Name, NsToUs(Time));
+        }
+        Previous = Time;
+    }
+}
+
+
+static VOID
+PrintS3PT( EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *S3pt,
+           BOOLEAN Verbose )
+{
+    EFI_ACPI_5_0_FPDT_S3_RESUME_RECORD  *Resume;
+    EFI_ACPI_5_0_FPDT_S3_SUSPEND_RECORD *Suspend;
+
+    OutputPrint(L"\nS3 Performance Table (S3PT)\n");
+    OutputPrint(L"  Address               : 0x%lx\n", (UINT64)(UINTN)S3pt);
+    OutputPrint(L"  Length                : %d\n", S3pt->Length);
+    if (Verbose) {
+        PrintRecords(S3pt);
+    }
+
+    Resume = (EFI_ACPI_5_0_FPDT_S3_RESUME_RECORD *)
+             FindRecord( S3pt,
+                         EFI_ACPI_5_0_FPDT_RUNTIME_RECORD_TYPE_S3_RESUME,
+                         sizeof(EFI_ACPI_5_0_FPDT_S3_RESUME_RECORD) );
+    if (Resume != NULL) {
+        OutputPrint(L"  Resume Count          : %d\n", Resume->ResumeCount);
+        OutputPrint(L"  Last Resume (us)      : %ld\n", NsToUs(Resume->FullResume));
+        OutputPrint(L"  Average Resume (us)   : %ld\n", NsToUs(Resume->AverageResume));
+    } else {
+        OutputPrint(L"  No S3 Resume Record found.\n");
+    }
+
+    Suspend = (EFI_ACPI_5_0_FPDT_S3_SUSPEND_RECORD *)
+              FindRecord( S3pt,
+                          EFI_ACPI_5_0_FPDT_RUNTIME_RECORD_TYPE_S3_SUSPEND,
+                          sizeof(EFI_ACPI_5_0_FPDT_S3_SUSPEND_RECORD) );
+    if (Suspend != NULL) {
+        OutputPrint(L"  Suspend Start (us)    : %ld\n", NsToUs(Suspend->SuspendStart));
+        OutputPrint(L"  Suspend End (us)      : %ld\n", NsToUs(Suspend->SuspendEnd));
+        if (Suspend->SuspendEnd >= Suspend->SuspendStart) {
+            OutputPrint(L"  Suspend (us)          : %ld\n",
+                        NsToUs(Suspend->SuspendEnd - Suspend->SuspendStart));
+        }
+    } else {
+        OutputPrint(L"  No S3 Suspend Record found.\n");
+    }
+}
+
+
+static VOID
+PrintFPDT( EFI_ACPI_DESCRIPTION_HEADER *Fpdt,
+           BOOLEAN Verbose )
+{
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *Fbpt;
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *S3pt;
+    CHAR16 Buffer[50];
+
+    OutputPrint(L"\nFPDT Table Details\n");
+    OutputPrint(L"  Address               : 0x%lx\n", (UINT64)(UINTN)Fpdt);
+    OutputPrint(L"  Length                : %d\n", Fpdt->Length);
+    OutputPrint(L"  Revision              : %d\n", Fpdt->Revision);
+    AsciiToUnicodeSize((CHAR8 *)(Fpdt->OemId), 6, Buffer);
+    OutputPrint(L"  OEM ID                : %s\n", Buffer);
+    AsciiToUnicodeSize((CHAR8 *)&(Fpdt->OemTableId), 8, Buffer);
+    OutputPrint(L"  OEM Table ID          : %s\n", Buffer);
+
+    FindPerformanceTables(Fpdt, &Fbpt, &S3pt);
+    if (Fbpt != NULL) {
+        PrintFBPT(Fbpt, Verbose);
+    } else {
+        OutputPrint(L"\nNo Firmware Basic Boot Performance Table found.\n");
+    }
+    if (S3pt != NULL) {
+        PrintS3PT(S3pt, Verbose);
+    } else {
+        OutputPrint(L"\nNo S3 Performance Table found.\n");
+    }
+    OutputPrint(L"\n");
+}
+
+
+static VOID
+JsonFBPT( EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *Fbpt )
+{
+    EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD *Boot;
+    UINT64 Previous = 0;
+    UINT64 Time;
+
+    JsonObjectBegin(L"basicBoot");
+    JsonHex(L"address", (UINTN)Fbpt);
+    JsonUint(L"length", Fbpt->Length);
+
+    Boot = (EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD *)
+           FindRecord( Fbpt,
+                       EFI_ACPI_5_0_FPDT_RUNTIME_RECORD_TYPE_FIRMWARE_BASIC_BOOT,
+                       sizeof(EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD) );
+    if (Boot == NULL) {
+        JsonString(L"error", L"No Firmware Basic Boot Performance Record found.");
+        JsonObjectEnd();
+        return;
+    }
+
+    // event times are null when the firmware did not record them
+    JsonObjectBegin(L"timelineUs");
+    for (UINTN i = 0; i < BOOT_EVENT_COUNT; i++) {
+        Time = BootEventTime(Boot, i);
+        if (Time == 0 && i > 0) {
+            JsonNull(BootEvents[i].JsonName);
+        } else {
+            JsonUint(BootEvents[i].JsonName, NsToUs(Time));
+        }
+    }
+    JsonObjectEnd();
+
+    JsonObjectBegin(L"phasesUs");
+    for (UINTN i = 0; i < BOOT_EVENT_COUNT; i++) {
+        Time = BootEventTime(Boot, i);
+        if (Time == 0 && i > 0) {
+            continue;
+        }
+        if (Previous != 0 || i == 0) {
+            JsonUint(BootPhasesJson[i], NsToUs(Time - Previous));
+        }
+        Previous = Time;
+    }
+    JsonObjectEnd();
+
+    JsonObjectEnd();
+}
+
+
+static VOID
+JsonS3PT( EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *S3pt )
+{
+    EFI_ACPI_5_0_FPDT_S3_RESUME_RECORD  *Resume;
+    EFI_ACPI_5_0_FPDT_S3_SUSPEND_RECORD *Suspend;
+
+    JsonObjectBegin(L"s3");
+    JsonHex(L"address", (UINTN)S3pt);
+    JsonUint(L"length", S3pt->Length);
+
+    Resume = (EFI_ACPI_5_0_FPDT_S3_RESUME_RECORD *)
+             FindRecord( S3pt,
+                         EFI_ACPI_5_0_FPDT_RUNTIME_RECORD_TYPE_S3_RESUME,
+                         sizeof(EFI_ACPI_5_0_FPDT_S3_RESUME_RECORD) );
+    if (Resume != NULL) {
+        JsonUint(L"resumeCount", Resume->ResumeCount);
+        JsonUint(L"fullResumeUs", NsToUs(Resume->FullResume));
+        JsonUint(L"averageResumeUs", NsToUs(Resume->AverageResume));
+    }
+
+    Suspend = (EFI_ACPI_5_0_FPDT_S3_SUSPEND_RECORD *)
+              FindRecord( S3pt,
+                          EFI_ACPI_5_0_FPDT_RUNTIME_RECORD_TYPE_S3_SUSPEND,
+                          sizeof(EFI_ACPI_5_0_FPDT_S3_SUSPEND_RECORD) );
+    if (Suspend != NULL) {
+        JsonUint(L"suspendStartUs", NsToUs(Suspend->SuspendStart));
+        JsonUint(L"suspendEndUs", NsToUs(Suspend->SuspendEnd));
+    }
+
+    JsonObjectEnd();
+}
+
+
+static VOID
+JsonFPDT( EFI_ACPI_DESCRIPTION_HEADER *Fpdt )
+{
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *Fbpt;
+    EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *S3pt;
+
+    JsonObjectBegin(L"fpdt");
+    JsonHex(L"address", (UINTN)Fpdt);
+    JsonUint(L"length", Fpdt->Length);
+    JsonUint(L"revision", Fpdt->Revision);
+    JsonAsciiString(L"oemId", (CHAR8 *)(Fpdt->OemId), 6);
+    JsonAsciiString(L"oemTableId", (CHAR8 *)&(Fpdt->OemTableId), 8);
+    JsonObjectEnd();
+
+    FindPerformanceTables(Fpdt, &Fbpt, &S3pt);
+    if (Fbpt != NULL) {
+        JsonFBPT(Fbpt);
+    } else {
+        JsonNull(L"basicBoot");
+    }
+    if (S3pt != NULL) {
+        JsonS3PT(S3pt);
+    } else {
+        JsonNull(L"s3");
+    }
+}
+
+
+static void
+Usage( void )
+{
+    OutputPrint(L"Usage: ShowFPDT [-v | --verbose]\n");
+    OutputPrint(L"       ShowFPDT [--json]\n");
+    OutputPrint(L"       ShowFPDT [-V | --version]\n");
+}
+
+
+INTN
+EFIAPI
+ShellAppMain( UINTN Argc,
+              CHAR16 **Argv )
+{
+    EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *Rsdp = NULL;
+    EFI_ACPI_DESCRIPTION_HEADER *Fpdt = NULL;
+    EFI_STATUS Status = EFI_SUCCESS;
+    BOOLEAN Verbose = FALSE;
+    BOOLEAN Json = FALSE;
+
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
+
+    if (Argc == 2) {
+        if (!StrCmp(Argv[1], L"--verbose") ||
+            !StrCmp(Argv[1], L"-v")) {
+            Verbose = TRUE;
+        } else if (!StrCmp(Argv[1], L"--version") ||
+            !StrCmp(Argv[1], L"-V")) {
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
+            return Status;
+        } else if (!StrCmp(Argv[1], L"--help") ||
+            !StrCmp(Argv[1], L"-h")) {
+            Usage();
+            return Status;
+        } else {
+            Usage();
+            return Status;
+        }
+    }
+    if (Argc > 2) {
+        Usage();
+        return Status;
+    }
+
+    if (Json) {
+        JsonDocumentBegin(L"ShowFPDT", UTILITY_VERSION);
+    }
+
+    // look up the FPDT in the shared ACPI table index
+    Rsdp = AcpiIndexRsdp();
+    if (Rsdp != NULL) {
+        Fpdt = AcpiIndexFind(EFI_ACPI_5_0_FIRMWARE_PERFORMANCE_DATA_TABLE_SIGNATURE, 0);
+    }
+
+    if (Rsdp == NULL) {
+        JsonError(L"Could not find an ACPI RSDP table.");
+        Status = EFI_NOT_FOUND;
+    } else if (Fpdt == NULL) {
+        JsonError(L"Could not find an ACPI FPDT table.");
+        Status = EFI_NOT_FOUND;
+    } else if (Json) {
+        JsonFPDT(Fpdt);
+    } else {
+        PrintFPDT(Fpdt, Verbose);
+    }
+
+    if (Json) {
+        JsonDocumentEnd();
+    }
+
+    return Status;
+}
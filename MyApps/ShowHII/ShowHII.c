@@ -16,6 +16,8 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/PrintLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
 
 #include <Protocol/EfiShell.h>
 #include <Protocol/LoadedImage.h>
@@ -67,7 +69,7 @@ DumpHiiPackage( VOID *HiiPackage )
 {
     EFI_HII_PACKAGE_HEADER *HiiPackageHeader = (EFI_HII_PACKAGE_HEADER *) HiiPackage;
 
-    Print(L"      Type: 0x%02x (%s)   Length: 0x%06x (%d)\n", HiiPackageHeader->Type,
+    OutputPrint(L"      Type: 0x%02x (%s)   Length: 0x%06x (%d)\n", HiiPackageHeader->Type,
                                                               HiiPackageTypeToString(HiiPackageHeader->Type),  
                                                               HiiPackageHeader->Length,
                                                               HiiPackageHeader->Length);
@@ -85,9 +87,9 @@ DumpHiiDatabase( VOID    *HiiDatabase,
     UINT16 HiiPackageCount = 0;
 
     if (Terse)
-        Print(L"\n");
+        OutputPrint(L"\n");
     else
-        Print(L"\nHII Database Size: 0x%x (%d)\n\n", HiiDatabaseSize, HiiDatabaseSize);
+        OutputPrint(L"\nHII Database Size: 0x%x (%d)\n\n", HiiDatabaseSize, HiiDatabaseSize);
 
     HiiPackageListHeader = (EFI_HII_PACKAGE_LIST_HEADER *) HiiDatabase;
 
@@ -97,7 +99,7 @@ DumpHiiDatabase( VOID    *HiiDatabase,
            break;
         HiiPackageCount++;
         UnicodeSPrint(GuidStr, sizeof(GuidStr), L"%g", &(HiiPackageListHeader->PackageListGuid));
-        Print(L"%02d  GUID: %s   Length: 0x%06x (%d)\n", HiiPackageCount, GuidStr, HiiPackageSize, HiiPackageSize);
+        OutputPrint(L"%02d  GUID: %s   Length: 0x%06x (%d)\n", HiiPackageCount, GuidStr, HiiPackageSize, HiiPackageSize);
         HiiPackageHeader = (EFI_HII_PACKAGE_HEADER *)(HiiPackageListHeader + 1);
         if (!Terse) {
             while ((UINTN) HiiPackageHeader < (UINTN) (HiiPackageListHeader + HiiPackageListHeader->PackageLength)) {
@@ -112,15 +114,62 @@ DumpHiiDatabase( VOID    *HiiDatabase,
 }
 
 
+VOID
+JsonHiiDatabase( VOID    *HiiDatabase,
+                 UINTN   HiiDatabaseSize,
+                 BOOLEAN Terse )
+{
+    EFI_HII_PACKAGE_LIST_HEADER *HiiPackageListHeader;
+    EFI_HII_PACKAGE_HEADER      *HiiPackageHeader;
+    UINTN                       HiiPackageListEnd;
+
+    JsonUint(L"databaseSize", HiiDatabaseSize);
+    JsonArrayBegin(L"packageLists");
+
+    HiiPackageListHeader = (EFI_HII_PACKAGE_LIST_HEADER *) HiiDatabase;
+    while ((UINTN) HiiPackageListHeader < ((UINTN) HiiDatabase + HiiDatabaseSize)) {
+        UINTN HiiPackageSize = HiiPackageListHeader->PackageLength;
+        if (HiiPackageSize == 0)
+           break;
+
+        JsonObjectBegin(NULL);
+        JsonGuid(L"guid", &(HiiPackageListHeader->PackageListGuid));
+        JsonUint(L"length", HiiPackageSize);
+        if (!Terse) {
+            JsonArrayBegin(L"packages");
+            HiiPackageListEnd = (UINTN) HiiPackageListHeader + HiiPackageSize;
+            HiiPackageHeader = (EFI_HII_PACKAGE_HEADER *)(HiiPackageListHeader + 1);
+            while ((UINTN) HiiPackageHeader < HiiPackageListEnd) {
+                JsonObjectBegin(NULL);
+                JsonHex(L"type", HiiPackageHeader->Type);
+                JsonString(L"typeName", HiiPackageTypeToString(HiiPackageHeader->Type));
+                JsonUint(L"length", HiiPackageHeader->Length);
+                JsonObjectEnd();
+                if (HiiPackageHeader->Type == EFI_HII_PACKAGE_END || HiiPackageHeader->Length == 0)
+                   break;
+                HiiPackageHeader = (EFI_HII_PACKAGE_HEADER *) ((UINTN) HiiPackageHeader + HiiPackageHeader->Length);
+            }
+            JsonArrayEnd();
+        }
+        JsonObjectEnd();
+
+        HiiPackageListHeader = (EFI_HII_PACKAGE_LIST_HEADER *) ((UINTN) HiiPackageListHeader + HiiPackageSize);
+    }
+
+    JsonArrayEnd();
+}
+
+
 VOID
 Usage( CHAR16 *Str,
        BOOLEAN ErrorMsg )
 {
     if ( ErrorMsg ) {
-        Print(L"ERROR: Unknown option.\n");
+        OutputPrint(L"ERROR: Unknown option.\n");
     }
-    Print(L"Usage: %s [-V | --version]\n", Str);
-    Print(L"       %s [-t | --terse]\n", Str);
+    OutputPrint(L"Usage: %s [-V | --version]\n", Str);
+    OutputPrint(L"       %s [-t | --terse]\n", Str);
+    OutputPrint(L"       %s [-t | --terse] --json\n", Str);
 }
 
 
@@ -134,11 +183,15 @@ ShellAppMain( UINTN Argc,
     UINTN PackageListSize = 0;
     EFI_HII_PACKAGE_LIST_HEADER *PackageList = NULL;
     BOOLEAN Terse = FALSE;
+    BOOLEAN Json = FALSE;
+
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
 
     if (Argc == 2) {
         if (!StrCmp(Argv[1], L"--version") ||
             !StrCmp(Argv[1], L"-V")) {
-            Print(L"Version: %s\n", UTILITY_VERSION);
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
             return Status;
         } else if (!StrCmp(Argv[1], L"--help") ||
             !StrCmp(Argv[1], L"-h")) {
@@ -158,11 +211,15 @@ ShellAppMain( UINTN Argc,
     }
 
 
+    if (Json) {
+        JsonDocumentBegin(L"ShowHII", UTILITY_VERSION);
+    }
+
     Status = gBS->LocateProtocol( &gEfiHiiDatabaseProtocolGuid, 
                                   NULL, 
                                   (VOID **) &HiiDbProtocol );
     if (EFI_ERROR(Status)) {
-        Print(L"ERROR: Could not find HII Database protocol\n");
+        JsonError(L"Could not find HII Database protocol");
         return Status;
     }
 
@@ -172,7 +229,7 @@ ShellAppMain( UINTN Argc,
                                                 &PackageListSize,
                                                 PackageList );
     if (Status != EFI_BUFFER_TOO_SMALL) {
-        Print(L"ERROR: Could not obtain package list size\n");
+        JsonError(L"Could not obtain package list size");
         return Status;
     }
 
@@ -180,7 +237,7 @@ ShellAppMain( UINTN Argc,
                                 PackageListSize, 
                                 (VOID **) &PackageList );
     if (EFI_ERROR(Status)) {
-        Print(L"ERROR: Could not allocate sufficient memory for package list\n");
+        JsonError(L"Could not allocate sufficient memory for package list");
         return Status;
     }
 
@@ -189,7 +246,14 @@ ShellAppMain( UINTN Argc,
                                                 &PackageListSize,
                                                 PackageList );
     if (EFI_ERROR(Status)) {
-        Print(L"ERROR: Could not retrieve the package list\n");
+        JsonError(L"Could not retrieve the package list");
+        FreePool(PackageList);
+        return Status;
+    }
+
+    if (Json) {
+        JsonHiiDatabase( PackageList, PackageListSize, Terse );
+        JsonDocumentEnd();
         FreePool(PackageList);
         return Status;
     }
@@ -198,7 +262,7 @@ ShellAppMain( UINTN Argc,
 
     FreePool(PackageList);
 
-    Print(L"\n");
+    OutputPrint(L"\n");
 
     return Status;
 }
@@ -0,0 +1,1053 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Show NUMA topology from the ACPI SRAT, SLIT and HMAT: processors and
+//  memory per proximity domain, the SLIT distance matrix and the HMAT
+//  latency, bandwidth and memory side cache figures.  Warns about
+//  missing or asymmetric entries.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/UefiLib.h>
+#include <Library/ShellCEntryLib.h>
+#include <Library/ShellLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/PrintLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/AcpiTableIndexLib.h>
+
+#include <Protocol/EfiShell.h>
+#include <Protocol/LoadedImage.h>
+#include <Protocol/AcpiSystemDescriptionTable.h>
+
+#define UTILITY_VERSION L"20181022"
+#undef DEBUG
+
+#define SRAT_SIGNATURE  SIGNATURE_32('S','R','A','T')
+#define SLIT_SIGNATURE  SIGNATURE_32('S','L','I','T')
+#define HMAT_SIGNATURE  SIGNATURE_32('H','M','A','T')
+
+#define MAX_NODES       64          // proximity domains tracked
+#define MAX_WARNINGS    32
+#define WARNING_SIZE    128
+
+// SLIT distances
+#define SLIT_LOCAL        10
+#define SLIT_UNREACHABLE  0xff
+
+// SRAT structure types
+#define SRAT_PROCESSOR_APIC     0
+#define SRAT_MEMORY             1
+#define SRAT_PROCESSOR_X2APIC   2
+#define SRAT_GICC               3
+
+#define SRAT_ENABLED            BIT0
+#define SRAT_MEMORY_HOTPLUG     BIT1
+#define SRAT_MEMORY_NONVOLATILE BIT2
+
+// HMAT structure types
+#define HMAT_PROXIMITY_DOMAIN   0
+#define HMAT_LATENCY_BANDWIDTH  1
+#define HMAT_MEMORY_CACHE       2
+
+#define HMAT_INITIATOR_VALID    BIT0
+#define HMAT_NO_ENTRY           0
+#define HMAT_UNREACHABLE        0xffff
+
+
+#pragma pack(1)
+typedef struct {
+    EFI_ACPI_SDT_HEADER Header;
+    UINT32  Reserved1;
+    UINT64  Reserved2;
+} SRAT_HEADER;
+
+typedef struct {
+    UINT8   Type;
+    UINT8   Length;
+} SRAT_STRUCTURE;
+
+typedef struct {
+    UINT8   Type;
+    UINT8   Length;
+    UINT8   ProximityDomain7To0;
+    UINT8   ApicId;
+    UINT32  Flags;
+    UINT8   LocalSapicEid;
+    UINT8   ProximityDomain31To8[3];
+    UINT32  ClockDomain;
+} SRAT_PROCESSOR_APIC_AFFINITY;
+
+typedef struct {
+    UINT8   Type;
+    UINT8   Length;
+    UINT32  ProximityDomain;
+    UINT16  Reserved1;
+    UINT64  Base;
+    UINT64  Size;
+    UINT32  Reserved2;
+    UINT32  Flags;
+    UINT64  Reserved3;
+} SRAT_MEMORY_AFFINITY;
+
+typedef struct {
+    UINT8   Type;
+    UINT8   Length;
+    UINT16  Reserved1;
+    UINT32  ProximityDomain;
+    UINT32  X2ApicId;
+    UINT32  Flags;
+    UINT32  ClockDomain;
+    UINT32  Reserved2;
+} SRAT_PROCESSOR_X2APIC_AFFINITY;
+
+typedef struct {
+    UINT8   Type;
+    UINT8   Length;
+    UINT32  ProximityDomain;
+    UINT32  AcpiProcessorUid;
+    UINT32  Flags;
+    UINT32  ClockDomain;
+} SRAT_GICC_AFFINITY;
+
+typedef struct {
+    EFI_ACPI_SDT_HEADER Header;
+    UINT64  Localities;
+    // UINT8 Entry[Localities][Localities];
+} SLIT_HEADER;
+
+typedef struct {
+    EFI_ACPI_SDT_HEADER Header;
+    UINT32  Reserved;
+} HMAT_HEADER;
+
+typedef struct {
+    UINT16  Type;
+    UINT16  Reserved;
+    UINT32  Length;
+} HMAT_STRUCTURE;
+
+// type 0; ACPI 6.2 called it the memory subsystem address range
+typedef struct {
+    UINT16  Type;
+    UINT16  Reserved1;
+    UINT32  Length;
+    UINT16  Flags;
+    UINT16  Reserved2;
+    UINT32  InitiatorDomain;
+    UINT32  MemoryDomain;
+    UINT32  Reserved3;
+    UINT64  Reserved4;
+    UINT64  Reserved5;
+} HMAT_PROXIMITY_DOMAIN_ATTRIBUTES;
+
+typedef struct {
+    UINT16  Type;
+    UINT16  Reserved1;
+    UINT32  Length;
+    UINT8   Flags;
+    UINT8   DataType;
+    UINT16  Reserved2;
+    UINT32  Initiators;
+    UINT32  Targets;
+    UINT32  Reserved3;
+    UINT64  EntryBaseUnit;
+    // UINT32 InitiatorDomain[Initiators];
+    // UINT32 TargetDomain[Targets];
+    // UINT16 Entry[Initiators][Targets];
+} HMAT_LATENCY_BANDWIDTH_INFO;
+
+typedef struct {
+    UINT16  Type;
+    UINT16  Reserved1;
+    UINT32  Length;
+    UINT32  MemoryDomain;
+    UINT32  Reserved2;
+    UINT64  CacheSize;
+    UINT32  CacheAttributes;
+    UINT16  Reserved3;
+    UINT16  SmbiosHandles;
+} HMAT_MEMORY_CACHE_INFO;
+#pragma pack()
+
+
+typedef struct {
+    UINT32  Domain;
+    UINTN   Processors;
+    UINTN   Ranges;
+    UINT64  Memory;
+    UINT64  HotPlugMemory;
+    UINT64  NonVolatileMemory;
+} NUMA_NODE;
+
+STATIC NUMA_NODE Nodes[MAX_NODES];
+STATIC UINTN     NodeCount;
+STATIC UINTN     DroppedDomains;
+
+STATIC CHAR16    Warnings[MAX_WARNINGS][WARNING_SIZE];
+STATIC UINTN     WarningCount;
+
+// HMAT latency/bandwidth data types
+STATIC CHAR16 *HmatDataTypes[] = {
+    L"Access Latency",
+    L"Read Latency",
+    L"Write Latency",
+    L"Access Bandwidth",
+    L"Read Bandwidth",
+    L"Write Bandwidth"
+};
+
+STATIC CHAR16 *HmatDataTypesJson[] = {
+    L"accessLatency",
+    L"readLatency",
+    L"writeLatency",
+    L"accessBandwidth",
+    L"readBandwidth",
+    L"writeBandwidth"
+};
+
+#define HMAT_IS_LATENCY(DataType)  ((DataType) < 3)
+
+
+//
+// Collect a warning for the end of the report
+//
+static VOID
+Warn( CONST CHAR16 *Format,
+      ... )
+{
+    VA_LIST Marker;
+
+    if (WarningCount == MAX_WARNINGS) {
+        return;
+    }
+
+    VA_START(Marker, Format);
+    UnicodeVSPrint(Warnings[WarningCount++], sizeof(Warnings[0]), Format, Marker);
+    VA_END(Marker);
+}
+
+
+static NUMA_NODE *
+FindNode( UINT32 Domain,
+          BOOLEAN Add )
+{
+    for (UINTN i = 0; i < NodeCount; i++) {
+        if (Nodes[i].Domain == Domain) {
+            return &Nodes[i];
+        }
+    }
+    if (!Add) {
+        return NULL;
+    }
+    if (NodeCount == MAX_NODES) {
+        DroppedDomains++;
+        return NULL;
+    }
+
+    ZeroMem(&Nodes[NodeCount], sizeof(NUMA_NODE));
+    Nodes[NodeCount].Domain = Domain;
+    return &Nodes[NodeCount++];
+}
+
+
+//
+// Affinity structures follow the SRAT header; stop at the first one
+// with an impossible length
+//
+static SRAT_STRUCTURE *
+NextAffinity( EFI_ACPI_DESCRIPTION_HEADER *Srat,
+              SRAT_STRUCTURE *Entry )
+{
+    UINT8 *Ptr;
+    UINT8 *End = (UINT8 *)Srat + Srat->Length;
+
+    if (Entry == NULL) {
+        Ptr = (UINT8 *)Srat + sizeof(SRAT_HEADER);
+    } else {
+        Ptr = (UINT8 *)Entry + Entry->Length;
+    }
+
+    if (Ptr + sizeof(SRAT_STRUCTURE) > End) {
+        return NULL;
+    }
+    Entry = (SRAT_STRUCTURE *)Ptr;
+    if (Entry->Length < sizeof(SRAT_STRUCTURE) || Ptr + Entry->Length > End) {
+        return NULL;
+    }
+
+    return Entry;
+}
+
+
+//
+// SRAT revision 1 (ACPI 2.0) proximity domains are one byte; the bytes
+// above it were reserved and may hold anything
+//
+static UINT32
+SratDomain( EFI_ACPI_DESCRIPTION_HEADER *Srat,
+            UINT32 Domain )
+{
+    if (Srat->Revision < 2) {
+        return Domain & 0xff;
+    }
+
+    return Domain;
+}
+
+
+//
+// Proximity domain, processor ID and enabled flag of a processor
+// affinity structure.  FALSE for anything else.
+//
+static BOOLEAN
+ProcessorAffinity( EFI_ACPI_DESCRIPTION_HEADER *Srat,
+                   SRAT_STRUCTURE *Entry,
+                   UINT32 *Domain,
+                   UINT32 *Id,
+                   BOOLEAN *Enabled )
+{
+    SRAT_PROCESSOR_APIC_AFFINITY *Apic;
+    SRAT_PROCESSOR_X2APIC_AFFINITY *X2Apic;
+    SRAT_GICC_AFFINITY *Gicc;
+
+    switch (Entry->Type) {
+        case SRAT_PROCESSOR_APIC:
+            if (Entry->Length < sizeof(SRAT_PROCESSOR_APIC_AFFINITY)) {
+                return FALSE;
+            }
+            Apic = (SRAT_PROCESSOR_APIC_AFFINITY *)Entry;
+            *Domain = SratDomain(Srat, Apic->ProximityDomain7To0 |
+                                       (Apic->ProximityDomain31To8[0] << 8) |
+                                       (Apic->ProximityDomain31To8[1] << 16) |
+                                       ((UINT32)Apic->ProximityDomain31To8[2] << 24));
+            *Id = Apic->ApicId;
+            *Enabled = (Apic->Flags & SRAT_ENABLED) != 0;
+            return TRUE;
+        case SRAT_PROCESSOR_X2APIC:
+            if (Entry->Length < sizeof(SRAT_PROCESSOR_X2APIC_AFFINITY)) {
+                return FALSE;
+            }
+            X2Apic = (SRAT_PROCESSOR_X2APIC_AFFINITY *)Entry;
+            *Domain = X2Apic->ProximityDomain;
+            *Id = X2Apic->X2ApicId;
+            *Enabled = (X2Apic->Flags & SRAT_ENABLED) != 0;
+            return TRUE;
+        case SRAT_GICC:
+            if (Entry->Length < sizeof(SRAT_GICC_AFFINITY)) {
+                return FALSE;
+            }
+            Gicc = (SRAT_GICC_AFFINITY *)Entry;
+            *Domain = Gicc->ProximityDomain;
+            *Id = Gicc->AcpiProcessorUid;
+            *Enabled = (Gicc->Flags & SRAT_ENABLED) != 0;
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+
+static SRAT_MEMORY_AFFINITY *
+MemoryAffinity( SRAT_STRUCTURE *Entry )
+{
+    if (Entry->Type != SRAT_MEMORY || Entry->Length < sizeof(SRAT_MEMORY_AFFINITY)) {
+        return NULL;
+    }
+
+    return (SRAT_MEMORY_AFFINITY *)Entry;
+}
+
+
+//
+// Build the per-domain totals.  Disabled structures are placeholders
+// the OS ignores, so they are not counted.
+//
+static VOID
+CollectNodes( EFI_ACPI_DESCRIPTION_HEADER *Srat )
+{
+    SRAT_STRUCTURE *Entry = NULL;
+    SRAT_MEMORY_AFFINITY *Memory;
+    NUMA_NODE *Node;
+    UINT32 Domain;
+    UINT32 Id;
+    BOOLEAN Enabled;
+
+    while ((Entry = NextAffinity(Srat, Entry)) != NULL) {
+        if (ProcessorAffinity(Srat, Entry, &Domain, &Id, &Enabled)) {
+            if (Enabled && (Node = FindNode(Domain, TRUE)) != NULL) {
+                Node->Processors++;
+            }
+        } else if ((Memory = MemoryAffinity(Entry)) != NULL) {
+            if ((Memory->Flags & SRAT_ENABLED) && (Node = FindNode(SratDomain(Srat, Memory->ProximityDomain), TRUE)) != NULL) {
+                Node->Ranges++;
+                Node->Memory += Memory->Size;
+                if (Memory->Flags & SRAT_MEMORY_HOTPLUG) {
+                    Node->HotPlugMemory += Memory->Size;
+                }
+                if (Memory->Flags & SRAT_MEMORY_NONVOLATILE) {
+                    Node->NonVolatileMemory += Memory->Size;
+                }
+            }
+        }
+    }
+}
+
+
+static UINT8
+SlitDistance( SLIT_HEADER *Slit,
+              UINT64 From,
+              UINT64 To )
+{
+    return ((UINT8 *)(Slit + 1))[From * Slit->Localities + To];
+}
+
+
+//
+// Returns NULL if the SLIT is too short for its own locality count
+//
+static SLIT_HEADER *
+CheckSlit( EFI_ACPI_DESCRIPTION_HEADER *Table )
+{
+    SLIT_HEADER *Slit = (SLIT_HEADER *)Table;
+
+    if (Table->Length < sizeof(SLIT_HEADER) ||
+        Slit->Localities > 0xffff ||
+        Table->Length < sizeof(SLIT_HEADER) + Slit->Localities * Slit->Localities) {
+        return NULL;
+    }
+
+    return Slit;
+}
+
+
+static HMAT_STRUCTURE *
+NextHmat( EFI_ACPI_DESCRIPTION_HEADER *Hmat,
+          HMAT_STRUCTURE *Entry )
+{
+    UINT8 *Ptr;
+    UINT8 *End = (UINT8 *)Hmat + Hmat->Length;
+
+    if (Entry == NULL) {
+        Ptr = (UINT8 *)Hmat + sizeof(HMAT_HEADER);
+    } else {
+        Ptr = (UINT8 *)Entry + Entry->Length;
+    }
+
+    if (Ptr + sizeof(HMAT_STRUCTURE) > End) {
+        return NULL;
+    }
+    Entry = (HMAT_STRUCTURE *)Ptr;
+    if (Entry->Length < sizeof(HMAT_STRUCTURE) || Entry->Length > (UINTN)(End - Ptr)) {
+        return NULL;
+    }
+
+    return Entry;
+}
+
+
+//
+// A latency/bandwidth structure whose domain lists and matrix fit in
+// its length, or NULL
+//
+static HMAT_LATENCY_BANDWIDTH_INFO *
+LatencyInfo( HMAT_STRUCTURE *Entry )
+{
+    HMAT_LATENCY_BANDWIDTH_INFO *Info = (HMAT_LATENCY_BANDWIDTH_INFO *)Entry;
+    UINT64 Needed;
+
+    if (Entry->Type != HMAT_LATENCY_BANDWIDTH || Entry->Length < sizeof(HMAT_LATENCY_BANDWIDTH_INFO)) {
+        return NULL;
+    }
+    if (Info->Initiators > MAX_NODES || Info->Targets > MAX_NODES ||
+        (Info->DataType & 0x0f) >= ARRAY_SIZE(HmatDataTypes)) {
+        return NULL;
+    }
+    Needed = sizeof(HMAT_LATENCY_BANDWIDTH_INFO) + 4 * (Info->Initiators + Info->Targets) +
+             2 * Info->Initiators * Info->Targets;
+    if (Entry->Length < Needed) {
+        return NULL;
+    }
+
+    return Info;
+}
+
+
+static UINT32 *
+InitiatorDomains( HMAT_LATENCY_BANDWIDTH_INFO *Info )
+{
+    return (UINT32 *)(Info + 1);
+}
+
+
+static UINT32 *
+TargetDomains( HMAT_LATENCY_BANDWIDTH_INFO *Info )
+{
+    return InitiatorDomains(Info) + Info->Initiators;
+}
+
+
+static UINT16
+HmatEntry( HMAT_LATENCY_BANDWIDTH_INFO *Info,
+           UINTN Initiator,
+           UINTN Target )
+{
+    UINT16 *Entries = (UINT16 *)(TargetDomains(Info) + Info->Targets);
+
+    return Entries[Initiator * Info->Targets + Target];
+}
+
+
+//
+// Position of Domain in an HMAT domain list, or Count if it is not there
+//
+static UINTN
+DomainIndex( UINT32 *List,
+             UINTN Count,
+             UINT32 Domain )
+{
+    UINTN i;
+
+    for (i = 0; i < Count && List[i] != Domain; i++) {
+        ;
+    }
+
+    return i;
+}
+
+
+//
+// Latency in picoseconds, bandwidth in MB/s
+//
+static UINT64
+HmatValue( HMAT_LATENCY_BANDWIDTH_INFO *Info,
+           UINT16 Entry )
+{
+    return MultU64x32(Info->EntryBaseUnit, Entry);
+}
+
+
+//
+// Things that make the OS place memory badly: nodes with processors
+// but no memory (or the reverse), domains the SLIT or HMAT do not
+// describe, and distances or latencies that differ by direction
+//
+static VOID
+CheckTopology( EFI_ACPI_DESCRIPTION_HEADER *Srat,
+               SLIT_HEADER *Slit,
+               EFI_ACPI_DESCRIPTION_HEADER *Hmat )
+{
+    HMAT_LATENCY_BANDWIDTH_INFO *Info;
+    HMAT_STRUCTURE *Entry = NULL;
+    UINT32 *Initiators;
+    UINT32 *Targets;
+    CHAR16 *Name;
+    BOOLEAN Asymmetric;
+    UINTN Missing;
+    UINTN i, j, k, t;
+    UINT16 Value;
+    UINT8 Forward;
+    UINT8 Back;
+
+    if (Srat == NULL) {
+        Warn(L"No SRAT; the OS will treat the system as a single node");
+        return;
+    }
+    if (DroppedDomains > 0) {
+        Warn(L"%d proximity domains beyond the first %d were not checked", DroppedDomains, MAX_NODES);
+    }
+
+    for (i = 0; i < NodeCount; i++) {
+        if (Nodes[i].Processors > 0 && Nodes[i].Memory == 0) {
+            Warn(L"Domain %d has processors but no memory; all its allocations will be remote", Nodes[i].Domain);
+        }
+        if (Nodes[i].Processors == 0 && Nodes[i].Memory > 0) {
+            Warn(L"Domain %d has memory but no processors", Nodes[i].Domain);
+        }
+    }
+
+    if (Slit == NULL) {
+        if (NodeCount > 1) {
+            Warn(L"No valid SLIT; the OS will assume all %d domains are equally distant", NodeCount);
+        }
+    } else {
+        for (i = 0; i < NodeCount; i++) {
+            if (Nodes[i].Domain >= Slit->Localities) {
+                Warn(L"Domain %d has no SLIT row (%ld localities)", Nodes[i].Domain, Slit->Localities);
+            }
+        }
+        for (i = 0; i < Slit->Localities; i++) {
+            if (SlitDistance(Slit, i, i) != SLIT_LOCAL) {
+                Warn(L"SLIT distance %d->%d is %d, not %d", i, i, SlitDistance(Slit, i, i), SLIT_LOCAL);
+            }
+            for (j = i + 1; j < Slit->Localities; j++) {
+                Forward = SlitDistance(Slit, i, j);
+                Back = SlitDistance(Slit, j, i);
+                if (Forward != Back) {
+                    Warn(L"SLIT is asymmetric: %d->%d is %d but %d->%d is %d", i, j, Forward, j, i, Back);
+                }
+                if (Forward <= SLIT_LOCAL || Back <= SLIT_LOCAL) {
+                    Warn(L"SLIT distance between %d and %d is not greater than local", i, j);
+                }
+                if ((Forward == SLIT_UNREACHABLE || Back == SLIT_UNREACHABLE) &&
+                    FindNode((UINT32)i, FALSE) != NULL && FindNode((UINT32)j, FALSE) != NULL) {
+                    Warn(L"SLIT marks domains %d and %d unreachable from each other", i, j);
+                }
+            }
+        }
+    }
+
+    if (Hmat == NULL) {
+        return;
+    }
+    while ((Entry = NextHmat(Hmat, Entry)) != NULL) {
+        if ((Info = LatencyInfo(Entry)) == NULL) {
+            continue;
+        }
+        Name = HmatDataTypes[Info->DataType & 0x0f];
+        Initiators = InitiatorDomains(Info);
+        Targets = TargetDomains(Info);
+
+        for (i = 0; i < Info->Targets; i++) {
+            if (FindNode(Targets[i], FALSE) == NULL) {
+                Warn(L"HMAT %s target domain %d is not in the SRAT", Name, Targets[i]);
+            }
+        }
+        for (i = 0; i < NodeCount; i++) {
+            if (Nodes[i].Memory > 0 && DomainIndex(Targets, Info->Targets, Nodes[i].Domain) == Info->Targets) {
+                Warn(L"HMAT %s has no entries for memory domain %d", Name, Nodes[i].Domain);
+            }
+        }
+
+        Missing = 0;
+        Asymmetric = FALSE;
+        for (i = 0; i < Info->Initiators; i++) {
+            for (j = 0; j < Info->Targets; j++) {
+                Value = HmatEntry(Info, i, j);
+                if (Value == HMAT_NO_ENTRY) {
+                    Missing++;
+                    continue;
+                }
+                // compare i->j with j->i where both domains are initiators and targets
+                if (Asymmetric || Initiators[i] >= Targets[j]) {
+                    continue;
+                }
+                k = DomainIndex(Initiators, Info->Initiators, Targets[j]);
+                t = DomainIndex(Targets, Info->Targets, Initiators[i]);
+                if (k < Info->Initiators && t < Info->Targets && HmatEntry(Info, k, t) != Value) {
+                    Warn(L"HMAT %s is asymmetric between domains %d and %d", Name, Initiators[i], Targets[j]);
+                    Asymmetric = TRUE;
+                }
+            }
+        }
+        if (Missing > 0) {
+            Warn(L"HMAT %s has %d missing entries", Name, Missing);
+        }
+    }
+}
+
+
+static VOID
+PrintNodes( EFI_ACPI_DESCRIPTION_HEADER *Srat,
+            BOOLEAN Verbose )
+{
+    SRAT_STRUCTURE *Entry = NULL;
+    SRAT_MEMORY_AFFINITY *Memory;
+    UINT32 Domain;
+    UINT32 Id;
+    BOOLEAN Enabled;
+
+    OutputPrint(L"\nDomain  Processors  Memory (MB)  Ranges  Hot-plug (MB)  NV (MB)\n");
+    for (UINTN i = 0; i < NodeCount; i++) {
+        OutputPrint(L"  %4d  %10d  %11ld  %6d  %13ld  %7ld\n", Nodes[i].Domain, Nodes[i].Processors,
+                    RShiftU64(Nodes[i].Memory, 20), Nodes[i].Ranges,
+                    RShiftU64(Nodes[i].HotPlugMemory, 20), RShiftU64(Nodes[i].NonVolatileMemory, 20));
+    }
+
+    if (!Verbose) {
+        return;
+    }
+
+    OutputPrint(L"\nAffinity Structures\n");
+    while ((Entry = NextAffinity(Srat, Entry)) != NULL) {
+        if (ProcessorAffinity(Srat, Entry, &Domain, &Id, &Enabled)) {
+            OutputPrint(L"  Domain %4d  %-6s 0x%08x%s\n", Domain,
+                        Entry->Type == SRAT_GICC ? L"UID" : (Entry->Type == SRAT_PROCESSOR_X2APIC ? L"x2APIC" : L"APIC"),
+                        Id, Enabled ? L"" : L"  (disabled)");
+        } else if ((Memory = MemoryAffinity(Entry)) != NULL) {
+            OutputPrint(L"  Domain %4d  Memory 0x%016lx-0x%016lx%s%s%s\n", SratDomain(Srat, Memory->ProximityDomain),
+                        Memory->Base, Memory->Base + Memory->Size - 1,
+                        (Memory->Flags & SRAT_MEMORY_HOTPLUG) ? L"  hot-plug" : L"",
+                        (Memory->Flags & SRAT_MEMORY_NONVOLATILE) ? L"  non-volatile" : L"",
+                        (Memory->Flags & SRAT_ENABLED) ? L"" : L"  (disabled)");
+        }
+    }
+}
+
+
+static VOID
+PrintSlit( SLIT_HEADER *Slit )
+{
+    OutputPrint(L"\nSLIT Distances (%ld localities)\n      ", Slit->Localities);
+    for (UINT64 j = 0; j < Slit->Localities; j++) {
+        OutputPrint(L" %4ld", j);
+    }
+    OutputPrint(L"\n");
+    for (UINT64 i = 0; i < Slit->Localities; i++) {
+        OutputPrint(L"  %4ld", i);
+        for (UINT64 j = 0; j < Slit->Localities; j++) {
+            OutputPrint(L" %4d", SlitDistance(Slit, i, j));
+        }
+        OutputPrint(L"\n");
+    }
+}
+
+
+static VOID
+PrintHmat( EFI_ACPI_DESCRIPTION_HEADER *Hmat )
+{
+    HMAT_PROXIMITY_DOMAIN_ATTRIBUTES *Attributes;
+    HMAT_LATENCY_BANDWIDTH_INFO *Info;
+    HMAT_MEMORY_CACHE_INFO *Cache;
+    HMAT_STRUCTURE *Entry = NULL;
+    UINT16 Value;
+
+    while ((Entry = NextHmat(Hmat, Entry)) != NULL) {
+        if (Entry->Type == HMAT_PROXIMITY_DOMAIN && Entry->Length >= sizeof(HMAT_PROXIMITY_DOMAIN_ATTRIBUTES)) {
+            Attributes = (HMAT_PROXIMITY_DOMAIN_ATTRIBUTES *)Entry;
+            if (Attributes->Flags & HMAT_INITIATOR_VALID) {
+                OutputPrint(L"\nHMAT: memory domain %d is attached to initiator domain %d\n",
+                            Attributes->MemoryDomain, Attributes->InitiatorDomain);
+            }
+        } else if ((Info = LatencyInfo(Entry)) != NULL) {
+            OutputPrint(L"\nHMAT %s (%s), initiators down, targets across\n      ",
+                        HmatDataTypes[Info->DataType & 0x0f],
+                        HMAT_IS_LATENCY(Info->DataType & 0x0f) ? L"ps" : L"MB/s");
+            for (UINTN j = 0; j < Info->Targets; j++) {
+                OutputPrint(L" %7d", TargetDomains(Info)[j]);
+            }
+            OutputPrint(L"\n");
+            for (UINTN i = 0; i < Info->Initiators; i++) {
+                OutputPrint(L"  %4d", InitiatorDomains(Info)[i]);
+                for (UINTN j = 0; j < Info->Targets; j++) {
+                    Value = HmatEntry(Info, i, j);
+                    if (Value == HMAT_NO_ENTRY) {
+                        OutputPrint(L"       -");
+                    } else if (Value == HMAT_UNREACHABLE) {
+                        OutputPrint(L"    none");
+                    } else {
+                        OutputPrint(L" %7ld", HmatValue(Info, Value));
+                    }
+                }
+                OutputPrint(L"\n");
+            }
+        } else if (Entry->Type == HMAT_MEMORY_CACHE && Entry->Length >= sizeof(HMAT_MEMORY_CACHE_INFO)) {
+            Cache = (HMAT_MEMORY_CACHE_INFO *)Entry;
+            OutputPrint(L"\nHMAT: memory domain %d has a %ld MB level %d memory side cache, %d byte lines\n",
+                        Cache->MemoryDomain, RShiftU64(Cache->CacheSize, 20),
+                        (Cache->CacheAttributes >> 4) & 0x0f, Cache->CacheAttributes >> 16);
+        }
+    }
+}
+
+
+static VOID
+PrintNUMA( EFI_ACPI_DESCRIPTION_HEADER *Srat,
+           SLIT_HEADER *Slit,
+           EFI_ACPI_DESCRIPTION_HEADER *Hmat,
+           BOOLEAN Verbose )
+{
+    if (Srat != NULL) {
+        PrintNodes(Srat, Verbose);
+    }
+    if (Slit != NULL) {
+        PrintSlit(Slit);
+    }
+    if (Hmat != NULL) {
+        PrintHmat(Hmat);
+    }
+
+    OutputPrint(L"\n");
+    for (UINTN i = 0; i < WarningCount; i++) {
+        OutputPrint(L"WARNING: %s\n", Warnings[i]);
+    }
+    if (WarningCount == 0) {
+        OutputPrint(L"No missing or asymmetric NUMA entries found.\n");
+    }
+}
+
+
+static VOID
+JsonNodes( EFI_ACPI_DESCRIPTION_HEADER *Srat )
+{
+    SRAT_STRUCTURE *Entry = NULL;
+    SRAT_MEMORY_AFFINITY *Memory;
+    UINT32 Domain;
+    UINT32 Id;
+    BOOLEAN Enabled;
+
+    JsonArrayBegin(L"nodes");
+    for (UINTN i = 0; i < NodeCount; i++) {
+        JsonObjectBegin(NULL);
+        JsonUint(L"domain", Nodes[i].Domain);
+        JsonUint(L"processors", Nodes[i].Processors);
+        JsonUint(L"memoryBytes", Nodes[i].Memory);
+        JsonUint(L"memoryRanges", Nodes[i].Ranges);
+        JsonUint(L"hotPlugBytes", Nodes[i].HotPlugMemory);
+        JsonUint(L"nonVolatileBytes", Nodes[i].NonVolatileMemory);
+        JsonObjectEnd();
+    }
+    JsonArrayEnd();
+
+    JsonArrayBegin(L"processors");
+    while ((Entry = NextAffinity(Srat, Entry)) != NULL) {
+        if (ProcessorAffinity(Srat, Entry, &Domain, &Id, &Enabled)) {
+            JsonObjectBegin(NULL);
+            JsonUint(L"domain", Domain);
+            JsonString(L"idType", Entry->Type == SRAT_GICC ? L"uid" : (Entry->Type == SRAT_PROCESSOR_X2APIC ? L"x2apic" : L"apic"));
+            JsonUint(L"id", Id);
+            JsonBool(L"enabled", Enabled);
+            JsonObjectEnd();
+        }
+    }
+    JsonArrayEnd();
+
+    JsonArrayBegin(L"memory");
+    while ((Entry = NextAffinity(Srat, Entry)) != NULL) {
+        if ((Memory = MemoryAffinity(Entry)) != NULL) {
+            JsonObjectBegin(NULL);
+            JsonUint(L"domain", SratDomain(Srat, Memory->ProximityDomain));
+            JsonHex(L"base", Memory->Base);
+            JsonUint(L"length", Memory->Size);
+            JsonBool(L"enabled", (Memory->Flags & SRAT_ENABLED) != 0);
+            JsonBool(L"hotPluggable", (Memory->Flags & SRAT_MEMORY_HOTPLUG) != 0);
+            JsonBool(L"nonVolatile", (Memory->Flags & SRAT_MEMORY_NONVOLATILE) != 0);
+            JsonObjectEnd();
+        }
+    }
+    JsonArrayEnd();
+}
+
+
+static VOID
+JsonSlit( SLIT_HEADER *Slit )
+{
+    JsonObjectBegin(L"slit");
+    JsonUint(L"localities", Slit->Localities);
+    JsonArrayBegin(L"distances");
+    for (UINT64 i = 0; i < Slit->Localities; i++) {
+        JsonArrayBegin(NULL);
+        for (UINT64 j = 0; j < Slit->Localities; j++) {
+            JsonUint(NULL, SlitDistance(Slit, i, j));
+        }
+        JsonArrayEnd();
+    }
+    JsonArrayEnd();
+    JsonObjectEnd();
+}
+
+
+static VOID
+JsonHmat( EFI_ACPI_DESCRIPTION_HEADER *Hmat )
+{
+    HMAT_PROXIMITY_DOMAIN_ATTRIBUTES *Attributes;
+    HMAT_LATENCY_BANDWIDTH_INFO *Info;
+    HMAT_MEMORY_CACHE_INFO *Cache;
+    HMAT_STRUCTURE *Entry = NULL;
+    UINT16 Value;
+
+    JsonObjectBegin(L"hmat");
+    JsonArrayBegin(L"attachedMemory");
+    while ((Entry = NextHmat(Hmat, Entry)) != NULL) {
+        if (Entry->Type == HMAT_PROXIMITY_DOMAIN && Entry->Length >= sizeof(HMAT_PROXIMITY_DOMAIN_ATTRIBUTES)) {
+            Attributes = (HMAT_PROXIMITY_DOMAIN_ATTRIBUTES *)Entry;
+            if (Attributes->Flags & HMAT_INITIATOR_VALID) {
+                JsonObjectBegin(NULL);
+                JsonUint(L"memoryDomain", Attributes->MemoryDomain);
+                JsonUint(L"initiatorDomain", Attributes->InitiatorDomain);
+                JsonObjectEnd();
+            }
+        }
+    }
+    JsonArrayEnd();
+
+    // latency in picoseconds, bandwidth in MB/s; 0 = no entry
+    JsonArrayBegin(L"matrices");
+    while ((Entry = NextHmat(Hmat, Entry)) != NULL) {
+        if ((Info = LatencyInfo(Entry)) == NULL) {
+            continue;
+        }
+        JsonObjectBegin(NULL);
+        JsonString(L"dataType", HmatDataTypesJson[Info->DataType & 0x0f]);
+        JsonString(L"unit", HMAT_IS_LATENCY(Info->DataType & 0x0f) ? L"ps" : L"MB/s");
+        JsonArrayBegin(L"initiators");
+        for (UINTN i = 0; i < Info->Initiators; i++) {
+            JsonUint(NULL, InitiatorDomains(Info)[i]);
+        }
+        JsonArrayEnd();
+        JsonArrayBegin(L"targets");
+        for (UINTN j = 0; j < Info->Targets; j++) {
+            JsonUint(NULL, TargetDomains(Info)[j]);
+        }
+        JsonArrayEnd();
+        JsonArrayBegin(L"values");
+        for (UINTN i = 0; i < Info->Initiators; i++) {
+            JsonArrayBegin(NULL);
+            for (UINTN j = 0; j < Info->Targets; j++) {
+                Value = HmatEntry(Info, i, j);
+                if (Value == HMAT_UNREACHABLE) {
+                    JsonNull(NULL);
+                } else {
+                    JsonUint(NULL, HmatValue(Info, Value));
+                }
+            }
+            JsonArrayEnd();
+        }
+        JsonArrayEnd();
+        JsonObjectEnd();
+    }
+    JsonArrayEnd();
+
+    JsonArrayBegin(L"memorySideCaches");
+    while ((Entry = NextHmat(Hmat, Entry)) != NULL) {
+        if (Entry->Type == HMAT_MEMORY_CACHE && Entry->Length >= sizeof(HMAT_MEMORY_CACHE_INFO)) {
+            Cache = (HMAT_MEMORY_CACHE_INFO *)Entry;
+            JsonObjectBegin(NULL);
+            JsonUint(L"memoryDomain", Cache->MemoryDomain);
+            JsonUint(L"size", Cache->CacheSize);
+            JsonUint(L"level", (Cache->CacheAttributes >> 4) & 0x0f);
+            JsonUint(L"lineSize", Cache->CacheAttributes >> 16);
+            JsonObjectEnd();
+        }
+    }
+    JsonArrayEnd();
+    JsonObjectEnd();
+}
+
+
+static VOID
+JsonNUMA( EFI_ACPI_DESCRIPTION_HEADER *Srat,
+          SLIT_HEADER *Slit,
+          EFI_ACPI_DESCRIPTION_HEADER *Hmat )
+{
+    if (Srat != NULL) {
+        JsonNodes(Srat);
+    } else {
+        JsonNull(L"nodes");
+    }
+    if (Slit != NULL) {
+        JsonSlit(Slit);
+    } else {
+        JsonNull(L"slit");
+    }
+    if (Hmat != NULL) {
+        JsonHmat(Hmat);
+    } else {
+        JsonNull(L"hmat");
+    }
+
+    JsonArrayBegin(L"warnings");
+    for (UINTN i = 0; i < WarningCount; i++) {
+        JsonString(NULL, Warnings[i]);
+    }
+    JsonArrayEnd();
+}
+
+
+static void
+Usage( void )
+{
+    OutputPrint(L"Usage: ShowNUMA [-v | --verbose]\n");
+    OutputPrint(L"       ShowNUMA [--json]\n");
+    OutputPrint(L"       ShowNUMA [-V | --version]\n");
+}
+
+
+INTN
+EFIAPI
+ShellAppMain( UINTN Argc,
+              CHAR16 **Argv )
+{
+    EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *Rsdp = NULL;
+    EFI_ACPI_DESCRIPTION_HEADER *Srat = NULL;
+    EFI_ACPI_DESCRIPTION_HEADER *Table = NULL;
+    EFI_ACPI_DESCRIPTION_HEADER *Hmat = NULL;
+    SLIT_HEADER *Slit = NULL;
+    EFI_STATUS Status = EFI_SUCCESS;
+    BOOLEAN Verbose = FALSE;
+    BOOLEAN Json = FALSE;
+
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
+
+    if (Argc == 2) {
+        if (!StrCmp(Argv[1], L"--verbose") ||
+            !StrCmp(Argv[1], L"-v")) {
+            Verbose = TRUE;
+        } else if (!StrCmp(Argv[1], L"--version") ||
+            !StrCmp(Argv[1], L"-V")) {
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
+            return Status;
+        } else if (!StrCmp(Argv[1], L"--help") ||
+            !StrCmp(Argv[1], L"-h")) {
+            Usage();
+            return Status;
+        } else {
+            Usage();
+            return Status;
+        }
+    }
+    if (Argc > 2) {
+        Usage();
+        return Status;
+    }
+
+    if (Json) {
+        JsonDocumentBegin(L"ShowNUMA", UTILITY_VERSION);
+    }
+
+    // look up the SRAT, SLIT and HMAT in the shared ACPI table index
+    Rsdp = AcpiIndexRsdp();
+    if (Rsdp != NULL) {
+        Srat = AcpiIndexFind(SRAT_SIGNATURE, 0);
+        Hmat = AcpiIndexFind(HMAT_SIGNATURE, 0);
+        Table = AcpiIndexFind(SLIT_SIGNATURE, 0);
+        if (Table != NULL && (Slit = CheckSlit(Table)) == NULL) {
+            Warn(L"SLIT length %d is too short for its locality count", Table->Length);
+        }
+        if (Srat != NULL && Srat->Length < sizeof(SRAT_HEADER)) {
+            Warn(L"SRAT length %d is too short", Srat->Length);
+            Srat = NULL;
+        }
+        if (Hmat != NULL && Hmat->Length < sizeof(HMAT_HEADER)) {
+            Warn(L"HMAT length %d is too short", Hmat->Length);
+            Hmat = NULL;
+        }
+    }
+
+    if (Rsdp == NULL) {
+        JsonError(L"Could not find an ACPI RSDP table.");
+        Status = EFI_NOT_FOUND;
+    } else {
+        if (Srat != NULL) {
+            CollectNodes(Srat);
+        }
+        CheckTopology(Srat, Slit, Hmat);
+        if (Json) {
+            JsonNUMA(Srat, Slit, Hmat);
+        } else {
+            PrintNUMA(Srat, Slit, Hmat, Verbose);
+        }
+    }
+
+    if (Json) {
+        JsonDocumentEnd();
+    }
+
+    return Status;
+}
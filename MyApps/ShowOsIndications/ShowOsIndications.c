@@ -18,6 +18,8 @@
 #include <Library/ShellLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
 
 #include <Protocol/EfiShell.h>
 #include <Protocol/LoadedImage.h>
@@ -26,11 +28,24 @@
 #undef DEBUG
 
 
+VOID
+JsonIndication( CHAR16 *Name,
+                BOOLEAN Supported,
+                BOOLEAN Set )
+{
+    JsonObjectBegin(Name);
+    JsonBool(L"supported", Supported);
+    JsonBool(L"set", Set);
+    JsonObjectEnd();
+}
+
+
 VOID
 Usage( VOID )
 {
-    Print(L"Usage: ShowOsIndications [-v | --verbose]\n");
-    Print(L"                         [-V | --version]\n");
+    OutputPrint(L"Usage: ShowOsIndications [-v | --verbose]\n");
+    OutputPrint(L"                         [--json]\n");
+    OutputPrint(L"                         [-V | --version]\n");
 }
 
 
@@ -47,15 +62,19 @@ ShellAppMain( UINTN Argc,
     BOOLEAN    SupportFMPCapsuleSupported, FMPCapsuleSupported; 
     BOOLEAN    SupportCapsuleResultVariable, CapsuleResultVariable;
     BOOLEAN    Verbose = FALSE;
+    BOOLEAN    Json = FALSE;
     UINT64     OsIndicationsSupported;
     UINT64     OsIndications;
     UINTN      DataSize;
     UINT32     Attributes;
 
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
+
     if (Argc == 2) {
         if (!StrCmp(Argv[1], L"--version") || 
             !StrCmp(Argv[1], L"-V")) {
-            Print(L"Version: %s\n", UTILITY_VERSION);
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
             return Status;
         } else if (!StrCmp(Argv[1], L"--verbose") ||
             !StrCmp(Argv[1], L"-v")) {
@@ -74,6 +93,9 @@ ShellAppMain( UINTN Argc,
         return Status;
     }
 
+    if (Json) {
+        JsonDocumentBegin(L"ShowOsIndications", UTILITY_VERSION);
+    }
 
     Attributes = EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS;
     DataSize = sizeof(UINT64);
@@ -84,12 +106,12 @@ ShellAppMain( UINTN Argc,
                                &DataSize,
                                &OsIndicationsSupported);
     if (Status == EFI_NOT_FOUND) {
-        Print(L"ERROR: OsIndicationsSupported variable not found.\n");
+        JsonError(L"OsIndicationsSupported variable not found.");
         return Status;
     }
 
 #ifdef DEBUG
-    Print(L"OSIndicationsSupported variable found: 0x%016x\n", OsIndicationSupport );
+    OutputPrint(L"OSIndicationsSupported variable found: 0x%016x\n", OsIndicationSupport );
 #endif
 
     Attributes = EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS;
@@ -101,12 +123,12 @@ ShellAppMain( UINTN Argc,
                                &DataSize,
                                &OsIndications);
     if (Status == EFI_NOT_FOUND) {
-        Print(L"ERROR: OSIndications variable not found.\n");
+        JsonError(L"OSIndications variable not found.");
         return Status;
     }
 
 #ifdef DEBUG
-    Print(L"OsIndications variable found: 0x%016x\n", OsIndication);
+    OutputPrint(L"OsIndications variable found: 0x%016x\n", OsIndication);
 #endif
 
     SupportBootFwUi = (BOOLEAN) ((OsIndicationsSupported & EFI_OS_INDICATIONS_BOOT_TO_FW_UI) != 0);
@@ -123,25 +145,38 @@ ShellAppMain( UINTN Argc,
     CapsuleResultVariable = (BOOLEAN) ((OsIndications & EFI_OS_INDICATIONS_CAPSULE_RESULT_VAR_SUPPORTED) != 0);
     PlatformRecovery = (BOOLEAN) ((OsIndications & EFI_OS_INDICATIONS_START_PLATFORM_RECOVERY) != 0);
 
-    Print(L"\n");
+    if (Json) {
+        JsonHex(L"osIndicationsSupported", OsIndicationsSupported);
+        JsonHex(L"osIndications", OsIndications);
+        JsonIndication(L"bootToFirmwareUi", SupportBootFwUi, BootFwUi);
+        JsonIndication(L"timestampRevocation", SupportTimeStampRevocation, TimeStampRevocation);
+        JsonIndication(L"fileCapsuleDelivery", SupportFileCapsuleDelivery, FileCapsuleDelivery);
+        JsonIndication(L"fmpCapsule", SupportFMPCapsuleSupported, FMPCapsuleSupported);
+        JsonIndication(L"capsuleResultVariable", SupportCapsuleResultVariable, CapsuleResultVariable);
+        JsonIndication(L"startPlatformRecovery", SupportPlatformRecovery, PlatformRecovery);
+        JsonDocumentEnd();
+        return Status;
+    }
+
+    OutputPrint(L"\n");
     if (Verbose) {
-        Print(L"    OsIndicationsSupported Variable: 0x%016x\n", OsIndicationsSupported); 
-        Print(L"             OsIndications Variable: 0x%016x\n", OsIndications); 
-        Print(L"\n");
+        OutputPrint(L"    OsIndicationsSupported Variable: 0x%016x\n", OsIndicationsSupported); 
+        OutputPrint(L"             OsIndications Variable: 0x%016x\n", OsIndications); 
+        OutputPrint(L"\n");
     }
-    Print(L"                Boot to Firmware UI: %s [%s]\n", SupportBootFwUi ? L"Supported  " : L"Unsupported", 
+    OutputPrint(L"                Boot to Firmware UI: %s [%s]\n", SupportBootFwUi ? L"Supported  " : L"Unsupported", 
                                                              BootFwUi ? L"Set" : L"Unset");
-    Print(L"               Timestamp Revocation: %s [%s]\n", SupportTimeStampRevocation ? L"Supported  " : L"Unsupported", 
+    OutputPrint(L"               Timestamp Revocation: %s [%s]\n", SupportTimeStampRevocation ? L"Supported  " : L"Unsupported", 
                                                              TimeStampRevocation ? L"Set" : L"Unset");
-    Print(L"      File Capsule Delivery Support: %s [%s]\n", SupportFileCapsuleDelivery ? L"Supported  " : L"Unsupported",
+    OutputPrint(L"      File Capsule Delivery Support: %s [%s]\n", SupportFileCapsuleDelivery ? L"Supported  " : L"Unsupported",
                                                              FileCapsuleDelivery ? L"Set" : L"Unset");
-    Print(L"                FMP Capsule Support: %s [%s]\n", SupportFMPCapsuleSupported ? L"Supported  " : L"Unsupported",
+    OutputPrint(L"                FMP Capsule Support: %s [%s]\n", SupportFMPCapsuleSupported ? L"Supported  " : L"Unsupported",
                                                              FMPCapsuleSupported ? L"Set" : L"Unset");
-    Print(L"    Capsule Result Variable Support: %s [%s]\n", SupportCapsuleResultVariable ? L"Supported  " : L"Unsupported", 
+    OutputPrint(L"    Capsule Result Variable Support: %s [%s]\n", SupportCapsuleResultVariable ? L"Supported  " : L"Unsupported", 
                                                              CapsuleResultVariable ? L"Set" : L"Unset");
-    Print(L"            Start Platform Recovery: %s [%s]\n", SupportPlatformRecovery ? L"Supported  " : L"Unsupported",
+    OutputPrint(L"            Start Platform Recovery: %s [%s]\n", SupportPlatformRecovery ? L"Supported  " : L"Unsupported",
                                                              PlatformRecovery ? L"Set" : L"Unset");
-    Print(L"\n");
+    OutputPrint(L"\n");
 
     return Status;
 }
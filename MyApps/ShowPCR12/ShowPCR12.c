@@ -13,6 +13,9 @@
 #include <Library/ShellLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/TpmCommandLib.h>
 
 #include <Protocol/EfiShell.h>
 #include <Protocol/LoadedImage.h>
@@ -32,29 +35,11 @@ Print_PcrDigest( TPM_PCRINDEX PcrIndex,
     int size = sizeof(TPM_PCRVALUE);
     UINT8 *buf = (UINT8 *)PcrValue;
 
-    Print(L"[%02d]  ", PcrIndex);
+    OutputPrint(L"[%02d]  ", PcrIndex);
     for (int i = 0; i < size; i++) {
-        Print(L"%02x ", 0xff & buf[i]);
+        OutputPrint(L"%02x ", 0xff & buf[i]);
     }
-    Print(L"\n");
-}
-
-
-BOOLEAN
-CheckForTpm20()
-{
-     EFI_STATUS Status = EFI_SUCCESS;
-     EFI_TCG2_PROTOCOL *Tcg2Protocol;
-     EFI_GUID gEfiTcg2ProtocolGuid = EFI_TCG2_PROTOCOL_GUID;
-
-     Status = gBS->LocateProtocol( &gEfiTcg2ProtocolGuid,
-                                   NULL,
-                                   (VOID **) &Tcg2Protocol );
-     if (EFI_ERROR (Status)) {
-         return FALSE;
-     } 
-
-     return TRUE;
+    OutputPrint(L"\n");
 }
 
 
@@ -63,9 +48,10 @@ Usage( CHAR16 *Str,
        BOOLEAN ErrorMsg )
 {
     if ( ErrorMsg ) {
-        Print(L"ERROR: Unknown option.\n");
+        OutputPrint(L"ERROR: Unknown option.\n");
     }
-    Print(L"Usage: %s [-V | --version]\n", Str);
+    OutputPrint(L"Usage: %s [-V | --version]\n", Str);
+    OutputPrint(L"       %s [--json]\n", Str);
 }
 
 
@@ -74,19 +60,22 @@ EFIAPI
 ShellAppMain( UINTN Argc,
               CHAR16 **Argv )
 {
-    EFI_GUID            gEfiTcgProtocolGuid = EFI_TCG_PROTOCOL_GUID;
     EFI_STATUS          Status = EFI_SUCCESS;
-    EFI_TCG_PROTOCOL    *TcgProtocol;
-    TPM_RSP_COMMAND_HDR *TpmRsp;
-    UINT32              TpmSendSize;
+    TPM_TRANSPORT       Transport;
+    TPM_COMMAND         Command;
+    TPM_RESPONSE        Response;
     UINT8               CmdBuf[64];
     TPM_PCRINDEX        PcrIndex;
     TPM_PCRVALUE        *PcrValue;
+    BOOLEAN             Json = FALSE;
+
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
 
     if (Argc == 2) {
         if ((!StrCmp(Argv[1], L"--version")) ||
             (!StrCmp(Argv[1], L"-V"))) {
-            Print(L"Version: %s\n", UTILITY_VERSION);
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
             return Status;
         } else if ((!StrCmp(Argv[1], L"--help")) ||
             (!StrCmp(Argv[1], L"-h"))) {
@@ -102,48 +91,57 @@ ShellAppMain( UINTN Argc,
         return Status;
     }
 
-    Status = gBS->LocateProtocol( &gEfiTcgProtocolGuid, 
-                                  NULL, 
-                                  (VOID **) &TcgProtocol );
-    if (EFI_ERROR (Status)) {
-        if (CheckForTpm20()) {
-            Print(L"ERROR: Platform configured for TPM 2.0, not TPM 1.2\n");
+    if (Json) {
+        JsonDocumentBegin(L"ShowPCR12", UTILITY_VERSION);
+    }
+
+    Status = TpmOpen(&Transport);
+    if (Transport != TpmTransportTpm12) {
+        if (Transport == TpmTransportTpm20) {
+            JsonError(L"Platform configured for TPM 2.0, not TPM 1.2");
+            Status = EFI_UNSUPPORTED;
         } else {
-            Print(L"ERROR: Failed to locate EFI_TCG_PROTOCOL [%d]\n", Status);
+            JsonError(L"Failed to locate EFI_TCG_PROTOCOL [%d]", Status);
         }
         return Status;
     }  
 
+    if (Json) {
+        JsonArrayBegin(L"pcrs");
+    }
+
     // Loop through all the PCRs and print each digest 
     for (PcrIndex = 1; PcrIndex <= TPM_NUM_PCR; PcrIndex++) {
-        TpmSendSize           = sizeof (TPM_RQU_COMMAND_HDR) + sizeof (UINT32);
-        *(UINT16*)&CmdBuf[0]  = SwapBytes16 (TPM_TAG_RQU_COMMAND);
-        *(UINT32*)&CmdBuf[2]  = SwapBytes32 (TpmSendSize);
-        *(UINT32*)&CmdBuf[6]  = SwapBytes32 (TPM_ORD_PcrRead);
-        *(UINT32*)&CmdBuf[10] = SwapBytes32 (PcrIndex);
-
-        Status = TcgProtocol->PassThroughToTpm( TcgProtocol,
-                                                TpmSendSize,
-                                                CmdBuf,
-                                                sizeof (CmdBuf),
-                                                CmdBuf );
-        if (EFI_ERROR (Status)) {
-            if (CheckForTpm20()) {
-                Print(L"ERROR: Platform configured for TPM 2.0, not TPM 1.2\n");
-            } else {
-                Print(L"ERROR: PassThroughToTpm failed [%d]\n", Status);
-            }
+        TpmCommandBegin(&Command, CmdBuf, sizeof(CmdBuf), TPM_TAG_RQU_COMMAND, TPM_ORD_PcrRead);
+        TpmPutUint32(&Command, PcrIndex);
+
+        Status = TpmSubmit(&Command, &Response, CmdBuf, sizeof(CmdBuf));
+        if (Status == EFI_PROTOCOL_ERROR) {
+            JsonError(L"TPM command result [%d]", Response.ResponseCode);
+            return EFI_DEVICE_ERROR;
+        } else if (EFI_ERROR (Status)) {
+            JsonError(L"PassThroughToTpm failed [%d]", Status);
             return Status;
         }
 
-        TpmRsp = (TPM_RSP_COMMAND_HDR *) &CmdBuf[0];
-        if ((TpmRsp->tag != SwapBytes16(TPM_TAG_RSP_COMMAND)) || (TpmRsp->returnCode != 0)) {
-            Print(L"ERROR: TPM command result [%d]\n", SwapBytes16(TpmRsp->returnCode));
+        PcrValue = (TPM_PCRVALUE *) TpmGetBytes(&Response, sizeof(TPM_PCRVALUE));
+        if (PcrValue == NULL) {
+            JsonError(L"Short PcrRead response [%d bytes]", Response.Length);
             return EFI_DEVICE_ERROR;
         }
+        if (Json) {
+            JsonObjectBegin(NULL);
+            JsonUint(L"index", PcrIndex);
+            JsonBytes(L"digest", PcrValue, sizeof(TPM_PCRVALUE));
+            JsonObjectEnd();
+        } else {
+            Print_PcrDigest(PcrIndex, PcrValue);
+        }
+    }
 
-        PcrValue = (TPM_PCRVALUE *) &CmdBuf[sizeof (TPM_RSP_COMMAND_HDR)];
-        Print_PcrDigest(PcrIndex, PcrValue);
+    if (Json) {
+        JsonArrayEnd();
+        JsonDocumentEnd();
     }
 
     return Status;
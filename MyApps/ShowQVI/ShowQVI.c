@@ -18,6 +18,8 @@
 #include <Library/ShellLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
 
 #include <Protocol/EfiShell.h>
 #include <Protocol/LoadedImage.h>
@@ -29,7 +31,8 @@
 VOID
 Usage( VOID )
 {
-    Print(L"Usage: ShowQVI [-V | --version]\n");
+    OutputPrint(L"Usage: ShowQVI [--json]\n");
+    OutputPrint(L"       ShowQVI [-V | --version]\n");
 }
 
 
@@ -43,11 +46,15 @@ ShellAppMain( UINTN Argc,
     UINT64 MaxStoreSize = 0;
     UINT64 RemainStoreSize = 0;
     UINT64 MaxVariableSize = 0;
+    BOOLEAN Json = FALSE;
+
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
 
     if (Argc == 2) {
         if (!StrCmp(Argv[1], L"--version") || 
             !StrCmp(Argv[1], L"-V")) {
-            Print(L"Version: %s\n", UTILITY_VERSION);
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
             return Status;
         } else if (!StrCmp(Argv[1], L"--help") ||
             !StrCmp(Argv[1], L"-h")) {
@@ -64,6 +71,10 @@ ShellAppMain( UINTN Argc,
     }
 
 
+    if (Json) {
+        JsonDocumentBegin(L"ShowQVI", UTILITY_VERSION);
+    }
+
     Attributes = EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS;
 
     Status = gRT->QueryVariableInfo( Attributes,
@@ -71,15 +82,23 @@ ShellAppMain( UINTN Argc,
                                      &RemainStoreSize,
                                      &MaxVariableSize );
     if (Status != EFI_SUCCESS) {
-        Print(L"ERROR: QueryVariableInfo: %d\n", Status);
+        JsonError(L"QueryVariableInfo: %d", Status);
+        return Status;
+    }
+
+    if (Json) {
+        JsonUint(L"maxStorageSize", MaxStoreSize);
+        JsonUint(L"remainingStorageSize", RemainStoreSize);
+        JsonUint(L"maxVariableSize", MaxVariableSize);
+        JsonDocumentEnd();
         return Status;
     }
 
-    Print(L"\n");
-    Print(L"    Maximum Variable Storage Size: 0x%016x [%ld]\n", MaxStoreSize, MaxStoreSize);
-    Print(L"  Remaining Variable Storage Size: 0x%016x [%ld]\n", RemainStoreSize, RemainStoreSize);
-    Print(L"            Maximum Variable Size: 0x%016x [%ld]\n", MaxVariableSize, MaxVariableSize);
-    Print(L"\n");
+    OutputPrint(L"\n");
+    OutputPrint(L"    Maximum Variable Storage Size: 0x%016x [%ld]\n", MaxStoreSize, MaxStoreSize);
+    OutputPrint(L"  Remaining Variable Storage Size: 0x%016x [%ld]\n", RemainStoreSize, RemainStoreSize);
+    OutputPrint(L"            Maximum Variable Size: 0x%016x [%ld]\n", MaxVariableSize, MaxVariableSize);
+    OutputPrint(L"\n");
 
     return Status;
 }
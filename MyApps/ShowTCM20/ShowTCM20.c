@@ -13,6 +13,10 @@
 #include <Library/ShellLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/TpmInfoLib.h>
+#include <Library/TpmCommandLib.h>
 
 #include <Protocol/EfiShell.h>
 #include <Protocol/LoadedImage.h>
@@ -23,29 +27,15 @@
 #undef DEBUG
 
 
-CHAR16 *
-ManufacturerStr( UINT32 ManufacturerID )
-{
-    static CHAR16 Mcode[5];
-
-    Mcode[0] = (CHAR16) ((ManufacturerID & 0xff000000) >> 24);
-    Mcode[1] = (CHAR16) ((ManufacturerID & 0x00ff0000) >> 16);
-    Mcode[2] = (CHAR16) ((ManufacturerID & 0x0000ff00) >> 8);
-    Mcode[3] = (CHAR16)  (ManufacturerID & 0x000000ff);
-    Mcode[4] = (CHAR16) '\0';
-
-    return Mcode;
-}
-
-
 VOID
 Usage( CHAR16 *Str,
        BOOLEAN ErrorMsg )
 {
     if ( ErrorMsg ) {
-        Print(L"ERROR: Unknown option.\n");
+        OutputPrint(L"ERROR: Unknown option.\n");
     }
-    Print(L"Usage: %s [-V | --version]\n", Str);
+    OutputPrint(L"Usage: %s [-V | --version]\n", Str);
+    OutputPrint(L"       %s [--json]\n", Str);
 }
 
 
@@ -57,12 +47,16 @@ ShellAppMain( UINTN Argc,
     EFI_STATUS Status = EFI_SUCCESS;
     EFI_TCG2_PROTOCOL *Tcg2Protocol;
     EFI_TCG2_BOOT_SERVICE_CAPABILITY CapabilityData;
-    EFI_GUID gEfiTcg2ProtocolGuid = EFI_TCG2_PROTOCOL_GUID;
+    TPM_TRANSPORT Transport;
+    BOOLEAN Json = FALSE;
+
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
 
     if (Argc == 2) {
         if (!StrCmp(Argv[1], L"--version") ||
             !StrCmp(Argv[1], L"-V")) {
-            Print(L"Version: %s\n", UTILITY_VERSION);
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
             return Status;
         } else if (!StrCmp(Argv[1], L"--help") ||
             !StrCmp(Argv[1], L"-h")) {
@@ -78,12 +72,19 @@ ShellAppMain( UINTN Argc,
         return Status;
     }
 
-    Status = gBS->LocateProtocol( &gEfiTcg2ProtocolGuid, 
-                                  NULL, 
-                                  (VOID **) &Tcg2Protocol );
-    if (EFI_ERROR (Status)) {
-        Print(L"ERROR: Failed to locate EFI_TCG2_PROTOCOL [%d]\n", Status);
-        return Status;
+    if (Json) {
+        JsonDocumentBegin(L"ShowTCM20", UTILITY_VERSION);
+    }
+
+    Status = TpmOpen(&Transport);
+    Tcg2Protocol = TpmTcg2();
+    if (Tcg2Protocol == NULL) {
+        if (Transport == TpmTransportTpm12) {
+            JsonError(L"Platform configured for TPM 1.2, not TPM 2.0");
+        } else {
+            JsonError(L"Failed to locate EFI_TCG2_PROTOCOL [%d]", EFI_NOT_FOUND);
+        }
+        return EFI_NOT_FOUND;
     }  
 
  
@@ -91,58 +92,64 @@ ShellAppMain( UINTN Argc,
     Status = Tcg2Protocol->GetCapability( Tcg2Protocol,
                                           &CapabilityData );
     if (EFI_ERROR (Status)) {
-        Print(L"ERROR: Tcg2Protocol GetCapacity [%d]\n", Status);
+        JsonError(L"Tcg2Protocol GetCapacity [%d]", Status);
         return Status;
     }  
 
-    Print(L"\n");
-    Print(L"            Structure Version: %d.%d\n", CapabilityData.StructureVersion.Major,
+    if (Json) {
+        TpmCapabilityJson(&CapabilityData);
+        JsonDocumentEnd();
+        return Status;
+    }
+
+    OutputPrint(L"\n");
+    OutputPrint(L"            Structure Version: %d.%d\n", CapabilityData.StructureVersion.Major,
                                                      CapabilityData.StructureVersion.Minor );
-    Print(L"             Protocol Version: %d.%d\n", CapabilityData.ProtocolVersion.Major,
+    OutputPrint(L"             Protocol Version: %d.%d\n", CapabilityData.ProtocolVersion.Major,
                                                      CapabilityData.ProtocolVersion.Minor );
-    Print(L"    Supported Hash Algorithms: ");
+    OutputPrint(L"    Supported Hash Algorithms: ");
     if ((CapabilityData.HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SHA1) != 0) {
-        Print(L"SHA1 ");
+        OutputPrint(L"SHA1 ");
     }
     if ((CapabilityData.HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SHA256) != 0) {
-        Print(L"SHA256 ");
+        OutputPrint(L"SHA256 ");
     }
     if ((CapabilityData.HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SHA384) != 0) {
-        Print(L"SHA384 ");
+        OutputPrint(L"SHA384 ");
     }
     if ((CapabilityData.HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SHA512) != 0) {
-        Print(L"SHA512 ");
+        OutputPrint(L"SHA512 ");
     }
     if ((CapabilityData.HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SM3_256) != 0) {
-        Print(L"SM3_256 ");
+        OutputPrint(L"SM3_256 ");
     }
-    Print(L"\n");
+    OutputPrint(L"\n");
 
-    Print(L"  Supported Event Log Formats: ");
+    OutputPrint(L"  Supported Event Log Formats: ");
     if ((CapabilityData.SupportedEventLogs & EFI_TCG2_EVENT_LOG_FORMAT_TCG_1_2) != 0) {
-        Print(L"TCG_1.2 ");
+        OutputPrint(L"TCG_1.2 ");
     }
     if ((CapabilityData.SupportedEventLogs & EFI_TCG2_EVENT_LOG_FORMAT_TCG_2) != 0) {
-        Print(L"TCG_2 ");
+        OutputPrint(L"TCG_2 ");
     }
-    Print(L"\n");
+    OutputPrint(L"\n");
 
-    Print(L"             TPM Present Flag: ");
+    OutputPrint(L"             TPM Present Flag: ");
     if (CapabilityData.TPMPresentFlag) {
-        Print(L"True\n");
+        OutputPrint(L"True\n");
     } else {
-        Print(L"False\n");
+        OutputPrint(L"False\n");
     }
 
-    Print(L"         Maximum Command Size: 0x%02x (%d)\n", CapabilityData.MaxCommandSize,
+    OutputPrint(L"         Maximum Command Size: 0x%02x (%d)\n", CapabilityData.MaxCommandSize,
                                                            CapabilityData.MaxCommandSize);
-    Print(L"        Maximum Response Size: 0x%02x (%d)\n", CapabilityData.MaxResponseSize,
+    OutputPrint(L"        Maximum Response Size: 0x%02x (%d)\n", CapabilityData.MaxResponseSize,
                                                            CapabilityData.MaxResponseSize);
-    Print(L"                TCG Vendor ID: %s\n", ManufacturerStr(CapabilityData.ManufacturerID));
-    Print(L"          Number of PCR Banks: %d\n", CapabilityData.NumberOfPCRBanks);
-    Print(L"             Active PCR Banks: %d\n", (UINT32) CapabilityData.ActivePcrBanks);
+    OutputPrint(L"                TCG Vendor ID: %s\n", TpmManufacturerStr(CapabilityData.ManufacturerID));
+    OutputPrint(L"          Number of PCR Banks: %d\n", CapabilityData.NumberOfPCRBanks);
+    OutputPrint(L"             Active PCR Banks: %d\n", (UINT32) CapabilityData.ActivePcrBanks);
 
-    Print(L"\n");
+    OutputPrint(L"\n");
 
     return Status;
 }
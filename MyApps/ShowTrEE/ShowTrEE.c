@@ -14,6 +14,10 @@
 #include <Library/ShellLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Library/HexDumpLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/TpmInfoLib.h>
 
 #include <Protocol/EfiShell.h>
 #include <Protocol/LoadedImage.h>
@@ -32,25 +36,34 @@ VOID
 PrintEventDetail( UINT8 *Detail, 
                   UINT32 Size )
 {
-    UINT8 *d = Detail;
-    int Offset = 0;
-    int Row = 1;
-
-    Print(L"                 Event Detail: %08x: ", Offset);
-
-    for (int i = 0; i < Size; i++) {
-        Print(L"%02x", *d++);
-        Offset++; Row++;
-        if (Row == 17 || Row == 33) {
-            Print(L" ");
-        }              
-        if (Row > 48) {
-            Row = 1;
-            Print(L"\n                               %08x: ", Offset);
-        }
-    }
+    HexDump( L"                 Event Detail: ", L"                               ",
+             Detail, Size, 48, HEXDUMP_OFFSET );
+}
+
 
-    Print(L"\n");
+CHAR16 *
+EventTypeStr( UINT32 EventType )
+{
+    switch (EventType) {
+        case  EV_POST_CODE:                       return L"Post Code";
+        case  EV_NO_ACTION:                       return L"No Action";
+        case  EV_SEPARATOR:                       return L"Separator";
+        case  EV_S_CRTM_CONTENTS:                 return L"CTRM Contents";
+        case  EV_S_CRTM_VERSION:                  return L"CRTM Version";
+        case  EV_CPU_MICROCODE:                   return L"CPU Microcode";
+        case  EV_TABLE_OF_DEVICES:                return L"Table of Devices";
+        case  EV_EFI_VARIABLE_DRIVER_CONFIG:      return L"Variable Driver Config";
+        case  EV_EFI_VARIABLE_BOOT:               return L"Variable Boot";
+        case  EV_EFI_BOOT_SERVICES_APPLICATION:   return L"Boot Services Application";
+        case  EV_EFI_BOOT_SERVICES_DRIVER:        return L"Boot Services Driver";
+        case  EV_EFI_RUNTIME_SERVICES_DRIVER:     return L"Runtime Services Driver";
+        case  EV_EFI_GPT_EVENT:                   return L"GPT Event";
+        case  EV_EFI_ACTION:                      return L"Action";
+        case  EV_EFI_PLATFORM_FIRMWARE_BLOB:      return L"Platform Fireware Blob";
+        case  EV_EFI_HANDOFF_TABLES:              return L"Handoff Tables";
+        case  EV_EFI_VARIABLE_AUTHORITY:          return L"Variable Authority";
+        default:                                  return L"Unknown Type";
+    }
 }
 
 
@@ -58,77 +71,68 @@ VOID
 PrintEventType( UINT32 EventType,
                 BOOLEAN Verbose )
 {
-    Print(L"                   Event Type: ");
+    OutputPrint(L"                   Event Type: ");
     if (Verbose) {
-        Print(L"%08x ", EventType);
+        OutputPrint(L"%08x ", EventType);
     }
-    switch (EventType) {
-        case  EV_POST_CODE:                      Print(L"Post Code");
-                                                 break;
-        case  EV_NO_ACTION:                      Print(L"No Action");
-                                                 break;
-        case  EV_SEPARATOR:                      Print(L"Separator");
-                                                 break;
-        case  EV_S_CRTM_CONTENTS:                Print(L"CTRM Contents");
-                                                 break;
-        case  EV_S_CRTM_VERSION:                 Print(L"CRTM Version");
-                                                 break;
-        case  EV_CPU_MICROCODE:                  Print(L"CPU Microcode");
-                                                 break;
-        case  EV_TABLE_OF_DEVICES:               Print(L"Table of Devices");
-                                                 break;
-        case  EV_EFI_VARIABLE_DRIVER_CONFIG:     Print(L"Variable Driver Config");
-                                                 break;
-        case  EV_EFI_VARIABLE_BOOT:              Print(L"Variable Boot");
-                                                 break;
-        case  EV_EFI_BOOT_SERVICES_APPLICATION:  Print(L"Boot Services Application");
-                                                 break;
-        case  EV_EFI_BOOT_SERVICES_DRIVER:       Print(L"Boot Services Driver");
-                                                 break;
-        case  EV_EFI_RUNTIME_SERVICES_DRIVER:    Print(L"Runtime Services Driver");
-                                                 break;
-        case  EV_EFI_GPT_EVENT:                  Print(L"GPT Event");
-                                                 break;
-        case  EV_EFI_ACTION:                     Print(L"Action");
-                                                 break;
-        case  EV_EFI_PLATFORM_FIRMWARE_BLOB:     Print(L"Platform Fireware Blob");
-                                                 break;
-        case  EV_EFI_HANDOFF_TABLES:             Print(L"Handoff Tables");
-                                                 break;
-        case  EV_EFI_VARIABLE_AUTHORITY:         Print(L"Variable Authority");
-                                                 break;
-        default:                                 Print(L"Unknown Type");
-                                                 break;
-    }        
-    Print(L"\n");
+    OutputPrint(L"%s\n", EventTypeStr(EventType));
 }
 
 
 VOID
 PrintSHA1( TCG_DIGEST Digest )
 {
-    Print(L"                  SHA1 Digest: " );
-
-    for (int j = 0; j < SHA1_DIGEST_SIZE; j++ ) {
-         Print(L"%02x", Digest.digest[j]);
-    }
+    CHAR16 Buffer[(SHA1_DIGEST_SIZE * 2) + 1];
 
-    Print(L"\n");
+    OutputPrint(L"                  SHA1 Digest: %s\n", HexToString(Buffer, sizeof(Buffer), Digest.digest, SHA1_DIGEST_SIZE));
 }
 
 
-CHAR16 *
-ManufacturerStr( UINT32 ManufacturerID )
+//
+// Capability and last event log entry as a JSON record
+//
+VOID
+JsonTrEE( TREE_BOOT_SERVICE_CAPABILITY *CapabilityData,
+          TCG_PCR_EVENT *Event )
 {
-    static CHAR16 Mcode[5];
-
-    Mcode[0] = (CHAR16) ((ManufacturerID & 0xff000000) >> 24);
-    Mcode[1] = (CHAR16) ((ManufacturerID & 0x00ff0000) >> 16);
-    Mcode[2] = (CHAR16) ((ManufacturerID & 0x0000ff00) >> 8);
-    Mcode[3] = (CHAR16)  (ManufacturerID & 0x000000ff);
-    Mcode[4] = (CHAR16) '\0';
-
-    return Mcode;
+    JsonPrint(L"structureVersion", L"%d.%d", CapabilityData->StructureVersion.Major,
+                                             CapabilityData->StructureVersion.Minor);
+    JsonPrint(L"protocolVersion", L"%d.%d", CapabilityData->ProtocolVersion.Major,
+                                            CapabilityData->ProtocolVersion.Minor);
+    JsonArrayBegin(L"hashAlgorithms");
+    if ((CapabilityData->HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SHA1) != 0) {
+        JsonString(NULL, L"SHA1");
+    }
+    if ((CapabilityData->HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SHA256) != 0) {
+        JsonString(NULL, L"SHA256");
+    }
+    if ((CapabilityData->HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SHA384) != 0) {
+        JsonString(NULL, L"SHA384");
+    }
+    if ((CapabilityData->HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SHA512) != 0) {
+        JsonString(NULL, L"SHA512");
+    }
+    JsonArrayEnd();
+    JsonBool(L"trEEPresent", CapabilityData->TrEEPresentFlag);
+    JsonArrayBegin(L"eventLogFormats");
+    if ((CapabilityData->SupportedEventLogs & TREE_EVENT_LOG_FORMAT_TCG_1_2) != 0) {
+        JsonString(NULL, L"TCG_1.2");
+    }
+    JsonArrayEnd();
+    JsonUint(L"maxCommandSize", CapabilityData->MaxCommandSize);
+    JsonUint(L"maxResponseSize", CapabilityData->MaxResponseSize);
+    JsonString(L"manufacturerId", TpmManufacturerStr(CapabilityData->ManufacturerID));
+
+    if (Event != NULL) {
+        JsonObjectBegin(L"lastEvent");
+        JsonUint(L"pcrIndex", Event->PCRIndex);
+        JsonHex(L"eventType", Event->EventType);
+        JsonString(L"eventTypeName", EventTypeStr(Event->EventType));
+        JsonBytes(L"sha1", Event->Digest.digest, SHA1_DIGEST_SIZE);
+        JsonUint(L"eventSize", Event->EventSize);
+        JsonBytes(L"eventData", Event->Event, Event->EventSize);
+        JsonObjectEnd();
+    }
 }
 
 
@@ -137,10 +141,11 @@ Usage( CHAR16 *Str,
        BOOLEAN ErrorMsg )
 {
     if ( ErrorMsg ) {
-        Print(L"ERROR: Unknown option.\n");
+        OutputPrint(L"ERROR: Unknown option.\n");
     }
-    Print(L"Usage: %s [-V | --version]\n", Str);
-    Print(L"       %s [-v | --verbose]\n", Str);
+    OutputPrint(L"Usage: %s [-V | --version]\n", Str);
+    OutputPrint(L"       %s [-v | --verbose]\n", Str);
+    OutputPrint(L"       %s [--json]\n", Str);
 }
 
 
@@ -162,11 +167,15 @@ ShellAppMain( UINTN Argc,
     BOOLEAN EventLogTruncated;
     TCG_PCR_EVENT *Event = NULL;
     BOOLEAN Verbose = FALSE;
+    BOOLEAN Json = FALSE;
+
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
 
    if (Argc == 2) {
         if (!StrCmp(Argv[1], L"--version") ||
             !StrCmp(Argv[1], L"-V")) {
-            Print(L"Version: %s\n", UTILITY_VERSION);
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
             return Status;
         } else if (!StrCmp(Argv[1], L"--help") ||
             !StrCmp(Argv[1], L"-h")) {
@@ -193,69 +202,87 @@ ShellAppMain( UINTN Argc,
                                       &HandleCount,
                                       &HandleBuffer );
     if (EFI_ERROR (Status)) {
-        Print(L"No EFI_TREE_SERVICE_BINDING_PROTOCOL handles found.\n\n");
+        OutputPrint(L"No EFI_TREE_SERVICE_BINDING_PROTOCOL handles found.\n\n");
     }
 #endif
 
+    if (Json) {
+        JsonDocumentBegin(L"ShowTrEE", UTILITY_VERSION);
+    }
+
     Status = gBS->LocateProtocol( &gEfiTrEEProtocolGuid, 
                                   NULL, 
                                   (VOID **) &TreeProtocol );
     if (EFI_ERROR (Status)) {
-        Print(L"Failed to locate EFI_TREE_PROTOCOL [%d]\n", Status);
+        JsonError(L"Failed to locate EFI_TREE_PROTOCOL [%d]", Status);
         return Status;
     }  
 
     CapabilityData.Size = (UINT8)sizeof(CapabilityData);
     Status = TreeProtocol->GetCapability(TreeProtocol, &CapabilityData);
     if (EFI_ERROR (Status)) {
-        Print(L"ERROR: TrEEProtocol GetCapacity [%d]\n", Status);
+        JsonError(L"TrEEProtocol GetCapacity [%d]", Status);
         return Status;
     }  
 
     // check TrEE Protocol present flag and exit if false
     if (CapabilityData.TrEEPresentFlag == FALSE) {
-        Print(L"ERROR: TrEEProtocol TrEEPresentFlag is false.\n");
+        JsonError(L"TrEEProtocol TrEEPresentFlag is false.");
         return Status;
     } 
 
-    Print(L"\n");
-    Print(L"            Structure version: %d.%d\n", CapabilityData.StructureVersion.Major,
+    if (Json) {
+        Status = TreeProtocol->GetEventLog( TreeProtocol, 
+                                            TREE_EVENT_LOG_FORMAT_TCG_1_2,
+                                            &EventLogLocation,
+                                            &EventLogLastEntry,
+                                            &EventLogTruncated );
+        if (!EFI_ERROR (Status) && EventLogLastEntry != 0) {
+            Event = (TCG_PCR_EVENT *) EventLogLastEntry;
+        }
+        JsonTrEE(&CapabilityData, Event);
+        JsonDocumentEnd();
+        return Status;
+    }
+
+    OutputPrint(L"\n");
+    OutputPrint(L"            Structure version: %d.%d\n", CapabilityData.StructureVersion.Major,
                                                      CapabilityData.StructureVersion.Minor);
-    Print(L"             Protocol version: %d.%d\n", CapabilityData.ProtocolVersion.Major,
+    OutputPrint(L"             Protocol version: %d.%d\n", CapabilityData.ProtocolVersion.Major,
                                                      CapabilityData.ProtocolVersion.Minor);
 
-    Print(L"    Supported Hash Algorithms: ");
+    OutputPrint(L"    Supported Hash Algorithms: ");
     if ((CapabilityData.HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SHA1) != 0) {
-        Print(L"SHA1 ");
+        OutputPrint(L"SHA1 ");
     }
     if ((CapabilityData.HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SHA256) != 0) {
-        Print(L"SHA256 ");
+        OutputPrint(L"SHA256 ");
     }
     if ((CapabilityData.HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SHA384) != 0) {
-        Print(L"SHA384 ");
+        OutputPrint(L"SHA384 ");
     }
     if ((CapabilityData.HashAlgorithmBitmap & EFI_TCG2_BOOT_HASH_ALG_SHA512) != 0) {
-        Print(L"SHA512 ");
+        OutputPrint(L"SHA512 ");
     }
-    Print(L"\n");
+    OutputPrint(L"\n");
 
-    Print(L"            TrEE Present Flag: ");
+    OutputPrint(L"            TrEE Present Flag: ");
     if (CapabilityData.TrEEPresentFlag) {
-        Print(L"True\n");
+        OutputPrint(L"True\n");
     } else {
-        Print(L"False\n");
+        OutputPrint(L"False\n");
     }
      
-    Print(L"  Supported Event Log Formats: ");
+    OutputPrint(L"  Supported Event Log Formats: ");
     if ((CapabilityData.SupportedEventLogs & TREE_EVENT_LOG_FORMAT_TCG_1_2) != 0) {
-        Print(L"TCG_1.2 ");
+        OutputPrint(L"TCG_1.2 ");
     }
-    Print(L"\n");
+    OutputPrint(L"\n");
 
-    Print(L"         Maximum Command Size: %d\n", CapabilityData.MaxCommandSize);
-    Print(L"        Maximum Response Size: %d\n", CapabilityData.MaxResponseSize);
+    OutputPrint(L"         Maximum Command Size: %d\n", CapabilityData.MaxCommandSize);
+    OutputPrint(L"        Maximum Response Size: %d\n", CapabilityData.MaxResponseSize);
 
-    Print(L"              Manufacturer ID: %s\n", ManufacturerStr(CapabilityData.ManufacturerID));
+    OutputPrint(L"              Manufacturer ID: %s\n", TpmManufacturerStr(CapabilityData.ManufacturerID));
 
     Status = TreeProtocol->GetEventLog( TreeProtocol, 
                                         TREE_EVENT_LOG_FORMAT_TCG_1_2,
@@ -263,20 +290,20 @@ ShellAppMain( UINTN Argc,
                                         &EventLogLastEntry,
                                         &EventLogTruncated );
     if (EFI_ERROR (Status)) {
-        Print(L"ERROR: TreeProtocol GetEventLog [%d]\n", Status);
+        JsonError(L"TreeProtocol GetEventLog [%d]", Status);
         return Status;
     }  
 
     Event = (TCG_PCR_EVENT *) EventLogLastEntry;
 
-    Print(L"         Last Event PCR Index: %u\n", Event->PCRIndex);
+    OutputPrint(L"         Last Event PCR Index: %u\n", Event->PCRIndex);
     PrintEventType(Event->EventType, Verbose);
     PrintSHA1(Event->Digest);
-    Print(L"                   Event Size: %d\n", Event->EventSize);
+    OutputPrint(L"                   Event Size: %d\n", Event->EventSize);
     if (Verbose) {
         PrintEventDetail(Event->Event, Event->EventSize);
     }
-    Print(L"\n");
+    OutputPrint(L"\n");
 
     return Status;
 }
@@ -0,0 +1,594 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  ShowTrEELog event types and payload decoders.  Each event type has
+//  one table entry giving its TCG name, a description and (optionally)
+//  a decoder for the event data.  Decoders check every length against
+//  EventSize before touching the payload; the data is whatever the
+//  firmware logged and nothing in it can be trusted.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/UefiLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+
+#include <Guid/GlobalVariable.h>
+
+#include "ShowTrEELog.h"
+
+#define MAX_NAME_LENGTH     64           // characters shown of a variable name
+#define MAX_STRING_LENGTH   128          // characters shown of a logged string
+
+
+static VOID
+DecodeMalformed( BOOLEAN Json )
+{
+    if (Json) {
+        JsonBool(L"malformed", TRUE);
+    } else {
+        OutputPrint(L"     Event Detail: malformed event data\n");
+    }
+}
+
+
+//
+// Device path of Length bytes as text, or NULL if it is not a valid path.
+// Caller frees.
+//
+static CHAR16 *
+DevicePathText( EFI_DEVICE_PATH_PROTOCOL *DevicePath,
+                UINTN Length )
+{
+    if (Length < sizeof(EFI_DEVICE_PATH_PROTOCOL) || !IsDevicePathValid(DevicePath, Length)) {
+        return NULL;
+    }
+
+    return ConvertDevicePathToText(DevicePath, FALSE, FALSE);
+}
+
+
+static VOID
+DecodeDevicePath( EFI_DEVICE_PATH_PROTOCOL *DevicePath,
+                  UINTN Length,
+                  BOOLEAN Json )
+{
+    CHAR16 *Text = DevicePathText(DevicePath, Length);
+
+    if (Json) {
+        if (Text != NULL) {
+            JsonString(L"devicePath", Text);
+        } else {
+            JsonNull(L"devicePath");
+        }
+    } else {
+        OutputPrint(L"      Device Path: %s\n", Text != NULL ? Text : L"(invalid)");
+    }
+    if (Text != NULL) {
+        FreePool(Text);
+    }
+}
+
+
+//
+// EFI_LOAD_OPTION: Attributes, FilePathListLength, NUL terminated
+// Description, FilePathList, OptionalData
+//
+static VOID
+DecodeLoadOption( UINT8 *Data,
+                  UINTN Size,
+                  BOOLEAN Json )
+{
+    CHAR16 Description[MAX_STRING_LENGTH + 1];
+    UINTN  Offset = sizeof(UINT32) + sizeof(UINT16);
+    UINTN  Length = 0;
+    UINT16 PathLength;
+    UINT32 Attributes;
+
+    if (Size < Offset) {
+        DecodeMalformed(Json);
+        return;
+    }
+    CopyMem(&Attributes, Data, sizeof(Attributes));
+    CopyMem(&PathLength, Data + sizeof(UINT32), sizeof(PathLength));
+
+    // description may be unaligned in the log, so copy it out a character at a time
+    for (CHAR16 Char = 1; Char != 0; Offset += sizeof(CHAR16)) {
+        if (Offset + sizeof(CHAR16) > Size) {
+            DecodeMalformed(Json);
+            return;
+        }
+        CopyMem(&Char, Data + Offset, sizeof(CHAR16));
+        if (Length < MAX_STRING_LENGTH) {
+            Description[Length++] = Char;
+        }
+    }
+    Description[Length] = 0;
+    if (PathLength > Size - Offset) {
+        DecodeMalformed(Json);
+        return;
+    }
+
+    if (Json) {
+        JsonHex(L"attributes", Attributes);
+        JsonString(L"description", Description);
+    } else {
+        OutputPrint(L"       Attributes: 0x%08x%s\n", Attributes,
+                    (Attributes & LOAD_OPTION_ACTIVE) ? L" (active)" : L"");
+        OutputPrint(L"      Description: %s\n", Description);
+    }
+    DecodeDevicePath((EFI_DEVICE_PATH_PROTOCOL *)(Data + Offset), PathLength, Json);
+}
+
+
+static VOID
+DecodeBootOrder( UINT8 *Data,
+                 UINTN Size,
+                 BOOLEAN Json )
+{
+    UINT16 Option;
+
+    if (Json) {
+        JsonArrayBegin(L"bootOrder");
+    } else {
+        OutputPrint(L"       Boot Order:");
+    }
+    for (UINTN i = 0; i + sizeof(UINT16) <= Size; i += sizeof(UINT16)) {
+        CopyMem(&Option, Data + i, sizeof(UINT16));
+        if (Json) {
+            JsonPrint(NULL, L"Boot%04x", Option);
+        } else {
+            OutputPrint(L" Boot%04x", Option);
+        }
+    }
+    if (Json) {
+        JsonArrayEnd();
+    } else {
+        OutputPrint(L"\n");
+    }
+}
+
+
+//
+// EV_EFI_VARIABLE_AUTHORITY logs the single EFI_SIGNATURE_DATA from
+// db that authorized an image
+//
+static VOID
+DecodeSignatureOwner( UINT8 *Data,
+                      UINTN Size,
+                      BOOLEAN Json )
+{
+    EFI_GUID Owner;
+
+    if (Size < sizeof(EFI_GUID)) {
+        DecodeMalformed(Json);
+        return;
+    }
+    CopyMem(&Owner, Data, sizeof(EFI_GUID));
+
+    if (Json) {
+        JsonGuid(L"signatureOwner", &Owner);
+    } else {
+        OutputPrint(L"  Signature Owner: %g\n", &Owner);
+    }
+}
+
+
+static BOOLEAN
+IsBootOption( CHAR16 *Name )
+{
+    if (StrLen(Name) != 8 || StrnCmp(Name, L"Boot", 4) != 0) {
+        return FALSE;
+    }
+    for (UINTN i = 4; i < 8; i++) {
+        if (!((Name[i] >= L'0' && Name[i] <= L'9') || (Name[i] >= L'A' && Name[i] <= L'F'))) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+
+//
+// UEFI_VARIABLE_DATA: EV_EFI_VARIABLE_DRIVER_CONFIG, _BOOT and _AUTHORITY
+//
+static VOID
+DecodeVariable( LOG_EVENT *Event,
+                BOOLEAN Json )
+{
+    UEFI_VARIABLE_DATA *Var = (UEFI_VARIABLE_DATA *) Event->Event;
+    UINTN              Header = OFFSET_OF(UEFI_VARIABLE_DATA, UnicodeName);
+    UINTN              NameLength;
+    UINTN              DataLength;
+    UINT8              *Data;
+    CHAR16             Name[MAX_NAME_LENGTH + 1];
+    EFI_GUID           Guid;
+    EFI_GUID           GlobalVariable = EFI_GLOBAL_VARIABLE;
+
+    if (Event->EventSize < Header ||
+        Var->UnicodeNameLength > (Event->EventSize - Header) / sizeof(CHAR16) ||
+        Var->VariableDataLength > Event->EventSize - Header - Var->UnicodeNameLength * sizeof(CHAR16)) {
+        DecodeMalformed(Json);
+        return;
+    }
+    NameLength = (UINTN) Var->UnicodeNameLength;
+    DataLength = (UINTN) Var->VariableDataLength;
+    Data = Event->Event + Header + NameLength * sizeof(CHAR16);
+
+    CopyMem(&Guid, &Var->VariableName, sizeof(EFI_GUID));
+    CopyMem(Name, Var->UnicodeName, MIN(NameLength, MAX_NAME_LENGTH) * sizeof(CHAR16));
+    Name[MIN(NameLength, MAX_NAME_LENGTH)] = 0;
+
+    if (Json) {
+        JsonGuid(L"variableGuid", &Guid);
+        JsonString(L"variableName", Name);
+        JsonUint(L"dataLength", DataLength);
+    } else {
+        OutputPrint(L"    Variable GUID: %g\n", &Guid);
+        OutputPrint(L"    Variable Name: %s\n", Name);
+        OutputPrint(L"      Data Length: %d\n", DataLength);
+    }
+
+    if (Event->EventType == EV_EFI_VARIABLE_AUTHORITY) {
+        DecodeSignatureOwner(Data, DataLength, Json);
+    } else if (CompareGuid(&Guid, &GlobalVariable)) {
+        if (IsBootOption(Name)) {
+            DecodeLoadOption(Data, DataLength, Json);
+        } else if (!StrCmp(Name, L"BootOrder")) {
+            DecodeBootOrder(Data, DataLength, Json);
+        }
+    }
+}
+
+
+//
+// EFI_IMAGE_LOAD_EVENT (UEFI_IMAGE_LOAD_EVENT in the TCG specification):
+// EV_EFI_BOOT_SERVICES_APPLICATION, _DRIVER and EV_EFI_RUNTIME_SERVICES_DRIVER
+//
+static VOID
+DecodeImageLoad( LOG_EVENT *Event,
+                 BOOLEAN Json )
+{
+    EFI_IMAGE_LOAD_EVENT *Image = (EFI_IMAGE_LOAD_EVENT *) Event->Event;
+    UINTN                Header = OFFSET_OF(EFI_IMAGE_LOAD_EVENT, DevicePath);
+
+    if (Event->EventSize < Header ||
+        Image->LengthOfDevicePath > Event->EventSize - Header) {
+        DecodeMalformed(Json);
+        return;
+    }
+
+    if (Json) {
+        JsonHex(L"imageAddress", Image->ImageLocationInMemory);
+        JsonUint(L"imageLength", Image->ImageLengthInMemory);
+        JsonHex(L"linkTimeAddress", Image->ImageLinkTimeAddress);
+    } else {
+        OutputPrint(L"    Image Address: 0x%lx\n", Image->ImageLocationInMemory);
+        OutputPrint(L"     Image Length: %ld\n", (UINT64) Image->ImageLengthInMemory);
+        OutputPrint(L"     Link Address: 0x%lx\n", (UINT64) Image->ImageLinkTimeAddress);
+    }
+    DecodeDevicePath(Image->DevicePath, Image->LengthOfDevicePath, Json);
+}
+
+
+//
+// EFI_GPT_DATA: the GPT header followed by the partitions in use, each
+// SizeOfPartitionEntry bytes apart
+//
+static VOID
+DecodeGpt( LOG_EVENT *Event,
+           BOOLEAN Json )
+{
+    EFI_GPT_DATA        *Gpt = (EFI_GPT_DATA *) Event->Event;
+    EFI_PARTITION_ENTRY Entry;
+    UINTN               Header = OFFSET_OF(EFI_GPT_DATA, Partitions);
+    UINTN               EntrySize;
+    UINTN               Count;
+    CHAR16              Name[ARRAY_SIZE(Entry.PartitionName) + 1];
+
+    if (Event->EventSize < Header) {
+        DecodeMalformed(Json);
+        return;
+    }
+    EntrySize = Gpt->EfiPartitionHeader.SizeOfPartitionEntry;
+    Count = (UINTN) Gpt->NumberOfPartitions;
+    if (EntrySize < sizeof(EFI_PARTITION_ENTRY) ||
+        Count > (Event->EventSize - Header) / EntrySize) {
+        DecodeMalformed(Json);
+        return;
+    }
+
+    if (Json) {
+        JsonGuid(L"diskGuid", &Gpt->EfiPartitionHeader.DiskGUID);
+        JsonUint(L"partitionCount", Count);
+        JsonArrayBegin(L"partitions");
+    } else {
+        OutputPrint(L"        Disk GUID: %g\n", &Gpt->EfiPartitionHeader.DiskGUID);
+        OutputPrint(L"       Partitions: %d\n", Count);
+    }
+
+    for (UINTN i = 0; i < Count; i++) {
+        CopyMem(&Entry, (UINT8 *) Gpt->Partitions + i * EntrySize, sizeof(Entry));
+        CopyMem(Name, Entry.PartitionName, sizeof(Entry.PartitionName));
+        Name[ARRAY_SIZE(Entry.PartitionName)] = 0;
+
+        if (Json) {
+            JsonObjectBegin(NULL);
+            JsonGuid(L"typeGuid", &Entry.PartitionTypeGUID);
+            JsonGuid(L"uniqueGuid", &Entry.UniquePartitionGUID);
+            JsonUint(L"startingLba", Entry.StartingLBA);
+            JsonUint(L"endingLba", Entry.EndingLBA);
+            JsonHex(L"attributes", Entry.Attributes);
+            JsonString(L"name", Name);
+            JsonObjectEnd();
+        } else {
+            OutputPrint(L"      Partition %d: %g LBA %ld-%ld %s\n", i + 1,
+                        &Entry.PartitionTypeGUID, Entry.StartingLBA, Entry.EndingLBA, Name);
+        }
+    }
+
+    if (Json) {
+        JsonArrayEnd();
+    }
+}
+
+
+//
+// EV_EFI_PLATFORM_FIRMWARE_BLOB: base and length of a firmware volume
+//
+static VOID
+DecodeFirmwareBlob( LOG_EVENT *Event,
+                    BOOLEAN Json )
+{
+    EFI_PLATFORM_FIRMWARE_BLOB Blob;
+
+    if (Event->EventSize < sizeof(Blob)) {
+        DecodeMalformed(Json);
+        return;
+    }
+    CopyMem(&Blob, Event->Event, sizeof(Blob));
+
+    if (Json) {
+        JsonHex(L"blobBase", Blob.BlobBase);
+        JsonUint(L"blobLength", Blob.BlobLength);
+    } else {
+        OutputPrint(L"        Blob Base: 0x%lx\n", Blob.BlobBase);
+        OutputPrint(L"      Blob Length: %ld\n", Blob.BlobLength);
+    }
+}
+
+
+//
+// EV_EFI_HANDOFF_TABLES: the configuration tables (normally SMBIOS)
+// handed to the OS
+//
+static VOID
+DecodeHandoffTables( LOG_EVENT *Event,
+                     BOOLEAN Json )
+{
+    EFI_HANDOFF_TABLE_POINTERS *Tables = (EFI_HANDOFF_TABLE_POINTERS *) Event->Event;
+    EFI_CONFIGURATION_TABLE    Table;
+    UINTN                      Header = OFFSET_OF(EFI_HANDOFF_TABLE_POINTERS, TableEntry);
+    UINTN                      Count;
+
+    if (Event->EventSize < Header ||
+        Tables->NumberOfTables > (Event->EventSize - Header) / sizeof(EFI_CONFIGURATION_TABLE)) {
+        DecodeMalformed(Json);
+        return;
+    }
+    Count = Tables->NumberOfTables;
+
+    if (Json) {
+        JsonArrayBegin(L"tables");
+    }
+    for (UINTN i = 0; i < Count; i++) {
+        CopyMem(&Table, &Tables->TableEntry[i], sizeof(Table));
+        if (Json) {
+            JsonObjectBegin(NULL);
+            JsonGuid(L"guid", &Table.VendorGuid);
+            JsonHex(L"address", (UINTN) Table.VendorTable);
+            JsonObjectEnd();
+        } else {
+            OutputPrint(L"            Table: %g at 0x%lx\n", &Table.VendorGuid, (UINT64)(UINTN) Table.VendorTable);
+        }
+    }
+    if (Json) {
+        JsonArrayEnd();
+    }
+}
+
+
+//
+// EV_ACTION and EV_EFI_ACTION: ASCII string without a terminator
+//
+static VOID
+DecodeAction( LOG_EVENT *Event,
+              BOOLEAN Json )
+{
+    CHAR8 Action[MAX_STRING_LENGTH + 1];
+    UINTN Length = MIN(Event->EventSize, MAX_STRING_LENGTH);
+
+    CopyMem(Action, Event->Event, Length);
+    Action[Length] = 0;
+
+    if (Json) {
+        JsonAsciiString(L"action", Action, Length);
+    } else {
+        OutputPrint(L"           Action: %a\n", Action);
+    }
+}
+
+
+//
+// EV_S_CRTM_VERSION: UCS-2 firmware version string
+//
+static VOID
+DecodeCrtmVersion( LOG_EVENT *Event,
+                   BOOLEAN Json )
+{
+    CHAR16 Version[MAX_STRING_LENGTH + 1];
+    UINTN  Length = MIN(Event->EventSize / sizeof(CHAR16), MAX_STRING_LENGTH);
+
+    CopyMem(Version, Event->Event, Length * sizeof(CHAR16));
+    Version[Length] = 0;
+
+    if (Json) {
+        JsonString(L"version", Version);
+    } else {
+        OutputPrint(L"     CRTM Version: %s\n", Version);
+    }
+}
+
+
+static VOID
+DecodeSeparator( LOG_EVENT *Event,
+                 BOOLEAN Json )
+{
+    UINT32 Value;
+
+    if (Event->EventSize < sizeof(UINT32)) {
+        DecodeMalformed(Json);
+        return;
+    }
+    CopyMem(&Value, Event->Event, sizeof(UINT32));
+
+    if (Json) {
+        JsonHex(L"separator", Value);
+    } else {
+        OutputPrint(L"        Separator: 0x%08x%s\n", Value, Value == 0 ? L"" : L" (error)");
+    }
+}
+
+
+//
+// EV_NO_ACTION events start with a 16 byte signature, e.g. "Spec ID Event03"
+// or "StartupLocality"
+//
+static VOID
+DecodeNoAction( LOG_EVENT *Event,
+                BOOLEAN Json )
+{
+    UINTN Length = 0;
+
+    if (Event->EventSize < 16) {
+        DecodeMalformed(Json);
+        return;
+    }
+    while (Length < 16 && Event->Event[Length] != 0) {
+        Length++;
+    }
+
+    if (Json) {
+        JsonAsciiString(L"signature", (CHAR8 *) Event->Event, Length);
+    } else {
+        OutputPrint(L"        Signature: ");
+        for (UINTN i = 0; i < Length; i++) {
+            OutputPrint(L"%c", Event->Event[i]);
+        }
+        OutputPrint(L"\n");
+    }
+}
+
+
+STATIC EVENT_TYPE_INFO EventTypes[] = {
+    { EV_PREBOOT_CERT,                   L"EV_PREBOOT_CERT",                   L"Preboot Cert",              NULL },
+    { EV_POST_CODE,                      L"EV_POST_CODE",                      L"Post Code",                 NULL },
+    { EV_NO_ACTION,                      L"EV_NO_ACTION",                      L"No Action",                 DecodeNoAction },
+    { EV_SEPARATOR,                      L"EV_SEPARATOR",                      L"Separator",                 DecodeSeparator },
+    { EV_ACTION,                         L"EV_ACTION",                         L"Action String",             DecodeAction },
+    { EV_EVENT_TAG,                      L"EV_EVENT_TAG",                      L"Event Tag",                 NULL },
+    { EV_S_CRTM_CONTENTS,                L"EV_S_CRTM_CONTENTS",                L"CTRM Contents",             NULL },
+    { EV_S_CRTM_VERSION,                 L"EV_S_CRTM_VERSION",                 L"CRTM Version",              DecodeCrtmVersion },
+    { EV_CPU_MICROCODE,                  L"EV_CPU_MICROCODE",                  L"CPU Microcode",             NULL },
+    { EV_PLATFORM_CONFIG_FLAGS,          L"EV_PLATFORM_CONFIG_FLAGS",          L"Platform Config Flags",     NULL },
+    { EV_TABLE_OF_DEVICES,               L"EV_TABLE_OF_DEVICES",               L"Table of Devices",          NULL },
+    { EV_COMPACT_HASH,                   L"EV_COMPACT_HASH",                   L"Compact Hash",              NULL },
+    { EV_NONHOST_CODE,                   L"EV_NONHOST_CODE",                   L"Non-host Code",             NULL },
+    { EV_NONHOST_CONFIG,                 L"EV_NONHOST_CONFIG",                 L"Non-host Config",           NULL },
+    { EV_NONHOST_INFO,                   L"EV_NONHOST_INFO",                   L"Non-host Info",             NULL },
+    { EV_OMIT_BOOT_DEVICE_EVENTS,        L"EV_OMIT_BOOT_DEVICE_EVENTS",        L"Omit Boot Device Events",   NULL },
+    { EV_EFI_VARIABLE_DRIVER_CONFIG,     L"EV_EFI_VARIABLE_DRIVER_CONFIG",     L"Variable Driver Config",    DecodeVariable },
+    { EV_EFI_VARIABLE_BOOT,              L"EV_EFI_VARIABLE_BOOT",              L"Variable Boot",             DecodeVariable },
+    { EV_EFI_BOOT_SERVICES_APPLICATION,  L"EV_EFI_BOOT_SERVICES_APPLICATION",  L"Boot Services Application", DecodeImageLoad },
+    { EV_EFI_BOOT_SERVICES_DRIVER,       L"EV_EFI_BOOT_SERVICES_DRIVER",       L"Boot Services Driver",      DecodeImageLoad },
+    { EV_EFI_RUNTIME_SERVICES_DRIVER,    L"EV_EFI_RUNTIME_SERVICES_DRIVER",    L"Runtime Services Driver",   DecodeImageLoad },
+    { EV_EFI_GPT_EVENT,                  L"EV_EFI_GPT_EVENT",                  L"GPT Event",                 DecodeGpt },
+    { EV_EFI_ACTION,                     L"EV_EFI_ACTION",                     L"Action",                    DecodeAction },
+    { EV_EFI_PLATFORM_FIRMWARE_BLOB,     L"EV_EFI_PLATFORM_FIRMWARE_BLOB",     L"Platform Fireware Blob",    DecodeFirmwareBlob },
+    { EV_EFI_HANDOFF_TABLES,             L"EV_EFI_HANDOFF_TABLES",             L"Handoff Tables",            DecodeHandoffTables },
+    { EV_EFI_VARIABLE_AUTHORITY,         L"EV_EFI_VARIABLE_AUTHORITY",         L"Variable Authority",        DecodeVariable },
+    { 0,                                 NULL,                                 L"Unknown Type",              NULL }
+};
+
+
+//
+// Table entry for EventType; the terminating entry if it is not known
+//
+CONST EVENT_TYPE_INFO *
+EventTypeInfo( UINT32 EventType )
+{
+    UINTN i;
+
+    for (i = 0; EventTypes[i].Name != NULL; i++) {
+        if (EventTypes[i].Type == EventType) {
+            break;
+        }
+    }
+
+    return &EventTypes[i];
+}
+
+
+CONST CHAR16 *
+EventTypeStr( UINT32 EventType )
+{
+    return EventTypeInfo(EventType)->Description;
+}
+
+
+//
+// TCG event type name (EV_...) or hex value
+//
+BOOLEAN
+EventTypeFromStr( CHAR16 *Str,
+                  UINT32 *EventType )
+{
+    for (UINTN i = 0; EventTypes[i].Name != NULL; i++) {
+        if (!StrCmp(Str, EventTypes[i].Name)) {
+            *EventType = EventTypes[i].Type;
+            return TRUE;
+        }
+    }
+    if (Str[0] == L'0' && (Str[1] == L'x' || Str[1] == L'X')) {
+        *EventType = (UINT32) StrHexToUintn(Str);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+
+//
+// Decoded fields of the event data as text lines, or as members of the
+// current JSON object.  FALSE if there is no decoder for the type.
+//
+BOOLEAN
+DecodeEvent( LOG_EVENT *Event,
+             BOOLEAN Json )
+{
+    CONST EVENT_TYPE_INFO *Info = EventTypeInfo(Event->EventType);
+
+    if (Info->Decode == NULL) {
+        return FALSE;
+    }
+    Info->Decode(Event, Json);
+
+    return TRUE;
+}
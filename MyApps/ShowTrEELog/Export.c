@@ -0,0 +1,84 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  ShowTrEELog binary export.  The file has the same layout as Linux's
+//  /sys/kernel/security/tpm0/binary_bios_measurements: the log records
+//  exactly as the firmware wrote them, followed (TCG 2.0 only) by any
+//  Final Events table records that are not already in the log, which is
+//  what the kernel appends after ExitBootServices.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+
+#include "ShowTrEELog.h"
+
+
+EFI_STATUS
+ExportLog( EVENT_LOG *Log,
+           CONST CHAR16 *FileName,
+           BOOLEAN Json )
+{
+    OUTPUT_FILE File;
+    EFI_STATUS  Status;
+    UINT8       *Late;
+    UINT8       *Data;
+    UINT64      LateCount;
+    UINTN       LogBytes;
+    UINTN       LateBytes;
+
+    LogBytes = LogSize(Log);
+    if (LogBytes == 0) {
+        JsonError(L"Event log is empty");
+        return EFI_NOT_FOUND;
+    }
+    LateBytes = LogLateEvents(Log, &Late, &LateCount);
+
+    // one contiguous image so the file goes out in a single write
+    Data = Log->Location;
+    if (LateBytes > 0) {
+        Data = AllocatePool(LogBytes + LateBytes);
+        if (Data == NULL) {
+            JsonError(L"Out of memory");
+            return EFI_OUT_OF_RESOURCES;
+        }
+        CopyMem(Data, Log->Location, LogBytes);
+        CopyMem(Data + LogBytes, Late, LateBytes);
+    }
+
+    Status = OutputFileOpen(&File, FileName);
+    if (!EFI_ERROR(Status)) {
+        OutputFileWrite(&File, Data, LogBytes + LateBytes);
+        Status = OutputFileClose(&File);
+    }
+    if (Data != Log->Location) {
+        FreePool(Data);
+    }
+
+    if (EFI_ERROR(Status)) {
+        JsonError(L"Writing %s [%d]", FileName, Status);
+        return Status;
+    }
+
+    if (Json) {
+        JsonObjectBegin(L"export");
+        JsonString(L"file", FileName);
+        JsonUint(L"bytes", LogBytes + LateBytes);
+        JsonUint(L"finalEvents", LateCount);
+        JsonObjectEnd();
+    } else {
+        OutputPrint(L"Exported %d bytes to %s", LogBytes + LateBytes, FileName);
+        if (LateCount > 0) {
+            OutputPrint(L" (including %ld Final Events table records)", LateCount);
+        }
+        OutputPrint(L"\n");
+    }
+
+    return EFI_SUCCESS;
+}
@@ -0,0 +1,116 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  ShowTrEELog event index.  One walk of the log records where each
+//  event is, its PCR and type, and the leading bytes of each digest.
+//  Filters are answered from the index; a record is only parsed again
+//  when it matches (or a long digest has to be confirmed).
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#include "ShowTrEELog.h"
+
+#define INDEX_CHUNK  1024                  // entries added per reallocation
+
+
+EFI_STATUS
+IndexBuild( EVENT_LOG *Log,
+            LOG_INDEX *Index )
+{
+    LOG_INDEX_ENTRY *Entry;
+    LOG_INDEX_ENTRY *Grown;
+    LOG_EVENT       Event;
+    UINTN           Allocated = 0;
+    BOOLEAN         More;
+
+    ZeroMem(Index, sizeof(LOG_INDEX));
+
+    for (More = LogFirst(Log, &Event); More; More = LogNext(Log, &Event)) {
+        if (Index->Count == Allocated) {
+            Grown = ReallocatePool( Allocated * sizeof(LOG_INDEX_ENTRY),
+                                    (Allocated + INDEX_CHUNK) * sizeof(LOG_INDEX_ENTRY),
+                                    Index->Entries );
+            if (Grown == NULL) {
+                IndexFree(Index);
+                return EFI_OUT_OF_RESOURCES;
+            }
+            Index->Entries = Grown;
+            Allocated += INDEX_CHUNK;
+        }
+
+        Entry = &Index->Entries[Index->Count++];
+        Entry->Offset = (UINT32) (Event.Record - Log->Location);
+        Entry->PcrIndex = Event.PcrIndex;
+        Entry->EventType = Event.EventType;
+        Entry->DigestCount = (UINT8) Event.DigestCount;
+        for (UINT32 i = 0; i < Event.DigestCount; i++) {
+            CopyMem(Entry->Prefix[i], Event.Digests[i].Digest, INDEX_PREFIX_SIZE);
+        }
+    }
+    Index->Bad = Log->Bad;
+
+    return EFI_SUCCESS;
+}
+
+
+VOID
+IndexFree( LOG_INDEX *Index )
+{
+    if (Index->Entries != NULL) {
+        FreePool(Index->Entries);
+    }
+    ZeroMem(Index, sizeof(LOG_INDEX));
+}
+
+
+//
+// TRUE if Entry passes every filter that is set, in which case Event is
+// filled in from the record for printing
+//
+BOOLEAN
+IndexMatch( EVENT_LOG *Log,
+            LOG_INDEX_ENTRY *Entry,
+            LOG_FILTER *Filter,
+            LOG_EVENT *Event )
+{
+    UINTN   Prefix = MIN(Filter->DigestSize, INDEX_PREFIX_SIZE);
+    BOOLEAN Found = FALSE;
+
+    if (Filter->ByPcr && Entry->PcrIndex != Filter->PcrIndex) {
+        return FALSE;
+    }
+    if (Filter->ByType && Entry->EventType != Filter->EventType) {
+        return FALSE;
+    }
+    if (Filter->DigestSize > 0) {
+        for (UINT8 i = 0; i < Entry->DigestCount && !Found; i++) {
+            Found = CompareMem(Entry->Prefix[i], Filter->Digest, Prefix) == 0;
+        }
+        if (!Found) {
+            return FALSE;
+        }
+    }
+
+    if (!LogEventAt(Log, Entry->Offset, Event)) {
+        return FALSE;
+    }
+    if (Filter->DigestSize <= INDEX_PREFIX_SIZE) {
+        return TRUE;
+    }
+
+    // the prefix only narrowed it down
+    for (UINT32 i = 0; i < Event->DigestCount; i++) {
+        if (Event->Digests[i].Size >= Filter->DigestSize &&
+            CompareMem(Event->Digests[i].Digest, Filter->Digest, Filter->DigestSize) == 0) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
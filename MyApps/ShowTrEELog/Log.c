@@ -0,0 +1,382 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  ShowTrEELog event log access.  The TCG2 protocol is preferred since
+//  it can return the crypto-agile (TCG 2.0) log; TrEE only ever returns
+//  the SHA-1 (TCG 1.2) log.
+//
+//  Once GetEventLog has been called, the firmware also records each new
+//  event in the TCG2 Final Events table.  The main log keeps growing as
+//  well, so only events added to the Final Events table after the log
+//  was fetched are missing from it.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/TpmCommandLib.h>
+
+#include "ShowTrEELog.h"
+
+typedef struct {
+    TPMI_ALG_HASH AlgId;
+    CHAR16        *Name;
+} ALGORITHM_NAME;
+
+STATIC ALGORITHM_NAME AlgorithmNames[] = {
+    { TPM_ALG_SHA1,    L"SHA1" },
+    { TPM_ALG_SHA256,  L"SHA256" },
+    { TPM_ALG_SHA384,  L"SHA384" },
+    { TPM_ALG_SHA512,  L"SHA512" },
+    { TPM_ALG_SM3_256, L"SM3_256" },
+    { TPM_ALG_NULL,    L"Unknown" }
+};
+
+
+CONST CHAR16 *
+LogAlgorithmName( TPMI_ALG_HASH AlgId )
+{
+    UINTN i;
+
+    for (i = 0; AlgorithmNames[i].AlgId != TPM_ALG_NULL; i++) {
+        if (AlgorithmNames[i].AlgId == AlgId) {
+            break;
+        }
+    }
+
+    return AlgorithmNames[i].Name;
+}
+
+
+static UINT16
+AlgorithmSize( EVENT_LOG *Log,
+               TPMI_ALG_HASH AlgId )
+{
+    for (UINT32 i = 0; i < Log->AlgorithmCount; i++) {
+        if (Log->Algorithms[i].AlgId == AlgId) {
+            return Log->Algorithms[i].Size;
+        }
+    }
+
+    return 0;
+}
+
+
+//
+// TCG_PCR_EVENT layout: used for every record of a TCG 1.2 log and
+// for the first (Spec ID) record of a TCG 2.0 log
+//
+static BOOLEAN
+ParseEvent12( UINT8 *Record,
+              LOG_EVENT *Event )
+{
+    TCG_PCR_EVENT *Event12 = (TCG_PCR_EVENT *) Record;
+
+    if (Event12->EventSize > MAX_EVENT_SIZE) {
+        return FALSE;
+    }
+
+    Event->PcrIndex = Event12->PCRIndex;
+    Event->EventType = Event12->EventType;
+    Event->DigestCount = 1;
+    Event->Digests[0].AlgId = TPM_ALG_SHA1;
+    Event->Digests[0].Size = SHA1_DIGEST_SIZE;
+    Event->Digests[0].Digest = Event12->Digest.digest;
+    Event->EventSize = Event12->EventSize;
+    Event->Event = Record + sizeof(TCG_PCR_EVENT_HDR);
+    Event->RecordSize = sizeof(TCG_PCR_EVENT_HDR) + Event12->EventSize;
+
+    return TRUE;
+}
+
+
+//
+// TCG_PCR_EVENT2 layout.  Digest sizes are not in the record, they
+// come from the Spec ID event, so an unknown algorithm ends the walk.
+//
+static BOOLEAN
+ParseEvent2( EVENT_LOG *Log,
+             UINT8 *Record,
+             LOG_EVENT *Event )
+{
+    UINT8  *Ptr = Record;
+    UINT32 Count;
+
+    Event->PcrIndex = ReadUnaligned32((UINT32 *) Ptr);
+    Event->EventType = ReadUnaligned32((UINT32 *) (Ptr + 4));
+    Count = ReadUnaligned32((UINT32 *) (Ptr + 8));
+    Ptr += 12;
+    if (Count > MAX_LOG_ALGORITHMS) {
+        return FALSE;
+    }
+
+    Event->DigestCount = Count;
+    for (UINT32 i = 0; i < Count; i++) {
+        Event->Digests[i].AlgId = ReadUnaligned16((UINT16 *) Ptr);
+        Event->Digests[i].Size = AlgorithmSize(Log, Event->Digests[i].AlgId);
+        if (Event->Digests[i].Size == 0) {
+            return FALSE;
+        }
+        Event->Digests[i].Digest = Ptr + sizeof(TPMI_ALG_HASH);
+        Ptr += sizeof(TPMI_ALG_HASH) + Event->Digests[i].Size;
+    }
+
+    Event->EventSize = ReadUnaligned32((UINT32 *) Ptr);
+    if (Event->EventSize > MAX_EVENT_SIZE) {
+        return FALSE;
+    }
+    Event->Event = Ptr + sizeof(UINT32);
+    Event->RecordSize = (UINT32) (Event->Event + Event->EventSize - Record);
+
+    return TRUE;
+}
+
+
+//
+// Pick up the digest sizes from the TCG_EfiSpecIDEventStruct that
+// starts a TCG 2.0 log
+//
+static EFI_STATUS
+ParseSpecId( EVENT_LOG *Log )
+{
+    TCG_EfiSpecIDEventStruct        *SpecId;
+    TCG_EfiSpecIdEventAlgorithmSize *Sizes;
+    LOG_EVENT                       Event;
+
+    if (!ParseEvent12(Log->Location, &Event) ||
+        Event.EventType != EV_NO_ACTION ||
+        Event.EventSize < sizeof(TCG_EfiSpecIDEventStruct)) {
+        return EFI_COMPROMISED_DATA;
+    }
+
+    SpecId = (TCG_EfiSpecIDEventStruct *) Event.Event;
+    if (CompareMem(SpecId->signature, TCG_EfiSpecIDEventStruct_SIGNATURE_03,
+                   sizeof(TCG_EfiSpecIDEventStruct_SIGNATURE_03)) != 0 ||
+        SpecId->numberOfAlgorithms == 0 ||
+        SpecId->numberOfAlgorithms > MAX_LOG_ALGORITHMS ||
+        Event.EventSize < sizeof(TCG_EfiSpecIDEventStruct) +
+                          SpecId->numberOfAlgorithms * sizeof(TCG_EfiSpecIdEventAlgorithmSize)) {
+        return EFI_COMPROMISED_DATA;
+    }
+
+    Log->SpecMajor = SpecId->specVersionMajor;
+    Log->SpecMinor = SpecId->specVersionMinor;
+    Log->SpecErrata = SpecId->specErrata;
+    Log->AlgorithmCount = SpecId->numberOfAlgorithms;
+
+    Sizes = (TCG_EfiSpecIdEventAlgorithmSize *) (SpecId + 1);
+    for (UINT32 i = 0; i < Log->AlgorithmCount; i++) {
+        Log->Algorithms[i].AlgId = ReadUnaligned16(&Sizes[i].algorithmId);
+        Log->Algorithms[i].Size = ReadUnaligned16(&Sizes[i].digestSize);
+        if (Log->Algorithms[i].Size == 0 || Log->Algorithms[i].Size > sizeof(TPMU_HA)) {
+            return EFI_COMPROMISED_DATA;
+        }
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+static VOID
+FindFinalEvents( EVENT_LOG *Log )
+{
+    EFI_CONFIGURATION_TABLE *ect = gST->ConfigurationTable;
+    EFI_GUID FinalEventsGuid = EFI_TCG2_FINAL_EVENTS_TABLE_GUID;
+
+    for (UINTN i = 0; i < gST->NumberOfTableEntries; i++, ect++) {
+        if (CompareGuid(&ect->VendorGuid, &FinalEventsGuid)) {
+            Log->FinalEvents = (EFI_TCG2_FINAL_EVENTS_TABLE *) ect->VendorTable;
+            Log->FinalEventsAtOpen = Log->FinalEvents->NumberOfEvents;
+            return;
+        }
+    }
+}
+
+
+//
+// Locate TCG2 (or failing that TrEE) and fetch the log in the best
+// format it offers
+//
+EFI_STATUS
+LogOpen( EVENT_LOG *Log )
+{
+    EFI_TCG2_BOOT_SERVICE_CAPABILITY Capability;
+    EFI_PHYSICAL_ADDRESS LogLocation = 0;
+    EFI_PHYSICAL_ADDRESS LogLastEntry = 0;
+    EFI_STATUS Status;
+
+    ZeroMem(Log, sizeof(EVENT_LOG));
+
+    TpmOpen(NULL);
+    Log->Tcg2 = TpmTcg2();
+    Log->TrEE = TpmTrEE();
+    if (Log->Tcg2 != NULL) {
+        ZeroMem(&Capability, sizeof(Capability));
+        Capability.Size = (UINT8) sizeof(Capability);
+        Log->Format = EFI_TCG2_EVENT_LOG_FORMAT_TCG_1_2;
+        if (!EFI_ERROR(Log->Tcg2->GetCapability(Log->Tcg2, &Capability)) &&
+            (Capability.SupportedEventLogs & EFI_TCG2_EVENT_LOG_FORMAT_TCG_2)) {
+            Log->Format = EFI_TCG2_EVENT_LOG_FORMAT_TCG_2;
+        }
+        Status = Log->Tcg2->GetEventLog( Log->Tcg2,
+                                         Log->Format,
+                                         &LogLocation,
+                                         &LogLastEntry,
+                                         &Log->Truncated );
+    } else {
+        if (Log->TrEE == NULL) {
+            return EFI_NOT_FOUND;
+        }
+        Log->Format = EFI_TCG2_EVENT_LOG_FORMAT_TCG_1_2;
+        Status = Log->TrEE->GetEventLog( Log->TrEE,
+                                         TREE_EVENT_LOG_FORMAT_TCG_1_2,
+                                         &LogLocation,
+                                         &LogLastEntry,
+                                         &Log->Truncated );
+    }
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+
+    Log->Location = (UINT8 *)(UINTN) LogLocation;
+    Log->LastEntry = (UINT8 *)(UINTN) LogLastEntry;
+
+    if (Log->Format == EFI_TCG2_EVENT_LOG_FORMAT_TCG_2) {
+        if (Log->Location == NULL) {
+            return EFI_NOT_FOUND;
+        }
+        FindFinalEvents(Log);
+        return ParseSpecId(Log);
+    }
+
+    Log->SpecMajor = 1;
+    Log->SpecMinor = 2;
+    Log->AlgorithmCount = 1;
+    Log->Algorithms[0].AlgId = TPM_ALG_SHA1;
+    Log->Algorithms[0].Size = SHA1_DIGEST_SIZE;
+
+    return EFI_SUCCESS;
+}
+
+
+BOOLEAN
+LogFirst( EVENT_LOG *Log,
+          LOG_EVENT *Event )
+{
+    Log->Next = Log->Location;
+    Log->Bad = FALSE;
+
+    return LogNext(Log, Event);
+}
+
+
+//
+// Fill in Event from the record at the walk position and step past it.
+// Returns FALSE after the last record or at a malformed one (Log->Bad).
+//
+BOOLEAN
+LogNext( EVENT_LOG *Log,
+         LOG_EVENT *Event )
+{
+    UINT8   *Record = Log->Next;
+    BOOLEAN Parsed;
+
+    if (Record == NULL || Log->LastEntry == NULL || Record > Log->LastEntry) {
+        return FALSE;
+    }
+
+    Parsed = LogEventAt(Log, (UINT32) (Record - Log->Location), Event);
+
+    Log->Next = Record + Event->RecordSize;
+    if (!Parsed || (Record != Log->LastEntry && Log->Next > Log->LastEntry)) {
+        Log->Bad = TRUE;
+        Log->Next = NULL;
+        return FALSE;
+    }
+    if (Record == Log->LastEntry) {
+        Log->Next = NULL;
+    }
+
+    return TRUE;
+}
+
+
+//
+// The record Offset bytes into the log, as found by an earlier walk
+//
+BOOLEAN
+LogEventAt( EVENT_LOG *Log,
+            UINT32 Offset,
+            LOG_EVENT *Event )
+{
+    UINT8 *Record = Log->Location + Offset;
+
+    if (Log->Location == NULL || Log->LastEntry == NULL || Record > Log->LastEntry) {
+        return FALSE;
+    }
+
+    ZeroMem(Event, sizeof(LOG_EVENT));
+    Event->Record = Record;
+    if (Log->Format == EFI_TCG2_EVENT_LOG_FORMAT_TCG_2 && Offset != 0) {
+        return ParseEvent2(Log, Record, Event);
+    }
+
+    return ParseEvent12(Record, Event);
+}
+
+
+//
+// Bytes from the start of the log to the end of the last record
+//
+UINTN
+LogSize( EVENT_LOG *Log )
+{
+    LOG_EVENT Event;
+
+    if (Log->Location == NULL || Log->LastEntry == NULL ||
+        !LogEventAt(Log, (UINT32) (Log->LastEntry - Log->Location), &Event)) {
+        return 0;
+    }
+
+    return (UINTN) (Log->LastEntry + Event.RecordSize - Log->Location);
+}
+
+
+//
+// TCG_PCR_EVENT2 records added to the Final Events table after the log
+// was fetched.  Returns their size in bytes; they are contiguous from
+// *Start.
+//
+UINTN
+LogLateEvents( EVENT_LOG *Log,
+               UINT8 **Start,
+               UINT64 *Count )
+{
+    LOG_EVENT Event;
+    UINT8     *Record;
+
+    *Start = NULL;
+    *Count = 0;
+    if (Log->FinalEvents == NULL || Log->FinalEvents->NumberOfEvents <= Log->FinalEventsAtOpen) {
+        return 0;
+    }
+
+    Record = (UINT8 *) Log->FinalEvents->Event;
+    for (UINT64 i = 0; i < Log->FinalEvents->NumberOfEvents; i++) {
+        if (i == Log->FinalEventsAtOpen) {
+            *Start = Record;
+        }
+        if (!ParseEvent2(Log, Record, &Event)) {
+            break;
+        }
+        Record += Event.RecordSize;
+        if (*Start != NULL) {
+            (*Count)++;
+        }
+    }
+
+    return *Start != NULL ? (UINTN) (Record - *Start) : 0;
+}
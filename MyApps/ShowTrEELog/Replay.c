@@ -0,0 +1,334 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  ShowTrEELog PCR replay.  Every measured event in the log is extended
+//  into a virtual PCR bank for each algorithm in the log, and the result
+//  is compared with the TPM's live PCRs.  A difference means either the
+//  log or the PCRs have been tampered with (or an event was not logged).
+//
+//  License: UDK2017 license applies to code from UDK2017 sources,
+//           BSD 2 clause license applies to all other code.
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/HexDumpLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/DigestLib.h>
+#include <Library/TpmInfoLib.h>
+
+#include "ShowTrEELog.h"
+
+typedef VOID (EFIAPI *HASH_FUNCTION)( CONST VOID *Data, UINTN Size, UINT8 *Digest );
+
+typedef struct {
+    TPMI_ALG_HASH AlgId;
+    UINT16        Size;
+    HASH_FUNCTION Hash;                    // NULL if DigestLib lacks it
+    BOOLEAN       LiveRead;                // live PCRs read into Live
+    EFI_STATUS    LiveStatus;              // why not; EFI_UNSUPPORTED if not allocated
+    UINT32        Missing;                 // events without this digest
+    UINT32        Events[MAX_PCR];
+    UINT8         Replayed[MAX_PCR][sizeof(TPMU_HA)];
+    UINT8         Live[MAX_PCR][sizeof(TPMU_HA)];
+} REPLAY_BANK;
+
+STATIC REPLAY_BANK Banks[MAX_LOG_ALGORITHMS];
+
+
+static HASH_FUNCTION
+HashFunction( TPMI_ALG_HASH AlgId )
+{
+    switch (AlgId) {
+        case TPM_ALG_SHA1:   return DigestSha1;
+        case TPM_ALG_SHA256: return DigestSha256;
+        case TPM_ALG_SHA384: return DigestSha384;
+        case TPM_ALG_SHA512: return DigestSha512;
+        default:             return NULL;
+    }
+}
+
+
+//
+// PCRs 17-22 are the DRTM PCRs and reset to all ones; the rest to zero
+//
+static VOID
+ResetBank( REPLAY_BANK *Bank )
+{
+    ZeroMem(Bank->Replayed, sizeof(Bank->Replayed));
+    for (UINT32 Pcr = 17; Pcr <= 22; Pcr++) {
+        SetMem(Bank->Replayed[Pcr], Bank->Size, 0xff);
+    }
+}
+
+
+//
+// PCR = Hash(PCR || Digest)
+//
+static VOID
+ExtendBank( REPLAY_BANK *Bank,
+            UINT32 Pcr,
+            UINT8 *Digest )
+{
+    UINT8 Buffer[2 * sizeof(TPMU_HA)];
+
+    CopyMem(Buffer, Bank->Replayed[Pcr], Bank->Size);
+    CopyMem(Buffer + Bank->Size, Digest, Bank->Size);
+    Bank->Hash(Buffer, 2 * Bank->Size, Bank->Replayed[Pcr]);
+}
+
+
+//
+// All 24 PCRs of one bank, read with TpmPcrReadAll as ShowPCR20 does.
+// Returns EFI_UNSUPPORTED if the bank is not allocated in the TPM.
+//
+static EFI_STATUS
+ReadLiveBank( REPLAY_BANK *Bank )
+{
+    STATIC TPM_PCR_VALUES Values;
+    TPMS_PCR_SELECTION    *Read;
+    TPM2B_DIGEST          *Digest;
+    EFI_STATUS            Status;
+
+    ZeroMem(&Values, sizeof(Values));
+    TpmPcrSelectBank(&Values, Bank->AlgId);
+    Status = TpmPcrReadAll(&Values);
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+
+    Read = &Values.Read.pcrSelections[0];
+    if (!(Read->pcrSelect[0] | Read->pcrSelect[1] | Read->pcrSelect[2])) {
+        return EFI_UNSUPPORTED;
+    }
+    for (UINT32 Pcr = 0; Pcr < MAX_PCR; Pcr++) {
+        Digest = &Values.Digests[0][Pcr];
+        if (!(Read->pcrSelect[Pcr / 8] & (1 << (Pcr % 8))) || Digest->size != Bank->Size) {
+            return EFI_DEVICE_ERROR;
+        }
+        CopyMem(Bank->Live[Pcr], Digest->buffer, Bank->Size);
+    }
+
+    Bank->LiveRead = TRUE;
+
+    return EFI_SUCCESS;
+}
+
+
+//
+// One pass over the log, extending every bank as each event goes by
+//
+static UINT32
+ReplayEvents( EVENT_LOG *Log,
+              UINT32 *Skipped )
+{
+    TCG_EfiStartupLocalityEvent *Locality;
+    LOG_EVENT Event;
+    UINT32    Count = 0;
+    BOOLEAN   More;
+
+    *Skipped = 0;
+    for (More = LogFirst(Log, &Event); More; More = LogNext(Log, &Event)) {
+        if (Event.EventType == EV_NO_ACTION) {
+            // a locality 3 or 4 startup is recorded in the initial PCR 0
+            Locality = (TCG_EfiStartupLocalityEvent *) Event.Event;
+            if (Event.PcrIndex == 0 && Event.EventSize >= sizeof(TCG_EfiStartupLocalityEvent) &&
+                !CompareMem(Locality->Signature, TCG_EfiStartupLocalityEvent_SIGNATURE,
+                            sizeof(TCG_EfiStartupLocalityEvent_SIGNATURE))) {
+                for (UINT32 b = 0; b < Log->AlgorithmCount; b++) {
+                    ZeroMem(Banks[b].Replayed[0], Banks[b].Size);
+                    Banks[b].Replayed[0][Banks[b].Size - 1] = Locality->StartupLocality;
+                }
+            }
+            continue;
+        }
+        if (Event.PcrIndex >= MAX_PCR) {
+            (*Skipped)++;
+            continue;
+        }
+
+        Count++;
+        for (UINT32 b = 0; b < Log->AlgorithmCount; b++) {
+            UINT32 d;
+
+            for (d = 0; d < Event.DigestCount; d++) {
+                if (Event.Digests[d].AlgId == Banks[b].AlgId) {
+                    break;
+                }
+            }
+            if (d == Event.DigestCount) {
+                Banks[b].Missing++;
+                continue;
+            }
+            Banks[b].Events[Event.PcrIndex]++;
+            if (Banks[b].Hash != NULL) {
+                ExtendBank(&Banks[b], Event.PcrIndex, Event.Digests[d].Digest);
+            }
+        }
+    }
+
+    return Count;
+}
+
+
+static VOID
+PrintBank( REPLAY_BANK *Bank,
+           BOOLEAN Verbose )
+{
+    CHAR16 Buffer[(sizeof(TPMU_HA) * 2) + 1];
+    BOOLEAN Match;
+
+    OutputPrint(L"\nBank (Algorithm): %s (0x%04x)\n\n", LogAlgorithmName(Bank->AlgId), Bank->AlgId);
+    if (Bank->Hash == NULL) {
+        OutputPrint(L"  Not replayed, no digest implementation for this algorithm\n");
+        return;
+    }
+    if (Bank->LiveStatus == EFI_UNSUPPORTED) {
+        OutputPrint(L"  Bank is not allocated in the TPM, nothing to compare with\n");
+    } else if (EFI_ERROR(Bank->LiveStatus)) {
+        OutputPrint(L"  ERROR: Could not read the live PCRs [%r], nothing to compare with\n", Bank->LiveStatus);
+    }
+    if (Bank->Missing) {
+        OutputPrint(L"  WARNING: %d events have no digest for this bank\n", Bank->Missing);
+    }
+
+    for (UINT32 Pcr = 0; Pcr < MAX_PCR; Pcr++) {
+        Match = !Bank->LiveRead || CompareMem(Bank->Replayed[Pcr], Bank->Live[Pcr], Bank->Size) == 0;
+        if (Bank->Events[Pcr] == 0 && Match && !Verbose) {
+            continue;
+        }
+        OutputPrint(L"  [%02d] %4d events  %s\n", Pcr, Bank->Events[Pcr],
+                    !Bank->LiveRead ? L"" : (Match ? L"match" : L"MISMATCH"));
+        if (!Match || Verbose) {
+            OutputPrint(L"       Replayed: %s\n", HexToString(Buffer, sizeof(Buffer), Bank->Replayed[Pcr], Bank->Size));
+        }
+        if (Bank->LiveRead && (!Match || Verbose)) {
+            OutputPrint(L"           Live: %s\n", HexToString(Buffer, sizeof(Buffer), Bank->Live[Pcr], Bank->Size));
+        }
+    }
+}
+
+
+static VOID
+JsonBank( REPLAY_BANK *Bank )
+{
+    BOOLEAN Match;
+
+    JsonObjectBegin(NULL);
+    JsonString(L"algorithm", LogAlgorithmName(Bank->AlgId));
+    JsonHex(L"algorithmId", Bank->AlgId);
+    JsonBool(L"replayed", Bank->Hash != NULL);
+    if (EFI_ERROR(Bank->LiveStatus) && Bank->LiveStatus != EFI_UNSUPPORTED) {
+        JsonPrint(L"readError", L"%r", Bank->LiveStatus);
+    } else {
+        JsonBool(L"allocated", Bank->LiveRead);
+    }
+    JsonUint(L"missingDigests", Bank->Missing);
+    if (Bank->Hash != NULL) {
+        JsonArrayBegin(L"pcrs");
+        for (UINT32 Pcr = 0; Pcr < MAX_PCR; Pcr++) {
+            JsonObjectBegin(NULL);
+            JsonUint(L"index", Pcr);
+            JsonUint(L"events", Bank->Events[Pcr]);
+            JsonBytes(L"replayed", Bank->Replayed[Pcr], Bank->Size);
+            if (Bank->LiveRead) {
+                Match = CompareMem(Bank->Replayed[Pcr], Bank->Live[Pcr], Bank->Size) == 0;
+                JsonBytes(L"live", Bank->Live[Pcr], Bank->Size);
+                JsonBool(L"match", Match);
+            }
+            JsonObjectEnd();
+        }
+        JsonArrayEnd();
+    }
+    JsonObjectEnd();
+}
+
+
+//
+// Replay the log and compare with the live PCRs.  Returns
+// EFI_SECURITY_VIOLATION if any allocated bank does not match so that
+// a startup script can act on it, or EFI_DEVICE_ERROR if nothing
+// mismatched but the live PCRs of some bank could not be read.
+//
+EFI_STATUS
+ReplayLog( EVENT_LOG *Log,
+           BOOLEAN Verbose,
+           BOOLEAN Json )
+{
+    UINT32 Replayed;
+    UINT32 Skipped;
+    UINT32 Mismatches = 0;
+    UINT32 ReadErrors = 0;
+
+    ZeroMem(Banks, sizeof(Banks));
+    for (UINT32 b = 0; b < Log->AlgorithmCount; b++) {
+        Banks[b].AlgId = Log->Algorithms[b].AlgId;
+        Banks[b].Size = Log->Algorithms[b].Size;
+        Banks[b].Hash = HashFunction(Banks[b].AlgId);
+        ResetBank(&Banks[b]);
+    }
+
+    Replayed = ReplayEvents(Log, &Skipped);
+
+    for (UINT32 b = 0; b < Log->AlgorithmCount; b++) {
+        if (Banks[b].Hash == NULL) {
+            continue;
+        }
+        Banks[b].LiveStatus = ReadLiveBank(&Banks[b]);
+        if (EFI_ERROR(Banks[b].LiveStatus)) {
+            if (Banks[b].LiveStatus != EFI_UNSUPPORTED) {
+                ReadErrors++;
+            }
+            continue;
+        }
+        for (UINT32 Pcr = 0; Pcr < MAX_PCR; Pcr++) {
+            if (CompareMem(Banks[b].Replayed[Pcr], Banks[b].Live[Pcr], Banks[b].Size)) {
+                Mismatches++;
+            }
+        }
+    }
+
+    if (Json) {
+        JsonObjectBegin(L"replay");
+        JsonUint(L"events", Replayed);
+        JsonUint(L"skippedEvents", Skipped);
+        JsonBool(L"logComplete", !Log->Bad && !Log->Truncated);
+        JsonArrayBegin(L"banks");
+        for (UINT32 b = 0; b < Log->AlgorithmCount; b++) {
+            JsonBank(&Banks[b]);
+        }
+        JsonArrayEnd();
+        JsonUint(L"mismatches", Mismatches);
+        JsonUint(L"readErrors", ReadErrors);
+        JsonObjectEnd();
+    } else {
+        OutputPrint(L"Events replayed: %d\n", Replayed);
+        if (Skipped) {
+            OutputPrint(L"WARNING: %d events for PCRs above %d skipped\n", Skipped, MAX_PCR - 1);
+        }
+        if (Log->Bad) {
+            OutputPrint(L"WARNING: Replay stopped at a malformed log record\n");
+        }
+        if (Log->Truncated) {
+            OutputPrint(L"WARNING: Event log is truncated\n");
+        }
+        for (UINT32 b = 0; b < Log->AlgorithmCount; b++) {
+            PrintBank(&Banks[b], Verbose);
+        }
+        if (Mismatches) {
+            OutputPrint(L"\nRESULT: %d PCR values do not match the event log\n", Mismatches);
+        } else if (ReadErrors) {
+            OutputPrint(L"\nRESULT: Live PCR values of %d banks could not be read\n", ReadErrors);
+        } else {
+            OutputPrint(L"\nRESULT: Event log replay matches the live PCR values\n");
+        }
+    }
+
+    if (Mismatches) {
+        return EFI_SECURITY_VIOLATION;
+    }
+
+    return ReadErrors ? EFI_DEVICE_ERROR : EFI_SUCCESS;
+}
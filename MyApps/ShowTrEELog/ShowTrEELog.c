@@ -1,7 +1,9 @@
 //
 //  Copyright (c) 2015-2018   Finnbarr P. Murphy.   All rights reserved.
 //
-//  Display all available TCG TrEE log entries 
+//  Display all available TCG TrEE log entries, in the TCG 2.0
+//  crypto-agile format where the firmware supports it, and optionally
+//  replay the log against the live PCRs
 //
 //  License: UDK2017 license applies to code from UDK2017 sources,
 //           BSD 2 clause license applies to all other code.
@@ -14,14 +16,16 @@
 #include <Library/ShellLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Library/HexDumpLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
 
 #include <Protocol/EfiShell.h>
 #include <Protocol/LoadedImage.h>
-#include <Protocol/TrEEProtocol.h>
-#include <Protocol/Tcg2Protocol.h>
-#include <IndustryStandard/UefiTcgPlatform.h>
 
-#define UTILITY_VERSION L"20180903"
+#include "ShowTrEELog.h"
+
+#define UTILITY_VERSION L"20181026"
 #undef DEBUG
 
 
@@ -29,25 +33,7 @@ VOID
 PrintEventDetail( UINT8 *Detail,
                   UINT32 Size )
 {
-    UINT8 *d = Detail;
-    int Offset = 0;
-    int Row = 1;
-
-    Print(L"     Event Detail: %08x: ", Offset);
-
-    for (int i = 0; i < Size; i++) {
-        Print(L"%02x", *d++);
-        Offset++; Row++;
-        if (Row == 17 || Row == 33) {
-            Print(L" ");
-        }
-        if (Row > 48) {
-           Row = 1;
-           Print(L"\n                   %08x: ", Offset);
-        }
-    }
-
-    Print(L"\n");
+    HexDump( L"     Event Detail: ", L"                   ", Detail, Size, 48, HEXDUMP_OFFSET );
 }
 
 
@@ -55,77 +41,286 @@ VOID
 PrintEventType( UINT32 EventType, 
                 BOOLEAN Verbose )
 {
-    Print(L"       Event Type: ");
+    OutputPrint(L"       Event Type: ");
     if (Verbose) {
-        Print(L"%08x ", EventType);
-    }
-    switch (EventType) {
-        case  EV_POST_CODE:                      Print(L"Post Code");
-                                                 break;
-        case  EV_NO_ACTION:                      Print(L"No Action");
-                                                 break;
-        case  EV_SEPARATOR:                      Print(L"Separator");
-                                                 break;
-        case  EV_S_CRTM_CONTENTS:                Print(L"CTRM Contents");
-                                                 break;
-        case  EV_S_CRTM_VERSION:                 Print(L"CRTM Version");
-                                                 break;
-        case  EV_CPU_MICROCODE:                  Print(L"CPU Microcode");
-                                                 break;
-        case  EV_TABLE_OF_DEVICES:               Print(L"Table of Devices");
-                                                 break;
-        case  EV_EFI_VARIABLE_DRIVER_CONFIG:     Print(L"Variable Driver Config");
-                                                 break;
-        case  EV_EFI_VARIABLE_BOOT:              Print(L"Variable Boot");
-                                                 break;
-        case  EV_EFI_BOOT_SERVICES_APPLICATION:  Print(L"Boot Services Application");
-                                                 break;
-        case  EV_EFI_BOOT_SERVICES_DRIVER:       Print(L"Boot Services Driver");
-                                                 break;
-        case  EV_EFI_RUNTIME_SERVICES_DRIVER:    Print(L"Runtime Services Driver");
-                                                 break;
-        case  EV_EFI_GPT_EVENT:                  Print(L"GPT Event");
-                                                 break;
-        case  EV_EFI_ACTION:                     Print(L"Action");
-                                                 break;
-        case  EV_EFI_PLATFORM_FIRMWARE_BLOB:     Print(L"Platform Fireware Blob");
-                                                 break;
-        case  EV_EFI_HANDOFF_TABLES:             Print(L"Handoff Tables");
-                                                 break;
-        case  EV_EFI_VARIABLE_AUTHORITY:         Print(L"Variable Authority");
-                                                 break;
-        default:                                 Print(L"Unknown Type");
-                                                 break;
-    }        
-    Print(L"\n");
+        OutputPrint(L"%08x ", EventType);
+    }
+    OutputPrint(L"%s\n", EventTypeStr(EventType));
 }
 
 
 VOID
-PrintSHA1( TCG_DIGEST Digest )
+PrintDigests( LOG_EVENT *Event )
 {
-    Print(L"      SHA1 Digest: " );
+    CHAR16 Buffer[(sizeof(TPMU_HA) * 2) + 1];
 
-    for (int j = 0; j < SHA1_DIGEST_SIZE; j++ ) {
-         Print(L"%02x", Digest.digest[j]);
+    for (UINT32 i = 0; i < Event->DigestCount; i++) {
+        OutputPrint(L"%10s Digest: %s\n", LogAlgorithmName(Event->Digests[i].AlgId),
+                    HexToString(Buffer, sizeof(Buffer), Event->Digests[i].Digest, Event->Digests[i].Size));
     }
-
-    Print(L"\n");
 }
 
 
 VOID
-PrintLog( TCG_PCR_EVENT *Event,
+PrintLog( LOG_EVENT *Event,
           BOOLEAN Verbose )
 {
-    Print(L"  Event PCR Index: %u\n", Event->PCRIndex);
+    OutputPrint(L"  Event PCR Index: %u\n", Event->PcrIndex);
     PrintEventType(Event->EventType, Verbose);
-    PrintSHA1(Event->Digest);
-    Print(L"       Event Size: %d\n", Event->EventSize);
+    PrintDigests(Event);
+    OutputPrint(L"       Event Size: %d\n", Event->EventSize);
+    DecodeEvent(Event, FALSE);
     if (Verbose) {
         PrintEventDetail(Event->Event, Event->EventSize);
     }
-    Print(L"\n");
+    OutputPrint(L"\n");
+}
+
+
+VOID
+JsonLog( LOG_EVENT *Event,
+         UINTN Number )
+{
+    JsonObjectBegin(NULL);
+    JsonUint(L"number", Number);
+    JsonUint(L"pcrIndex", Event->PcrIndex);
+    JsonHex(L"eventType", Event->EventType);
+    JsonString(L"eventTypeName", EventTypeStr(Event->EventType));
+    JsonArrayBegin(L"digests");
+    for (UINT32 i = 0; i < Event->DigestCount; i++) {
+        JsonObjectBegin(NULL);
+        JsonString(L"algorithm", LogAlgorithmName(Event->Digests[i].AlgId));
+        JsonBytes(L"digest", Event->Digests[i].Digest, Event->Digests[i].Size);
+        JsonObjectEnd();
+    }
+    JsonArrayEnd();
+    JsonUint(L"eventSize", Event->EventSize);
+    if (EventTypeInfo(Event->EventType)->Decode != NULL) {
+        JsonObjectBegin(L"decoded");
+        DecodeEvent(Event, TRUE);
+        JsonObjectEnd();
+    }
+    JsonBytes(L"eventData", Event->Event, Event->EventSize);
+    JsonObjectEnd();
+}
+
+
+VOID
+PrintLogFormat( EVENT_LOG *Log )
+{
+    if (Log->Format == EFI_TCG2_EVENT_LOG_FORMAT_TCG_2) {
+        OutputPrint(L"Log Format: TCG %d.%d errata %d (crypto agile), algorithms:",
+                    Log->SpecMajor, Log->SpecMinor, Log->SpecErrata);
+        for (UINT32 i = 0; i < Log->AlgorithmCount; i++) {
+            OutputPrint(L" %s", LogAlgorithmName(Log->Algorithms[i].AlgId));
+        }
+        OutputPrint(L"\n");
+    } else {
+        OutputPrint(L"Log Format: TCG 1.2 (SHA1)\n");
+    }
+    if (Log->Truncated) {
+        OutputPrint(L"WARNING: Event log is truncated\n");
+    }
+    OutputPrint(L"\n");
+}
+
+
+VOID
+JsonLogFormat( EVENT_LOG *Log )
+{
+    JsonString(L"format", Log->Format == EFI_TCG2_EVENT_LOG_FORMAT_TCG_2 ? L"TCG_2" : L"TCG_1_2");
+    JsonArrayBegin(L"algorithms");
+    for (UINT32 i = 0; i < Log->AlgorithmCount; i++) {
+        JsonObjectBegin(NULL);
+        JsonString(L"algorithm", LogAlgorithmName(Log->Algorithms[i].AlgId));
+        JsonHex(L"algorithmId", Log->Algorithms[i].AlgId);
+        JsonUint(L"digestSize", Log->Algorithms[i].Size);
+        JsonObjectEnd();
+    }
+    JsonArrayEnd();
+    JsonBool(L"truncated", Log->Truncated);
+}
+
+
+//
+// Digest bytes given as hex digits, most significant first
+//
+BOOLEAN
+HexToBytes( CHAR16 *Str,
+            UINT8 *Bytes,
+            UINTN Max,
+            UINTN *Count )
+{
+    UINTN  Length = StrLen(Str);
+    UINT8  Nibble;
+
+    if (Length == 0 || (Length % 2) || Length / 2 > Max) {
+        return FALSE;
+    }
+
+    for (UINTN i = 0; i < Length; i++) {
+        if (Str[i] >= L'0' && Str[i] <= L'9') {
+            Nibble = (UINT8) (Str[i] - L'0');
+        } else if (Str[i] >= L'a' && Str[i] <= L'f') {
+            Nibble = (UINT8) (Str[i] - L'a' + 10);
+        } else if (Str[i] >= L'A' && Str[i] <= L'F') {
+            Nibble = (UINT8) (Str[i] - L'A' + 10);
+        } else {
+            return FALSE;
+        }
+        if (i % 2) {
+            Bytes[i / 2] |= Nibble;
+        } else {
+            Bytes[i / 2] = (UINT8) (Nibble << 4);
+        }
+    }
+    *Count = Length / 2;
+
+    return TRUE;
+}
+
+
+BOOLEAN
+IsNumber( CHAR16* str )
+{
+    CHAR16 *s = str;
+
+    if (*s == 0)
+        return FALSE;
+
+    while (*s) {
+        if (*s  < L'0' || *s > L'9')
+            return FALSE;
+        s++;
+    }
+
+    return TRUE;
+}
+
+
+BOOLEAN
+IsFilterOption( CHAR16 *Str )
+{
+    return !StrCmp(Str, L"--pcr") || !StrCmp(Str, L"-p") ||
+           !StrCmp(Str, L"--type") || !StrCmp(Str, L"-t") ||
+           !StrCmp(Str, L"--digest") || !StrCmp(Str, L"-d");
+}
+
+
+BOOLEAN
+IsVerboseOption( CHAR16 *Str )
+{
+    return !StrCmp(Str, L"--verbose") || !StrCmp(Str, L"-v");
+}
+
+
+//
+// Any filter option anywhere on the command line, so that -v may come first
+//
+BOOLEAN
+HasFilterOption( UINTN Argc,
+                 CHAR16 **Argv )
+{
+    for (UINTN i = 1; i < Argc; i++) {
+        if (IsFilterOption(Argv[i])) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+
+//
+// Any combination of --pcr, --type and --digest, plus --verbose
+//
+BOOLEAN
+ParseFilters( UINTN Argc,
+              CHAR16 **Argv,
+              LOG_FILTER *Filter,
+              BOOLEAN *Verbose )
+{
+    ZeroMem(Filter, sizeof(LOG_FILTER));
+
+    for (UINTN i = 1; i < Argc; i++) {
+        if (IsVerboseOption(Argv[i])) {
+            *Verbose = TRUE;
+            continue;
+        }
+        if (!IsFilterOption(Argv[i]) || i + 1 == Argc) {
+            return FALSE;
+        }
+        if (!StrCmp(Argv[i], L"--pcr") || !StrCmp(Argv[i], L"-p")) {
+            // StrDecimalToUintn stops at the first non-digit, so check first
+            if (!IsNumber(Argv[++i]) || StrLen(Argv[i]) > 2 ||
+                StrDecimalToUintn(Argv[i]) >= MAX_PCR) {
+                return FALSE;
+            }
+            Filter->ByPcr = TRUE;
+            Filter->PcrIndex = (UINT32) StrDecimalToUintn(Argv[i]);
+        } else if (!StrCmp(Argv[i], L"--type") || !StrCmp(Argv[i], L"-t")) {
+            Filter->ByType = TRUE;
+            if (!EventTypeFromStr(Argv[++i], &Filter->EventType)) {
+                return FALSE;
+            }
+        } else if (!HexToBytes(Argv[++i], Filter->Digest, sizeof(Filter->Digest), &Filter->DigestSize)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+
+//
+// Build the index once and print only the events that pass Filter
+//
+EFI_STATUS
+FilterLog( EVENT_LOG *Log,
+           LOG_FILTER *Filter,
+           BOOLEAN Verbose,
+           BOOLEAN Json )
+{
+    LOG_INDEX  Index;
+    LOG_EVENT  Event;
+    EFI_STATUS Status;
+    UINTN      Matches = 0;
+
+    Status = IndexBuild(Log, &Index);
+    if (EFI_ERROR(Status)) {
+        JsonError(L"Building event log index [%d]", Status);
+        return Status;
+    }
+
+    if (Json) {
+        JsonArrayBegin(L"events");
+    }
+    for (UINTN i = 0; i < Index.Count; i++) {
+        if (!IndexMatch(Log, &Index.Entries[i], Filter, &Event)) {
+            continue;
+        }
+        Matches++;
+        if (Json) {
+            JsonLog(&Event, i);
+        } else {
+            OutputPrint(L"     Event Number: %d (offset 0x%x)\n", i, Index.Entries[i].Offset);
+            PrintLog(&Event, Verbose);
+        }
+    }
+    if (Json) {
+        JsonArrayEnd();
+        JsonUint(L"indexedEvents", Index.Count);
+        JsonUint(L"matches", Matches);
+    } else {
+        OutputPrint(L"%d of %d events match\n", Matches, Index.Count);
+    }
+    if (Index.Bad) {
+        JsonError(L"Malformed event log record, later events not indexed");
+    }
+
+    IndexFree(&Index);
+
+    return EFI_SUCCESS;
 }
 
 
@@ -134,10 +329,14 @@ Usage( CHAR16 *Str,
        BOOLEAN ErrorMsg )
 {
     if ( ErrorMsg ) {
-        Print(L"ERROR: Unknown option.\n");
+        OutputPrint(L"ERROR: Unknown option.\n");
     }
-    Print(L"Usage: %s [-V | --version]\n", Str);
-    Print(L"       %s [-v | --verbose]\n", Str);
+    OutputPrint(L"Usage: %s [-V | --version]\n", Str);
+    OutputPrint(L"       %s [-v | --verbose]\n", Str);
+    OutputPrint(L"       %s [-r | --replay] [-v | --verbose]\n", Str);
+    OutputPrint(L"       %s [-e | --export <file>]\n", Str);
+    OutputPrint(L"       %s [-p | --pcr <index>] [-t | --type <EV_name | 0xtype>] [-d | --digest <hex>] [-v]\n", Str);
+    OutputPrint(L"       %s [--json]\n", Str);
 }
 
 
@@ -147,63 +346,128 @@ ShellAppMain( UINTN Argc,
               CHAR16 **Argv )
 {
     EFI_STATUS Status = EFI_SUCCESS;
-    EFI_TREE_PROTOCOL *TreeProtocol;
-    EFI_PHYSICAL_ADDRESS LogLocation;
-    EFI_PHYSICAL_ADDRESS LogLastEntry;
-    EFI_PHYSICAL_ADDRESS LogAddress;
-    TCG_PCR_EVENT *Event = NULL;
-    BOOLEAN LogTruncated;
+    EVENT_LOG Log;
+    LOG_EVENT Event;
+    CHAR16 *ExportFile = NULL;
+    LOG_FILTER Filter;
+    UINTN Number = 0;
+    BOOLEAN Filtered = FALSE;
+    BOOLEAN More;
     BOOLEAN Verbose = FALSE;
+    BOOLEAN Replay = FALSE;
+    BOOLEAN Json = FALSE;
 
-    if (Argc == 2) {
-        if (!StrCmp(Argv[1], L"--version") ||
-            !StrCmp(Argv[1], L"-V")) {
-            Print(L"Version: %s\n", UTILITY_VERSION);
-            return Status;
-        } else if (!StrCmp(Argv[1], L"--help") ||
-            !StrCmp(Argv[1], L"-h")) {
-            Usage(Argv[0], FALSE);
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
+
+    if (HasFilterOption(Argc, Argv)) {
+        if (!ParseFilters(Argc, Argv, &Filter, &Verbose)) {
+            Usage(Argv[0], TRUE);
             return Status;
-        } else if (!StrCmp(Argv[1], L"--verbose") ||
-            !StrCmp(Argv[1], L"-v")) {
-            Verbose = TRUE;
-        } else {
+        }
+        Filtered = TRUE;
+    } else {
+        if (Argc == 2) {
+            if (!StrCmp(Argv[1], L"--version") ||
+                !StrCmp(Argv[1], L"-V")) {
+                OutputPrint(L"Version: %s\n", UTILITY_VERSION);
+                return Status;
+            } else if (!StrCmp(Argv[1], L"--help") ||
+                !StrCmp(Argv[1], L"-h")) {
+                Usage(Argv[0], FALSE);
+                return Status;
+            } else if (IsVerboseOption(Argv[1])) {
+                Verbose = TRUE;
+            } else if (!StrCmp(Argv[1], L"--replay") ||
+                !StrCmp(Argv[1], L"-r")) {
+                Replay = TRUE;
+            } else {
+                Usage(Argv[0], TRUE);
+                return Status;
+            }
+        }
+        if (Argc == 3) {
+            if (!StrCmp(Argv[1], L"--export") ||
+                !StrCmp(Argv[1], L"-e")) {
+                ExportFile = Argv[2];
+            } else if (((!StrCmp(Argv[1], L"--replay") || !StrCmp(Argv[1], L"-r")) && IsVerboseOption(Argv[2])) ||
+                ((!StrCmp(Argv[2], L"--replay") || !StrCmp(Argv[2], L"-r")) && IsVerboseOption(Argv[1]))) {
+                Replay = TRUE;
+                Verbose = TRUE;
+            } else {
+                Usage(Argv[0], TRUE);
+                return Status;
+            }
+        }
+        if (Argc > 3) {
             Usage(Argv[0], TRUE);
             return Status;
         }
     }
-    if (Argc > 2) {
-        Usage(Argv[0], TRUE);
+
+    if (Json) {
+        JsonDocumentBegin(L"ShowTrEELog", UTILITY_VERSION);
+    }
+
+    Status = LogOpen(&Log);
+    if (Status == EFI_COMPROMISED_DATA) {
+        JsonError(L"Bad Spec ID event at start of TCG2 event log");
+        return Status;
+    } else if (EFI_ERROR (Status)) {
+        JsonError(L"Failed to get event log from EFI_TCG2_PROTOCOL or EFI_TREE_PROTOCOL [%d]", Status);
+        return Status;
+    }
+
+    if (Json) {
+        JsonLogFormat(&Log);
+    } else {
+        PrintLogFormat(&Log);
+    }
+
+    if (ExportFile != NULL) {
+        Status = ExportLog(&Log, ExportFile, Json);
+        if (Json) {
+            JsonDocumentEnd();
+        }
         return Status;
     }
 
-    Status = gBS->LocateProtocol( &gEfiTrEEProtocolGuid, 
-                                  NULL, 
-                                  (VOID **) &TreeProtocol );
-    if (EFI_ERROR (Status)) {
-        Print(L"ERROR: Failed to locate EFI_TREE_PROTOCOL [%d]\n", Status);
+    if (Filtered) {
+        Status = FilterLog(&Log, &Filter, Verbose, Json);
+        if (Json) {
+            JsonDocumentEnd();
+        }
         return Status;
-    }  
-
-    Status = TreeProtocol->GetEventLog( TreeProtocol, 
-                                        TREE_EVENT_LOG_FORMAT_TCG_1_2,
-                                        &LogLocation,
-                                        &LogLastEntry,
-                                        &LogTruncated );
-    if (EFI_ERROR (Status)) {
-        Print(L"ERROR: TreeProtocol GetEventLog [%d]\n", Status);
+    }
+
+    if (Replay) {
+        Status = ReplayLog(&Log, Verbose, Json);
+        if (Json) {
+            JsonDocumentEnd();
+        }
         return Status;
-    }  
+    }
 
-    LogAddress = LogLocation;
-    if (LogLocation != LogLastEntry) {
-        do {
-            Event = (TCG_PCR_EVENT *) LogAddress;
-            PrintLog(Event, Verbose);
-            LogAddress += sizeof(TCG_PCR_EVENT_HDR) + Event->EventSize;
-        } while (LogAddress != LogLastEntry);
+    if (Json) {
+        JsonArrayBegin(L"events");
+    }
+    for (More = LogFirst(&Log, &Event); More; More = LogNext(&Log, &Event)) {
+        if (Json) {
+            JsonLog(&Event, Number);
+        } else {
+            PrintLog(&Event, Verbose);
+        }
+        Number++;
+    }
+    if (Json) {
+        JsonArrayEnd();
+        if (Log.Bad) {
+            JsonError(L"Malformed event log record");
+        }
+        JsonDocumentEnd();
+    } else if (Log.Bad) {
+        OutputPrint(L"ERROR: Malformed event log record\n");
     }
-    PrintLog((TCG_PCR_EVENT *)LogAddress, Verbose);
 
     return Status;
 }
@@ -0,0 +1,134 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  ShowTrEELog shared definitions
+//
+//  License: BSD License
+//
+
+#ifndef _SHOWTREELOG_H_
+#define _SHOWTREELOG_H_
+
+#include <Uefi.h>
+
+#include <Protocol/TrEEProtocol.h>
+#include <Protocol/Tcg2Protocol.h>
+#include <IndustryStandard/UefiTcgPlatform.h>
+
+#define MAX_PCR             24
+#define MAX_LOG_ALGORITHMS  HASH_COUNT
+#define MAX_EVENT_SIZE      0x100000     // sanity limit on one event's data
+
+typedef struct {
+    TPMI_ALG_HASH AlgId;
+    UINT16        Size;
+} LOG_ALGORITHM;
+
+typedef struct {
+    TPMI_ALG_HASH AlgId;
+    UINT16        Size;
+    UINT8         *Digest;
+} LOG_DIGEST;
+
+//
+// One record from either log format.  The pointers are into the
+// firmware's log; nothing is copied.
+//
+typedef struct {
+    UINT8      *Record;
+    UINT32     RecordSize;
+    UINT32     PcrIndex;
+    UINT32     EventType;
+    UINT32     DigestCount;
+    LOG_DIGEST Digests[MAX_LOG_ALGORITHMS];
+    UINT32     EventSize;
+    UINT8      *Event;
+} LOG_EVENT;
+
+//
+// The event log as returned by GetEventLog.  A TCG 1.2 log is treated
+// as a crypto-agile log with a single SHA-1 algorithm.
+//
+typedef struct {
+    EFI_TCG2_PROTOCOL         *Tcg2;          // NULL if only TrEE is present
+    EFI_TREE_PROTOCOL         *TrEE;
+    EFI_TCG2_EVENT_LOG_FORMAT Format;
+    UINT8                     *Location;
+    UINT8                     *LastEntry;      // start of the last record
+    BOOLEAN                   Truncated;
+    UINT8                     SpecMajor;       // from the Spec ID event
+    UINT8                     SpecMinor;
+    UINT8                     SpecErrata;
+    UINT32                    AlgorithmCount;
+    LOG_ALGORITHM             Algorithms[MAX_LOG_ALGORITHMS];
+    EFI_TCG2_FINAL_EVENTS_TABLE *FinalEvents;  // NULL if not published
+    UINT64                    FinalEventsAtOpen; // already in the log when fetched
+    UINT8                     *Next;           // walk position
+    BOOLEAN                   Bad;             // walk stopped at a malformed record
+} EVENT_LOG;
+
+#define INDEX_PREFIX_SIZE   4            // digest bytes kept in the index
+
+//
+// Index of the log: one compact entry per record
+//
+typedef struct {
+    UINT32 Offset;                       // from the start of the log
+    UINT32 PcrIndex;
+    UINT32 EventType;
+    UINT8  DigestCount;
+    UINT8  Prefix[MAX_LOG_ALGORITHMS][INDEX_PREFIX_SIZE];
+} LOG_INDEX_ENTRY;
+
+typedef struct {
+    LOG_INDEX_ENTRY *Entries;
+    UINTN           Count;
+    BOOLEAN         Bad;                 // log walk stopped early
+} LOG_INDEX;
+
+typedef struct {
+    BOOLEAN ByPcr;
+    UINT32  PcrIndex;
+    BOOLEAN ByType;
+    UINT32  EventType;
+    UINTN   DigestSize;                  // 0 if not filtering on digest
+    UINT8   Digest[sizeof(TPMU_HA)];     // leading bytes of any digest
+} LOG_FILTER;
+
+typedef VOID (*EVENT_DECODER)( LOG_EVENT *Event, BOOLEAN Json );
+
+typedef struct {
+    UINT32        Type;
+    CHAR16        *Name;                 // TCG name, as accepted by --type
+    CHAR16        *Description;
+    EVENT_DECODER Decode;                // NULL if the data is only dumped
+} EVENT_TYPE_INFO;
+
+
+// Events.c
+CONST EVENT_TYPE_INFO *EventTypeInfo( UINT32 EventType );
+CONST CHAR16 *EventTypeStr( UINT32 EventType );
+BOOLEAN EventTypeFromStr( CHAR16 *Str, UINT32 *EventType );
+BOOLEAN DecodeEvent( LOG_EVENT *Event, BOOLEAN Json );
+
+// Log.c
+EFI_STATUS LogOpen( EVENT_LOG *Log );
+BOOLEAN LogFirst( EVENT_LOG *Log, LOG_EVENT *Event );
+BOOLEAN LogNext( EVENT_LOG *Log, LOG_EVENT *Event );
+BOOLEAN LogEventAt( EVENT_LOG *Log, UINT32 Offset, LOG_EVENT *Event );
+UINTN LogSize( EVENT_LOG *Log );
+UINTN LogLateEvents( EVENT_LOG *Log, UINT8 **Start, UINT64 *Count );
+CONST CHAR16 *LogAlgorithmName( TPMI_ALG_HASH AlgId );
+
+// Export.c
+EFI_STATUS ExportLog( EVENT_LOG *Log, CONST CHAR16 *FileName, BOOLEAN Json );
+
+// Index.c
+EFI_STATUS IndexBuild( EVENT_LOG *Log, LOG_INDEX *Index );
+VOID IndexFree( LOG_INDEX *Index );
+BOOLEAN IndexMatch( EVENT_LOG *Log, LOG_INDEX_ENTRY *Entry, LOG_FILTER *Filter, LOG_EVENT *Event );
+
+// Replay.c
+EFI_STATUS ReplayLog( EVENT_LOG *Log, BOOLEAN Verbose, BOOLEAN Json );
+
+#endif
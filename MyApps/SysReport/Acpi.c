@@ -0,0 +1,89 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  SysReport ACPI section - RSDP, XSDT/RSDT, table headers and the
+//  tables AcpiTableDecodeLib has a decoder for
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/AcpiTableIndexLib.h>
+#include <Library/AcpiTableDecodeLib.h>
+
+#include "SysReport.h"
+
+
+EFI_STATUS
+CollectAcpi( SYSREPORT_CACHE *Cache )
+{
+    EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *Rsdp = AcpiIndexRsdp();
+    EFI_ACPI_DESCRIPTION_HEADER *Root;
+    EFI_ACPI_DESCRIPTION_HEADER *Ptr;
+    CONST ACPI_INDEX_ENTRY *Entry;
+    CONST ACPI_DECODER_ENTRY *Decoder;
+    BOOLEAN IsXsdt;
+    UINTN RootEntries = 0;
+
+    if (Rsdp == NULL) {
+        return EFI_NOT_FOUND;
+    }
+
+    JsonObjectBegin(L"rsdp");
+    JsonHex(L"address", (UINTN)Rsdp);
+    JsonGuid(L"guid", AcpiIndexRsdpGuid());
+    JsonUint(L"revision", Rsdp->Revision);
+    JsonAsciiString(L"oemId", (CHAR8 *)(Rsdp->OemId), 6);
+    JsonObjectEnd();
+
+    Root = AcpiIndexRoot(&IsXsdt);
+    if (Root == NULL) {
+        return EFI_VOLUME_CORRUPTED;
+    }
+
+    for (UINTN i = 0; (Entry = AcpiIndexEntry(i)) != NULL; i++) {
+        if (!(Entry->Flags & ACPI_INDEX_FROM_FADT)) {
+            RootEntries++;
+        }
+    }
+
+    JsonObjectBegin(IsXsdt ? L"xsdt" : L"rsdt");
+    JsonHex(L"address", (UINTN)Root);
+    JsonUint(L"revision", Root->Revision);
+    JsonAsciiString(L"oemId", (CHAR8 *)(Root->OemId), 6);
+    JsonUint(L"entryCount", RootEntries);
+    JsonObjectEnd();
+
+    // FACS has no standard header beyond signature and length
+    JsonArrayBegin(L"tables");
+    for (UINTN i = 0; (Entry = AcpiIndexEntry(i)) != NULL; i++) {
+        Ptr = Entry->Table;
+        JsonObjectBegin(NULL);
+        JsonAsciiString(L"signature", (CHAR8 *)&(Entry->Signature), 4);
+        JsonHex(L"address", (UINTN)Ptr);
+        JsonUint(L"length", Entry->Length);
+        if (!(Entry->Flags & ACPI_INDEX_NO_CHECKSUM)) {
+            JsonUint(L"revision", Ptr->Revision);
+            JsonAsciiString(L"oemId", (CHAR8 *)(Ptr->OemId), 6);
+            JsonAsciiString(L"oemTableId", (CHAR8 *)&(Ptr->OemTableId), 8);
+            JsonHex(L"oemRevision", Ptr->OemRevision);
+            JsonAsciiString(L"creatorId", (CHAR8 *)&(Ptr->CreatorId), 4);
+            JsonHex(L"creatorRevision", Ptr->CreatorRevision);
+            JsonBool(L"checksumValid", (Entry->Flags & ACPI_INDEX_CHECKSUM_OK) != 0);
+        }
+        JsonBool(L"fromFadt", (Entry->Flags & ACPI_INDEX_FROM_FADT) != 0);
+        // same decoders, and so the same layout, as ListACPI --all --json
+        Decoder = AcpiDecoderFind(Entry->Signature);
+        if (Decoder != NULL) {
+            JsonString(L"decoder", Decoder->Name);
+            JsonObjectBegin(L"decoded");
+            Decoder->Decode(Ptr, TRUE);
+            JsonObjectEnd();
+        }
+        JsonObjectEnd();
+    }
+    JsonArrayEnd();
+
+    return EFI_SUCCESS;
+}
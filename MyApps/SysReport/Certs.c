@@ -0,0 +1,93 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  SysReport Secure Boot section - mode variables, an inventory of the
+//  PK, KEK, db and dbx signature lists and their decoded certificates
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/SignatureListLib.h>
+
+#include <Guid/GlobalVariable.h>
+#include <Guid/ImageAuthentication.h>
+
+#include "SysReport.h"
+
+
+STATIC BOOLEAN
+ReadFlag( CHAR16 *Name )
+{
+    EFI_GUID gGlobal = EFI_GLOBAL_VARIABLE;
+    UINT8    Value = 0;
+    UINTN    Size = sizeof(Value);
+
+    if (EFI_ERROR(gRT->GetVariable(Name, &gGlobal, NULL, &Size, &Value))) {
+        return FALSE;
+    }
+
+    return Value != 0;
+}
+
+
+STATIC VOID
+JsonSignatureDatabase( CHAR16   *Name,
+                       EFI_GUID *Owner )
+{
+    EFI_STATUS Status;
+    UINT8      *Data;
+    UINTN      DataSize;
+
+    JsonObjectBegin(NULL);
+    JsonString(L"name", Name);
+
+    Status = SignatureListGet(Name, Owner, &Data, &DataSize);
+    if (Status == EFI_NOT_FOUND) {
+        JsonBool(L"present", FALSE);
+        JsonObjectEnd();
+        return;
+    }
+    if (EFI_ERROR(Status)) {
+        JsonPrint(L"error", L"Failed to get variable %s. Status Code: %d", Name, Status);
+        JsonObjectEnd();
+        return;
+    }
+
+    JsonBool(L"present", TRUE);
+    JsonUint(L"size", DataSize);
+    JsonArrayBegin(L"signatureLists");
+    SignatureListJson(Data, DataSize);
+    JsonArrayEnd();
+    JsonArrayBegin(L"certificates");
+    SignatureListCertificates(Data, DataSize, TRUE);
+    JsonArrayEnd();
+    JsonObjectEnd();
+
+    FreePool(Data);
+}
+
+
+EFI_STATUS
+CollectCerts( SYSREPORT_CACHE *Cache )
+{
+    EFI_GUID gGlobal = EFI_GLOBAL_VARIABLE;
+    EFI_GUID gSIGDB = EFI_IMAGE_SECURITY_DATABASE_GUID;
+
+    JsonBool(L"secureBoot", ReadFlag(L"SecureBoot"));
+    JsonBool(L"setupMode", ReadFlag(L"SetupMode"));
+
+    JsonArrayBegin(L"databases");
+    JsonSignatureDatabase(L"PK", &gGlobal);
+    JsonSignatureDatabase(L"KEK", &gGlobal);
+    JsonSignatureDatabase(L"db", &gSIGDB);
+    JsonSignatureDatabase(L"dbx", &gSIGDB);
+    JsonArrayEnd();
+
+    return EFI_SUCCESS;
+}
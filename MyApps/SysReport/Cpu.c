@@ -0,0 +1,24 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  SysReport CPU section - signature, brand string, version, features
+//  and caches (CPUID)
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/CpuInfoLib.h>
+
+#include "SysReport.h"
+
+
+EFI_STATUS
+CollectCpu( SYSREPORT_CACHE *Cache )
+{
+    CpuInfoReport(TRUE);
+
+    return EFI_SUCCESS;
+}
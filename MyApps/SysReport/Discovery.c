@@ -0,0 +1,80 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  SysReport discovery pass
+//
+//  One walk of the configuration table, one build of the ACPI table
+//  index and one lookup per protocol.  The results are kept in the
+//  cache and shared by every section.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/AcpiTableIndexLib.h>
+#include <Library/TpmCommandLib.h>
+
+#include <Protocol/PciRootBridgeIo.h>
+#include <Protocol/GraphicsOutput.h>
+
+#include "SysReport.h"
+
+
+VOID
+Discover( SYSREPORT_CACHE *Cache )
+{
+    EFI_CONFIGURATION_TABLE *ect = gST->ConfigurationTable;
+    EFI_GUID EsrtGuid = EFI_SYSTEM_RESOURCE_TABLE_GUID;
+    EFI_STATUS Status;
+
+    ZeroMem(Cache, sizeof(*Cache));
+
+    for (UINTN i = 0; i < gST->NumberOfTableEntries; i++, ect++) {
+        if (CompareGuid(&ect->VendorGuid, &EsrtGuid)) {
+            Cache->Esrt = (EFI_SYSTEM_RESOURCE_TABLE *)ect->VendorTable;
+        }
+    }
+
+    AcpiIndexInit();
+
+    TpmOpen(NULL);
+    Cache->Tcg2 = TpmTcg2();
+
+    Status = gBS->LocateHandleBuffer( ByProtocol,
+                                      &gEfiPciRootBridgeIoProtocolGuid,
+                                      NULL,
+                                      &Cache->PciHandleCount,
+                                      &Cache->PciHandles );
+    if (EFI_ERROR(Status)) {
+        Cache->PciHandles = NULL;
+        Cache->PciHandleCount = 0;
+    }
+
+    Status = gBS->LocateHandleBuffer( ByProtocol,
+                                      &gEfiGraphicsOutputProtocolGuid,
+                                      NULL,
+                                      &Cache->GopHandleCount,
+                                      &Cache->GopHandles );
+    if (EFI_ERROR(Status)) {
+        Cache->GopHandles = NULL;
+        Cache->GopHandleCount = 0;
+    }
+}
+
+
+VOID
+DiscoverFree( SYSREPORT_CACHE *Cache )
+{
+    if (Cache->PciHandles != NULL) {
+        FreePool(Cache->PciHandles);
+        Cache->PciHandles = NULL;
+    }
+    if (Cache->GopHandles != NULL) {
+        FreePool(Cache->GopHandles);
+        Cache->GopHandles = NULL;
+    }
+}
@@ -0,0 +1,57 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  SysReport EDID section - discovered EDID of every GOP display
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/EdidLib.h>
+
+#include <Protocol/EdidDiscovered.h>
+
+#include "SysReport.h"
+
+
+EFI_STATUS
+CollectEdid( SYSREPORT_CACHE *Cache )
+{
+    EFI_EDID_DISCOVERED_PROTOCOL *Edp;
+    EFI_STATUS Status;
+    UINTN      Found = 0;
+
+    if (Cache->GopHandleCount == 0) {
+        return EFI_NOT_FOUND;
+    }
+
+    JsonArrayBegin(L"displays");
+    for (UINTN i = 0; i < Cache->GopHandleCount; i++) {
+        Status = gBS->OpenProtocol( Cache->GopHandles[i],
+                                    &gEfiEdidDiscoveredProtocolGuid,
+                                    (VOID **)&Edp,
+                                    gImageHandle,
+                                    NULL,
+                                    EFI_OPEN_PROTOCOL_BY_HANDLE_PROTOCOL );
+        if (EFI_ERROR(Status)) {
+            continue;
+        }
+
+        JsonObjectBegin(NULL);
+        JsonUint(L"size", Edp->SizeOfEdid);
+        if (EdidValid(Edp->Edid, Edp->SizeOfEdid)) {
+            JsonBool(L"valid", TRUE);
+            EdidJson((EDID_DATA_BLOCK *)Edp->Edid);
+            Found++;
+        } else {
+            JsonBool(L"valid", FALSE);
+        }
+        JsonObjectEnd();
+    }
+    JsonArrayEnd();
+
+    return Found ? EFI_SUCCESS : EFI_NOT_FOUND;
+}
@@ -0,0 +1,25 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  SysReport ESRT section - EFI System Resource Table entries
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/EsrtLib.h>
+
+#include "SysReport.h"
+
+
+EFI_STATUS
+CollectEsrt( SYSREPORT_CACHE *Cache )
+{
+    if (Cache->Esrt == NULL) {
+        return EFI_NOT_FOUND;
+    }
+
+    return EsrtJson(Cache->Esrt);
+}
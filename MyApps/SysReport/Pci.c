@@ -0,0 +1,42 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  SysReport PCI section - devices behind every root bridge
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/PciScanLib.h>
+
+#include "SysReport.h"
+
+
+STATIC VOID
+EFIAPI
+JsonPciFunction( PCI_SCAN_ENTRY *Entry,
+                 VOID           *Context )
+{
+    PciScanJson(Entry);
+}
+
+
+EFI_STATUS
+CollectPci( SYSREPORT_CACHE *Cache )
+{
+    UINTN DeviceCount;
+
+    if (Cache->PciHandleCount == 0) {
+        return EFI_NOT_FOUND;
+    }
+
+    JsonUint(L"rootBridges", Cache->PciHandleCount);
+    JsonArrayBegin(L"devices");
+    DeviceCount = PciScan(Cache->PciHandles, Cache->PciHandleCount, JsonPciFunction, NULL);
+    JsonArrayEnd();
+    JsonUint(L"deviceCount", DeviceCount);
+
+    return EFI_SUCCESS;
+}
@@ -0,0 +1,167 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Collect a full platform inventory (ACPI, CPU, PCI, EDID, ESRT, TPM
+//  and Secure Boot databases) in one invocation and write it as a
+//  single JSON report bundle.
+//
+//  Protocols, configuration tables and the XSDT are looked up once by
+//  the discovery pass and shared by every section.  Each section is
+//  timed separately with the TSC.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/UefiLib.h>
+#include <Library/ShellCEntryLib.h>
+#include <Library/ShellLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/TscTimerLib.h>
+
+#include "SysReport.h"
+
+#undef DEBUG
+
+typedef struct {
+    CHAR16            *Name;
+    SECTION_COLLECTOR Collect;
+} SECTION;
+
+STATIC SECTION Sections[] = {
+    { L"acpi",  CollectAcpi },
+    { L"cpu",   CollectCpu },
+    { L"pci",   CollectPci },
+    { L"edid",  CollectEdid },
+    { L"esrt",  CollectEsrt },
+    { L"tpm",   CollectTpm },
+    { L"certs", CollectCerts },
+};
+
+
+STATIC VOID
+Usage( BOOLEAN ErrorMsg )
+{
+    if ( ErrorMsg ) {
+        OutputPrint(L"ERROR: Unknown option.\n");
+    }
+    OutputPrint(L"Usage: SysReport [-o | --output <file>] [-s | --section <name>]\n");
+    OutputPrint(L"       SysReport [-V | --version]\n");
+    OutputPrint(L"\nSections:");
+    for (UINTN i = 0; i < ARRAY_SIZE(Sections); i++) {
+        OutputPrint(L" %s", Sections[i].Name);
+    }
+    OutputPrint(L"\n");
+}
+
+
+INTN
+EFIAPI
+ShellAppMain( UINTN Argc,
+              CHAR16 **Argv )
+{
+    EFI_STATUS      Status = EFI_SUCCESS;
+    SYSREPORT_CACHE Cache;
+    CHAR16          *FileName = NULL;
+    CHAR16          *Only = NULL;
+    UINT64          StartTick;
+    UINT64          SectionTick;
+    UINT64          DiscoveryUs;
+    UINTN           Failed = 0;
+    UINTN           Run = 0;
+
+    OutputInit(&Argc, Argv);
+    JsonInit(&Argc, Argv);      // always JSON; accept and ignore --json
+
+    for (UINTN i = 1; i < Argc; i++) {
+        if (!StrCmp(Argv[i], L"--version") ||
+            !StrCmp(Argv[i], L"-V")) {
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
+            return Status;
+        } else if (!StrCmp(Argv[i], L"--help") ||
+            !StrCmp(Argv[i], L"-h")) {
+            Usage(FALSE);
+            return Status;
+        } else if ((!StrCmp(Argv[i], L"--output") ||
+            !StrCmp(Argv[i], L"-o")) && i + 1 < Argc) {
+            FileName = Argv[++i];
+        } else if ((!StrCmp(Argv[i], L"--section") ||
+            !StrCmp(Argv[i], L"-s")) && i + 1 < Argc) {
+            Only = Argv[++i];
+        } else {
+            Usage(TRUE);
+            return Status;
+        }
+    }
+
+    if (Only != NULL) {
+        for (Run = 0; Run < ARRAY_SIZE(Sections); Run++) {
+            if (!StrCmp(Only, Sections[Run].Name)) {
+                break;
+            }
+        }
+        if (Run == ARRAY_SIZE(Sections)) {
+            OutputPrint(L"ERROR: Unknown section: %s\n", Only);
+            return EFI_INVALID_PARAMETER;
+        }
+        Run = 0;
+    }
+
+    if (FileName != NULL) {
+        Status = OutputTeeFile(FileName);
+        if (EFI_ERROR(Status)) {
+            OutputPrint(L"ERROR: Cannot create %s [%d]\n", FileName, Status);
+            return Status;
+        }
+        OutputConsole(FALSE);
+    }
+
+    StartTick = TimerTick();
+    Discover(&Cache);
+    DiscoveryUs = TimerElapsedMicroseconds(StartTick);
+
+    JsonDocumentBegin(L"SysReport", UTILITY_VERSION);
+    JsonUint(L"discoveryUs", DiscoveryUs);
+    JsonUint(L"tscFrequency", TimerFrequency());
+
+    JsonArrayBegin(L"sections");
+    for (UINTN i = 0; i < ARRAY_SIZE(Sections); i++) {
+        if (Only != NULL && StrCmp(Only, Sections[i].Name)) {
+            continue;
+        }
+
+        JsonObjectBegin(NULL);
+        JsonString(L"name", Sections[i].Name);
+
+        SectionTick = TimerTick();
+        JsonObjectBegin(L"data");
+        Status = Sections[i].Collect(&Cache);
+        JsonObjectEnd();
+
+        JsonUint(L"elapsedUs", TimerElapsedMicroseconds(SectionTick));
+        if (EFI_ERROR(Status)) {
+            JsonPrint(L"error", L"%r", Status);
+            Failed++;
+        }
+        JsonObjectEnd();
+        Run++;
+    }
+    JsonArrayEnd();
+
+    JsonUint(L"totalUs", TimerElapsedMicroseconds(StartTick));
+    JsonDocumentEnd();
+
+    DiscoverFree(&Cache);
+
+    if (FileName != NULL) {
+        OutputTeeClose();
+        OutputConsole(TRUE);
+        OutputPrint(L"SysReport: %d sections (%d incomplete) written to %s\n", Run, Failed, FileName);
+    }
+
+    return EFI_SUCCESS;
+}
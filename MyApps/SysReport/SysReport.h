@@ -0,0 +1,56 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  SysReport shared definitions
+//
+//  License: BSD License
+//
+
+#ifndef _SYSREPORT_H_
+#define _SYSREPORT_H_
+
+#include <Uefi.h>
+
+#include <Protocol/Tcg2Protocol.h>
+
+#include <Guid/SystemResourceTable.h>
+
+#define UTILITY_VERSION L"20181019"
+
+//
+// Everything the sections need that would otherwise be looked up again
+// by each of them: configuration table entries and the protocol
+// instances/handles.  Filled in once by Discover() before any section
+// runs; ACPI tables come from AcpiTableIndexLib, which Discover() also
+// builds.
+//
+typedef struct {
+    EFI_SYSTEM_RESOURCE_TABLE *Esrt;
+    EFI_TCG2_PROTOCOL         *Tcg2;
+    EFI_HANDLE                *PciHandles;
+    UINTN                     PciHandleCount;
+    EFI_HANDLE                *GopHandles;
+    UINTN                     GopHandleCount;
+} SYSREPORT_CACHE;
+
+typedef EFI_STATUS (*SECTION_COLLECTOR)( SYSREPORT_CACHE *Cache );
+
+
+// Discovery.c
+VOID Discover( SYSREPORT_CACHE *Cache );
+VOID DiscoverFree( SYSREPORT_CACHE *Cache );
+
+//
+// Section collectors.  Each one writes the members of the section's
+// "data" object and returns an error status if it could not; the
+// caller records the status against the section and moves on.
+//
+EFI_STATUS CollectAcpi( SYSREPORT_CACHE *Cache );
+EFI_STATUS CollectCpu( SYSREPORT_CACHE *Cache );
+EFI_STATUS CollectPci( SYSREPORT_CACHE *Cache );
+EFI_STATUS CollectEdid( SYSREPORT_CACHE *Cache );
+EFI_STATUS CollectEsrt( SYSREPORT_CACHE *Cache );
+EFI_STATUS CollectTpm( SYSREPORT_CACHE *Cache );
+EFI_STATUS CollectCerts( SYSREPORT_CACHE *Cache );
+
+#endif
@@ -0,0 +1,61 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  SysReport TPM section - TCG2 capability and the PCR values of every
+//  allocated bank, as reported by ShowTCM20 and ShowPCR20 --all
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/TpmInfoLib.h>
+
+#include <IndustryStandard/UefiTcgPlatform.h>
+
+#include "SysReport.h"
+
+
+EFI_STATUS
+CollectTpm( SYSREPORT_CACHE *Cache )
+{
+    EFI_TCG2_BOOT_SERVICE_CAPABILITY CapabilityData;
+    STATIC TPM_PCR_VALUES PcrValues;    // about 8KB of digests, keep it off the stack
+    EFI_STATUS    Status;
+
+    if (Cache->Tcg2 == NULL) {
+        return EFI_NOT_FOUND;
+    }
+
+    CapabilityData.Size = (UINT8)sizeof(CapabilityData);
+    Status = Cache->Tcg2->GetCapability(Cache->Tcg2, &CapabilityData);
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+
+    TpmCapabilityJson(&CapabilityData);
+
+    if (!CapabilityData.TPMPresentFlag) {
+        return EFI_SUCCESS;
+    }
+
+    ZeroMem(&PcrValues, sizeof(PcrValues));
+    if (EFI_ERROR(TpmPcrSelectActive(&PcrValues))) {
+        // fall back to the strongest commonly allocated bank
+        if (CapabilityData.ActivePcrBanks & EFI_TCG2_BOOT_HASH_ALG_SHA256) {
+            TpmPcrSelectBank(&PcrValues, TPM_ALG_SHA256);
+        } else {
+            TpmPcrSelectBank(&PcrValues, TPM_ALG_SHA1);
+        }
+    }
+
+    Status = TpmPcrReadAll(&PcrValues);
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+    TpmPcrJson(&PcrValues);
+
+    return EFI_SUCCESS;
+}
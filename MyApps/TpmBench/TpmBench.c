@@ -0,0 +1,696 @@
+//
+//  Copyright (c) 2018  Finnbarr P. Murphy.   All rights reserved.
+//
+//  Measure TPM command latency.  PCR_Read, GetRandom, GetCapability,
+//  Hash, SequenceUpdate and PCR_Extend (on a resettable scratch PCR)
+//  are each sent N times through the TCG2 (TPM 2.0) or TCG (TPM 1.2)
+//  protocol and the min, median, p99 and max round trip times reported.
+//
+//  License: BSD License
+//
+
+#include <Uefi.h>
+#include <Library/UefiLib.h>
+#include <Library/ShellCEntryLib.h>
+#include <Library/ShellLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/SortLib.h>
+#include <Library/BufferedOutputLib.h>
+#include <Library/JsonWriterLib.h>
+#include <Library/TscTimerLib.h>
+#include <Library/TpmCommandLib.h>
+
+#include <Protocol/EfiShell.h>
+#include <Protocol/LoadedImage.h>
+#include <Protocol/TcgService.h>
+#include <Protocol/Tcg2Protocol.h>
+
+#include <IndustryStandard/UefiTcgPlatform.h>
+
+#define UTILITY_VERSION L"20181027"
+#undef DEBUG
+
+#define DEFAULT_ITERATIONS  100
+#define MAX_ITERATIONS      10000
+#define DEFAULT_SCRATCH_PCR 16           // debug PCR, resettable from locality 0
+#define RANDOM_BYTES        32
+#define HASH_DATA_SIZE      512          // within every TPM's input buffer; multiple of 64 for SHA1Update
+#define MAX_BENCH_COMMAND   (HASH_DATA_SIZE + 64)
+#define MAX_BENCH_RESPONSE  1024
+
+typedef struct {
+    BOOLEAN           Tpm20;
+    TPMI_ALG_HASH     Alg;               // bank used for PCR_Read and PCR_Extend
+    UINT16            DigestSize;
+    UINT32            Pcr;               // scratch PCR
+    UINT32            Sequence;          // open hash sequence handle, 0 if none
+    TPM_COMMAND       Command;
+    UINT8             CommandBuffer[MAX_BENCH_COMMAND];
+    TPM_RESPONSE      Response;
+    UINT8             ResponseBuffer[MAX_BENCH_RESPONSE];
+    UINT32            ResponseCode;      // of the last command sent
+} BENCH_CONTEXT;
+
+//
+// Builds the command to be timed into Context->Command.  Open and Close
+// (either may be NULL) run untimed before and after the iterations.
+//
+typedef VOID (*BENCH_BUILD)( BENCH_CONTEXT *Context );
+typedef EFI_STATUS (*BENCH_STEP)( BENCH_CONTEXT *Context );
+
+typedef struct {
+    CHAR16      *Name;
+    BENCH_BUILD Build20;                 // NULL if the command does not exist on TPM 2.0
+    BENCH_BUILD Build12;                 // NULL if the command does not exist on TPM 1.2
+    BENCH_STEP  Open;
+    BENCH_STEP  Close;
+    CHAR16      *CloseFailed;            // what is left behind if Close fails
+} BENCHMARK;
+
+typedef struct {
+    UINTN  Count;                        // successful commands timed
+    UINTN  Failed;
+    UINT64 Min;                          // microseconds
+    UINT64 Median;
+    UINT64 P99;
+    UINT64 Max;
+    UINT64 Mean;
+    EFI_STATUS CloseStatus;              // of the untimed tear down
+    UINT32 CloseResponseCode;
+} BENCH_RESULT;
+
+STATIC UINT8 HashData[HASH_DATA_SIZE];
+
+
+//
+// Start a command in the context's buffer
+//
+static TPM_COMMAND *
+Begin( BENCH_CONTEXT *Context,
+       UINT16 Tag,
+       UINT32 Code )
+{
+    TpmCommandBegin(&Context->Command, Context->CommandBuffer, sizeof(Context->CommandBuffer), Tag, Code);
+
+    return &Context->Command;
+}
+
+
+static EFI_STATUS
+Submit( BENCH_CONTEXT *Context )
+{
+    EFI_STATUS Status;
+
+    Status = TpmSubmit( &Context->Command,
+                        &Context->Response,
+                        Context->ResponseBuffer,
+                        sizeof(Context->ResponseBuffer) );
+    Context->ResponseCode = Context->Response.ResponseCode;
+
+    return (Status == EFI_PROTOCOL_ERROR) ? EFI_DEVICE_ERROR : Status;
+}
+
+
+//
+// TPM 2.0 commands
+//
+static VOID
+BuildPcrRead20( BENCH_CONTEXT *Context )
+{
+    TPML_PCR_SELECTION Selection;
+
+    ZeroMem(&Selection, sizeof(Selection));
+    Selection.count = 1;
+    Selection.pcrSelections[0].hash = Context->Alg;
+    Selection.pcrSelections[0].sizeofSelect = PCR_SELECT_MAX;
+    Selection.pcrSelections[0].pcrSelect[Context->Pcr / 8] = (UINT8)(1 << (Context->Pcr % 8));
+
+    TpmBuildPcrRead(&Context->Command, Context->CommandBuffer, sizeof(Context->CommandBuffer), &Selection);
+}
+
+
+static VOID
+BuildGetRandom20( BENCH_CONTEXT *Context )
+{
+    TPM_COMMAND *Command;
+
+    Command = Begin(Context, TPM_ST_NO_SESSIONS, TPM_CC_GetRandom);
+    TpmPutUint16(Command, RANDOM_BYTES);
+}
+
+
+static VOID
+BuildGetCapability20( BENCH_CONTEXT *Context )
+{
+    TpmBuildGetCapability( &Context->Command,
+                           Context->CommandBuffer,
+                           sizeof(Context->CommandBuffer),
+                           TPM_CAP_TPM_PROPERTIES,
+                           TPM_PT_MANUFACTURER,
+                           1 );
+}
+
+
+static VOID
+BuildHash20( BENCH_CONTEXT *Context )
+{
+    TPM_COMMAND *Command;
+
+    Command = Begin(Context, TPM_ST_NO_SESSIONS, TPM_CC_Hash);
+    TpmPutUint16(Command, HASH_DATA_SIZE);
+    TpmPutBytes(Command, HashData, HASH_DATA_SIZE);
+    TpmPutUint16(Command, Context->Alg);
+    TpmPutUint32(Command, TPM_RH_NULL);
+}
+
+
+static VOID
+BuildSequenceUpdate20( BENCH_CONTEXT *Context )
+{
+    TPM_COMMAND *Command;
+
+    Command = Begin(Context, TPM_ST_SESSIONS, TPM_CC_SequenceUpdate);
+    TpmPutUint32(Command, Context->Sequence);
+    TpmPutPasswordSession(Command);
+    TpmPutUint16(Command, HASH_DATA_SIZE);
+    TpmPutBytes(Command, HashData, HASH_DATA_SIZE);
+}
+
+
+static VOID
+BuildPcrExtend20( BENCH_CONTEXT *Context )
+{
+    TPM_COMMAND *Command;
+
+    Command = Begin(Context, TPM_ST_SESSIONS, TPM_CC_PCR_Extend);
+    TpmPutUint32(Command, Context->Pcr);
+    TpmPutPasswordSession(Command);
+    TpmPutUint32(Command, 1);
+    TpmPutUint16(Command, Context->Alg);
+    TpmPutBytes(Command, HashData, Context->DigestSize);
+}
+
+
+//
+// TPM 1.2 commands
+//
+static VOID
+BuildPcrRead12( BENCH_CONTEXT *Context )
+{
+    TPM_COMMAND *Command;
+
+    Command = Begin(Context, TPM_TAG_RQU_COMMAND, TPM_ORD_PcrRead);
+    TpmPutUint32(Command, Context->Pcr);
+}
+
+
+static VOID
+BuildGetRandom12( BENCH_CONTEXT *Context )
+{
+    TPM_COMMAND *Command;
+
+    Command = Begin(Context, TPM_TAG_RQU_COMMAND, TPM_ORD_GetRandom);
+    TpmPutUint32(Command, RANDOM_BYTES);
+}
+
+
+static VOID
+BuildGetCapability12( BENCH_CONTEXT *Context )
+{
+    TPM_COMMAND *Command;
+
+    Command = Begin(Context, TPM_TAG_RQU_COMMAND, TPM_ORD_GetCapability);
+    TpmPutUint32(Command, TPM_CAP_PROPERTY);
+    TpmPutUint32(Command, sizeof(UINT32));
+    TpmPutUint32(Command, TPM_CAP_PROP_MANUFACTURER);
+}
+
+
+static VOID
+BuildSequenceUpdate12( BENCH_CONTEXT *Context )
+{
+    TPM_COMMAND *Command;
+
+    Command = Begin(Context, TPM_TAG_RQU_COMMAND, TPM_ORD_SHA1Update);
+    TpmPutUint32(Command, HASH_DATA_SIZE);
+    TpmPutBytes(Command, HashData, HASH_DATA_SIZE);
+}
+
+
+static VOID
+BuildPcrExtend12( BENCH_CONTEXT *Context )
+{
+    TPM_COMMAND *Command;
+
+    Command = Begin(Context, TPM_TAG_RQU_COMMAND, TPM_ORD_Extend);
+    TpmPutUint32(Command, Context->Pcr);
+    TpmPutBytes(Command, HashData, SHA1_DIGEST_SIZE);
+}
+
+
+//
+// Untimed set up and tear down
+//
+static EFI_STATUS
+OpenSequence( BENCH_CONTEXT *Context )
+{
+    TPM_COMMAND *Command;
+    EFI_STATUS  Status;
+
+    if (Context->Tpm20) {
+        Command = Begin(Context, TPM_ST_NO_SESSIONS, TPM_CC_HashSequenceStart);
+        TpmPutUint16(Command, 0);        // auth
+        TpmPutUint16(Command, Context->Alg);
+        Status = Submit(Context);
+        if (!EFI_ERROR(Status)) {
+            Context->Sequence = TpmGetUint32(&Context->Response);
+        }
+    } else {
+        Begin(Context, TPM_TAG_RQU_COMMAND, TPM_ORD_SHA1Start);
+        Status = Submit(Context);
+    }
+
+    return Status;
+}
+
+
+static EFI_STATUS
+CloseSequence( BENCH_CONTEXT *Context )
+{
+    TPM_COMMAND *Command;
+    EFI_STATUS  Status;
+
+    if (Context->Tpm20) {
+        Command = Begin(Context, TPM_ST_SESSIONS, TPM_CC_SequenceComplete);
+        TpmPutUint32(Command, Context->Sequence);
+        TpmPutPasswordSession(Command);
+        TpmPutUint16(Command, 0);        // no more data
+        TpmPutUint32(Command, TPM_RH_NULL);
+    } else {
+        Command = Begin(Context, TPM_TAG_RQU_COMMAND, TPM_ORD_SHA1Complete);
+        TpmPutUint32(Command, 0);
+    }
+
+    Status = Submit(Context);
+    if (!EFI_ERROR(Status)) {
+        Context->Sequence = 0;
+    }
+
+    return Status;
+}
+
+
+//
+// Put the scratch PCR back to its reset value
+//
+static EFI_STATUS
+ResetPcr( BENCH_CONTEXT *Context )
+{
+    TPM_COMMAND *Command;
+    UINT8       Select[PCR_SELECT_MAX] = { 0 };
+
+    if (Context->Tpm20) {
+        Command = Begin(Context, TPM_ST_SESSIONS, TPM_CC_PCR_Reset);
+        TpmPutUint32(Command, Context->Pcr);
+        TpmPutPasswordSession(Command);
+    } else {
+        Select[Context->Pcr / 8] = (UINT8)(1 << (Context->Pcr % 8));
+        Command = Begin(Context, TPM_TAG_RQU_COMMAND, TPM_ORD_PCR_Reset);
+        TpmPutUint16(Command, PCR_SELECT_MAX);
+        TpmPutBytes(Command, Select, PCR_SELECT_MAX);
+    }
+
+    return Submit(Context);
+}
+
+
+STATIC BENCHMARK Benchmarks[] = {
+    { L"PCR_Read",       BuildPcrRead20,        BuildPcrRead12,        NULL,         NULL,          NULL },
+    { L"GetRandom",      BuildGetRandom20,      BuildGetRandom12,      NULL,         NULL,          NULL },
+    { L"GetCapability",  BuildGetCapability20,  BuildGetCapability12,  NULL,         NULL,          NULL },
+    { L"Hash",           BuildHash20,           NULL,                  NULL,         NULL,          NULL },
+    { L"SequenceUpdate", BuildSequenceUpdate20, BuildSequenceUpdate12, OpenSequence, CloseSequence, L"hash sequence left open" },
+    { L"PCR_Extend",     BuildPcrExtend20,      BuildPcrExtend12,      NULL,         ResetPcr,      L"scratch PCR left extended" },
+};
+
+
+static BENCH_BUILD
+BenchBuilder( BENCH_CONTEXT *Context,
+              BENCHMARK *Bench )
+{
+    return Context->Tpm20 ? Bench->Build20 : Bench->Build12;
+}
+
+
+static INTN
+EFIAPI
+CompareTicks( CONST VOID *Tick1,
+              CONST VOID *Tick2 )
+{
+    UINT64 A = *(CONST UINT64 *)Tick1;
+    UINT64 B = *(CONST UINT64 *)Tick2;
+
+    return (A < B) ? -1 : (A > B) ? 1 : 0;
+}
+
+
+//
+// Nearest-rank percentile of sorted Ticks, in microseconds
+//
+static UINT64
+Percentile( UINT64 *Ticks,
+            UINTN Count,
+            UINTN Percent )
+{
+    UINTN Rank = (Count * Percent + 99) / 100;
+
+    return TimerTicksToMicroseconds(Ticks[(Rank > 0) ? Rank - 1 : 0]);
+}
+
+
+static EFI_STATUS
+RunBenchmark( BENCH_CONTEXT *Context,
+              BENCHMARK *Bench,
+              UINTN Iterations,
+              UINT64 *Ticks,
+              BENCH_RESULT *Result )
+{
+    BENCH_BUILD Build = BenchBuilder(Context, Bench);
+    EFI_STATUS  Status;
+    UINT32      ResponseCode;
+    UINT64      Start;
+    UINT64      Total = 0;
+
+    ZeroMem(Result, sizeof(BENCH_RESULT));
+    if (Build == NULL) {
+        return EFI_UNSUPPORTED;
+    }
+
+    if (Bench->Open != NULL) {
+        Status = Bench->Open(Context);
+        if (EFI_ERROR(Status)) {
+            return Status;
+        }
+    }
+
+    // one untimed command first so a cold TPM or driver does not count
+    Build(Context);
+    Status = Submit(Context);
+
+    for (UINTN i = 0; i < Iterations && !EFI_ERROR(Status); i++) {
+        Build(Context);
+        Start = TimerTick();
+        Status = Submit(Context);
+        Ticks[Result->Count] = TimerTick() - Start;
+        if (EFI_ERROR(Status)) {
+            Result->Failed++;
+        } else {
+            Total += Ticks[Result->Count++];
+        }
+    }
+
+    // keep the response code of the timed command for the report
+    if (Bench->Close != NULL) {
+        ResponseCode = Context->ResponseCode;
+        Result->CloseStatus = Bench->Close(Context);
+        Result->CloseResponseCode = Context->ResponseCode;
+        Context->ResponseCode = ResponseCode;
+    }
+    if (Result->Count == 0) {
+        return EFI_ERROR(Status) ? Status : EFI_DEVICE_ERROR;
+    }
+
+    PerformQuickSort(Ticks, Result->Count, sizeof(UINT64), CompareTicks);
+    Result->Min = TimerTicksToMicroseconds(Ticks[0]);
+    Result->Median = Percentile(Ticks, Result->Count, 50);
+    Result->P99 = Percentile(Ticks, Result->Count, 99);
+    Result->Max = TimerTicksToMicroseconds(Ticks[Result->Count - 1]);
+    Result->Mean = TimerTicksToMicroseconds(DivU64x64Remainder(Total, Result->Count, NULL));
+
+    return Status;
+}
+
+
+static VOID
+PrintResult( BENCHMARK *Bench,
+             BENCH_CONTEXT *Context,
+             BENCH_RESULT *Result,
+             EFI_STATUS Status )
+{
+    OutputPrint(L"%-15s", Bench->Name);
+    if (BenchBuilder(Context, Bench) == NULL) {
+        OutputPrint(L"  not available on TPM %s\n", Context->Tpm20 ? L"2.0" : L"1.2");
+    } else if (Result->Count == 0) {
+        OutputPrint(L"  failed [%r] response code 0x%x\n", Status, Context->ResponseCode);
+    } else {
+        OutputPrint(L" %10ld %10ld %10ld %10ld %10ld", Result->Min, Result->Median,
+                    Result->P99, Result->Max, Result->Mean);
+        if (Result->Failed) {
+            OutputPrint(L"  (stopped after %d: response code 0x%x)", Result->Count, Context->ResponseCode);
+        }
+        OutputPrint(L"\n");
+    }
+    if (EFI_ERROR(Result->CloseStatus)) {
+        OutputPrint(L"WARNING: %s clean up failed [%r] response code 0x%x, %s\n", Bench->Name,
+                    Result->CloseStatus, Result->CloseResponseCode, Bench->CloseFailed);
+    }
+}
+
+
+static VOID
+JsonResult( BENCHMARK *Bench,
+            BENCH_CONTEXT *Context,
+            BENCH_RESULT *Result,
+            EFI_STATUS Status )
+{
+    JsonObjectBegin(NULL);
+    JsonString(L"command", Bench->Name);
+    if (BenchBuilder(Context, Bench) == NULL) {
+        JsonBool(L"available", FALSE);
+    } else {
+        JsonUint(L"samples", Result->Count);
+        JsonUint(L"failed", Result->Failed);
+        if (Result->Count > 0) {
+            JsonUint(L"minUs", Result->Min);
+            JsonUint(L"medianUs", Result->Median);
+            JsonUint(L"p99Us", Result->P99);
+            JsonUint(L"maxUs", Result->Max);
+            JsonUint(L"meanUs", Result->Mean);
+        }
+        if (EFI_ERROR(Status)) {
+            JsonPrint(L"error", L"%r", Status);
+            JsonHex(L"responseCode", Context->ResponseCode);
+        }
+        if (EFI_ERROR(Result->CloseStatus)) {
+            JsonObjectBegin(L"cleanup");
+            JsonPrint(L"error", L"%r", Result->CloseStatus);
+            JsonHex(L"responseCode", Result->CloseResponseCode);
+            JsonString(L"effect", Bench->CloseFailed);
+            JsonObjectEnd();
+        }
+    }
+    JsonObjectEnd();
+}
+
+
+//
+// Find the TPM and pick the PCR bank to use
+//
+static EFI_STATUS
+OpenTpm( BENCH_CONTEXT *Context )
+{
+    EFI_TCG2_BOOT_SERVICE_CAPABILITY CapabilityData;
+    EFI_TCG2_PROTOCOL                *Tcg2;
+    TPM_TRANSPORT                    Transport;
+    EFI_STATUS                       Status;
+
+    Status = TpmOpen(&Transport);
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
+
+    Context->Tpm20 = (Transport == TpmTransportTpm20);
+    Context->Alg = TPM_ALG_SHA1;
+    Context->DigestSize = SHA1_DIGEST_SIZE;
+
+    Tcg2 = TpmTcg2();
+    if (Tcg2 != NULL) {
+        ZeroMem(&CapabilityData, sizeof(CapabilityData));
+        CapabilityData.Size = (UINT8)sizeof(CapabilityData);
+        Status = Tcg2->GetCapability(Tcg2, &CapabilityData);
+        if (EFI_ERROR(Status) || !CapabilityData.TPMPresentFlag) {
+            return EFI_NOT_FOUND;
+        }
+        if (CapabilityData.ActivePcrBanks & EFI_TCG2_BOOT_HASH_ALG_SHA256) {
+            Context->Alg = TPM_ALG_SHA256;
+            Context->DigestSize = SHA256_DIGEST_SIZE;
+        }
+    }
+
+    return EFI_SUCCESS;
+}
+
+
+BOOLEAN
+IsNumber( CHAR16* str )
+{
+    CHAR16 *s = str;
+
+    if (*s == 0)
+        return FALSE;
+
+    while (*s) {
+        if (*s  < L'0' || *s > L'9')
+            return FALSE;
+        s++;
+    }
+
+    return TRUE;
+}
+
+
+VOID
+Usage( CHAR16 *Str,
+       BOOLEAN ErrorMsg )
+{
+    if ( ErrorMsg ) {
+        OutputPrint(L"ERROR: Unknown option.\n");
+    }
+    OutputPrint(L"Usage: %s [-n | --iterations <count>] [-p | --pcr <16 | 23>]\n", Str);
+    OutputPrint(L"       %s [-n | --iterations <count>] [-p | --pcr <16 | 23>] --json\n", Str);
+    OutputPrint(L"       %s [-V | --version]\n", Str);
+    OutputPrint(L"\nDefaults are %d iterations and PCR %d.  The scratch PCR is extended\n",
+                DEFAULT_ITERATIONS, DEFAULT_SCRATCH_PCR);
+    OutputPrint(L"and then reset; only the locality 0 resettable PCRs are accepted.\n");
+}
+
+
+INTN
+EFIAPI
+ShellAppMain( UINTN Argc,
+              CHAR16 **Argv )
+{
+    EFI_STATUS    Status = EFI_SUCCESS;
+    BENCH_CONTEXT *Context;
+    BENCH_RESULT  Result;
+    UINT64        *Ticks;
+    UINT64        TpmCommands;
+    UINT64        TpmMicroseconds;
+    UINTN         Iterations = DEFAULT_ITERATIONS;
+    UINT32        Pcr = DEFAULT_SCRATCH_PCR;
+    BOOLEAN       Json = FALSE;
+    BOOLEAN       CleanupFailed = FALSE;
+
+    OutputInit(&Argc, Argv);
+    Json = JsonInit(&Argc, Argv);
+
+    for (UINTN i = 1; i < Argc; i++) {
+        if (!StrCmp(Argv[i], L"--version") ||
+            !StrCmp(Argv[i], L"-V")) {
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
+            return Status;
+        } else if (!StrCmp(Argv[i], L"--help") ||
+            !StrCmp(Argv[i], L"-h")) {
+            Usage(Argv[0], FALSE);
+            return Status;
+        } else if ((!StrCmp(Argv[i], L"--iterations") ||
+            !StrCmp(Argv[i], L"-n")) && i + 1 < Argc && IsNumber(Argv[i + 1])) {
+            Iterations = StrDecimalToUintn(Argv[++i]);
+        } else if ((!StrCmp(Argv[i], L"--pcr") ||
+            !StrCmp(Argv[i], L"-p")) && i + 1 < Argc && IsNumber(Argv[i + 1])) {
+            Pcr = (UINT32) StrDecimalToUintn(Argv[++i]);
+        } else {
+            Usage(Argv[0], TRUE);
+            return Status;
+        }
+    }
+
+    if (Iterations < 1 || Iterations > MAX_ITERATIONS) {
+        OutputPrint(L"ERROR: Iterations must be between 1 and %d\n", MAX_ITERATIONS);
+        return EFI_INVALID_PARAMETER;
+    }
+    // never touch a PCR that holds boot measurements
+    if (Pcr != 16 && Pcr != 23) {
+        OutputPrint(L"ERROR: Scratch PCR must be 16 or 23\n");
+        return EFI_INVALID_PARAMETER;
+    }
+
+    if (Json) {
+        JsonDocumentBegin(L"TpmBench", UTILITY_VERSION);
+    }
+
+    Context = AllocateZeroPool(sizeof(BENCH_CONTEXT));
+    Ticks = AllocatePool(Iterations * sizeof(UINT64));
+    if (Context == NULL || Ticks == NULL) {
+        JsonError(L"Out of memory");
+        Status = EFI_OUT_OF_RESOURCES;
+        goto Done;
+    }
+    Context->Pcr = Pcr;
+    for (UINTN i = 0; i < HASH_DATA_SIZE; i++) {
+        HashData[i] = (UINT8) i;
+    }
+
+    Status = OpenTpm(Context);
+    if (EFI_ERROR(Status)) {
+        JsonError(L"No TPM found (no EFI_TCG2_PROTOCOL, EFI_TREE_PROTOCOL or EFI_TCG_PROTOCOL) [%d]", Status);
+        goto Done;
+    }
+
+    if (Json) {
+        JsonString(L"tpmVersion", Context->Tpm20 ? L"2.0" : L"1.2");
+        JsonUint(L"iterations", Iterations);
+        JsonUint(L"scratchPcr", Pcr);
+        JsonHex(L"pcrBank", Context->Alg);
+        JsonUint(L"hashDataSize", HASH_DATA_SIZE);
+        JsonUint(L"tscFrequency", TimerFrequency());
+        JsonArrayBegin(L"commands");
+    } else {
+        OutputPrint(L"TPM %s command latency, %d iterations, scratch PCR %d (%s bank)\n\n",
+                    Context->Tpm20 ? L"2.0" : L"1.2", Iterations, Pcr,
+                    Context->Alg == TPM_ALG_SHA256 ? L"SHA256" : L"SHA1");
+        OutputPrint(L"Command            Min(us) Median(us)    p99(us)    Max(us)   Mean(us)\n");
+    }
+
+    for (UINTN i = 0; i < ARRAY_SIZE(Benchmarks); i++) {
+        Status = RunBenchmark(Context, &Benchmarks[i], Iterations, Ticks, &Result);
+        if (Json) {
+            JsonResult(&Benchmarks[i], Context, &Result, Status);
+        } else {
+            PrintResult(&Benchmarks[i], Context, &Result, Status);
+        }
+        if (EFI_ERROR(Result.CloseStatus)) {
+            CleanupFailed = TRUE;
+        }
+    }
+    // a latency failure is reported per command; a failed clean up
+    // leaves the TPM changed, so the caller needs to know
+    Status = CleanupFailed ? EFI_DEVICE_ERROR : EFI_SUCCESS;
+
+    // includes the untimed warm-up, set up and tear down commands
+    TpmStatistics(&TpmCommands, &TpmMicroseconds);
+    if (Json) {
+        JsonArrayEnd();
+        JsonUint(L"totalCommands", TpmCommands);
+        JsonUint(L"totalUs", TpmMicroseconds);
+    } else {
+        OutputPrint(L"\nHash and SequenceUpdate carry %d bytes of data.\n", HASH_DATA_SIZE);
+        OutputPrint(L"%ld commands sent in total, %ld us spent in the TPM.\n", TpmCommands, TpmMicroseconds);
+    }
+
+Done:
+    if (Json) {
+        JsonDocumentEnd();
+    }
+    if (Ticks != NULL) {
+        FreePool(Ticks);
+    }
+    if (Context != NULL) {
+        FreePool(Context);
+    }
+
+    return Status;
+}
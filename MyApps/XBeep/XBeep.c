@@ -16,6 +16,7 @@
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/PrintLib.h>
 #include <Library/IoLib.h>
+#include <Library/BufferedOutputLib.h>
 
 #include <Protocol/EfiShell.h>
 #include <Protocol/LoadedImage.h>
@@ -239,13 +240,13 @@ ComplexBeep( UINTN NumBeeps,
 VOID
 PrintDefaults( VOID )
 {
-    Print(L"\n");
-    Print(L"                   Default beep count: %d\n",   EFI_DEFAULT_BEEP_NUMBER ); 
-    Print(L"            Default beep enabled time: 0x%x\n", EFI_DEFAULT_BEEP_ON_TIME ); 
-    Print(L"           Default beep disabled time: 0x%x\n", EFI_DEFAULT_BEEP_OFF_TIME );
-    Print(L"               Default beep frequency: 0x%x\n", EFI_DEFAULT_BEEP_FREQUENCY );
-    Print(L"   Default beep alternative frequency: 0x%x\n", EFI_DEFAULT_BEEP_ALTFREQUENCY );
-    Print(L"\n");
+    OutputPrint(L"\n");
+    OutputPrint(L"                   Default beep count: %d\n",   EFI_DEFAULT_BEEP_NUMBER ); 
+    OutputPrint(L"            Default beep enabled time: 0x%x\n", EFI_DEFAULT_BEEP_ON_TIME ); 
+    OutputPrint(L"           Default beep disabled time: 0x%x\n", EFI_DEFAULT_BEEP_OFF_TIME );
+    OutputPrint(L"               Default beep frequency: 0x%x\n", EFI_DEFAULT_BEEP_FREQUENCY );
+    OutputPrint(L"   Default beep alternative frequency: 0x%x\n", EFI_DEFAULT_BEEP_ALTFREQUENCY );
+    OutputPrint(L"\n");
 }
 
 
@@ -253,12 +254,12 @@ VOID
 Usage( BOOLEAN ErrorMsg )
 {
     if ( ErrorMsg ) {
-        Print(L"ERROR: Unknown option(s).\n");
+        OutputPrint(L"ERROR: Unknown option(s).\n");
     }
-    Print(L"Usage: XBeep [-T] [-n number ] [-d duration] [-i interavl] [-f frequency] [-a altfreq]\n");
-    Print(L"       XBeep -D | --defaults\n");
-    Print(L"       XBeep -T | --twotone\n");
-    Print(L"       XBeep -V | --version\n");
+    OutputPrint(L"Usage: XBeep [-T] [-n number ] [-d duration] [-i interavl] [-f frequency] [-a altfreq]\n");
+    OutputPrint(L"       XBeep -D | --defaults\n");
+    OutputPrint(L"       XBeep -T | --twotone\n");
+    OutputPrint(L"       XBeep -V | --version\n");
 }
 
 
@@ -278,13 +279,15 @@ ShellAppMain( UINTN Argc,
     UINT32 Val = 0;
 #endif
 
+    OutputInit(&Argc, Argv);
+
     if (Argc == 1) {
        SimpleBeep(FALSE);
        return Status;
     } else if (Argc == 2) {
         if (!StrCmp(Argv[1], L"--version") ||
             !StrCmp(Argv[1], L"-V")) {
-            Print(L"Version: %s\n", UTILITY_VERSION);
+            OutputPrint(L"Version: %s\n", UTILITY_VERSION);
         } else if (!StrCmp(Argv[1], L"--help") ||
             !StrCmp(Argv[1], L"-h")) {
             Usage(FALSE);
@@ -299,7 +302,7 @@ ShellAppMain( UINTN Argc,
 #ifdef DEBUG
         } else if (!StrCmp(Argv[1], L"-R")) {      // undocumented experimental option
             Val = ReadCounter(2);
-            Print(L"Timer 3 count value: %d %x\n", Val, Val);
+            OutputPrint(L"Timer 3 count value: %d %x\n", Val, Val);
             return Status;
 #endif
         } else {
@@ -314,12 +317,12 @@ ShellAppMain( UINTN Argc,
                i++;
                NumBeeps = (UINTN) StrDecimalToUint64( Argv[i] );            
                if (NumBeeps < 1) {
-                   Print(L"ERROR: Invalid number of beeps entered.\n");               
+                   OutputPrint(L"ERROR: Invalid number of beeps entered.\n");               
                    Usage(FALSE);
                    return Status;
                }
             } else {
-                Print(L"ERROR: Invalid or missing argument to option.\n");               
+                OutputPrint(L"ERROR: Invalid or missing argument to option.\n");               
                 Usage(FALSE);
                 return Status;
             }
@@ -328,12 +331,12 @@ ShellAppMain( UINTN Argc,
                i++;
                Duration = (UINTN) StrHexToUint64( Argv[i] );            
                if (Duration < 1) {
-                   Print(L"ERROR: Invalid duration entered.\n");               
+                   OutputPrint(L"ERROR: Invalid duration entered.\n");               
                    Usage(FALSE);
                    return Status;
                }
             } else {
-                Print(L"ERROR: Invalid or missing argument to option.\n");               
+                OutputPrint(L"ERROR: Invalid or missing argument to option.\n");               
                 Usage(FALSE);
                 return Status;
             }
@@ -342,12 +345,12 @@ ShellAppMain( UINTN Argc,
                i++;
                Interval = (UINTN) StrHexToUint64( Argv[i] );            
                if (Interval < 1) {
-                   Print(L"ERROR: Invalid interval entered.\n");               
+                   OutputPrint(L"ERROR: Invalid interval entered.\n");               
                    Usage(FALSE);
                    return Status;
                }
             } else {
-                Print(L"ERROR: Invalid or missing argument to option.\n");               
+                OutputPrint(L"ERROR: Invalid or missing argument to option.\n");               
                 Usage(FALSE);
                 return Status;
             }
@@ -356,12 +359,12 @@ ShellAppMain( UINTN Argc,
                i++;
                Frequency = (UINTN) StrHexToUint64( Argv[i] );            
                if (Frequency < 1) {
-                   Print(L"ERROR: Invalid frequency entered.\n");               
+                   OutputPrint(L"ERROR: Invalid frequency entered.\n");               
                    Usage(FALSE);
                    return Status;
                }
             } else {
-                Print(L"ERROR: Invalid or missing argument to option.\n");               
+                OutputPrint(L"ERROR: Invalid or missing argument to option.\n");               
                 Usage(FALSE);
                 return Status;
             }
@@ -370,12 +373,12 @@ ShellAppMain( UINTN Argc,
                i++;
                AltFreq = (UINTN) StrHexToUint64( Argv[i] );            
                if (AltFreq < 1) {
-                   Print(L"ERROR: Invalid alternative frequency entered.\n");               
+                   OutputPrint(L"ERROR: Invalid alternative frequency entered.\n");               
                    Usage(FALSE);
                    return Status;
                }
             } else {
-                Print(L"ERROR: Invalid or missing argument to option.\n");               
+                OutputPrint(L"ERROR: Invalid or missing argument to option.\n");               
                 Usage(FALSE);
                 return Status;
             }